@@ -69,7 +69,7 @@ static void GnVoiceEngine_recordTask(void *arg)
         }
 
         if (sGnIsRecording) {
-            litevad_result_t vad_state = litevad_process(sGnVadHandle, sGnRecordBuf, bytes_read);
+            litevad_result_t vad_state = litevad_process_stream(sGnVadHandle, sGnRecordBuf, bytes_read, NULL);
             if (sGnVadActive && vad_state == LITEVAD_RESULT_SPEECH_END) {
                 ESP_LOGI(TAG, "VAD state changed: speech >> silence, onMicphoneSilence");
                 if (sdkCallback == NULL)
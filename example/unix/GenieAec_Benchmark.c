@@ -0,0 +1,373 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Echo cancellation during playback on simulated audio. Two player streams are fed to
+// GnAec_reference the way the sink tap does: music at 44.1k stereo and tts (test.wav)
+// at 24k mono. The capture is the keyword (snowboy.wav) said every few seconds, plus
+// the echo of both streams through a synthetic room (delay, decaying reflections,
+// gain set by the signal to echo ratio) and noise, in 60ms blocks like the alsa engine.
+// Reports the cpu per 10ms frame, ERLE, and with snowboy the keyword hits and false
+// alarms on clean speech, on the capture without and with echo cancellation.
+// Exits with failure when ERLE at -5dB signal to echo falls far below what the floating
+// point canceller gets, a fixed point overflow shows up there first.
+//
+//   GenieAec_Benchmark [seconds, default 60] [echo delay ms, default 230] [signal to echo dB, default -5]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "litevad_resampler.h"
+#include "GenieAec.h"
+#if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
+#include "snowboy-detect-c-wrapper.h"
+#endif
+
+#define BENCH_TTS_FILE          "test.wav"
+#define BENCH_KEYWORD_FILE      "snowboy.wav"
+#define BENCH_RATE              16000
+#define BENCH_FRAME             160
+#define BENCH_CAPTURE_TIME      60      // ms per capture block, same as the alsa voice engine
+#define BENCH_WRITE_TIME        40      // ms per sink write
+#define BENCH_MUSIC_RATE        44100
+#define BENCH_TTS_INTERVAL      5000    // ms
+#define BENCH_KEYWORD_FIRST     2000    // ms
+#define BENCH_KEYWORD_INTERVAL  4000    // ms
+#define BENCH_KEYWORD_WINDOW    500     // ms after the keyword a detection still counts as hit
+#define BENCH_ROOM_TAIL         960     // samples of reflections after the direct path, 60ms
+#define BENCH_NOISE_RMS         30
+#define BENCH_CLOCK_BASE        1000000000ULL // usec, simulated os_monotonic_usec at start
+#define BENCH_ERLE_CHECK_SER    -5      // dB, near full scale capture
+#define BENCH_ERLE_CHECK_TIME   30      // s, shorter runs are still converging
+#define BENCH_ERLE_FLOAT        20.9    // dB, floating point speex at 60s 230ms -5dB
+#define BENCH_ERLE_MARGIN       3.0     // dB
+
+#define BENCH_SNOWBOY_RESOURCE  "common.res"
+#define BENCH_SNOWBOY_MODEL     "snowboy.umdl"
+#define BENCH_SNOWBOY_SENS      "0.5"
+
+typedef struct {
+    int16_t *pcm;
+    int frames;
+    int sampleRate;
+    int channelCount;
+} Bench_Pcm_t;
+
+static unsigned int sBenchSeed = 1;
+
+static double bench_noise()
+{
+    sBenchSeed = sBenchSeed*1103515245 + 12345;
+    return ((int)((sBenchSeed >> 16) & 0x7fff) - 16384)/16384.0;
+}
+
+static double cpu_time_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+static int16_t bench_clip(double v)
+{
+    return v > 32767 ? 32767 : (v < -32768 ? -32768 : (int16_t)lrint(v));
+}
+
+// 16 bit pcm wav, data chunk found by walking the riff chunks
+static bool bench_load_wav(const char *file, Bench_Pcm_t *wav)
+{
+    FILE *fp = fopen(file, "rb");
+    if (fp == NULL)
+        return false;
+    unsigned char header[12], chunk[8];
+    bool ok = false;
+    if (fread(header, 1, 12, fp) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+        goto __out;
+    while (fread(chunk, 1, 8, fp) == 8) {
+        uint32_t size = chunk[4] | chunk[5] << 8 | chunk[6] << 16 | (uint32_t)chunk[7] << 24;
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, fp) != 16)
+                goto __out;
+            wav->channelCount = fmt[2] | fmt[3] << 8;
+            wav->sampleRate = fmt[4] | fmt[5] << 8 | fmt[6] << 16 | fmt[7] << 24;
+            if ((fmt[14] | fmt[15] << 8) != 16)
+                goto __out;
+            fseek(fp, size - 16 + (size & 1), SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (wav->channelCount <= 0)
+                goto __out;
+            wav->frames = size/(2*wav->channelCount);
+            wav->pcm = (int16_t *)malloc(size);
+            ok = wav->pcm != NULL && fread(wav->pcm, 1, wav->frames*2*wav->channelCount, fp) ==
+                 (size_t)(wav->frames*2*wav->channelCount);
+            break;
+        } else {
+            fseek(fp, size + (size & 1), SEEK_CUR);
+        }
+    }
+__out:
+    fclose(fp);
+    return ok;
+}
+
+// Notes with a sharp attack and exponential decay, a chord change every 500ms
+static void bench_make_music(Bench_Pcm_t *music, int seconds)
+{
+    static const double notes[] = { 220.0, 261.6, 293.7, 329.6, 392.0, 440.0, 523.3, 587.3 };
+    music->sampleRate = BENCH_MUSIC_RATE;
+    music->channelCount = 2;
+    music->frames = BENCH_MUSIC_RATE*seconds;
+    music->pcm = (int16_t *)malloc(music->frames*2*sizeof(int16_t));
+    int beat = BENCH_MUSIC_RATE/4;
+    double f[3] = { 0 };
+    for (int i = 0; i < music->frames; i++) {
+        if (i%(beat*2) == 0) {
+            for (int k = 0; k < 3; k++)
+                f[k] = notes[(int)((bench_noise() + 1)*4) & 7]*(k + 1)/2;
+        }
+        double t = (double)i/BENCH_MUSIC_RATE;
+        double env = exp(-(double)(i%beat)/(BENCH_MUSIC_RATE*0.08));
+        double s = 0;
+        for (int k = 0; k < 3; k++)
+            s += sin(2*M_PI*f[k]*t)/(k + 1);
+        s = 4000*env*s + 300*bench_noise();
+        music->pcm[2*i] = bench_clip(s);
+        music->pcm[2*i + 1] = bench_clip(0.8*s);
+    }
+}
+
+// test.wav repeated every BENCH_TTS_INTERVAL, silence in between
+static void bench_make_tts(Bench_Pcm_t *tts, const Bench_Pcm_t *speech, int seconds)
+{
+    tts->sampleRate = speech->sampleRate;
+    tts->channelCount = 1;
+    tts->frames = speech->sampleRate*seconds;
+    tts->pcm = (int16_t *)calloc(tts->frames, sizeof(int16_t));
+    int interval = speech->sampleRate/1000*BENCH_TTS_INTERVAL;
+    for (int start = interval/2; start < tts->frames; start += interval) {
+        for (int i = 0; i < speech->frames && start + i < tts->frames; i++)
+            tts->pcm[start + i] = speech->pcm[i*speech->channelCount];
+    }
+}
+
+// What the speaker plays, at 16k: the streams through their own resampler, same as
+// GnAec does it, so that the echo path is linear in the reference
+static void bench_speaker_add(const Bench_Pcm_t *stream, double *speaker, int samples)
+{
+    litevad_resampler_handle_t resampler =
+            litevad_resampler_create(stream->sampleRate, stream->channelCount, 16);
+    int frameBytes = stream->channelCount*2;
+    int chunk = stream->sampleRate/1000*BENCH_WRITE_TIME;
+    int outSize = litevad_resampler_output_size(resampler, chunk*frameBytes);
+    int16_t *out = (int16_t *)malloc(outSize);
+    int pos = 0;
+    for (int i = 0; i + chunk <= stream->frames; i += chunk) {
+        int n = litevad_resampler_process(resampler, stream->pcm + i*stream->channelCount,
+                                          chunk*frameBytes, out, outSize)/2;
+        for (int k = 0; k < n && pos < samples; k++)
+            speaker[pos++] += out[k];
+    }
+    free(out);
+    litevad_resampler_destroy(resampler);
+}
+
+static double bench_energy(const int16_t *pcm, int count)
+{
+    double sum = 0;
+    for (int i = 0; i < count; i++)
+        sum += (double)pcm[i]*pcm[i];
+    return sum;
+}
+
+#if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
+static void bench_kws(SnowboyDetect *detector, const char *name, const int16_t *pcm, int samples,
+                      const int *keywords, int keywordCount, int keywordLen)
+{
+    int window = BENCH_RATE/1000*BENCH_KEYWORD_WINDOW;
+    int block = BENCH_RATE/1000*BENCH_CAPTURE_TIME;
+    int hits = 0, falseAlarms = 0, lastHit = -1;
+    SnowboyDetectReset(detector);
+    for (int pos = 0; pos + block <= samples; pos += block) {
+        if (SnowboyDetectRunDetection(detector, pcm + pos, block, false) <= 0)
+            continue;
+        int end = pos + block;
+        int hit = -1;
+        for (int k = 0; k < keywordCount; k++) {
+            if (end > keywords[k] && end <= keywords[k] + keywordLen + window)
+                hit = k;
+        }
+        if (hit < 0)
+            falseAlarms++;
+        else if (hit != lastHit)
+            hits++;
+        lastHit = hit >= 0 ? hit : lastHit;
+    }
+    fprintf(stdout, "  %-22s hits %2d/%-2d (%5.1f%%)  false alarms %d\n", name, hits, keywordCount,
+            keywordCount > 0 ? 100.0*hits/keywordCount : 0, falseAlarms);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 60;
+    int delayMs = argc > 2 ? atoi(argv[2]) : 230;
+    double serDb = argc > 3 ? atof(argv[3]) : -5;
+    if (seconds < 10 || delayMs < 0 || delayMs > 900) {
+        fprintf(stderr, "Usage: %s [seconds >= 10] [echo delay ms 0~900] [signal to echo dB]\n", argv[0]);
+        return 1;
+    }
+
+    Bench_Pcm_t speech = { 0 }, keyword = { 0 }, music = { 0 }, tts = { 0 };
+    if (!bench_load_wav(BENCH_TTS_FILE, &speech) || !bench_load_wav(BENCH_KEYWORD_FILE, &keyword) ||
+        keyword.sampleRate != BENCH_RATE || keyword.channelCount != 1) {
+        fprintf(stderr, "Failed to load %s and %s (16k mono)\n", BENCH_TTS_FILE, BENCH_KEYWORD_FILE);
+        return 1;
+    }
+    bench_make_music(&music, seconds);
+    bench_make_tts(&tts, &speech, seconds);
+
+    int samples = BENCH_RATE*seconds;
+    double *speaker = (double *)calloc(samples, sizeof(double));
+    int16_t *clean = (int16_t *)calloc(samples, sizeof(int16_t));
+    int16_t *echo = (int16_t *)calloc(samples, sizeof(int16_t));
+    int16_t *mic = (int16_t *)calloc(samples, sizeof(int16_t));
+    int16_t *out = (int16_t *)calloc(samples, sizeof(int16_t));
+    bench_speaker_add(&music, speaker, samples);
+    bench_speaker_add(&tts, speaker, samples);
+
+    // keyword every BENCH_KEYWORD_INTERVAL, that and the noise is the clean capture
+    int keywords[256], keywordCount = 0;
+    for (int start = BENCH_RATE/1000*BENCH_KEYWORD_FIRST; start + keyword.frames < samples && keywordCount < 256;
+         start += BENCH_RATE/1000*BENCH_KEYWORD_INTERVAL) {
+        keywords[keywordCount++] = start;
+        for (int i = 0; i < keyword.frames; i++)
+            clean[start + i] = keyword.pcm[i];
+    }
+    double keywordEnergy = bench_energy(keyword.pcm, keyword.frames)/keyword.frames;
+    for (int i = 0; i < samples; i++)
+        clean[i] = bench_clip(clean[i] + BENCH_NOISE_RMS*1.73*bench_noise());
+
+    // room: direct path plus decaying reflections, then scaled to the signal to echo ratio
+    double room[BENCH_ROOM_TAIL];
+    for (int k = 0; k < BENCH_ROOM_TAIL; k++)
+        room[k] = 0.3*bench_noise()*exp(-k/(BENCH_RATE*0.015));
+    room[0] = 1.0;
+    int delay = BENCH_RATE/1000*delayMs;
+    double *echoRaw = (double *)calloc(samples, sizeof(double));
+    double echoEnergy = 0;
+    for (int i = delay; i < samples; i++) {
+        double v = 0;
+        for (int k = 0; k < BENCH_ROOM_TAIL && i - delay - k >= 0; k++)
+            v += room[k]*speaker[i - delay - k];
+        echoRaw[i] = v;
+        echoEnergy += v*v;
+    }
+    double gain = sqrt(keywordEnergy/(echoEnergy/samples)*pow(10, -serDb/10));
+    for (int i = 0; i < samples; i++) {
+        echo[i] = bench_clip(gain*echoRaw[i]);
+        mic[i] = bench_clip((double)clean[i] + echo[i]);
+    }
+    free(echoRaw);
+
+    if (!GnAec_init(BENCH_RATE, 1, 16)) {
+        fprintf(stderr, "GnAec_init failed\n");
+        return 1;
+    }
+
+    // simulated time: sinks write 40ms at a time, capture hands over 60ms blocks with up
+    // to 3ms of scheduling jitter
+    int musicChunk = music.sampleRate/1000*BENCH_WRITE_TIME;
+    int ttsChunk = tts.sampleRate/1000*BENCH_WRITE_TIME;
+    int block = BENCH_RATE/1000*BENCH_CAPTURE_TIME;
+    int musicPos = 0, ttsPos = 0;
+    double stageCpu = 0;
+    memcpy(out, mic, samples*sizeof(int16_t));
+    for (int ms = 0; ms < seconds*1000; ms += 10) {
+        unsigned long long now = BENCH_CLOCK_BASE + ms*1000ULL;
+        if (ms%BENCH_WRITE_TIME == 0) {
+            if (musicPos + musicChunk <= music.frames)
+                GnAec_reference(&music, music.pcm + musicPos*2, musicChunk*4, music.sampleRate, 2, 16, now);
+            if (ttsPos + ttsChunk <= tts.frames)
+                GnAec_reference(&tts, tts.pcm + ttsPos, ttsChunk*2, tts.sampleRate, 1, 16, now);
+            musicPos += musicChunk;
+            ttsPos += ttsChunk;
+        }
+        // the block is handed over when its last 10ms has been captured
+        int end = ms + 10;
+        if (end%BENCH_CAPTURE_TIME == 0) {
+            unsigned long long captureUsec = BENCH_CLOCK_BASE + end*1000ULL +
+                    (unsigned long long)((bench_noise() + 1)*1500);
+            double start = cpu_time_now();
+            GnAec_process(out + (end - BENCH_CAPTURE_TIME)*BENCH_RATE/1000, block*2, captureUsec);
+            stageCpu += cpu_time_now() - start;
+        }
+    }
+
+    GnAec_Stats_t stats;
+    GnAec_getStats(&stats);
+    int frames = samples/BENCH_FRAME;
+    fprintf(stdout, "%ds, echo delay %dms, signal to echo %.1fdB, %d keywords\n",
+            seconds, delayMs, serDb, keywordCount);
+    fprintf(stdout, "cpu per 10ms frame: aec stage %.1fus avg, echo canceller %uus avg %uus max (%.2f%% of one core)\n",
+            stageCpu*1e6/frames, stats.processAvgUs, stats.processMaxUs, stageCpu*100/seconds);
+    fprintf(stdout, "echo delay estimated %dms, %u realigns, %u/%u frames cancelled\n",
+            stats.delayMs, stats.realigns, stats.cancelledFrames, stats.frames);
+
+    // ERLE where only echo and noise are captured, after 5s of convergence
+    double micEcho = 0, outEcho = 0, noiseOnly = 0;
+    int k = 0;
+    for (int i = BENCH_RATE*5; i < samples; i++) {
+        while (k < keywordCount && keywords[k] + keyword.frames < i)
+            k++;
+        if (k < keywordCount && i >= keywords[k])
+            continue;
+        micEcho += (double)mic[i]*mic[i];
+        outEcho += (double)out[i]*out[i];
+        noiseOnly += (double)clean[i]*clean[i];
+    }
+    double erle = 10*log10(micEcho/outEcho);
+    fprintf(stdout, "ERLE %.1fdB (noise floor limits it to %.1fdB)\n", erle, 10*log10(micEcho/noiseOnly));
+    bool erleFailed = serDb == BENCH_ERLE_CHECK_SER && seconds >= BENCH_ERLE_CHECK_TIME &&
+                      erle < BENCH_ERLE_FLOAT - BENCH_ERLE_MARGIN;
+    if (erleFailed)
+        fprintf(stderr, "ERLE %.1fdB is more than %.1fdB below floating point (%.1fdB)\n",
+                erle, BENCH_ERLE_MARGIN, BENCH_ERLE_FLOAT);
+
+#if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
+    SnowboyDetect *detector = SnowboyDetectConstructor(BENCH_SNOWBOY_RESOURCE, BENCH_SNOWBOY_MODEL);
+    SnowboyDetectSetSensitivity(detector, BENCH_SNOWBOY_SENS);
+    SnowboyDetectSetAudioGain(detector, 1.0);
+    SnowboyDetectApplyFrontend(detector, false);
+    fprintf(stdout, "keyword spotting, %s sensitivity %s:\n", BENCH_SNOWBOY_MODEL, BENCH_SNOWBOY_SENS);
+    bench_kws(detector, "clean", clean, samples, keywords, keywordCount, keyword.frames);
+    bench_kws(detector, "playback, no aec", mic, samples, keywords, keywordCount, keyword.frames);
+    bench_kws(detector, "playback, aec", out, samples, keywords, keywordCount, keyword.frames);
+    SnowboyDetectDestructor(detector);
+#endif
+
+    free(speaker);
+    free(clean);
+    free(echo);
+    free(mic);
+    free(out);
+    free(music.pcm);
+    free(tts.pcm);
+    free(speech.pcm);
+    free(keyword.pcm);
+    return erleFailed ? 1 : 0;
+}
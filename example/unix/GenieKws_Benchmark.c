@@ -0,0 +1,346 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Cost of spotting 1, 2 and 4 keywords on one capture stream. The capture is the keyword
+// (snowboy.wav) said every few seconds, other speech (test.wav) in between, and noise, in
+// 60ms blocks like the alsa engine. Each keyword set is run through one GnKwsEngine, where
+// the models share the frontend and features, and through one engine per keyword, which
+// is what loading the models separately costs. Reports the cpu per block, best of the
+// passes, and the "snowboy" hits and false alarms.
+// Then all keywords through the two stage engine, trigger stage on every block and
+// verification on the retained window, for a few tails: cpu on the capture and on noise
+// only, triggers the verification rejected, false alarms, and how much later than the
+// single stage engine the hits are reported, in audio plus the time verification took.
+//
+//   GenieKws_Benchmark [seconds, default 60] [passes, default 3]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "litevad_resampler.h"
+#include "GenieKwsEngine.h"
+
+#define BENCH_SPEECH_FILE       "test.wav"
+#define BENCH_KEYWORD_FILE      "snowboy.wav"
+#define BENCH_RESOURCE_FILE     "common.res"
+#define BENCH_RATE              16000
+#define BENCH_CAPTURE_TIME      60      // ms per capture block, same as the alsa voice engine
+#define BENCH_KEYWORD_FIRST     2000    // ms
+#define BENCH_KEYWORD_INTERVAL  4000    // ms, speech is said halfway in between
+#define BENCH_KEYWORD_WINDOW    500     // ms after the keyword a detection still counts as hit
+#define BENCH_NOISE_RMS         30
+#define BENCH_KEYWORD_MAX       256
+#define BENCH_VERIFY_WINDOW     1500    // ms, as GenieKwsWorker
+#define BENCH_IDLE_TIME         10      // s of noise only
+
+// same table as GenieKwsWorker, first n entries make a keyword set
+static const GnKws_Keyword_t sBenchKeywords[] = {
+    { "jarvis",   "jarvis.umdl",   "0.8,0.8", true,  NULL },
+    { "alexa",    "alexa.umdl",    "0.6",     true,  NULL },
+    { "computer", "computer.umdl", "0.6",     true,  NULL },
+    { "snowboy",  "snowboy.umdl",  "0.5",     false, NULL },
+};
+static const int sBenchSets[] = { 1, 2, 4 };
+static const int sBenchTails[] = { 0, 120, 240, 480 };   // ms
+
+typedef struct {
+    double cpu;                         // seconds, best pass
+    int hits;
+    int falseAlarms;
+    int hitEnd[BENCH_KEYWORD_MAX];      // sample the keyword was reported at, -1 if missed
+} Bench_Result_t;
+
+typedef struct {
+    int16_t *pcm;
+    int frames;
+    int sampleRate;
+    int channelCount;
+} Bench_Pcm_t;
+
+static unsigned int sBenchSeed = 1;
+
+static double bench_noise()
+{
+    sBenchSeed = sBenchSeed*1103515245 + 12345;
+    return ((int)((sBenchSeed >> 16) & 0x7fff) - 16384)/16384.0;
+}
+
+static double cpu_time_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+static int16_t bench_clip(double v)
+{
+    return v > 32767 ? 32767 : (v < -32768 ? -32768 : (int16_t)lrint(v));
+}
+
+// 16 bit pcm wav, data chunk found by walking the riff chunks
+static bool bench_load_wav(const char *file, Bench_Pcm_t *wav)
+{
+    FILE *fp = fopen(file, "rb");
+    if (fp == NULL)
+        return false;
+    unsigned char header[12], chunk[8];
+    bool ok = false;
+    if (fread(header, 1, 12, fp) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+        goto __out;
+    while (fread(chunk, 1, 8, fp) == 8) {
+        uint32_t size = chunk[4] | chunk[5] << 8 | chunk[6] << 16 | (uint32_t)chunk[7] << 24;
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, fp) != 16)
+                goto __out;
+            wav->channelCount = fmt[2] | fmt[3] << 8;
+            wav->sampleRate = fmt[4] | fmt[5] << 8 | fmt[6] << 16 | fmt[7] << 24;
+            if ((fmt[14] | fmt[15] << 8) != 16)
+                goto __out;
+            fseek(fp, size - 16 + (size & 1), SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (wav->channelCount <= 0)
+                goto __out;
+            wav->frames = size/(2*wav->channelCount);
+            wav->pcm = (int16_t *)malloc(size);
+            ok = wav->pcm != NULL && fread(wav->pcm, 1, wav->frames*2*wav->channelCount, fp) ==
+                 (size_t)(wav->frames*2*wav->channelCount);
+            break;
+        } else {
+            fseek(fp, size + (size & 1), SEEK_CUR);
+        }
+    }
+__out:
+    fclose(fp);
+    return ok;
+}
+
+// wav converted to 16k mono, whole file in one go
+static int16_t *bench_resample(const Bench_Pcm_t *wav, int *samples)
+{
+    litevad_resampler_handle_t resampler =
+            litevad_resampler_create(wav->sampleRate, wav->channelCount, 16);
+    int inSize = wav->frames*wav->channelCount*2;
+    int outSize = litevad_resampler_output_size(resampler, inSize);
+    int16_t *out = (int16_t *)malloc(outSize);
+    *samples = litevad_resampler_process(resampler, wav->pcm, inSize, out, outSize)/2;
+    litevad_resampler_destroy(resampler);
+    return out;
+}
+
+// One pass over the capture. engines[0..count) all see every block, the first to fire
+// wins, like GnKwsEngine_run does across its detectors. Returns the cpu time taken
+static double bench_pass(GnKwsEngine_t **engines, int count, const int16_t *pcm, int samples,
+                         const int *keywords, int keywordCount, int keywordLen, Bench_Result_t *result)
+{
+    int window = BENCH_RATE/1000*BENCH_KEYWORD_WINDOW;
+    int block = BENCH_RATE/1000*BENCH_CAPTURE_TIME;
+    int lastHit = -1;
+    double cpu = 0;
+    result->hits = result->falseAlarms = 0;
+    for (int k = 0; k < keywordCount; k++)
+        result->hitEnd[k] = -1;
+    for (int i = 0; i < count; i++)
+        GnKwsEngine_reset(engines[i]);
+    for (int pos = 0; pos + block <= samples; pos += block) {
+        const GnKws_Keyword_t *fired = NULL;
+        double start = cpu_time_now();
+        for (int i = 0; i < count; i++) {
+            const GnKws_Keyword_t *keyword = GnKwsEngine_run(engines[i], pcm + pos, block, NULL);
+            if (fired == NULL)
+                fired = keyword;
+        }
+        cpu += cpu_time_now() - start;
+        if (fired == NULL)
+            continue;
+        int end = pos + block;
+        int hit = -1;
+        for (int k = 0; k < keywordCount; k++) {
+            if (end > keywords[k] && end <= keywords[k] + keywordLen + window)
+                hit = k;
+        }
+        if (hit < 0 || strcmp(fired->word, "snowboy") != 0) {
+            result->falseAlarms++;
+        } else if (hit != lastHit) {
+            result->hits++;
+            result->hitEnd[hit] = end;
+        }
+        lastHit = hit >= 0 ? hit : lastHit;
+    }
+    return cpu;
+}
+
+static void bench_run(GnKwsEngine_t **engines, int count, int passes, const int16_t *pcm, int samples,
+                      const int *keywords, int keywordCount, int keywordLen, Bench_Result_t *result)
+{
+    result->cpu = 1e9;
+    for (int p = 0; p < passes; p++) {
+        double cpu = bench_pass(engines, count, pcm, samples, keywords, keywordCount, keywordLen, result);
+        if (cpu < result->cpu)
+            result->cpu = cpu;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 60;
+    int passes = argc > 2 ? atoi(argv[2]) : 3;
+    if (seconds < 10 || passes <= 0) {
+        fprintf(stderr, "Usage: %s [seconds >= 10] [passes]\n", argv[0]);
+        return 1;
+    }
+
+    Bench_Pcm_t speechWav = { 0 }, keyword = { 0 };
+    if (!bench_load_wav(BENCH_SPEECH_FILE, &speechWav) || !bench_load_wav(BENCH_KEYWORD_FILE, &keyword) ||
+        keyword.sampleRate != BENCH_RATE || keyword.channelCount != 1) {
+        fprintf(stderr, "Failed to load %s and %s (16k mono)\n", BENCH_SPEECH_FILE, BENCH_KEYWORD_FILE);
+        return 1;
+    }
+    int speechLen = 0;
+    int16_t *speech = bench_resample(&speechWav, &speechLen);
+
+    int samples = BENCH_RATE*seconds;
+    int16_t *capture = (int16_t *)calloc(samples, sizeof(int16_t));
+    int keywords[BENCH_KEYWORD_MAX], keywordCount = 0;
+    int interval = BENCH_RATE/1000*BENCH_KEYWORD_INTERVAL;
+    for (int start = BENCH_RATE/1000*BENCH_KEYWORD_FIRST; start + keyword.frames < samples && keywordCount < BENCH_KEYWORD_MAX;
+         start += interval) {
+        keywords[keywordCount++] = start;
+        for (int i = 0; i < keyword.frames; i++)
+            capture[start + i] = keyword.pcm[i];
+    }
+    for (int start = BENCH_RATE/1000*BENCH_KEYWORD_FIRST + interval/2; start < samples; start += interval) {
+        for (int i = 0; i < speechLen && i < interval/2 && start + i < samples; i++)
+            capture[start + i] = speech[i];
+    }
+    for (int i = 0; i < samples; i++)
+        capture[i] = bench_clip(capture[i] + BENCH_NOISE_RMS*1.73*bench_noise());
+    int idleSamples = BENCH_RATE*BENCH_IDLE_TIME;
+    int16_t *idle = (int16_t *)malloc(idleSamples*sizeof(int16_t));
+    for (int i = 0; i < idleSamples; i++)
+        idle[i] = bench_clip(BENCH_NOISE_RMS*1.73*bench_noise());
+
+    int block = BENCH_RATE/1000*BENCH_CAPTURE_TIME;
+    int blocks = samples/block;
+    fprintf(stdout, "%ds, %d keywords (snowboy) and speech in between, %dms blocks, best of %d passes\n",
+            seconds, keywordCount, BENCH_CAPTURE_TIME, passes);
+    fprintf(stdout, "%-6s %-30s %-26s %-26s\n", "models", "", "shared frontend", "engine per model");
+
+    GnKwsEngine_Config_t config = { .audioGain = 1.0, .verifyWindow = 0, .verifyTail = 0 };
+    Bench_Result_t shared, separate;
+    int setCount = sizeof(sBenchSets)/sizeof(sBenchSets[0]);
+    double sharedBase = 0, separateBase = 0;
+    for (int s = 0; s < setCount; s++) {
+        int n = sBenchSets[s];
+        char names[128] = "";
+        for (int i = 0; i < n; i++) {
+            strcat(names, i > 0 ? "," : "");
+            strcat(names, sBenchKeywords[i].word);
+        }
+
+        GnKwsEngine_t *sharedEngine = GnKwsEngine_create(BENCH_RESOURCE_FILE, sBenchKeywords, n, &config);
+        GnKwsEngine_t *separateEngines[4] = { NULL };
+        bool ok = sharedEngine != NULL;
+        for (int i = 0; i < n && ok; i++) {
+            separateEngines[i] = GnKwsEngine_create(BENCH_RESOURCE_FILE, &sBenchKeywords[i], 1, &config);
+            ok = separateEngines[i] != NULL;
+        }
+        if (!ok) {
+            fprintf(stderr, "GnKwsEngine_create failed, are the models in the working directory?\n");
+            return 1;
+        }
+
+        bench_run(&sharedEngine, 1, passes, capture, samples, keywords, keywordCount, keyword.frames, &shared);
+        bench_run(separateEngines, n, passes, capture, samples, keywords, keywordCount, keyword.frames, &separate);
+        double sharedUs = shared.cpu*1e6/blocks, separateUs = separate.cpu*1e6/blocks;
+        if (s == 0) {
+            sharedBase = sharedUs;
+            separateBase = separateUs;
+        }
+        fprintf(stdout, "%-6d %-30s %7.0fus x%.2f (%d det)   %7.0fus x%.2f (%d det)\n",
+                n, names, sharedUs, sharedUs/sharedBase, GnKwsEngine_detectorCount(sharedEngine),
+                separateUs, separateUs/separateBase, n);
+        fprintf(stdout, "%-6s %-30s hits %2d/%-2d false alarms %-3d hits %2d/%-2d false alarms %d\n",
+                "", "", shared.hits, keywordCount, shared.falseAlarms, separate.hits, keywordCount,
+                separate.falseAlarms);
+
+        GnKwsEngine_destroy(sharedEngine);
+        for (int i = 0; i < n; i++)
+            GnKwsEngine_destroy(separateEngines[i]);
+    }
+    fprintf(stdout, "cpu per %dms block, x: relative to one model, %.2f%% of one core for one model\n",
+            BENCH_CAPTURE_TIME, sharedBase*100/(BENCH_CAPTURE_TIME*1000));
+
+
+    // shared holds the single stage run of all keywords, the reference for the latency
+    int keywordSets = sBenchSets[setCount - 1];
+    int idleBlocks = idleSamples/block;
+    Bench_Result_t twoStage, idleRun;
+    fprintf(stdout, "\ntwo stage, %d keywords, verified on the last %dms:\n", keywordSets, BENCH_VERIFY_WINDOW);
+    fprintf(stdout, "%-14s %9s %9s %8s %8s %7s %6s %14s\n", "", "us/block", "idle", "triggers",
+            "rejected", "hits", "false", "extra latency");
+    for (int t = -1; t < (int)(sizeof(sBenchTails)/sizeof(sBenchTails[0])); t++) {
+        config.verifyWindow = t < 0 ? 0 : BENCH_VERIFY_WINDOW;
+        config.verifyTail = t < 0 ? 0 : sBenchTails[t];
+        GnKwsEngine_t *engine = GnKwsEngine_create(BENCH_RESOURCE_FILE, sBenchKeywords, keywordSets, &config);
+        if (engine == NULL) {
+            fprintf(stderr, "GnKwsEngine_create failed\n");
+            return 1;
+        }
+        bench_run(&engine, 1, passes, capture, samples, keywords, keywordCount, keyword.frames, &twoStage);
+        bench_run(&engine, 1, passes, idle, idleSamples, keywords, 0, keyword.frames, &idleRun);
+        GnKwsEngine_Stats_t stats;
+        GnKwsEngine_getStats(engine, &stats);
+        GnKwsEngine_destroy(engine);
+
+        char name[32], triggers[16], rejects[16], latency[32];
+        if (t < 0) {
+            snprintf(name, sizeof(name), "single stage");
+            snprintf(triggers, sizeof(triggers), "-");
+            snprintf(rejects, sizeof(rejects), "-");
+            snprintf(latency, sizeof(latency), "-");
+        } else {
+            // later than single stage, over the keywords both reported
+            double delay = 0;
+            int both = 0;
+            for (int k = 0; k < keywordCount; k++) {
+                if (shared.hitEnd[k] >= 0 && twoStage.hitEnd[k] >= 0) {
+                    delay += twoStage.hitEnd[k] - shared.hitEnd[k];
+                    both++;
+                }
+            }
+            snprintf(name, sizeof(name), "tail %dms", sBenchTails[t]);
+            snprintf(triggers, sizeof(triggers), "%u", stats.triggers/passes);
+            snprintf(rejects, sizeof(rejects), "%u", stats.rejects/passes);
+            snprintf(latency, sizeof(latency), "%.0f+%.1fms", both > 0 ? delay*1000/BENCH_RATE/both : 0,
+                     stats.verifyAvgUs/1000.0);
+        }
+        fprintf(stdout, "%-14s %9.0f %9.0f %8s %8s %4d/%-2d %6d %14s\n", name, twoStage.cpu*1e6/blocks,
+                idleRun.cpu*1e6/idleBlocks, triggers, rejects, twoStage.hits, keywordCount,
+                twoStage.falseAlarms, latency);
+    }
+    fprintf(stdout, "idle: cpu per block on noise only, extra latency: audio after the single stage hit"
+            " + verification time\n");
+
+    free(capture);
+    free(idle);
+    free(speech);
+    free(speechWav.pcm);
+    free(keyword.pcm);
+    return 0;
+}
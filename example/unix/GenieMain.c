@@ -22,6 +22,9 @@
 
 #include "GenieSdk.h"
 #include "GenieVendor.h"
+#if defined(GENIE_HAVE_AEC_ENABLED)
+#include "GenieAec.h"
+#endif
 
 #define TAG "GenieMain"
 
@@ -175,6 +178,12 @@ int main(int argc, char **argv)
         OS_LOGE(TAG, "Failed to GenieSdk_Register_NluResultListener");
         goto __exit;
     }
+#if defined(GENIE_HAVE_AEC_ENABLED)
+    if (!GenieSdk_Register_PcmOutListener(GnAec_pcmOutListener)) {
+        OS_LOGE(TAG, "Failed to GenieSdk_Register_PcmOutListener");
+        goto __exit;
+    }
+#endif
     if (!GenieSdk_Start()) {
         OS_LOGE(TAG, "Failed to GenieSdk_Start");
         goto __exit;
@@ -209,6 +218,9 @@ __exit:
     GenieSdk_Unregister_StatusListener(Genie_Status_Handler);
     GenieSdk_Unregister_AsrResultListener(Genie_AsrResult_Handler);
     GenieSdk_Unregister_NluResultListener(Genie_NluResult_Handler);
+#if defined(GENIE_HAVE_AEC_ENABLED)
+    GenieSdk_Unregister_PcmOutListener(GnAec_pcmOutListener);
+#endif
     OS_MEMORY_DUMP();
     return 0;
 }
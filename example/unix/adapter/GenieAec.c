@@ -0,0 +1,390 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "osal/os_thread.h"
+#include "osal/os_time.h"
+#include "cutils/memory_helper.h"
+#include "cutils/log_helper.h"
+#include "litevad_resampler.h"
+#include "speex/speex_echo.h"
+#include "GenieAec.h"
+
+#define TAG "GenieAec"
+
+#define GENIE_AEC_SAMPLE_RATE           16000
+#define GENIE_AEC_FRAME_SAMPLES         160   // 10ms, timeline unit
+#define GENIE_AEC_FRAME_USEC            10000
+#define GENIE_AEC_FILTER_LENGTH         2048  // samples, 128ms of echo tail after the aligned delay
+#define GENIE_AEC_FILTER_FRAMES         ((GENIE_AEC_FILTER_LENGTH + GENIE_AEC_FRAME_SAMPLES - 1)/GENIE_AEC_FRAME_SAMPLES)
+
+#define GENIE_AEC_REF_FRAMES            256   // reference ring, 2.56s around now
+#define GENIE_AEC_REF_STREAMS           4     // player sinks mixed at the same time
+#define GENIE_AEC_REF_AHEAD_MAX         100   // frames, stream timeline re-anchored beyond this
+#define GENIE_AEC_REF_IDLE              100   // frames without writes before a stream slot is reused
+#define GENIE_AEC_REF_CHUNK             8     // frames of reference resampled per call
+#define GENIE_AEC_CAPTURE_DRIFT_MAX     10    // frames, capture timeline re-anchored beyond this
+
+// Delay estimator: normalized cross-correlation of the log energy envelopes of capture
+// and reference, over the last GENIE_AEC_DELAY_HISTORY frames. An estimate is taken
+// when it repeats on two runs, the reference is then aligned GENIE_AEC_DELAY_MARGIN
+// frames before it and only realigned when the estimate leaves the filter's head room
+#define GENIE_AEC_DELAY_LAGS            100   // 0~990ms, pcm out buffer plus capture latency
+#define GENIE_AEC_DELAY_HISTORY         400
+#define GENIE_AEC_DELAY_INTERVAL        100   // frames between runs
+#define GENIE_AEC_DELAY_MIN_CORR        0.5f
+#define GENIE_AEC_DELAY_MIN_VARIANCE    1.0f  // reference envelope must move, log energy units
+#define GENIE_AEC_DELAY_MARGIN          2
+#define GENIE_AEC_DELAY_SLACK           4
+
+#define GENIE_AEC_SILENCE_ENERGY        (GENIE_AEC_FRAME_SAMPLES*4) // reference below this is silence
+#define GENIE_AEC_STATS_INTERVAL        60000 // ms
+
+typedef struct {
+    void *stream;
+    int sampleRate;
+    int channelCount;
+    int bitsPerSample;
+    litevad_resampler_handle_t resampler;
+    long long nextFrame;        // timeline frame of the next resampled frame
+    long long lastWriteFrame;   // clock frame of the last write
+} GnAec_RefStream_t;
+
+static SpeexEchoState *sGnEchoState = NULL;
+static os_mutex sGnRefLock = NULL;
+
+// reference side, guarded by sGnRefLock
+static GnAec_RefStream_t sGnRefStreams[GENIE_AEC_REF_STREAMS];
+static int16_t sGnRefFrames[GENIE_AEC_REF_FRAMES][GENIE_AEC_FRAME_SAMPLES];
+static long long sGnRefFrameIndex[GENIE_AEC_REF_FRAMES];    // timeline frame held by the slot, -1 none
+static int16_t sGnRefBuf[(GENIE_AEC_REF_CHUNK + 2)*GENIE_AEC_FRAME_SAMPLES];
+
+// capture side only
+static long long sGnCaptureNext = -1;
+static int16_t sGnRefAligned[GENIE_AEC_FRAME_SAMPLES];
+static int16_t sGnRefZeroDelay[GENIE_AEC_FRAME_SAMPLES];
+static int16_t sGnOutBuf[GENIE_AEC_FRAME_SAMPLES];
+static float sGnCaptureEnv[GENIE_AEC_DELAY_HISTORY];
+static float sGnRefEnv[GENIE_AEC_DELAY_HISTORY];
+static float sGnCaptureLin[GENIE_AEC_DELAY_HISTORY];
+static float sGnRefLin[GENIE_AEC_DELAY_HISTORY];
+static int sGnEnvPos = 0;
+static int sGnEnvCount = 0;
+static int sGnDelayCandidate = -1;
+static int sGnDelay = -1;       // frames
+static int sGnAlign = -1;       // frames the reference is read behind the capture
+static int sGnRefSilentFrames = GENIE_AEC_FILTER_FRAMES + 2;
+static unsigned long long sGnLastStatsUsec = 0;
+
+static unsigned int sGnFrames = 0;
+static unsigned int sGnCancelledFrames = 0;
+static unsigned long long sGnProcessTotalUs = 0;
+static unsigned int sGnProcessMaxUs = 0;
+static unsigned int sGnRealigns = 0;
+static double sGnCancelInEnergy = 0;
+static double sGnCancelOutEnergy = 0;
+
+static float GnAec_Frame_LogEnergy(const int16_t *pcm, double *energy)
+{
+    double sum = 0;
+    for (int i = 0; i < GENIE_AEC_FRAME_SAMPLES; i++)
+        sum += (double)pcm[i]*pcm[i];
+    if (energy != NULL)
+        *energy = sum;
+    return logf((float)sum + GENIE_AEC_FRAME_SAMPLES);
+}
+
+static void GnAec_Mix_RefFrame(long long frame, const int16_t *pcm)
+{
+    int slot = (int)(frame % GENIE_AEC_REF_FRAMES);
+    int16_t *dst = sGnRefFrames[slot];
+    if (sGnRefFrameIndex[slot] != frame) {
+        memcpy(dst, pcm, sizeof(sGnRefFrames[0]));
+        sGnRefFrameIndex[slot] = frame;
+        return;
+    }
+    for (int i = 0; i < GENIE_AEC_FRAME_SAMPLES; i++) {
+        int v = dst[i] + pcm[i];
+        dst[i] = v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+    }
+}
+
+// Frames never written, or overwritten by a later lap of the ring, read as silence
+static void GnAec_Read_RefFrame(long long frame, int16_t *pcm)
+{
+    int slot = (int)(frame % GENIE_AEC_REF_FRAMES);
+    if (frame >= 0 && sGnRefFrameIndex[slot] == frame)
+        memcpy(pcm, sGnRefFrames[slot], sizeof(sGnRefFrames[0]));
+    else
+        memset(pcm, 0x0, sizeof(sGnRefFrames[0]));
+}
+
+static GnAec_RefStream_t *GnAec_Find_RefStream(void *stream, int sampleRate, int channelCount,
+                                               int bitsPerSample, long long clockFrame)
+{
+    GnAec_RefStream_t *ref = NULL;
+    for (int i = 0; i < GENIE_AEC_REF_STREAMS; i++) {
+        GnAec_RefStream_t *s = &sGnRefStreams[i];
+        if (s->stream == stream && s->lastWriteFrame >= clockFrame - GENIE_AEC_REF_IDLE &&
+            s->sampleRate == sampleRate && s->channelCount == channelCount &&
+            s->bitsPerSample == bitsPerSample)
+            return s;
+        if (ref == NULL || s->lastWriteFrame < ref->lastWriteFrame)
+            ref = s;
+    }
+
+    // reuse the slot written least recently, a sink handle may also come back for a new stream
+    if (ref->resampler != NULL && (ref->sampleRate != sampleRate ||
+        ref->channelCount != channelCount || ref->bitsPerSample != bitsPerSample)) {
+        litevad_resampler_destroy(ref->resampler);
+        ref->resampler = NULL;
+    }
+    if (ref->resampler == NULL)
+        ref->resampler = litevad_resampler_create(sampleRate, channelCount, bitsPerSample);
+    else
+        litevad_resampler_reset(ref->resampler);
+    if (ref->resampler == NULL)
+        OS_LOGW(TAG, "Reference %dHz %dch %dbit not supported, no echo cancellation of this stream",
+                sampleRate, channelCount, bitsPerSample);
+    ref->stream = stream;
+    ref->sampleRate = sampleRate;
+    ref->channelCount = channelCount;
+    ref->bitsPerSample = bitsPerSample;
+    ref->nextFrame = clockFrame;
+    ref->lastWriteFrame = clockFrame;
+    return ref;
+}
+
+static void GnAec_Estimate_Delay()
+{
+    int n = sGnEnvCount;
+    if (n < GENIE_AEC_DELAY_LAGS + GENIE_AEC_DELAY_INTERVAL)
+        return;
+    int start = (sGnEnvPos - n + GENIE_AEC_DELAY_HISTORY) % GENIE_AEC_DELAY_HISTORY;
+    float refMean = 0, refVar = 0;
+    for (int i = 0; i < n; i++) {
+        int idx = (start + i) % GENIE_AEC_DELAY_HISTORY;
+        sGnCaptureLin[i] = sGnCaptureEnv[idx];
+        sGnRefLin[i] = sGnRefEnv[idx];
+        refMean += sGnRefLin[i];
+    }
+    refMean /= n;
+    for (int i = 0; i < n; i++)
+        refVar += (sGnRefLin[i] - refMean)*(sGnRefLin[i] - refMean);
+    if (refVar/n < GENIE_AEC_DELAY_MIN_VARIANCE)
+        return; // reference silent or flat, nothing to correlate
+
+    int best = -1;
+    float bestCorr = 0;
+    for (int d = 0; d < GENIE_AEC_DELAY_LAGS; d++) {
+        // capture frame t holds the echo of reference frame t-d
+        const float *cap = sGnCaptureLin + d;
+        const float *ref = sGnRefLin;
+        int len = n - d;
+        float capMean = 0, refMeanLag = 0;
+        for (int i = 0; i < len; i++) {
+            capMean += cap[i];
+            refMeanLag += ref[i];
+        }
+        capMean /= len;
+        refMeanLag /= len;
+        float cr = 0, cc = 0, rr = 0;
+        for (int i = 0; i < len; i++) {
+            float c = cap[i] - capMean, r = ref[i] - refMeanLag;
+            cr += c*r;
+            cc += c*c;
+            rr += r*r;
+        }
+        if (cc <= 0 || rr <= 0)
+            continue;
+        float corr = cr/sqrtf(cc*rr);
+        if (corr > bestCorr) {
+            bestCorr = corr;
+            best = d;
+        }
+    }
+    if (best < 0 || bestCorr < GENIE_AEC_DELAY_MIN_CORR)
+        return;
+    if (sGnDelayCandidate < 0 || best < sGnDelayCandidate - 1 || best > sGnDelayCandidate + 1) {
+        sGnDelayCandidate = best;
+        return;
+    }
+    sGnDelayCandidate = best;
+    sGnDelay = best;
+
+    int lowest = sGnAlign > 0 ? sGnAlign + 1 : 0; // align can't go below 0 to keep the margin
+    if (sGnAlign < 0 || best < lowest || best > sGnAlign + GENIE_AEC_DELAY_SLACK) {
+        int align = best > GENIE_AEC_DELAY_MARGIN ? best - GENIE_AEC_DELAY_MARGIN : 0;
+        OS_LOGI(TAG, "Echo delay %dms (corr %.2f), reference aligned %dms behind capture",
+                best*GENIE_AEC_FRAME_USEC/1000, bestCorr, align*GENIE_AEC_FRAME_USEC/1000);
+        sGnAlign = align;
+        sGnRealigns++;
+        // echo path moved outside the filter, adapting from scratch converges faster
+        speex_echo_state_reset(sGnEchoState);
+    }
+}
+
+bool GnAec_init(int sampleRate, int channelCount, int bitsPerSample)
+{
+    if (sampleRate != GENIE_AEC_SAMPLE_RATE || channelCount != 1 || bitsPerSample != 16) {
+        OS_LOGE(TAG, "Record parameters not matched, abort echo cancellation");
+        return false;
+    }
+    sGnRefLock = os_mutex_create();
+    if (sGnRefLock == NULL) {
+        OS_LOGE(TAG, "os_mutex_create failed");
+        return false;
+    }
+    sGnEchoState = speex_echo_state_init(GENIE_AEC_FRAME_SAMPLES, GENIE_AEC_FILTER_LENGTH);
+    if (sGnEchoState == NULL) {
+        OS_LOGE(TAG, "speex_echo_state_init failed");
+        os_mutex_destroy(sGnRefLock);
+        sGnRefLock = NULL;
+        return false;
+    }
+    int rate = GENIE_AEC_SAMPLE_RATE;
+    speex_echo_ctl(sGnEchoState, SPEEX_ECHO_SET_SAMPLING_RATE, &rate);
+    for (int i = 0; i < GENIE_AEC_REF_FRAMES; i++)
+        sGnRefFrameIndex[i] = -1;
+    for (int i = 0; i < GENIE_AEC_REF_STREAMS; i++)
+        sGnRefStreams[i].lastWriteFrame = -1;
+    return true;
+}
+
+void GnAec_pcmOutListener(void *stream, const void *buffer, unsigned int size,
+                          int sampleRate, int channelCount, int bitsPerSample)
+{
+    GnAec_reference(stream, buffer, size, sampleRate, channelCount, bitsPerSample, os_monotonic_usec());
+}
+
+// Sink writes of a stream are contiguous pcm, so they're laid on the timeline back to
+// back from where the stream started. The device queue paces the writes, the timeline
+// is only re-anchored to the write clock after an underrun (it fell behind) or when it
+// ran off too far ahead, e.g. 44.1k resampled as 44k running 0.2% fast.
+void GnAec_reference(void *stream, const void *buffer, unsigned int size,
+                     int sampleRate, int channelCount, int bitsPerSample,
+                     unsigned long long writeUsec)
+{
+    if (sGnEchoState == NULL || buffer == NULL || size == 0)
+        return;
+    int frameBytes = channelCount*(bitsPerSample == 16 ? 2 : 4);
+    if (frameBytes <= 0 || sampleRate <= 0)
+        return;
+    size -= size%frameBytes;
+    long long clockFrame = (long long)(writeUsec/GENIE_AEC_FRAME_USEC);
+
+    os_mutex_lock(sGnRefLock);
+    GnAec_RefStream_t *ref = GnAec_Find_RefStream(stream, sampleRate, channelCount, bitsPerSample, clockFrame);
+    ref->lastWriteFrame = clockFrame;
+    if (ref->resampler == NULL) {
+        os_mutex_unlock(sGnRefLock);
+        return;
+    }
+    if (ref->nextFrame < clockFrame || ref->nextFrame > clockFrame + GENIE_AEC_REF_AHEAD_MAX)
+        ref->nextFrame = clockFrame;
+
+    const char *in = (const char *)buffer;
+    unsigned int chunk = (unsigned int)(frameBytes*(sampleRate/100)*GENIE_AEC_REF_CHUNK);
+    while (size > 0) {
+        unsigned int bytes = size > chunk ? chunk : size;
+        int out = litevad_resampler_process(ref->resampler, in, bytes, sGnRefBuf, sizeof(sGnRefBuf));
+        for (int i = 0; i + GENIE_AEC_FRAME_SAMPLES*2 <= out; i += GENIE_AEC_FRAME_SAMPLES*2)
+            GnAec_Mix_RefFrame(ref->nextFrame++, sGnRefBuf + i/2);
+        in += bytes;
+        size -= bytes;
+    }
+    os_mutex_unlock(sGnRefLock);
+}
+
+void GnAec_process(void *pcm, unsigned int size, unsigned long long captureUsec)
+{
+    if (sGnEchoState == NULL)
+        return;
+    int frames = size/(GENIE_AEC_FRAME_SAMPLES*2);
+    long long expected = (long long)(captureUsec/GENIE_AEC_FRAME_USEC) - frames;
+    if (sGnCaptureNext < 0 || sGnCaptureNext < expected - GENIE_AEC_CAPTURE_DRIFT_MAX ||
+        sGnCaptureNext > expected + GENIE_AEC_CAPTURE_DRIFT_MAX)
+        sGnCaptureNext = expected;
+
+    int16_t *frame = (int16_t *)pcm;
+    for (int f = 0; f < frames; f++, frame += GENIE_AEC_FRAME_SAMPLES) {
+        long long c = sGnCaptureNext++;
+        os_mutex_lock(sGnRefLock);
+        GnAec_Read_RefFrame(c, sGnRefZeroDelay);
+        if (sGnAlign >= 0)
+            GnAec_Read_RefFrame(c - sGnAlign, sGnRefAligned);
+        os_mutex_unlock(sGnRefLock);
+
+        double inEnergy, refEnergy = 0;
+        sGnCaptureEnv[sGnEnvPos] = GnAec_Frame_LogEnergy(frame, &inEnergy);
+        sGnRefEnv[sGnEnvPos] = GnAec_Frame_LogEnergy(sGnRefZeroDelay, NULL);
+        sGnEnvPos = (sGnEnvPos + 1) % GENIE_AEC_DELAY_HISTORY;
+        if (sGnEnvCount < GENIE_AEC_DELAY_HISTORY)
+            sGnEnvCount++;
+
+        if (sGnAlign >= 0)
+            GnAec_Frame_LogEnergy(sGnRefAligned, &refEnergy);
+        if (refEnergy < GENIE_AEC_SILENCE_ENERGY)
+            sGnRefSilentFrames++;
+        else
+            sGnRefSilentFrames = 0;
+
+        // keep feeding silence until it filled the filter, then leave capture untouched
+        if (sGnAlign >= 0 && sGnRefSilentFrames <= GENIE_AEC_FILTER_FRAMES + 1) {
+            unsigned long long start = os_monotonic_usec();
+            speex_echo_cancellation(sGnEchoState, frame, sGnRefAligned, sGnOutBuf);
+            unsigned int cost = (unsigned int)(os_monotonic_usec() - start);
+            double outEnergy = 0;
+            for (int i = 0; i < GENIE_AEC_FRAME_SAMPLES; i++)
+                outEnergy += (double)sGnOutBuf[i]*sGnOutBuf[i];
+            memcpy(frame, sGnOutBuf, sizeof(sGnOutBuf));
+            sGnCancelledFrames++;
+            sGnProcessTotalUs += cost;
+            if (cost > sGnProcessMaxUs)
+                sGnProcessMaxUs = cost;
+            sGnCancelInEnergy += inEnergy;
+            sGnCancelOutEnergy += outEnergy;
+        }
+
+        sGnFrames++;
+        if (sGnFrames%GENIE_AEC_DELAY_INTERVAL == 0)
+            GnAec_Estimate_Delay();
+    }
+
+    if (captureUsec - sGnLastStatsUsec >= GENIE_AEC_STATS_INTERVAL*1000ULL) {
+        if (sGnLastStatsUsec != 0) {
+            GnAec_Stats_t stats;
+            GnAec_getStats(&stats);
+            OS_LOGD(TAG, "Aec stats: frames=%u, cancelled=%u, process avg=%uus max=%uus, delay=%dms, realigns=%u, erle=%ddB",
+                    stats.frames, stats.cancelledFrames, stats.processAvgUs, stats.processMaxUs,
+                    stats.delayMs, stats.realigns, stats.erleDb);
+        }
+        sGnLastStatsUsec = captureUsec;
+    }
+}
+
+void GnAec_getStats(GnAec_Stats_t *stats)
+{
+    stats->frames = sGnFrames;
+    stats->cancelledFrames = sGnCancelledFrames;
+    stats->processAvgUs = sGnCancelledFrames > 0 ? (unsigned int)(sGnProcessTotalUs/sGnCancelledFrames) : 0;
+    stats->processMaxUs = sGnProcessMaxUs;
+    stats->delayMs = sGnDelay >= 0 ? sGnDelay*GENIE_AEC_FRAME_USEC/1000 : -1;
+    stats->realigns = sGnRealigns;
+    stats->erleDb = sGnCancelOutEnergy > 0 ? (int)lround(10*log10(sGnCancelInEnergy/sGnCancelOutEnergy)) : 0;
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __TMALLGENIE_AEC_H__
+#define __TMALLGENIE_AEC_H__
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Acoustic echo cancellation of the capture path against what the player is playing.
+// The pcm written to the player sinks (GenieSdk_Register_PcmOutListener) is converted
+// to 16k mono, mixed and kept on a 10ms frame timeline, capture frames are put on the
+// same timeline and a delay estimator finds the lag of the echo. Capture is then run
+// through the fixed-point speex MDF echo canceller, before VAD, upload and KWS.
+
+typedef struct {
+    unsigned int frames;            // 10ms capture frames processed
+    unsigned int cancelledFrames;   // frames run through the echo canceller
+    unsigned int processAvgUs;      // per 10ms frame, cancelled frames only
+    unsigned int processMaxUs;
+    int delayMs;                    // estimated echo delay, -1 if unknown
+    unsigned int realigns;          // reference realigned to a new delay estimate
+    int erleDb;                     // capture to output energy ratio of cancelled frames
+} GnAec_Stats_t;
+
+// Capture format, must be 16k mono 16bit
+bool GnAec_init(int sampleRate, int channelCount, int bitsPerSample);
+
+// GeniePcmOutListener, register with GenieSdk_Register_PcmOutListener
+void GnAec_pcmOutListener(void *stream, const void *buffer, unsigned int size,
+                          int sampleRate, int channelCount, int bitsPerSample);
+
+// Reference pcm of a player stream, writeUsec is the os_monotonic_usec when it was
+// handed to the device
+void GnAec_reference(void *stream, const void *buffer, unsigned int size,
+                     int sampleRate, int channelCount, int bitsPerSample,
+                     unsigned long long writeUsec);
+
+// Called from capture thread/callback only, cancels echo in place. size must be whole
+// 10ms frames, captureUsec is the os_monotonic_usec of the end of the block
+void GnAec_process(void *pcm, unsigned int size, unsigned long long captureUsec);
+
+void GnAec_getStats(GnAec_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TMALLGENIE_AEC_H__
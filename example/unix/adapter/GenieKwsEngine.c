@@ -0,0 +1,337 @@
+// Copyright (c) 2019-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "osal/os_time.h"
+#include "cutils/memory_helper.h"
+#include "cutils/log_helper.h"
+#include "snowboy-detect-c-wrapper.h"
+#include "GenieKwsEngine.h"
+
+#define TAG "GenieKwsEngine"
+
+#define GENIE_KWS_ENGINE_HOTWORD_MAX    16
+#define GENIE_KWS_ENGINE_DETECTOR_MAX   2   // frontend on, frontend off
+#define GENIE_KWS_ENGINE_VERIFY_CHUNK   100 // ms of the window per detection call
+
+typedef struct {
+    SnowboyDetect *detector;
+    int hotwordCount;
+    int keyword[GENIE_KWS_ENGINE_HOTWORD_MAX];          // keyword of each snowboy hotword
+    double sensitivity[GENIE_KWS_ENGINE_HOTWORD_MAX];
+} GnKwsEngine_Detector_t;
+
+typedef struct {
+    int detectorCount;
+    GnKwsEngine_Detector_t detectors[GENIE_KWS_ENGINE_DETECTOR_MAX];
+} GnKwsEngine_Stage_t;
+
+struct GnKwsEngine {
+    const GnKws_Keyword_t *keywords;
+    bool verify;
+    GnKwsEngine_Stage_t trigger;        // verify only
+    GnKwsEngine_Stage_t detect;         // every block, or on the window after a trigger
+
+    // retained audio, verify only
+    int16_t *window;
+    int windowSize;                     // samples
+    int windowPos;                      // next write
+    int windowFilled;
+    int chunkSize;
+    int tailSize;
+
+    const GnKws_Keyword_t *pending;     // triggered, waiting for the tail
+    int pendingLeft;                    // samples of the tail still to come
+
+    GnKwsEngine_Stats_t stats;
+    unsigned int verifies;
+    unsigned long long verifyTotalUs;
+};
+
+// One detector for the keywords with the given frontend setting, models and sensitivities
+// joined in keyword order, which is the order snowboy numbers the hotwords in. The
+// trigger stage takes all keywords with the frontend off at their trigger sensitivity
+static bool GnKwsEngine_Create_Detector(GnKwsEngine_Stage_t *stage, const char *resource,
+                                        const GnKws_Keyword_t *keywords, int keywordCount,
+                                        bool trigger, bool applyFrontend, float audioGain)
+{
+    GnKwsEngine_Detector_t *det = &stage->detectors[stage->detectorCount];
+    int modelLen = 0, sensitivityLen = 0;
+    for (int i = 0; i < keywordCount; i++) {
+        if (!trigger && keywords[i].applyFrontend != applyFrontend)
+            continue;
+        const char *sensitivity = trigger && keywords[i].triggerSensitivity != NULL ?
+                keywords[i].triggerSensitivity : keywords[i].sensitivity;
+        modelLen += strlen(keywords[i].model) + 1;
+        sensitivityLen += strlen(sensitivity) + 1;
+    }
+    if (modelLen == 0)
+        return true;
+
+    bool ret = false;
+    char *models = OS_CALLOC(1, modelLen);
+    char *sensitivities = OS_CALLOC(1, sensitivityLen);
+    if (models == NULL || sensitivities == NULL) {
+        OS_LOGE(TAG, "Failed to allocate model string");
+        goto __out;
+    }
+    for (int i = 0; i < keywordCount; i++) {
+        if (!trigger && keywords[i].applyFrontend != applyFrontend)
+            continue;
+        const char *sensitivity = trigger && keywords[i].triggerSensitivity != NULL ?
+                keywords[i].triggerSensitivity : keywords[i].sensitivity;
+        if (models[0] != '\0') {
+            strcat(models, ",");
+            strcat(sensitivities, ",");
+        }
+        strcat(models, keywords[i].model);
+        strcat(sensitivities, sensitivity);
+
+        const char *s = sensitivity;
+        while (1) {
+            if (det->hotwordCount >= GENIE_KWS_ENGINE_HOTWORD_MAX) {
+                OS_LOGE(TAG, "Too many hotwords, max %d per detector", GENIE_KWS_ENGINE_HOTWORD_MAX);
+                goto __out;
+            }
+            det->keyword[det->hotwordCount] = i;
+            det->sensitivity[det->hotwordCount] = atof(s);
+            det->hotwordCount++;
+            s = strchr(s, ',');
+            if (s == NULL)
+                break;
+            s++;
+        }
+    }
+
+    det->detector = SnowboyDetectConstructor(resource, models);
+    if (det->detector == NULL) {
+        OS_LOGE(TAG, "SnowboyDetectConstructor failed: %s", models);
+        goto __out;
+    }
+    if (SnowboyDetectNumHotwords(det->detector) != det->hotwordCount) {
+        OS_LOGE(TAG, "%s has %d hotwords, but %d sensitivities given", models,
+                SnowboyDetectNumHotwords(det->detector), det->hotwordCount);
+        SnowboyDetectDestructor(det->detector);
+        det->detector = NULL;
+        goto __out;
+    }
+    SnowboyDetectSetSensitivity(det->detector, sensitivities);
+    SnowboyDetectSetAudioGain(det->detector, audioGain);
+    SnowboyDetectApplyFrontend(det->detector, applyFrontend);
+    OS_LOGI(TAG, "%s detector %d: %s, sensitivity %s, frontend %s", trigger ? "Trigger" : "Keyword",
+            stage->detectorCount, models, sensitivities, applyFrontend ? "on" : "off");
+    stage->detectorCount++;
+    ret = true;
+
+__out:
+    OS_FREE(models);
+    OS_FREE(sensitivities);
+    return ret;
+}
+
+// Every detector of the stage sees the block, also after a hit, to keep their state in step
+static const GnKws_Keyword_t *GnKwsEngine_Run_Stage(GnKwsEngine_t *engine, GnKwsEngine_Stage_t *stage,
+                                                    const int16_t *pcm, int samples, double *confidence)
+{
+    const GnKws_Keyword_t *hit = NULL;
+    for (int i = 0; i < stage->detectorCount; i++) {
+        GnKwsEngine_Detector_t *det = &stage->detectors[i];
+        int ret = SnowboyDetectRunDetection(det->detector, (const int16_t* const)pcm, samples, false);
+        if (ret > 0 && ret <= det->hotwordCount && hit == NULL) {
+            hit = &engine->keywords[det->keyword[ret - 1]];
+            if (confidence != NULL)
+                *confidence = det->sensitivity[ret - 1];
+        } else if (ret == -1) {
+            OS_LOGE(TAG, "SnowboyDetectRunDetection failed");
+        }
+    }
+    return hit;
+}
+
+static void GnKwsEngine_Reset_Stage(GnKwsEngine_Stage_t *stage)
+{
+    for (int i = 0; i < stage->detectorCount; i++)
+        SnowboyDetectReset(stage->detectors[i].detector);
+}
+
+static void GnKwsEngine_Retain(GnKwsEngine_t *engine, const int16_t *pcm, int samples)
+{
+    if (samples > engine->windowSize) {
+        pcm += samples - engine->windowSize;
+        samples = engine->windowSize;
+    }
+    int first = engine->windowSize - engine->windowPos;
+    if (first > samples)
+        first = samples;
+    memcpy(engine->window + engine->windowPos, pcm, first*sizeof(int16_t));
+    memcpy(engine->window, pcm + first, (samples - first)*sizeof(int16_t));
+    engine->windowPos = (engine->windowPos + samples)%engine->windowSize;
+    engine->windowFilled += samples;
+    if (engine->windowFilled > engine->windowSize)
+        engine->windowFilled = engine->windowSize;
+}
+
+// The detectors from a clean state over the retained window, oldest first, until they
+// find the keyword that triggered
+static const GnKws_Keyword_t *GnKwsEngine_Verify(GnKwsEngine_t *engine, double *confidence)
+{
+    unsigned long long start = os_monotonic_usec();
+    const GnKws_Keyword_t *confirmed = NULL;
+    GnKwsEngine_Reset_Stage(&engine->detect);
+    int pos = (engine->windowPos - engine->windowFilled + engine->windowSize)%engine->windowSize;
+    int left = engine->windowFilled;
+    while (left > 0 && confirmed == NULL) {
+        int samples = engine->windowSize - pos;
+        if (samples > engine->chunkSize)
+            samples = engine->chunkSize;
+        if (samples > left)
+            samples = left;
+        if (GnKwsEngine_Run_Stage(engine, &engine->detect, engine->window + pos, samples, confidence) ==
+            engine->pending)
+            confirmed = engine->pending;
+        pos = (pos + samples)%engine->windowSize;
+        left -= samples;
+    }
+
+    unsigned int cost = (unsigned int)(os_monotonic_usec() - start);
+    engine->verifies++;
+    engine->verifyTotalUs += cost;
+    if (cost > engine->stats.verifyMaxUs)
+        engine->stats.verifyMaxUs = cost;
+    if (confirmed == NULL) {
+        engine->stats.rejects++;
+        OS_LOGI(TAG, "Trigger \"%s\" rejected by verification, %uus", engine->pending->word, cost);
+    } else {
+        // the window still holds the keyword just reported, and the trigger stage may fire
+        // on it again (jarvis.umdl has two hotwords): start both over
+        engine->windowPos = 0;
+        engine->windowFilled = 0;
+        GnKwsEngine_Reset_Stage(&engine->trigger);
+    }
+    engine->pending = NULL;
+    return confirmed;
+}
+
+GnKwsEngine_t *GnKwsEngine_create(const char *resource, const GnKws_Keyword_t *keywords,
+                                  int keywordCount, const GnKwsEngine_Config_t *config)
+{
+    if (keywordCount <= 0)
+        return NULL;
+    GnKwsEngine_t *engine = OS_CALLOC(1, sizeof(GnKwsEngine_t));
+    if (engine == NULL)
+        return NULL;
+    engine->keywords = keywords;
+    engine->verify = config->verifyWindow > 0;
+    if (!GnKwsEngine_Create_Detector(&engine->detect, resource, keywords, keywordCount,
+                                     false, true, config->audioGain) ||
+        !GnKwsEngine_Create_Detector(&engine->detect, resource, keywords, keywordCount,
+                                     false, false, config->audioGain))
+        goto __error_create;
+    if (!engine->verify)
+        return engine;
+
+    if (!GnKwsEngine_Create_Detector(&engine->trigger, resource, keywords, keywordCount,
+                                     true, false, config->audioGain))
+        goto __error_create;
+    int sampleRate = SnowboyDetectSampleRate(engine->trigger.detectors[0].detector);
+    engine->windowSize = sampleRate/1000*config->verifyWindow;
+    engine->chunkSize = sampleRate/1000*GENIE_KWS_ENGINE_VERIFY_CHUNK;
+    engine->tailSize = sampleRate/1000*config->verifyTail;
+    if (engine->tailSize >= engine->windowSize) {
+        OS_LOGE(TAG, "Verify tail %dms doesn't fit the %dms window", config->verifyTail, config->verifyWindow);
+        goto __error_create;
+    }
+    engine->window = OS_CALLOC(engine->windowSize, sizeof(int16_t));
+    if (engine->window == NULL) {
+        OS_LOGE(TAG, "Failed to allocate verify window");
+        goto __error_create;
+    }
+    return engine;
+
+__error_create:
+    GnKwsEngine_destroy(engine);
+    return NULL;
+}
+
+bool GnKwsEngine_matchFormat(GnKwsEngine_t *engine, int sampleRate, int channelCount, int bitsPerSample)
+{
+    GnKwsEngine_Stage_t *stages[] = { &engine->detect, &engine->trigger };
+    for (int s = 0; s < 2; s++) {
+        for (int i = 0; i < stages[s]->detectorCount; i++) {
+            SnowboyDetect *detector = stages[s]->detectors[i].detector;
+            if (SnowboyDetectSampleRate(detector) != sampleRate ||
+                SnowboyDetectNumChannels(detector) != channelCount ||
+                SnowboyDetectBitsPerSample(detector) != bitsPerSample)
+                return false;
+        }
+    }
+    return true;
+}
+
+int GnKwsEngine_detectorCount(GnKwsEngine_t *engine)
+{
+    return engine->verify ? engine->trigger.detectorCount : engine->detect.detectorCount;
+}
+
+const GnKws_Keyword_t *GnKwsEngine_run(GnKwsEngine_t *engine, const int16_t *pcm, int samples,
+                                       double *confidence)
+{
+    if (!engine->verify)
+        return GnKwsEngine_Run_Stage(engine, &engine->detect, pcm, samples, confidence);
+
+    GnKwsEngine_Retain(engine, pcm, samples);
+    // the trigger stage keeps running while a trigger waits for its tail, hits are ignored
+    const GnKws_Keyword_t *trigger = GnKwsEngine_Run_Stage(engine, &engine->trigger, pcm, samples, NULL);
+    if (engine->pending != NULL) {
+        engine->pendingLeft -= samples;
+        return engine->pendingLeft <= 0 ? GnKwsEngine_Verify(engine, confidence) : NULL;
+    }
+    if (trigger == NULL)
+        return NULL;
+    engine->stats.triggers++;
+    engine->pending = trigger;
+    engine->pendingLeft = engine->tailSize;
+    return engine->pendingLeft <= 0 ? GnKwsEngine_Verify(engine, confidence) : NULL;
+}
+
+void GnKwsEngine_reset(GnKwsEngine_t *engine)
+{
+    GnKwsEngine_Reset_Stage(&engine->detect);
+    GnKwsEngine_Reset_Stage(&engine->trigger);
+    engine->windowPos = 0;
+    engine->windowFilled = 0;
+    engine->pending = NULL;
+}
+
+void GnKwsEngine_getStats(GnKwsEngine_t *engine, GnKwsEngine_Stats_t *stats)
+{
+    *stats = engine->stats;
+    stats->verifyAvgUs = engine->verifies > 0 ? (unsigned int)(engine->verifyTotalUs/engine->verifies) : 0;
+}
+
+void GnKwsEngine_destroy(GnKwsEngine_t *engine)
+{
+    if (engine == NULL)
+        return;
+    for (int i = 0; i < engine->detect.detectorCount; i++)
+        SnowboyDetectDestructor(engine->detect.detectors[i].detector);
+    for (int i = 0; i < engine->trigger.detectorCount; i++)
+        SnowboyDetectDestructor(engine->trigger.detectors[i].detector);
+    OS_FREE(engine->window);
+    OS_FREE(engine);
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2019-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __TMALLGENIE_KWS_ENGINE_H__
+#define __TMALLGENIE_KWS_ENGINE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Several wake words on one capture stream. Keywords are grouped by their frontend
+// setting and every group is a single snowboy detector loaded with all of its models,
+// so the audio frontend (AGC, NS) and feature extraction run once per block for the
+// group and only the keyword networks run per model. A hit is mapped back from the
+// snowboy hotword index to the keyword it belongs to.
+//
+// With verification on, blocks only run a cheap trigger stage: all models in one
+// detector with the frontend off, at the trigger sensitivities. The frontend is most of
+// the cost while nobody speaks. The last verifyWindow ms of audio are retained, and
+// verifyTail ms after a trigger the detectors above are reset and run on that window.
+// The wakeup is reported only if they find the same keyword in it, so it comes
+// verifyTail ms plus the verification time later.
+
+typedef struct {
+    const char *word;               // reported as wakeupWord
+    const char *model;              // snowboy model file
+    const char *sensitivity;        // one per hotword of the model, comma separated
+    bool applyFrontend;             // as the model was trained, see snowboy ApplyFrontend
+    const char *triggerSensitivity; // trigger stage, NULL to use sensitivity
+} GnKws_Keyword_t;
+
+typedef struct {
+    float audioGain;
+    int verifyWindow;               // ms, 0 runs the detectors on every block instead
+    int verifyTail;                 // ms of the window after the trigger
+} GnKwsEngine_Config_t;
+
+typedef struct {
+    unsigned int triggers;          // trigger stage hits
+    unsigned int rejects;           // triggers the verification didn't confirm
+    unsigned int verifyAvgUs;       // per verification of a window
+    unsigned int verifyMaxUs;
+} GnKwsEngine_Stats_t;
+
+typedef struct GnKwsEngine GnKwsEngine_t;
+
+// keywords must stay valid for the life of the engine
+GnKwsEngine_t *GnKwsEngine_create(const char *resource, const GnKws_Keyword_t *keywords,
+                                  int keywordCount, const GnKwsEngine_Config_t *config);
+
+bool GnKwsEngine_matchFormat(GnKwsEngine_t *engine, int sampleRate, int channelCount, int bitsPerSample);
+
+// Number of snowboy detectors that run on every block, i.e. times the frontend runs
+int GnKwsEngine_detectorCount(GnKwsEngine_t *engine);
+
+// Runs the engine on the next block. Returns the keyword that fired (was confirmed) and
+// sets confidence, NULL if none did. Snowboy gives no score, the confidence is the
+// sensitivity of the hotword that fired.
+const GnKws_Keyword_t *GnKwsEngine_run(GnKwsEngine_t *engine, const int16_t *pcm, int samples,
+                                       double *confidence);
+
+// Call on a gap in the stream, drops the retained audio and a pending trigger
+void GnKwsEngine_reset(GnKwsEngine_t *engine);
+
+void GnKwsEngine_getStats(GnKwsEngine_t *engine, GnKwsEngine_Stats_t *stats);
+
+void GnKwsEngine_destroy(GnKwsEngine_t *engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TMALLGENIE_KWS_ENGINE_H__
@@ -0,0 +1,294 @@
+// Copyright (c) 2019-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "osal/os_thread.h"
+#include "osal/os_time.h"
+#include "cutils/memory_helper.h"
+#include "cutils/log_helper.h"
+#include "cutils/lockfree_ringbuf.h"
+#include "GenieSdk.h"
+#include "GenieKwsEngine.h"
+#include "GenieKwsWorker.h"
+
+#define TAG "GenieKwsWorker"
+
+#define GENIE_KWS_THREAD_NAME           "GnKwsWorker"
+#define GENIE_KWS_THREAD_PRIO           OS_THREAD_PRIO_HIGH
+#define GENIE_KWS_THREAD_STACK          65536
+
+#define GENIE_KWS_RINGBUF_SIZE          32768 // ~1s of 16k/16bit/mono, with block headers
+#define GENIE_KWS_BLOCK_MAX             4096  // bytes, larger feeds are split
+#define GENIE_KWS_STATS_INTERVAL        60000 // ms
+
+//resources/models/snowboy.umdl:
+//    Universal model for the hotword "Snowboy".
+//    Set SetSensitivity to "0.5" and ApplyFrontend to false.
+//resources/models/alexa.umdl:
+//    Universal model for the hotword "Alexa".
+//    Set SetSensitivity to "0.6" and set ApplyFrontend to true.
+//resources/models/jarvis.umdl:
+//    Universal model for the hotword "Jarvis".
+//    It has two different models for the hotword Jarvis,
+//    so you have to use two sensitivites.
+//    Set SetSensitivity to "0.8,0.8" and ApplyFrontend to true.
+//resources/models/computer.umdl:
+//    Universal model for the hotword "Computer".
+//    Set SetSensitivity to "0.6" and ApplyFrontend to true.
+// See https://github.com/Kitt-AI/snowboy#pretrained-universal-models
+#define GENIE_SNOWBOY_RESOURCE_FILE     "common.res"
+#define GENIE_SNOWBOY_AUDIO_GAIN        1.0
+#define GENIE_KWS_VERIFY_WINDOW         1500  // ms of audio retained for verification
+#define GENIE_KWS_VERIFY_TAIL           120   // ms of it after the trigger, in case it fired early
+
+// Keywords listed first win when two fire in the same block. Keywords sharing a frontend
+// setting share one detector, snowboy.umdl needs its own. Every block only runs the
+// trigger stage, all models with the frontend off at the trigger sensitivity (NULL: the
+// same), the detectors confirm a trigger on the retained window, see GenieKwsEngine.h
+static const GnKws_Keyword_t sGnKeywords[] = {
+    { "jarvis",   "jarvis.umdl",   "0.8,0.8", true,  NULL },
+    { "alexa",    "alexa.umdl",    "0.6",     true,  NULL },
+    { "computer", "computer.umdl", "0.6",     true,  NULL },
+    { "snowboy",  "snowboy.umdl",  "0.5",     false, NULL },
+};
+
+// Ring record: header followed by pcm, always written with a single lockfree_ringbuf_write
+// so that the worker never sees a partial block
+typedef struct {
+    uint64_t samplePos;     // position of first sample in the capture stream
+    uint64_t captureUsec;   // os_monotonic_usec when the block was fed
+    uint32_t size;          // pcm bytes following the header
+    uint32_t reserved;
+} GnKws_BlockHeader_t;
+
+static GnKwsEngine_t *sGnKwsEngine = NULL;
+static void *sGnRingbuf = NULL;
+static int sGnBytesPerSample = 0;
+static atomic_bool sGnFlushRequested;
+static atomic_bool sGnWorkerWaiting;    // worker is about to wait or waiting on sGnDataCond
+static os_mutex sGnDataMutex = NULL;
+static os_cond sGnDataCond = NULL;
+static char sGnFeedBuf[sizeof(GnKws_BlockHeader_t) + GENIE_KWS_BLOCK_MAX];   // capture side only
+static char sGnDetectBuf[GENIE_KWS_BLOCK_MAX];                               // worker side only
+
+// dropped samples are counted by capture side, the rest by worker, GnKws_getStats reads
+// them from any thread. The engine's own stats are copied here after every block
+static atomic_ullong sGnDroppedSamples;
+static atomic_uint sGnBlocks;
+static atomic_ullong sGnDetectTotalUs;
+static atomic_uint sGnDetectMaxUs;
+static atomic_uint sGnWakeups;
+static atomic_uint sGnTriggers;
+static atomic_uint sGnRejects;
+static atomic_uint sGnVerifyAvgUs;
+static atomic_uint sGnVerifyMaxUs;
+
+static void GnKws_Run_Block(GnKws_BlockHeader_t *header, uint64_t *nextPos)
+{
+    static GenieSdk_Callback_t *sdkCallback = NULL;
+    int samples = header->size/sGnBytesPerSample;
+
+    // gap in sample positions: the recorder owned the mic meanwhile, start from a clean state
+    if (header->samplePos != *nextPos)
+        GnKwsEngine_reset(sGnKwsEngine);
+    *nextPos = header->samplePos + samples;
+
+    unsigned long long start = os_monotonic_usec();
+    double confidence = 0;
+    const GnKws_Keyword_t *keyword = GnKwsEngine_run(sGnKwsEngine, (const int16_t *)sGnDetectBuf, samples, &confidence);
+    unsigned long long now = os_monotonic_usec();
+    unsigned int cost = (unsigned int)(now - start);
+    atomic_fetch_add_explicit(&sGnBlocks, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&sGnDetectTotalUs, cost, memory_order_relaxed);
+    if (cost > atomic_load_explicit(&sGnDetectMaxUs, memory_order_relaxed))
+        atomic_store_explicit(&sGnDetectMaxUs, cost, memory_order_relaxed);
+    GnKwsEngine_Stats_t engineStats;
+    GnKwsEngine_getStats(sGnKwsEngine, &engineStats);
+    atomic_store_explicit(&sGnTriggers, engineStats.triggers, memory_order_relaxed);
+    atomic_store_explicit(&sGnRejects, engineStats.rejects, memory_order_relaxed);
+    atomic_store_explicit(&sGnVerifyAvgUs, engineStats.verifyAvgUs, memory_order_relaxed);
+    atomic_store_explicit(&sGnVerifyMaxUs, engineStats.verifyMaxUs, memory_order_relaxed);
+
+    if (keyword != NULL) {
+        atomic_fetch_add_explicit(&sGnWakeups, 1, memory_order_relaxed);
+        OS_LOGI(TAG, "Hotword detect, onMicphoneWakeup: \"%s\" ends at sample %llu, %llums after capture",
+                keyword->word, (unsigned long long)*nextPos, (now - header->captureUsec)/1000);
+        if (sdkCallback == NULL)
+            GenieSdk_Get_Callback(&sdkCallback);
+        if (sdkCallback != NULL)
+            sdkCallback->onMicphoneWakeup(keyword->word, 0, confidence);
+    }
+}
+
+static void *GnKws_Thread(void *arg)
+{
+    GnKws_BlockHeader_t header;
+    uint64_t nextPos = 0;
+    unsigned long long lastStats = os_monotonic_usec();
+    while (1) {
+        if (atomic_exchange(&sGnFlushRequested, false)) {
+            int filled = lockfree_ringbuf_bytes_filled(sGnRingbuf);
+            if (filled > 0)
+                lockfree_ringbuf_unsafe_discard(sGnRingbuf, filled);
+        }
+        if (lockfree_ringbuf_bytes_filled(sGnRingbuf) < (int)sizeof(header)) {
+            // announce the wait before the last look at the ring, GnKws_feed checks the flag
+            // after its write, so one of the two sees the other
+            os_mutex_lock(sGnDataMutex);
+            atomic_store(&sGnWorkerWaiting, true);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (lockfree_ringbuf_bytes_filled(sGnRingbuf) < (int)sizeof(header))
+                os_cond_wait(sGnDataCond, sGnDataMutex);
+            atomic_store(&sGnWorkerWaiting, false);
+            os_mutex_unlock(sGnDataMutex);
+            continue;
+        }
+        lockfree_ringbuf_read(sGnRingbuf, (char *)&header, sizeof(header));
+        lockfree_ringbuf_read(sGnRingbuf, sGnDetectBuf, header.size);
+        GnKws_Run_Block(&header, &nextPos);
+
+        if (os_monotonic_usec() - lastStats >= GENIE_KWS_STATS_INTERVAL*1000ULL) {
+            GnKws_Stats_t stats;
+            GnKws_getStats(&stats);
+            OS_LOGD(TAG, "Kws stats: blocks=%u, detect avg=%uus max=%uus, triggers=%u, rejects=%u, "
+                    "verify avg=%uus max=%uus, wakeups=%u, dropped=%llu samples",
+                    stats.blocks, stats.detectAvgUs, stats.detectMaxUs, stats.triggers, stats.rejects,
+                    stats.verifyAvgUs, stats.verifyMaxUs, stats.wakeups, stats.droppedSamples);
+            lastStats = os_monotonic_usec();
+        }
+    }
+    return NULL;
+}
+
+bool GnKws_init(int sampleRate, int channelCount, int bitsPerSample)
+{
+    GnKwsEngine_Config_t config = {
+        .audioGain = GENIE_SNOWBOY_AUDIO_GAIN,
+        .verifyWindow = GENIE_KWS_VERIFY_WINDOW,
+        .verifyTail = GENIE_KWS_VERIFY_TAIL,
+    };
+    sGnKwsEngine = GnKwsEngine_create(GENIE_SNOWBOY_RESOURCE_FILE, sGnKeywords,
+                                      sizeof(sGnKeywords)/sizeof(sGnKeywords[0]), &config);
+    if (sGnKwsEngine == NULL) {
+        OS_LOGE(TAG, "GnKwsEngine_create failed");
+        goto __error_init;
+    }
+    if (!GnKwsEngine_matchFormat(sGnKwsEngine, sampleRate, channelCount, bitsPerSample)) {
+        OS_LOGE(TAG, "Record parameters not matched, abort voice trigger");
+        goto __error_init;
+    }
+    sGnBytesPerSample = channelCount*bitsPerSample/8;
+
+    sGnRingbuf = lockfree_ringbuf_create(GENIE_KWS_RINGBUF_SIZE);
+    if (sGnRingbuf == NULL) {
+        OS_LOGE(TAG, "lockfree_ringbuf_create failed");
+        goto __error_init;
+    }
+    atomic_init(&sGnFlushRequested, false);
+    atomic_init(&sGnWorkerWaiting, false);
+    sGnDataMutex = os_mutex_create();
+    sGnDataCond = os_cond_create();
+    if (sGnDataMutex == NULL || sGnDataCond == NULL) {
+        OS_LOGE(TAG, "Failed to create data mutex/cond");
+        goto __error_init;
+    }
+
+    struct os_thread_attr thread_attr = {
+        .name = GENIE_KWS_THREAD_NAME,
+        .priority = GENIE_KWS_THREAD_PRIO,
+        .stacksize = GENIE_KWS_THREAD_STACK,
+        .joinable = false,
+    };
+    if (os_thread_create(&thread_attr, GnKws_Thread, NULL) == NULL) {
+        OS_LOGE(TAG, "os_thread_create failed");
+        goto __error_init;
+    }
+    return true;
+
+__error_init:
+    if (sGnDataCond != NULL) {
+        os_cond_destroy(sGnDataCond);
+        sGnDataCond = NULL;
+    }
+    if (sGnDataMutex != NULL) {
+        os_mutex_destroy(sGnDataMutex);
+        sGnDataMutex = NULL;
+    }
+    if (sGnRingbuf != NULL) {
+        lockfree_ringbuf_destroy(sGnRingbuf);
+        sGnRingbuf = NULL;
+    }
+    GnKwsEngine_destroy(sGnKwsEngine);
+    sGnKwsEngine = NULL;
+    return false;
+}
+
+void GnKws_feed(const void *pcm, unsigned int size, uint64_t samplePos)
+{
+    if (sGnRingbuf == NULL)
+        return;
+    GnKws_BlockHeader_t *header = (GnKws_BlockHeader_t *)sGnFeedBuf;
+    const char *data = (const char *)pcm;
+    unsigned long long now = os_monotonic_usec();
+    bool written = false;
+    while (size > 0) {
+        unsigned int bytes = size > GENIE_KWS_BLOCK_MAX ? GENIE_KWS_BLOCK_MAX : size;
+        header->samplePos = samplePos;
+        header->captureUsec = now;
+        header->size = bytes;
+        header->reserved = 0;
+        memcpy(sGnFeedBuf + sizeof(GnKws_BlockHeader_t), data, bytes);
+        if (lockfree_ringbuf_write(sGnRingbuf, sGnFeedBuf, sizeof(GnKws_BlockHeader_t) + bytes) < 0)
+            atomic_fetch_add_explicit(&sGnDroppedSamples, bytes/sGnBytesPerSample, memory_order_relaxed);
+        else
+            written = true;
+        samplePos += bytes/sGnBytesPerSample;
+        data += bytes;
+        size -= bytes;
+    }
+
+    // wake the worker, the mutex is only taken when it waits and is held by it only around
+    // the wait itself
+    atomic_thread_fence(memory_order_seq_cst);
+    if (written && atomic_load(&sGnWorkerWaiting)) {
+        os_mutex_lock(sGnDataMutex);
+        os_cond_signal(sGnDataCond);
+        os_mutex_unlock(sGnDataMutex);
+    }
+}
+
+void GnKws_flush()
+{
+    atomic_store(&sGnFlushRequested, true);
+}
+
+void GnKws_getStats(GnKws_Stats_t *stats)
+{
+    // each counter is read atomically, the set of them is not a snapshot
+    unsigned int blocks = atomic_load_explicit(&sGnBlocks, memory_order_relaxed);
+    unsigned long long detectTotalUs = atomic_load_explicit(&sGnDetectTotalUs, memory_order_relaxed);
+    stats->blocks = blocks;
+    stats->detectAvgUs = blocks > 0 ? (unsigned int)(detectTotalUs/blocks) : 0;
+    stats->detectMaxUs = atomic_load_explicit(&sGnDetectMaxUs, memory_order_relaxed);
+    stats->triggers = atomic_load_explicit(&sGnTriggers, memory_order_relaxed);
+    stats->rejects = atomic_load_explicit(&sGnRejects, memory_order_relaxed);
+    stats->verifyAvgUs = atomic_load_explicit(&sGnVerifyAvgUs, memory_order_relaxed);
+    stats->verifyMaxUs = atomic_load_explicit(&sGnVerifyMaxUs, memory_order_relaxed);
+    stats->wakeups = atomic_load_explicit(&sGnWakeups, memory_order_relaxed);
+    stats->droppedSamples = atomic_load_explicit(&sGnDroppedSamples, memory_order_relaxed);
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2019-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __TMALLGENIE_KWS_WORKER_H__
+#define __TMALLGENIE_KWS_WORKER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Keyword spotting off the capture path. The capture thread/callback feeds pcm blocks
+// into a lock-free SPSC ring together with their sample position and capture time,
+// the worker thread runs the keyword engine (GenieKwsEngine.h) on them and calls
+// onMicphoneWakeup with the keyword that fired. A cheap first stage runs on every block,
+// the second stage verifies its triggers on the last 1.5s of audio, both on the worker.
+// The worker sleeps on a condition while the ring is empty, feeding wakes it.
+
+typedef struct {
+    unsigned int blocks;              // blocks run through the detector
+    unsigned int detectAvgUs;         // detect time per block
+    unsigned int detectMaxUs;         // includes verification of a trigger
+    unsigned int triggers;            // first stage hits
+    unsigned int rejects;             // triggers the second stage didn't confirm
+    unsigned int verifyAvgUs;         // second stage, per trigger
+    unsigned int verifyMaxUs;
+    unsigned int wakeups;
+    unsigned long long droppedSamples;// ring was full, detector never saw them
+} GnKws_Stats_t;
+
+bool GnKws_init(int sampleRate, int channelCount, int bitsPerSample);
+
+// Called from capture thread/callback only, never waits for the worker: the worker mutex
+// is taken only to wake it when idle. samplePos is the position of the first sample in
+// the capture stream, it keeps counting while recording.
+void GnKws_feed(const void *pcm, unsigned int size, uint64_t samplePos);
+
+// Drop blocks still queued, call when capture stops feeding (recorder started)
+void GnKws_flush();
+
+void GnKws_getStats(GnKws_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TMALLGENIE_KWS_WORKER_H__
@@ -22,11 +22,18 @@
 #include "cutils/log_helper.h"
 #include "cutils/ringbuf.h"
 #include "litevad.h"
+#include "litevad_resampler.h"
 #include "GenieSdk.h"
 #include "GenieVoiceEngine_Alsa.h"
 #if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
-#include "snowboy-detect-c-wrapper.h"
-static SnowboyDetect *sGnSnowboyDetect = NULL;
+#include "GenieKwsWorker.h"
+#endif
+#if defined(GENIE_HAVE_AEC_ENABLED)
+#include "osal/os_time.h"
+#include "GenieAec.h"
+#endif
+#if defined(GENIE_HAVE_DENOISE_ENABLED)
+#include "litevad_denoise.h"
 #endif
 
 #define TAG "GenieVoiceEngnieAlsa"
@@ -42,36 +49,70 @@ static SnowboyDetect *sGnSnowboyDetect = NULL;
 #define GENIE_RECORD_SAMPLE_BIT         16
 #define GENIE_RECORD_CHANNEL_COUNT      1
 #define GENIE_RECORD_RINGBUF_SIZE       8192
-#define GENIE_RECORD_READ_SIZE          1920
+#define GENIE_RECORD_READ_TIME          60   // ms
 #define GENIE_RECORD_READ_TIMEOUT       3000 // ms
 
-//resources/models/snowboy.umdl:
-//    Universal model for the hotword "Snowboy".
-//    Set SetSensitivity to "0.5" and ApplyFrontend to false.
-//resources/models/alexa.umdl:
-//    Universal model for the hotword "Alexa".
-//    Set SetSensitivity to "0.6" and set ApplyFrontend to true.
-//resources/models/jarvis.umdl:
-//    Universal model for the hotword "Jarvis".
-//    It has two different models for the hotword Jarvis,
-//    so you have to use two sensitivites.
-//    Set SetSensitivity to "0.8,0.8" and ApplyFrontend to true.
-//resources/models/computer.umdl:
-//    Universal model for the hotword "Computer".
-//    Set SetSensitivity to "0.6" and ApplyFrontend to true.
-// See https://github.com/Kitt-AI/snowboy#pretrained-universal-models
-#define GENIE_SNOWBOY_RESOURCE_FILE     "common.res"
-#define GENIE_SNOWBOY_MODEL_FILE        "jarvis.umdl"
-#define GENIE_SNOWBOY_SENSIVIVITY       "0.8,0.8"
-#define GENIE_SNOWBOY_AUDIO_GAIN        1.0
-#define GENIE_SNOWBOY_APPLY_FRONTEND    true
+// Noise suppression of capture ahead of VAD and upload, 0-3, see litevad_denoise.h
+#define GENIE_DENOISE_NS_LEVEL          2
+
+// The device is captured at a rate/channel count/format it runs natively and converted
+// to the record settings above by litevad_resampler, instead of alsa plug resampling
+#define GENIE_CAPTURE_CHANNEL_MAX       8
+static const unsigned int sGnCaptureRates[] = { 16000, 48000, 32000, 96000, 44100, 22050, 24000, 8000 };
+static const snd_pcm_format_t sGnCaptureFormats[] = {
+    SND_PCM_FORMAT_S16_LE, SND_PCM_FORMAT_S32_LE, SND_PCM_FORMAT_S24_LE,
+};
 
 static GnLinux_Alsa_t *sGnAlsa = NULL;
 static ringbuf_handle sGnRingbuf = NULL;
 static bool sGnIsRecording = false;
-static char sGnRecordBuf[GENIE_RECORD_READ_SIZE];
+static litevad_resampler_handle_t sGnResampler = NULL;
+static char *sGnCaptureBuf = NULL;
+static size_t sGnCaptureFrames = 0;
+// one read resampled, plus one 10ms block completed by input carried over from the last read
+static char sGnRecordBuf[(GENIE_RECORD_READ_TIME + 10)*GENIE_RECORD_SAMPLE_RATE/1000*GENIE_RECORD_SAMPLE_BIT/8];
 static litevad_handle_t sGnVadHandle = NULL;
 static bool sGnVadActive = false;
+#if defined(GENIE_HAVE_DENOISE_ENABLED)
+static litevad_denoise_handle_t sGnDenoise = NULL;
+#endif
+static uint64_t sGnCapturedSamples = 0; // capture stream position, only touched by capture path
+
+// Buffer of up to 500ms in 4 periods, hwparams has access/format/channels/rate set
+static bool GnLinux_alsaSetup(GnLinux_Alsa_t *alsa, snd_pcm_hw_params_t *hwparams, int channelCount)
+{
+    uint32_t buffer_time, period_time;
+    if (snd_pcm_hw_params_get_buffer_time_max(hwparams, &buffer_time, 0) < 0) {
+        OS_LOGE(TAG, "snd_pcm_hw_params_get_buffer_time_max failed");
+        return false;
+    }
+    if (buffer_time > 500000)
+        buffer_time = 500000;
+    if (snd_pcm_hw_params_set_buffer_time_near(alsa->pcm, hwparams, &buffer_time, 0) < 0) {
+        OS_LOGE(TAG, "snd_pcm_hw_params_set_buffer_time_near failed");
+        return false;
+    }
+    period_time = buffer_time / 4;
+    if (snd_pcm_hw_params_set_period_time_near(alsa->pcm, hwparams, &period_time, 0) < 0) {
+        OS_LOGE(TAG, "snd_pcm_hw_params_set_period_time_near failed");
+        return false;
+    }
+    if (snd_pcm_hw_params(alsa->pcm, hwparams) < 0) {
+        OS_LOGE(TAG, "snd_pcm_hw_params failed");
+        return false;
+    }
+
+    snd_pcm_hw_params_get_period_size(hwparams, &alsa->chunk_size, 0);    
+    snd_pcm_hw_params_get_buffer_size(hwparams, &alsa->buffer_size);
+    if (alsa->chunk_size == alsa->buffer_size) {        
+        OS_LOGE(TAG, "Can't use period equal to buffer size");
+        return false;
+    }
+    alsa->bits_per_sample = snd_pcm_format_physical_width(alsa->format);
+    alsa->bits_per_frame = alsa->bits_per_sample * channelCount;
+    alsa->channel_count = channelCount;
+    return true;
+}
 
 GnLinux_Alsa_t *GnLinux_alsaOpen(snd_pcm_stream_t stream, int sampleRate, int channelCount, int bitsPerSample)
 {
@@ -81,7 +122,6 @@ GnLinux_Alsa_t *GnLinux_alsaOpen(snd_pcm_stream_t stream, int sampleRate, int ch
 
     snd_pcm_hw_params_t *hwparams = NULL;
     uint32_t exact_rate = (uint32_t)sampleRate;
-    uint32_t buffer_time, period_time;
     switch (bitsPerSample) {
     case 16:
         alsa->format = SND_PCM_FORMAT_S16_LE;
@@ -133,35 +173,82 @@ GnLinux_Alsa_t *GnLinux_alsaOpen(snd_pcm_stream_t stream, int sampleRate, int ch
         OS_LOGI(TAG, "%d Hz is not supported by your hardware, using %d Hz instead", 
             sampleRate, exact_rate);
     }
-    if (snd_pcm_hw_params_get_buffer_time_max(hwparams, &buffer_time, 0) < 0) {
-        OS_LOGE(TAG, "snd_pcm_hw_params_get_buffer_time_max failed");
+    if (!GnLinux_alsaSetup(alsa, hwparams, channelCount))
+        goto fail_open;
+    alsa->sample_rate = sampleRate;
+
+    return alsa;
+
+fail_open:
+    if (alsa->pcm != NULL)
+        snd_pcm_close(alsa->pcm);
+    OS_FREE(alsa);
+    return NULL;
+}
+
+// Capture without alsa plug conversions, at the first rate of sGnCaptureRates, format of
+// sGnCaptureFormats and the channel count nearest to mono the device runs natively
+static GnLinux_Alsa_t *GnLinux_alsaOpenCapture()
+{
+    GnLinux_Alsa_t *alsa = (GnLinux_Alsa_t *)OS_CALLOC(1, sizeof(GnLinux_Alsa_t));
+    if (alsa == NULL)
+        return NULL;
+
+    snd_pcm_hw_params_t *hwparams = NULL;
+    unsigned int channels = GENIE_RECORD_CHANNEL_COUNT;
+    unsigned int rate = 0;
+    int i;
+
+    if (snd_pcm_open(&alsa->pcm, GENIE_LINUX_ALSA_DEVICE, SND_PCM_STREAM_CAPTURE,
+            SND_PCM_NO_AUTO_RESAMPLE | SND_PCM_NO_AUTO_CHANNELS | SND_PCM_NO_AUTO_FORMAT) < 0) {
+        OS_LOGE(TAG, "snd_pcm_open failed");
         goto fail_open;
     }
-    if (buffer_time > 500000)
-        buffer_time = 500000;
-    if (snd_pcm_hw_params_set_buffer_time_near(alsa->pcm, hwparams, &buffer_time, 0) < 0) {
-        OS_LOGE(TAG, "snd_pcm_hw_params_set_buffer_time_near failed");
+
+    if (snd_pcm_nonblock(alsa->pcm, 0) < 0) {
+        OS_LOGE(TAG, "snd_pcm_nonblock failed");
         goto fail_open;
     }
-    period_time = buffer_time / 4;
-    if (snd_pcm_hw_params_set_period_time_near(alsa->pcm, hwparams, &period_time, 0) < 0) {
-        OS_LOGE(TAG, "snd_pcm_hw_params_set_period_time_near failed");
+
+    snd_pcm_hw_params_alloca(&hwparams);
+    if (snd_pcm_hw_params_any(alsa->pcm, hwparams) < 0) {
+        OS_LOGE(TAG, "snd_pcm_hw_params_any failed");
         goto fail_open;
     }
-    if (snd_pcm_hw_params(alsa->pcm, hwparams) < 0) {
-        OS_LOGE(TAG, "snd_pcm_hw_params failed");
+    if (snd_pcm_hw_params_set_access(alsa->pcm, hwparams, SND_PCM_ACCESS_RW_INTERLEAVED) < 0) {
+        OS_LOGE(TAG, "snd_pcm_hw_params_set_access failed");
         goto fail_open;
     }
-
-    snd_pcm_hw_params_get_period_size(hwparams, &alsa->chunk_size, 0);    
-    snd_pcm_hw_params_get_buffer_size(hwparams, &alsa->buffer_size);
-    if (alsa->chunk_size == alsa->buffer_size) {        
-        OS_LOGE(TAG, "Can't use period equal to buffer size");
+    alsa->format = SND_PCM_FORMAT_UNKNOWN;
+    for (i = 0; i < sizeof(sGnCaptureFormats)/sizeof(sGnCaptureFormats[0]); i++) {
+        if (snd_pcm_hw_params_test_format(alsa->pcm, hwparams, sGnCaptureFormats[i]) == 0) {
+            alsa->format = sGnCaptureFormats[i];
+            break;
+        }
+    }
+    if (alsa->format == SND_PCM_FORMAT_UNKNOWN ||
+        snd_pcm_hw_params_set_format(alsa->pcm, hwparams, alsa->format) < 0) {
+        OS_LOGE(TAG, "No supported capture format, need S16_LE/S32_LE/S24_LE");
         goto fail_open;
     }
-    alsa->bits_per_sample = snd_pcm_format_physical_width(alsa->format);
-    alsa->bits_per_frame = alsa->bits_per_sample * channelCount;
-    alsa->sample_rate = sampleRate;
+    if (snd_pcm_hw_params_set_channels_near(alsa->pcm, hwparams, &channels) < 0 ||
+        channels > GENIE_CAPTURE_CHANNEL_MAX) {
+        OS_LOGE(TAG, "No supported capture channel count, need 1-%d", GENIE_CAPTURE_CHANNEL_MAX);
+        goto fail_open;
+    }
+    for (i = 0; i < sizeof(sGnCaptureRates)/sizeof(sGnCaptureRates[0]); i++) {
+        if (snd_pcm_hw_params_test_rate(alsa->pcm, hwparams, sGnCaptureRates[i], 0) == 0) {
+            rate = sGnCaptureRates[i];
+            break;
+        }
+    }
+    if (rate == 0 || snd_pcm_hw_params_set_rate(alsa->pcm, hwparams, rate, 0) < 0) {
+        OS_LOGE(TAG, "No supported capture rate");
+        goto fail_open;
+    }
+    if (!GnLinux_alsaSetup(alsa, hwparams, channels))
+        goto fail_open;
+    alsa->sample_rate = rate;
 
     return alsa;
 
@@ -176,8 +263,8 @@ static void *GnVoiceEngine_Thread(void *arg)
 {
     static GenieSdk_Callback_t *sdkCallback = NULL;
     while (1) {
-        size_t frame_count = sizeof(sGnRecordBuf)*8/sGnAlsa->bits_per_frame;
-        unsigned char *data = (unsigned char *)sGnRecordBuf;
+        size_t frame_count = sGnCaptureFrames;
+        unsigned char *data = (unsigned char *)sGnCaptureBuf;
         while (frame_count > 0) {
             ssize_t ret = snd_pcm_readi(sGnAlsa->pcm, data, frame_count);
             if (ret == -EAGAIN || (ret >= 0 && (size_t)ret < frame_count)) {
@@ -198,10 +285,32 @@ static void *GnVoiceEngine_Thread(void *arg)
             }
         }
 
-        if (sGnIsRecording) {
-            litevad_result_t vad_state = litevad_process(sGnVadHandle, sGnRecordBuf, sizeof(sGnRecordBuf));
+        int size = litevad_resampler_process(sGnResampler, sGnCaptureBuf,
+            sGnCaptureFrames*sGnAlsa->bits_per_frame/8, sGnRecordBuf, sizeof(sGnRecordBuf));
+        if (size <= 0)
+            continue;
+#if defined(GENIE_HAVE_AEC_ENABLED)
+        // echo of our own playback out before anyone looks at the capture
+        GnAec_process(sGnRecordBuf, size, os_monotonic_usec());
+#endif
+
+        bool recording = sGnIsRecording;
+#if defined(GENIE_HAVE_DENOISE_ENABLED)
+        // VAD and upload get denoised capture. While idle only the noise estimate is kept
+        // current, KWS is fed the raw capture
+        if (sGnDenoise != NULL) {
+            if (recording)
+                litevad_denoise_process(sGnDenoise, sGnRecordBuf, size);
+            else
+                litevad_denoise_analyze(sGnDenoise, sGnRecordBuf, size);
+        }
+#endif
+        if (recording) {
+            litevad_result_t vad_state = litevad_process_stream(sGnVadHandle, sGnRecordBuf, size, NULL);
             if (sGnVadActive && vad_state == LITEVAD_RESULT_SPEECH_END) {
-                OS_LOGI(TAG, "VAD state changed: speech >> silence, onMicphoneSilence");
+                litevad_eos_info_t eosInfo;
+                litevad_get_eos_info(sGnVadHandle, &eosInfo);
+                OS_LOGI(TAG, "VAD state changed: speech >> silence, onMicphoneSilence, eos timeout %dms", eosInfo.last_eos_silence_time);
                 if (sdkCallback == NULL)
                     GenieSdk_Get_Callback(&sdkCallback);
                 if (sdkCallback != NULL)
@@ -210,32 +319,38 @@ static void *GnVoiceEngine_Thread(void *arg)
             if (!sGnVadActive && vad_state == LITEVAD_RESULT_SPEECH_BEGIN)
                 sGnVadActive = true;
 
-            rb_write(sGnRingbuf, sGnRecordBuf, sizeof(sGnRecordBuf), GENIE_RECORD_READ_TIMEOUT);
+            rb_write(sGnRingbuf, sGnRecordBuf, size, GENIE_RECORD_READ_TIMEOUT);
         }
 #if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
         else {
-            if (sGnSnowboyDetect != NULL &&
-                SnowboyDetectRunDetection(sGnSnowboyDetect,
-                    (const int16_t* const)sGnRecordBuf, sizeof(sGnRecordBuf)/sizeof(short),
-                    false) > 0) {
-                OS_LOGI(TAG, "Hotword detect, onMicphoneWakeup");
-                if (sdkCallback == NULL)
-                    GenieSdk_Get_Callback(&sdkCallback);
-                if (sdkCallback != NULL)
-                    sdkCallback->onMicphoneWakeup("ni hao tian mao", 0, 0.600998834);
-            }
+            GnKws_feed(sGnRecordBuf, size, sGnCapturedSamples);
         }
 #endif
+        sGnCapturedSamples += size*8/GENIE_RECORD_SAMPLE_BIT;
     }
     return NULL;
 }
 
 bool GnVoiceEngine_init()
 {
-    sGnAlsa = GnLinux_alsaOpen(SND_PCM_STREAM_CAPTURE,
-        GENIE_RECORD_SAMPLE_RATE, GENIE_RECORD_CHANNEL_COUNT, GENIE_RECORD_SAMPLE_BIT);
+    sGnAlsa = GnLinux_alsaOpenCapture();
     if (sGnAlsa == NULL) {
-        OS_LOGE(TAG, "GnLinux_alsaOpen failed");
+        OS_LOGE(TAG, "GnLinux_alsaOpenCapture failed");
+        return false;
+    }
+    OS_LOGI(TAG, "Capturing %dHz %dch %s, resampling to %dHz %dch",
+        sGnAlsa->sample_rate, sGnAlsa->channel_count, snd_pcm_format_name(sGnAlsa->format),
+        GENIE_RECORD_SAMPLE_RATE, GENIE_RECORD_CHANNEL_COUNT);
+    sGnResampler = litevad_resampler_create(sGnAlsa->sample_rate, sGnAlsa->channel_count,
+        snd_pcm_format_width(sGnAlsa->format));
+    if (sGnResampler == NULL) {
+        OS_LOGE(TAG, "litevad_resampler_create failed");
+        return false;
+    }
+    sGnCaptureFrames = sGnAlsa->sample_rate/1000*GENIE_RECORD_READ_TIME;
+    sGnCaptureBuf = (char *)OS_MALLOC(sGnCaptureFrames*sGnAlsa->bits_per_frame/8);
+    if (sGnCaptureBuf == NULL) {
+        OS_LOGE(TAG, "OS_MALLOC failed");
         return false;
     }
     sGnRingbuf = rb_create(GENIE_RECORD_RINGBUF_SIZE);
@@ -243,31 +358,35 @@ bool GnVoiceEngine_init()
         OS_LOGE(TAG, "rb_create failed");
         return false;
     }
-    sGnVadHandle = litevad_create(GENIE_RECORD_SAMPLE_RATE, GENIE_RECORD_CHANNEL_COUNT, GENIE_RECORD_SAMPLE_BIT);
+    litevad_config_t vadConfig;
+    litevad_default_config(&vadConfig);
+    vadConfig.eos_adaptive = 1; // end speech on the speaker's own pause length instead of fixed 700ms
+    sGnVadHandle = litevad_create_with_config(GENIE_RECORD_SAMPLE_RATE, GENIE_RECORD_CHANNEL_COUNT, GENIE_RECORD_SAMPLE_BIT, &vadConfig);
     if (sGnVadHandle == NULL) {
         OS_LOGE(TAG, "litevad_create failed");
         return false;
     }
+#if defined(GENIE_HAVE_DENOISE_ENABLED)
+    litevad_denoise_config_t denoiseConfig;
+    litevad_denoise_default_config(&denoiseConfig);
+    denoiseConfig.ns_level = GENIE_DENOISE_NS_LEVEL;
+    sGnDenoise = litevad_denoise_create(GENIE_RECORD_SAMPLE_RATE, &denoiseConfig);
+    if (sGnDenoise == NULL)
+        OS_LOGE(TAG, "litevad_denoise_create failed, noise suppression disabled");
+#endif
+#if defined(GENIE_HAVE_AEC_ENABLED)
+    if (!GnAec_init(GENIE_RECORD_SAMPLE_RATE, GENIE_RECORD_CHANNEL_COUNT, GENIE_RECORD_SAMPLE_BIT))
+        OS_LOGE(TAG, "GnAec_init failed, echo cancellation disabled");
+#endif
+#if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
+    if (!GnKws_init(GENIE_RECORD_SAMPLE_RATE, GENIE_RECORD_CHANNEL_COUNT, GENIE_RECORD_SAMPLE_BIT))
+        OS_LOGE(TAG, "GnKws_init failed, voice trigger disabled");
+#endif
     pthread_t tid;
     if (pthread_create(&tid, NULL, GnVoiceEngine_Thread, NULL) != 0) {
         OS_LOGE(TAG, "pthread_create failed");
         return false;
     }
-
-#if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
-    // Initializes Snowboy detector.
-    sGnSnowboyDetect = SnowboyDetectConstructor(GENIE_SNOWBOY_RESOURCE_FILE, GENIE_SNOWBOY_MODEL_FILE);
-    SnowboyDetectSetSensitivity(sGnSnowboyDetect, GENIE_SNOWBOY_SENSIVIVITY);
-    SnowboyDetectSetAudioGain(sGnSnowboyDetect, GENIE_SNOWBOY_AUDIO_GAIN);
-    SnowboyDetectApplyFrontend(sGnSnowboyDetect, GENIE_SNOWBOY_APPLY_FRONTEND);
-    if (SnowboyDetectSampleRate(sGnSnowboyDetect) != GENIE_RECORD_SAMPLE_RATE ||
-        SnowboyDetectNumChannels(sGnSnowboyDetect) != GENIE_RECORD_CHANNEL_COUNT ||
-        SnowboyDetectBitsPerSample(sGnSnowboyDetect) != GENIE_RECORD_SAMPLE_BIT) {
-        OS_LOGE(TAG, "Record parameters not matched, abort voice trigger");
-        SnowboyDetectDestructor(sGnSnowboyDetect);
-        sGnSnowboyDetect = NULL;
-    }
-#endif
     return true;
 }
 
@@ -283,6 +402,9 @@ bool GnVoiceEngine_recorderStart(int sampleRate, int channelCount, int bitsPerSa
     rb_reset(sGnRingbuf);
     sGnVadActive = false;
     sGnIsRecording = true;
+#if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
+    GnKws_flush();
+#endif
     return true;
 }
 
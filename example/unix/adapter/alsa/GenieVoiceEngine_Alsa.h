@@ -30,6 +30,7 @@ typedef struct {
     snd_pcm_uframes_t buffer_size;
     snd_pcm_format_t format;
     int sample_rate;
+    int channel_count;
     size_t bits_per_sample;
     size_t bits_per_frame;
 } GnLinux_Alsa_t;
@@ -21,12 +21,19 @@
 #include "cutils/log_helper.h"
 #include "cutils/ringbuf.h"
 #include "litevad.h"
+#include "litevad_resampler.h"
 #include "GenieSdk.h"
 #include "portaudio.h"
 #include "GenieVoiceEngine_PortAudio.h"
 #if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
-#include "snowboy-detect-c-wrapper.h"
-static SnowboyDetect *sGnSnowboyDetect = NULL;
+#include "GenieKwsWorker.h"
+#endif
+#if defined(GENIE_HAVE_AEC_ENABLED)
+#include "osal/os_time.h"
+#include "GenieAec.h"
+#endif
+#if defined(GENIE_HAVE_DENOISE_ENABLED)
+#include "litevad_denoise.h"
 #endif
 
 #define TAG "GenieVoiceEngniePortAudio"
@@ -36,45 +43,58 @@ static SnowboyDetect *sGnSnowboyDetect = NULL;
 #define GENIE_RECORD_SAMPLE_BIT         16
 #define GENIE_RECORD_CHANNEL_COUNT      1
 #define GENIE_RECORD_RINGBUF_SIZE       8192
-#define GENIE_RECORD_READ_SIZE          1920
 #define GENIE_RECORD_READ_TIMEOUT       3000 // ms
 
-//resources/models/snowboy.umdl:
-//    Universal model for the hotword "Snowboy".
-//    Set SetSensitivity to "0.5" and ApplyFrontend to false.
-//resources/models/alexa.umdl:
-//    Universal model for the hotword "Alexa".
-//    Set SetSensitivity to "0.6" and set ApplyFrontend to true.
-//resources/models/jarvis.umdl:
-//    Universal model for the hotword "Jarvis".
-//    It has two different models for the hotword Jarvis,
-//    so you have to use two sensitivites.
-//    Set SetSensitivity to "0.8,0.8" and ApplyFrontend to true.
-//resources/models/computer.umdl:
-//    Universal model for the hotword "Computer".
-//    Set SetSensitivity to "0.6" and ApplyFrontend to true.
-// See https://github.com/Kitt-AI/snowboy#pretrained-universal-models
-#define GENIE_SNOWBOY_RESOURCE_FILE     "common.res"
-#define GENIE_SNOWBOY_MODEL_FILE        "jarvis.umdl"
-#define GENIE_SNOWBOY_SENSIVIVITY       "0.8,0.8"
-#define GENIE_SNOWBOY_AUDIO_GAIN        1.0
-#define GENIE_SNOWBOY_APPLY_FRONTEND    true
+// Noise suppression of capture ahead of VAD and upload, 0-3, see litevad_denoise.h
+#define GENIE_DENOISE_NS_LEVEL          2
+
+// The device is captured at its default rate and converted to the record settings above
+// by litevad_resampler, instead of resampling in the host api
+#define GENIE_CAPTURE_BUFFER_TIME       20   // ms
 
 static ringbuf_handle sGnRingbuf = NULL;
+static litevad_resampler_handle_t sGnResampler = NULL;
+static int sGnCaptureSampleRate = GENIE_RECORD_SAMPLE_RATE;
+// one callback resampled, plus one 10ms block completed by input carried over from the last one
+static char sGnRecordBuf[(GENIE_CAPTURE_BUFFER_TIME + 10)*GENIE_RECORD_SAMPLE_RATE/1000*GENIE_RECORD_SAMPLE_BIT/8];
 static bool sGnIsRecording = false;
 static litevad_handle_t sGnVadHandle = NULL;
 static bool sGnVadActive = false;
+#if defined(GENIE_HAVE_DENOISE_ENABLED)
+static litevad_denoise_handle_t sGnDenoise = NULL;
+#endif
+static uint64_t sGnCapturedSamples = 0; // capture stream position, only touched by capture path
 
 static int GnVoiceEngine_inStreamCallback(const void *input, void *output,
     unsigned long frame_count, const PaStreamCallbackTimeInfo *time_info,
     PaStreamCallbackFlags status_flags, void *user_data)
 {
     static GenieSdk_Callback_t *sdkCallback = NULL;
-    unsigned long nbytes = frame_count*GENIE_RECORD_CHANNEL_COUNT*GENIE_RECORD_SAMPLE_BIT/8;
-    if (sGnIsRecording) {
-        litevad_result_t vad_state = litevad_process(sGnVadHandle, input, nbytes);
+    int nbytes = litevad_resampler_process(sGnResampler, input,
+        frame_count*GENIE_RECORD_CHANNEL_COUNT*GENIE_RECORD_SAMPLE_BIT/8, sGnRecordBuf, sizeof(sGnRecordBuf));
+    if (nbytes <= 0)
+        return paContinue;
+#if defined(GENIE_HAVE_AEC_ENABLED)
+    GnAec_process(sGnRecordBuf, nbytes, os_monotonic_usec());
+#endif
+
+    bool recording = sGnIsRecording;
+#if defined(GENIE_HAVE_DENOISE_ENABLED)
+    // VAD and upload get denoised capture. While idle only the noise estimate is kept
+    // current, KWS is fed the raw capture
+    if (sGnDenoise != NULL) {
+        if (recording)
+            litevad_denoise_process(sGnDenoise, sGnRecordBuf, nbytes);
+        else
+            litevad_denoise_analyze(sGnDenoise, sGnRecordBuf, nbytes);
+    }
+#endif
+    if (recording) {
+        litevad_result_t vad_state = litevad_process_stream(sGnVadHandle, sGnRecordBuf, nbytes, NULL);
         if (sGnVadActive && vad_state == LITEVAD_RESULT_SPEECH_END) {
-            OS_LOGI(TAG, "VAD state changed: speech >> silence, onMicphoneSilence");
+            litevad_eos_info_t eosInfo;
+            litevad_get_eos_info(sGnVadHandle, &eosInfo);
+            OS_LOGI(TAG, "VAD state changed: speech >> silence, onMicphoneSilence, eos timeout %dms", eosInfo.last_eos_silence_time);
             if (sdkCallback == NULL)
                 GenieSdk_Get_Callback(&sdkCallback);
             if (sdkCallback != NULL)
@@ -84,23 +104,16 @@ static int GnVoiceEngine_inStreamCallback(const void *input, void *output,
             sGnVadActive = true;
 
         if (rb_bytes_available(sGnRingbuf) >= nbytes)
-            rb_write(sGnRingbuf, (char *)input, nbytes, GENIE_RECORD_READ_TIMEOUT);
+            rb_write(sGnRingbuf, sGnRecordBuf, nbytes, GENIE_RECORD_READ_TIMEOUT);
         else
             OS_LOGW(TAG, "Insufficient available space in ringbuf, discard current frame");
     }
 #if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
     else {
-        if (sGnSnowboyDetect != NULL &&
-            SnowboyDetectRunDetection(sGnSnowboyDetect,
-                (const int16_t* const)input, frame_count, false) > 0) {
-            OS_LOGI(TAG, "Hotword detect, onMicphoneWakeup");
-            if (sdkCallback == NULL)
-                GenieSdk_Get_Callback(&sdkCallback);
-            if (sdkCallback != NULL)
-                sdkCallback->onMicphoneWakeup("ni hao tian mao", 0, 0.600998834);
-        }
+        GnKws_feed(sGnRecordBuf, nbytes, sGnCapturedSamples);
     }
 #endif
+    sGnCapturedSamples += nbytes*8/GENIE_RECORD_SAMPLE_BIT;
     return paContinue;
 }
 
@@ -111,33 +124,36 @@ bool GnVoiceEngine_init()
         OS_LOGE(TAG, "rb_create failed");
         return false;
     }
-    sGnVadHandle = litevad_create(GENIE_RECORD_SAMPLE_RATE, GENIE_RECORD_CHANNEL_COUNT, GENIE_RECORD_SAMPLE_BIT);
+    litevad_config_t vadConfig;
+    litevad_default_config(&vadConfig);
+    vadConfig.eos_adaptive = 1; // end speech on the speaker's own pause length instead of fixed 700ms
+    sGnVadHandle = litevad_create_with_config(GENIE_RECORD_SAMPLE_RATE, GENIE_RECORD_CHANNEL_COUNT, GENIE_RECORD_SAMPLE_BIT, &vadConfig);
     if (sGnVadHandle == NULL) {
         OS_LOGE(TAG, "litevad_create failed");
         return false;
     }
+#if defined(GENIE_HAVE_DENOISE_ENABLED)
+    litevad_denoise_config_t denoiseConfig;
+    litevad_denoise_default_config(&denoiseConfig);
+    denoiseConfig.ns_level = GENIE_DENOISE_NS_LEVEL;
+    sGnDenoise = litevad_denoise_create(GENIE_RECORD_SAMPLE_RATE, &denoiseConfig);
+    if (sGnDenoise == NULL)
+        OS_LOGE(TAG, "litevad_denoise_create failed, noise suppression disabled");
+#endif
 
+#if defined(GENIE_HAVE_AEC_ENABLED)
+    if (!GnAec_init(GENIE_RECORD_SAMPLE_RATE, GENIE_RECORD_CHANNEL_COUNT, GENIE_RECORD_SAMPLE_BIT))
+        OS_LOGE(TAG, "GnAec_init failed, echo cancellation disabled");
+#endif
 #if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
-    // Initializes Snowboy detector.
-    sGnSnowboyDetect = SnowboyDetectConstructor(GENIE_SNOWBOY_RESOURCE_FILE, GENIE_SNOWBOY_MODEL_FILE);
-    SnowboyDetectSetSensitivity(sGnSnowboyDetect, GENIE_SNOWBOY_SENSIVIVITY);
-    SnowboyDetectSetAudioGain(sGnSnowboyDetect, GENIE_SNOWBOY_AUDIO_GAIN);
-    SnowboyDetectApplyFrontend(sGnSnowboyDetect, GENIE_SNOWBOY_APPLY_FRONTEND);
-    if (SnowboyDetectSampleRate(sGnSnowboyDetect) != GENIE_RECORD_SAMPLE_RATE ||
-        SnowboyDetectNumChannels(sGnSnowboyDetect) != GENIE_RECORD_CHANNEL_COUNT ||
-        SnowboyDetectBitsPerSample(sGnSnowboyDetect) != GENIE_RECORD_SAMPLE_BIT) {
-        OS_LOGE(TAG, "Record parameters not matched, abort voice trigger");
-        SnowboyDetectDestructor(sGnSnowboyDetect);
-        sGnSnowboyDetect = NULL;
-    }
+    if (!GnKws_init(GENIE_RECORD_SAMPLE_RATE, GENIE_RECORD_CHANNEL_COUNT, GENIE_RECORD_SAMPLE_BIT))
+        OS_LOGE(TAG, "GnKws_init failed, voice trigger disabled");
 #endif
 
     if (Pa_Initialize() != paNoError) {
         OS_LOGE(TAG, "Pa_Initialize failed");
         return false;
     }
-    unsigned long framesNeed =
-        GENIE_RECORD_READ_SIZE/(GENIE_RECORD_CHANNEL_COUNT*GENIE_RECORD_SAMPLE_BIT/8);
     PaStream *inStream = NULL;
     PaStreamParameters inParameters;
     inParameters.device = Pa_GetDefaultInputDevice();
@@ -159,8 +175,20 @@ bool GnVoiceEngine_init()
     inParameters.suggestedLatency =
             Pa_GetDeviceInfo(inParameters.device)->defaultLowInputLatency;
     inParameters.hostApiSpecificStreamInfo = NULL;
+    sGnCaptureSampleRate = (int)Pa_GetDeviceInfo(inParameters.device)->defaultSampleRate;
+    sGnResampler = litevad_resampler_create(sGnCaptureSampleRate, GENIE_RECORD_CHANNEL_COUNT, GENIE_RECORD_SAMPLE_BIT);
+    if (sGnResampler == NULL) {
+        // rate litevad_resampler can't convert, leave it to the host api
+        sGnCaptureSampleRate = GENIE_RECORD_SAMPLE_RATE;
+        sGnResampler = litevad_resampler_create(sGnCaptureSampleRate, GENIE_RECORD_CHANNEL_COUNT, GENIE_RECORD_SAMPLE_BIT);
+        if (sGnResampler == NULL) {
+            OS_LOGE(TAG, "litevad_resampler_create failed");
+            return false;
+        }
+    }
+    OS_LOGI(TAG, "Capturing %dHz, resampling to %dHz", sGnCaptureSampleRate, GENIE_RECORD_SAMPLE_RATE);
     if (Pa_OpenStream(&inStream, &inParameters, NULL,
-            GENIE_RECORD_SAMPLE_RATE, framesNeed, paFramesPerBufferUnspecified,
+            sGnCaptureSampleRate, sGnCaptureSampleRate/1000*GENIE_CAPTURE_BUFFER_TIME, paNoFlag,
             GnVoiceEngine_inStreamCallback, NULL) != paNoError)
         return false;
     if (Pa_StartStream(inStream) != paNoError)
@@ -180,6 +208,9 @@ bool GnVoiceEngine_recorderStart(int sampleRate, int channelCount, int bitsPerSa
     rb_reset(sGnRingbuf);
     sGnVadActive = false;
     sGnIsRecording = true;
+#if defined(GENIE_HAVE_SNOWBOY_KEYWORD_DETECT_ENABLED)
+    GnKws_flush();
+#endif
     return true;
 }
 
@@ -89,6 +89,12 @@ typedef void (*GenieAsrResultListener)(const char *result);
 
 typedef void (*GenieNluResultListener)(const char *result);
 
+// Pcm written to the speaker, called from the player thread right before pcmOutWrite.
+// stream identifies the player sink, several streams may be playing at the same time.
+// Typically used as the reference signal of an echo canceller, so don't block in it.
+typedef void (*GeniePcmOutListener)(void *stream, const void *buffer, unsigned int size,
+                                    int sampleRate, int channelCount, int bitsPerSample);
+
 bool GenieSdk_Init(GnVendor_Wrapper_t *adapter);
 
 bool GenieSdk_Get_Callback(GenieSdk_Callback_t **callback);
@@ -109,6 +115,10 @@ bool GenieSdk_Register_NluResultListener(GenieNluResultListener listener);
 
 void GenieSdk_Unregister_NluResultListener(GenieNluResultListener listener);
 
+bool GenieSdk_Register_PcmOutListener(GeniePcmOutListener listener);
+
+void GenieSdk_Unregister_PcmOutListener(GeniePcmOutListener listener);
+
 bool GenieSdk_Start();
 
 bool GenieSdk_IsActive();
@@ -129,14 +129,13 @@ static bool GenieSdk_IsGatewayConnected()
     return true;
 }
 
-static void GenieSdk_CommandListener(Genie_Domain_t domain, Genie_Command_t command, const char *payload)
+static void GenieSdk_CommandListener(Genie_Domain_t domain, Genie_Command_t command, const cJSON *payload)
 {
     switch (command) {
     case GENIE_COMMAND_ListenResult: {
-        cJSON *payloadJson = cJSON_Parse(payload);
-        if (payloadJson == NULL) break;
-        cJSON *isLastJson = cJSON_GetObjectItem(payloadJson, "isLast");
-        cJSON *outputTextJson = cJSON_GetObjectItem(payloadJson, "outputText");
+        if (payload == NULL) break;
+        cJSON *isLastJson = cJSON_GetObjectItem(payload, "isLast");
+        cJSON *outputTextJson = cJSON_GetObjectItem(payload, "outputText");
         if (isLastJson != NULL && cJSON_IsTrue(isLastJson) &&
             outputTextJson != NULL && cJSON_IsString(outputTextJson)) {
             sGnSdk.isWaitingNluResult = true;
@@ -151,15 +150,13 @@ static void GenieSdk_CommandListener(Genie_Domain_t domain, Genie_Command_t comm
         } else {
             sGnSdk.isWaitingNluResult = false;
         }
-        cJSON_Delete(payloadJson);
     }
         break;
     case GENIE_COMMAND_Speak: {
         if (sGnSdk.isWaitingNluResult) {
             sGnSdk.isWaitingNluResult = false;
-            cJSON *payloadJson = cJSON_Parse(payload);
-            if (payloadJson == NULL) break;
-            cJSON *textJson = cJSON_GetObjectItem(payloadJson, "text");
+            if (payload == NULL) break;
+            cJSON *textJson = cJSON_GetObjectItem(payload, "text");
             if (textJson != NULL && cJSON_IsString(textJson)) {
                 os_mutex_lock(sGnSdk.lock);
                 struct listnode *item;
@@ -170,22 +167,18 @@ static void GenieSdk_CommandListener(Genie_Domain_t domain, Genie_Command_t comm
                 }
                 os_mutex_unlock(sGnSdk.lock);
             }
-            cJSON_Delete(payloadJson);
         }
     }
         break;
     case GENIE_COMMAND_Volume: {
-        if (sGnSdk.adapter.setSpeakerVolume == NULL)
+        if (sGnSdk.adapter.setSpeakerVolume == NULL || payload == NULL)
             break;
-        cJSON *payloadJson = cJSON_Parse(payload);
-        if (payloadJson == NULL) break;
-        cJSON *volumeValueJson = cJSON_GetObjectItem(payloadJson, "volumeValue");
+        cJSON *volumeValueJson = cJSON_GetObjectItem(payload, "volumeValue");
         if (volumeValueJson != NULL && cJSON_IsNumber(volumeValueJson)) {
             int valumeValue = cJSON_GetNumberValue(volumeValueJson);
             if (sGnSdk.adapter.setSpeakerVolume(valumeValue))
                 sGnSdk.serviceCallback->onSpeakerVolumeChanged(valumeValue);
         }
-        cJSON_Delete(payloadJson);
     }
         break;
     default:
@@ -194,11 +187,17 @@ static void GenieSdk_CommandListener(Genie_Domain_t domain, Genie_Command_t comm
     }
 
     os_mutex_lock(sGnSdk.lock);
-    struct listnode *item;
-    list_for_each(item, &sGnSdk.commandListenerList) {
-        GnSdk_CommandListenerNode_t *node =
-                listnode_to_item(item, GnSdk_CommandListenerNode_t, listnode);
-        node->commandListener(domain, command, payload);
+    if (!list_empty(&sGnSdk.commandListenerList)) {
+        // public listeners take payload string, only print it when someone is listening
+        char *payloadStr = payload != NULL ? cJSON_PrintUnformatted(payload) : NULL;
+        struct listnode *item;
+        list_for_each(item, &sGnSdk.commandListenerList) {
+            GnSdk_CommandListenerNode_t *node =
+                    listnode_to_item(item, GnSdk_CommandListenerNode_t, listnode);
+            node->commandListener(domain, command, payloadStr != NULL ? payloadStr : "{}");
+        }
+        if (payloadStr != NULL)
+            OS_FREE(payloadStr);
     }
     os_mutex_unlock(sGnSdk.lock);
 }
@@ -593,6 +592,24 @@ void GenieSdk_Unregister_NluResultListener(GenieNluResultListener listener)
     os_mutex_unlock(sGnSdk.lock);
 }
 
+bool GenieSdk_Register_PcmOutListener(GeniePcmOutListener listener)
+{
+    if (!sGnInited || listener == NULL) {
+        OS_LOGE(TAG, "Genie Sdk is NOT inited");
+        return false;
+    }
+    return GnPlayer_Register_PcmOutListener(listener);
+}
+
+void GenieSdk_Unregister_PcmOutListener(GeniePcmOutListener listener)
+{
+    if (!sGnInited || listener == NULL) {
+        OS_LOGE(TAG, "Genie Sdk is NOT inited");
+        return;
+    }
+    GnPlayer_Unregister_PcmOutListener(listener);
+}
+
 bool GenieSdk_Start()
 {
     if (!sGnInited) {
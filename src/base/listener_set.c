@@ -0,0 +1,235 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "osal/os_thread.h"
+#include "cutils/log_helper.h"
+#include "cutils/memory_helper.h"
+
+#include "listener_set.h"
+
+#define TAG "listener_set"
+
+#define LISTENER_SET_GRACE_POLL 100 // us, writer sleeps this long while waiting for readers
+#define LISTENER_SET_NEST_MAX   8   // sets a thread can be reading at once, checked in debug builds
+
+#if defined(__STDC_NO_ATOMICS__)
+// IMPORTANT:
+//   IF ATOMIC NOT SUPPORTED, READERS FALL BACK TO THE WRITE LOCK, SO A SLOW
+//   LISTENER BLOCKS OTHER NOTIFICATIONS OF THE SAME SET AGAIN.
+#warning __STDC_NO_ATOMICS__
+#define ATOMIC_DECLARE(type, obj)   type obj
+#define ATOMIC_INIT(obj, val)       obj = val
+#define ATOMIC_LOAD(obj)            obj
+#define ATOMIC_STORE(obj, val)      obj = val
+#define ATOMIC_EXCHANGE(obj, val)   ({ __typeof__(obj) __old = obj; obj = val; __old; })
+#define ATOMIC_FETCH_ADD(obj, val)  obj += val
+#define ATOMIC_FETCH_SUB(obj, val)  obj -= val
+#else
+#include <stdatomic.h>
+#define ATOMIC_DECLARE(type, obj)   _Atomic(type) obj
+#define ATOMIC_INIT(obj, val)       atomic_init(&(obj), val)
+#define ATOMIC_LOAD(obj)            atomic_load(&(obj))
+#define ATOMIC_STORE(obj, val)      atomic_store(&(obj), val)
+#define ATOMIC_EXCHANGE(obj, val)   atomic_exchange(&(obj), val)
+#define ATOMIC_FETCH_ADD(obj, val)  atomic_fetch_add(&(obj), val)
+#define ATOMIC_FETCH_SUB(obj, val)  atomic_fetch_sub(&(obj), val)
+#endif
+
+struct listener_array {
+    int count;
+    listener_fn_t listeners[];
+};
+
+struct listener_set {
+    ATOMIC_DECLARE(struct listener_array *, array); // NULL when empty
+    ATOMIC_DECLARE(int, epoch);
+    ATOMIC_DECLARE(int, readers[2]);                // readers pinned in each epoch
+    os_mutex write_lock;                            // serializes add/remove
+};
+
+#if !defined(NDEBUG)
+// Sets the calling thread is reading, add/remove from a listener would deadlock in
+// listener_set_synchronize() waiting for its own pin
+static __thread struct listener_set *listener_set_reading[LISTENER_SET_NEST_MAX];
+static __thread int listener_set_read_depth = 0;
+
+static bool listener_set_is_reading(struct listener_set *set)
+{
+    for (int i = 0; i < listener_set_read_depth && i < LISTENER_SET_NEST_MAX; i++) {
+        if (listener_set_reading[i] == set)
+            return true;
+    }
+    return false;
+}
+#endif
+
+listener_set_handle_t listener_set_create(void)
+{
+    struct listener_set *set = OS_CALLOC(1, sizeof(struct listener_set));
+    if (set == NULL)
+        return NULL;
+    if ((set->write_lock = os_mutex_create()) == NULL) {
+        OS_FREE(set);
+        return NULL;
+    }
+    ATOMIC_INIT(set->array, NULL);
+    ATOMIC_INIT(set->epoch, 0);
+    ATOMIC_INIT(set->readers[0], 0);
+    ATOMIC_INIT(set->readers[1], 0);
+    return set;
+}
+
+// Wait until no reader can still see the array unpublished before this call.
+// Flip twice so that readers which loaded a stale epoch are covered as well.
+static void listener_set_synchronize(struct listener_set *set)
+{
+#if !defined(__STDC_NO_ATOMICS__)
+    for (int i = 0; i < 2; i++) {
+        int epoch = ATOMIC_LOAD(set->epoch);
+        ATOMIC_STORE(set->epoch, !epoch);
+        while (ATOMIC_LOAD(set->readers[epoch]) > 0)
+            os_thread_sleep_usec(LISTENER_SET_GRACE_POLL);
+    }
+#endif
+}
+
+static void listener_set_publish(struct listener_set *set, struct listener_array *array)
+{
+    struct listener_array *old = ATOMIC_EXCHANGE(set->array, array);
+    if (old != NULL) {
+        listener_set_synchronize(set);
+        OS_FREE(old);
+    }
+}
+
+int listener_set_add(listener_set_handle_t handle, listener_fn_t listener)
+{
+    struct listener_set *set = handle;
+    int ret = 0;
+
+    assert(!listener_set_is_reading(set));
+    os_mutex_lock(set->write_lock);
+    struct listener_array *curr = ATOMIC_LOAD(set->array);
+    int count = curr != NULL ? curr->count : 0;
+    for (int i = 0; i < count; i++) {
+        if (curr->listeners[i] == listener)
+            goto __out;
+    }
+
+    struct listener_array *array =
+            OS_MALLOC(sizeof(struct listener_array) + (count + 1) * sizeof(listener_fn_t));
+    if (array == NULL) {
+        ret = -1;
+        goto __out;
+    }
+    if (count > 0)
+        memcpy(array->listeners, curr->listeners, count * sizeof(listener_fn_t));
+    array->listeners[count] = listener;
+    array->count = count + 1;
+    listener_set_publish(set, array);
+
+__out:
+    os_mutex_unlock(set->write_lock);
+    return ret;
+}
+
+void listener_set_remove(listener_set_handle_t handle, listener_fn_t listener)
+{
+    struct listener_set *set = handle;
+
+    assert(!listener_set_is_reading(set));
+    os_mutex_lock(set->write_lock);
+    struct listener_array *curr = ATOMIC_LOAD(set->array);
+    int count = curr != NULL ? curr->count : 0;
+    int found = -1;
+    for (int i = 0; i < count; i++) {
+        if (curr->listeners[i] == listener) {
+            found = i;
+            break;
+        }
+    }
+    if (found < 0)
+        goto __out;
+
+    struct listener_array *array = NULL;
+    if (count > 1) {
+        array = OS_MALLOC(sizeof(struct listener_array) + (count - 1) * sizeof(listener_fn_t));
+        if (array == NULL) {
+            OS_LOGE(TAG, "Failed to allocate listener array, listener is not removed");
+            goto __out;
+        }
+        memcpy(array->listeners, curr->listeners, found * sizeof(listener_fn_t));
+        memcpy(array->listeners + found, curr->listeners + found + 1,
+               (count - found - 1) * sizeof(listener_fn_t));
+        array->count = count - 1;
+    }
+    listener_set_publish(set, array);
+
+__out:
+    os_mutex_unlock(set->write_lock);
+}
+
+void listener_set_read_begin(listener_set_handle_t handle, listener_set_reader_t *reader)
+{
+    struct listener_set *set = handle;
+#if defined(__STDC_NO_ATOMICS__)
+    os_mutex_lock(set->write_lock);
+    reader->epoch = 0;
+#else
+    // pin first, then load the array: a writer that swapped after our load must wait for us
+    reader->epoch = ATOMIC_LOAD(set->epoch);
+    ATOMIC_FETCH_ADD(set->readers[reader->epoch], 1);
+#endif
+    struct listener_array *array = ATOMIC_LOAD(set->array);
+    reader->count = array != NULL ? array->count : 0;
+    reader->listeners = array != NULL ? array->listeners : NULL;
+#if !defined(NDEBUG)
+    if (listener_set_read_depth < LISTENER_SET_NEST_MAX)
+        listener_set_reading[listener_set_read_depth] = set;
+    listener_set_read_depth++;
+#endif
+}
+
+void listener_set_read_end(listener_set_handle_t handle, listener_set_reader_t *reader)
+{
+    struct listener_set *set = handle;
+#if defined(__STDC_NO_ATOMICS__)
+    os_mutex_unlock(set->write_lock);
+#else
+    ATOMIC_FETCH_SUB(set->readers[reader->epoch], 1);
+#endif
+#if !defined(NDEBUG)
+    listener_set_read_depth--;
+#endif
+    reader->count = 0;
+    reader->listeners = NULL;
+}
+
+void listener_set_destroy(listener_set_handle_t handle)
+{
+    struct listener_set *set = handle;
+    if (set == NULL)
+        return;
+    struct listener_array *array = ATOMIC_LOAD(set->array);
+    if (array != NULL)
+        OS_FREE(array);
+    os_mutex_destroy(set->write_lock);
+    OS_FREE(set);
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __TMALLGENIE_BASE_LISTENER_SET_H__
+#define __TMALLGENIE_BASE_LISTENER_SET_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Set of listener callbacks for the notify hot path.
+//
+// Listeners are kept in an immutable array, add/remove build a new copy and publish it
+// with an atomic pointer swap. Readers never take a lock: they pin the current array
+// with an epoch counter, call listeners, and unpin. The writer frees the old array
+// only after readers of both epochs drained (RCU-style grace period).
+//
+// Add/remove may wait for in-flight notifications, so never call them from a listener
+// of the same set: they would wait for themselves. Debug builds assert on it.
+
+typedef struct listener_set *listener_set_handle_t;
+
+// Generic callback type, cast back to the real prototype before calling
+typedef void (*listener_fn_t)(void);
+
+typedef struct {
+    int count;
+    const listener_fn_t *listeners;
+    int epoch; // private
+} listener_set_reader_t;
+
+listener_set_handle_t listener_set_create(void);
+
+// 0: added or already present, -1: out of memory
+int listener_set_add(listener_set_handle_t handle, listener_fn_t listener);
+
+void listener_set_remove(listener_set_handle_t handle, listener_fn_t listener);
+
+// Pin the current listeners, lock-free and wait-free
+void listener_set_read_begin(listener_set_handle_t handle, listener_set_reader_t *reader);
+
+void listener_set_read_end(listener_set_handle_t handle, listener_set_reader_t *reader);
+
+void listener_set_destroy(listener_set_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TMALLGENIE_BASE_LISTENER_SET_H__ */
@@ -38,11 +38,28 @@
 #define WS_CLIENT_SOCKET_CONN_TIMEOUT 10   // s
 #define WS_CLIENT_SOCKET_RECV_TIMEOUT 20   // ms
 #define WS_CLIENT_SOCKET_PONG_TIMEOUT 3000 // ms
+#define WS_CLIENT_RECV_STATS_INTERVAL 1000 // ms
 //#define WS_CLIENT_SOCKET_DISCONN_IF_PONG_TIMEOUT
 
 #define WS_CLIENT_QUEUE_MESSAGE_MAX   100
 #define WS_CLIENT_QUEUE_RECV_TIMEOUT  20   // ms
 #define WS_CLIENT_QUEUE_SEND_TIMEOUT  0x7fffffff // ms
+// Audio fragments queued longer than this are dropped, the stream is useless
+// when it lags behind, and it would delay control messages in strict mode
+#define WS_CLIENT_AUDIO_LATE_TIMEOUT  1500 // ms
+// Consecutive audio fragments are merged into one frame (one TLS record) when
+// they are queued, and held up to WS_CLIENT_AUDIO_COALESCE_HOLD for more when
+// the uplink is slow. The final fragment is never held.
+#define WS_CLIENT_AUDIO_COALESCE_BYTES 8192
+#define WS_CLIENT_AUDIO_COALESCE_HOLD 90   // ms
+#define WS_CLIENT_UPLINK_SLOW_RTT     200  // ms
+#define WS_CLIENT_UPLINK_SLOW_SEND    10   // ms
+// Text messages are compressed (permessage-deflate) if the gateway accepts it,
+// each direction keeps a sliding window of 1 << bits bytes; 0 to disable
+#define WS_CLIENT_DEFLATE_WINDOW_BITS 11
+// Define it to hold text messages until a fragmented binary message is finished,
+// as RFC6455 requires; by default control messages preempt between fragments
+//#define WS_CLIENT_STRICT_FRAGMENTS
 
 enum {
     WS_CLIENT_CMD_CONNECT,
@@ -63,10 +80,18 @@ typedef struct {
 typedef struct {
     struct listnode listnode;
     int what;
+    ws_lane_t lane;
+    unsigned long long enqueue_time; // ms
     // @xfer must be the last member of ws_msg_t
     ws_xfer_t xfer;
 } ws_msg_t;
 
+typedef struct {
+    struct listnode list;
+    ws_lane_stats_t stats;
+    unsigned long long wait_total;
+} ws_lane_queue_t;
+
 typedef struct ws_client {
     noPollCtx *ctx;
     noPollConn *conn;
@@ -77,11 +102,24 @@ typedef struct ws_client {
     unsigned long long active_time;
     int ping_interval;
     bool pong_recv;
+    unsigned long long ping_time;
+    int rtt;          // ms, measured by ping/pong
+    int send_cost;    // ms, average time spent in sending an audio frame
+    long utterance_writes;
+    long utterance_frames;
     char *prev_text;
     int prev_text_size;
     int prev_recv_type;
 
-    struct listnode msg_list;
+    // receive stats of the last interval, to see how many frames each read carries
+    unsigned long long stats_time;
+    long stats_reads;
+    long stats_frames;
+    long stats_views;
+    long stats_bytes;
+
+    ws_lane_queue_t lanes[WS_LANE_MAX];
+    bool fragment_open; // fragmented binary message started but not finished
     os_mutex lock;
     os_cond cond;
     os_thread thread;
@@ -180,24 +218,52 @@ current_msg:
     case NOPOLL_PONG_FRAME:
         OS_LOGD(TAG, "Recv pong");
         client->pong_recv = true;
+        if (client->ping_time > 0) {
+            client->rtt = (int)(os_monotonic_usec() / 1000 - client->ping_time);
+            client->ping_time = 0;
+        }
         break;
     default:
         break;
     }
 }
 
+static void ws_nopoll_free_ctx(ws_client_t *client)
+{
+    if (client->conn_opts != NULL) {
+        nopoll_conn_opts_free(client->conn_opts);
+        client->conn_opts = NULL;
+    }
+    if (client->ctx != NULL) {
+        nopoll_ctx_unref(client->ctx);
+        client->ctx = NULL;
+    }
+}
+
 static int ws_nopoll_open_conn(ws_client_t *client)
 {
-    client->ctx = nopoll_ctx_new();
+    unsigned long long start_time = os_monotonic_usec() / 1000;
+    bool new_opts = false;
+
+    // The ctx and conn opts outlive the connection, so reconnecting reuses
+    // the parsed CA and resumes the last TLS session instead of a full handshake
     if (client->ctx == NULL) {
-        OS_LOGE(TAG, "Failed to nopoll_ctx_new");
-        goto __err_exit;
+        client->ctx = nopoll_ctx_new();
+        if (client->ctx == NULL) {
+            OS_LOGE(TAG, "Failed to nopoll_ctx_new");
+            goto __err_exit;
+        }
     }
 
-    client->conn_opts = nopoll_conn_opts_new();
     if (client->conn_opts == NULL) {
-        OS_LOGE(TAG, "Failed to nopoll_conn_opts_new");
-        goto __err_exit;
+        client->conn_opts = nopoll_conn_opts_new();
+        if (client->conn_opts == NULL) {
+            OS_LOGE(TAG, "Failed to nopoll_conn_opts_new");
+            goto __err_exit;
+        }
+        nopoll_conn_opts_set_reuse(client->conn_opts, nopoll_true);
+        nopoll_conn_opts_set_permessage_deflate(client->conn_opts, WS_CLIENT_DEFLATE_WINDOW_BITS);
+        new_opts = true;
     }
 
 #if defined(NOPOLL_HAVE_LIBRARY_DEBUG_ENABLED)
@@ -225,22 +291,25 @@ static int ws_nopoll_open_conn(ws_client_t *client)
                     client->user_info.host,
                     NULL, NULL, NULL);
     } else {
+        ret = nopoll_true;
 #if defined(NOPOLL_HAVE_MBEDTLS_ENABLED)
-        ret = nopoll_conn_opts_set_ssl_certs(client->conn_opts,
-                NULL, 0,
-                NULL, 0,
-                NULL, 0,
-                client->user_info.cacert, strlen(client->user_info.cacert)+1);
+        if (new_opts)
+            ret = nopoll_conn_opts_set_ssl_certs(client->conn_opts,
+                    NULL, 0,
+                    NULL, 0,
+                    NULL, 0,
+                    client->user_info.cacert, strlen(client->user_info.cacert)+1);
 #else
         if (access(client->user_info.cacert, R_OK) != 0) {
             OS_LOGE(TAG, "Failed to access ca: %s", client->user_info.cacert);
             goto __err_exit;
         }
-        ret = nopoll_conn_opts_set_ssl_certs(client->conn_opts,
-                NULL,
-                NULL,
-                NULL,
-                client->user_info.cacert);
+        if (new_opts)
+            ret = nopoll_conn_opts_set_ssl_certs(client->conn_opts,
+                    NULL,
+                    NULL,
+                    NULL,
+                    client->user_info.cacert);
 #endif
         if (ret != nopoll_true) {
             OS_LOGE(TAG, "Failed to nopoll_conn_opts_set_ssl_certs: %s", client->user_info.cacert);
@@ -269,7 +338,12 @@ static int ws_nopoll_open_conn(ws_client_t *client)
 
     client->active_time = os_monotonic_usec() / 1000;
     client->pong_recv = false;
+    client->stats_time = client->active_time;
+    client->stats_reads = client->stats_frames = client->stats_views = client->stats_bytes = 0;
+    client->ping_time = 0;
+    client->rtt = client->send_cost = 0;
     client->conn_state = WS_CONN_STATE_CONNECTED;
+    OS_LOGI(TAG, "Connected in %llums", client->active_time - start_time);
     if (client->user_info.callback.on_connected != NULL)
         client->user_info.callback.on_connected();
     return 0;
@@ -279,26 +353,25 @@ __err_exit:
         nopoll_conn_close(client->conn);
         client->conn = NULL;
     }
-    if (client->conn_opts != NULL) {
-        nopoll_conn_opts_free(client->conn_opts);
-        client->conn_opts = NULL;
-    }
-    if (client->ctx != NULL) {
-        nopoll_ctx_unref(client->ctx);
-        client->ctx = NULL;
-    }
     client->conn_state = WS_CONN_STATE_DISCONNECTED;
+    OS_LOGE(TAG, "Failed to connect after %llums", os_monotonic_usec() / 1000 - start_time);
+    // Report the failed attempt so the owner can schedule the next retry
+    if (client->user_info.callback.on_disconnected != NULL)
+        client->user_info.callback.on_disconnected();
     return -1;
 }
 
 static void ws_nopoll_close_conn(ws_client_t *client)
 {
+    long sent_raw, sent_wire, recv_raw, recv_wire;
+    if (nopoll_conn_get_deflate_stats(client->conn, &sent_raw, &sent_wire, &recv_raw, &recv_wire))
+        OS_LOGI(TAG, "Deflate: sent %ld -> %ld bytes, received %ld <- %ld bytes",
+                sent_raw, sent_wire, recv_raw, recv_wire);
+
     nopoll_conn_close(client->conn);
-    nopoll_conn_opts_free(client->conn_opts);
-    nopoll_ctx_unref(client->ctx);
     client->conn = NULL;
-    client->conn_opts = NULL;
-    client->ctx = NULL;
+    // Nothing left for this thread, leave now so the reconnect needn't wait for the join
+    client->thread_exit = true;
 
     client->conn_state = WS_CONN_STATE_DISCONNECTED;
     if (client->user_info.callback.on_disconnected != NULL)
@@ -343,6 +416,8 @@ static void ws_nopoll_send_binary(ws_client_t *client, ws_xfer_t *xfer)
 
     OS_LOGD(TAG, "Send binary: type=%d, data=%p, len=%d", xfer->type, content, xfer->len);
     client->active_time = os_monotonic_usec() / 1000;
+    if (xfer->type == WS_BINARY_FRAGMENT_START)
+        nopoll_conn_get_send_stats(client->conn, &client->utterance_writes, &client->utterance_frames, NULL);
     switch (xfer->type) {
     case WS_BINARY_FRAGMENT_START:
         ret = nopoll_conn_send_frame(client->conn, nopoll_false, nopoll_true,
@@ -368,10 +443,37 @@ static void ws_nopoll_send_binary(ws_client_t *client, ws_xfer_t *xfer)
             OS_LOGW(TAG, "Send binary: fewer bytes than expected (%d < %d)", ret, xfer->len);
     }
 
+    // average cost of sending, including pending write retries, tells if uplink is congested
+    int cost = (int)(os_monotonic_usec() / 1000 - client->active_time);
+    client->send_cost += (cost - client->send_cost) / 4;
+
     if (xfer->unique_data != NULL)
         OS_FREE(xfer->unique_data);
 }
 
+static void ws_nopoll_report_recv_stats(ws_client_t *client)
+{
+    unsigned long long now_time = os_monotonic_usec() / 1000;
+    long elapsed = (long)(now_time - client->stats_time);
+    if (elapsed < WS_CLIENT_RECV_STATS_INTERVAL)
+        return;
+
+    long reads = 0, frames = 0, views = 0, bytes = 0;
+    nopoll_conn_get_recv_stats(client->conn, &reads, &frames, &views, &bytes);
+    if (frames > client->stats_frames) {
+        OS_LOGI(TAG, "Recv: %ld reads/s, %ld frames/s, %ld views/s, %ld bytes/s",
+                (reads - client->stats_reads) * 1000 / elapsed,
+                (frames - client->stats_frames) * 1000 / elapsed,
+                (views - client->stats_views) * 1000 / elapsed,
+                (bytes - client->stats_bytes) * 1000 / elapsed);
+    }
+    client->stats_time = now_time;
+    client->stats_reads = reads;
+    client->stats_frames = frames;
+    client->stats_views = views;
+    client->stats_bytes = bytes;
+}
+
 static int ws_nopoll_try_get_msg(ws_client_t *client)
 {
     if (!nopoll_conn_is_ok(client->conn)) {
@@ -382,14 +484,25 @@ static int ws_nopoll_try_get_msg(ws_client_t *client)
         return -1;
     }
 
-    noPollMsg *msg = nopoll_conn_get_msg(client->conn);
-    if (msg == NULL)
+    // Frames left in the read-ahead buffer (or a decrypted TLS record) are not reported
+    // by the socket, take all of them now instead of one per thread loop
+    int received = 0, pending;
+    noPollMsg *msg;
+    do {
+        pending = nopoll_conn_recv_pending(client->conn);
+        msg = nopoll_conn_get_msg(client->conn);
+        if (msg == NULL)
+            continue;
+        client->active_time = os_monotonic_usec() / 1000;
+        ws_nopoll_handle_message(client, msg);
+        nopoll_msg_unref(msg);
+        received++;
+    } while (nopoll_conn_is_ok(client->conn) && nopoll_conn_recv_pending(client->conn) > 0 &&
+             (msg != NULL || nopoll_conn_recv_pending(client->conn) != pending));
+
+    if (received == 0)
         return -1;
-    client->active_time = os_monotonic_usec() / 1000;
-
-    ws_nopoll_handle_message(client, msg);
-
-    nopoll_msg_unref(msg);
+    ws_nopoll_report_recv_stats(client);
     return 0;
 }
 
@@ -409,20 +522,215 @@ static int ws_nopoll_try_ping(ws_client_t *client)
 
     OS_LOGD(TAG, "Send ping");
     client->active_time = now_time;
+    client->ping_time = now_time;
     nopoll_conn_send_ping(client->conn);
     return 0;
 }
 
+static void ws_client_free_msg(ws_msg_t *msg)
+{
+    if (msg->xfer.unique_data != NULL)
+        OS_FREE(msg->xfer.unique_data);
+    OS_FREE(msg);
+}
+
 static void ws_client_clear_msglist(ws_client_t *client)
 {
     struct listnode *item, *tmp;
-    list_for_each_safe(item, tmp, &client->msg_list) {
+    for (int i = 0; i < WS_LANE_MAX; i++) {
+        list_for_each_safe(item, tmp, &client->lanes[i].list) {
+            ws_msg_t *msg = listnode_to_item(item, ws_msg_t, listnode);
+            list_remove(item);
+            ws_client_free_msg(msg);
+        }
+        client->lanes[i].stats.depth = 0;
+    }
+    client->fragment_open = false;
+}
+
+static void ws_client_reset_lane_stats(ws_client_t *client)
+{
+    for (int i = 0; i < WS_LANE_MAX; i++) {
+        int depth = client->lanes[i].stats.depth;
+        memset(&client->lanes[i].stats, 0, sizeof(ws_lane_stats_t));
+        client->lanes[i].stats.depth = depth;
+        client->lanes[i].stats.depth_max = depth;
+        client->lanes[i].wait_total = 0;
+    }
+}
+
+static bool ws_client_lanes_empty(ws_client_t *client)
+{
+    for (int i = 0; i < WS_LANE_MAX; i++) {
+        if (!list_empty(&client->lanes[i].list))
+            return false;
+    }
+    return true;
+}
+
+static void ws_client_drop_msg(ws_client_t *client, ws_msg_t *msg)
+{
+    ws_lane_queue_t *queue = &client->lanes[msg->lane];
+    list_remove(&msg->listnode);
+    queue->stats.depth--;
+    queue->stats.dropped++;
+    ws_client_free_msg(msg);
+}
+
+// Called with client->lock held
+static void ws_client_enqueue(ws_client_t *client, ws_msg_t *msg)
+{
+    if (msg->what == WS_CLIENT_CMD_SEND_BINARY)
+        msg->lane = msg->xfer.type == WS_BINARY_WHOLE ? WS_LANE_BULK : WS_LANE_AUDIO;
+    else
+        msg->lane = WS_LANE_CONTROL;
+    msg->enqueue_time = os_monotonic_usec() / 1000;
+
+    ws_lane_queue_t *queue = &client->lanes[msg->lane];
+    if (msg->lane == WS_LANE_AUDIO && queue->stats.depth >= WS_CLIENT_QUEUE_MESSAGE_MAX) {
+        // uplink can't keep up, drop the oldest continue fragment
+        struct listnode *item;
+        list_for_each(item, &queue->list) {
+            ws_msg_t *old = listnode_to_item(item, ws_msg_t, listnode);
+            if (old->xfer.type == WS_BINARY_FRAGMENT_CONTINUE) {
+                ws_client_drop_msg(client, old);
+                break;
+            }
+        }
+    }
+
+    list_add_tail(&queue->list, &msg->listnode);
+    queue->stats.depth++;
+    if (queue->stats.depth > queue->stats.depth_max)
+        queue->stats.depth_max = queue->stats.depth;
+    os_cond_signal(client->cond);
+}
+
+static ws_msg_t *ws_client_lane_front(ws_client_t *client, ws_lane_t lane)
+{
+    if (list_empty(&client->lanes[lane].list))
+        return NULL;
+    return listnode_to_item(list_head(&client->lanes[lane].list), ws_msg_t, listnode);
+}
+
+static void ws_client_take_msg(ws_client_t *client, ws_msg_t *msg, unsigned long long now)
+{
+    ws_lane_queue_t *queue = &client->lanes[msg->lane];
+    unsigned int wait = (unsigned int)(now - msg->enqueue_time);
+    list_remove(&msg->listnode);
+    queue->stats.depth--;
+    queue->stats.sent++;
+    queue->wait_total += wait;
+    queue->stats.wait_avg = (unsigned int)(queue->wait_total / queue->stats.sent);
+    if (wait > queue->stats.wait_max)
+        queue->stats.wait_max = wait;
+}
+
+// Merge the continue fragments queued from @front (and the finish one if queued) into
+// one message, returns NULL if holding @front for more fragments to come
+static ws_msg_t *ws_client_coalesce_audio(ws_client_t *client, ws_msg_t *front, unsigned long long now)
+{
+    struct listnode *head = &client->lanes[WS_LANE_AUDIO].list;
+    struct listnode *item;
+    bool finish = false;
+    int count = 0, size = 0;
+
+    list_for_each(item, head) {
         ws_msg_t *msg = listnode_to_item(item, ws_msg_t, listnode);
-        list_remove(item);
-        if (msg->xfer.unique_data != NULL)
-            OS_FREE(msg->xfer.unique_data);
-        OS_FREE(msg);
+        if (msg->xfer.type != WS_BINARY_FRAGMENT_CONTINUE && msg->xfer.type != WS_BINARY_FRAGMENT_FINISH)
+            break;
+        if (count > 0 && size + msg->xfer.len > WS_CLIENT_AUDIO_COALESCE_BYTES)
+            break;
+        size += msg->xfer.len;
+        count++;
+        if (msg->xfer.type == WS_BINARY_FRAGMENT_FINISH) {
+            finish = true;
+            break;
+        }
     }
+
+    bool slow = client->rtt > WS_CLIENT_UPLINK_SLOW_RTT || client->send_cost > WS_CLIENT_UPLINK_SLOW_SEND;
+    if (slow && !finish && size < WS_CLIENT_AUDIO_COALESCE_BYTES &&
+        now - front->enqueue_time < WS_CLIENT_AUDIO_COALESCE_HOLD)
+        return NULL;
+
+    ws_msg_t *merged = count > 1 ? OS_MALLOC(sizeof(ws_msg_t) + size + sizeof(long)) : NULL;
+    if (merged == NULL) {
+        ws_client_take_msg(client, front, now);
+        return front;
+    }
+
+    memset(merged, 0, sizeof(ws_msg_t));
+    merged->what = WS_CLIENT_CMD_SEND_BINARY;
+    merged->lane = WS_LANE_AUDIO;
+    merged->enqueue_time = front->enqueue_time;
+    merged->xfer.type = finish ? WS_BINARY_FRAGMENT_FINISH : WS_BINARY_FRAGMENT_CONTINUE;
+    merged->xfer.len = size;
+    for (int i = 0, offset = 0; i < count; i++) {
+        ws_msg_t *msg = listnode_to_item(list_head(head), ws_msg_t, listnode);
+        char *content = msg->xfer.unique_data != NULL ? msg->xfer.unique_data : msg->xfer.data;
+        ws_client_take_msg(client, msg, now);
+        memcpy(merged->xfer.data + offset, content, msg->xfer.len);
+        offset += msg->xfer.len;
+        ws_client_free_msg(msg);
+    }
+    client->lanes[WS_LANE_AUDIO].stats.coalesced += count - 1;
+    return merged;
+}
+
+// Called with client->lock held, returns the next message to handle, or NULL if
+// nothing can be sent now (e.g. bulk message waiting for voice stream finished)
+static ws_msg_t *ws_client_dequeue(ws_client_t *client)
+{
+    unsigned long long now = os_monotonic_usec() / 1000;
+    ws_msg_t *msg;
+
+    // drop late audio fragments, never the start/finish ones that frame the stream
+    while ((msg = ws_client_lane_front(client, WS_LANE_AUDIO)) != NULL &&
+           msg->xfer.type == WS_BINARY_FRAGMENT_CONTINUE &&
+           now - msg->enqueue_time > WS_CLIENT_AUDIO_LATE_TIMEOUT)
+        ws_client_drop_msg(client, msg);
+
+    msg = ws_client_lane_front(client, WS_LANE_CONTROL);
+#if defined(WS_CLIENT_STRICT_FRAGMENTS)
+    if (msg != NULL && msg->what == WS_CLIENT_CMD_SEND_TEXT && client->fragment_open)
+        msg = NULL;
+#endif
+    if (msg == NULL)
+        msg = ws_client_lane_front(client, WS_LANE_AUDIO);
+    if (msg == NULL && !client->fragment_open)
+        msg = ws_client_lane_front(client, WS_LANE_BULK);
+    if (msg == NULL)
+        return NULL;
+
+    if (msg->lane == WS_LANE_AUDIO && msg->xfer.type == WS_BINARY_FRAGMENT_CONTINUE)
+        msg = ws_client_coalesce_audio(client, msg, now);
+    else
+        ws_client_take_msg(client, msg, now);
+    if (msg == NULL)
+        return NULL;
+
+    if (msg->what == WS_CLIENT_CMD_SEND_BINARY) {
+        if (msg->xfer.type == WS_BINARY_FRAGMENT_START)
+            client->fragment_open = true;
+        else if (msg->xfer.type == WS_BINARY_FRAGMENT_FINISH)
+            client->fragment_open = false;
+    }
+    return msg;
+}
+
+static void ws_client_report_lane_stats(ws_client_t *client)
+{
+    ws_lane_stats_t *control = &client->lanes[WS_LANE_CONTROL].stats;
+    ws_lane_stats_t *audio = &client->lanes[WS_LANE_AUDIO].stats;
+    long writes = 0, frames = 0;
+    nopoll_conn_get_send_stats(client->conn, &writes, &frames, NULL);
+    OS_LOGI(TAG, "Uplink: audio sent=%u, coalesced=%u, dropped=%u, wait=%u/%ums, depth=%d, control wait=%u/%ums",
+            audio->sent, audio->coalesced, audio->dropped, audio->wait_avg, audio->wait_max, audio->depth_max,
+            control->wait_avg, control->wait_max);
+    OS_LOGI(TAG, "Utterance: %ld frames, %ld writes (TLS records), rtt=%dms, send cost=%dms",
+            frames - client->utterance_frames, writes - client->utterance_writes,
+            client->rtt, client->send_cost);
 }
 
 static void ws_client_clear_msglist_l(ws_client_t *client)
@@ -438,26 +746,26 @@ static void *ws_client_thread_entry(void *arg)
     bool ping_sent_flag = false;
     int ping_check_time = 0;
     int ping_escape_time = 0;
+    bool recv_active = false;
     ws_msg_t *msg = NULL;
 
     OS_LOGV(TAG, "websocket thread enter");
 
     while (!client->thread_exit) {
         os_mutex_lock(client->lock);
-        if (list_empty(&client->msg_list))
+        // while messages keep arriving poll the socket again right away
+        if (!recv_active && ws_client_lanes_empty(client))
             os_cond_timedwait(client->cond, client->lock, WS_CLIENT_QUEUE_RECV_TIMEOUT*1000);
-        if (!list_empty(&client->msg_list)) {
-            struct listnode *front = list_head(&client->msg_list);
-            msg = listnode_to_item(front, ws_msg_t, listnode);
-            list_remove(front);
-        }
+        msg = ws_client_dequeue(client);
         os_mutex_unlock(client->lock);
 
         if (msg == NULL) {
-            if (ws_nopoll_try_get_msg(client) != 0)
+            recv_active = ws_nopoll_try_get_msg(client) == 0;
+            if (!recv_active)
                 os_thread_sleep_msec(WS_CLIENT_SOCKET_RECV_TIMEOUT);
 
-            if (client->ping_interval > 0) {
+            // the counters below assume an idle loop takes the two timeouts
+            if (client->ping_interval > 0 && !recv_active) {
                 ping_check_time += (WS_CLIENT_SOCKET_RECV_TIMEOUT+WS_CLIENT_QUEUE_RECV_TIMEOUT)*2;
                 if (ping_check_time > client->ping_interval) {
                     if (ws_nopoll_try_ping(client) == 0) {
@@ -507,6 +815,8 @@ static void *ws_client_thread_entry(void *arg)
                 ws_nopoll_send_binary(client, &msg->xfer);
             else
                 OS_LOGE(TAG, "WS_CLIENT_CMD_SEND_BINARY: websocket not connected");
+            if (msg->xfer.type == WS_BINARY_FRAGMENT_FINISH)
+                ws_client_report_lane_stats(client);
             break;
         case WS_CLIENT_CMD_DISCONNECT:
             if (client->conn_state == WS_CONN_STATE_CONNECTED)
@@ -547,7 +857,8 @@ ws_client_handle_t ws_client_create()
     if ((client->cond = os_cond_create()) == NULL)
         goto __error_exit;
 
-    list_init(&client->msg_list);
+    for (int i = 0; i < WS_LANE_MAX; i++)
+        list_init(&client->lanes[i].list);
     client->conn_state = WS_CONN_STATE_DISCONNECTED;
     return client;
 
@@ -579,6 +890,13 @@ int ws_client_connect(ws_client_handle_t handle, ws_user_info_t *info)
         os_thread_join(handle->thread, NULL);
     }
 
+    // The kept TLS session and CA belong to the previous server
+    if (handle->user_info.host == NULL || strcmp(handle->user_info.host, info->host) != 0 ||
+        handle->user_info.port != info->port ||
+        (handle->user_info.cacert == NULL) != (info->cacert == NULL) ||
+        (info->cacert != NULL && strcmp(handle->user_info.cacert, info->cacert) != 0))
+        ws_nopoll_free_ctx(handle);
+
     struct os_thread_attr attr;
     attr.name = "websocket";
     attr.priority = WS_CLIENT_TASK_PRIORITY;
@@ -639,8 +957,8 @@ int ws_client_connect(ws_client_handle_t handle, ws_user_info_t *info)
 
     os_mutex_lock(handle->lock);
     ws_client_clear_msglist(handle);
-    list_add_tail(&handle->msg_list, &msg->listnode);
-    os_cond_signal(handle->cond);
+    ws_client_reset_lane_stats(handle);
+    ws_client_enqueue(handle, msg);
     os_mutex_unlock(handle->lock);
     return 0;
 
@@ -703,8 +1021,7 @@ int ws_client_send_text(ws_client_handle_t handle, char *data, int len)
     memcpy(msg->xfer.data, data, msg->xfer.len);
 
     os_mutex_lock(handle->lock);
-    list_add_tail(&handle->msg_list, &msg->listnode);
-    os_cond_signal(handle->cond);
+    ws_client_enqueue(handle, msg);
     os_mutex_unlock(handle->lock);
     return 0;
 }
@@ -728,8 +1045,7 @@ int ws_client_send_text_unique(ws_client_handle_t handle, char *unique_data, int
     msg->xfer.unique_data = unique_data;
 
     os_mutex_lock(handle->lock);
-    list_add_tail(&handle->msg_list, &msg->listnode);
-    os_cond_signal(handle->cond);
+    ws_client_enqueue(handle, msg);
     os_mutex_unlock(handle->lock);
     return 0;
 }
@@ -754,8 +1070,7 @@ int ws_client_send_binary(ws_client_handle_t handle, char *data, int len, ws_bin
         memcpy(msg->xfer.data, data, msg->xfer.len);
 
     os_mutex_lock(handle->lock);
-    list_add_tail(&handle->msg_list, &msg->listnode);
-    os_cond_signal(handle->cond);
+    ws_client_enqueue(handle, msg);
     os_mutex_unlock(handle->lock);
     return 0;
 }
@@ -780,8 +1095,17 @@ int ws_client_send_binary_unique(ws_client_handle_t handle, char *unique_data, i
     msg->xfer.unique_data = unique_data;
 
     os_mutex_lock(handle->lock);
-    list_add_tail(&handle->msg_list, &msg->listnode);
-    os_cond_signal(handle->cond);
+    ws_client_enqueue(handle, msg);
+    os_mutex_unlock(handle->lock);
+    return 0;
+}
+
+int ws_client_get_lane_stats(ws_client_handle_t handle, ws_lane_t lane, ws_lane_stats_t *stats)
+{
+    if (handle == NULL || lane < 0 || lane >= WS_LANE_MAX || stats == NULL)
+        return -1;
+    os_mutex_lock(handle->lock);
+    memcpy(stats, &handle->lanes[lane].stats, sizeof(ws_lane_stats_t));
     os_mutex_unlock(handle->lock);
     return 0;
 }
@@ -799,6 +1123,7 @@ void ws_client_disconnect(ws_client_handle_t handle)
         os_thread_join(handle->thread, NULL);
         handle->thread = NULL;
     }
+    ws_nopoll_free_ctx(handle);
 
     if (handle->prev_text != NULL) {
         OS_FREE(handle->prev_text);
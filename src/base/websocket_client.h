@@ -30,7 +30,7 @@ typedef enum {
 
 typedef struct {
     void (*on_connected)();
-    void (*on_disconnected)();
+    void (*on_disconnected)(); // also called when a connect attempt fails
     void (*on_received_text)(char *text, int size);
     void (*on_received_binary)(char *data, int size, ws_binary_type_t type);
 } ws_callback_t;
@@ -43,6 +43,26 @@ typedef struct {
     ws_callback_t callback;
 } ws_user_info_t;
 
+// Outbound messages are scheduled by lane: text goes to control lane, fragmented
+// binary (voice stream) to audio lane, and whole binary to bulk lane. Control lane
+// is served first, late audio fragments are dropped rather than delaying others.
+typedef enum {
+    WS_LANE_CONTROL = 0,
+    WS_LANE_AUDIO,
+    WS_LANE_BULK,
+    WS_LANE_MAX,
+} ws_lane_t;
+
+typedef struct {
+    int depth;              // messages queued now
+    int depth_max;          // max messages queued since connected
+    unsigned int sent;      // messages sent since connected
+    unsigned int dropped;   // messages dropped since connected
+    unsigned int coalesced; // messages merged into the previous one when sending
+    unsigned int wait_avg;  // average queueing time of sent messages, in ms
+    unsigned int wait_max;  // max queueing time of sent messages, in ms
+} ws_lane_stats_t;
+
 typedef enum {
     WS_CONN_STATE_INVALID = -1,
     WS_CONN_STATE_DISCONNECTED = 0,
@@ -70,6 +90,8 @@ ws_conn_state_t ws_client_conn_state(ws_client_handle_t handle);
 
 void ws_client_set_heartbeat(ws_client_handle_t handle, int millisecond);
 
+int ws_client_get_lane_stats(ws_client_handle_t handle, ws_lane_t lane, ws_lane_stats_t *stats);
+
 void ws_client_disconnect(ws_client_handle_t handle);
 
 void ws_client_destory(ws_client_handle_t handle);
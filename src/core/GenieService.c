@@ -20,6 +20,7 @@
 
 #include "osal/os_thread.h"
 #include "osal/os_time.h"
+#include "osal/os_misc.h"
 #include "cutils/log_helper.h"
 #include "cutils/memory_helper.h"
 #include "cutils/list.h"
@@ -27,6 +28,7 @@
 #include "json/cJSON.h"
 
 #include "base/websocket_client.h"
+#include "base/listener_set.h"
 #include "GenieProtocol.h"
 #include "GenieService.h"
 
@@ -36,14 +38,27 @@
 #define GENIE_SERVICE_THREAD_PRIO           OS_THREAD_PRIO_NORMAL
 #define GENIE_SERVICE_THREAD_STACK          8192
 
+#if defined(GENIE_HAVE_MOCK_GATEWAY_ENABLED)
+// local stand-in gateway for offline tests (unittest/GenieMockGateway.c), plain websocket without tls
+#ifndef GENIE_MOCK_GATEWAY_PORT
+#define GENIE_MOCK_GATEWAY_PORT             18443
+#endif
+#define GENIE_WEBSOCKET_HOST_NAME           "127.0.0.1"
+#define GENIE_WEBSOCKET_HOST_PORT           GENIE_MOCK_GATEWAY_PORT
+#else
 #define GENIE_WEBSOCKET_HOST_NAME           "g-aicloud.alibaba.com"
 #define GENIE_WEBSOCKET_HOST_PORT           443
+#endif
 #define GENIE_WEBSOCKET_PING_INTERVAL       20000 // 20s
-#define GENIE_WEBSOCKET_RECONNECT_INTERVAL  10000 // 10s
-#define GENIE_WEBSOCKET_RECONNECT_MAX       5
+#define GENIE_WEBSOCKET_RECONNECT_INTERVAL  10000 // 10s, timeout of one connect attempt
+#define GENIE_WEBSOCKET_RECONNECT_MAX       10
+#define GENIE_WEBSOCKET_BACKOFF_BASE        500   // first retry is immediate, then 0.5s, 1s, 2s...
+#define GENIE_WEBSOCKET_BACKOFF_MAX         30000 // 30s
 
 #define GENIE_MICPHONE_CHECKSTATE_DELAY     10000 // 10s
 
+#define GENIE_COMMAND_ARENA_SIZE            4096  // gateway commands are parsed into this block, larger ones spill to heap
+
 typedef struct {
     bool useDefaultBiz;
     const char *bizType;
@@ -71,31 +86,22 @@ typedef struct {
     bool isPlayerStarted;
     bool isStateSynced;
 
-    struct listnode commandListenerList;
-    struct listnode ttsbinaryListenerList;
-    struct listnode statusListenerList;
+    listener_set_handle_t commandListeners;   // notified without threadLock, see listener_set.h
+    listener_set_handle_t ttsbinaryListeners;
+    listener_set_handle_t statusListeners;
     struct listnode pendingMsgList;           // if micphone active, add other events to pending list
 
+    cJSON_Arena commandArena;                 // only used in websocket receive callback, reset after each command
+
     Genie_SpeechContext_t speechContext;      // update speechContext when micphone active
     Genie_SpeakerContext_t speakerContext;    // update speakerContext when speaker volume/muted changed
     Genie_PlayerContext_t playerContext;      // update playerContext when player started
     Genie_PlayerContext_t playerContextCache; // update playerContextCache when receiving audio command from gateway
 } GnService_Priv_t;
 
-typedef struct {
-    void (*commandListener)(Genie_Domain_t domain, Genie_Command_t command, const char *payload);
-    struct listnode listnode;
-} GnService_CommandListenerNode_t;
-
-typedef struct {
-    void (*ttsbinaryListener)(char *data, int len, bool final);
-    struct listnode listnode;
-} GnService_TtsbinaryListenerNode_t;
-
-typedef struct {
-    void (*statusListener)(Genie_Status_t status);
-    struct listnode listnode;
-} GnService_StatusListenerNode_t;
+typedef void (*GnService_CommandListener_t)(Genie_Domain_t domain, Genie_Command_t command, const cJSON *payload);
+typedef void (*GnService_TtsbinaryListener_t)(char *data, int len, bool final);
+typedef void (*GnService_StatusListener_t)(Genie_Status_t status);
 
 typedef struct {
     struct message *msg;
@@ -105,6 +111,7 @@ typedef struct {
 static GnService_Priv_t     sGnService;
 static GnService_Callback_t sGnCallback;
 static bool                 sGnInited = false;
+static unsigned char        sGnCommandArenaBlock[GENIE_COMMAND_ARENA_SIZE];
 
 enum {
     WHAT_STATUS_WEBSOCKET_CONNECTED     = 0,
@@ -170,41 +177,32 @@ static void GnLooper_Update_PlayerContext()
     memset(&sGnService.playerContextCache, 0x0, sizeof(sGnService.playerContextCache));
 }
 
-static void GnLooper_Notify_CommandListener(Genie_Domain_t domain, Genie_Command_t command, const char *payload)
+static void GnLooper_Notify_CommandListener(Genie_Domain_t domain, Genie_Command_t command, const cJSON *payload)
 {
-    os_mutex_lock(sGnService.threadLock);
-    struct listnode *item;
-    list_for_each(item, &sGnService.commandListenerList) {
-        GnService_CommandListenerNode_t *node =
-                listnode_to_item(item, GnService_CommandListenerNode_t, listnode);
-        node->commandListener(domain, command, payload);
-    }
-    os_mutex_unlock(sGnService.threadLock);
+    listener_set_reader_t reader;
+    listener_set_read_begin(sGnService.commandListeners, &reader);
+    for (int i = 0; i < reader.count; i++)
+        ((GnService_CommandListener_t)reader.listeners[i])(domain, command, payload);
+    listener_set_read_end(sGnService.commandListeners, &reader);
 }
 
 static void GnLooper_Notify_TtsbinaryListener(char *data, int len, bool final)
 {
-    os_mutex_lock(sGnService.threadLock);
-    struct listnode *item;
-    list_for_each(item, &sGnService.ttsbinaryListenerList) {
-        GnService_TtsbinaryListenerNode_t *node =
-                listnode_to_item(item, GnService_TtsbinaryListenerNode_t, listnode);
-        node->ttsbinaryListener(data, len, final);
-    }
-    os_mutex_unlock(sGnService.threadLock);
+    listener_set_reader_t reader;
+    listener_set_read_begin(sGnService.ttsbinaryListeners, &reader);
+    for (int i = 0; i < reader.count; i++)
+        ((GnService_TtsbinaryListener_t)reader.listeners[i])(data, len, final);
+    listener_set_read_end(sGnService.ttsbinaryListeners, &reader);
 }
 
 static void GnLooper_Notify_StatusListener(Genie_Status_t status)
 {
-    os_mutex_lock(sGnService.threadLock);
     OS_LOGI(TAG, "Notified status: %s", GnStatus_ToString(status));
-    struct listnode *item;
-    list_for_each(item, &sGnService.statusListenerList) {
-        GnService_StatusListenerNode_t *node =
-                listnode_to_item(item, GnService_StatusListenerNode_t, listnode);
-        node->statusListener(status);
-    }
-    os_mutex_unlock(sGnService.threadLock);
+    listener_set_reader_t reader;
+    listener_set_read_begin(sGnService.statusListeners, &reader);
+    for (int i = 0; i < reader.count; i++)
+        ((GnService_StatusListener_t)reader.listeners[i])(status);
+    listener_set_read_end(sGnService.statusListeners, &reader);
 }
 
 static void GnLooper_Free_MessageData(struct message *msg)
@@ -241,7 +239,7 @@ static void GnLooper_Clear_AllMessages()
 
     if (sGnService.isMicphoneWakeup) {
         if (sGnService.isMicphoneStarted)
-            GnLooper_Notify_CommandListener(GENIE_DOMAIN_Microphone, GENIE_COMMAND_ExpectSpeechStop, "{}");
+            GnLooper_Notify_CommandListener(GENIE_DOMAIN_Microphone, GENIE_COMMAND_ExpectSpeechStop, NULL);
         else
             sGnService.isMicphoneWakeup = false;
     }
@@ -472,7 +470,7 @@ static void GnCallback_OnExpectSpeech()
 
     if (!sGnService.isMicphoneStarted && !sGnService.isSpeakerMuted) {
         sGnService.isMicphoneWakeup = true;
-        GnLooper_Notify_CommandListener(GENIE_DOMAIN_Microphone, GENIE_COMMAND_ExpectSpeechStart, "{}");
+        GnLooper_Notify_CommandListener(GENIE_DOMAIN_Microphone, GENIE_COMMAND_ExpectSpeechStart, NULL);
     }
 
     os_mutex_unlock(sGnService.stateLock);
@@ -481,7 +479,7 @@ static void GnCallback_OnExpectSpeech()
 static void GnCallback_OnMicphoneSilence()
 {
     OS_LOGI(TAG, "OnMicphoneSilence");
-    GnLooper_Notify_CommandListener(GENIE_DOMAIN_Microphone, GENIE_COMMAND_ExpectSpeechStop, "{}");
+    GnLooper_Notify_CommandListener(GENIE_DOMAIN_Microphone, GENIE_COMMAND_ExpectSpeechStop, NULL);
 }
 
 static void GnCallback_OnSpeakerVolumeChanged(int volume)
@@ -726,6 +724,22 @@ static void GnCallback_OnTextRecognize(const char *inputText)
     os_mutex_unlock(sGnService.stateLock);
 }
 
+// Exponential backoff with jitter: 0, then [d/2, d] with d = BASE << (retry-1), capped at MAX,
+// so a dropped link comes back at once while a fleet of devices does not retry in lockstep
+static int GnWebsocket_ReconnectDelay(int retry)
+{
+    if (retry <= 0)
+        return 0;
+    int delay = GENIE_WEBSOCKET_BACKOFF_MAX;
+    if (retry <= 16)
+        delay = GENIE_WEBSOCKET_BACKOFF_BASE << (retry - 1);
+    if (delay > GENIE_WEBSOCKET_BACKOFF_MAX)
+        delay = GENIE_WEBSOCKET_BACKOFF_MAX;
+    unsigned int rand = 0;
+    os_random(&rand, sizeof(rand));
+    return delay / 2 + rand % (delay / 2 + 1);
+}
+
 static void GnWebsocket_OnConnected()
 {
     OS_LOGI(TAG, "-->OnWebsocketConnected");
@@ -755,7 +769,10 @@ static void GnWebsocket_OnDisconnected()
     os_mutex_lock(sGnService.stateLock);
 
     if (!sGnService.isWebsocketConnected) {
-        OS_LOGV(TAG, "Websocket already disconnected, ignore OnWebsocketDisconnected");
+        // connect attempt failed, schedule next retry now rather than at checkstate timeout
+        OS_LOGV(TAG, "Websocket connect failed, check state immediately");
+        mlooper_remove_message(sGnService.looper, WHAT_COMMAND_WEBSOCKET_CHECKSTATE);
+        GnLooper_Post_Message(WHAT_COMMAND_WEBSOCKET_CHECKSTATE, 0, 0, NULL);
         os_mutex_unlock(sGnService.stateLock);
         return;
     }
@@ -773,37 +790,41 @@ static void GnWebsocket_OnReceivedText(char *text, int size)
     OS_LOGI(TAG, "OnWebsocketReceivedText");
     if (text == NULL) return;
 
-    cJSON *rootJson = cJSON_Parse(text);
-    if (rootJson == NULL) return;
+    // Parse once into the command arena, listeners borrow payloadJson instead of reprinting and reparsing the payload
+    unsigned long long parseUs = os_monotonic_usec();
+    cJSON *rootJson = cJSON_ParseWithArena(&sGnService.commandArena, text);
+    if (rootJson == NULL) {
+        cJSON_ResetArena(&sGnService.commandArena);
+        return;
+    }
+    parseUs = os_monotonic_usec() - parseUs;
     cJSON *commandDomainJson = cJSON_GetObjectItem(rootJson, "commandDomain");
     cJSON *commandNameJson = cJSON_GetObjectItem(rootJson, "commandName");
     cJSON *payloadJson = cJSON_GetObjectItem(rootJson, "payload");
     if (commandDomainJson == NULL || commandNameJson == NULL || payloadJson == NULL) {
-        cJSON_Delete(rootJson);
+        cJSON_ResetArena(&sGnService.commandArena);
         return;
     }
     char *commandDomainStr = cJSON_GetStringValue(commandDomainJson);
     char *commandNameStr = cJSON_GetStringValue(commandNameJson);
-    char *payloadStr = cJSON_PrintUnformatted(payloadJson);
-    if (commandDomainStr == NULL || commandNameStr == NULL || payloadStr == NULL) {
-        if (payloadStr != NULL) OS_FREE(payloadStr);
-        cJSON_Delete(rootJson);
+    if (commandDomainStr == NULL || commandNameStr == NULL) {
+        cJSON_ResetArena(&sGnService.commandArena);
         return;
     }
     Genie_Domain_t commandDomain = Genie_Domain_StringToInt(commandDomainStr);
     Genie_Command_t commandName = Genie_Command_StringToInt(commandNameStr);
     if (commandDomain == -1 || commandName == -1) {
-        OS_LOGE(TAG, "Unsupported command: {%s - %s}, payload: %s", commandDomainStr, commandNameStr, payloadStr);
-        OS_FREE(payloadStr);
-        cJSON_Delete(rootJson);
+        OS_LOGE(TAG, "Unsupported command: %s", text);
+        cJSON_ResetArena(&sGnService.commandArena);
         return;
     }
 
     if (commandDomain != GENIE_DOMAIN_Account)
-        OS_LOGI(TAG, "Receive command: {%s - %s}, payload: %s", commandDomainStr, commandNameStr, payloadStr);
+        OS_LOGI(TAG, "Receive command: %s", text);
     else
         OS_LOGI(TAG, "Receive command: {%s - %s}", commandDomainStr, commandNameStr);
 
+    cJSON *accountJson = NULL;
     os_mutex_lock(sGnService.stateLock);
 
     switch (commandDomain) {
@@ -886,17 +907,11 @@ static void GnWebsocket_OnReceivedText(char *text, int size)
                 sGnService.isAccountAuthorized ? GENIE_STATUS_Authorized : GENIE_STATUS_Unauthorized;
             GnLooper_Notify_StatusListener(accountStatus);
 
-            OS_FREE(payloadStr);
-            unsigned int payloadLen = 128;
-            if (sGnService.uuid != NULL && sGnService.accessToken != NULL)
-                payloadLen += (strlen(sGnService.uuid) + strlen(sGnService.accessToken));
-            payloadStr = OS_MALLOC(payloadLen);
-            if (payloadStr != NULL) {
-                if (sGnService.uuid != NULL && sGnService.accessToken != NULL)
-                    snprintf(payloadStr, payloadLen,
-                        "{\"uuid\":\"%s\", \"accessToken\":\"%s\"}", sGnService.uuid, sGnService.accessToken);
-                else
-                    snprintf(payloadStr, payloadLen, "{}");
+            // listeners get the account only, not the whole activate response
+            accountJson = cJSON_CreateObject();
+            if (accountJson != NULL && sGnService.uuid != NULL && sGnService.accessToken != NULL) {
+                cJSON_AddStringToObject(accountJson, "uuid", sGnService.uuid);
+                cJSON_AddStringToObject(accountJson, "accessToken", sGnService.accessToken);
             }
         }
         break;
@@ -926,11 +941,17 @@ static void GnWebsocket_OnReceivedText(char *text, int size)
 
     os_mutex_unlock(sGnService.stateLock);
 
-    GnLooper_Notify_CommandListener(commandDomain, commandName, payloadStr);
-
-    if (payloadStr != NULL)
-        OS_FREE(payloadStr);
-    cJSON_Delete(rootJson);
+    unsigned long long dispatchUs = os_monotonic_usec();
+    GnLooper_Notify_CommandListener(commandDomain, commandName, accountJson != NULL ? accountJson : payloadJson);
+    dispatchUs = os_monotonic_usec() - dispatchUs;
+    OS_LOGD(TAG, "Dispatch {%s - %s}: size=%d, parse=%lluus, listeners=%lluus, arena=%d/%d, spills=%d",
+            commandDomainStr, commandNameStr, size, parseUs, dispatchUs,
+            (int)sGnService.commandArena.offset, (int)sGnService.commandArena.size,
+            (int)sGnService.commandArena.spill_count);
+
+    if (accountJson != NULL)
+        cJSON_Delete(accountJson);
+    cJSON_ResetArena(&sGnService.commandArena);
 }
 
 static void GnWebsocket_OnReceivedBinary(char *data, int size, ws_binary_type_t type)
@@ -959,8 +980,11 @@ static void GnLooper_Handle_WebsocketStatusMessage(struct message *msg)
             GnLooper_Post_Message(WHAT_STATUS_ACCOUNT_AUTHORIZED, 0, 0, NULL);
         }
     } else if (msg->what == WHAT_STATUS_WEBSOCKET_DISCONNECTED) {
-        if (sGnService.isNetworkConnected)
-            GnLooper_Post_DelayMessage(WHAT_COMMAND_WEBSOCKET_CONNECT, 0, 0, NULL, GENIE_WEBSOCKET_RECONNECT_INTERVAL);
+        if (sGnService.isNetworkConnected) {
+            GnLooper_Post_DelayMessage(WHAT_COMMAND_WEBSOCKET_CONNECT, 0, 0, NULL,
+                GnWebsocket_ReconnectDelay(sGnService.websocketReconnectCount));
+            sGnService.websocketReconnectCount++;
+        }
         // todo: if always unauthorized, don't connect gateway any more
     }
 }
@@ -1076,7 +1100,11 @@ static void GnLooper_Handle_WebsocketDoConnect(struct message *msg)
         info.path = Genie_Create_GatewayUrl2();
     else
         info.path = Genie_Create_GatewayUrl(sGnService.bizType, sGnService.bizGroup, sGnService.bizSecret);
+#if defined(GENIE_HAVE_MOCK_GATEWAY_ENABLED)
+    info.cacert = NULL;
+#else
     info.cacert = (char *)sGnService.caCert;
+#endif
     info.callback.on_connected = GnWebsocket_OnConnected;
     info.callback.on_disconnected = GnWebsocket_OnDisconnected;
     info.callback.on_received_text = GnWebsocket_OnReceivedText;
@@ -1105,8 +1133,9 @@ static void GnLooper_Handle_WebsocketDoCheckstate(struct message *msg)
     if (ws_client_conn_state(sGnService.websocket) != WS_CONN_STATE_CONNECTED) {
         GnLooper_Clear_AllMessages_l();
         if (sGnService.websocketReconnectCount < GENIE_WEBSOCKET_RECONNECT_MAX) {
-            OS_LOGW(TAG, "Retry to connect gateway, retryCount=%d", sGnService.websocketReconnectCount);
-            GnLooper_Post_Message(WHAT_COMMAND_WEBSOCKET_CONNECT, 0, 0, NULL);
+            int delay = GnWebsocket_ReconnectDelay(sGnService.websocketReconnectCount);
+            OS_LOGW(TAG, "Retry to connect gateway in %dms, retryCount=%d", delay, sGnService.websocketReconnectCount);
+            GnLooper_Post_DelayMessage(WHAT_COMMAND_WEBSOCKET_CONNECT, 0, 0, NULL, delay);
         } else {
             OS_LOGE(TAG, "Failed to connect gateway, retryCount=%d", sGnService.websocketReconnectCount);
         }
@@ -1237,6 +1266,7 @@ bool GnService_Init(GnService_Adapter_t *adapter)
 
     memset(&sGnService, 0x0, sizeof(sGnService));
     memset(&sGnCallback, 0x0, sizeof(sGnCallback));
+    cJSON_InitArena(&sGnService.commandArena, sGnCommandArenaBlock, sizeof(sGnCommandArenaBlock));
 
     if (adapter == NULL) return false;
 
@@ -1304,6 +1334,12 @@ bool GnService_Init(GnService_Adapter_t *adapter)
         goto __error_init;
     if ((sGnService.stateLock = os_mutex_create()) == NULL)
         goto __error_init;
+    if ((sGnService.commandListeners = listener_set_create()) == NULL)
+        goto __error_init;
+    if ((sGnService.ttsbinaryListeners = listener_set_create()) == NULL)
+        goto __error_init;
+    if ((sGnService.statusListeners = listener_set_create()) == NULL)
+        goto __error_init;
     struct os_thread_attr thread_attr = {
         .name = GENIE_SERVICE_THREAD_NAME,
         .priority = GENIE_SERVICE_THREAD_PRIO,
@@ -1314,9 +1350,6 @@ bool GnService_Init(GnService_Adapter_t *adapter)
     if (sGnService.looper == NULL)
         goto __error_init;
 
-    list_init(&sGnService.commandListenerList);
-    list_init(&sGnService.ttsbinaryListenerList);
-    list_init(&sGnService.statusListenerList);
     list_init(&sGnService.pendingMsgList);
 
     sGnCallback.onNetworkConnected      = GnCallback_OnNetworkConnected;
@@ -1351,6 +1384,9 @@ __error_init:
     if (sGnService.websocket != NULL)   ws_client_destory(sGnService.websocket);
     if (sGnService.threadLock != NULL)  os_mutex_destroy(sGnService.threadLock);
     if (sGnService.stateLock != NULL)   os_mutex_destroy(sGnService.stateLock);
+    if (sGnService.commandListeners != NULL)    listener_set_destroy(sGnService.commandListeners);
+    if (sGnService.ttsbinaryListeners != NULL)  listener_set_destroy(sGnService.ttsbinaryListeners);
+    if (sGnService.statusListeners != NULL)     listener_set_destroy(sGnService.statusListeners);
     if (sGnService.looper != NULL)      mlooper_destroy(sGnService.looper);
     return false;
 }
@@ -1360,34 +1396,13 @@ bool GnService_IsInit()
     return sGnInited;
 }
 
-bool GnService_Register_CommandListener(void (*listener)(Genie_Domain_t domain, Genie_Command_t command, const char *payload))
+bool GnService_Register_CommandListener(void (*listener)(Genie_Domain_t domain, Genie_Command_t command, const cJSON *payload))
 {
     if (!sGnInited || listener == NULL) {
         OS_LOGE(TAG, "Genie service is NOT inited");
         return false;
     }
-
-    GnService_CommandListenerNode_t *node;
-    struct listnode *item;
-    bool found = false;
-
-    os_mutex_lock(sGnService.threadLock);
-    list_for_each(item, &sGnService.commandListenerList) {
-        node = listnode_to_item(item, GnService_CommandListenerNode_t, listnode);
-        if (node->commandListener == listener)
-            found = true;
-    }
-    if (!found) {
-        node = OS_MALLOC(sizeof(GnService_CommandListenerNode_t));
-        if (node == NULL) {
-            os_mutex_unlock(sGnService.threadLock);
-            return false;
-        }
-        node->commandListener = listener;
-        list_add_tail(&sGnService.commandListenerList, &node->listnode);
-    }
-    os_mutex_unlock(sGnService.threadLock);
-    return true;
+    return listener_set_add(sGnService.commandListeners, (listener_fn_t)listener) == 0;
 }
 
 bool GnService_Register_TtsbinaryListener(void (*listener)(char *data, int len, bool final))
@@ -1396,28 +1411,7 @@ bool GnService_Register_TtsbinaryListener(void (*listener)(char *data, int len,
         OS_LOGE(TAG, "Genie service is NOT inited");
         return false;
     }
-
-    GnService_TtsbinaryListenerNode_t *node;
-    struct listnode *item;
-    bool found = false;
-
-    os_mutex_lock(sGnService.threadLock);
-    list_for_each(item, &sGnService.ttsbinaryListenerList) {
-        node = listnode_to_item(item, GnService_TtsbinaryListenerNode_t, listnode);
-        if (node->ttsbinaryListener == listener)
-            found = true;
-    }
-    if (!found) {
-        node = OS_MALLOC(sizeof(GnService_TtsbinaryListenerNode_t));
-        if (node == NULL) {
-            os_mutex_unlock(sGnService.threadLock);
-            return false;
-        }
-        node->ttsbinaryListener = listener;
-        list_add_tail(&sGnService.ttsbinaryListenerList, &node->listnode);
-    }
-    os_mutex_unlock(sGnService.threadLock);
-    return true;
+    return listener_set_add(sGnService.ttsbinaryListeners, (listener_fn_t)listener) == 0;
 }
 
 bool GnService_Register_StatusListener(void (*listener)(Genie_Status_t status))
@@ -1426,49 +1420,16 @@ bool GnService_Register_StatusListener(void (*listener)(Genie_Status_t status))
         OS_LOGE(TAG, "Genie service is NOT inited");
         return false;
     }
-
-    GnService_StatusListenerNode_t *node;
-    struct listnode *item;
-    bool found = false;
-
-    os_mutex_lock(sGnService.threadLock);
-    list_for_each(item, &sGnService.statusListenerList) {
-        node = listnode_to_item(item, GnService_StatusListenerNode_t, listnode);
-        if (node->statusListener == listener)
-            found = true;
-    }
-    if (!found) {
-        node = OS_MALLOC(sizeof(GnService_StatusListenerNode_t));
-        if (node == NULL) {
-            os_mutex_unlock(sGnService.threadLock);
-            return false;
-        }
-        node->statusListener = listener;
-        list_add_tail(&sGnService.statusListenerList, &node->listnode);
-    }
-    os_mutex_unlock(sGnService.threadLock);
-    return true;
+    return listener_set_add(sGnService.statusListeners, (listener_fn_t)listener) == 0;
 }
 
-void GnService_Unregister_CommandListener(void (*listener)(Genie_Domain_t domain, Genie_Command_t command, const char *payload))
+void GnService_Unregister_CommandListener(void (*listener)(Genie_Domain_t domain, Genie_Command_t command, const cJSON *payload))
 {
     if (!sGnInited || listener == NULL) {
         OS_LOGE(TAG, "Genie service is NOT inited");
         return;
     }
-
-    GnService_CommandListenerNode_t *node;
-    struct listnode *item, *tmp;
-    os_mutex_lock(sGnService.threadLock);
-    list_for_each_safe(item, tmp, &sGnService.commandListenerList) {
-        node = listnode_to_item(item, GnService_CommandListenerNode_t, listnode);
-        if (node->commandListener == listener) {
-            list_remove(item);
-            OS_FREE(node);
-            break;
-        }
-    }
-    os_mutex_unlock(sGnService.threadLock);
+    listener_set_remove(sGnService.commandListeners, (listener_fn_t)listener);
 }
 
 void GnService_Unregister_TtsbinaryListener(void (*listener)(char *data, int len, bool final))
@@ -1477,19 +1438,7 @@ void GnService_Unregister_TtsbinaryListener(void (*listener)(char *data, int len
         OS_LOGE(TAG, "Genie service is NOT inited");
         return;
     }
-
-    GnService_TtsbinaryListenerNode_t *node;
-    struct listnode *item, *tmp;
-    os_mutex_lock(sGnService.threadLock);
-    list_for_each_safe(item, tmp, &sGnService.ttsbinaryListenerList) {
-        node = listnode_to_item(item, GnService_TtsbinaryListenerNode_t, listnode);
-        if (node->ttsbinaryListener == listener) {
-            list_remove(item);
-            OS_FREE(node);
-            break;
-        }
-    }
-    os_mutex_unlock(sGnService.threadLock);
+    listener_set_remove(sGnService.ttsbinaryListeners, (listener_fn_t)listener);
 }
 
 void GnService_Unregister_StatusListener(void (*listener)(Genie_Status_t status))
@@ -1498,19 +1447,7 @@ void GnService_Unregister_StatusListener(void (*listener)(Genie_Status_t status)
         OS_LOGE(TAG, "Genie service is NOT inited");
         return;
     }
-
-    GnService_StatusListenerNode_t *node;
-    struct listnode *item, *tmp;
-    os_mutex_lock(sGnService.threadLock);
-    list_for_each_safe(item, tmp, &sGnService.statusListenerList) {
-        node = listnode_to_item(item, GnService_StatusListenerNode_t, listnode);
-        if (node->statusListener == listener) {
-            list_remove(item);
-            OS_FREE(node);
-            break;
-        }
-    }
-    os_mutex_unlock(sGnService.threadLock);
+    listener_set_remove(sGnService.statusListeners, (listener_fn_t)listener);
 }
 
 bool GnService_Get_Callback(GnService_Callback_t **callback)
@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include "json/cJSON.h"
 #include "GenieDefine.h"
 
 #ifdef __cplusplus
@@ -66,13 +67,15 @@ bool GnService_Init(GnService_Adapter_t *adapter);
 
 bool GnService_IsInit();
 
-bool GnService_Register_CommandListener(void (*listener)(Genie_Domain_t domain, Genie_Command_t command, const char *payload));
+// payload is parsed once and borrowed by all listeners, only valid during the callback, don't modify or keep it.
+// payload is NULL for commands generated locally (ExpectSpeechStart, ExpectSpeechStop)
+bool GnService_Register_CommandListener(void (*listener)(Genie_Domain_t domain, Genie_Command_t command, const cJSON *payload));
 
 bool GnService_Register_TtsbinaryListener(void (*listener)(char *data, int len, bool final));
 
 bool GnService_Register_StatusListener(void (*listener)(Genie_Status_t status));
 
-void GnService_Unregister_CommandListener(void (*listener)(Genie_Domain_t domain, Genie_Command_t command, const char *payload));
+void GnService_Unregister_CommandListener(void (*listener)(Genie_Domain_t domain, Genie_Command_t command, const cJSON *payload));
 
 void GnService_Unregister_TtsbinaryListener(void (*listener)(char *data, int len, bool final));
 
@@ -39,36 +39,30 @@ typedef struct {
 static GnPlayer_priv_t sGnPlayer;
 static bool            sGnInited = false;
 
-static void GnService_CommandListener(Genie_Domain_t domain, Genie_Command_t command, const char *payload)
+static void GnService_CommandListener(Genie_Domain_t domain, Genie_Command_t command, const cJSON *payload)
 {
     switch (command) {
     case GENIE_COMMAND_Speak: {
-        cJSON *payloadJson = cJSON_Parse(payload);
-        if (payloadJson == NULL) return;
-        cJSON *expectSpeechJson = cJSON_GetObjectItem(payloadJson, "expectSpeech");
+        if (payload == NULL) return;
+        cJSON *expectSpeechJson = cJSON_GetObjectItem(payload, "expectSpeech");
         bool expectSpeech = false;
         if (expectSpeechJson != NULL && cJSON_IsTrue(expectSpeechJson))
             expectSpeech = true;
         sGnPlayer.utpCallback->onCommandNewTtsHeader(expectSpeech);
-        cJSON_Delete(payloadJson);
     }
         break;
     case GENIE_COMMAND_Play: {
-        cJSON *payloadJson = cJSON_Parse(payload);
-        if (payloadJson == NULL) return;
-        cJSON *audioUrlJson = cJSON_GetObjectItem(payloadJson, "audioUrl");
+        if (payload == NULL) return;
+        cJSON *audioUrlJson = cJSON_GetObjectItem(payload, "audioUrl");
         if (audioUrlJson != NULL && cJSON_IsString(audioUrlJson))
             sGnPlayer.utpCallback->onCommandNewMusic(cJSON_GetStringValue(audioUrlJson));
-        cJSON_Delete(payloadJson);
     }
         break;
     case GENIE_COMMAND_PlayOnce: {
-        cJSON *payloadJson = cJSON_Parse(payload);
-        if (payloadJson == NULL) return;
-        cJSON *audioUrlJson = cJSON_GetObjectItem(payloadJson, "audioUrl");
+        if (payload == NULL) return;
+        cJSON *audioUrlJson = cJSON_GetObjectItem(payload, "audioUrl");
         if (audioUrlJson != NULL && cJSON_IsString(audioUrlJson))
             sGnPlayer.utpCallback->onCommandNewPrompt(cJSON_GetStringValue(audioUrlJson));
-        cJSON_Delete(payloadJson);
     }
         break;
     case GENIE_COMMAND_Pause:
@@ -283,3 +277,23 @@ void GnPlayer_Stop()
     GnUtpManager_Stop();
     os_mutex_unlock(sGnPlayer.lock);
 }
+
+bool GnPlayer_Register_PcmOutListener(void (*listener)(void *stream, const void *buffer, unsigned int size,
+                                                       int sampleRate, int channelCount, int bitsPerSample))
+{
+    if (!sGnInited) {
+        OS_LOGE(TAG, "Genie Player is NOT inited");
+        return false;
+    }
+    return GnVendorPlayer_Register_PcmOutListener(listener);
+}
+
+void GnPlayer_Unregister_PcmOutListener(void (*listener)(void *stream, const void *buffer, unsigned int size,
+                                                         int sampleRate, int channelCount, int bitsPerSample))
+{
+    if (!sGnInited) {
+        OS_LOGE(TAG, "Genie Player is NOT inited");
+        return;
+    }
+    GnVendorPlayer_Unregister_PcmOutListener(listener);
+}
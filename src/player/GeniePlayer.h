@@ -55,6 +55,12 @@ bool GnPlayer_IsTtsPlaying();
 
 void GnPlayer_Stop();
 
+bool GnPlayer_Register_PcmOutListener(void (*listener)(void *stream, const void *buffer, unsigned int size,
+                                                       int sampleRate, int channelCount, int bitsPerSample));
+
+void GnPlayer_Unregister_PcmOutListener(void (*listener)(void *stream, const void *buffer, unsigned int size,
+                                                         int sampleRate, int channelCount, int bitsPerSample));
+
 #ifdef __cplusplus
 }
 #endif
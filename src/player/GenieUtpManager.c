@@ -25,6 +25,7 @@
 #include "cutils/list.h"
 #include "cutils/mlooper.h"
 
+#include "base/listener_set.h"
 #include "GenieUtpManager.h"
 
 #define TAG "GenieUTP"
@@ -70,7 +71,7 @@ typedef struct {
     bool isMusicPausing;
     bool isMusicResuming;
 
-    struct listnode stateListenerList;
+    listener_set_handle_t stateListeners;   // notified without looperLock, see listener_set.h
     struct listnode playList;
     struct listnode ttsFrameList;
     int ttsId;
@@ -79,10 +80,7 @@ typedef struct {
     os_cond ttsCond;
 } GnUtpManager_priv_t;
 
-typedef struct {
-    void (*stateListener)(GnPlayer_Stream_t stream, GnPlayer_State_t state, bool expectSpeech);
-    struct listnode listnode;
-} GnPlayer_StateListenerNode_t;
+typedef void (*GnPlayer_StateListener_t)(GnPlayer_Stream_t stream, GnPlayer_State_t state, bool expectSpeech);
 
 typedef struct {
     GnPlayer_Stream_t stream;
@@ -205,13 +203,11 @@ static bool GnPlayer_Need_ResumeMusic()
 
 static void GnPlayer_Update_State(GnPlayer_Stream_t stream, GnPlayer_State_t state, bool expectSpeech)
 {
-    os_mutex_lock(sGnUtpManager.looperLock);
-    struct listnode *item;
-    list_for_each(item, &sGnUtpManager.stateListenerList) {
-        GnPlayer_StateListenerNode_t *node = listnode_to_item(item, GnPlayer_StateListenerNode_t, listnode);
-        node->stateListener(stream, state, expectSpeech);
-    }
-    os_mutex_unlock(sGnUtpManager.looperLock);
+    listener_set_reader_t reader;
+    listener_set_read_begin(sGnUtpManager.stateListeners, &reader);
+    for (int i = 0; i < reader.count; i++)
+        ((GnPlayer_StateListener_t)reader.listeners[i])(stream, state, expectSpeech);
+    listener_set_read_end(sGnUtpManager.stateListeners, &reader);
 }
 
 static void GnPlayer_Do_Action(GnPlayer_Priv_t *player, GnPlayer_Action_t action, int arg1, int arg2, void *data)
@@ -1063,6 +1059,8 @@ bool GnUtpManager_Init(GnPlayer_Adapter_t *adapter)
         goto __error_init;
     if ((sGnUtpManager.ttsCond = os_cond_create()) == NULL)
         goto __error_init;
+    if ((sGnUtpManager.stateListeners = listener_set_create()) == NULL)
+        goto __error_init;
 
     thread_attr.name = GENIE_TTS_THREAD_NAME;
     thread_attr.priority = GENIE_TTS_THREAD_PRIO;
@@ -1071,7 +1069,6 @@ bool GnUtpManager_Init(GnPlayer_Adapter_t *adapter)
     if (sGnUtpManager.ttsThread == NULL)
         goto __error_init;
 
-    list_init(&sGnUtpManager.stateListenerList);
     list_init(&sGnUtpManager.playList);
     list_init(&sGnUtpManager.ttsFrameList);
 
@@ -1095,6 +1092,7 @@ bool GnUtpManager_Init(GnPlayer_Adapter_t *adapter)
     return true;
 
 __error_init:
+    if (sGnUtpManager.stateListeners != NULL)   listener_set_destroy(sGnUtpManager.stateListeners);
     if (sGnUtpManager.ttsCond != NULL)      os_cond_destroy(sGnUtpManager.ttsCond);
     if (sGnUtpManager.ttsLock != NULL)      os_mutex_destroy(sGnUtpManager.ttsLock);
     if (sGnUtpManager.looperLock != NULL)   os_mutex_destroy(sGnUtpManager.looperLock);
@@ -1129,27 +1127,7 @@ bool GnUtpManager_Register_StateListener(void (*listener)(GnPlayer_Stream_t stre
         OS_LOGE(TAG, "Genie UtpManager is NOT inited");
         return false;
     }
-
-    os_mutex_lock(sGnUtpManager.looperLock);
-    GnPlayer_StateListenerNode_t *node;
-    struct listnode *item;
-    bool found = false;
-    list_for_each(item, &sGnUtpManager.stateListenerList) {
-        node = listnode_to_item(item, GnPlayer_StateListenerNode_t, listnode);
-        if (node->stateListener == listener)
-            found = true;
-    }
-    if (!found) {
-        node = OS_MALLOC(sizeof(GnPlayer_StateListenerNode_t));
-        if (node == NULL) {
-            os_mutex_unlock(sGnUtpManager.looperLock);
-            return false;
-        }
-        node->stateListener = listener;
-        list_add_tail(&sGnUtpManager.stateListenerList, &node->listnode);
-    }
-    os_mutex_unlock(sGnUtpManager.looperLock);
-    return true;
+    return listener_set_add(sGnUtpManager.stateListeners, (listener_fn_t)listener) == 0;
 }
 
 void GnUtpManager_Unregister_StateListener(void (*listener)(GnPlayer_Stream_t stream, GnPlayer_State_t state, bool expectSpeech))
@@ -1158,18 +1136,7 @@ void GnUtpManager_Unregister_StateListener(void (*listener)(GnPlayer_Stream_t st
         OS_LOGE(TAG, "Genie UtpManager is NOT inited");
         return;
     }
-
-    os_mutex_lock(sGnUtpManager.looperLock);
-    struct listnode *item, *tmp;
-    list_for_each_safe(item, tmp, &sGnUtpManager.stateListenerList) {
-        GnPlayer_StateListenerNode_t *node = listnode_to_item(item, GnPlayer_StateListenerNode_t, listnode);
-        if (node->stateListener == listener) {
-            list_remove(item);
-            OS_FREE(node);
-            break;
-        }
-    }
-    os_mutex_unlock(sGnUtpManager.looperLock);
+    listener_set_remove(sGnUtpManager.stateListeners, (listener_fn_t)listener);
 }
 
 bool GnUtpManager_Start()
@@ -20,10 +20,15 @@
 
 #include "cutils/memory_helper.h"
 #include "cutils/log_helper.h"
+#include "base/listener_set.h"
 #include "liteplayer_main.h"
 #include "liteplayer_ttsplayer.h"
 #include "source_httpclient_wrapper.h"
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include "source_mmap_wrapper.h"
+#else
 #include "source_file_wrapper.h"
+#endif
 #include "GenieVendorPlayer.h"
 
 #define TAG "GenieVendorPlayer"
@@ -48,6 +53,13 @@ typedef struct {
     bool hasCompleted;
 } GnVendorPlayer_Priv_t;
 
+typedef struct {
+    void *pcmOut;
+    int sampleRate;
+    int channelCount;
+    int bitsPerSample;
+} GnVendorPlayer_Sink_t;
+
 #include "prebuilt_prompt_WAKEUP_REMIND.c"
 #include "prebuilt_prompt_RECORD_REMIND.c"
 #include "prebuilt_prompt_NETWORK_DISCONNECTED.c"
@@ -56,6 +68,7 @@ typedef struct {
 
 static GnPlayer_Adapter_t sGnVendorPlayer;
 static GnVendor_PcmOut_t  sGnVendorPcmOut;
+static listener_set_handle_t sGnPcmOutListeners; // notified from the sink thread, see listener_set.h
 static bool               sGnInited = false;
 
 static int GnVendorPlayer_StateListener(enum liteplayer_state state, int errcode, void *priv)
@@ -163,6 +176,17 @@ static int GnVendorPlayer_PrebuiltRead(source_handle_t handle, char *buffer, int
     return size;
 }
 
+static int GnVendorPlayer_PrebuiltPeek(source_handle_t handle, char **buffer, int size)
+{
+    GnVendorPlayer_Prebuilt_t *prebuilt = (GnVendorPlayer_Prebuilt_t *)handle;
+    if (prebuilt->offset + size > prebuilt->length)
+        size = prebuilt->length - prebuilt->offset;
+    if (size <= 0)
+        return 0;
+    *buffer = prebuilt->base+prebuilt->offset;
+    return size;
+}
+
 static long long GnVendorPlayer_PrebuiltContentPos(source_handle_t handle)
 {
     GnVendorPlayer_Prebuilt_t *prebuilt = (GnVendorPlayer_Prebuilt_t *)handle;
@@ -198,18 +222,39 @@ static const char *GnVendorPlayer_SinkName()
 
 static sink_handle_t GnVendorPlayer_SinkOpen(int samplerate, int channels, int bits, void *priv_data)
 {
-    void *handle = sGnVendorPcmOut.open(samplerate, channels, bits);
-    return (sink_handle_t)handle;
+    GnVendorPlayer_Sink_t *sink = OS_CALLOC(1, sizeof(GnVendorPlayer_Sink_t));
+    if (sink == NULL)
+        return NULL;
+    sink->pcmOut = sGnVendorPcmOut.open(samplerate, channels, bits);
+    if (sink->pcmOut == NULL) {
+        OS_FREE(sink);
+        return NULL;
+    }
+    sink->sampleRate = samplerate;
+    sink->channelCount = channels;
+    sink->bitsPerSample = bits;
+    return (sink_handle_t)sink;
 }
 
 static int GnVendorPlayer_SinkWrite(sink_handle_t handle, char *buffer, int size)
 {
-    return sGnVendorPcmOut.write((void *)handle, buffer, size);
+    GnVendorPlayer_Sink_t *sink = (GnVendorPlayer_Sink_t *)handle;
+    // Tap the pcm before it is queued to the device, so echo cancellers get the reference
+    // at least as early as the speaker plays it
+    listener_set_reader_t reader;
+    listener_set_read_begin(sGnPcmOutListeners, &reader);
+    for (int i = 0; i < reader.count; i++)
+        ((GnVendorPlayer_PcmOutListener_t)reader.listeners[i])(sink, buffer, size,
+                sink->sampleRate, sink->channelCount, sink->bitsPerSample);
+    listener_set_read_end(sGnPcmOutListeners, &reader);
+    return sGnVendorPcmOut.write(sink->pcmOut, buffer, size);
 }
 
 static void GnVendorPlayer_SinkClose(sink_handle_t handle)
 {
-    sGnVendorPcmOut.close((void *)handle);
+    GnVendorPlayer_Sink_t *sink = (GnVendorPlayer_Sink_t *)handle;
+    sGnVendorPcmOut.close(sink->pcmOut);
+    OS_FREE(sink);
 }
 
 static void *GnVendorPlayer_Create(GnPlayer_Stream_t stream)
@@ -244,6 +289,7 @@ static void *GnVendorPlayer_Create(GnPlayer_Stream_t stream)
             .url_protocol = GnVendorPlayer_PrebuiltUrlProtocol,
             .open = GnVendorPlayer_PrebuiltOpen,
             .read = GnVendorPlayer_PrebuiltRead,
+            .peek = GnVendorPlayer_PrebuiltPeek,
             .content_pos = GnVendorPlayer_PrebuiltContentPos,
             .content_len = GnVendorPlayer_PrebuiltContentLen,
             .seek = GnVendorPlayer_PrebuiltSeek,
@@ -255,6 +301,16 @@ static void *GnVendorPlayer_Create(GnPlayer_Stream_t stream)
             .async_mode = false,
             .buffer_size = 2048,
             .priv_data = NULL,
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+            .url_protocol = mmap_wrapper_url_protocol,
+            .open = mmap_wrapper_open,
+            .read = mmap_wrapper_read,
+            .peek = mmap_wrapper_peek,
+            .content_pos = mmap_wrapper_content_pos,
+            .content_len = mmap_wrapper_content_len,
+            .seek = mmap_wrapper_seek,
+            .close = mmap_wrapper_close,
+#else
             .url_protocol = file_wrapper_url_protocol,
             .open = file_wrapper_open,
             .read = file_wrapper_read,
@@ -262,6 +318,7 @@ static void *GnVendorPlayer_Create(GnPlayer_Stream_t stream)
             .content_len = file_wrapper_content_len,
             .seek = file_wrapper_seek,
             .close = file_wrapper_close,
+#endif
         };
         liteplayer_register_source_wrapper(priv->urlPlayer, &fileOps);
 
@@ -444,6 +501,8 @@ GnPlayer_Adapter_t *GnVendorPlayer_GetInstance(GnVendor_PcmOut_t *pcmOut)
 
     if (pcmOut == NULL || pcmOut->open == NULL || pcmOut->write == NULL || pcmOut->close == NULL)
         return NULL;
+    if ((sGnPcmOutListeners = listener_set_create()) == NULL)
+        return NULL;
     sGnVendorPcmOut.open  = pcmOut->open;
     sGnVendorPcmOut.write = pcmOut->write;
     sGnVendorPcmOut.close = pcmOut->close;
@@ -466,3 +525,21 @@ GnPlayer_Adapter_t *GnVendorPlayer_GetInstance(GnVendor_PcmOut_t *pcmOut)
     sGnInited = true;
     return &sGnVendorPlayer;
 }
+
+bool GnVendorPlayer_Register_PcmOutListener(GnVendorPlayer_PcmOutListener_t listener)
+{
+    if (!sGnInited || listener == NULL) {
+        OS_LOGE(TAG, "Genie vendor player is NOT inited");
+        return false;
+    }
+    return listener_set_add(sGnPcmOutListeners, (listener_fn_t)listener) == 0;
+}
+
+void GnVendorPlayer_Unregister_PcmOutListener(GnVendorPlayer_PcmOutListener_t listener)
+{
+    if (!sGnInited || listener == NULL) {
+        OS_LOGE(TAG, "Genie vendor player is NOT inited");
+        return;
+    }
+    listener_set_remove(sGnPcmOutListeners, (listener_fn_t)listener);
+}
@@ -23,8 +23,17 @@
 extern "C" {
 #endif
 
+// Called from the player sink thread with the pcm about to be written to pcmOut, stream
+// identifies the sink and stays the same until the sink is closed
+typedef void (*GnVendorPlayer_PcmOutListener_t)(void *stream, const void *buffer, unsigned int size,
+                                                int sampleRate, int channelCount, int bitsPerSample);
+
 GnPlayer_Adapter_t *GnVendorPlayer_GetInstance(GnVendor_PcmOut_t *pcmOut);
 
+bool GnVendorPlayer_Register_PcmOutListener(GnVendorPlayer_PcmOutListener_t listener);
+
+void GnVendorPlayer_Unregister_PcmOutListener(GnVendorPlayer_PcmOutListener_t listener);
+
 #ifdef __cplusplus
 }
 #endif
@@ -81,8 +81,15 @@ typedef struct {
 
 #if defined(GENIE_HAVE_SPEEXOGG_ENABLED)
 #define GENIE_SPEEX_QULITY      8
-#define GENIE_SPEEX_COMPLEXITY  2
 #define GENIE_SPEEX_MODEID      SPEEX_MODEID_NB
+// Complexity is picked at startup: the highest one whose encode fits the cpu budget, a
+// percentage of each frame's duration, as measured on this device. Never below the floor
+#define GENIE_SPEEX_COMPLEXITY_MIN      2
+#define GENIE_SPEEX_COMPLEXITY_MAX      10
+#define GENIE_SPEEX_CPU_BUDGET          10 // percent
+#define GENIE_SPEEX_CALIBRATE_FRAMES    10
+#define GENIE_SPEEX_CALIBRATE_PASSES    2
+    int speexComplexity;
     void *speexEncodeHandle;
     SpeexBits speexBits;
     int speexFrameSize;
@@ -100,7 +107,7 @@ typedef struct {
 static GnRecorder_priv_t sGnRecorder;
 static bool              sGnInited = false;
 
-static void GnService_CommandListener(Genie_Domain_t domain, Genie_Command_t command, const char *payload)
+static void GnService_CommandListener(Genie_Domain_t domain, Genie_Command_t command, const cJSON *payload)
 {
     switch (command) {
     case GENIE_COMMAND_ExpectSpeechStart:
@@ -164,9 +171,85 @@ static void GnService_StatusListener(Genie_Status_t status)
 }
 
 #if defined(GENIE_HAVE_SPEEXOGG_ENABLED)
+// Voiced test signal for calibration: a pulse train with the pitch jittering around 170 Hz
+// plus noise, through a formant resonator, so the pitch and codebook searches work as they
+// do on speech
+static void GnRecorder_SpeexOgg_CalibrateSignal(spx_int16_t *pcm, int samples,
+                                                uint32_t *seed, int *phase, int32_t *mem)
+{
+    for (int i = 0; i < samples; i++) {
+        int period = 80 + ((*seed >> 24) & 0x1f);
+        int32_t x = (*phase)++ >= period ? 2000 : 0;
+        if (x != 0)
+            *phase = 0;
+        *seed = *seed * 1664525 + 1013904223;
+        x += (int32_t)(*seed >> 22) - 512;
+        // y = x + 1.6*y1 - 0.8*y2 in Q14
+        int32_t y = x + ((26214 * mem[0] - 13107 * mem[1]) >> 14);
+        mem[1] = mem[0];
+        mem[0] = y;
+        pcm[i] = y > 32767 ? 32767 : (y < -32768 ? -32768 : y);
+    }
+}
+
+// Time the encoder at rising complexity and keep the last one within the cpu budget, cost
+// grows with complexity so stop at the first that doesn't fit
+static int GnRecorder_SpeexOgg_Calibrate()
+{
+    const SpeexMode *mode = speex_lib_get_mode(GENIE_SPEEX_MODEID);
+    spx_int32_t quality = GENIE_SPEEX_QULITY;
+    spx_int32_t frameSize = 0;
+    void *encoder = speex_encoder_init(mode);
+    if (encoder == NULL)
+        return GENIE_SPEEX_COMPLEXITY_MIN;
+    speex_encoder_ctl(encoder, SPEEX_SET_QUALITY, &quality);
+    speex_encoder_ctl(encoder, SPEEX_GET_FRAME_SIZE, &frameSize);
+
+    spx_int16_t *pcm = (spx_int16_t *)sGnRecorder.pcmBuffer;
+    if (frameSize <= 0 || frameSize*sizeof(spx_int16_t) > sizeof(sGnRecorder.pcmBuffer)) {
+        speex_encoder_destroy(encoder);
+        return GENIE_SPEEX_COMPLEXITY_MIN;
+    }
+
+    SpeexBits bits;
+    speex_bits_init(&bits);
+    uint32_t seed = 1;
+    int phase = 0;
+    int32_t mem[2] = { 0, 0 };
+    unsigned long budgetUs = (unsigned long)frameSize*1000000/GENIE_RECORDER_SAMPLE_RATE*GENIE_SPEEX_CPU_BUDGET/100;
+    unsigned long costUs = 0;
+    int complexity = GENIE_SPEEX_COMPLEXITY_MIN;
+    for (spx_int32_t c = GENIE_SPEEX_COMPLEXITY_MIN; c <= GENIE_SPEEX_COMPLEXITY_MAX; c++) {
+        unsigned long frameUs = (unsigned long)-1;
+        speex_encoder_ctl(encoder, SPEEX_SET_COMPLEXITY, &c);
+        for (int pass = 0; pass < GENIE_SPEEX_CALIBRATE_PASSES; pass++) {
+            unsigned long long elapsed = 0;
+            for (int i = 0; i < GENIE_SPEEX_CALIBRATE_FRAMES; i++) {
+                GnRecorder_SpeexOgg_CalibrateSignal(pcm, frameSize, &seed, &phase, mem);
+                unsigned long long start = os_monotonic_usec();
+                speex_encode_int(encoder, pcm, &bits);
+                elapsed += os_monotonic_usec() - start;
+                speex_bits_reset(&bits);
+            }
+            if (elapsed/GENIE_SPEEX_CALIBRATE_FRAMES < frameUs)
+                frameUs = elapsed/GENIE_SPEEX_CALIBRATE_FRAMES;
+        }
+        OS_LOGD(TAG, "Speex complexity %d: %luus per frame", (int)c, frameUs);
+        if (c > GENIE_SPEEX_COMPLEXITY_MIN && frameUs > budgetUs)
+            break;
+        complexity = c;
+        costUs = frameUs;
+    }
+
+    speex_bits_destroy(&bits);
+    speex_encoder_destroy(encoder);
+    OS_LOGI(TAG, "Speex complexity %d, %luus per frame, budget %luus", complexity, costUs, budgetUs);
+    return complexity;
+}
+
 static bool GnRecorder_SpeexOgg_Init()
 {
-    spx_int32_t complexity = GENIE_SPEEX_COMPLEXITY;
+    spx_int32_t complexity = sGnRecorder.speexComplexity;
     spx_int32_t quality = GENIE_SPEEX_QULITY;
     spx_int32_t rate = GENIE_RECORDER_SAMPLE_RATE;
     spx_int32_t channels = GENIE_RECORDER_CHANNEL_COUNT;
@@ -302,6 +385,10 @@ static void GnRecorder_SpeexOgg_EncodeStream(bool final)
 static void *GnRecorder_Thread_Entry(void *arg)
 {
     OS_LOGD(TAG, "GenieRecorder thread enter");
+#if defined(GENIE_HAVE_SPEEXOGG_ENABLED)
+    if (sGnRecorder.speexComplexity == 0)
+        sGnRecorder.speexComplexity = GnRecorder_SpeexOgg_Calibrate();
+#endif
     while (sGnRecorder.isThreadRunning) {
         os_mutex_lock(sGnRecorder.stateLock);
         while (sGnRecorder.isThreadRunning && !sGnRecorder.isRecording)
@@ -0,0 +1,178 @@
+// Copyright (c) 2019-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cutils/memory_helper.h"
+#include "cutils/log_helper.h"
+#include "source_mmap_wrapper.h"
+
+#define TAG "[liteplayer]mmap"
+
+// Ask kernel to prefetch this many bytes ahead of the read position,
+// refreshed every half window
+#define MMAP_READAHEAD_WINDOW   ( 1024*256 )
+
+struct mmap_priv {
+    int fd;
+    char *base;
+    long map_len;               // length mapped at open, content_len only shrinks below it
+    long content_pos;
+    long content_len;
+    long readahead_pos;
+};
+
+// A file truncated while mapped raises SIGBUS on the pages past its new end. Clamp to
+// the current file size before every access to the mapping instead of catching it
+static void mmap_wrapper_clamp(struct mmap_priv *priv)
+{
+    struct stat st;
+    if (fstat(priv->fd, &st) != 0 || (long)st.st_size >= priv->content_len)
+        return;
+    OS_LOGW(TAG, "File shrank while mapped: %ld>>%ld", priv->content_len, (long)st.st_size);
+    priv->content_len = (long)st.st_size;
+    if (priv->content_pos > priv->content_len)
+        priv->content_pos = priv->content_len;
+}
+
+static void mmap_wrapper_readahead(struct mmap_priv *priv)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    long start = priv->content_pos & ~(page - 1);
+    long len = MMAP_READAHEAD_WINDOW;
+    if (start >= priv->content_len)
+        return;
+    if (start + len > priv->content_len)
+        len = priv->content_len - start;
+    madvise(priv->base + start, len, MADV_WILLNEED);
+    priv->readahead_pos = priv->content_pos + MMAP_READAHEAD_WINDOW/2;
+}
+
+const char *mmap_wrapper_url_protocol()
+{
+    return "file";
+}
+
+source_handle_t mmap_wrapper_open(const char *url, long long content_pos, void *priv_data)
+{
+    struct mmap_priv *priv = OS_CALLOC(1, sizeof(struct mmap_priv));
+    struct stat st;
+    int fd = -1;
+
+    if (priv == NULL)
+        return NULL;
+
+    OS_LOGD(TAG, "Opening file:%s, content_pos:%d", url, (int)content_pos);
+
+    fd = open(url, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        OS_LOGE(TAG, "Failed to open file:%s", url);
+        goto open_fail;
+    }
+
+    priv->content_len = (long)st.st_size;
+    if (priv->content_len > 0) {
+        priv->base = mmap(NULL, priv->content_len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (priv->base == MAP_FAILED) {
+            OS_LOGE(TAG, "Failed to map file:%s", url);
+            priv->base = NULL;
+            goto open_fail;
+        }
+        madvise(priv->base, priv->content_len, MADV_SEQUENTIAL);
+        priv->map_len = priv->content_len;
+    }
+    priv->fd = fd;
+
+    priv->content_pos = (long)content_pos;
+    if (priv->content_pos > priv->content_len)
+        priv->content_pos = priv->content_len;
+    if (priv->base != NULL)
+        mmap_wrapper_readahead(priv);
+    return priv;
+
+open_fail:
+    if (fd >= 0)
+        close(fd);
+    OS_FREE(priv);
+    return NULL;
+}
+
+int mmap_wrapper_read(source_handle_t handle, char *buffer, int size)
+{
+    struct mmap_priv *priv = (struct mmap_priv *)handle;
+    mmap_wrapper_clamp(priv);
+    if (priv->content_pos + size > priv->content_len)
+        size = priv->content_len - priv->content_pos;
+    if (size > 0) {
+        memcpy(buffer, priv->base + priv->content_pos, size);
+        priv->content_pos += size;
+        if (priv->content_pos >= priv->readahead_pos)
+            mmap_wrapper_readahead(priv);
+    } else {
+        OS_LOGD(TAG, "file read done: %d/%d", (int)priv->content_pos, (int)priv->content_len);
+        size = 0;
+    }
+    return size;
+}
+
+int mmap_wrapper_peek(source_handle_t handle, char **buffer, int size)
+{
+    struct mmap_priv *priv = (struct mmap_priv *)handle;
+    mmap_wrapper_clamp(priv);
+    if (priv->content_pos + size > priv->content_len)
+        size = priv->content_len - priv->content_pos;
+    if (size <= 0)
+        return 0;
+    *buffer = priv->base + priv->content_pos;
+    return size;
+}
+
+long long mmap_wrapper_content_pos(source_handle_t handle)
+{
+    struct mmap_priv *priv = (struct mmap_priv *)handle;
+    return priv->content_pos;
+}
+
+long long mmap_wrapper_content_len(source_handle_t handle)
+{
+    struct mmap_priv *priv = (struct mmap_priv *)handle;
+    return priv->content_len;
+}
+
+int mmap_wrapper_seek(source_handle_t handle, long offset)
+{
+    struct mmap_priv *priv = (struct mmap_priv *)handle;
+    OS_LOGD(TAG, "Seeking file: %ld>>%ld", priv->content_pos, offset);
+    if (offset < 0 || offset > priv->content_len)
+        return -1;
+    priv->content_pos = offset;
+    if (priv->base != NULL)
+        mmap_wrapper_readahead(priv);
+    return 0;
+}
+
+void mmap_wrapper_close(source_handle_t handle)
+{
+    struct mmap_priv *priv = (struct mmap_priv *)handle;
+    OS_LOGD(TAG, "Closing file:%p", priv->base);
+    if (priv->base != NULL)
+        munmap(priv->base, priv->map_len);
+    close(priv->fd);
+    OS_FREE(priv);
+}
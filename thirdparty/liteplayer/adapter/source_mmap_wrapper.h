@@ -0,0 +1,54 @@
+// Copyright (c) 2019-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _LITEPLAYER_ADAPTER_MMAP_WRAPPER_H_
+#define _LITEPLAYER_ADAPTER_MMAP_WRAPPER_H_
+
+#include "liteplayer_adapter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Local file source backed by mmap, for Linux/Android/macOS. Read is a memcpy
+// from page cache, seek is a pointer move, and peek exposes the mapping directly.
+// The pointer peek hands out stays valid until the next read/seek/close of the handle.
+//
+// Meant for files nobody writes while they play. Every read and peek checks the file
+// size first and ends playback at the new end of a file truncated while mapped, but a
+// truncation racing with a copy out of the mapping still raises SIGBUS. A file rewritten
+// in place plays mixed old and new content, use file_wrapper for files that are still
+// being downloaded.
+
+const char *mmap_wrapper_url_protocol();
+
+source_handle_t mmap_wrapper_open(const char *url, long long content_pos, void *priv_data);
+
+int mmap_wrapper_read(source_handle_t handle, char *buffer, int size);
+
+int mmap_wrapper_peek(source_handle_t handle, char **buffer, int size);
+
+long long mmap_wrapper_content_pos(source_handle_t handle);
+
+long long mmap_wrapper_content_len(source_handle_t handle);
+
+int mmap_wrapper_seek(source_handle_t handle, long offset);
+
+void mmap_wrapper_close(source_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _LITEPLAYER_ADAPTER_MMAP_WRAPPER_H_
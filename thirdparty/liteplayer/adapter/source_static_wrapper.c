@@ -70,6 +70,17 @@ int static_wrapper_read(source_handle_t handle, char *buffer, int size)
     return size;
 }
 
+int static_wrapper_peek(source_handle_t handle, char **buffer, int size)
+{
+    struct static_priv *priv = (struct static_priv *)handle;
+    if (priv->content_offset + size > priv->content_length)
+        size = priv->content_length - priv->content_offset;
+    if (size <= 0)
+        return 0;
+    *buffer = priv->content_base+priv->content_offset;
+    return size;
+}
+
 long long static_wrapper_content_pos(source_handle_t handle)
 {
     struct static_priv *priv = (struct static_priv *)handle;
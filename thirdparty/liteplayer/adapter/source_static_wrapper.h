@@ -27,6 +27,8 @@ source_handle_t static_wrapper_open(const char *url, long long content_pos, void
 
 int static_wrapper_read(source_handle_t handle, char *buffer, int size);
 
+int static_wrapper_peek(source_handle_t handle, char **buffer, int size);
+
 long long static_wrapper_content_pos(source_handle_t handle);
 
 long long static_wrapper_content_len(source_handle_t handle);
@@ -0,0 +1,338 @@
+// Copyright (c) 2019-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the pvaac kernel sets (C reference, SSE2 or NEON): every kernel is fed
+// random input and checked bit-exact against the C reference, then timed per set and
+// scaled to a real-time factor of HE-AAC stereo at 48kHz (24kHz core). Each ADTS file
+// given is decoded once per set, the pcm checksums must be the same.
+//
+//   aac_bench [ADTS_FILE...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "osal/os_time.h"
+#include "cutils/log_helper.h"
+#include "pvmp4audiodecoder_api.h"
+#include "fxp_simd.h"
+#include "fft_rx4.h"
+#include "imdct_fxp.h"
+
+#define TAG "aac_bench"
+
+#define FUZZ_ROUNDS         1000
+#define ADTS_INPUT_SIZE     (8 * 1024)
+#define MAX_KERNEL_SETS     4
+
+// Input and output of all kernels, a kernel only touches its own fields
+typedef struct {
+    Int16 V[1280];              // synfilterbank window
+    Int16 timeSig[128];
+    Int16 X[320];               // anafilterbank window, X[-320..-1]
+    Int32 Y[64];
+    Int32 qmf[4][13];           // two_ch_filtering_x2
+    Int32 hybrid_r[4];
+    Int32 hybrid_i[4];
+    Int32 fft[2 * FFT_RX4_LONG];
+    Int32 fft_peak;
+    Int32 quant[LONG_WINDOW_TYPE / 2];
+    Int32 quant_peak;
+    Int n;                      // 2048 long or 256 short window
+    Int shift1;
+} bench_state_t;
+
+typedef struct {
+    const char *name;
+    // HE-AAC stereo, 48kHz output from a 24kHz core
+    double calls_per_sec;
+    int loops;
+    void (*call)(const SIMD_KERNELS *set, bench_state_t *state);
+} bench_kernel_t;
+
+static bench_state_t sInput;
+static bench_state_t sWork;
+static bench_state_t sReference;
+
+static Int32 bench_rand32()
+{
+    return (Int32)(((unsigned int)rand() << 16) ^ (unsigned int)rand());
+}
+
+static void bench_fill(bench_state_t *state)
+{
+    memset(state, 0, sizeof(*state));
+    for (int i = 0; i < 1280; i++)
+        state->V[i] = (Int16)bench_rand32();
+    for (int i = 0; i < 320; i++)
+        state->X[i] = (Int16)bench_rand32();
+    for (int i = 0; i < 4; i++) {
+        for (int k = 0; k < 13; k++)
+            state->qmf[i][k] = bench_rand32() >> 2;
+    }
+    // the FFT input comes in with headroom, the pre-rotation input is normalized by shift1
+    for (int i = 0; i < 2 * FFT_RX4_LONG; i++)
+        state->fft[i] = bench_rand32() >> 8;
+    for (int i = 0; i < LONG_WINDOW_TYPE / 2; i++)
+        state->quant[i] = bench_rand32() >> 12;
+    state->n = (rand() & 1) ? LONG_WINDOW_TYPE : SHORT_WINDOW_TYPE;
+    state->shift1 = rand() % 12 - 1;
+}
+
+static void call_synfilterbank(const SIMD_KERNELS *set, bench_state_t *state)
+{
+    set->synfilterbank_window(state->timeSig, state->V);
+}
+
+static void call_anafilterbank(const SIMD_KERNELS *set, bench_state_t *state)
+{
+    set->anafilterbank_window(state->Y, &state->X[320], true);
+    state->Y[32] = 0;   // the caller's, some sets write it
+}
+
+static void call_two_ch_filtering(const SIMD_KERNELS *set, bench_state_t *state)
+{
+    set->two_ch_filtering_x2(state->qmf[0], state->qmf[1], state->qmf[2], state->qmf[3],
+                             state->hybrid_r, state->hybrid_i);
+}
+
+static void call_fft_rx4_long(const SIMD_KERNELS *set, bench_state_t *state)
+{
+    set->fft_rx4_long(state->fft, &state->fft_peak);
+}
+
+static void call_imdct_pre_rotation(const SIMD_KERNELS *set, bench_state_t *state)
+{
+    const Int32 *rotate = state->n == LONG_WINDOW_TYPE ? exp_rotation_N_2048 : exp_rotation_N_256;
+    state->quant_peak = set->imdct_pre_rotation(state->quant, rotate, state->n, state->shift1);
+}
+
+static const bench_kernel_t sKernels[] = {
+    // 2 channels * 48000/64 QMF slots
+    { "synfilterbank window", 2 * 48000.0 / 64, 200000, call_synfilterbank },
+    // 2 channels * 24000/32 QMF slots
+    { "anafilterbank window", 2 * 24000.0 / 32, 200000, call_anafilterbank },
+    // PS: 1 channel * 24000/32 slots, both 2-band filters at once
+    { "two_ch_filtering x2",  24000.0 / 32,     5000000, call_two_ch_filtering },
+    // 2 channels * 24000/1024 long blocks, 2 calls per 2048-point IMDCT
+    { "fft_rx4_long",         2 * 2 * 24000.0 / 1024, 20000, call_fft_rx4_long },
+    // 2 channels * 24000/1024 long blocks
+    { "imdct pre-rotation",   2 * 24000.0 / 1024, 50000, call_imdct_pre_rotation },
+};
+
+#define NUM_KERNELS (int)(sizeof(sKernels) / sizeof(sKernels[0]))
+
+static unsigned int bench_fnv1a(unsigned int hash, const void *data, int size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    while (size-- > 0) {
+        hash ^= *p++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+// Kernel sets built in and supported by this CPU, the C reference first
+static int bench_kernel_sets(const SIMD_KERNELS **sets)
+{
+    int count = 0;
+    for (int i = 0; count < MAX_KERNEL_SETS; i++) {
+        const SIMD_KERNELS *set = pv_simd_kernels(i);
+        if (set == NULL)
+            break;
+        if (pv_simd_select(set->name) == 0)
+            sets[count++] = set;
+    }
+    pv_simd_select(NULL);
+    return count;
+}
+
+static int bench_kernels(const SIMD_KERNELS **sets, int num_sets)
+{
+    double rtf[MAX_KERNEL_SETS] = { 0 };
+    int ret = 0;
+
+    for (int k = 0; k < NUM_KERNELS; k++) {
+        const bench_kernel_t *kernel = &sKernels[k];
+        bool exact[MAX_KERNEL_SETS];
+
+        srand(0x5eed + k);
+        for (int s = 0; s < num_sets; s++)
+            exact[s] = true;
+        for (int round = 0; round < FUZZ_ROUNDS; round++) {
+            bench_fill(&sInput);
+            memcpy(&sReference, &sInput, sizeof(sInput));
+            kernel->call(sets[0], &sReference);
+            for (int s = 1; s < num_sets; s++) {
+                memcpy(&sWork, &sInput, sizeof(sInput));
+                kernel->call(sets[s], &sWork);
+                if (exact[s] && memcmp(&sWork, &sReference, sizeof(sWork)) != 0) {
+                    OS_LOGE(TAG, "%s [%s]: output mismatch at round %d",
+                            kernel->name, sets[s]->name, round);
+                    exact[s] = false;
+                    ret = -1;
+                }
+            }
+        }
+
+        for (int s = 0; s < num_sets; s++) {
+            // in-place kernels run on their own output, the timing doesn't depend on the data
+            memcpy(&sWork, &sInput, sizeof(sInput));
+            sWork.n = LONG_WINDOW_TYPE;
+            // warm up caches and clocks, the first set timed would pay for it otherwise
+            for (int i = 0; i < kernel->loops / 4; i++)
+                kernel->call(sets[s], &sWork);
+            unsigned long long start = os_monotonic_usec();
+            for (int i = 0; i < kernel->loops; i++)
+                kernel->call(sets[s], &sWork);
+            unsigned long long cost = os_monotonic_usec() - start;
+
+            double ns = cost * 1000.0 / kernel->loops;
+            double kernel_rtf = ns * 1e-9 * kernel->calls_per_sec;
+            rtf[s] += kernel_rtf;
+            OS_LOGI(TAG, "%s [%s]: %.1f ns/call, rtf=%.6f%s", kernel->name, sets[s]->name,
+                    ns, kernel_rtf, s == 0 ? "" : (exact[s] ? ", bit-exact" : ", MISMATCH"));
+        }
+    }
+
+    for (int s = 0; s < num_sets; s++)
+        OS_LOGI(TAG, "kernels [%s]: rtf=%.6f, %.2fx the C reference", sets[s]->name,
+                rtf[s], rtf[s] > 0 ? rtf[0] / rtf[s] : 0.0);
+    return ret;
+}
+
+static int bench_adts_decode(const char *filename, const char *set_name, unsigned int *checksum)
+{
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        OS_LOGE(TAG, "Failed to open %s", filename);
+        return -1;
+    }
+
+    tPVMP4AudioDecoderExternal config;
+    memset(&config, 0, sizeof(config));
+    config.outputFormat = OUTPUTFORMAT_16PCM_INTERLEAVED;
+    config.aacPlusEnabled = 1;
+    config.desiredChannels = 2;
+
+    void *decoder = malloc(PVMP4AudioDecoderGetMemRequirements());
+    unsigned char *in = malloc(ADTS_INPUT_SIZE);
+    short *out = malloc(4096 * 2 * sizeof(short));
+    if (decoder == NULL || in == NULL || out == NULL ||
+        PVMP4AudioDecoderInitLibrary(&config, decoder) != MP4AUDEC_SUCCESS) {
+        OS_LOGE(TAG, "Failed to init pvaac decoder");
+        free(decoder);
+        free(in);
+        free(out);
+        fclose(file);
+        return -1;
+    }
+
+    unsigned long long decode_usec = 0;
+    unsigned long long samples = 0;
+    int frames = 0, errors = 0;
+    int remain = 0;
+    bool eof = false;
+
+    *checksum = 2166136261U;
+    while (!eof || remain > 0) {
+        if (!eof && remain < ADTS_INPUT_SIZE) {
+            int ret = fread(&in[remain], 1, ADTS_INPUT_SIZE - remain, file);
+            if (ret <= 0)
+                eof = true;
+            else
+                remain += ret;
+        }
+
+        config.pInputBuffer = in;
+        config.inputBufferCurrentLength = remain;
+        config.inputBufferMaxLength = 0;
+        config.inputBufferUsedLength = 0;
+        config.remainderBits = 0;
+        config.pOutputBuffer = out;
+        config.pOutputBuffer_plus = &out[2048];
+        config.repositionFlag = false;
+
+        unsigned long long start = os_monotonic_usec();
+        int ret = PVMP4AudioDecodeFrame(&config, decoder);
+        decode_usec += os_monotonic_usec() - start;
+
+        if (ret == MP4AUDEC_INCOMPLETE_FRAME) {
+            if (eof)
+                break;
+            continue;
+        } else if (ret != MP4AUDEC_SUCCESS) {
+            // skip one byte to resync
+            config.inputBufferUsedLength = 1;
+            if (++errors > 16) {
+                OS_LOGE(TAG, "Too many decode errors, abort");
+                break;
+            }
+        } else {
+            int size = config.frameLength * config.desiredChannels * sizeof(short);
+            *checksum = bench_fnv1a(*checksum, out, size);
+            samples += config.frameLength;
+            frames++;
+        }
+
+        remain -= config.inputBufferUsedLength;
+        if (remain > 0)
+            memmove(in, &in[config.inputBufferUsedLength], remain);
+    }
+
+    bool decoded = frames > 0 && config.samplingRate > 0;
+    if (decoded) {
+        double duration = (double)samples / config.samplingRate;
+        OS_LOGI(TAG, "%s [%s]: %d frames, %d Hz, %.2f s audio, %.3f s decode, rtf=%.4f, pcm fnv1a=%08x",
+                filename, set_name, frames, (int)config.samplingRate, duration,
+                decode_usec * 1e-6, decode_usec * 1e-6 / duration, *checksum);
+    } else {
+        OS_LOGE(TAG, "No frame decoded from %s", filename);
+    }
+
+    free(decoder);
+    free(in);
+    free(out);
+    fclose(file);
+    return decoded ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    const SIMD_KERNELS *sets[MAX_KERNEL_SETS];
+    int num_sets = bench_kernel_sets(sets);
+    int ret = bench_kernels(sets, num_sets);
+
+    // the same stream decoded with every set must give the same pcm
+    for (int i = 1; i < argc; i++) {
+        unsigned int reference = 0;
+        for (int s = 0; s < num_sets; s++) {
+            unsigned int checksum = 0;
+            pv_simd_select(sets[s]->name);
+            if (bench_adts_decode(argv[i], sets[s]->name, &checksum) != 0) {
+                ret = -1;
+                break;
+            }
+            if (s == 0) {
+                reference = checksum;
+            } else if (checksum != reference) {
+                OS_LOGE(TAG, "%s [%s]: pcm differs from the C reference", argv[i], sets[s]->name);
+                ret = -1;
+            }
+        }
+    }
+    pv_simd_select(NULL);
+    return ret == 0 ? 0 : 1;
+}
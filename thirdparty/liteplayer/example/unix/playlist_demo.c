@@ -25,7 +25,7 @@
 #include "cutils/log_helper.h"
 #include "liteplayer_listplayer.h"
 #include "source_httpclient_wrapper.h"
-#include "source_file_wrapper.h"
+#include "source_mmap_wrapper.h"
 #if defined(HAVE_LINUX_ALSA_ENABLED)
 #include "sink_alsa_wrapper.h"
 #elif defined(HAVE_PORT_AUDIO_ENABLED)
@@ -178,13 +178,14 @@ static void *playlist_demo_thread(void *arg)
         .async_mode = false,
         .buffer_size = 2*1024,
         .priv_data = NULL,
-        .url_protocol = file_wrapper_url_protocol,
-        .open = file_wrapper_open,
-        .read = file_wrapper_read,
-        .content_pos = file_wrapper_content_pos,
-        .content_len = file_wrapper_content_len,
-        .seek = file_wrapper_seek,
-        .close = file_wrapper_close,
+        .url_protocol = mmap_wrapper_url_protocol,
+        .open = mmap_wrapper_open,
+        .read = mmap_wrapper_read,
+        .peek = mmap_wrapper_peek,
+        .content_pos = mmap_wrapper_content_pos,
+        .content_len = mmap_wrapper_content_len,
+        .seek = mmap_wrapper_seek,
+        .close = mmap_wrapper_close,
     };
     listplayer_register_source_wrapper(demo->player_handle, &file_ops);
 
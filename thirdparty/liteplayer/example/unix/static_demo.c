@@ -612,6 +612,7 @@ static int static_demo(const char *url)
         .url_protocol = static_wrapper_url_protocol,
         .open = static_wrapper_open,
         .read = static_wrapper_read,
+        .peek = static_wrapper_peek,
         .content_pos = static_wrapper_content_pos,
         .content_len = static_wrapper_content_len,
         .seek = static_wrapper_seek,
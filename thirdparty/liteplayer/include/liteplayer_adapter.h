@@ -31,6 +31,7 @@ struct source_wrapper {
     const char *    (*url_protocol)(); // "http", "tts", "rtsp", "rtmp", "file"
     source_handle_t (*open)(const char *url, long long content_pos, void *priv_data);
     int             (*read)(source_handle_t handle, char *buffer, int size);//note: 0<=ret<size means eof
+    int             (*peek)(source_handle_t handle, char **buffer, int size);//optional: data at content_pos in place, valid until next read/seek/close, for memory-backed source
     long long       (*content_pos)(source_handle_t handle);
     long long       (*content_len)(source_handle_t handle);
     int             (*seek)(source_handle_t handle, long offset);
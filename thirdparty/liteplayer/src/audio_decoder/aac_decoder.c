@@ -41,6 +41,8 @@ static esp_err_t aac_decoder_open(audio_element_handle_t self)
     esp_err_t err = ESP_OK;
     aac_decoder_handle_t decoder = (aac_decoder_handle_t)audio_element_getdata(self);
 
+    // Seek before open inits the wrapper already, check the input type anyway
+    decoder->zero_copy = audio_element_get_input_ringbuf(self) != NULL;
     if (decoder->handle != NULL) {
         OS_LOGD(TAG, "AAC decoder already opened");
         return ESP_OK;
@@ -64,6 +66,8 @@ static esp_err_t aac_decoder_close(audio_element_handle_t self)
 
         memset(&decoder->buf_in, 0x0, sizeof(decoder->buf_in));
         memset(&decoder->buf_out, 0x0, sizeof(decoder->buf_out));
+        decoder->frame_base = decoder->buf_in.data;
+        decoder->frame_blocks = 0;
         decoder->handle = NULL;
         decoder->parsed_header = false;
 
@@ -132,6 +136,8 @@ static esp_err_t aac_decoder_seek(audio_element_handle_t self, long long offset)
 
     memset(&decoder->buf_in, 0x0, sizeof(decoder->buf_in));
     memset(&decoder->buf_out, 0x0, sizeof(decoder->buf_out));
+    decoder->frame_base = decoder->buf_in.data;
+    decoder->frame_blocks = 0;
     decoder->seek_mode = true;
     return ESP_OK;
 }
@@ -160,6 +166,7 @@ audio_element_handle_t aac_decoder_init(struct aac_decoder_cfg *config)
     AUDIO_MEM_CHECK(TAG, el, goto aac_init_error);
     decoder->aac_info = config->aac_info;
     decoder->el = el;
+    decoder->frame_base = decoder->buf_in.data;
     audio_element_setdata(el, decoder);
 
     audio_element_set_input_timeout(el, AAC_DECODER_INPUT_TIMEOUT_MAX);
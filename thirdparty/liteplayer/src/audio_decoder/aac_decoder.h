@@ -78,6 +78,9 @@ struct aac_decoder {
     struct aac_buf_in       buf_in;
     struct aac_buf_out      buf_out;
     struct aac_info        *aac_info;
+    char                   *frame_base;    // buf_in.data, or input ringbuf memory if zero_copy
+    int                     frame_blocks;  // raw data blocks of the frame at frame_base left to decode
+    bool                    zero_copy;     // decode ADTS frames in place from input ringbuf
     bool                    parsed_header;
     bool                    seek_mode;
 };
@@ -25,6 +25,8 @@
 
 #define TAG "[liteplayer]aac_decoder"
 
+#define ADTS_HEADER_SIZE    (7)
+
 struct pvaac_wrapper {
     tPVMP4AudioDecoderExternal pvaac_config;
     void *pvaac_buffer;
@@ -55,6 +57,115 @@ static int aac_adts_read(aac_decoder_handle_t decoder)
     return ret;
 }
 
+static int aac_input_status(aac_decoder_handle_t decoder, int ret)
+{
+    if (ret == AEL_IO_TIMEOUT) {
+        return AEL_IO_TIMEOUT;
+    } else if (ret == AEL_IO_OK || ret == AEL_IO_DONE || ret == AEL_IO_ABORT) {
+        decoder->buf_in.eof = true;
+        return AEL_IO_DONE;
+    } else {
+        OS_LOGE(TAG, "AAC peek fail, ret=%d", ret);
+        return AEL_IO_FAIL;
+    }
+}
+
+// Length of the ADTS frame whose header is at buf, 0 if buf isn't at a header
+static int aac_adts_frame_size(const unsigned char *buf)
+{
+    if (buf[0] != 0xFF || (buf[1] & 0xF6) != 0xF0) // syncword, layer 0
+        return 0;
+    int header_size = (buf[1] & 0x01) ? ADTS_HEADER_SIZE : ADTS_HEADER_SIZE + 2;
+    int frame_size = ((buf[3] & 0x03) << 11) | (buf[4] << 3) | (buf[5] >> 5);
+    return frame_size > header_size ? frame_size : 0;
+}
+
+// The frame at read position wraps around the end of a ringbuf not mirrored, copy it to
+// buf_in. Leave frame_blocks 0 if the bytes copied turn out not to be a frame header
+static int aac_adts_copy(aac_decoder_handle_t decoder)
+{
+    struct aac_buf_in *in = &decoder->buf_in;
+    char *data = NULL;
+    int frame_size, ret;
+
+    // Wait until a buf_in worth of data is filled, so the chunk reads below don't block
+    ret = audio_element_input_peek(decoder->el, &data, AAC_DECODER_INPUT_BUFFER_SIZE);
+    if (ret <= 0)
+        return aac_input_status(decoder, ret);
+
+    ret = audio_element_input_chunk(decoder->el, in->data, ADTS_HEADER_SIZE);
+    if (ret != ADTS_HEADER_SIZE)
+        return aac_input_status(decoder, ret > 0 ? AEL_IO_DONE : ret);
+    frame_size = aac_adts_frame_size((unsigned char *)in->data);
+    if (frame_size == 0)
+        return AEL_IO_OK;
+    if (frame_size > AAC_DECODER_INPUT_BUFFER_SIZE) {
+        OS_LOGW(TAG, "Drop ADTS frame too large to copy: %d", frame_size);
+        return AEL_IO_OK;
+    }
+
+    ret = audio_element_input_chunk(decoder->el, &in->data[ADTS_HEADER_SIZE], frame_size - ADTS_HEADER_SIZE);
+    if (ret != frame_size - ADTS_HEADER_SIZE)
+        return aac_input_status(decoder, ret > 0 ? AEL_IO_DONE : ret);
+    decoder->frame_base = in->data;
+    decoder->frame_blocks = (in->data[6] & 0x03) + 1;
+    in->bytes_read = frame_size;
+    return AEL_IO_OK;
+}
+
+// Peek the next ADTS frame whole from input ringbuf to decode it in place, skipping
+// the bytes before its header, e.g. after seeking
+static int aac_adts_peek(aac_decoder_handle_t decoder)
+{
+    ringbuf_handle rb = audio_element_get_input_ringbuf(decoder->el);
+    struct aac_buf_in *in = &decoder->buf_in;
+    char *data = NULL;
+    int frame_size = 0;
+    int skip, ret;
+
+    while (true) {
+        ret = audio_element_input_peek(decoder->el, &data, ADTS_HEADER_SIZE);
+        if (ret <= 0)
+            return aac_input_status(decoder, ret);
+
+        if (ret == ADTS_HEADER_SIZE) {
+            frame_size = aac_adts_frame_size((unsigned char *)data);
+            if (frame_size == 0) {
+                ret = audio_element_input_peek(decoder->el, &data, AAC_DECODER_INPUT_BUFFER_SIZE);
+                if (ret <= 0)
+                    return aac_input_status(decoder, ret);
+                for (skip = 1; skip < ret - 1; skip++) {
+                    if ((data[skip] & 0xFF) == 0xFF && (data[skip + 1] & 0xF6) == 0xF0)
+                        break;
+                }
+                OS_LOGD(TAG, "Skip %d bytes to ADTS syncword", skip);
+                audio_element_input_consume(decoder->el, skip);
+                continue;
+            }
+
+            ret = audio_element_input_peek(decoder->el, &data, frame_size);
+            if (ret <= 0)
+                return aac_input_status(decoder, ret);
+            if (ret == frame_size) {
+                decoder->frame_base = data;
+                decoder->frame_blocks = (data[6] & 0x03) + 1;
+                in->bytes_read = frame_size;
+                return AEL_IO_OK;
+            }
+        } else {
+            frame_size = ADTS_HEADER_SIZE;
+        }
+
+        // Short of a whole header or frame: the stream ends in it, or it wraps around
+        // the end of a ringbuf not mirrored
+        if (rb_bytes_filled(rb) < frame_size)
+            return aac_input_status(decoder, AEL_IO_DONE);
+        ret = aac_adts_copy(decoder);
+        if (ret != AEL_IO_OK || decoder->frame_blocks > 0)
+            return ret;
+    }
+}
+
 int aac_wrapper_run(aac_decoder_handle_t decoder)
 {
     int ret = 0;
@@ -62,7 +173,17 @@ int aac_wrapper_run(aac_decoder_handle_t decoder)
     struct pvaac_wrapper *wrap = (struct pvaac_wrapper *)decoder->handle;
 
 fill_data:
-    ret = aac_adts_read(decoder);
+    if (!decoder->zero_copy) {
+        ret = aac_adts_read(decoder);
+        wrap->pvaac_config.inputBufferUsedLength = 0;
+        wrap->pvaac_config.remainderBits = 0;
+    } else if (decoder->frame_blocks == 0) {
+        // Frames are decoded whole, a frame of several raw data blocks is kept
+        // in place with the decoded position until its last block
+        ret = aac_adts_peek(decoder);
+        wrap->pvaac_config.inputBufferUsedLength = 0;
+        wrap->pvaac_config.remainderBits = 0;
+    }
     if (ret != AEL_IO_OK) {
         if (decoder->buf_in.eof) {
             OS_LOGV(TAG, "AAC frame end");
@@ -71,16 +192,21 @@ fill_data:
         return ret;
     }
 
-    wrap->pvaac_config.pInputBuffer = (unsigned char *)(decoder->buf_in.data);
+    wrap->pvaac_config.pInputBuffer = (unsigned char *)(decoder->frame_base);
     wrap->pvaac_config.inputBufferCurrentLength = decoder->buf_in.bytes_read;
     wrap->pvaac_config.inputBufferMaxLength = 0;
-    wrap->pvaac_config.inputBufferUsedLength = 0;
-    wrap->pvaac_config.remainderBits = 0;
     wrap->pvaac_config.pOutputBuffer = (short *)(decoder->buf_out.data);
     wrap->pvaac_config.pOutputBuffer_plus = &(wrap->pvaac_config.pOutputBuffer[2048]);
     wrap->pvaac_config.repositionFlag = false;
     ret = PVMP4AudioDecodeFrame(&wrap->pvaac_config, wrap->pvaac_buffer);
-    if (ret == MP4AUDEC_INCOMPLETE_FRAME) {
+    if (decoder->zero_copy && (ret != MP4AUDEC_SUCCESS || --decoder->frame_blocks == 0)) {
+        if (decoder->frame_base != decoder->buf_in.data)
+            audio_element_input_consume(decoder->el, decoder->buf_in.bytes_read);
+        decoder->frame_base = decoder->buf_in.data;
+        decoder->frame_blocks = 0;
+        decoder->buf_in.bytes_read = 0;
+    }
+    if (ret == MP4AUDEC_INCOMPLETE_FRAME && !decoder->zero_copy) {
         if (decoder->buf_in.eof)
             return AEL_IO_DONE;
         else
@@ -92,7 +218,8 @@ fill_data:
         goto fill_data;
     }
 
-    decoder->buf_in.bytes_read -= wrap->pvaac_config.inputBufferUsedLength;
+    if (!decoder->zero_copy)
+        decoder->buf_in.bytes_read -= wrap->pvaac_config.inputBufferUsedLength;
     decoder->buf_out.bytes_remain =
         wrap->pvaac_config.frameLength * sizeof(short) * wrap->pvaac_config.desiredChannels;
 
@@ -167,7 +294,19 @@ static int m4a_mdat_read(m4a_decoder_handle_t decoder)
     in->bytes_want = decoder->m4a_info->stsz_samplesize[stsz_current];
     in->bytes_read = 0;
 
-    ret = audio_element_input_chunk(decoder->el, in->data, in->bytes_want);
+    if (decoder->zero_copy) {
+        char *data = NULL;
+        ret = audio_element_input_peek(decoder->el, &data, in->bytes_want);
+        if (ret == in->bytes_want) {
+            decoder->frame_base = data;
+            in->bytes_read += ret;
+            goto read_done;
+        }
+    }
+
+    // Copy the sample if it wraps around the end of a ringbuf not mirrored
+    if (!decoder->zero_copy || ret > 0)
+        ret = audio_element_input_chunk(decoder->el, in->data, in->bytes_want);
     if (ret == in->bytes_want) {
         in->bytes_read += ret;
         goto read_done;
@@ -202,7 +341,7 @@ int m4a_wrapper_run(m4a_decoder_handle_t decoder)
         return ret;
     }
 
-    wrap->pvaac_config.pInputBuffer = (unsigned char *)(decoder->buf_in.data);
+    wrap->pvaac_config.pInputBuffer = (unsigned char *)(decoder->frame_base);
     wrap->pvaac_config.inputBufferCurrentLength = decoder->buf_in.bytes_read;
     wrap->pvaac_config.inputBufferMaxLength = 0;
     wrap->pvaac_config.inputBufferUsedLength = 0;
@@ -211,6 +350,10 @@ int m4a_wrapper_run(m4a_decoder_handle_t decoder)
     wrap->pvaac_config.pOutputBuffer_plus = &(wrap->pvaac_config.pOutputBuffer[2048]);
     wrap->pvaac_config.repositionFlag = false;
     ret = PVMP4AudioDecodeFrame(&wrap->pvaac_config, wrap->pvaac_buffer);
+    if (decoder->frame_base != decoder->buf_in.data) {
+        audio_element_input_consume(decoder->el, decoder->buf_in.bytes_read);
+        decoder->frame_base = decoder->buf_in.data;
+    }
     if (ret != MP4AUDEC_SUCCESS) {
         OS_LOGE(TAG, "AACDecode error[%d]", ret);
         return AEL_PROCESS_FAIL;
@@ -40,6 +40,8 @@ static esp_err_t m4a_decoder_open(audio_element_handle_t self)
     esp_err_t err = ESP_OK;
     m4a_decoder_handle_t decoder = (m4a_decoder_handle_t)audio_element_getdata(self);
 
+    // Seek before open inits the wrapper already, check the input type anyway
+    decoder->zero_copy = audio_element_get_input_ringbuf(self) != NULL;
     if (decoder->handle != NULL) {
         OS_LOGD(TAG, "M4A decoder already opened");
         return ESP_OK;
@@ -158,6 +160,7 @@ audio_element_handle_t m4a_decoder_init(struct m4a_decoder_cfg *config)
     AUDIO_MEM_CHECK(TAG, el, goto m4a_init_error);
     decoder->m4a_info = config->m4a_info;
     decoder->el = el;
+    decoder->frame_base = decoder->buf_in.data;
     audio_element_setdata(el, decoder);
 
     audio_element_set_input_timeout(el, M4A_DECODER_INPUT_TIMEOUT_MAX);
@@ -42,6 +42,8 @@ struct m4a_decoder {
     struct aac_buf_in       buf_in;
     struct aac_buf_out      buf_out;
     struct m4a_info        *m4a_info;
+    char                   *frame_base;    // buf_in.data, or input ringbuf memory if zero_copy
+    bool                    zero_copy;     // decode samples in place from input ringbuf
     bool                    parsed_header;
 };
 
@@ -39,6 +39,8 @@ static esp_err_t mp3_decoder_open(audio_element_handle_t self)
     esp_err_t status = ESP_OK;
     mp3_decoder_handle_t decoder = (mp3_decoder_handle_t)audio_element_getdata(self);
 
+    // Seek before open inits the wrapper already, check the input type anyway
+    decoder->zero_copy = audio_element_get_input_ringbuf(self) != NULL;
     if (decoder->handle != NULL) {
         OS_LOGD(TAG, "MP3 decoder already opened");
         return ESP_OK;
@@ -158,6 +160,7 @@ audio_element_handle_t mp3_decoder_init(struct mp3_decoder_cfg *config)
     AUDIO_MEM_CHECK(TAG, el, goto mp3_init_error);
     decoder->mp3_info = config->mp3_info;
     decoder->el = el;
+    decoder->frame_base = decoder->buf_in.data;
     audio_element_setdata(el, decoder);
     
     audio_element_info_t info = {0};
@@ -65,6 +65,8 @@ struct mp3_decoder {
     struct mp3_buf_in       buf_in;
     struct mp3_buf_out      buf_out;
     struct mp3_info        *mp3_info;
+    char                   *frame_base;    // buf_in.data, or input ringbuf memory if zero_copy
+    bool                    zero_copy;     // decode frames in place from input ringbuf
     bool                    parsed_header;
     bool                    seek_mode;
 };
@@ -144,6 +144,41 @@ finish:
     return found ? 0 : -1;
 }
 
+// Peek the next frame whole from input ringbuf to decode it in place. Leave frame_base
+// at buf_in.data if the frame wraps around the end of a ringbuf not mirrored, to copy it
+static int mp3_frame_peek(mp3_decoder_handle_t decoder)
+{
+    struct pvmp3_wrapper *wrap = (struct pvmp3_wrapper *)(decoder->handle);
+    struct mp3_buf_in *in = &decoder->buf_in;
+    char *data = NULL;
+
+    int ret = audio_element_input_peek(decoder->el, &data, 4);
+    if (ret == 4) {
+        wrap->frame_size = mp3_frame_size(data);
+        if (wrap->frame_size <= 0 || wrap->frame_size > MP3_DECODER_INPUT_BUFFER_SIZE) {
+            OS_LOGW(TAG, "MP3 demux dummy data, AEL_IO_DONE");
+            return AEL_IO_DONE;
+        }
+        ret = audio_element_input_peek(decoder->el, &data, wrap->frame_size);
+        if (ret == wrap->frame_size) {
+            decoder->frame_base = data;
+            in->bytes_read = wrap->frame_size;
+            return AEL_IO_OK;
+        }
+    }
+
+    if (ret > 0) {
+        return AEL_IO_OK;
+    } else if (ret == AEL_IO_TIMEOUT) {
+        return AEL_IO_TIMEOUT;
+    } else if (ret == AEL_IO_OK || ret == AEL_IO_DONE || ret == AEL_IO_ABORT) {
+        in->eof = true;
+        return AEL_IO_DONE;
+    } else {
+        return AEL_IO_FAIL;
+    }
+}
+
 static int mp3_data_read(mp3_decoder_handle_t decoder)
 {
     struct pvmp3_wrapper *wrap = (struct pvmp3_wrapper *)(decoder->handle);
@@ -241,6 +276,12 @@ static int mp3_data_read(mp3_decoder_handle_t decoder)
         return AEL_IO_OK;
     }
 
+    if (decoder->zero_copy && in->bytes_want == 0) {
+        ret = mp3_frame_peek(decoder);
+        if (ret != AEL_IO_OK || decoder->frame_base != in->data)
+            return ret;
+    }
+
     if (in->bytes_want > 0) {
         if (wrap->new_frame) {
             OS_LOGD(TAG, "Remain %d/4 bytes header needed to read", in->bytes_want);
@@ -320,11 +361,15 @@ int mp3_wrapper_run(mp3_decoder_handle_t decoder)
     wrap->pvmp3_config.inputBufferCurrentLength = decoder->buf_in.bytes_read;
     wrap->pvmp3_config.inputBufferMaxLength = MP3_DECODER_INPUT_BUFFER_SIZE;
     wrap->pvmp3_config.inputBufferUsedLength = 0;
-    wrap->pvmp3_config.pInputBuffer = (uint8 *)decoder->buf_in.data;
+    wrap->pvmp3_config.pInputBuffer = (uint8 *)decoder->frame_base;
     wrap->pvmp3_config.pOutputBuffer = (int16 *)decoder->buf_out.data;
     wrap->pvmp3_config.outputFrameSize = MP3_DECODER_OUTPUT_BUFFER_SIZE / sizeof(int16_t);
     wrap->pvmp3_config.crcEnabled = false;
     ERROR_CODE decoderErr = pvmp3_framedecoder(&wrap->pvmp3_config, wrap->pvmp3_buffer);
+    if (decoder->frame_base != decoder->buf_in.data) {
+        audio_element_input_consume(decoder->el, decoder->buf_in.bytes_read);
+        decoder->frame_base = decoder->buf_in.data;
+    }
     if (decoderErr != NO_DECODING_ERROR) {
         OS_LOGE(TAG, "PVMP3Decoder encountered error: %d", decoderErr);
         return AEL_PROCESS_FAIL;
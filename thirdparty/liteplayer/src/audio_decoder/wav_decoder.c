@@ -49,6 +49,8 @@ struct wav_decoder {
     drwav                   drwav;
     bool                    drwav_inited;
     int                     drwav_offset;
+    char                   *drwav_base;    // buf_in.data, or input ringbuf memory if zero_copy
+    bool                    zero_copy;     // decode in place from input ringbuf
     int                     block_align;
     struct wav_buf_in       buf_in;
     struct wav_buf_out      buf_out;
@@ -91,7 +93,7 @@ static size_t drwav_on_read(void *pUserData, void *pBufferOut, size_t bytesToRea
         bytesToRead = decoder->buf_in.bytes_read;
     }
     if (bytesToRead > 0) {
-        memcpy(pBufferOut, &decoder->buf_in.data[decoder->drwav_offset], bytesToRead);
+        memcpy(pBufferOut, &decoder->drwav_base[decoder->drwav_offset], bytesToRead);
         decoder->drwav_offset += bytesToRead;
         decoder->buf_in.bytes_read -= bytesToRead;
     }
@@ -152,6 +154,31 @@ static int drwav_run(wav_decoder_handle_t decoder)
         decoder->filled_header = true;
     }
 
+    if (decoder->zero_copy && in->bytes_read < decoder->block_align &&
+        (in->bytes_read == 0 || decoder->drwav_base != in->data)) {
+        // Release the blocks decoded in place last round, the partial block left
+        // is still in ringbuf and will be peeked again together with new data
+        if (decoder->drwav_base != in->data && decoder->drwav_offset > 0)
+            audio_element_input_consume(decoder->el, decoder->drwav_offset);
+        decoder->drwav_base = in->data;
+        decoder->drwav_offset = 0;
+        in->bytes_read = 0;
+
+        char *data = NULL;
+        ret = audio_element_input_peek(decoder->el, &data, prefered_insize);
+        if (ret >= decoder->block_align) {
+            decoder->drwav_base = data;
+            in->bytes_read = ret;
+        } else if (ret == AEL_IO_OK || ret == AEL_IO_DONE || ret == AEL_IO_ABORT) {
+            in->eof = true;
+            return AEL_IO_DONE;
+        } else if (ret < 0) {
+            OS_LOGW(TAG, "Peek chunk error: %d/%d", ret, (int)prefered_insize);
+            return ret;
+        }
+        // else a block wraps around the end of ringbuf, copy it out below
+    }
+
     if (in->bytes_read < decoder->block_align) {
         if (in->bytes_read > 0) {
             if (!decoder->read_timeout) {
@@ -314,6 +341,7 @@ static int wav_decoder_process(audio_element_handle_t self, char *in_buffer, int
 
     if (!decoder->drwav_inited) {
         ringbuf_handle rb = audio_element_get_input_ringbuf(self);
+        decoder->zero_copy = rb != NULL;
         if (rb != NULL) {
             // update prefered frames if the size of input ringbuf is too small
             int max_frames = rb_get_size(rb) / decoder->wav_info->blockAlign;
@@ -366,6 +394,7 @@ static esp_err_t wav_decoder_seek(audio_element_handle_t self, long long offset)
 {
     wav_decoder_handle_t decoder = (wav_decoder_handle_t)audio_element_getdata(self);
     decoder->drwav_offset = 0;
+    decoder->drwav_base = decoder->buf_in.data;
     decoder->read_timeout = false;
     decoder->buf_in.bytes_read = 0;
     decoder->buf_in.bytes_want = 0;
@@ -402,6 +431,7 @@ audio_element_handle_t wav_decoder_init(struct wav_decoder_cfg *config)
     decoder->buf_in.data = audio_malloc(decoder->buf_in.size);
     decoder->buf_out.data = audio_malloc(decoder->buf_out.size);
     AUDIO_MEM_CHECK(TAG, decoder->buf_in.data && decoder->buf_out.data, goto wav_init_error);
+    decoder->drwav_base = decoder->buf_in.data;
 
     audio_element_handle_t el = audio_element_init(&cfg);
     AUDIO_MEM_CHECK(TAG, el, goto wav_init_error);
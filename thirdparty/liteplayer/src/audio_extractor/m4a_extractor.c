@@ -859,6 +859,12 @@ int m4a_extractor(m4a_fetch_cb fetch_cb, void *fetch_priv, struct m4a_info *info
         .joinable = true,
     };
 
+    if (info->parsed_once && info->moov_tail) {
+        // Caller has located moov already, parse it directly
+        double_check = true;
+        offset = info->moov_offset;
+    }
+
 m4a_parse:
     tid = os_thread_create(&tattr, m4a_reader_parse_thread, &priv);
     if (tid == NULL) {
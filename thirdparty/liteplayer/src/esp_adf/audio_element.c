@@ -542,6 +542,49 @@ int audio_element_input_chunk(audio_element_handle_t el, char *buffer, int wante
     return in_len;
 }
 
+int audio_element_input_peek(audio_element_handle_t el, char **buffer, int wanted_size)
+{
+    int in_len = 0;
+    if (el->read_type != IO_TYPE_RB || el->in.input_rb == NULL) {
+        OS_LOGE(TAG, "[%s] Peek IO type ringbuf but ringbuf not set", el->tag);
+        return ESP_FAIL;
+    }
+    in_len = rb_peek_contiguous(el->in.input_rb, buffer, wanted_size, el->input_timeout_ms);
+    if (in_len <= 0) {
+        switch (in_len) {
+            case AEL_IO_ABORT:
+                OS_LOGW(TAG, "IN-[%s] AEL_IO_ABORT", el->tag);
+                audio_element_set_ringbuf_done(el);
+                audio_element_stop(el);
+                break;
+            case AEL_IO_DONE:
+            case AEL_IO_OK:
+                OS_LOGD(TAG, "IN-[%s] AEL_IO_DONE,%d", el->tag, in_len);
+                break;
+            case AEL_IO_FAIL:
+                OS_LOGE(TAG, "IN-[%s] AEL_STATUS_ERROR_INPUT", el->tag);
+                audio_element_report_status(el, AEL_STATUS_ERROR_INPUT);
+                audio_element_cmd_send(el, AEL_MSG_CMD_ERROR);
+                break;
+            case AEL_IO_TIMEOUT:
+                OS_LOGV(TAG, "IN-[%s] AEL_IO_TIMEOUT", el->tag);
+                break;
+            default:
+                OS_LOGE(TAG, "IN-[%s] Input return not support,ret:%d", el->tag, in_len);
+                audio_element_cmd_send(el, AEL_MSG_CMD_PAUSE);
+                break;
+        }
+    }
+    return in_len;
+}
+
+int audio_element_input_consume(audio_element_handle_t el, int size)
+{
+    if (el->read_type != IO_TYPE_RB || el->in.input_rb == NULL)
+        return ESP_FAIL;
+    return rb_consume(el->in.input_rb, size);
+}
+
 int audio_element_output_chunk(audio_element_handle_t el, char *buffer, int write_size)
 {
     int output_len = 0;
@@ -664,6 +664,35 @@ int audio_element_output(audio_element_handle_t el, char *buffer, int write_size
  */
 int audio_element_input_chunk(audio_element_handle_t el, char *buffer, int wanted_size);
 
+/**
+ * @brief      Call this function to access Element input data in place, without copying it out of
+ *             the input ringbuffer. Only available if input is ringbuffer. The data is kept in the
+ *             ringbuffer until audio_element_input_consume, so the bytes not consumed are returned
+ *             again by the next peek.
+ *
+ * @param[in]  el            The audio element handle
+ * @param[out] buffer        The pointer to input data in ringbuffer memory
+ * @param[in]  wanted_size   The wanted size
+ *
+ * @return
+ *        - > 0 number of contiguous bytes at buffer, may be less than wanted_size
+ *              at the end of a ringbuffer that is not mirrored
+ *        - <=0 audio_element_err_t
+ */
+int audio_element_input_peek(audio_element_handle_t el, char **buffer, int wanted_size);
+
+/**
+ * @brief      Release the input data returned by audio_element_input_peek
+ *
+ * @param[in]  el          The audio element handle
+ * @param[in]  size        The size consumed
+ *
+ * @return
+ *        - >=0 number of bytes consumed
+ *        - < 0 audio_element_err_t
+ */
+int audio_element_input_consume(audio_element_handle_t el, int size);
+
 /**
  * @brief      Call this function to sendout Element output the whole chunk
  *             Depending on setup using ringbuffer or function callback, Element will invoke write to ringbuffer, or call write callback funtion.
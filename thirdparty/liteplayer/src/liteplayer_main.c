@@ -59,8 +59,6 @@ struct liteplayer {
 
     struct media_source_info media_source_info;
     media_source_handle_t    media_source_handle;
-    int                      source_buffer_size; // for source synchronous mode
-    char                    *source_buffer_addr; // for source synchronous mode
 
     sink_handle_t           sink_handle;
     int                     sink_samplerate;
@@ -92,37 +90,41 @@ static int audio_source_open(audio_element_handle_t self, void *ctx)
 static int audio_source_read(audio_element_handle_t self, char *buffer, int len, int timeout_ms, void *ctx)
 {
     liteplayer_handle_t handle = (liteplayer_handle_t)ctx;
-    int bytes_remain = rb_bytes_filled(handle->media_source_info.out_ringbuf);
+    ringbuf_handle rb = handle->media_source_info.out_ringbuf;
+    int bytes_remain = rb_bytes_filled(rb);
     if (bytes_remain >= len) {
-        rb_read_chunk(handle->media_source_info.out_ringbuf, buffer, len, 0);
+        rb_read_chunk(rb, buffer, len, 0);
         return len;
     }
 
     if (bytes_remain > 0)
-        rb_read_chunk(handle->media_source_info.out_ringbuf, buffer, bytes_remain, 0);
+        rb_read_chunk(rb, buffer, bytes_remain, 0);
 
     int bytes_want = len - bytes_remain;
     int bytes_read = 0;
-    if (bytes_want < handle->source_buffer_size/2) {
+    // Memory-backed source (peek supported) reads as cheap as memcpy, no need to stage
+    if (bytes_want < rb_get_size(rb)/2 && handle->source_ops->peek == NULL) {
+        // Small request: read a whole buffer from source straight into the (now empty)
+        // ringbuf memory, hand out what is wanted and keep the rest for next read
+        char *space = NULL;
+        int space_size = rb_reserve_write(rb, &space, rb_get_size(rb), 0);
+        if (space_size <= 0) {
+            OS_LOGE(TAG, "Failed to reserve ringbuf, ret:%d", space_size);
+            return AEL_IO_FAIL;
+        }
         bytes_read = handle->source_ops->read(handle->media_source_info.source_handle,
-                                              handle->source_buffer_addr,
-                                              handle->source_buffer_size);
-        if (bytes_read < 0 || bytes_read > handle->source_buffer_size) {
+                                              space, space_size);
+        if (bytes_read < 0 || bytes_read > space_size) {
             OS_LOGE(TAG, "Failed to read source, ret:%d", bytes_read);
             return AEL_IO_FAIL;
         } else if (bytes_read == 0) {
             return AEL_IO_DONE;
-        } else if (bytes_read > bytes_want) {
-            memcpy(buffer + bytes_remain, handle->source_buffer_addr, bytes_want);
-            rb_write_chunk(handle->media_source_info.out_ringbuf,
-                           handle->source_buffer_addr + bytes_want,
-                           bytes_read - bytes_want,
-                           0);
-            return len;
-        } else {
-            memcpy(buffer + bytes_remain, handle->source_buffer_addr, bytes_read);
-            return bytes_read + bytes_remain;
         }
+        rb_commit_write(rb, bytes_read);
+        if (bytes_read > bytes_want)
+            bytes_read = bytes_want;
+        rb_read_chunk(rb, buffer + bytes_remain, bytes_read, 0);
+        return bytes_read + bytes_remain;
     } else {
         bytes_read = handle->source_ops->read(handle->media_source_info.source_handle,
                 buffer + bytes_remain, bytes_want);
@@ -386,11 +388,6 @@ static void main_pipeline_deinit(liteplayer_handle_t handle)
         rb_destroy(handle->media_source_info.out_ringbuf);
         handle->media_source_info.out_ringbuf = NULL;
     }
-
-    if (handle->source_buffer_addr != NULL) {
-        audio_free(handle->source_buffer_addr);
-        handle->source_buffer_addr = NULL;
-    }
 }
 
 static int main_pipeline_init(liteplayer_handle_t handle)
@@ -476,9 +473,6 @@ static int main_pipeline_init(liteplayer_handle_t handle)
         AUDIO_MEM_CHECK(TAG, handle->media_source_handle, return ESP_FAIL);
     } else {
         OS_LOGD(TAG, "[1.2] Create source element, sync mode, ringbuf size: %d", handle->source_ops->buffer_size);
-        handle->source_buffer_size = handle->source_ops->buffer_size;
-        handle->source_buffer_addr = audio_malloc(handle->source_buffer_size);
-        AUDIO_MEM_CHECK(TAG, handle->source_buffer_addr, return ESP_FAIL);
         stream_callback_t audio_source = {
             .open = audio_source_open,
             .read = audio_source_read,
@@ -612,7 +606,7 @@ int liteplayer_set_data_source(liteplayer_handle_t handle, const char *url)
 
     handle->media_source_info.url = handle->url;
     handle->media_source_info.source_ops = handle->source_ops;
-    handle->media_source_info.out_ringbuf = rb_create(handle->source_ops->buffer_size);
+    handle->media_source_info.out_ringbuf = rb_create_mirrored(handle->source_ops->buffer_size);
     AUDIO_MEM_CHECK(TAG, handle->media_source_info.out_ringbuf, goto set_fail);
 
     {
@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "osal/os_time.h"
 #include "cutils/log_helper.h"
 #include "esp_adf/audio_common.h"
 #include "audio_extractor/mp3_extractor.h"
@@ -30,6 +31,7 @@
 #define DEFAULT_MEDIA_PARSER_BUFFER_SIZE    (2048+1)
 #define DEFAULT_MEDIA_PARSER_DISCARD_MAX    (1024*512)
 #define DEFAULT_MEDIA_PARSER_WRITE_TIMEOUT  (200)
+#define DEFAULT_MEDIA_PARSER_TAIL_MAX       (1024*256)
 
 struct media_parser_priv {
     struct media_source_info source;
@@ -40,6 +42,16 @@ struct media_parser_priv {
     int reuse_size;
     int ringbuf_size;
 
+    // moov-at-tail window, fetched by a ranged open planned from the probe window
+    char *tail_buffer;
+    long tail_offset;
+    int tail_size;
+
+    // per-prepare source statistics
+    int stat_opens;
+    int stat_seeks;
+    long stat_bytes;
+
     media_parser_state_cb listener;
     void *listener_priv;
     struct media_source_info *listener_source;
@@ -49,44 +61,114 @@ struct media_parser_priv {
     os_cond cond;  // wait stop to exit mediaparser thread
 };
 
-static audio_codec_t get_codec_type(const char *url, char *buf)
+static bool media_parser_is_adts(const unsigned char *buf)
+{
+    // 12-bit syncword followed by layer '00'
+    return buf[0] == 0xFF && (buf[1] & 0xF6) == 0xF0;
+}
+
+static bool media_parser_is_mpeg_audio(const unsigned char *buf)
+{
+    // 11-bit syncword followed by a non-reserved layer
+    return buf[0] == 0xFF && (buf[1] & 0xE0) == 0xE0 && (buf[1] & 0x06) != 0;
+}
+
+static audio_codec_t get_codec_type(const char *url, const char *header, int size)
 {
+    const unsigned char *buf = (const unsigned char *)header;
     audio_codec_t codec = AUDIO_CODEC_NONE;
     if (memcmp(&buf[4], "ftyp", 4) == 0) {
         OS_LOGV(TAG, "Found M4A media");
         codec = AUDIO_CODEC_M4A;
-    } else if (memcmp(&buf[0], "ID3", 3) == 0) {
-        if (strstr(url, "mp3") != NULL) {
-            OS_LOGV(TAG, "Found MP3 media with ID3 tag");
-            codec = AUDIO_CODEC_MP3;
-        } else if (strstr(url, "aac") != NULL) {
-            OS_LOGV(TAG, "Found AAC media with ID3 tag");
-            codec = AUDIO_CODEC_AAC;
-        } else {
-            OS_LOGV(TAG, "Unknown type with ID3, assume codec is MP3");
-            codec = AUDIO_CODEC_MP3;
-        }
-    } else if ((buf[0] & 0xFF) == 0xFF && (buf[1] & 0xE0) == 0xE0) {
-        if (strstr(url, "aac") != NULL &&
-            (buf[0] & 0xFF) == 0xFF && (buf[1] & 0xF0) == 0xF0) {
-            OS_LOGV(TAG, "Found AAC media raw data");
-            codec = AUDIO_CODEC_AAC;
-        } else {
-            OS_LOGV(TAG, "Found MP3 media raw data");
-            codec = AUDIO_CODEC_MP3;
-        }
     } else if (memcmp(&buf[0], "RIFF", 4) == 0) {
         OS_LOGV(TAG, "Found wav media");
         codec = AUDIO_CODEC_WAV;
+    } else if (memcmp(&buf[0], "ID3", 3) == 0) {
+        // ID3v2 size is syncsafe and excludes the 10-byte header (and footer if present)
+        int offset = 10 + (((buf[6] & 0x7F) << 21) | ((buf[7] & 0x7F) << 14) |
+                           ((buf[8] & 0x7F) << 7) | (buf[9] & 0x7F));
+        if (buf[5] & 0x10)
+            offset += 10;
+        for (; offset + 1 < size; offset++) {
+            if (media_parser_is_adts(&buf[offset])) {
+                OS_LOGV(TAG, "Found AAC media with ID3 tag");
+                codec = AUDIO_CODEC_AAC;
+                break;
+            } else if (media_parser_is_mpeg_audio(&buf[offset])) {
+                OS_LOGV(TAG, "Found MP3 media with ID3 tag");
+                codec = AUDIO_CODEC_MP3;
+                break;
+            }
+        }
+        if (codec == AUDIO_CODEC_NONE) {
+            // ID3 tag is bigger than probe window, fallback to url hint
+            if (strstr(url, "aac") != NULL) {
+                OS_LOGV(TAG, "Found AAC media with ID3 tag (url hint)");
+                codec = AUDIO_CODEC_AAC;
+            } else {
+                OS_LOGV(TAG, "Unknown type with ID3, assume codec is MP3");
+                codec = AUDIO_CODEC_MP3;
+            }
+        }
+    } else if (media_parser_is_adts(buf)) {
+        OS_LOGV(TAG, "Found AAC media raw data");
+        codec = AUDIO_CODEC_AAC;
+    } else if (media_parser_is_mpeg_audio(buf)) {
+        OS_LOGV(TAG, "Found MP3 media raw data");
+        codec = AUDIO_CODEC_MP3;
     }
     // todo: support flac/opus
     return codec;
 }
 
+static int media_parser_source_read(struct media_parser_priv *priv, char *buf, int size)
+{
+    int bytes_read = priv->source.source_ops->read(priv->source.source_handle, buf, size);
+    if (bytes_read > 0)
+        priv->stat_bytes += bytes_read;
+    return bytes_read;
+}
+
+static int media_parser_source_seek(struct media_parser_priv *priv, long offset)
+{
+    priv->stat_seeks++;
+    return priv->source.source_ops->seek(priv->source.source_handle, offset);
+}
+
+static int media_parser_fetch_inplace(struct media_parser_priv *priv, char *buf, int wanted_size, long offset)
+{
+    // Memory-backed source: seek is a pointer move and data is copied from source
+    // memory directly, no need to cache header/reuse data or discard bytes
+    struct source_wrapper *ops = priv->source.source_ops;
+    char *data = NULL;
+    if ((long)ops->content_pos(priv->source.source_handle) != offset &&
+        ops->seek(priv->source.source_handle, offset) != 0)
+        return ESP_FAIL;
+    int bytes_read = ops->peek(priv->source.source_handle, &data, wanted_size);
+    if (bytes_read > 0) {
+        memcpy(buf, data, bytes_read);
+        priv->stat_bytes += bytes_read;
+    }
+    return bytes_read;
+}
+
 static int media_parser_fetch(char *buf, int wanted_size, long offset, void *arg)
 {
     struct media_parser_priv *priv = (struct media_parser_priv *)arg;
     int bytes_read = ESP_FAIL;
+    if (priv->source.source_ops->peek != NULL)
+        return media_parser_fetch_inplace(priv, buf, wanted_size, offset);
+
+    if (priv->tail_buffer != NULL && offset >= priv->tail_offset &&
+        offset <= priv->tail_offset + priv->tail_size) {
+        // requested offset is in the prefetched tail window, don't move the head handle
+        int bytes_remain = priv->tail_offset + priv->tail_size - offset;
+        if (wanted_size > bytes_remain)
+            wanted_size = bytes_remain;
+        memcpy(buf, &priv->tail_buffer[offset - priv->tail_offset], wanted_size);
+        return wanted_size;
+    }
+
     long content_pos = (long)priv->source.source_ops->content_pos(priv->source.source_handle);
 
     if (wanted_size > sizeof(priv->reuse_buffer)) {
@@ -107,8 +189,7 @@ static int media_parser_fetch(char *buf, int wanted_size, long offset, void *arg
             // wanted bytes bigger than remaining, need read more data from source
             memcpy(buf, &priv->header_buffer[offset], bytes_remain);
             wanted_size -= bytes_remain;
-            bytes_read = priv->source.source_ops->read(priv->source.source_handle,
-                    &buf[bytes_remain], wanted_size);
+            bytes_read = media_parser_source_read(priv, &buf[bytes_remain], wanted_size);
             if (bytes_read > 0) {
                 bytes_read += bytes_remain;
                 // update reuse buffer, because content_pos has been changed
@@ -142,8 +223,7 @@ static int media_parser_fetch(char *buf, int wanted_size, long offset, void *arg
                 int read_size = total_discard - bytes_read;
                 if (read_size > sizeof(priv->reuse_buffer))
                     read_size = sizeof(priv->reuse_buffer);
-                priv->reuse_size = priv->source.source_ops->read(priv->source.source_handle,
-                        priv->reuse_buffer, read_size);
+                priv->reuse_size = media_parser_source_read(priv, priv->reuse_buffer, read_size);
                 if (priv->reuse_size > 0) {
                     bytes_read += priv->reuse_size;
                 } else if (priv->reuse_size == 0) {
@@ -160,8 +240,7 @@ static int media_parser_fetch(char *buf, int wanted_size, long offset, void *arg
             } else if (total_discard > bytes_read) {
                 // left some bytes need to be discarded, read more data
                 int bytes_discard = total_discard - bytes_read;
-                priv->reuse_size = priv->source.source_ops->read(priv->source.source_handle,
-                        priv->reuse_buffer, sizeof(priv->reuse_buffer));
+                priv->reuse_size = media_parser_source_read(priv, priv->reuse_buffer, sizeof(priv->reuse_buffer));
                 int bytes_remain = priv->reuse_size - bytes_discard;
                 if (bytes_remain >= wanted_size) {
                     // update reuse buffer, because content_pos has been changed
@@ -180,7 +259,7 @@ static int media_parser_fetch(char *buf, int wanted_size, long offset, void *arg
 
 fallthrough_seek:
         OS_LOGD(TAG, "Seeking %ld>>%ld", content_pos, offset);
-        if (priv->source.source_ops->seek(priv->source.source_handle, offset) != 0)
+        if (media_parser_source_seek(priv, offset) != 0)
             return ESP_FAIL;
     }
 
@@ -188,10 +267,10 @@ read_want:
     content_pos = (long)priv->source.source_ops->content_pos(priv->source.source_handle);
     if (content_pos != offset) {
         OS_LOGW(TAG, "Unexpected offset, seeking: %ld>>%ld", content_pos, offset);
-        if (priv->source.source_ops->seek(priv->source.source_handle, offset) != 0)
+        if (media_parser_source_seek(priv, offset) != 0)
             return ESP_FAIL;
     }
-    bytes_read = priv->source.source_ops->read(priv->source.source_handle, buf, wanted_size);
+    bytes_read = media_parser_source_read(priv, buf, wanted_size);
     if (bytes_read > 0) {
         // update reuse buffer, because content_pos has been changed
         if (bytes_read <= sizeof(priv->reuse_buffer)) {
@@ -208,6 +287,83 @@ read_want:
     return bytes_read;
 }
 
+static void media_parser_drop_tail(struct media_parser_priv *priv)
+{
+    if (priv->tail_buffer != NULL)
+        audio_free(priv->tail_buffer);
+    priv->tail_buffer = NULL;
+    priv->tail_offset = 0;
+    priv->tail_size = 0;
+}
+
+static void media_parser_plan_m4a(struct media_parser_priv *priv, struct m4a_info *info)
+{
+    // Walk top-level atoms in the probe window. If mdat is found before moov, moov
+    // is at tail and its offset is known now, there is no need to stream through
+    // the head to locate it
+    const unsigned char *buf = (const unsigned char *)priv->header_buffer;
+    long offset = 0;
+    while (offset + 8 <= priv->header_size) {
+        uint32_t atom_size = ((uint32_t)buf[offset] << 24) | ((uint32_t)buf[offset+1] << 16) |
+                             ((uint32_t)buf[offset+2] << 8) | (uint32_t)buf[offset+3];
+        if (memcmp(&buf[offset+4], "moov", 4) == 0)
+            return;
+        if (memcmp(&buf[offset+4], "mdat", 4) == 0) {
+            if (atom_size < 8)
+                return;
+            info->mdat_offset = offset;
+            info->mdat_size = atom_size;
+            info->moov_offset = offset + atom_size;
+            info->moov_tail = true;
+            info->parsed_once = true;
+            break;
+        }
+        // 64-bit and to-end-of-file atoms are left to m4a extractor
+        if (atom_size < 8)
+            return;
+        offset += atom_size;
+    }
+    if (!info->moov_tail)
+        return;
+
+    OS_LOGD(TAG, "Probe found moov at tail: mdat_offset=%u, moov_offset=%u",
+            info->mdat_offset, info->moov_offset);
+
+    // Memory-backed source reads tail in place
+    if (priv->source.source_ops->peek != NULL)
+        return;
+
+    // Fetch the whole tail with a ranged open, keep head handle at mdat for playback
+    long content_len = (long)priv->source.source_ops->content_len(priv->source.source_handle);
+    long tail_size = content_len - (long)info->moov_offset;
+    if (content_len <= 0 || tail_size < 8 || tail_size > DEFAULT_MEDIA_PARSER_TAIL_MAX)
+        return;
+    priv->tail_buffer = audio_malloc(tail_size);
+    if (priv->tail_buffer == NULL)
+        return;
+
+    source_handle_t tail_handle =
+        priv->source.source_ops->open(priv->source.url, info->moov_offset, priv->source.source_ops->priv_data);
+    if (tail_handle != NULL) {
+        priv->stat_opens++;
+        while (priv->tail_size < tail_size) {
+            int bytes_read = priv->source.source_ops->read(tail_handle,
+                    &priv->tail_buffer[priv->tail_size], tail_size - priv->tail_size);
+            if (bytes_read <= 0)
+                break;
+            priv->tail_size += bytes_read;
+            priv->stat_bytes += bytes_read;
+        }
+        priv->source.source_ops->close(tail_handle);
+    }
+    if (priv->tail_size != tail_size) {
+        OS_LOGW(TAG, "Failed to prefetch moov: %d/%ld, fallback to seek", priv->tail_size, tail_size);
+        media_parser_drop_tail(priv);
+        return;
+    }
+    priv->tail_offset = info->moov_offset;
+}
+
 static int media_parser_extract(struct media_parser_priv *priv)
 {
     int ret = ESP_FAIL;
@@ -216,14 +372,16 @@ static int media_parser_extract(struct media_parser_priv *priv)
 
     if (read_size > priv->ringbuf_size)
         read_size = priv->ringbuf_size;
-    priv->header_size =
-        priv->source.source_ops->read(priv->source.source_handle, priv->header_buffer, read_size);
+    priv->header_size = media_parser_source_read(priv, priv->header_buffer, read_size);
     if (priv->header_size < 256) {
         OS_LOGE(TAG, "Insufficient bytes read: %d", priv->header_size);
         return ESP_FAIL;
     }
+    // header window is the data right before content_pos, it can be reused as well
+    memcpy(priv->reuse_buffer, priv->header_buffer, priv->header_size);
+    priv->reuse_size = priv->header_size;
 
-    codec->codec_type = get_codec_type(priv->source.url, priv->header_buffer);
+    codec->codec_type = get_codec_type(priv->source.url, priv->header_buffer, priv->header_size);
     switch (codec->codec_type) {
     case AUDIO_CODEC_MP3: {
         if (mp3_extractor(media_parser_fetch, priv, &(codec->detail.mp3_info)) == 0) {
@@ -254,6 +412,7 @@ static int media_parser_extract(struct media_parser_priv *priv)
     }
 
     case AUDIO_CODEC_M4A:
+        media_parser_plan_m4a(priv, &(codec->detail.m4a_info));
         if (m4a_extractor(media_parser_fetch, priv, &(codec->detail.m4a_info)) == 0) {
             codec->content_pos = codec->detail.m4a_info.mdat_offset;
             codec->content_len = priv->source.source_ops->content_len(priv->source.source_handle);
@@ -294,10 +453,12 @@ static int media_parser_extract(struct media_parser_priv *priv)
 
 static int media_parser_main(struct media_parser_priv *priv)
 {
+    unsigned long long probe_start = os_monotonic_usec();
     priv->source.source_handle =
         priv->source.source_ops->open(priv->source.url, 0, priv->source.source_ops->priv_data);
     if (priv->source.source_handle == NULL)
         return ESP_FAIL;
+    priv->stat_opens++;
 
     bool reuse_handle = false;
     int ret = media_parser_extract(priv);
@@ -309,7 +470,18 @@ static int media_parser_main(struct media_parser_priv *priv)
         OS_LOGE(TAG, "Failed to parse url:[%s]", priv->source.url);
     }
 
-    if (ret == ESP_OK) {
+    if (ret == ESP_OK && priv->source.source_ops->peek != NULL) {
+        // Memory-backed source can always be reused, just move to frame_start_offset
+        if (priv->lock != NULL)
+            os_mutex_lock(priv->lock);
+        if (!priv->stop &&
+            priv->source.source_ops->seek(priv->source.source_handle, priv->codec.content_pos) == 0) {
+            rb_reset(priv->source.out_ringbuf);
+            reuse_handle = true;
+        }
+        if (priv->lock != NULL)
+            os_mutex_unlock(priv->lock);
+    } else if (ret == ESP_OK) {
         long content_pos = (long)priv->source.source_ops->content_pos(priv->source.source_handle);
         OS_LOGV(TAG, "content_pos=%ld, frame_start_offset=%ld", content_pos, priv->codec.content_pos);
 
@@ -318,8 +490,7 @@ static int media_parser_main(struct media_parser_priv *priv)
             int bytes_discard = priv->codec.content_pos - content_pos;
             OS_LOGD(TAG, "Try to discard %d bytes to reach frame_start_offset", bytes_discard);
             while (bytes_discard > 0) {
-                priv->reuse_size = priv->source.source_ops->read(priv->source.source_handle,
-                        priv->reuse_buffer, sizeof(priv->reuse_buffer));
+                priv->reuse_size = media_parser_source_read(priv, priv->reuse_buffer, sizeof(priv->reuse_buffer));
                 if (priv->reuse_size > 0)
                     bytes_discard -= priv->reuse_size;
                 else
@@ -362,10 +533,16 @@ static int media_parser_main(struct media_parser_priv *priv)
     }
 
 reuse_out:
+    // the moov tail is only needed while extracting
+    media_parser_drop_tail(priv);
     if (!reuse_handle || priv->stop) {
         priv->source.source_ops->close(priv->source.source_handle);
         priv->source.source_handle = NULL;
     }
+    // Each open/seek is a round trip for network source, a handle not reused costs one more
+    OS_LOGI(TAG, "Probe: opens[%d], seeks[%d], bytes[%ld], reuse[%d], cost[%llums]",
+            priv->stat_opens, priv->stat_seeks, priv->stat_bytes, reuse_handle,
+            (os_monotonic_usec() - probe_start)/1000);
     return ret;
 }
 
@@ -430,6 +607,7 @@ static int media_parser_get_codec_info2(struct media_parser_priv *priv)
 
 static void media_parser_cleanup(struct media_parser_priv *priv)
 {
+    media_parser_drop_tail(priv);
     if (priv->lock != NULL)
         os_mutex_destroy(priv->lock);
     if (priv->cond != NULL)
@@ -13,10 +13,12 @@
 // limitations under the License.
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 
 #include "osal/os_thread.h"
+#include "osal/os_time.h"
 #include "cutils/log_helper.h"
 #include "cutils/ringbuf.h"
 #include "esp_adf/audio_common.h"
@@ -30,6 +32,10 @@
 #define DEFAULT_TTS_WRITE_TIMEOUT 1000 // ms
 #define DEFAULT_TTS_RINGBUF_SIZE  (1024*16)
 
+#define DEFAULT_TTS_JITTER_MIN_MS 120
+#define DEFAULT_TTS_JITTER_MAX_MS 1500
+#define DEFAULT_TTS_BYTERATE      4000 // bytes per second before measured, 32kbps
+
 struct ttsplayer {
     struct ttsplayer_cfg   cfg;
     liteplayer_handle_t    player;
@@ -37,7 +43,23 @@ struct ttsplayer {
     bool                   force_stop;
     bool                   waiting_data;
     bool                   has_prepared;
+    bool                   has_started;
     long                   tts_offset;
+
+    // Adaptive jitter buffer, estimates are kept across utterances
+    unsigned long long     last_arrival;  // usec
+    bool                   last_blocked;  // last write waited for ringbuf space
+    int                    gap_avg;       // smoothed inter-arrival time, usec
+    int                    gap_jitter;    // smoothed deviation of inter-arrival time, usec
+    int                    gap_peak;      // largest inter-arrival time, decays per utterance
+    int                    target_ms;     // target buffer depth
+    int                    byterate;      // measured consumption rate
+
+    // Per utterance statistics
+    unsigned long long     first_arrival;
+    unsigned long long     prebuffer_usec;
+    unsigned long long     stall_usec;
+    int                    underruns;
 };
 
 static const char *tts_source_url_protocol();
@@ -48,6 +70,64 @@ static long long tts_source_content_len(source_handle_t handle);
 static int tts_source_seek(source_handle_t handle, long offset);
 static void tts_source_close(source_handle_t handle);
 
+static int tts_jitter_target_bytes(ttsplayer_handle_t handle)
+{
+    int bytes = (int)((long long)handle->target_ms * handle->byterate / 1000);
+    if (bytes < DEFAULT_TTS_HEADER_SIZE)
+        bytes = DEFAULT_TTS_HEADER_SIZE;
+    if (bytes > handle->cfg.ringbuf_size*3/4)
+        bytes = handle->cfg.ringbuf_size*3/4;
+    return bytes;
+}
+
+static void tts_jitter_on_arrival(ttsplayer_handle_t handle, int size)
+{
+    unsigned long long now = os_monotonic_usec();
+    bool blocked = rb_bytes_available(handle->ringbuf) < size;
+
+    if (handle->first_arrival == 0) {
+        handle->first_arrival = now;
+    } else if (!handle->last_blocked) {
+        // Gap is meaningless if last write waited for space: buffer was full anyway
+        int gap = (int)(now - handle->last_arrival);
+        int delta = gap - handle->gap_avg;
+        handle->gap_avg += delta/8;
+        handle->gap_jitter += (abs(delta) - handle->gap_jitter)/16;
+        if (gap > handle->gap_peak)
+            handle->gap_peak = gap;
+
+        int target = (handle->gap_avg + 4*handle->gap_jitter)/1000;
+        if (target < handle->gap_peak/1000)
+            target = handle->gap_peak/1000;
+        if (target < DEFAULT_TTS_JITTER_MIN_MS)
+            target = DEFAULT_TTS_JITTER_MIN_MS;
+        if (target > DEFAULT_TTS_JITTER_MAX_MS)
+            target = DEFAULT_TTS_JITTER_MAX_MS;
+        handle->target_ms = target;
+    }
+    handle->last_arrival = now;
+    handle->last_blocked = blocked;
+}
+
+static void tts_jitter_report(ttsplayer_handle_t handle)
+{
+    if (handle->first_arrival == 0)
+        return;
+
+    // Sink position is exact, so bytes consumed per played second gives the byterate
+    int position = 0;
+    if (liteplayer_get_position(handle->player, &position) == 0 && position >= 500) {
+        int byterate = (int)((long long)handle->tts_offset * 1000 / position);
+        handle->byterate = (handle->byterate*3 + byterate)/4;
+    }
+
+    OS_LOGI(TAG, "Utterance: bytes[%ld], underruns[%d], prebuffer[%dms], stall[%dms], target[%dms], jitter[%dms], byterate[%d]",
+            handle->tts_offset, handle->underruns,
+            (int)(handle->prebuffer_usec/1000), (int)(handle->stall_usec/1000),
+            handle->target_ms, handle->gap_jitter/1000, handle->byterate);
+    handle->first_arrival = 0;
+}
+
 ttsplayer_handle_t ttsplayer_create(struct ttsplayer_cfg *cfg)
 {
     ttsplayer_handle_t handle = audio_calloc(1, sizeof(struct ttsplayer));
@@ -60,6 +140,8 @@ ttsplayer_handle_t ttsplayer_create(struct ttsplayer_cfg *cfg)
         handle->ringbuf = rb_create(handle->cfg.ringbuf_size);
         if (handle->ringbuf == NULL)
             goto create_fail;
+        handle->target_ms = DEFAULT_TTS_JITTER_MIN_MS;
+        handle->byterate = DEFAULT_TTS_BYTERATE;
 
         handle->player = liteplayer_create();
         if (handle->player == NULL)
@@ -107,10 +189,17 @@ int ttsplayer_prepare_async(ttsplayer_handle_t handle)
     if (handle == NULL)
         return -1;
     rb_reset(handle->ringbuf);
+    rb_set_threshold(handle->ringbuf, 0);
     handle->force_stop = false;
     handle->waiting_data = true;
     handle->has_prepared = false;
+    handle->has_started = false;
     handle->tts_offset = 0;
+    handle->first_arrival = 0;
+    handle->prebuffer_usec = 0;
+    handle->stall_usec = 0;
+    handle->underruns = 0;
+    handle->gap_peak /= 2;
     return liteplayer_set_data_source(handle->player, TTS_SOURCE_URL_NAME);
 }
 
@@ -121,6 +210,9 @@ int ttsplayer_write(ttsplayer_handle_t handle, char *buffer, int size, bool fina
         return -1;
     }
 
+    if (size > 0)
+        tts_jitter_on_arrival(handle, size);
+
     int bytes_written = 0;
     int ret = 0;
     while (!handle->force_stop && size > 0) {
@@ -146,7 +238,10 @@ int ttsplayer_write(ttsplayer_handle_t handle, char *buffer, int size, bool fina
     }
 
     if (!handle->has_prepared && !handle->force_stop) {
-        if (rb_bytes_filled(handle->ringbuf) >= DEFAULT_TTS_HEADER_SIZE || final) {
+        // Prebuffer target depth before playing, instead of only the header
+        if (rb_bytes_filled(handle->ringbuf) >= tts_jitter_target_bytes(handle) || final) {
+            if (handle->first_arrival != 0)
+                handle->prebuffer_usec = os_monotonic_usec() - handle->first_arrival;
             ret = liteplayer_prepare_async(handle->player);
             handle->has_prepared = true;
         }
@@ -158,6 +253,7 @@ int ttsplayer_start(ttsplayer_handle_t handle)
 {
     if (handle == NULL)
         return -1;
+    handle->has_started = true;
     return liteplayer_start(handle->player);
 }
 
@@ -168,6 +264,7 @@ int ttsplayer_stop(ttsplayer_handle_t handle)
     handle->force_stop = true;
     handle->waiting_data = false;
     rb_done_write(handle->ringbuf);
+    tts_jitter_report(handle);
     return liteplayer_stop(handle->player);
 }
 
@@ -178,6 +275,7 @@ int ttsplayer_reset(ttsplayer_handle_t handle)
     handle->force_stop = true;
     handle->waiting_data = false;
     rb_done_write(handle->ringbuf);
+    tts_jitter_report(handle);
     return liteplayer_reset(handle->player);
 }
 
@@ -212,7 +310,8 @@ static source_handle_t tts_source_open(const char *url, long long content_pos, v
 static int tts_source_read(source_handle_t handle, char *buffer, int size)
 {
     ttsplayer_handle_t priv = (ttsplayer_handle_t)handle;
-    if (!priv->has_prepared) {
+    // Player may be started from prepared callback before has_prepared is set, only probe reads are limited
+    if (!priv->has_prepared && !priv->has_started) {
         if (size > DEFAULT_TTS_HEADER_SIZE)
             size = DEFAULT_TTS_HEADER_SIZE;
         if (size > rb_bytes_filled(priv->ringbuf)) {
@@ -220,7 +319,17 @@ static int tts_source_read(source_handle_t handle, char *buffer, int size)
             return -1;
         }
     }
-    int ret = rb_read(priv->ringbuf, buffer, size, AUDIO_MAX_DELAY);
+    int ret;
+    if (priv->has_started && rb_bytes_filled(priv->ringbuf) < size && !rb_is_done_write(priv->ringbuf)) {
+        // Underrun: rebuffer to target depth rather than playing each frame as it trickles in
+        priv->underruns++;
+        rb_set_threshold(priv->ringbuf, tts_jitter_target_bytes(priv));
+        unsigned long long start = os_monotonic_usec();
+        ret = rb_read(priv->ringbuf, buffer, size, AUDIO_MAX_DELAY);
+        priv->stall_usec += os_monotonic_usec() - start;
+    } else {
+        ret = rb_read(priv->ringbuf, buffer, size, AUDIO_MAX_DELAY);
+    }
     if (ret > 0)
         priv->tts_offset += ret;
     else if (ret == RB_OK || ret == RB_DONE)
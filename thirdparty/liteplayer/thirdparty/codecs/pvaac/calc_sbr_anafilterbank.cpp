@@ -92,6 +92,7 @@ Copyright (c) ISO/IEC 2002.
 
 #include    "aac_mem_funcs.h"
 #include    "fxp_mul32.h"
+#include    "fxp_simd.h"
 
 
 
@@ -117,6 +118,111 @@ Copyright (c) ISO/IEC 2002.
 ; Variable declaration - defined here and used outside this module
 ----------------------------------------------------------------------------*/
 
+#if defined(PV_SIMD_SSE2) || defined(PV_SIMD_NEON)
+/*
+ *  sbrDecoderFilterbankCoefficients_an_filt[_LC][] transposed for the vector
+ *  window: row k holds, for every output pair j, coefficient 5*j + k.
+ *  Pair 31 is zero padding.
+ */
+static const Int32 sbrDecoderFilterbankCoefficients_an_filt_LC_simd[5*32] =
+{
+    Qfmt27(-0.00079446133872F),  Qfmt27(-0.00068946163857F),  Qfmt27(-0.00071286404460F),  Qfmt27(-0.00077308974337F),
+    Qfmt27(-0.00083027488297F),  Qfmt27(-0.00089272089703F),  Qfmt27(-0.00095851011196F),  Qfmt27(-0.00101225729839F),
+    Qfmt27(-0.00105230782648F),  Qfmt27(-0.00108630976316F),  Qfmt27(-0.00110794157381F),  Qfmt27(-0.00110360418081F),
+    Qfmt27(-0.00109714405326F),  Qfmt27(-0.00106490281247F),  Qfmt27(-0.00102041023958F),  Qfmt27(-0.00094051141595F),
+    Qfmt27(-0.00084090835475F),  Qfmt27(-0.00072769348801F),  Qfmt27(-0.00057913742435F),  Qfmt27(-0.00040969484059F),
+    Qfmt27(-0.00020454902123F),  Qfmt27(0.00001908481202F),   Qfmt27(0.00028892665922F),   Qfmt27(0.00056943874774F),
+    Qfmt27(0.00088238158168F),   Qfmt27(0.00121741725989F),   Qfmt27(0.00159101288509F),   Qfmt27(0.00196610899088F),
+    Qfmt27(0.00238550675072F),   Qfmt27(0.00280596092809F),   Qfmt27(0.00325513071185F),   0,
+
+    Qfmt27(0.02197766364781F),  Qfmt27(0.02537571195384F),  Qfmt27(0.02892516313544F),  Qfmt27(0.03262310249845F),
+    Qfmt27(0.03646915244785F),  Qfmt27(0.04045671426315F),  Qfmt27(0.04455021764484F),  Qfmt27(0.04873676213679F),
+    Qfmt27(0.05300654158217F),  Qfmt27(0.05732502937107F),  Qfmt27(0.06167350555855F),  Qfmt27(0.06602157445253F),
+    Qfmt27(0.07034096875232F),  Qfmt27(0.07461825625751F),  Qfmt27(0.07879625324269F),  Qfmt27(0.08286099010631F),
+    Qfmt27(0.08675566213219F),  Qfmt27(0.09046949018457F),  Qfmt27(0.09395575430420F),  Qfmt27(0.09716267023308F),
+    Qfmt27(0.10007381188066F),  Qfmt27(0.10262701466139F),  Qfmt27(0.10479373974558F),  Qfmt27(0.10650970405576F),
+    Qfmt27(0.10776200996423F),  Qfmt27(0.10848340171661F),  Qfmt27(0.10864412991640F),  Qfmt27(0.10819451041273F),
+    Qfmt27(0.10709920766553F),  Qfmt27(0.10531144797543F),  Qfmt27(0.10278145526768F),  0,
+
+    Qfmt27(0.54254182141522F),  Qfmt27(0.57449847577240F),  Qfmt27(0.60657315615086F),  Qfmt27(0.63865835544980F),
+    Qfmt27(0.67068416485018F),  Qfmt27(0.70254003810627F),  Qfmt27(0.73415149000395F),  Qfmt27(0.76545064960593F),
+    Qfmt27(0.79631383686511F),  Qfmt27(0.82666485395476F),  Qfmt27(0.85641712130638F),  Qfmt27(0.88547343436495F),
+    Qfmt27(0.91376152398903F),  Qfmt27(0.94117890777861F),  Qfmt27(0.96765488212662F),  Qfmt27(0.99311573680798F),
+    Qfmt27(1.01745066253324F),  Qfmt27(1.04060828658052F),  Qfmt27(1.06251808919053F),  Qfmt27(1.08310018709600F),
+    Qfmt27(1.10227871198194F),  Qfmt27(1.12001978353403F),  Qfmt27(1.13624787143434F),  Qfmt27(1.15091404672203F),
+    Qfmt27(1.16395714324633F),  Qfmt27(1.17535833075364F),  Qfmt27(1.18507099110810F),  Qfmt27(1.19306425909871F),
+    Qfmt27(1.19929775892826F),  Qfmt27(1.20377455661175F),  Qfmt27(1.20646855283790F),  0,
+
+    Qfmt27(-0.47923775873194F),  Qfmt27(-0.44806230039026F),  Qfmt27(-0.41729436041451F),  Qfmt27(-0.38701849746199F),
+    Qfmt27(-0.35729827194706F),  Qfmt27(-0.32819525024294F),  Qfmt27(-0.29977591877185F),  Qfmt27(-0.27208998714049F),
+    Qfmt27(-0.24519750285673F),  Qfmt27(-0.21914753347432F),  Qfmt27(-0.19396671004887F),  Qfmt27(-0.16971665552213F),
+    Qfmt27(-0.14641770628514F),  Qfmt27(-0.12410396326951F),  Qfmt27(-0.10280530739363F),  Qfmt27(-0.08254839941155F),
+    Qfmt27(-0.06332944781672F),  Qfmt27(-0.04518854556363F),  Qfmt27(-0.02811939233087F),  Qfmt27(-0.01212147193047F),
+    Qfmt27(0.00279527795884F),   Qfmt27(0.01663452156443F),   Qfmt27(0.02941522773279F),   Qfmt27(0.04112872592057F),
+    Qfmt27(0.05181934748033F),   Qfmt27(0.06148559051724F),   Qfmt27(0.07014197759039F),   Qfmt27(0.07784680399703F),
+    Qfmt27(0.08459352758522F),   Qfmt27(0.09043115226911F),   Qfmt27(0.09539224314440F),   0,
+
+    Qfmt27(-0.01574239605130F),  Qfmt27(-0.01291535202742F),  Qfmt27(-0.01026942774868F),  Qfmt27(-0.00782586328859F),
+    Qfmt27(-0.00557215982767F),  Qfmt27(-0.00351102841332F),  Qfmt27(-0.00163598204794F),  Qfmt27(0.00003903936539F),
+    Qfmt27(0.00154182229475F),   Qfmt27(0.00286720203220F),   Qfmt27(0.00402297937976F),   Qfmt27(0.00500649278750F),
+    Qfmt27(0.00583386287581F),   Qfmt27(0.00651097277313F),   Qfmt27(0.00704839655425F),   Qfmt27(0.00745513427428F),
+    Qfmt27(0.00774335382672F),   Qfmt27(0.00790787636150F),   Qfmt27(0.00797463714114F),   Qfmt27(0.00795079915733F),
+    Qfmt27(0.00784545014643F),   Qfmt27(0.00766458213130F),   Qfmt27(0.00741912981120F),   Qfmt27(0.00712664923329F),
+    Qfmt27(0.00677868764313F),   Qfmt27(0.00639363830229F),   Qfmt27(0.00597707038378F),   Qfmt27(0.00554476792518F),
+    Qfmt27(0.00509233837916F),   Qfmt27(0.00463008004888F),   Qfmt27(0.00416760958657F),   0,
+};
+
+#ifdef LITEPLAYER_CONFIG_HQ_SBR
+static const Int32 sbrDecoderFilterbankCoefficients_an_filt_simd[5*32] =
+{
+    Qfmt27(-0.000561769F),  Qfmt27(-0.000487523F),  Qfmt27(-0.000504071F),  Qfmt27(-0.000546657F),
+    Qfmt27(-0.000587093F),  Qfmt27(-0.000631249F),  Qfmt27(-0.000677769F),  Qfmt27(-0.000715774F),
+    Qfmt27(-0.000744094F),  Qfmt27(-0.000768137F),  Qfmt27(-0.000783433F),  Qfmt27(-0.000780366F),
+    Qfmt27(-0.000775798F),  Qfmt27(-0.000753000F),  Qfmt27(-0.000721539F),  Qfmt27(-0.000665042F),
+    Qfmt27(-0.000594612F),  Qfmt27(-0.000514557F),  Qfmt27(-0.000409512F),  Qfmt27(-0.000289698F),
+    Qfmt27(-0.000144638F),  Qfmt27(+0.000013495F),  Qfmt27(+0.000204302F),  Qfmt27(+0.000402654F),
+    Qfmt27(+0.000623938F),  Qfmt27(+0.000860844F),  Qfmt27(+0.001125016F),  Qfmt27(+0.001390249F),
+    Qfmt27(+0.001686808F),  Qfmt27(+0.001984114F),  Qfmt27(+0.002301725F),  0,
+
+    Qfmt27(+0.015540555F),  Qfmt27(+0.017943338F),  Qfmt27(+0.020453179F),  Qfmt27(+0.023068017F),
+    Qfmt27(+0.025787585F),  Qfmt27(+0.028607217F),  Qfmt27(+0.031501761F),  Qfmt27(+0.034462095F),
+    Qfmt27(+0.037481285F),  Qfmt27(+0.040534917F),  Qfmt27(+0.043609754F),  Qfmt27(+0.046684303F),
+    Qfmt27(+0.049738576F),  Qfmt27(+0.052763075F),  Qfmt27(+0.055717365F),  Qfmt27(+0.058591568F),
+    Qfmt27(+0.061345517F),  Qfmt27(+0.063971590F),  Qfmt27(+0.066436751F),  Qfmt27(+0.068704383F),
+    Qfmt27(+0.070762871F),  Qfmt27(+0.072568258F),  Qfmt27(+0.074100364F),  Qfmt27(+0.075313734F),
+    Qfmt27(+0.076199248F),  Qfmt27(+0.076709349F),  Qfmt27(+0.076823001F),  Qfmt27(+0.076505072F),
+    Qfmt27(+0.075730576F),  Qfmt27(+0.074466439F),  Qfmt27(+0.072677464F),  0,
+
+    Qfmt27(+0.383635001F),  Qfmt27(+0.406231768F),  Qfmt27(+0.428911992F),  Qfmt27(+0.451599654F),
+    Qfmt27(+0.474245321F),  Qfmt27(+0.496770825F),  Qfmt27(+0.519123497F),  Qfmt27(+0.541255345F),
+    Qfmt27(+0.563078914F),  Qfmt27(+0.584540324F),  Qfmt27(+0.605578354F),  Qfmt27(+0.626124270F),
+    Qfmt27(+0.646126970F),  Qfmt27(+0.665513988F),  Qfmt27(+0.684235329F),  Qfmt27(+0.702238872F),
+    Qfmt27(+0.719446263F),  Qfmt27(+0.735821176F),  Qfmt27(+0.751313746F),  Qfmt27(+0.765867487F),
+    Qfmt27(+0.779428752F),  Qfmt27(+0.791973584F),  Qfmt27(+0.803448575F),  Qfmt27(+0.813819127F),
+    Qfmt27(+0.823041989F),  Qfmt27(+0.831103846F),  Qfmt27(+0.837971734F),  Qfmt27(+0.843623828F),
+    Qfmt27(+0.848031578F),  Qfmt27(+0.851197152F),  Qfmt27(+0.853102095F),  0,
+
+    Qfmt27(-0.338872269F),  Qfmt27(-0.316827891F),  Qfmt27(-0.295071672F),  Qfmt27(-0.273663404F),
+    Qfmt27(-0.252648031F),  Qfmt27(-0.232069087F),  Qfmt27(-0.211973585F),  Qfmt27(-0.192396675F),
+    Qfmt27(-0.173380817F),  Qfmt27(-0.154960707F),  Qfmt27(-0.137155176F),  Qfmt27(-0.120007798F),
+    Qfmt27(-0.103532953F),  Qfmt27(-0.087754754F),  Qfmt27(-0.072694330F),  Qfmt27(-0.058370533F),
+    Qfmt27(-0.044780682F),  Qfmt27(-0.031953127F),  Qfmt27(-0.019883413F),  Qfmt27(-0.008571175F),
+    Qfmt27(+0.001976560F),  Qfmt27(+0.011762383F),  Qfmt27(+0.020799707F),  Qfmt27(+0.029082401F),
+    Qfmt27(+0.036641812F),  Qfmt27(+0.043476878F),  Qfmt27(+0.049597868F),  Qfmt27(+0.055046003F),
+    Qfmt27(+0.059816657F),  Qfmt27(+0.063944481F),  Qfmt27(+0.067452502F),  0,
+
+    Qfmt27(-0.011131555F),  Qfmt27(-0.009132533F),  Qfmt27(-0.007261582F),  Qfmt27(-0.005533721F),
+    Qfmt27(-0.003940112F),  Qfmt27(-0.002482672F),  Qfmt27(-0.001156814F),  Qfmt27(+0.000027605F),
+    Qfmt27(+0.001090233F),  Qfmt27(+0.002027418F),  Qfmt27(+0.002844676F),  Qfmt27(+0.003540125F),
+    Qfmt27(+0.004125164F),  Qfmt27(+0.004603953F),  Qfmt27(+0.004983969F),  Qfmt27(+0.005271576F),
+    Qfmt27(+0.005475378F),  Qfmt27(+0.005591713F),  Qfmt27(+0.005638920F),  Qfmt27(+0.005622064F),
+    Qfmt27(+0.005547571F),  Qfmt27(+0.005419678F),  Qfmt27(+0.005246117F),  Qfmt27(+0.005039302F),
+    Qfmt27(+0.004793256F),  Qfmt27(+0.004520985F),  Qfmt27(+0.004226427F),  Qfmt27(+0.003920743F),
+    Qfmt27(+0.003600827F),  Qfmt27(+0.003273961F),  Qfmt27(+0.002946945F),  0,
+};
+#endif
+#endif
+
 /*----------------------------------------------------------------------------
 ; EXTERNAL FUNCTION REFERENCES
 ; Declare functions defined elsewhere and referenced in this module
@@ -131,50 +237,41 @@ Copyright (c) ISO/IEC 2002.
 ; FUNCTION CODE
 ----------------------------------------------------------------------------*/
 
-void calc_sbr_anafilterbank_LC(Int32 * Sr,
-                               Int16 * X,
-                               Int32 scratch_mem[][64],
-                               Int32 maxBand)
+/*
+ *  window the 320 samples X[-320..-1] into Y[1..31] and Y[33..63], C reference
+ */
+void calc_sbr_anafilterbank_window_c(Int32 * Y,
+                                     const Int16 * X,
+                                     Bool bHQ)
 {
-
     Int i;
     Int32   *p_Y_1;
     Int32   *p_Y_2;
 
-    Int16 * pt_X_1;
-    Int16 * pt_X_2;
+    const Int32 * pt_C;
+    const Int16 * pt_X_1;
+    const Int16 * pt_X_2;
     Int32 realAccu1;
     Int32 realAccu2;
 
     Int32 tmp1;
     Int32 tmp2;
 
+    p_Y_1 = &Y[1];
+    p_Y_2 = &Y[63];
 
-    const Int32 * pt_C;
-
-    p_Y_1 = scratch_mem[0];
-
-
-    p_Y_2 = p_Y_1 + 63;
     pt_C   = &sbrDecoderFilterbankCoefficients_an_filt_LC[0];
-
-    pt_X_1 = X;
-
-
-    realAccu1  =  fxp_mul32_by_16(Qfmt27(-0.51075594183097F),   pt_X_1[-192]);
-
-    realAccu1  =  fxp_mac32_by_16(Qfmt27(-0.51075594183097F), -pt_X_1[-128], realAccu1);
-    realAccu1  =  fxp_mac32_by_16(Qfmt27(-0.01876919066980F),  pt_X_1[-256], realAccu1);
-    *(p_Y_1++) =  fxp_mac32_by_16(Qfmt27(-0.01876919066980F), -pt_X_1[ -64], realAccu1);
-
-
-    /* create array Y */
+#ifdef LITEPLAYER_CONFIG_HQ_SBR
+    if (bHQ)
+    {
+        pt_C = &sbrDecoderFilterbankCoefficients_an_filt[0];
+    }
+#endif
 
     pt_X_1 = &X[-1];
     pt_X_2 = &X[-319];
 
-
-    for (i = 15; i != 0; i--)
+    for (i = 31; i != 0; i--)
     {
         tmp1 = *(pt_X_1--);
         tmp2 = *(pt_X_2++);
@@ -182,78 +279,158 @@ void calc_sbr_anafilterbank_LC(Int32 * Sr,
         realAccu1  = fxp_mul32_by_16(*(pt_C), tmp1);
         realAccu2  = fxp_mul32_by_16(*(pt_C++), tmp2);
         tmp1 = pt_X_1[ -63];
-        tmp2 = pt_X_2[ +63];
+        tmp2 = pt_X_2[  63];
         realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
         realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
         tmp1 = pt_X_1[ -127];
-        tmp2 = pt_X_2[ +127];
+        tmp2 = pt_X_2[  127];
         realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
         realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
         tmp1 = pt_X_1[ -191];
-        tmp2 = pt_X_2[ +191];
+        tmp2 = pt_X_2[  191];
         realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
         realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
         tmp1 = pt_X_1[ -255];
-        tmp2 = pt_X_2[ +255];
+        tmp2 = pt_X_2[  255];
         *(p_Y_1++) = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
         *(p_Y_2--) = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
+    }
+}
 
-        tmp1 = *(pt_X_1--);
-        tmp2 = *(pt_X_2++);
-        realAccu1  = fxp_mul32_by_16(*(pt_C), tmp1);
-        realAccu2  = fxp_mul32_by_16(*(pt_C++), tmp2);
 
-        tmp1 = pt_X_1[ -63];
-        tmp2 = pt_X_2[ +63];
-        realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-        realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
-        tmp1 = pt_X_1[ -127];
-        tmp2 = pt_X_2[ +127];
-        realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-        realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
-        tmp1 = pt_X_1[ -191];
-        tmp2 = pt_X_2[ +191];
-        realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-        realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
-        tmp1 = pt_X_1[ -255];
-        tmp2 = pt_X_2[ +255];
-        *(p_Y_1++) = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-        *(p_Y_2--) = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
+#if defined(PV_SIMD_SSE2) || defined(PV_SIMD_NEON)
+
+/*
+ *  same as calc_sbr_anafilterbank_window_c(), 8 output pairs per iteration.
+ *  Every product is floor(C*x/2^16) as fxp_mul32_by_16() computes it and
+ *  the sums wrap around in 32 bits, so the output is bit-exact. The padding
+ *  pair writes 0 to Y[32], which the caller sets afterwards.
+ */
+PV_SIMD_TARGET void calc_sbr_anafilterbank_window_simd(Int32 * Y,
+        const Int16 * X,
+        Bool bHQ)
+{
+    Int32 j;
+    Int32 k;
+
+    const Int32 *pt_C = sbrDecoderFilterbankCoefficients_an_filt_LC_simd;
+#ifdef LITEPLAYER_CONFIG_HQ_SBR
+    if (bHQ)
+    {
+        pt_C = sbrDecoderFilterbankCoefficients_an_filt_simd;
+    }
+#endif
+
+    for (j = 0; j < 32; j += 8)
+    {
+#if defined(PV_SIMD_SSE2)
+
+        const __m128i one_hi = _mm_set1_epi32(0x10000);
+        __m128i acc1_lo = _mm_setzero_si128();
+        __m128i acc1_hi = acc1_lo;
+        __m128i acc2_lo = acc1_lo;
+        __m128i acc2_hi = acc1_lo;
+
+        for (k = 0; k < 5; k++)
+        {
+            __m128i c_lo = _mm_loadu_si128((const __m128i *)&pt_C[32*k + j]);
+            __m128i c_hi = _mm_loadu_si128((const __m128i *)&pt_C[32*k + j + 4]);
+
+            /*
+             *  C = Ch*2^16 + Cl with Cl unsigned: floor(C*x/2^16) is
+             *  Ch*x + floor(Cl*x/2^16), the latter fits in 16 bits
+             */
+            __m128i c_l  = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(c_lo, 16), 16),
+                                           _mm_srai_epi32(_mm_slli_epi32(c_hi, 16), 16));
+            __m128i ch_lo = _mm_or_si128(_mm_srli_epi32(c_lo, 16), one_hi);
+            __m128i ch_hi = _mm_or_si128(_mm_srli_epi32(c_hi, 16), one_hi);
+
+            /* X is read backwards for the first half, reverse the 8 lanes */
+            __m128i x1 = _mm_loadu_si128((const __m128i *)&X[-8 - j - 64*k]);
+            __m128i x2 = _mm_loadu_si128((const __m128i *)&X[-319 + j + 64*k]);
+            x1 = _mm_shuffle_epi32(x1, _MM_SHUFFLE(0, 1, 2, 3));
+            x1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x1, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+
+            __m128i t1 = _mm_sub_epi16(_mm_mulhi_epu16(c_l, x1), _mm_and_si128(c_l, _mm_srai_epi16(x1, 15)));
+            __m128i t2 = _mm_sub_epi16(_mm_mulhi_epu16(c_l, x2), _mm_and_si128(c_l, _mm_srai_epi16(x2, 15)));
+
+            acc1_lo = _mm_add_epi32(acc1_lo, _mm_madd_epi16(_mm_unpacklo_epi16(x1, t1), ch_lo));
+            acc1_hi = _mm_add_epi32(acc1_hi, _mm_madd_epi16(_mm_unpackhi_epi16(x1, t1), ch_hi));
+            acc2_lo = _mm_add_epi32(acc2_lo, _mm_madd_epi16(_mm_unpacklo_epi16(x2, t2), ch_lo));
+            acc2_hi = _mm_add_epi32(acc2_hi, _mm_madd_epi16(_mm_unpackhi_epi16(x2, t2), ch_hi));
+        }
+
+        _mm_storeu_si128((__m128i *)&Y[1 + j], acc1_lo);
+        _mm_storeu_si128((__m128i *)&Y[5 + j], acc1_hi);
+        _mm_storeu_si128((__m128i *)&Y[60 - j], _mm_shuffle_epi32(acc2_lo, _MM_SHUFFLE(0, 1, 2, 3)));
+        _mm_storeu_si128((__m128i *)&Y[56 - j], _mm_shuffle_epi32(acc2_hi, _MM_SHUFFLE(0, 1, 2, 3)));
+
+#else /* PV_SIMD_NEON */
+
+        int32x4_t acc1_lo = vdupq_n_s32(0);
+        int32x4_t acc1_hi = acc1_lo;
+        int32x4_t acc2_lo = acc1_lo;
+        int32x4_t acc2_hi = acc1_lo;
+
+        for (k = 0; k < 5; k++)
+        {
+            int32x4_t c_lo = vld1q_s32(&pt_C[32*k + j]);
+            int32x4_t c_hi = vld1q_s32(&pt_C[32*k + j + 4]);
+
+            /* X is read backwards for the first half, reverse the 8 lanes */
+            int16x8_t x1 = vrev64q_s16(vld1q_s16(&X[-8 - j - 64*k]));
+            int16x8_t x2 = vld1q_s16(&X[-319 + j + 64*k]);
+            x1 = vcombine_s16(vget_high_s16(x1), vget_low_s16(x1));
+
+            /* (2 * C * (x << 15)) >> 32 == (C * (x << 16)) >> 32, never saturates */
+            acc1_lo = vaddq_s32(acc1_lo, vqdmulhq_s32(c_lo, vshll_n_s16(vget_low_s16(x1), 15)));
+            acc1_hi = vaddq_s32(acc1_hi, vqdmulhq_s32(c_hi, vshll_n_s16(vget_high_s16(x1), 15)));
+            acc2_lo = vaddq_s32(acc2_lo, vqdmulhq_s32(c_lo, vshll_n_s16(vget_low_s16(x2), 15)));
+            acc2_hi = vaddq_s32(acc2_hi, vqdmulhq_s32(c_hi, vshll_n_s16(vget_high_s16(x2), 15)));
+        }
+
+        acc2_lo = vrev64q_s32(acc2_lo);
+        acc2_hi = vrev64q_s32(acc2_hi);
+        vst1q_s32(&Y[1 + j], acc1_lo);
+        vst1q_s32(&Y[5 + j], acc1_hi);
+        vst1q_s32(&Y[60 - j], vcombine_s32(vget_high_s32(acc2_lo), vget_low_s32(acc2_lo)));
+        vst1q_s32(&Y[56 - j], vcombine_s32(vget_high_s32(acc2_hi), vget_low_s32(acc2_hi)));
 
+#endif
     }
+}
+
+#endif
 
 
-    tmp1 = *(pt_X_1--);
-    tmp2 = *(pt_X_2++);
-    realAccu1  = fxp_mul32_by_16(*(pt_C), tmp1);
-    realAccu2  = fxp_mul32_by_16(*(pt_C++), tmp2);
+void calc_sbr_anafilterbank_LC(Int32 * Sr,
+                               Int16 * X,
+                               Int32 scratch_mem[][64],
+                               Int32 maxBand)
+{
+    Int32   *p_Y = scratch_mem[0];
+    Int32 realAccu1;
+    Int32 realAccu2;
 
-    tmp1 = pt_X_1[ -63];
-    tmp2 = pt_X_2[ +63];
-    realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-    realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
-    tmp1 = pt_X_1[ -127];
-    tmp2 = pt_X_2[ +127];
-    realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-    realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
-    tmp1 = pt_X_1[ -191];
-    tmp2 = pt_X_2[ +191];
-    realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-    realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
-    tmp1 = pt_X_1[ -255];
-    tmp2 = pt_X_2[ +255];
-    *(p_Y_1++) = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-    *(p_Y_2--) = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
 
+    realAccu1  =  fxp_mul32_by_16(Qfmt27(-0.51075594183097F),   X[-192]);
+
+    realAccu1  =  fxp_mac32_by_16(Qfmt27(-0.51075594183097F), -X[-128], realAccu1);
+    realAccu1  =  fxp_mac32_by_16(Qfmt27(-0.01876919066980F),  X[-256], realAccu1);
+    p_Y[0]     =  fxp_mac32_by_16(Qfmt27(-0.01876919066980F), -X[ -64], realAccu1);
+
+
+    /* create array Y */
+
+    pv_simd->anafilterbank_window(p_Y, X, false);
 
-    pt_X_1 = X;
 
     realAccu2  = fxp_mul32_by_16(Qfmt27(0.00370548843500F), X[ -32]);
 
-    realAccu2  = fxp_mac32_by_16(Qfmt27(0.00370548843500F), pt_X_1[-288], realAccu2);
-    realAccu2  = fxp_mac32_by_16(Qfmt27(0.09949460091720F), pt_X_1[ -96], realAccu2);
-    realAccu2  = fxp_mac32_by_16(Qfmt27(0.09949460091720F), pt_X_1[-224], realAccu2);
-    *(p_Y_1++) = fxp_mac32_by_16(Qfmt27(1.20736865027288F), pt_X_1[-160], realAccu2);
+    realAccu2  = fxp_mac32_by_16(Qfmt27(0.00370548843500F), X[-288], realAccu2);
+    realAccu2  = fxp_mac32_by_16(Qfmt27(0.09949460091720F), X[ -96], realAccu2);
+    realAccu2  = fxp_mac32_by_16(Qfmt27(0.09949460091720F), X[-224], realAccu2);
+    p_Y[32]    = fxp_mac32_by_16(Qfmt27(1.20736865027288F), X[-160], realAccu2);
 
 
     analysis_sub_band_LC(scratch_mem[0],
@@ -273,65 +450,21 @@ void calc_sbr_anafilterbank(Int32 * Sr,
                             Int32 scratch_mem[][64],
                             Int32   maxBand)
 {
-    Int i;
-    Int32   *p_Y_1;
-    Int32   *p_Y_2;
-
-
-
-
-    const Int32 * pt_C;
-    Int16 * pt_X_1;
-    Int16 * pt_X_2;
+    Int32   *p_Y = scratch_mem[0];
     Int32 realAccu1;
     Int32 realAccu2;
 
-    Int32 tmp1;
-    Int32 tmp2;
-
-
-    p_Y_1 = scratch_mem[0];
-
-
-    p_Y_2 = p_Y_1 + 63;
-    pt_C   = &sbrDecoderFilterbankCoefficients_an_filt[0];
 
     realAccu1  =  fxp_mul32_by_16(Qfmt27(-0.36115899F),   X[-192]);
 
 
     realAccu1  =  fxp_mac32_by_16(Qfmt27(-0.36115899F),  -X[-128], realAccu1);
     realAccu1  =  fxp_mac32_by_16(Qfmt27(-0.013271822F),  X[-256], realAccu1);
-    *(p_Y_1++) =  fxp_mac32_by_16(Qfmt27(-0.013271822F), -X[ -64], realAccu1);
+    p_Y[0]     =  fxp_mac32_by_16(Qfmt27(-0.013271822F), -X[ -64], realAccu1);
 
     /* create array Y */
 
-    pt_X_1 = &X[-1];
-    pt_X_2 = &X[-319];
-
-
-    for (i = 31; i != 0; i--)
-    {
-        tmp1 = *(pt_X_1--);
-        tmp2 = *(pt_X_2++);
-        realAccu1  = fxp_mul32_by_16(*(pt_C), tmp1);
-        realAccu2  = fxp_mul32_by_16(*(pt_C++), tmp2);
-        tmp1 = pt_X_1[ -63];
-        tmp2 = pt_X_2[  63];
-        realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-        realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
-        tmp1 = pt_X_1[ -127];
-        tmp2 = pt_X_2[  127];
-        realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-        realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
-        tmp1 = pt_X_1[ -191];
-        tmp2 = pt_X_2[  191];
-        realAccu1  = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-        realAccu2  = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
-        tmp1 = pt_X_1[ -255];
-        tmp2 = pt_X_2[  255];
-        *(p_Y_1++) = fxp_mac32_by_16(*(pt_C), tmp1, realAccu1);
-        *(p_Y_2--) = fxp_mac32_by_16(*(pt_C++), tmp2, realAccu2);
-    }
+    pv_simd->anafilterbank_window(p_Y, X, true);
 
 
     realAccu2  = fxp_mul32_by_16(Qfmt27(0.002620176F), X[ -32]);
@@ -340,7 +473,7 @@ void calc_sbr_anafilterbank(Int32 * Sr,
     realAccu2  = fxp_mac32_by_16(Qfmt27(0.070353307F), X[-224], realAccu2);
 
 
-    *(p_Y_1++) = fxp_mac32_by_16(Qfmt27(0.85373856F), (X[-160]), realAccu2);
+    p_Y[32]    = fxp_mac32_by_16(Qfmt27(0.85373856F), (X[-160]), realAccu2);
 
 
     analysis_sub_band(scratch_mem[0],
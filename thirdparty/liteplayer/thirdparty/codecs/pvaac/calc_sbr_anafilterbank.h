@@ -43,6 +43,7 @@
 ----------------------------------------------------------------------------*/
 
 #include "pv_audio_type_defs.h"
+#include "fxp_simd.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -85,6 +86,14 @@ extern "C"
     ; Function Prototype declaration
     ----------------------------------------------------------------------------*/
 
+    void calc_sbr_anafilterbank_window_c(Int32 * Y,
+                                         const Int16 * X,
+                                         Bool bHQ);
+#if defined(PV_SIMD_SSE2) || defined(PV_SIMD_NEON)
+    void calc_sbr_anafilterbank_window_simd(Int32 * Y,
+                                            const Int16 * X,
+                                            Bool bHQ);
+#endif
 
     void calc_sbr_anafilterbank_LC(Int32 * Sr,
     Int16 * X,
@@ -87,6 +87,7 @@ Copyright (c) ISO/IEC 2002.
 #include    "qmf_filterbank_coeff.h"
 #include    "synthesis_sub_band.h"
 #include    "fxp_mul32.h"
+#include    "fxp_simd.h"
 #include    "aac_mem_funcs.h"
 
 /*----------------------------------------------------------------------------
@@ -214,6 +215,66 @@ __inline Int16 sat(Int32 y)
 ; Variable declaration - defined here and used outside this module
 ----------------------------------------------------------------------------*/
 
+#if defined(PV_SIMD_SSE2) || defined(PV_SIMD_NEON)
+/*
+ *  sbrDecoderFilterbankCoefficients[] transposed for the vector window:
+ *  row k holds, for every output sample i, the pair (top, bottom) of
+ *  sbrDecoderFilterbankCoefficients[5*i + k]. Sample 31 is zero padding.
+ */
+static const Int16 sbrDecoderFilterbankCoefficients_simd[5*64] =
+{
+       -22,    102,    -22,    108,    -20,    114,    -19,    120,
+       -19,    126,    -20,    132,    -21,    137,    -21,    143,
+       -22,    149,    -23,    154,    -24,    160,    -24,    165,
+       -25,    170,    -26,    175,    -27,    179,    -28,    184,
+       -28,    188,    -29,    191,    -29,    195,    -29,    198,
+       -30,    200,    -30,    202,    -30,    204,    -30,    205,
+       -30,    206,    -30,    206,    -29,    205,    -29,    204,
+       -28,    202,    -28,    200,    -27,    197,      0,      0,
+
+       524,   2511,    566,   2456,    610,   2395,    654,   2329,
+       699,   2256,    745,   2178,    792,   2095,    840,   2005,
+       889,   1909,    939,   1806,    990,   1698,   1042,   1583,
+      1095,   1462,   1147,   1335,   1201,   1200,   1255,   1059,
+      1310,    912,   1365,    758,   1421,    596,   1476,    429,
+      1532,    254,   1588,     72,   1644,   -118,   1700,   -314,
+      1756,   -516,   1811,   -725,   1867,   -942,   1921,  -1165,
+      1975,  -1395,   2029,  -1632,   2082,  -1876,      0,      0,
+
+     13558,  31077,  13968,  31060,  14379,  31031,  14790,  30991,
+     15203,  30939,  15616,  30875,  16029,  30801,  16442,  30715,
+     16855,  30618,  17267,  30509,  17677,  30390,  18087,  30259,
+     18495,  30118,  18901,  29966,  19305,  29803,  19706,  29630,
+     20105,  29446,  20501,  29252,  20893,  29048,  21282,  28834,
+     21667,  28611,  22048,  28378,  22424,  28136,  22796,  27884,
+     23163,  27623,  23525,  27354,  23880,  27076,  24230,  26790,
+     24575,  26496,  24912,  26194,  25243,  25884,      0,      0,
+
+    -12744,   2607, -12339,   2647, -11936,   2682, -11536,   2712,
+    -11139,   2737, -10744,   2758, -10353,   2774,  -9965,   2786,
+     -9581,   2794,  -9200,   2797,  -8823,   2797,  -8451,   2793,
+     -8083,   2786,  -7719,   2775,  -7360,   2760,  -7006,   2743,
+     -6657,   2722,  -6314,   2698,  -5976,   2671,  -5643,   2643,
+     -5316,   2611,  -4995,   2577,  -4680,   2540,  -4371,   2502,
+     -4068,   2462,  -3771,   2419,  -3480,   2375,  -3196,   2330,
+     -2919,   2283,  -2648,   2234,  -2384,   2184,      0,      0,
+
+      -445,     90,   -407,     84,   -370,     79,   -334,     73,
+      -299,     67,   -266,     62,   -234,     57,   -203,     51,
+      -173,     46,   -145,     41,   -118,     36,    -92,     32,
+       -67,     28,    -44,     23,    -21,     19,      2,     15,
+        22,     11,     40,      8,     58,      4,     74,      1,
+        90,     -4,    104,     -7,    117,     -9,    129,    -12,
+       141,    -14,    151,    -16,    160,    -18,    168,    -20,
+       176,    -22,    182,    -23,    188,    -25,      0,      0
+};
+
+/* distance of the 10 taps from the first sample read for each output */
+static const Int16 synfil_tap_offset[10] =
+{
+    0, 192, 256, 448, 512, 704, 768, 960, 1024, 1216
+};
+#endif
 
 
 
@@ -231,6 +292,212 @@ __inline Int16 sat(Int32 y)
 ; FUNCTION CODE
 ----------------------------------------------------------------------------*/
 
+/*
+ *  window the 1280 samples of V[] and write the 62 samples timeSig[2..62] and
+ *  timeSig[66..126] (even positions only), C reference
+ */
+void calc_sbr_synfilterbank_window_c(Int16 * timeSig, const Int16 V[1280])
+{
+    Int32 i;
+
+    Int32   realAccu1;
+    Int32   realAccu2;
+    const Int32 *pt_C2;
+
+    const Int16 *pt_V1;
+    const Int16 *pt_V2;
+
+    Int16 *pt_timeSig;
+    Int16 *pt_timeSig_2;
+    Int32  test1;
+    Int16  tmp1;
+    Int16  tmp2;
+
+pt_timeSig   = &timeSig[2];
+pt_timeSig_2 = &timeSig[126];
+
+    pt_V1 = &V[1];
+    pt_V2 = &V[1279];
+
+    pt_C2 = &sbrDecoderFilterbankCoefficients[0];
+
+    for (i = 31; i != 0; i--)
+    {
+        test1 = *(pt_C2++);
+        tmp1 = *(pt_V1++);
+        tmp2 = *(pt_V2--);
+        realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, ROUND_SYNFIL);
+        realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, ROUND_SYNFIL);
+        tmp1 = pt_V1[  191];
+        tmp2 = pt_V2[ -191];
+        realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
+        realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
+
+        test1 = *(pt_C2++);
+        tmp1 = pt_V1[  255];
+        tmp2 = pt_V2[ -255];
+        realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
+        realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
+        tmp1 = pt_V1[  447];
+        tmp2 = pt_V2[ -447];
+        realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
+        realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
+
+        test1 = *(pt_C2++);
+        tmp1 = pt_V1[  511];
+        tmp2 = pt_V2[ -511];
+        realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
+        realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
+        tmp1 = pt_V1[  703];
+        tmp2 = pt_V2[ -703];
+        realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
+        realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
+
+        test1 = *(pt_C2++);
+        tmp1 = pt_V1[  767];
+        tmp2 = pt_V2[ -767];
+        realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
+        realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
+        tmp1 = pt_V1[  959];
+        tmp2 = pt_V2[ -959];
+        realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
+        realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
+
+        test1 = *(pt_C2++);
+        tmp1 = pt_V1[  1023];
+        tmp2 = pt_V2[ -1023];
+        realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
+        realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
+        tmp1 = pt_V1[  1215];
+        tmp2 = pt_V2[ -1215];
+        realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
+        realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
+
+        saturate2(realAccu1, realAccu2, pt_timeSig, pt_timeSig_2);
+
+    }
+}
+
+
+#if defined(PV_SIMD_SSE2) || defined(PV_SIMD_NEON)
+
+/*
+ *  same as calc_sbr_synfilterbank_window_c(), 8 output samples per iteration.
+ *  All products and sums are done in 32-bit two's complement as in the C
+ *  reference, and the packing saturation matches saturate2(), so the output
+ *  is bit-exact.
+ */
+PV_SIMD_TARGET void calc_sbr_synfilterbank_window_simd(Int16 * timeSig, const Int16 V[1280])
+{
+    Int32 i;
+    Int32 k;
+    Int32 p;
+
+    Int16 out1[8];
+    Int16 out2[8];
+
+    for (i = 0; i < 32; i += 8)
+    {
+        const Int16 *pt_C  = &sbrDecoderFilterbankCoefficients_simd[i << 1];
+        const Int16 *pt_V1 = &V[1 + i];
+        const Int16 *pt_V2 = &V[1279 - 7 - i];
+
+#if defined(PV_SIMD_SSE2)
+
+        __m128i acc1_lo = _mm_set1_epi32(ROUND_SYNFIL);
+        __m128i acc1_hi = acc1_lo;
+        __m128i acc2_lo = acc1_lo;
+        __m128i acc2_hi = acc1_lo;
+
+        for (p = 0; p < 10; p += 2)
+        {
+            Int32 off_a = synfil_tap_offset[p];
+            Int32 off_b = synfil_tap_offset[p + 1];
+
+            __m128i c_lo = _mm_loadu_si128((const __m128i *)(pt_C));
+            __m128i c_hi = _mm_loadu_si128((const __m128i *)(pt_C + 8));
+            pt_C += 64;
+
+            __m128i va = _mm_loadu_si128((const __m128i *)(pt_V1 + off_a));
+            __m128i vb = _mm_loadu_si128((const __m128i *)(pt_V1 + off_b));
+            acc1_lo = _mm_add_epi32(acc1_lo, _mm_madd_epi16(_mm_unpacklo_epi16(va, vb), c_lo));
+            acc1_hi = _mm_add_epi32(acc1_hi, _mm_madd_epi16(_mm_unpackhi_epi16(va, vb), c_hi));
+
+            /* V is read backwards for the second half, reverse the 8 lanes */
+            va = _mm_loadu_si128((const __m128i *)(pt_V2 - off_a));
+            vb = _mm_loadu_si128((const __m128i *)(pt_V2 - off_b));
+            va = _mm_shuffle_epi32(va, _MM_SHUFFLE(0, 1, 2, 3));
+            vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 1, 2, 3));
+            va = _mm_shufflehi_epi16(_mm_shufflelo_epi16(va, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+            vb = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vb, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+            acc2_lo = _mm_add_epi32(acc2_lo, _mm_madd_epi16(_mm_unpacklo_epi16(va, vb), c_lo));
+            acc2_hi = _mm_add_epi32(acc2_hi, _mm_madd_epi16(_mm_unpackhi_epi16(va, vb), c_hi));
+        }
+
+        /* a -= a>>2; a >>= N; saturate to 16 bits */
+        acc1_lo = _mm_srai_epi32(_mm_sub_epi32(acc1_lo, _mm_srai_epi32(acc1_lo, 2)), N);
+        acc1_hi = _mm_srai_epi32(_mm_sub_epi32(acc1_hi, _mm_srai_epi32(acc1_hi, 2)), N);
+        acc2_lo = _mm_srai_epi32(_mm_sub_epi32(acc2_lo, _mm_srai_epi32(acc2_lo, 2)), N);
+        acc2_hi = _mm_srai_epi32(_mm_sub_epi32(acc2_hi, _mm_srai_epi32(acc2_hi, 2)), N);
+        _mm_storeu_si128((__m128i *)out1, _mm_packs_epi32(acc1_lo, acc1_hi));
+        _mm_storeu_si128((__m128i *)out2, _mm_packs_epi32(acc2_lo, acc2_hi));
+
+#else /* PV_SIMD_NEON */
+
+        int32x4_t acc1_lo = vdupq_n_s32(ROUND_SYNFIL);
+        int32x4_t acc1_hi = acc1_lo;
+        int32x4_t acc2_lo = acc1_lo;
+        int32x4_t acc2_hi = acc1_lo;
+
+        for (p = 0; p < 10; p += 2)
+        {
+            Int32 off_a = synfil_tap_offset[p];
+            Int32 off_b = synfil_tap_offset[p + 1];
+
+            /* c.val[0]: top halves, c.val[1]: bottom halves */
+            int16x8x2_t c = vld2q_s16(pt_C);
+            pt_C += 64;
+
+            int16x8_t va = vld1q_s16(pt_V1 + off_a);
+            int16x8_t vb = vld1q_s16(pt_V1 + off_b);
+            acc1_lo = vmlal_s16(acc1_lo, vget_low_s16(va),  vget_low_s16(c.val[0]));
+            acc1_hi = vmlal_s16(acc1_hi, vget_high_s16(va), vget_high_s16(c.val[0]));
+            acc1_lo = vmlal_s16(acc1_lo, vget_low_s16(vb),  vget_low_s16(c.val[1]));
+            acc1_hi = vmlal_s16(acc1_hi, vget_high_s16(vb), vget_high_s16(c.val[1]));
+
+            /* V is read backwards for the second half, reverse the 8 lanes */
+            va = vrev64q_s16(vld1q_s16(pt_V2 - off_a));
+            vb = vrev64q_s16(vld1q_s16(pt_V2 - off_b));
+            va = vcombine_s16(vget_high_s16(va), vget_low_s16(va));
+            vb = vcombine_s16(vget_high_s16(vb), vget_low_s16(vb));
+            acc2_lo = vmlal_s16(acc2_lo, vget_low_s16(va),  vget_low_s16(c.val[0]));
+            acc2_hi = vmlal_s16(acc2_hi, vget_high_s16(va), vget_high_s16(c.val[0]));
+            acc2_lo = vmlal_s16(acc2_lo, vget_low_s16(vb),  vget_low_s16(c.val[1]));
+            acc2_hi = vmlal_s16(acc2_hi, vget_high_s16(vb), vget_high_s16(c.val[1]));
+        }
+
+        /* a -= a>>2; a >>= N; saturate to 16 bits */
+        acc1_lo = vshrq_n_s32(vsubq_s32(acc1_lo, vshrq_n_s32(acc1_lo, 2)), N);
+        acc1_hi = vshrq_n_s32(vsubq_s32(acc1_hi, vshrq_n_s32(acc1_hi, 2)), N);
+        acc2_lo = vshrq_n_s32(vsubq_s32(acc2_lo, vshrq_n_s32(acc2_lo, 2)), N);
+        acc2_hi = vshrq_n_s32(vsubq_s32(acc2_hi, vshrq_n_s32(acc2_hi, 2)), N);
+        vst1q_s16(out1, vcombine_s16(vqmovn_s32(acc1_lo), vqmovn_s32(acc1_hi)));
+        vst1q_s16(out2, vcombine_s16(vqmovn_s32(acc2_lo), vqmovn_s32(acc2_hi)));
+
+#endif
+
+        /* 31 output pairs, the last lane of the last block is padding */
+        for (k = 0; k < 8 && (i + k) < 31; k++)
+        {
+            timeSig[  2 + ((i + k) << 1)] = out1[k];
+            timeSig[126 - ((i + k) << 1)] = out2[k];
+        }
+    }
+}
+
+#endif
+
+
 void calc_sbr_synfilterbank_LC(Int32 * Sr,
                                Int16 * timeSig,
                                Int16   V[1280],
@@ -249,7 +516,6 @@ void calc_sbr_synfilterbank_LC(Int32 * Sr,
     Int16 *pt_timeSig;
 
     Int16 *pt_timeSig_2;
-    Int32  test1;
     Int16  tmp1;
     Int16  tmp2;
 
@@ -312,68 +578,7 @@ void calc_sbr_synfilterbank_LC(Int32 * Sr,
 
         saturate2(realAccu1, realAccu2, pt_timeSig, pt_timeSig_2);
 
-        pt_timeSig_2 = &timeSig[126];
-
-        pt_V1 = &V[1];
-        pt_V2 = &V[1279];
-
-        pt_C2 = &sbrDecoderFilterbankCoefficients[0];
-
-        for (i = 31; i != 0; i--)
-        {
-            test1 = *(pt_C2++);
-            tmp1 = *(pt_V1++);
-            tmp2 = *(pt_V2--);
-            realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, ROUND_SYNFIL);
-            realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, ROUND_SYNFIL);
-            tmp1 = pt_V1[  191];
-            tmp2 = pt_V2[ -191];
-            realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
-
-            test1 = *(pt_C2++);
-            tmp1 = pt_V1[  255];
-            tmp2 = pt_V2[ -255];
-            realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
-            tmp1 = pt_V1[  447];
-            tmp2 = pt_V2[ -447];
-            realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
-
-            test1 = *(pt_C2++);
-            tmp1 = pt_V1[  511];
-            tmp2 = pt_V2[ -511];
-            realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
-            tmp1 = pt_V1[  703];
-            tmp2 = pt_V2[ -703];
-            realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
-
-            test1 = *(pt_C2++);
-            tmp1 = pt_V1[  767];
-            tmp2 = pt_V2[ -767];
-            realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
-            tmp1 = pt_V1[  959];
-            tmp2 = pt_V2[ -959];
-            realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
-
-            test1 = *(pt_C2++);
-            tmp1 = pt_V1[  1023];
-            tmp2 = pt_V2[ -1023];
-            realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
-            tmp1 = pt_V1[  1215];
-            tmp2 = pt_V2[ -1215];
-            realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
-
-            saturate2(realAccu1, realAccu2, pt_timeSig, pt_timeSig_2);
-
-        }
+        pv_simd->synfilterbank_window(timeSig, V);
     }
     else
     {
@@ -455,7 +660,6 @@ void calc_sbr_synfilterbank(Int32 * Sr,
     Int16 *pt_timeSig;
 
     Int16 *pt_timeSig_2;
-    Int32  test1;
     Int16  tmp1;
     Int16  tmp2;
 
@@ -510,67 +714,7 @@ void calc_sbr_synfilterbank(Int32 * Sr,
 
         saturate2(realAccu1, realAccu2, pt_timeSig, pt_timeSig_2);
 
-        pt_timeSig_2 = &timeSig[126];
-
-        pt_V1 = &V[1];
-        pt_V2 = &V[1279];
-
-        pt_C2 = &sbrDecoderFilterbankCoefficients[0];
-
-        for (i = 31; i != 0; i--)
-        {
-            test1 = *(pt_C2++);
-            tmp1 = *(pt_V1++);
-            tmp2 = *(pt_V2--);
-            realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, ROUND_SYNFIL);
-            realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, ROUND_SYNFIL);
-            tmp1 = pt_V1[  191];
-            tmp2 = pt_V2[ -191];
-            realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
-
-            test1 = *(pt_C2++);
-            tmp1 = pt_V1[  255];
-            tmp2 = pt_V2[ -255];
-            realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
-            tmp1 = pt_V1[  447];
-            tmp2 = pt_V2[ -447];
-            realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
-
-            test1 = *(pt_C2++);
-            tmp1 = pt_V1[  511];
-            tmp2 = pt_V2[ -511];
-            realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
-            tmp1 = pt_V1[  703];
-            tmp2 = pt_V2[ -703];
-            realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
-
-            test1 = *(pt_C2++);
-            tmp1 = pt_V1[  767];
-            tmp2 = pt_V2[ -767];
-            realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
-            tmp1 = pt_V1[  959];
-            tmp2 = pt_V2[ -959];
-            realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
-
-            test1 = *(pt_C2++);
-            tmp1 = pt_V1[  1023];
-            tmp2 = pt_V2[ -1023];
-            realAccu1 =  fxp_mac_16_by_16_bt(tmp1 , test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bt(tmp2 , test1, realAccu2);
-            tmp1 = pt_V1[  1215];
-            tmp2 = pt_V2[ -1215];
-            realAccu1 =  fxp_mac_16_by_16_bb(tmp1, test1, realAccu1);
-            realAccu2 =  fxp_mac_16_by_16_bb(tmp2, test1, realAccu2);
-
-            saturate2(realAccu1, realAccu2, pt_timeSig, pt_timeSig_2);
-        }
+        pv_simd->synfilterbank_window(timeSig, V);
 
     }
     else
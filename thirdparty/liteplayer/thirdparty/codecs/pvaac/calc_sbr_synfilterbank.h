@@ -26,6 +26,7 @@
 ; INCLUDES
 ----------------------------------------------------------------------------*/
 #include "pv_audio_type_defs.h"
+#include "fxp_simd.h"
 
 /*----------------------------------------------------------------------------
 ; MACROS
@@ -67,6 +68,14 @@ extern "C"
     ----------------------------------------------------------------------------*/
 
 
+    void calc_sbr_synfilterbank_window_c(Int16 * timeSig,
+                                         const Int16 V[1280]);
+
+#if defined(PV_SIMD_SSE2) || defined(PV_SIMD_NEON)
+    void calc_sbr_synfilterbank_window_simd(Int16 * timeSig,
+                                            const Int16 V[1280]);
+#endif
+
     void calc_sbr_synfilterbank_LC(Int32 * Sr,
     Int16 * timeSig,
     Int16   V[1280],
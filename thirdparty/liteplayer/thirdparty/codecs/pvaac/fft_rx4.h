@@ -46,6 +46,7 @@
 ; INCLUDES
 ----------------------------------------------------------------------------*/
 #include "pv_audio_type_defs.h"
+#include "fxp_simd.h"
 
 /*----------------------------------------------------------------------------
 ; MACROS
@@ -92,10 +93,16 @@ extern "C"
 {
 #endif
 
-    void fft_rx4_long(
+    void fft_rx4_long_c(
         Int32      Data[],
         Int32      *peak_value);
 
+#if defined(PV_SIMD_SSE2) || defined(PV_SIMD_NEON)
+    void fft_rx4_long_simd(
+        Int32      Data[],
+        Int32      *peak_value);
+#endif
+
     Int fft_rx4_short(
         Int32      Data[],
         Int32      *peak_value);
@@ -18,7 +18,7 @@
 /*
 
  Pathname: ./src/fft_rx4_long.c
- Funtions: fft_rx4_long
+ Funtions: fft_rx4_long_c, fft_rx4_long_simd
 
 ------------------------------------------------------------------------------
  REVISION HISTORY
@@ -190,7 +190,7 @@
 ----------------------------------------------------------------------------*/
 
 
-void fft_rx4_long(
+void fft_rx4_long_c(
     Int32      Data[],
     Int32      *peak_value)
 
@@ -426,3 +426,279 @@ void fft_rx4_long(
 
 }
 
+
+
+#if defined(PV_SIMD_SSE2) || defined(PV_SIMD_NEON)
+
+#if defined(PV_SIMD_SSE2)
+
+/* re[], im[] of 4 consecutive complex values */
+static inline PV_SIMD_TARGET void fft_load_cmplx(const Int32 *p, __m128i *re, __m128i *im)
+{
+    __m128i lo = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)p), _MM_SHUFFLE(3, 1, 2, 0));
+    __m128i hi = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(p + 4)), _MM_SHUFFLE(3, 1, 2, 0));
+    *re = _mm_unpacklo_epi64(lo, hi);
+    *im = _mm_unpackhi_epi64(lo, hi);
+}
+
+static inline PV_SIMD_TARGET void fft_store_cmplx(Int32 *p, __m128i re, __m128i im)
+{
+    _mm_storeu_si128((__m128i *)p, _mm_unpacklo_epi32(re, im));
+    _mm_storeu_si128((__m128i *)(p + 4), _mm_unpackhi_epi32(re, im));
+}
+
+#endif
+
+/*
+ *  same as fft_rx4_long_c(). The dragonflies of 4 consecutive j (twiddles)
+ *  run side by side, j = 0 takes the untwiddled outputs, the last stage does
+ *  one dragonfly per iteration across the lanes. The multiplications are
+ *  exact replicas of cmplx_mul32_by_16(), so the output is bit-exact.
+ */
+PV_SIMD_TARGET void fft_rx4_long_simd(
+    Int32      Data[],
+    Int32      *peak_value)
+{
+    Int     n1;
+    Int     n2;
+    Int     j;
+    Int     k;
+    Int     i;
+    Int     l;
+
+    Int32   *pData1;
+    Int32   *pData2;
+    Int32   *pData3;
+    Int32   *pData4;
+
+    Int32   w[3][4];
+
+    const Int32  *pw = W_256rx4;
+
+    n2 = FFT_RX4_LONG;
+
+    for (k = FFT_RX4_LONG; k > 4; k >>= 2)
+    {
+
+        n1 = n2;
+        n2 >>= 2;
+
+        for (j = 0; j < n2; j += 4)
+        {
+            /* exp_jw1..3 of the 4 lanes, j = 0 has no twiddles */
+            for (l = 0; l < 4; l++)
+            {
+                w[0][l] = (j + l) ? pw[3*(j + l - 1)    ] : 0;
+                w[1][l] = (j + l) ? pw[3*(j + l - 1) + 1] : 0;
+                w[2][l] = (j + l) ? pw[3*(j + l - 1) + 2] : 0;
+            }
+
+#if defined(PV_SIMD_SSE2)
+
+            __m128i first = (j == 0) ? _mm_set_epi32(0, 0, 0, -1) : _mm_setzero_si128();
+            __m128i w1h, w1l, w2h, w2l, w3h, w3l;
+
+            simd_split_exp_jw(_mm_loadu_si128((const __m128i *)w[0]), &w1h, &w1l);
+            simd_split_exp_jw(_mm_loadu_si128((const __m128i *)w[1]), &w2h, &w2l);
+            simd_split_exp_jw(_mm_loadu_si128((const __m128i *)w[2]), &w3h, &w3l);
+
+            for (i = j; i < FFT_RX4_LONG; i += n1)
+            {
+                __m128i ar, ai, br, bi, cr, ci, dr, di;
+                __m128i r1, r2, r3, r4, s1, s2, t1, t2;
+                __m128i x, y, x2, y2, zr, zi;
+
+                pData1 = &Data[ i<<1];
+                pData2 = pData1 + n1;
+                pData3 = pData1 + (n1 >> 1);
+                pData4 = pData3 + n1;
+
+                fft_load_cmplx(pData1, &ar, &ai);
+                fft_load_cmplx(pData2, &br, &bi);
+                fft_load_cmplx(pData3, &cr, &ci);
+                fft_load_cmplx(pData4, &dr, &di);
+
+                r1 = _mm_add_epi32(ar, br);
+                r2 = _mm_sub_epi32(ar, br);
+                r3 = _mm_add_epi32(cr, dr);
+                r4 = _mm_sub_epi32(cr, dr);
+                s1 = _mm_add_epi32(ai, bi);
+                s2 = _mm_sub_epi32(ai, bi);
+                t1 = _mm_add_epi32(ci, di);
+                t2 = _mm_sub_epi32(ci, di);
+
+                fft_store_cmplx(pData1, _mm_add_epi32(r1, r3), _mm_add_epi32(s1, t1));
+
+                /* (x, y) before the twiddle, x<<1 and y<<1 multiplied by exp_jw */
+                x  = _mm_sub_epi32(r1, r3);
+                y  = _mm_sub_epi32(s1, t1);
+                x2 = _mm_slli_epi32(x, 1);
+                y2 = _mm_slli_epi32(y, 1);
+                zr = simd_cmplx_mul32_by_16(x2, y2, w2h, w2l);
+                zi = simd_cmplx_mul32_by_16(y2, _mm_sub_epi32(_mm_setzero_si128(), x2), w2h, w2l);
+                zr = _mm_or_si128(_mm_and_si128(first, x), _mm_andnot_si128(first, zr));
+                zi = _mm_or_si128(_mm_and_si128(first, y), _mm_andnot_si128(first, zi));
+                fft_store_cmplx(pData2, zr, zi);
+
+                x  = _mm_add_epi32(r2, t2);
+                y  = _mm_sub_epi32(s2, r4);
+                x2 = _mm_slli_epi32(x, 1);
+                y2 = _mm_slli_epi32(y, 1);
+                zr = simd_cmplx_mul32_by_16(x2, y2, w1h, w1l);
+                zi = simd_cmplx_mul32_by_16(y2, _mm_sub_epi32(_mm_setzero_si128(), x2), w1h, w1l);
+                zr = _mm_or_si128(_mm_and_si128(first, x), _mm_andnot_si128(first, zr));
+                zi = _mm_or_si128(_mm_and_si128(first, y), _mm_andnot_si128(first, zi));
+                fft_store_cmplx(pData3, zr, zi);
+
+                x  = _mm_sub_epi32(r2, t2);
+                y  = _mm_add_epi32(s2, r4);
+                x2 = _mm_slli_epi32(x, 1);
+                y2 = _mm_slli_epi32(y, 1);
+                zr = simd_cmplx_mul32_by_16(x2, y2, w3h, w3l);
+                zi = simd_cmplx_mul32_by_16(y2, _mm_sub_epi32(_mm_setzero_si128(), x2), w3h, w3l);
+                zr = _mm_or_si128(_mm_and_si128(first, x), _mm_andnot_si128(first, zr));
+                zi = _mm_or_si128(_mm_and_si128(first, y), _mm_andnot_si128(first, zi));
+                fft_store_cmplx(pData4, zr, zi);
+            }
+
+#else /* PV_SIMD_NEON */
+
+            static const uint32_t first_lane[4] = { 0xFFFFFFFF, 0, 0, 0 };
+            uint32x4_t first = (j == 0) ? vld1q_u32(first_lane) : vdupq_n_u32(0);
+            int32x4_t w1h, w1l, w2h, w2l, w3h, w3l;
+
+            simd_split_exp_jw(vld1q_s32(w[0]), &w1h, &w1l);
+            simd_split_exp_jw(vld1q_s32(w[1]), &w2h, &w2l);
+            simd_split_exp_jw(vld1q_s32(w[2]), &w3h, &w3l);
+
+            for (i = j; i < FFT_RX4_LONG; i += n1)
+            {
+                int32x4x2_t a, b, c, d, z;
+                int32x4_t r1, r2, r3, r4, s1, s2, t1, t2;
+                int32x4_t x, y;
+
+                pData1 = &Data[ i<<1];
+                pData2 = pData1 + n1;
+                pData3 = pData1 + (n1 >> 1);
+                pData4 = pData3 + n1;
+
+                a = vld2q_s32(pData1);
+                b = vld2q_s32(pData2);
+                c = vld2q_s32(pData3);
+                d = vld2q_s32(pData4);
+
+                r1 = vaddq_s32(a.val[0], b.val[0]);
+                r2 = vsubq_s32(a.val[0], b.val[0]);
+                r3 = vaddq_s32(c.val[0], d.val[0]);
+                r4 = vsubq_s32(c.val[0], d.val[0]);
+                s1 = vaddq_s32(a.val[1], b.val[1]);
+                s2 = vsubq_s32(a.val[1], b.val[1]);
+                t1 = vaddq_s32(c.val[1], d.val[1]);
+                t2 = vsubq_s32(c.val[1], d.val[1]);
+
+                z.val[0] = vaddq_s32(r1, r3);
+                z.val[1] = vaddq_s32(s1, t1);
+                vst2q_s32(pData1, z);
+
+                /* (x, y) before the twiddle, x<<1 and y<<1 multiplied by exp_jw */
+                x = vshlq_n_s32(vsubq_s32(r1, r3), 1);
+                y = vshlq_n_s32(vsubq_s32(s1, t1), 1);
+                z.val[0] = simd_cmplx_mul32_by_16(x, y, w2h, w2l);
+                z.val[1] = simd_cmplx_mul32_by_16(y, vnegq_s32(x), w2h, w2l);
+                z.val[0] = vbslq_s32(first, vsubq_s32(r1, r3), z.val[0]);
+                z.val[1] = vbslq_s32(first, vsubq_s32(s1, t1), z.val[1]);
+                vst2q_s32(pData2, z);
+
+                x = vshlq_n_s32(vaddq_s32(r2, t2), 1);
+                y = vshlq_n_s32(vsubq_s32(s2, r4), 1);
+                z.val[0] = simd_cmplx_mul32_by_16(x, y, w1h, w1l);
+                z.val[1] = simd_cmplx_mul32_by_16(y, vnegq_s32(x), w1h, w1l);
+                z.val[0] = vbslq_s32(first, vaddq_s32(r2, t2), z.val[0]);
+                z.val[1] = vbslq_s32(first, vsubq_s32(s2, r4), z.val[1]);
+                vst2q_s32(pData3, z);
+
+                x = vshlq_n_s32(vsubq_s32(r2, t2), 1);
+                y = vshlq_n_s32(vaddq_s32(s2, r4), 1);
+                z.val[0] = simd_cmplx_mul32_by_16(x, y, w3h, w3l);
+                z.val[1] = simd_cmplx_mul32_by_16(y, vnegq_s32(x), w3h, w3l);
+                z.val[0] = vbslq_s32(first, vsubq_s32(r2, t2), z.val[0]);
+                z.val[1] = vbslq_s32(first, vaddq_s32(s2, r4), z.val[1]);
+                vst2q_s32(pData4, z);
+            }
+
+#endif
+        }  /*  j */
+
+        pw += 3 * (n2 - 1);
+
+    } /* k */
+
+
+    /*
+     *  last stage: with V0 = (a, c) and V1 = (b, d) of a dragonfly, P = V0 + V1
+     *  and M = V0 - V1 the outputs are (P0, P1, M0, M1) +/- (P2, P3, M3, -M2)
+     */
+    pData1 = Data;
+
+#if defined(PV_SIMD_SSE2)
+
+    __m128i max = _mm_setzero_si128();
+
+    for (i = ONE_FOURTH_FFT_RX4_LONG; i != 0 ; i--)
+    {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)pData1);
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(pData1 + 4));
+        __m128i p  = _mm_add_epi32(v0, v1);
+        __m128i m  = _mm_sub_epi32(v0, v1);
+        __m128i x  = _mm_unpacklo_epi64(p, m);
+        /* (-M2, M2, -M3, M3) -> lanes 2, 3 = (M3, -M2) */
+        __m128i z  = _mm_unpackhi_epi32(_mm_sub_epi32(_mm_setzero_si128(), m), m);
+        __m128i y  = _mm_unpackhi_epi64(p, _mm_shuffle_epi32(z, _MM_SHUFFLE(0, 3, 0, 0)));
+
+        v0 = _mm_add_epi32(x, y);
+        v1 = _mm_sub_epi32(x, y);
+        _mm_storeu_si128((__m128i *)pData1, v0);
+        _mm_storeu_si128((__m128i *)(pData1 + 4), v1);
+        max = _mm_or_si128(max, _mm_xor_si128(_mm_srai_epi32(v0, 31), v0));
+        max = _mm_or_si128(max, _mm_xor_si128(_mm_srai_epi32(v1, 31), v1));
+
+        pData1 += 8;
+    }
+
+    max = _mm_or_si128(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(1, 0, 3, 2)));
+    max = _mm_or_si128(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(2, 3, 0, 1)));
+    *peak_value = _mm_cvtsi128_si32(max);
+
+#else /* PV_SIMD_NEON */
+
+    int32x4_t max = vdupq_n_s32(0);
+
+    for (i = ONE_FOURTH_FFT_RX4_LONG; i != 0 ; i--)
+    {
+        int32x4_t v0 = vld1q_s32(pData1);
+        int32x4_t v1 = vld1q_s32(pData1 + 4);
+        int32x4_t p  = vaddq_s32(v0, v1);
+        int32x4_t m  = vsubq_s32(v0, v1);
+        int32x4_t x  = vcombine_s32(vget_low_s32(p), vget_low_s32(m));
+        /* (M3, -M2) */
+        int32x2_t z  = vext_s32(vget_high_s32(m), vneg_s32(vget_high_s32(m)), 1);
+        int32x4_t y  = vcombine_s32(vget_high_s32(p), z);
+
+        v0 = vaddq_s32(x, y);
+        v1 = vsubq_s32(x, y);
+        vst1q_s32(pData1, v0);
+        vst1q_s32(pData1 + 4, v1);
+        max = vorrq_s32(max, veorq_s32(vshrq_n_s32(v0, 31), v0));
+        max = vorrq_s32(max, veorq_s32(vshrq_n_s32(v1, 31), v1));
+
+        pData1 += 8;
+    }
+
+    int32x2_t max2 = vorr_s32(vget_low_s32(max), vget_high_s32(max));
+    *peak_value = vget_lane_s32(max2, 0) | vget_lane_s32(max2, 1);
+
+#endif
+
+}
+
+#endif
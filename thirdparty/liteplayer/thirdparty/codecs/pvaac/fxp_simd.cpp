@@ -0,0 +1,181 @@
+/* ------------------------------------------------------------------
+ * Copyright (C) 1998-2009 PacketVideo
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ * -------------------------------------------------------------------
+ */
+/*
+
+  Filename: fxp_simd.cpp
+
+------------------------------------------------------------------------------
+ FUNCTION DESCRIPTION
+
+ Kernel dispatch table. One SIMD_KERNELS set per instruction set built in,
+ the C reference first. pv_simd is set once at start-up to the best set the
+ CPU supports: SSE2 is probed with cpuid (always there on x86-64, optional
+ on i386), NEON with the ELF hwcaps on 32-bit ARM Linux and taken as present
+ on AArch64, which requires it.
+
+ Kernels of tools left out of the build (SBR, PS) are NULL. A set keeps the
+ C version of a kernel its instruction set doesn't make faster.
+
+------------------------------------------------------------------------------
+*/
+
+
+/*----------------------------------------------------------------------------
+; INCLUDES
+----------------------------------------------------------------------------*/
+#include    <string.h>
+
+#include    "fxp_simd.h"
+#include    "calc_sbr_synfilterbank.h"
+#include    "calc_sbr_anafilterbank.h"
+#include    "ps_channel_filtering.h"
+#include    "fft_rx4.h"
+#include    "imdct_fxp.h"
+
+#if defined(PV_SIMD_NEON) && defined(__arm__) && defined(__linux__)
+#include    <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON  (1 << 12)
+#endif
+#endif
+
+/*----------------------------------------------------------------------------
+; MACROS
+; Define module specific macros here
+----------------------------------------------------------------------------*/
+#ifdef LITEPLAYER_CONFIG_AAC_PLUS
+#define SBR_KERNEL(f)   f
+#else
+#define SBR_KERNEL(f)   NULL
+#endif
+
+#if defined(LITEPLAYER_CONFIG_AAC_PLUS) && defined(LITEPLAYER_CONFIG_PARAMETRICSTEREO)
+#define PS_KERNEL(f)    f
+#else
+#define PS_KERNEL(f)    NULL
+#endif
+
+/*----------------------------------------------------------------------------
+; LOCAL STORE/BUFFER/POINTER DEFINITIONS
+; Variable declaration - defined here and used outside this module
+----------------------------------------------------------------------------*/
+static const SIMD_KERNELS simd_kernels[] =
+{
+    {
+        "c",
+        SBR_KERNEL(calc_sbr_synfilterbank_window_c),
+        SBR_KERNEL(calc_sbr_anafilterbank_window_c),
+        PS_KERNEL(two_ch_filtering_x2_c),
+        fft_rx4_long_c,
+        imdct_fxp_pre_rotation_c,
+    },
+#if defined(PV_SIMD_SSE2) || defined(PV_SIMD_NEON)
+    {
+        PV_SIMD_NAME,
+        SBR_KERNEL(calc_sbr_synfilterbank_window_simd),
+        SBR_KERNEL(calc_sbr_anafilterbank_window_simd),
+#if defined(PV_SIMD_NEON)
+        PS_KERNEL(two_ch_filtering_x2_simd),
+#else
+        PS_KERNEL(two_ch_filtering_x2_c),       /* no faster in SSE2 */
+#endif
+        fft_rx4_long_simd,
+        imdct_fxp_pre_rotation_simd,
+    },
+#endif
+};
+
+#define NUM_SIMD_KERNELS    (Int)(sizeof(simd_kernels) / sizeof(simd_kernels[0]))
+
+/*----------------------------------------------------------------------------
+; FUNCTION CODE
+----------------------------------------------------------------------------*/
+
+/*
+ *  true if the CPU runs the instruction set of simd_kernels[index]
+ */
+static bool pv_simd_supported(Int index)
+{
+    if (index == 0)
+    {
+        return true;
+    }
+
+#if defined(PV_SIMD_SSE2) && defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2") != 0;
+#elif defined(PV_SIMD_NEON) && defined(__arm__) && defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+    return true;    /* part of the compile target baseline */
+#endif
+}
+
+
+static const SIMD_KERNELS *pv_simd_best(void)
+{
+    Int i;
+
+    for (i = NUM_SIMD_KERNELS - 1; i > 0; i--)
+    {
+        if (pv_simd_supported(i))
+        {
+            break;
+        }
+    }
+    return &simd_kernels[i];
+}
+
+
+const SIMD_KERNELS *pv_simd = pv_simd_best();
+
+
+const SIMD_KERNELS *pv_simd_kernels(Int index)
+{
+    if (index < 0 || index >= NUM_SIMD_KERNELS)
+    {
+        return NULL;
+    }
+    return &simd_kernels[index];
+}
+
+
+Int pv_simd_select(const char *name)
+{
+    Int i;
+
+    if (name == NULL)
+    {
+        pv_simd = pv_simd_best();
+        return 0;
+    }
+
+    for (i = 0; i < NUM_SIMD_KERNELS; i++)
+    {
+        if (strcmp(simd_kernels[i].name, name) == 0)
+        {
+            if (!pv_simd_supported(i))
+            {
+                return -1;
+            }
+            pv_simd = &simd_kernels[i];
+            return 0;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,181 @@
+/* ------------------------------------------------------------------
+ * Copyright (C) 1998-2009 PacketVideo
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ * -------------------------------------------------------------------
+ */
+/*
+
+ Pathname: ./c/include/fxp_simd.h
+
+------------------------------------------------------------------------------
+ INCLUDE DESCRIPTION
+
+ Selects the vector instruction set the SIMD kernels are built for and
+ declares the kernel dispatch table. SSE2 is built on x86 (with a function
+ target attribute when it isn't part of the compile baseline, i386) and NEON
+ on ARM targets compiled with NEON. Which set runs is decided at run time:
+ pv_simd points to the best set the CPU supports, see fxp_simd.cpp. The
+ hand-written ARMv4/v5 builds keep their scalar assembly paths, and
+ PV_DISABLE_SIMD builds the C reference set only.
+
+------------------------------------------------------------------------------
+*/
+
+#ifndef FXP_SIMD_H
+#define FXP_SIMD_H
+
+#include "pv_audio_type_defs.h"
+
+#if defined(PV_DISABLE_SIMD) || defined(PV_ARM_V5) || defined(PV_ARM_V4) || \
+    defined(PV_ARM_MSC_EVC_V4) || defined(PV_ARM_MSC_EVC_V5) || \
+    defined(PV_ARM_GCC_V5) || defined(PV_ARM_GCC_V4)
+
+/* scalar reference only */
+
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#define PV_SIMD_SSE2
+#include <emmintrin.h>
+
+#elif defined(__GNUC__) && defined(__i386__)
+
+/* i386 baseline has no SSE2, build the kernels for it and probe at run time */
+#define PV_SIMD_SSE2
+#define PV_SIMD_TARGET  __attribute__((target("sse2")))
+#include <emmintrin.h>
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#define PV_SIMD_NEON
+#include <arm_neon.h>
+
+#endif
+
+#ifndef PV_SIMD_TARGET
+#define PV_SIMD_TARGET
+#endif
+
+#if defined(PV_SIMD_SSE2)
+#define PV_SIMD_NAME    "sse2"
+#elif defined(PV_SIMD_NEON)
+#define PV_SIMD_NAME    "neon"
+#endif
+
+/*
+ *  Lane-wise cmplx_mul32_by_16(x, y, exp_jw), bit-exact. simd_split_exp_jw()
+ *  brings the packed cos/sin pairs in the form simd_cmplx_mul32_by_16() takes,
+ *  do it once per twiddle vector.
+ */
+#if defined(PV_SIMD_SSE2)
+
+/* 16-bit factor in the upper half of the lanes, lower half zero */
+static inline PV_SIMD_TARGET void simd_split_exp_jw(__m128i exp_jw, __m128i *wh, __m128i *wl)
+{
+    *wh = _mm_and_si128(exp_jw, _mm_set1_epi32((Int32)0xFFFF0000));
+    *wl = _mm_slli_epi32(exp_jw, 16);
+}
+
+/*
+ *  floor(x * h / 2^16): with x = xh*2^16 + xl, xl unsigned, that is
+ *  xh*h + floor(xl*h/2^16) and the latter fits in 16 bits
+ */
+static inline PV_SIMD_TARGET __m128i simd_mul32_by_16(__m128i x, __m128i h)
+{
+    __m128i t = _mm_mulhi_epu16(x, _mm_srli_epi32(h, 16));
+    t = _mm_sub_epi16(t, _mm_and_si128(x, _mm_srli_epi32(_mm_srai_epi32(h, 31), 16)));
+    t = _mm_srai_epi32(_mm_slli_epi32(t, 16), 16);
+    return _mm_add_epi32(_mm_madd_epi16(x, h), t);
+}
+
+static inline PV_SIMD_TARGET __m128i simd_cmplx_mul32_by_16(__m128i x, __m128i y, __m128i wh, __m128i wl)
+{
+    return _mm_add_epi32(simd_mul32_by_16(x, wh), simd_mul32_by_16(y, wl));
+}
+
+#elif defined(PV_SIMD_NEON)
+
+/* 16-bit factor << 15: (2 * x * (h << 15)) >> 32 == floor(x * h / 2^16), never saturates */
+static inline void simd_split_exp_jw(int32x4_t exp_jw, int32x4_t *wh, int32x4_t *wl)
+{
+    *wh = vshlq_n_s32(vshrq_n_s32(exp_jw, 16), 15);
+    *wl = vshrq_n_s32(vshlq_n_s32(exp_jw, 16), 1);
+}
+
+static inline int32x4_t simd_cmplx_mul32_by_16(int32x4_t x, int32x4_t y, int32x4_t wh, int32x4_t wl)
+{
+    return vaddq_s32(vqdmulhq_s32(x, wh), vqdmulhq_s32(y, wl));
+}
+
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /*
+     *  One implementation of every vectorized kernel. All sets are bit-exact
+     *  with the C reference, they differ in speed only.
+     */
+    typedef struct
+    {
+        const char *name;
+
+        /* calc_sbr_synfilterbank.cpp */
+        void (*synfilterbank_window)(Int16 *timeSig,
+                                     const Int16 V[1280]);
+
+        /* calc_sbr_anafilterbank.cpp */
+        void (*anafilterbank_window)(Int32 *Y,
+                                     const Int16 *X,
+                                     Bool bHQ);
+
+        /* ps_channel_filtering.cpp, QMF bands 1 and 2 of the hybrid analysis */
+        void (*two_ch_filtering_x2)(const Int32 *pQmf_r1,
+                                    const Int32 *pQmf_i1,
+                                    const Int32 *pQmf_r2,
+                                    const Int32 *pQmf_i2,
+                                    Int32 *mHybrid_r,
+                                    Int32 *mHybrid_i);
+
+        /* fft_rx4_long.cpp */
+        void (*fft_rx4_long)(Int32 Data[],
+                             Int32 *peak_value);
+
+        /* imdct_fxp.cpp, returns the peak of the rotated data */
+        Int32(*imdct_pre_rotation)(Int32 data_quant[],
+                                   const Int32 *p_rotate,
+                                   Int n,
+                                   Int shift1);
+    } SIMD_KERNELS;
+
+    /* kernel set in use, the best one the CPU supports unless pv_simd_select() changed it */
+    extern const SIMD_KERNELS *pv_simd;
+
+    /* kernel sets built in, index 0 is the C reference, NULL past the last one */
+    const SIMD_KERNELS *pv_simd_kernels(Int index);
+
+    /*
+     *  Use the set called name ("c", "sse2", "neon"), or the best supported one
+     *  for NULL. Returns -1 if there's no such set or the CPU lacks it. Not
+     *  thread safe, call it while no decoder is running.
+     */
+    Int pv_simd_select(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   /*  FXP_SIMD_H  */
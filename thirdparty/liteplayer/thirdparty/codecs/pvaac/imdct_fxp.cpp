@@ -18,7 +18,7 @@
 /*
 
  Pathname: imdct_fxp.c
- Funtions: imdct_fxp
+ Funtions: imdct_fxp, imdct_fxp_pre_rotation_c, imdct_fxp_pre_rotation_simd
 
 ------------------------------------------------------------------------------
  INPUT AND OUTPUT DEFINITIONS
@@ -219,6 +219,7 @@
 #include "inv_long_complex_rot.h"
 #include "pv_normalize.h"
 #include "fxp_mul32.h"
+#include "fxp_simd.h"
 #include "aac_mem_funcs.h"
 
 #include "window_block_fxp.h"
@@ -266,17 +267,18 @@
 ----------------------------------------------------------------------------*/
 
 
-Int imdct_fxp(Int32   data_quant[],
-              Int32   freq_2_time_buffer[],
-              const   Int     n,
-              Int     Q_format,
-              Int32   max)
+/*
+ *  pre-rotation of the n/2 spectral lines (Real and Imag parts swapped to use
+ *  the FFT as IFFT), the input is scaled by shift1 first (>> 1 if negative).
+ *  Returns the peak of the rotated data.
+ */
+Int32 imdct_fxp_pre_rotation_c(Int32   data_quant[],
+                               const   Int32 *p_rotate,
+                               Int     n,
+                               Int     shift1)
 {
-
     Int32     exp_jw;
-    Int     shift = 0;
 
-    const   Int32 *p_rotate;
     const   Int32 *p_rotate_2;
 
     Int32   *p_data_1;
@@ -285,160 +287,300 @@ Int imdct_fxp(Int32   data_quant[],
     Int32   temp_re32;
     Int32   temp_im32;
 
-    Int     shift1 = 0;
     Int32   temp1;
     Int32   temp2;
+    Int32   max = 0;
 
     Int     k;
     Int     n_2   = n >> 1;
     Int     n_4   = n >> 2;
 
+    /*
+     *   p_data_1                                        p_data_2
+     *       |                                            |
+     *       RIRIRIRIRIRIRIRIRIRIRIRIRIRIRI....RIRIRIRIRIRI
+     *        |                                          |
+     *
+     */
 
+    p_data_1 =  data_quant;             /* uses first  half of buffer */
+    p_data_2 = &data_quant[n_2 - 1];    /* uses second half of buffer */
 
-    if (max != 0)
+    p_rotate_2 = &p_rotate[n_4-1];
+
+
+    if (shift1 >= 0)
     {
+        temp_re32 =   *(p_data_1++) << shift1;
+        temp_im32 =   *(p_data_2--) << shift1;
 
-        switch (n)
+        for (k = n_4 >> 1; k != 0; k--)
         {
-            case SHORT_WINDOW_TYPE:
-                p_rotate = exp_rotation_N_256;
-                shift = 21;           /* log2(n)-1 + 14 acomodates 2/N factor */
-                break;
+            /*
+             *  Real and Imag parts have been swaped to use FFT as IFFT
+             */
+            /*
+             * cos_n + j*sin_n == exp(j(2pi/N)(k+1/8))
+             */
+            exp_jw = *p_rotate++;
 
-            case LONG_WINDOW_TYPE:
-                p_rotate = exp_rotation_N_2048;
-                shift = 24;           /* log2(n)-1 +14 acomodates 2/N factor */
-                break;
+            temp1      =  cmplx_mul32_by_16(temp_im32, -temp_re32, exp_jw);
+            temp2      = -cmplx_mul32_by_16(temp_re32,  temp_im32, exp_jw);
 
-            default:
-                /*
-                 * There is no defined behavior for a non supported frame
-                 * size. By returning a fixed scaling factor, the input will
-                 * scaled down and the will be heard as a low level noise
-                 */
-                return(ERROR_IN_FRAME_SIZE);
+            temp_im32 =   *(p_data_1--) << shift1;
+            temp_re32 =   *(p_data_2--) << shift1;
+            *(p_data_1++) = temp1;
+            *(p_data_1++) = temp2;
+            max         |= (temp1 >> 31) ^ temp1;
+            max         |= (temp2 >> 31) ^ temp2;
 
-        }
 
-        /*
-         *   p_data_1                                        p_data_2
-         *       |                                            |
-         *       RIRIRIRIRIRIRIRIRIRIRIRIRIRIRI....RIRIRIRIRIRI
-         *        |                                          |
-         *
-         */
+            /*
+             *  Real and Imag parts have been swaped to use FFT as IFFT
+             */
 
-        p_data_1 =  data_quant;             /* uses first  half of buffer */
-        p_data_2 = &data_quant[n_2 - 1];    /* uses second half of buffer */
+            /*
+             * cos_n + j*sin_n == exp(j(2pi/N)(k+1/8))
+             */
 
-        p_rotate_2 = &p_rotate[n_4-1];
+            exp_jw = *p_rotate_2--;
 
-        shift1 = pv_normalize(max) - 1;     /* -1 to leave room for addition */
-        Q_format -= (16 - shift1);
-        max = 0;
+            temp1      =  cmplx_mul32_by_16(temp_im32, -temp_re32, exp_jw);
+            temp2      = -cmplx_mul32_by_16(temp_re32,  temp_im32, exp_jw);
 
 
-        if (shift1 >= 0)
-        {
             temp_re32 =   *(p_data_1++) << shift1;
             temp_im32 =   *(p_data_2--) << shift1;
 
-            for (k = n_4 >> 1; k != 0; k--)
-            {
-                /*
-                 *  Real and Imag parts have been swaped to use FFT as IFFT
-                 */
-                /*
-                 * cos_n + j*sin_n == exp(j(2pi/N)(k+1/8))
-                 */
-                exp_jw = *p_rotate++;
+            *(p_data_2 + 2) = temp1;
+            *(p_data_2 + 3) = temp2;
+            max         |= (temp1 >> 31) ^ temp1;
+            max         |= (temp2 >> 31) ^ temp2;
 
-                temp1      =  cmplx_mul32_by_16(temp_im32, -temp_re32, exp_jw);
-                temp2      = -cmplx_mul32_by_16(temp_re32,  temp_im32, exp_jw);
+        }
+    }
+    else
+    {
+        temp_re32 =   *(p_data_1++) >> 1;
+        temp_im32 =   *(p_data_2--) >> 1;
 
-                temp_im32 =   *(p_data_1--) << shift1;
-                temp_re32 =   *(p_data_2--) << shift1;
-                *(p_data_1++) = temp1;
-                *(p_data_1++) = temp2;
-                max         |= (temp1 >> 31) ^ temp1;
-                max         |= (temp2 >> 31) ^ temp2;
+        for (k = n_4 >> 1; k != 0; k--)
+        {
+            /*
+             *  Real and Imag parts have been swaped to use FFT as IFFT
+             */
+            /*
+             * cos_n + j*sin_n == exp(j(2pi/N)(k+1/8))
+             */
+            exp_jw = *p_rotate++;
 
+            temp1      =  cmplx_mul32_by_16(temp_im32, -temp_re32, exp_jw);
+            temp2      = -cmplx_mul32_by_16(temp_re32,  temp_im32, exp_jw);
 
-                /*
-                 *  Real and Imag parts have been swaped to use FFT as IFFT
-                 */
+            temp_im32 =   *(p_data_1--) >> 1;
+            temp_re32 =   *(p_data_2--) >> 1;
+            *(p_data_1++) = temp1;
+            *(p_data_1++) = temp2;
 
-                /*
-                 * cos_n + j*sin_n == exp(j(2pi/N)(k+1/8))
-                 */
+            max         |= (temp1 >> 31) ^ temp1;
+            max         |= (temp2 >> 31) ^ temp2;
 
-                exp_jw = *p_rotate_2--;
 
-                temp1      =  cmplx_mul32_by_16(temp_im32, -temp_re32, exp_jw);
-                temp2      = -cmplx_mul32_by_16(temp_re32,  temp_im32, exp_jw);
+            /*
+             *  Real and Imag parts have been swaped to use FFT as IFFT
+             */
 
+            /*
+             * cos_n + j*sin_n == exp(j(2pi/N)(k+1/8))
+             */
+            exp_jw = *p_rotate_2--;
 
-                temp_re32 =   *(p_data_1++) << shift1;
-                temp_im32 =   *(p_data_2--) << shift1;
+            temp1      =  cmplx_mul32_by_16(temp_im32, -temp_re32, exp_jw);
+            temp2      = -cmplx_mul32_by_16(temp_re32,  temp_im32, exp_jw);
 
-                *(p_data_2 + 2) = temp1;
-                *(p_data_2 + 3) = temp2;
-                max         |= (temp1 >> 31) ^ temp1;
-                max         |= (temp2 >> 31) ^ temp2;
-
-            }
-        }
-        else
-        {
             temp_re32 =   *(p_data_1++) >> 1;
             temp_im32 =   *(p_data_2--) >> 1;
 
-            for (k = n_4 >> 1; k != 0; k--)
-            {
-                /*
-                 *  Real and Imag parts have been swaped to use FFT as IFFT
-                 */
-                /*
-                 * cos_n + j*sin_n == exp(j(2pi/N)(k+1/8))
-                 */
-                exp_jw = *p_rotate++;
+            *(p_data_2 + 3) = temp2;
+            *(p_data_2 + 2) = temp1;
 
-                temp1      =  cmplx_mul32_by_16(temp_im32, -temp_re32, exp_jw);
-                temp2      = -cmplx_mul32_by_16(temp_re32,  temp_im32, exp_jw);
+            max         |= (temp1 >> 31) ^ temp1;
+            max         |= (temp2 >> 31) ^ temp2;
 
-                temp_im32 =   *(p_data_1--) >> 1;
-                temp_re32 =   *(p_data_2--) >> 1;
-                *(p_data_1++) = temp1;
-                *(p_data_1++) = temp2;
+        }
+    }
 
-                max         |= (temp1 >> 31) ^ temp1;
-                max         |= (temp2 >> 31) ^ temp2;
+    return (max);
 
+}
 
-                /*
-                 *  Real and Imag parts have been swaped to use FFT as IFFT
-                 */
 
-                /*
-                 * cos_n + j*sin_n == exp(j(2pi/N)(k+1/8))
-                 */
-                exp_jw = *p_rotate_2--;
+#if defined(PV_SIMD_SSE2) || defined(PV_SIMD_NEON)
 
-                temp1      =  cmplx_mul32_by_16(temp_im32, -temp_re32, exp_jw);
-                temp2      = -cmplx_mul32_by_16(temp_re32,  temp_im32, exp_jw);
+/*
+ *  same as imdct_fxp_pre_rotation_c(), 4 k per iteration. Every k rotates
+ *  the line pair (data_quant[2k], data_quant[n/2-1-2k]) with p_rotate[k] and
+ *  the pair (data_quant[n/2-2-2k], data_quant[2k+1]) with p_rotate[n/4-1-k],
+ *  all of them read before any is written. The second pairs are done in
+ *  reversed lane order, so their twiddles are a forward load.
+ */
+PV_SIMD_TARGET Int32 imdct_fxp_pre_rotation_simd(Int32   data_quant[],
+        const   Int32 *p_rotate,
+        Int     n,
+        Int     shift1)
+{
+    Int     k;
+    Int     n_2   = n >> 1;
+    Int     n_4   = n >> 2;
+
+    Int32   *p_data_1 = data_quant;
+    Int32   *p_data_2 = &data_quant[n_2 - 8];
+
+#if defined(PV_SIMD_SSE2)
+
+    const __m128i zero = _mm_setzero_si128();
+    __m128i shl = _mm_cvtsi32_si128(shift1 >= 0 ? shift1 : 0);
+    __m128i shr = _mm_cvtsi32_si128(shift1 >= 0 ? 0 : 1);
+    __m128i max = zero;
+
+    for (k = 0; k < (n_4 >> 1); k += 4)
+    {
+        __m128i l0 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)p_data_1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i l1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(p_data_1 + 4)), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i r0 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)p_data_2), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i r1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(p_data_2 + 4)), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i wh, wl, t1, t2;
+
+        /* first pairs in k order, second pairs in reversed order */
+        __m128i re_1 = _mm_unpacklo_epi64(l0, l1);
+        __m128i im_2 = _mm_shuffle_epi32(_mm_unpackhi_epi64(l0, l1), _MM_SHUFFLE(0, 1, 2, 3));
+        __m128i re_2 = _mm_unpacklo_epi64(r0, r1);
+        __m128i im_1 = _mm_shuffle_epi32(_mm_unpackhi_epi64(r0, r1), _MM_SHUFFLE(0, 1, 2, 3));
+
+        re_1 = _mm_sra_epi32(_mm_sll_epi32(re_1, shl), shr);
+        im_1 = _mm_sra_epi32(_mm_sll_epi32(im_1, shl), shr);
+        re_2 = _mm_sra_epi32(_mm_sll_epi32(re_2, shl), shr);
+        im_2 = _mm_sra_epi32(_mm_sll_epi32(im_2, shl), shr);
+
+        simd_split_exp_jw(_mm_loadu_si128((const __m128i *)&p_rotate[k]), &wh, &wl);
+        t1 = simd_cmplx_mul32_by_16(im_1, _mm_sub_epi32(zero, re_1), wh, wl);
+        t2 = _mm_sub_epi32(zero, simd_cmplx_mul32_by_16(re_1, im_1, wh, wl));
+        _mm_storeu_si128((__m128i *)p_data_1, _mm_unpacklo_epi32(t1, t2));
+        _mm_storeu_si128((__m128i *)(p_data_1 + 4), _mm_unpackhi_epi32(t1, t2));
+        max = _mm_or_si128(max, _mm_xor_si128(_mm_srai_epi32(t1, 31), t1));
+        max = _mm_or_si128(max, _mm_xor_si128(_mm_srai_epi32(t2, 31), t2));
+
+        simd_split_exp_jw(_mm_loadu_si128((const __m128i *)&p_rotate[n_4 - 4 - k]), &wh, &wl);
+        t1 = simd_cmplx_mul32_by_16(im_2, _mm_sub_epi32(zero, re_2), wh, wl);
+        t2 = _mm_sub_epi32(zero, simd_cmplx_mul32_by_16(re_2, im_2, wh, wl));
+        _mm_storeu_si128((__m128i *)p_data_2, _mm_unpacklo_epi32(t1, t2));
+        _mm_storeu_si128((__m128i *)(p_data_2 + 4), _mm_unpackhi_epi32(t1, t2));
+        max = _mm_or_si128(max, _mm_xor_si128(_mm_srai_epi32(t1, 31), t1));
+        max = _mm_or_si128(max, _mm_xor_si128(_mm_srai_epi32(t2, 31), t2));
+
+        p_data_1 += 8;
+        p_data_2 -= 8;
+    }
+
+    max = _mm_or_si128(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(1, 0, 3, 2)));
+    max = _mm_or_si128(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return (_mm_cvtsi128_si32(max));
 
-                temp_re32 =   *(p_data_1++) >> 1;
-                temp_im32 =   *(p_data_2--) >> 1;
+#else /* PV_SIMD_NEON */
+
+    /* a negative shift count is an arithmetic right shift */
+    int32x4_t shift = vdupq_n_s32(shift1 >= 0 ? shift1 : -1);
+    int32x4_t max = vdupq_n_s32(0);
+
+    for (k = 0; k < (n_4 >> 1); k += 4)
+    {
+        int32x4x2_t l = vld2q_s32(p_data_1);
+        int32x4x2_t r = vld2q_s32(p_data_2);
+        int32x4x2_t t;
+        int32x4_t wh, wl;
+
+        /* first pairs in k order, second pairs in reversed order */
+        int32x4_t re_1 = vshlq_s32(l.val[0], shift);
+        int32x4_t im_2 = vshlq_s32(vrev64q_s32(l.val[1]), shift);
+        int32x4_t re_2 = vshlq_s32(r.val[0], shift);
+        int32x4_t im_1 = vshlq_s32(vrev64q_s32(r.val[1]), shift);
+        im_2 = vcombine_s32(vget_high_s32(im_2), vget_low_s32(im_2));
+        im_1 = vcombine_s32(vget_high_s32(im_1), vget_low_s32(im_1));
+
+        simd_split_exp_jw(vld1q_s32(&p_rotate[k]), &wh, &wl);
+        t.val[0] = simd_cmplx_mul32_by_16(im_1, vnegq_s32(re_1), wh, wl);
+        t.val[1] = vnegq_s32(simd_cmplx_mul32_by_16(re_1, im_1, wh, wl));
+        vst2q_s32(p_data_1, t);
+        max = vorrq_s32(max, veorq_s32(vshrq_n_s32(t.val[0], 31), t.val[0]));
+        max = vorrq_s32(max, veorq_s32(vshrq_n_s32(t.val[1], 31), t.val[1]));
+
+        simd_split_exp_jw(vld1q_s32(&p_rotate[n_4 - 4 - k]), &wh, &wl);
+        t.val[0] = simd_cmplx_mul32_by_16(im_2, vnegq_s32(re_2), wh, wl);
+        t.val[1] = vnegq_s32(simd_cmplx_mul32_by_16(re_2, im_2, wh, wl));
+        vst2q_s32(p_data_2, t);
+        max = vorrq_s32(max, veorq_s32(vshrq_n_s32(t.val[0], 31), t.val[0]));
+        max = vorrq_s32(max, veorq_s32(vshrq_n_s32(t.val[1], 31), t.val[1]));
+
+        p_data_1 += 8;
+        p_data_2 -= 8;
+    }
 
-                *(p_data_2 + 3) = temp2;
-                *(p_data_2 + 2) = temp1;
+    int32x2_t max2 = vorr_s32(vget_low_s32(max), vget_high_s32(max));
 
-                max         |= (temp1 >> 31) ^ temp1;
-                max         |= (temp2 >> 31) ^ temp2;
+    return (vget_lane_s32(max2, 0) | vget_lane_s32(max2, 1));
+
+#endif
+}
+
+#endif
+
+
+Int imdct_fxp(Int32   data_quant[],
+              Int32   freq_2_time_buffer[],
+              const   Int     n,
+              Int     Q_format,
+              Int32   max)
+{
+
+    Int     shift = 0;
+
+    const   Int32 *p_rotate;
+
+    Int     shift1 = 0;
+
+
+
+    if (max != 0)
+    {
+
+        switch (n)
+        {
+            case SHORT_WINDOW_TYPE:
+                p_rotate = exp_rotation_N_256;
+                shift = 21;           /* log2(n)-1 + 14 acomodates 2/N factor */
+                break;
+
+            case LONG_WINDOW_TYPE:
+                p_rotate = exp_rotation_N_2048;
+                shift = 24;           /* log2(n)-1 +14 acomodates 2/N factor */
+                break;
+
+            default:
+                /*
+                 * There is no defined behavior for a non supported frame
+                 * size. By returning a fixed scaling factor, the input will
+                 * scaled down and the will be heard as a low level noise
+                 */
+                return(ERROR_IN_FRAME_SIZE);
 
-            }
         }
 
+        shift1 = pv_normalize(max) - 1;     /* -1 to leave room for addition */
+        Q_format -= (16 - shift1);
+
+        max = pv_simd->imdct_pre_rotation(data_quant, p_rotate, n, shift1);
+
 
         if (n != SHORT_WINDOW_TYPE)
         {
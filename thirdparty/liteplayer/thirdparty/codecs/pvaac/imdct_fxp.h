@@ -59,6 +59,7 @@ extern "C"
     ; INCLUDES
     ----------------------------------------------------------------------------*/
 #include "pv_audio_type_defs.h"
+#include "fxp_simd.h"
 
     /*----------------------------------------------------------------------------
     ; MACROS
@@ -111,6 +112,22 @@ extern "C"
         Int32   max
     );
 
+    Int32 imdct_fxp_pre_rotation_c(
+        Int32   data_quant[],
+        const   Int32 *p_rotate,
+        Int     n,
+        Int     shift1
+    );
+
+#if defined(PV_SIMD_SSE2) || defined(PV_SIMD_NEON)
+    Int32 imdct_fxp_pre_rotation_simd(
+        Int32   data_quant[],
+        const   Int32 *p_rotate,
+        Int     n,
+        Int     shift1
+    );
+#endif
+
 
 #ifdef __cplusplus
 }
@@ -120,6 +120,7 @@
 ----------------------------------------------------------------------------*/
 
 #include "fft_rx4.h"
+#include "fxp_simd.h"
 #include "mix_radix_fft.h"
 #include "pv_normalize.h"
 
@@ -301,12 +302,12 @@ Int mix_radix_fft(
     }/* for i  */
 
 
-    fft_rx4_long(
+    pv_simd->fft_rx4_long(
         Data,
         &max1);
 
 
-    fft_rx4_long(
+    pv_simd->fft_rx4_long(
         &Data[FFT_RX4_LENGTH_FOR_LONG],
         &max2);
 
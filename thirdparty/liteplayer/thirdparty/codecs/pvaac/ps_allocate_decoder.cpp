@@ -146,8 +146,7 @@ Int32 ps_allocate_decoder(SBRDECODER_DATA *self,
     Int32 *ptr3;
     Int32 *ptr4;
     Int32 *ptr5;
-    Int32 *ptr6;
-    Int32 *ptr7;
+    Int32 delays;
 
     const Int32 pHybridResolution[] = { HYBRID_8_CPLX,
                                         HYBRID_2_REAL,
@@ -168,23 +167,19 @@ Int32 ps_allocate_decoder(SBRDECODER_DATA *self,
 
     ptr2 = (&ptr1[658]);  /*  reuse un-used right channel QMF_FILTER Synthesis buffer */
     /* 1162 - 658 = 504
-     *            = NO_QMF_ALLPASS_CHANNELS*2 (Re&Im)*( 3 + 4 + 5) + ( 3 + 4 + 5)*2 (Re&Im)
+     *           >= NO_QMF_ALLPASS_CHANNELS*2 (Re&Im)*( 3 + 4 + 5)
      */
 
     ptr3 = (&ptr1[1162]);  /*  reuse un-used right channel QMF_FILTER Synthesis buffer */
     /* 1426 - 1162 = 264
-     *            = SUBQMF_GROUPS*2 (Re&Im)*( 3 + 4 + 5) + ( 3 + 4 + 5)*2 (Re&Im)
+     *            >= SUBQMF_GROUPS*2 (Re&Im)*( 3 + 4 + 5)
      */
 
     ptr4 = (&ptr1[1426]);  /*  high freq generation buffers */
 
     ptr5 = (&ptr1[1490]);  /*  high freq generation buffers */
 
-    ptr6 = (&ptr1[1618]);  /*  high freq generation buffers */
-
-    ptr7 = (&ptr1[1810]);  /*  high freq generation buffers */
-
-    /*  whole allocation requires 1871 words, sbrQmfBufferImag has 1920 words */
+    /*  whole allocation requires 1530 words, pointer tables are in h_ps_dec */
 
 
     h_ps_dec->aPeakDecayFast =  ptr1;
@@ -232,18 +227,6 @@ Int32 ps_allocate_decoder(SBRDECODER_DATA *self,
     }
 
 
-    h_ps_dec->aaRealDelayBufferQmf = (Int32 **)ptr6;
-    ptr6 += NO_QMF_ICC_CHANNELS * sizeof(Int32 *) / sizeof(Int32);
-
-    h_ps_dec->aaImagDelayBufferQmf = (Int32 **)ptr7;
-    ptr7 += NO_QMF_ICC_CHANNELS * sizeof(Int32 *) / sizeof(Int32);
-
-    h_ps_dec->aaRealDelayBufferSubQmf = (Int32 **)ptr1;
-    ptr1 += SUBQMF_GROUPS * sizeof(Int32 *) / sizeof(Int32);
-
-    h_ps_dec->aaImagDelayBufferSubQmf = (Int32 **)ptr1;
-    ptr1 += SUBQMF_GROUPS * sizeof(Int32 *) / sizeof(Int32);
-
     for (i = 0; i < NO_QMF_ICC_CHANNELS; i++)   /* 61 */
     {
         int delay;
@@ -287,22 +270,22 @@ Int32 ps_allocate_decoder(SBRDECODER_DATA *self,
 
     }
 
+    delays = 0;
+
     for (i = 0 ; i < NO_SERIAL_ALLPASS_LINKS ; i++) /*  NO_SERIAL_ALLPASS_LINKS == 3 */
     {
 
         h_ps_dec->aDelayRBufIndexSer[i] = 0;
 
-        h_ps_dec->aaaRealDelayRBufferSerQmf[i] = (Int32 **)ptr2;
-        ptr2 += aRevLinkDelaySer[i];
+        h_ps_dec->aaaRealDelayRBufferSerQmf[i] = &h_ps_dec->aaRealDelayRBufferSerQmfTab[delays];
+
+        h_ps_dec->aaaImagDelayRBufferSerQmf[i] = &h_ps_dec->aaImagDelayRBufferSerQmfTab[delays];
 
-        h_ps_dec->aaaImagDelayRBufferSerQmf[i] = (Int32 **)ptr2;
-        ptr2 += aRevLinkDelaySer[i];
+        h_ps_dec->aaaRealDelayRBufferSerSubQmf[i] = &h_ps_dec->aaRealDelayRBufferSerSubQmfTab[delays];
 
-        h_ps_dec->aaaRealDelayRBufferSerSubQmf[i] = (Int32 **)ptr3;
-        ptr3 += aRevLinkDelaySer[i];
+        h_ps_dec->aaaImagDelayRBufferSerSubQmf[i] = &h_ps_dec->aaImagDelayRBufferSerSubQmfTab[delays];
 
-        h_ps_dec->aaaImagDelayRBufferSerSubQmf[i] = (Int32 **)ptr3;
-        ptr3 += aRevLinkDelaySer[i];
+        delays += aRevLinkDelaySer[i];
 
         for (j = 0; j < aRevLinkDelaySer[i]; j++)
         {
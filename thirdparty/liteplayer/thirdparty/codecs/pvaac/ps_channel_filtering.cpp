@@ -93,6 +93,7 @@ Copyright (c) ISO/IEC 2003.
 #include    "ps_channel_filtering.h"
 #include    "pv_audio_type_defs.h"
 #include    "fxp_mul32.h"
+#include    "fxp_simd.h"
 /*----------------------------------------------------------------------------
 ; MACROS
 ; Define module specific macros here
@@ -174,6 +175,82 @@ void two_ch_filtering(const Int32 *pQmf_r,
 }
 
 
+/*
+ *  two_ch_filtering() of two consecutive QMF bands, bands 1 and 2 of the
+ *  hybrid analysis. mHybrid_r[0..3] and mHybrid_i[0..3] get both outputs.
+ */
+void two_ch_filtering_x2_c(const Int32 *pQmf_r1,
+                           const Int32 *pQmf_i1,
+                           const Int32 *pQmf_r2,
+                           const Int32 *pQmf_i2,
+                           Int32 *mHybrid_r,
+                           Int32 *mHybrid_i)
+{
+    two_ch_filtering(pQmf_r1, pQmf_i1, mHybrid_r, mHybrid_i);
+    two_ch_filtering(pQmf_r2, pQmf_i2, &mHybrid_r[2], &mHybrid_i[2]);
+}
+
+
+#if defined(PV_SIMD_NEON)
+
+/*
+ *  same as two_ch_filtering_x2_c(), the 4 filters (band 1 real, imag, band 2
+ *  real, imag) run in the 4 lanes. The Q31 products are the exact high words
+ *  fxp_mul32_Q31() returns, so the output is bit-exact.
+ *  NEON only: SSE2 has no signed 32x32->64 multiply, emulating the Q31
+ *  products costs what the 4 lanes save, the SSE2 set keeps the C version.
+ */
+void two_ch_filtering_x2_simd(const Int32 *pQmf_r1,
+        const Int32 *pQmf_i1,
+        const Int32 *pQmf_r2,
+        const Int32 *pQmf_i2,
+        Int32 *mHybrid_r,
+        Int32 *mHybrid_i)
+{
+    Int k;
+    int32x4_t tap[12];          /* taps 1..12 */
+    int32x4_t cum;
+    int32x4_t cum0;
+    int32x4x2_t out;
+    int32x2_t c;
+    int32x4_t s;
+
+    for (k = 0; k < 12; k += 4)
+    {
+        int32x4x2_t ab = vtrnq_s32(vld1q_s32(&pQmf_r1[1 + k]), vld1q_s32(&pQmf_i1[1 + k]));
+        int32x4x2_t cd = vtrnq_s32(vld1q_s32(&pQmf_r2[1 + k]), vld1q_s32(&pQmf_i2[1 + k]));
+
+        tap[k    ] = vcombine_s32(vget_low_s32(ab.val[0]),  vget_low_s32(cd.val[0]));
+        tap[k + 1] = vcombine_s32(vget_low_s32(ab.val[1]),  vget_low_s32(cd.val[1]));
+        tap[k + 2] = vcombine_s32(vget_high_s32(ab.val[0]), vget_high_s32(cd.val[0]));
+        tap[k + 3] = vcombine_s32(vget_high_s32(ab.val[1]), vget_high_s32(cd.val[1]));
+    }
+
+    /* (c * s) >> 32 from the 64-bit products */
+    c   = vdup_n_s32(Qfmt31(0.03798975052098f));
+    s   = vaddq_s32(tap[0], tap[10]);
+    cum = vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(s), c), 32),
+                       vshrn_n_s64(vmull_s32(vget_high_s32(s), c), 32));
+    c   = vdup_n_s32(Qfmt31(0.14586278335076f));
+    s   = vaddq_s32(tap[2], tap[8]);
+    cum = vsubq_s32(cum, vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(s), c), 32),
+                                      vshrn_n_s64(vmull_s32(vget_high_s32(s), c), 32)));
+    c   = vdup_n_s32(Qfmt31(0.61193261090336f));
+    s   = vaddq_s32(tap[4], tap[6]);
+    cum = vaddq_s32(cum, vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(s), c), 32),
+                                      vshrn_n_s64(vmull_s32(vget_high_s32(s), c), 32)));
+
+    cum0 = vshrq_n_s32(tap[HYBRID_FILTER_DELAY - 1], 1);
+
+    /* (r1[0], r1[1], i1[0], i1[1]), (r2[0], r2[1], i2[0], i2[1]) */
+    out = vzipq_s32(vaddq_s32(cum0, cum), vsubq_s32(cum0, cum));
+    vst1q_s32(mHybrid_r, vcombine_s32(vget_low_s32(out.val[0]),  vget_low_s32(out.val[1])));
+    vst1q_s32(mHybrid_i, vcombine_s32(vget_high_s32(out.val[0]), vget_high_s32(out.val[1])));
+}
+
+#endif
+
+
 
 
 
@@ -44,6 +44,7 @@
 ; INCLUDES
 ----------------------------------------------------------------------------*/
 #include "pv_audio_type_defs.h"
+#include "fxp_simd.h"
 
 /*----------------------------------------------------------------------------
 ; MACROS
@@ -86,6 +87,20 @@ extern "C"
     const Int32 *pQmf_i,
     Int32 *mHybrid_r,
     Int32 *mHybrid_i);
+    void two_ch_filtering_x2_c(const Int32 *pQmf_r1,
+                               const Int32 *pQmf_i1,
+                               const Int32 *pQmf_r2,
+                               const Int32 *pQmf_i2,
+                               Int32 *mHybrid_r,
+                               Int32 *mHybrid_i);
+#if defined(PV_SIMD_NEON)
+    void two_ch_filtering_x2_simd(const Int32 *pQmf_r1,
+                                  const Int32 *pQmf_i1,
+                                  const Int32 *pQmf_r2,
+                                  const Int32 *pQmf_i2,
+                                  Int32 *mHybrid_r,
+                                  Int32 *mHybrid_i);
+#endif
 
 
     void eight_ch_filtering(const Int32 *pQmfReal,
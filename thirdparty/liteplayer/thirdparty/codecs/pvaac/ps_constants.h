@@ -65,6 +65,7 @@ Copyright (c) ISO/IEC 2003.
 #define HYBRIDGROUPS                8
 #define DECAY_CUTOFF                3
 #define NO_SERIAL_ALLPASS_LINKS     3
+#define NO_SERIAL_ALLPASS_DELAYS    12      /* 3 + 4 + 5 */
 #define MAX_NO_PS_ENV               5
 #define NEGATE_IPD_MASK                 ( 0x00001000 )
 #define NO_BINS                         ( 20 )
@@ -143,6 +143,7 @@ Copyright (c) ISO/IEC 2003.
 #include    "aac_mem_funcs.h"
 #include    "ps_channel_filtering.h"
 #include    "ps_hybrid_analysis.h"
+#include    "fxp_simd.h"
 
 /*----------------------------------------------------------------------------
 ; MACROS
@@ -227,11 +228,34 @@ void ps_hybrid_analysis(const Int32 mQmfReal[][64],
 
             case HYBRID_2_REAL:
 
-                two_ch_filtering(pt_mQmfBufferReal,
-                                 pt_mQmfBufferImag,
-                                 ptr_mHybrid_Re,
-                                 ptr_mHybrid_Im);
-                chOffset += 2;
+                if ((band + 1 < pHybrid->nQmfBands) &&
+                        ((HYBRID_RES)pHybrid->pResolution[band + 1] == HYBRID_2_REAL))
+                {
+                    /*
+                     *  Both bands in one go, pt_mQmfBufferImag moves to
+                     *  the imaginary buffer of the second one
+                     */
+                    pt_mQmfBufferImag[44 + HYBRID_FILTER_LENGTH_m_1] = mQmfReal[HYBRID_FILTER_DELAY][band + 1];
+                    pt_mQmfBufferImag[88 + HYBRID_FILTER_LENGTH_m_1] = mQmfImag[HYBRID_FILTER_DELAY][band + 1];
+
+                    pv_simd->two_ch_filtering_x2(pt_mQmfBufferReal,
+                                                 pt_mQmfBufferImag,
+                                                 pt_mQmfBufferImag + 44,
+                                                 pt_mQmfBufferImag + 88,
+                                                 ptr_mHybrid_Re,
+                                                 ptr_mHybrid_Im);
+                    pt_mQmfBufferImag += 88;
+                    chOffset += 4;
+                    band++;
+                }
+                else
+                {
+                    two_ch_filtering(pt_mQmfBufferReal,
+                                     pt_mQmfBufferImag,
+                                     ptr_mHybrid_Re,
+                                     ptr_mHybrid_Im);
+                    chOffset += 2;
+                }
 
                 break;
 
@@ -101,10 +101,19 @@ struct PS_DEC
     Int32 **aaaRealDelayRBufferSerSubQmf[NO_SERIAL_ALLPASS_LINKS];
     Int32 **aaaImagDelayRBufferSerSubQmf[NO_SERIAL_ALLPASS_LINKS];
 
-    Int32 **aaRealDelayBufferQmf;
-    Int32 **aaImagDelayBufferQmf;
-    Int32 **aaRealDelayBufferSubQmf;
-    Int32 **aaImagDelayBufferSubQmf;
+    /*
+     *  Pointer tables of the delay lines, kept here rather than in the reused
+     *  Int32 buffer, where pointers of 64-bit targets don't fit
+     */
+    Int32 *aaRealDelayRBufferSerQmfTab[NO_SERIAL_ALLPASS_DELAYS];
+    Int32 *aaImagDelayRBufferSerQmfTab[NO_SERIAL_ALLPASS_DELAYS];
+    Int32 *aaRealDelayRBufferSerSubQmfTab[NO_SERIAL_ALLPASS_DELAYS];
+    Int32 *aaImagDelayRBufferSerSubQmfTab[NO_SERIAL_ALLPASS_DELAYS];
+
+    Int32 *aaRealDelayBufferQmf[NO_QMF_ICC_CHANNELS];
+    Int32 *aaImagDelayBufferQmf[NO_QMF_ICC_CHANNELS];
+    Int32 *aaRealDelayBufferSubQmf[SUBQMF_GROUPS];
+    Int32 *aaImagDelayBufferSubQmf[SUBQMF_GROUPS];
 
     Int32 *aPeakDecayFast;
     Int32 *aPrevNrg;
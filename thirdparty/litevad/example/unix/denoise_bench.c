@@ -0,0 +1,531 @@
+// Copyright (c) 2019-2023 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Cost of litevad_denoise and what it does to end-of-speech detection in noise.
+//
+// 1. Real time factor of the generic C and the SIMD code the CPU supports at 16 kHz, and
+//    a check that both produce the same output.
+// 2. A noisy corpus: synthetic utterances (voiced syllables, fricatives, pauses between
+//    words) mixed with white, pink, babble and fan noise at 20/10/5/0 dB SNR. Each one is
+//    recorded like the voice engines do: 1s of idle capture feeds the noise estimate, then
+//    up to 15s (GENIE_RECORDER_DURATION_MAX) go through litevad with the adaptive
+//    end-of-speech timeout, raw and after each ns level. An utterance that has not ended
+//    by 15s is a timeout; an end before the speech is over is an early cut.
+//
+//   denoise_bench [utterances per condition, default 10] [noise.wav ...]
+//
+// 16bit mono 16 kHz wavs given on the command line are used as extra noise types.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "litevad.h"
+#include "litevad_denoise.h"
+#include "signal_processing/signal_processing_library.h"
+
+#define BENCH_SAMPLE_RATE   16000
+#define BENCH_FRAME_TIME    10      // ms
+#define BENCH_FRAME_SIZE    (BENCH_SAMPLE_RATE / 1000 * BENCH_FRAME_TIME)
+#define BENCH_READ_TIME     60      // ms fed per call, GENIE_RECORD_READ_TIME of the engines
+#define BENCH_READ_SIZE     (BENCH_SAMPLE_RATE / 1000 * BENCH_READ_TIME)
+#define BENCH_IDLE_TIME     1000    // ms of capture before recording starts
+#define BENCH_RECORD_TIME   15000   // ms, GENIE_RECORDER_DURATION_MAX
+#define BENCH_SPEECH_LEVEL  -26.0   // rms dBFS of speech
+#define BENCH_RTF_TIME      60      // s of audio timed per implementation
+#define BENCH_MAX_NOISES    8
+#define BENCH_MODES         5       // raw and ns level 0-3
+
+typedef struct {
+    const char *name;
+    double *x;              // rms 1.0, looped as needed
+    int nsamples;
+} noise_t;
+
+typedef struct {
+    short *pcm;             // idle capture followed by the recording
+    int nsamples;
+    int speech_begin;       // sample of the recording where speech starts and ends
+    int speech_end;
+} utterance_t;
+
+typedef struct {
+    int count;
+    int timeouts;           // no SPEECH_END within BENCH_RECORD_TIME
+    int missed;             // no SPEECH_BEGIN at all, also a timeout
+    int early;              // SPEECH_END before the end of speech
+    long latency_sum;       // ms from end of speech to SPEECH_END, utterances ended in time
+    int latency_count;
+} vad_result_t;
+
+static unsigned int sRandSeed = 1;
+
+static double rand_uniform()
+{
+    sRandSeed = sRandSeed * 1103515245 + 12345;
+    return ((sRandSeed >> 8) & 0xffffff) / (double)0x1000000;
+}
+
+static double rand_gauss()
+{
+    double u = rand_uniform() + 1e-12, v = rand_uniform();
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+static double cpu_time_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double rms(const double *x, int n)
+{
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += x[i] * x[i];
+    return n > 0 ? sqrt(sum / n) : 0;
+}
+
+// Speech like signal: words of 1-3 syllables, each syllable a voiced vowel with a gliding
+// pitch and per-syllable formant weighting, some with a fricative onset; 50ms between
+// syllables, 150-400ms between words. Returns samples written, at most max
+static int make_speech(double *out, int max, double seconds, double pitch_base)
+{
+    int n = 0;
+    double phase = 0;
+    while (n < seconds * BENCH_SAMPLE_RATE) {
+        int syllables = 1 + (int)(rand_uniform() * 3);
+        for (int s = 0; s < syllables; s++) {
+            int len = (int)((0.12 + 0.14 * rand_uniform()) * BENCH_SAMPLE_RATE);
+            int fricative = rand_uniform() < 0.3 ? (int)(0.06 * BENCH_SAMPLE_RATE) : 0;
+            double formant1 = 300 + 500 * rand_uniform();
+            double formant2 = 900 + 1600 * rand_uniform();
+            double glide = (rand_uniform() - 0.5) * 40;
+            double hp = 0, prev = 0;
+            for (int i = 0; i < fricative && n < max; i++, n++) {
+                double w = rand_gauss();
+                hp = 0.7 * (hp + w - prev);
+                prev = w;
+                out[n] = 0.35 * hp;
+            }
+            for (int i = 0; i < len && n < max; i++, n++) {
+                double t = (double)i / len;
+                double pitch = pitch_base + glide * t;
+                double env = sin(M_PI * t);
+                phase += 2 * M_PI * pitch / BENCH_SAMPLE_RATE;
+                double v = 0;
+                for (int h = 1; h * pitch < 4000; h++) {
+                    double f = h * pitch;
+                    double a = 1 / (1 + pow((f - formant1) / 150, 2)) +
+                               0.5 / (1 + pow((f - formant2) / 250, 2)) + 0.05;
+                    v += a * sin(h * phase);
+                }
+                out[n] = env * v;
+            }
+            for (int i = 0; i < BENCH_SAMPLE_RATE / 20 && n < max; i++, n++)
+                out[n] = 0;
+        }
+        int pause = (int)((0.15 + 0.25 * rand_uniform()) * BENCH_SAMPLE_RATE);
+        for (int i = 0; i < pause && n < max; i++, n++)
+            out[n] = 0;
+    }
+    // the last pause isn't speech
+    while (n > 0 && out[n - 1] == 0)
+        n--;
+    return n;
+}
+
+static void normalize(double *x, int n)
+{
+    double scale = rms(x, n);
+    for (int i = 0; i < n; i++)
+        x[i] /= scale > 0 ? scale : 1;
+}
+
+static short *to_pcm(const double *x, int n)
+{
+    short *pcm = (short *)malloc(n * sizeof(short));
+    if (pcm == NULL)
+        return NULL;
+    for (int i = 0; i < n; i++) {
+        double s = x[i];
+        pcm[i] = (short)(s > 32767 ? 32767 : (s < -32768 ? -32768 : s));
+    }
+    return pcm;
+}
+
+// nsamples of a noise type at rms 1.0, scaled to the wanted SNR when mixed
+static double *make_noise(const char *type, int nsamples)
+{
+    double *x = (double *)calloc(nsamples, sizeof(double));
+    if (x == NULL)
+        return NULL;
+
+    if (strcmp(type, "white") == 0) {
+        for (int i = 0; i < nsamples; i++)
+            x[i] = rand_gauss();
+    } else if (strcmp(type, "pink") == 0) {
+        // Paul Kellet's filter
+        double b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0;
+        for (int i = 0; i < nsamples; i++) {
+            double w = rand_gauss();
+            b0 = 0.99886 * b0 + w * 0.0555179;
+            b1 = 0.99332 * b1 + w * 0.0750759;
+            b2 = 0.96900 * b2 + w * 0.1538520;
+            b3 = 0.86650 * b3 + w * 0.3104856;
+            b4 = 0.55000 * b4 + w * 0.5329522;
+            b5 = -0.7616 * b5 - w * 0.0168980;
+            x[i] = b0 + b1 + b2 + b3 + b4 + b5 + b6 + w * 0.5362;
+            b6 = w * 0.115926;
+        }
+    } else if (strcmp(type, "babble") == 0) {
+        // six talkers at once
+        double *talker = (double *)malloc(nsamples * sizeof(double));
+        if (talker == NULL) {
+            free(x);
+            return NULL;
+        }
+        for (int t = 0; t < 6; t++) {
+            int n = make_speech(talker, nsamples, (double)nsamples / BENCH_SAMPLE_RATE,
+                                100 + 120 * rand_uniform());
+            int offset = (int)(rand_uniform() * nsamples);
+            for (int i = 0; i < n; i++)
+                x[(i + offset) % nsamples] += talker[i];
+        }
+        free(talker);
+    } else if (strcmp(type, "fan") == 0) {
+        // mains hum and its harmonics over low passed noise
+        double lp = 0;
+        for (int i = 0; i < nsamples; i++) {
+            double t = (double)i / BENCH_SAMPLE_RATE;
+            lp = 0.95 * lp + 0.05 * rand_gauss();
+            x[i] = 4 * lp + 0.3 * sin(2 * M_PI * 50 * t) + 0.2 * sin(2 * M_PI * 100 * t) +
+                   0.1 * sin(2 * M_PI * 150 * t);
+        }
+    }
+
+    normalize(x, nsamples);
+    return x;
+}
+
+static short *load_wav(const char *path, int *nsamples)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+        return NULL;
+
+    short *pcm = NULL;
+    uint8_t header[12], chunk[8];
+    int channels = 0, bits = 0, format = 0, sample_rate = 0;
+    if (fread(header, 1, sizeof(header), fp) != sizeof(header) ||
+        memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+        goto out;
+
+    while (fread(chunk, 1, sizeof(chunk), fp) == sizeof(chunk)) {
+        uint32_t size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t)chunk[7] << 24);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (size < sizeof(fmt) || fread(fmt, 1, sizeof(fmt), fp) != sizeof(fmt))
+                goto out;
+            format = fmt[0] | (fmt[1] << 8);
+            channels = fmt[2] | (fmt[3] << 8);
+            sample_rate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | (fmt[7] << 24);
+            bits = fmt[14] | (fmt[15] << 8);
+            fseek(fp, size - sizeof(fmt) + (size & 1), SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (format != 1 || channels != 1 || bits != 16 || sample_rate != BENCH_SAMPLE_RATE)
+                goto out;
+            *nsamples = size / sizeof(short);
+            pcm = (short *)malloc(*nsamples * sizeof(short));
+            if (pcm != NULL)
+                *nsamples = fread(pcm, sizeof(short), *nsamples, fp);
+            goto out;
+        } else {
+            fseek(fp, size + (size & 1), SEEK_CUR);
+        }
+    }
+
+out:
+    fclose(fp);
+    return pcm;
+}
+
+// Idle capture, a short lead-in, the utterance and noise up to the end of the recording
+static int make_utterance(const double *noise, int noise_samples, double snr, utterance_t *utt)
+{
+    int idle = BENCH_SAMPLE_RATE / 1000 * BENCH_IDLE_TIME;
+    int record = BENCH_SAMPLE_RATE / 1000 * BENCH_RECORD_TIME;
+    double *x = (double *)calloc(idle + record, sizeof(double));
+    if (x == NULL)
+        return -1;
+
+    double *speech = x + idle + (int)((0.3 + 0.3 * rand_uniform()) * BENCH_SAMPLE_RATE);
+    int n = make_speech(speech, record / 2, 1.5 + 2.5 * rand_uniform(), 90 + 150 * rand_uniform());
+    double gain = 32768 * pow(10, BENCH_SPEECH_LEVEL / 20) / rms(speech, n);
+    for (int i = 0; i < n; i++)
+        speech[i] *= gain;
+    utt->speech_begin = (int)(speech - x) - idle;
+    utt->speech_end = utt->speech_begin + n;
+
+    // snr over the active speech, 20ms frames above -50 dBFS
+    double active = 0;
+    int active_count = 0;
+    for (int i = 0; i + 320 <= n; i += 320) {
+        double r = rms(speech + i, 320);
+        if (r > 32768 * pow(10, -50 / 20.0)) {
+            active += r * r;
+            active_count++;
+        }
+    }
+    double noise_gain = sqrt(active / (active_count > 0 ? active_count : 1)) * pow(10, -snr / 20);
+    int offset = (int)(rand_uniform() * noise_samples);
+    for (int i = 0; i < idle + record; i++)
+        x[i] += noise_gain * noise[(i + offset) % noise_samples];
+
+    utt->nsamples = idle + record;
+    utt->pcm = to_pcm(x, utt->nsamples);
+    free(x);
+    return utt->pcm != NULL ? 0 : -1;
+}
+
+// Record one utterance the way the voice engines do, denoise NULL for raw capture
+static void record(litevad_handle_t vad, litevad_denoise_handle_t denoise,
+                   const utterance_t *utt, vad_result_t *result)
+{
+    int idle = BENCH_SAMPLE_RATE / 1000 * BENCH_IDLE_TIME;
+    short buff[BENCH_READ_SIZE];
+    bool begun = false;
+    int end = -1;
+
+    for (int pos = 0; pos + BENCH_READ_SIZE <= idle; pos += BENCH_READ_SIZE) {
+        if (denoise != NULL)
+            litevad_denoise_analyze(denoise, utt->pcm + pos, sizeof(buff));
+    }
+
+    litevad_reset(vad);
+    if (denoise != NULL)
+        litevad_denoise_reset(denoise);
+    for (int pos = idle; pos + BENCH_READ_SIZE <= utt->nsamples; pos += BENCH_READ_SIZE) {
+        memcpy(buff, utt->pcm + pos, sizeof(buff));
+        if (denoise != NULL)
+            litevad_denoise_process(denoise, buff, sizeof(buff));
+        litevad_result_t ret = litevad_process_stream(vad, buff, sizeof(buff), NULL);
+        if (ret == LITEVAD_RESULT_SPEECH_BEGIN || ret == LITEVAD_RESULT_SPEECH_BEGIN_AND_END)
+            begun = true;
+        if (begun && (ret == LITEVAD_RESULT_SPEECH_END || ret == LITEVAD_RESULT_SPEECH_BEGIN_AND_END)) {
+            end = pos - idle + BENCH_READ_SIZE;
+            break;
+        }
+    }
+
+    result->count++;
+    if (!begun)
+        result->missed++;
+    if (end < 0) {
+        result->timeouts++;
+    } else if (end < utt->speech_end) {
+        result->early++;
+    } else {
+        result->latency_sum += (end - utt->speech_end) / (BENCH_SAMPLE_RATE / 1000);
+        result->latency_count++;
+    }
+}
+
+static void bench_rtf(const short *pcm, int nsamples, int features)
+{
+    short *generic = (short *)malloc(nsamples * sizeof(short));
+    short *simd = (short *)malloc(nsamples * sizeof(short));
+    if (generic == NULL || simd == NULL)
+        return;
+
+    for (int pass = 0; pass < (features != 0 ? 2 : 1); pass++) {
+        short *out = pass == 0 ? generic : simd;
+        WebRtcSpl_InitWithCpuFeatures(pass == 0 ? 0 : features);
+        litevad_denoise_handle_t handle = litevad_denoise_create(BENCH_SAMPLE_RATE, NULL);
+        if (handle == NULL)
+            return;
+        memcpy(out, pcm, nsamples * sizeof(short));
+        double start = cpu_time_now();
+        for (int pos = 0; pos + BENCH_FRAME_SIZE <= nsamples; pos += BENCH_FRAME_SIZE)
+            litevad_denoise_process(handle, out + pos, BENCH_FRAME_SIZE * sizeof(short));
+        double cpu = cpu_time_now() - start;
+        double seconds = (double)nsamples / BENCH_SAMPLE_RATE;
+        fprintf(stdout, "%-5s %6.2fus per 10ms frame, real time factor %.5f\n",
+                pass == 0 ? "c" : "simd", cpu * 1e6 / (seconds * 100), cpu / seconds);
+        litevad_denoise_destroy(handle);
+    }
+    if (features != 0) {
+        if (memcmp(generic, simd, nsamples * sizeof(short)) != 0)
+            fprintf(stdout, "simd and c results differ\n");
+        else
+            fprintf(stdout, "simd and c results are bit-exact\n");
+    }
+    WebRtcSpl_InitWithCpuFeatures(features);
+    free(generic);
+    free(simd);
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *noise_types[] = { "white", "pink", "babble", "fan" };
+    static const double snrs[] = { 20, 10, 5, 0 };
+    static const char *mode_names[BENCH_MODES] = { "raw", "ns0", "ns1", "ns2", "ns3" };
+    noise_t noises[BENCH_MAX_NOISES];
+    int noise_count = 0;
+    int noise_samples = 30 * BENCH_SAMPLE_RATE;
+    int per_condition = argc > 1 ? atoi(argv[1]) : 10;
+    int features = WebRtcSpl_GetCpuFeatures();
+
+    if (per_condition <= 0) {
+        fprintf(stderr, "Usage: %s [utterances per condition] [noise.wav ...]\n", argv[0]);
+        return 1;
+    }
+    fprintf(stdout, "cpu features:%s%s%s\n",
+            (features & WEBRTC_SPL_CPU_SSE2) ? " sse2" : "",
+            (features & WEBRTC_SPL_CPU_NEON) ? " neon" : "",
+            features == 0 ? " none" : "");
+
+    for (int i = 0; i < (int)(sizeof(noise_types) / sizeof(noise_types[0])); i++) {
+        noises[noise_count].name = noise_types[i];
+        noises[noise_count].x = make_noise(noise_types[i], noise_samples);
+        noises[noise_count].nsamples = noise_samples;
+        if (noises[noise_count].x == NULL)
+            return 1;
+        noise_count++;
+    }
+    for (int i = 2; i < argc && noise_count < BENCH_MAX_NOISES; i++) {
+        int n = 0;
+        short *pcm = load_wav(argv[i], &n);
+        double *x = pcm != NULL ? (double *)malloc(n * sizeof(double)) : NULL;
+        if (x == NULL || n < BENCH_SAMPLE_RATE) {
+            fprintf(stderr, "Skip %s: not a 16bit mono 16kHz wav of 1s or more\n", argv[i]);
+            free(pcm);
+            free(x);
+            continue;
+        }
+        for (int k = 0; k < n; k++)
+            x[k] = pcm[k];
+        normalize(x, n);
+        free(pcm);
+        noises[noise_count].name = argv[i];
+        noises[noise_count].x = x;
+        noises[noise_count].nsamples = n;
+        noise_count++;
+    }
+
+    // real time factor over utterances in pink noise at 5 dB
+    {
+        int nsamples = BENCH_RTF_TIME * BENCH_SAMPLE_RATE;
+        short *pcm = (short *)malloc(nsamples * sizeof(short));
+        const double *noise = noises[1].x;
+        if (pcm == NULL)
+            return 1;
+        for (int pos = 0; pos < nsamples; ) {
+            utterance_t utt;
+            if (make_utterance(noise, noise_samples, 5, &utt) != 0)
+                return 1;
+            int n = utt.speech_end + BENCH_SAMPLE_RATE * 2;
+            if (n > nsamples - pos)
+                n = nsamples - pos;
+            memcpy(pcm + pos, utt.pcm, n * sizeof(short));
+            pos += n;
+            free(utt.pcm);
+        }
+        bench_rtf(pcm, nsamples, features);
+        free(pcm);
+    }
+
+    // vad timeouts over the noisy corpus, one vad and denoise handle per mode that live
+    // across utterances like the engines' do
+    litevad_handle_t vads[BENCH_MODES];
+    litevad_denoise_handle_t denoisers[BENCH_MODES] = { NULL };
+    vad_result_t totals[BENCH_MODES];
+    memset(totals, 0, sizeof(totals));
+    for (int m = 0; m < BENCH_MODES; m++) {
+        litevad_config_t config;
+        litevad_default_config(&config);
+        config.eos_adaptive = 1;
+        vads[m] = litevad_create_with_config(BENCH_SAMPLE_RATE, 1, 16, &config);
+        if (m > 0) {
+            litevad_denoise_config_t denoise_config;
+            litevad_denoise_default_config(&denoise_config);
+            denoise_config.ns_level = m - 1;
+            denoisers[m] = litevad_denoise_create(BENCH_SAMPLE_RATE, &denoise_config);
+        }
+        if (vads[m] == NULL || (m > 0 && denoisers[m] == NULL)) {
+            fprintf(stderr, "create failed\n");
+            return 1;
+        }
+    }
+
+    fprintf(stdout, "\n%d utterances per condition, timeouts (missed speech begin) / early cuts / mean eos latency\n",
+            per_condition);
+    fprintf(stdout, "%-14s", "noise snr");
+    for (int m = 0; m < BENCH_MODES; m++)
+        fprintf(stdout, " %-20s", mode_names[m]);
+    fprintf(stdout, "\n");
+
+    for (int i = 0; i < noise_count; i++) {
+        const double *noise = noises[i].x;
+        for (int s = 0; s < (int)(sizeof(snrs) / sizeof(snrs[0])); s++) {
+            vad_result_t results[BENCH_MODES];
+            memset(results, 0, sizeof(results));
+            for (int u = 0; u < per_condition; u++) {
+                utterance_t utt;
+                if (make_utterance(noise, noises[i].nsamples, snrs[s], &utt) != 0)
+                    return 1;
+                for (int m = 0; m < BENCH_MODES; m++)
+                    record(vads[m], denoisers[m], &utt, &results[m]);
+                free(utt.pcm);
+            }
+
+            char label[32];
+            snprintf(label, sizeof(label), "%.8s %2.0fdB", noises[i].name, snrs[s]);
+            fprintf(stdout, "%-14s", label);
+            for (int m = 0; m < BENCH_MODES; m++) {
+                vad_result_t *r = &results[m];
+                char cell[32];
+                snprintf(cell, sizeof(cell), "%2d(%d)/%d/%ldms", r->timeouts, r->missed, r->early,
+                         r->latency_count > 0 ? r->latency_sum / r->latency_count : -1);
+                fprintf(stdout, " %-20s", cell);
+                totals[m].count += r->count;
+                totals[m].timeouts += r->timeouts;
+                totals[m].missed += r->missed;
+                totals[m].early += r->early;
+                totals[m].latency_sum += r->latency_sum;
+                totals[m].latency_count += r->latency_count;
+            }
+            fprintf(stdout, "\n");
+        }
+    }
+
+    fprintf(stdout, "\n");
+    for (int m = 0; m < BENCH_MODES; m++) {
+        vad_result_t *r = &totals[m];
+        fprintf(stdout, "%-4s timeouts %3d/%d (missed %d), early cuts %d, mean eos latency %ldms\n",
+                mode_names[m], r->timeouts, r->count, r->missed, r->early,
+                r->latency_count > 0 ? r->latency_sum / r->latency_count : -1);
+        litevad_destroy(vads[m]);
+        if (denoisers[m] != NULL)
+            litevad_denoise_destroy(denoisers[m]);
+    }
+    for (int i = 0; i < noise_count; i++)
+        free(noises[i].x);
+    return 0;
+}
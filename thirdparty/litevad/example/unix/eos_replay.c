@@ -0,0 +1,193 @@
+// Copyright (c) 2019-2023 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replay a corpus of recorded utterances (16bit mono wav, one utterance per file) through
+// litevad with the fixed and the adaptive end-of-speech timeout, and report the latency from
+// the last active frame to SPEECH_END. Files are replayed in order on one handle per mode,
+// so the adaptive timeout learns from earlier files like it would from the same speaker.
+//
+//   eos_replay a.wav b.wav ...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "litevad.h"
+
+#define REPLAY_FRAME_TIME   10      // ms fed per call
+#define REPLAY_TAIL_TIME    1500    // ms of digital silence appended so that every file can end
+#define REPLAY_MAX_FILES    1024
+
+typedef struct {
+    int ends;           // SPEECH_END events, more than one means the utterance was cut early
+    int latency;        // ms from last active frame to the final SPEECH_END, -1 if never ended
+    int eos_timeout;    // ms, timeout that ended the utterance
+} replay_result_t;
+
+static short *load_wav(const char *path, int *sample_rate, int *nsamples)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+        return NULL;
+
+    short *pcm = NULL;
+    uint8_t header[12], chunk[8];
+    int channels = 0, bits = 0, format = 0;
+    if (fread(header, 1, sizeof(header), fp) != sizeof(header) ||
+        memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+        goto out;
+
+    while (fread(chunk, 1, sizeof(chunk), fp) == sizeof(chunk)) {
+        uint32_t size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t)chunk[7] << 24);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (size < sizeof(fmt) || fread(fmt, 1, sizeof(fmt), fp) != sizeof(fmt))
+                goto out;
+            format = fmt[0] | (fmt[1] << 8);
+            channels = fmt[2] | (fmt[3] << 8);
+            *sample_rate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | (fmt[7] << 24);
+            bits = fmt[14] | (fmt[15] << 8);
+            fseek(fp, size - sizeof(fmt) + (size & 1), SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (format != 1 || channels != 1 || bits != 16)
+                goto out;
+            *nsamples = size / sizeof(short);
+            pcm = (short *)malloc(*nsamples * sizeof(short));
+            if (pcm != NULL)
+                *nsamples = fread(pcm, sizeof(short), *nsamples, fp);
+            goto out;
+        } else {
+            fseek(fp, size + (size & 1), SEEK_CUR);
+        }
+    }
+
+out:
+    fclose(fp);
+    return pcm;
+}
+
+static void replay(litevad_handle_t handle, const short *pcm, int nsamples, int sample_rate,
+                   replay_result_t *result)
+{
+    int frame_size = sample_rate / 1000 * REPLAY_FRAME_TIME;
+    int total = nsamples + sample_rate / 1000 * REPLAY_TAIL_TIME;
+    short *silence = (short *)calloc(frame_size, sizeof(short));
+    unsigned char activity[1];
+    int frame = 0, last_active = -1;
+
+    memset(result, 0, sizeof(*result));
+    result->latency = -1;
+    litevad_reset(handle);
+    for (int pos = 0; pos + frame_size <= total; pos += frame_size, frame++) {
+        const short *buff = pos + frame_size <= nsamples ? pcm + pos : silence;
+        litevad_stream_info_t info = { 0, -1, activity, sizeof(activity) };
+        litevad_result_t ret = litevad_process_stream(handle, buff, frame_size * sizeof(short), &info);
+        if (info.frames > 0 && (activity[0] & 1))
+            last_active = frame;
+        if (ret == LITEVAD_RESULT_SPEECH_END || ret == LITEVAD_RESULT_SPEECH_BEGIN_AND_END) {
+            litevad_eos_info_t eos;
+            litevad_get_eos_info(handle, &eos);
+            result->ends++;
+            result->latency = (frame - last_active) * REPLAY_FRAME_TIME;
+            result->eos_timeout = eos.last_eos_silence_time;
+        }
+    }
+    free(silence);
+}
+
+static int compare_int(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+static void summary(const char *name, replay_result_t *results, int count)
+{
+    int latencies[REPLAY_MAX_FILES];
+    int n = 0, early = 0, never = 0;
+    long sum = 0;
+    for (int i = 0; i < count; i++) {
+        if (results[i].latency < 0) {
+            never++;
+            continue;
+        }
+        latencies[n++] = results[i].latency;
+        sum += results[i].latency;
+        early += results[i].ends - 1;
+    }
+    if (n == 0) {
+        fprintf(stdout, "%-8s no utterance ended\n", name);
+        return;
+    }
+    qsort(latencies, n, sizeof(int), compare_int);
+    fprintf(stdout, "%-8s eos latency: mean=%4ldms p50=%4dms p95=%4dms max=%4dms, early ends=%d, never ended=%d\n",
+            name, sum / n, latencies[(n - 1) * 50 / 100], latencies[(n - 1) * 95 / 100],
+            latencies[n - 1], early, never);
+}
+
+int main(int argc, char *argv[])
+{
+    static replay_result_t fixed[REPLAY_MAX_FILES], adaptive[REPLAY_MAX_FILES];
+    litevad_handle_t fixed_handle = NULL, adaptive_handle = NULL;
+    int sample_rate = 0, count = 0;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s a.wav [b.wav ...]\n", argv[0]);
+        return 1;
+    }
+
+    for (int i = 1; i < argc && count < REPLAY_MAX_FILES; i++) {
+        int rate = 0, nsamples = 0;
+        short *pcm = load_wav(argv[i], &rate, &nsamples);
+        if (pcm == NULL) {
+            fprintf(stderr, "Skip %s: not a 16bit mono pcm wav\n", argv[i]);
+            continue;
+        }
+        if (fixed_handle == NULL) {
+            litevad_config_t config;
+            litevad_default_config(&config);
+            fixed_handle = litevad_create_with_config(rate, 1, 16, &config);
+            config.eos_adaptive = 1;
+            adaptive_handle = litevad_create_with_config(rate, 1, 16, &config);
+            if (fixed_handle == NULL || adaptive_handle == NULL) {
+                fprintf(stderr, "litevad_create failed, sample rate %d\n", rate);
+                free(pcm);
+                return 1;
+            }
+            sample_rate = rate;
+        } else if (rate != sample_rate) {
+            fprintf(stderr, "Skip %s: sample rate %d, corpus is %d\n", argv[i], rate, sample_rate);
+            free(pcm);
+            continue;
+        }
+
+        replay(fixed_handle, pcm, nsamples, rate, &fixed[count]);
+        replay(adaptive_handle, pcm, nsamples, rate, &adaptive[count]);
+        fprintf(stdout, "%-40s fixed: %4dms/%d ends, adaptive: %4dms/%d ends (timeout %dms)\n",
+                argv[i], fixed[count].latency, fixed[count].ends,
+                adaptive[count].latency, adaptive[count].ends, adaptive[count].eos_timeout);
+        count++;
+        free(pcm);
+    }
+
+    if (count > 0) {
+        summary("fixed", fixed, count);
+        summary("adaptive", adaptive, count);
+    }
+    if (fixed_handle != NULL)
+        litevad_destroy(fixed_handle);
+    if (adaptive_handle != NULL)
+        litevad_destroy(adaptive_handle);
+    return 0;
+}
@@ -0,0 +1,205 @@
+// Copyright (c) 2019-2023 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// CPU cost of converting common native capture formats to 16 kHz mono 16 bit, with
+// litevad_resampler and, if built with alsa, with alsa's plug over a null device that
+// runs at the native format (rate converter from defaults.pcm.rate_converter). Reports
+// the CPU load of one core when running in real time.
+//
+//   resample_bench [seconds of audio, default 600]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#if defined(RESAMPLE_BENCH_HAVE_ALSA)
+#include <alsa/asoundlib.h>
+#endif
+
+#include "litevad_resampler.h"
+
+#define BENCH_READ_TIME     60      // ms per read, same as the alsa voice engine
+
+static const struct {
+    int sample_rate;
+    int channel_count;
+    int sample_bits;
+} bench_formats[] = {
+    { 16000, 1, 16 },
+    { 16000, 2, 16 },
+    { 32000, 2, 16 },
+    { 44100, 2, 16 },
+    { 48000, 1, 16 },
+    { 48000, 2, 16 },
+    { 48000, 2, 32 },
+    { 48000, 4, 32 },
+    { 48000, 8, 16 },
+    { 96000, 2, 32 },
+};
+
+static double cpu_time_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// One read of interleaved native pcm: a tone per channel plus noise
+static void *make_signal(int sample_rate, int channel_count, int sample_bits, int frames)
+{
+    int sample_bytes = sample_bits == 16 ? 2 : 4;
+    char *pcm = (char *)malloc(frames * channel_count * sample_bytes);
+    if (pcm == NULL)
+        return NULL;
+
+    unsigned int seed = 1;
+    for (int i = 0; i < frames; i++) {
+        for (int c = 0; c < channel_count; c++) {
+            seed = seed * 1103515245 + 12345;
+            double s = 8000 * sin(2 * M_PI * (300 + 200 * c) * i / sample_rate) +
+                       ((int)((seed >> 16) & 0x7fff) - 16384) / 64.0;
+            int idx = i * channel_count + c;
+            if (sample_bits == 16)
+                ((int16_t *)pcm)[idx] = (int16_t)s;
+            else if (sample_bits == 24)
+                ((int32_t *)pcm)[idx] = (int32_t)(s * 256);
+            else
+                ((int32_t *)pcm)[idx] = (int32_t)(s * 65536);
+        }
+    }
+    return pcm;
+}
+
+static double bench_litevad(int sample_rate, int channel_count, int sample_bits, int seconds)
+{
+    litevad_resampler_handle_t handle =
+            litevad_resampler_create(sample_rate, channel_count, sample_bits);
+    if (handle == NULL)
+        return -1;
+
+    int frames = sample_rate / 1000 * BENCH_READ_TIME;
+    int size = frames * channel_count * (sample_bits == 16 ? 2 : 4);
+    void *in = make_signal(sample_rate, channel_count, sample_bits, frames);
+    int out_size = litevad_resampler_output_size(handle, size) + 2 * 160;
+    void *out = malloc(out_size);
+    if (in == NULL || out == NULL) {
+        free(in);
+        free(out);
+        litevad_resampler_destroy(handle);
+        return -1;
+    }
+
+    int reads = seconds * 1000 / BENCH_READ_TIME;
+    double start = cpu_time_now();
+    for (int i = 0; i < reads; i++)
+        litevad_resampler_process(handle, in, size, out, out_size);
+    double cpu_time = cpu_time_now() - start;
+
+    free(in);
+    free(out);
+    litevad_resampler_destroy(handle);
+    return cpu_time;
+}
+
+#if defined(RESAMPLE_BENCH_HAVE_ALSA)
+// plug at 16k/mono/S16 over a null device fixed to the native format, a null capture
+// returns silence without waiting, the rate/route/linear plugins don't look at the data
+static double bench_alsa(int sample_rate, int channel_count, int sample_bits, int seconds)
+{
+    static int pcm_id = 0;
+    char name[32], conf[256];
+    snprintf(name, sizeof(name), "resample_bench_%d", pcm_id++);
+    snprintf(conf, sizeof(conf),
+             "pcm.%s { type plug slave { pcm { type null } rate %d channels %d format %s } }",
+             name, sample_rate, channel_count,
+             sample_bits == 16 ? "S16_LE" : (sample_bits == 24 ? "S24_LE" : "S32_LE"));
+
+    snd_input_t *input = NULL;
+    if (snd_config_update() < 0 || snd_input_buffer_open(&input, conf, strlen(conf)) < 0)
+        return -1;
+    int ret = snd_config_load(snd_config, input);
+    snd_input_close(input);
+    if (ret < 0)
+        return -1;
+
+    snd_pcm_t *pcm = NULL;
+    if (snd_pcm_open(&pcm, name, SND_PCM_STREAM_CAPTURE, 0) < 0)
+        return -1;
+    if (snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED,
+                           1, LITEVAD_RESAMPLER_OUT_RATE, 1, 500000) < 0) {
+        snd_pcm_close(pcm);
+        return -1;
+    }
+
+    int16_t out[LITEVAD_RESAMPLER_OUT_RATE / 1000 * BENCH_READ_TIME];
+    int reads = seconds * 1000 / BENCH_READ_TIME;
+    double start = cpu_time_now();
+    for (int i = 0; i < reads; i++) {
+        snd_pcm_uframes_t frames = sizeof(out) / sizeof(out[0]);
+        while (frames > 0) {
+            snd_pcm_sframes_t n = snd_pcm_readi(pcm, out, frames);
+            if (n == -EPIPE) {
+                snd_pcm_prepare(pcm);
+                continue;
+            } else if (n < 0) {
+                snd_pcm_close(pcm);
+                return -1;
+            }
+            frames -= n;
+        }
+    }
+    double cpu_time = cpu_time_now() - start;
+
+    snd_pcm_close(pcm);
+    return cpu_time;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 600;
+    if (seconds <= 0) {
+        fprintf(stderr, "Usage: %s [seconds of audio]\n", argv[0]);
+        return 1;
+    }
+
+    fprintf(stdout, "%ds of audio, cpu load of one core converting to 16000Hz mono S16\n", seconds);
+    fprintf(stdout, "%-22s %10s %10s\n", "native format", "litevad", "alsa plug");
+    for (int i = 0; i < (int)(sizeof(bench_formats) / sizeof(bench_formats[0])); i++) {
+        int rate = bench_formats[i].sample_rate;
+        int channels = bench_formats[i].channel_count;
+        int bits = bench_formats[i].sample_bits;
+        char format[32];
+        snprintf(format, sizeof(format), "%dHz %dch S%d_LE", rate, channels, bits);
+
+        double litevad_time = bench_litevad(rate, channels, bits, seconds);
+        if (litevad_time < 0) {
+            fprintf(stderr, "litevad_resampler failed, %s\n", format);
+            return 1;
+        }
+#if defined(RESAMPLE_BENCH_HAVE_ALSA)
+        double alsa_time = bench_alsa(rate, channels, bits, seconds);
+        if (alsa_time >= 0)
+            fprintf(stdout, "%-22s %9.3f%% %9.3f%%\n", format,
+                    100 * litevad_time / seconds, 100 * alsa_time / seconds);
+        else
+            fprintf(stdout, "%-22s %9.3f%% %10s\n", format, 100 * litevad_time / seconds, "failed");
+#else
+        fprintf(stdout, "%-22s %9.3f%% %10s\n", format, 100 * litevad_time / seconds, "-");
+#endif
+    }
+    return 0;
+}
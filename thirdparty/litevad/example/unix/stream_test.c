@@ -0,0 +1,227 @@
+// Copyright (c) 2019-2023 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Regression test of litevad_process_stream: feeds a synthetic signal of utterances and
+// pauses in random chunks of 1..3000 samples and checks that SPEECH_BEGIN/SPEECH_END
+// come at the same frames as with litevad_process fed 10ms at a time, at 8k, 16k and
+// 48k. Also checks that an odd byte count is rejected. Exits non-zero on a mismatch.
+//
+//   stream_test [rounds per sample rate, default 20]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "litevad.h"
+
+#define TEST_FRAME_TIME     10      // ms
+#define TEST_SECONDS        60
+#define TEST_CHUNK_MAX      3000    // samples
+#define TEST_EVENTS_MAX     256
+
+typedef struct {
+    int frame;
+    int begin;              // 1 SPEECH_BEGIN, 0 SPEECH_END
+} test_event_t;
+
+typedef struct {
+    test_event_t events[TEST_EVENTS_MAX];
+    int count;
+} test_events_t;
+
+// 0.6-2.4s utterances of voiced syllables separated by 1.5-3s pauses, background noise
+// all the time, so both events happen regularly
+static short *make_signal(int sample_rate, int seconds, unsigned int seed)
+{
+    int nsamples = sample_rate * seconds;
+    short *pcm = (short *)malloc(nsamples * sizeof(short));
+    if (pcm == NULL)
+        return NULL;
+
+    double phase = 0;
+    int next_toggle = 0, speaking = 1;
+    for (int i = 0; i < nsamples; i++) {
+        if (i == next_toggle) {
+            speaking = !speaking;
+            seed = seed * 1103515245 + 12345;
+            int ms = speaking ? 600 + (seed >> 16) % 1800 : 1500 + (seed >> 16) % 1500;
+            next_toggle = i + ms * (sample_rate / 1000);
+        }
+        double t = (double)i / sample_rate;
+        seed = seed * 1103515245 + 12345;
+        double s = ((int)((seed >> 16) & 0x7fff) - 16384) / 16384.0 * 150;
+        if (speaking) {
+            double pitch = 130 + 30 * sin(2 * M_PI * 0.9 * t);
+            double envelope = 0.5 - 0.5 * cos(2 * M_PI * 4 * t);
+            phase += 2 * M_PI * pitch / sample_rate;
+            for (int h = 1; h <= 8; h++)
+                s += envelope * 6000 / h * sin(h * phase);
+        }
+        pcm[i] = (short)(s > 32767 ? 32767 : (s < -32768 ? -32768 : s));
+    }
+    return pcm;
+}
+
+static void add_event(test_events_t *events, int frame, int begin)
+{
+    if (events->count < TEST_EVENTS_MAX) {
+        events->events[events->count].frame = frame;
+        events->events[events->count].begin = begin;
+    }
+    events->count++;
+}
+
+static int run_frames(int sample_rate, const short *pcm, int nsamples, test_events_t *events)
+{
+    litevad_handle_t handle = litevad_create(sample_rate, 1, 16);
+    if (handle == NULL)
+        return -1;
+
+    int frame_size = sample_rate / 1000 * TEST_FRAME_TIME;
+    events->count = 0;
+    for (int f = 0; (f + 1) * frame_size <= nsamples; f++) {
+        litevad_result_t ret = litevad_process(handle, pcm + f * frame_size, frame_size * sizeof(short));
+        if (ret == LITEVAD_RESULT_ERROR) {
+            litevad_destroy(handle);
+            return -1;
+        }
+        if (ret == LITEVAD_RESULT_SPEECH_BEGIN || ret == LITEVAD_RESULT_SPEECH_BEGIN_AND_END)
+            add_event(events, f, 1);
+        if (ret == LITEVAD_RESULT_SPEECH_END || ret == LITEVAD_RESULT_SPEECH_BEGIN_AND_END)
+            add_event(events, f, 0);
+    }
+
+    litevad_destroy(handle);
+    return 0;
+}
+
+static int run_stream(int sample_rate, const short *pcm, int nsamples, unsigned int seed,
+                      test_events_t *events)
+{
+    litevad_handle_t handle = litevad_create(sample_rate, 1, 16);
+    if (handle == NULL)
+        return -1;
+
+    int pos = 0, frames = 0;
+    events->count = 0;
+    while (pos < nsamples) {
+        seed = seed * 1103515245 + 12345;
+        int chunk = 1 + (seed >> 16) % TEST_CHUNK_MAX;
+        if (chunk > nsamples - pos)
+            chunk = nsamples - pos;
+
+        litevad_stream_info_t info = { 0, -1, NULL, 0 };
+        litevad_result_t ret = litevad_process_stream(handle, pcm + pos, chunk * sizeof(short), &info);
+        if (ret == LITEVAD_RESULT_ERROR) {
+            litevad_destroy(handle);
+            return -1;
+        }
+        // event_frame is the last event, a BEGIN_AND_END began at an earlier frame of
+        // this call which the stream info doesn't give: take it as the first frame
+        if (ret == LITEVAD_RESULT_SPEECH_BEGIN)
+            add_event(events, frames + info.event_frame, 1);
+        else if (ret == LITEVAD_RESULT_SPEECH_BEGIN_AND_END)
+            add_event(events, -1, 1);
+        if (ret == LITEVAD_RESULT_SPEECH_END || ret == LITEVAD_RESULT_SPEECH_BEGIN_AND_END)
+            add_event(events, frames + info.event_frame, 0);
+        frames += info.frames;
+        pos += chunk;
+    }
+
+    litevad_destroy(handle);
+    return 0;
+}
+
+static int compare(const test_events_t *expected, const test_events_t *actual)
+{
+    if (expected->count != actual->count) {
+        printf("  %d events, expected %d\n", actual->count, expected->count);
+        return -1;
+    }
+    for (int i = 0; i < expected->count && i < TEST_EVENTS_MAX; i++) {
+        const test_event_t *e = &expected->events[i];
+        const test_event_t *a = &actual->events[i];
+        if (e->begin != a->begin || (a->frame >= 0 && e->frame != a->frame)) {
+            printf("  event %d: %s at frame %d, expected %s at frame %d\n", i,
+                   a->begin ? "begin" : "end", a->frame, e->begin ? "begin" : "end", e->frame);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int test_odd_size(int sample_rate)
+{
+    short pcm[3] = { 0 };
+    litevad_handle_t handle = litevad_create(sample_rate, 1, 16);
+    if (handle == NULL)
+        return -1;
+    litevad_result_t odd = litevad_process_stream(handle, pcm, 3, NULL);
+    litevad_result_t even = litevad_process_stream(handle, pcm, 4, NULL);
+    litevad_destroy(handle);
+    if (odd != LITEVAD_RESULT_ERROR || even == LITEVAD_RESULT_ERROR) {
+        printf("  odd byte count: %d, even byte count: %d\n", odd, even);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    static const int rates[] = { 8000, 16000, 48000 };
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    int failures = 0;
+    if (rounds <= 0)
+        rounds = 20;
+
+    for (int r = 0; r < (int)(sizeof(rates) / sizeof(rates[0])); r++) {
+        int sample_rate = rates[r];
+        int nsamples = sample_rate * TEST_SECONDS;
+        test_events_t expected, actual;
+
+        if (test_odd_size(sample_rate) != 0) {
+            printf("%dHz: odd size FAILED\n", sample_rate);
+            failures++;
+        }
+
+        short *pcm = make_signal(sample_rate, TEST_SECONDS, 7 + r);
+        if (pcm == NULL || run_frames(sample_rate, pcm, nsamples, &expected) != 0) {
+            printf("%dHz: reference run failed\n", sample_rate);
+            free(pcm);
+            return 1;
+        }
+        if (expected.count < 2 || expected.count > TEST_EVENTS_MAX) {
+            printf("%dHz: %d reference events, signal doesn't exercise the vad\n",
+                   sample_rate, expected.count);
+            free(pcm);
+            return 1;
+        }
+
+        int passed = 0;
+        for (int round = 0; round < rounds; round++) {
+            if (run_stream(sample_rate, pcm, nsamples, 1000 + round, &actual) != 0 ||
+                compare(&expected, &actual) != 0) {
+                printf("%dHz: round %d FAILED\n", sample_rate, round);
+                failures++;
+                continue;
+            }
+            passed++;
+        }
+        printf("%dHz: %d events, %d/%d rounds match\n", sample_rate, expected.count, passed, rounds);
+        free(pcm);
+    }
+
+    return failures != 0 ? 1 : 0;
+}
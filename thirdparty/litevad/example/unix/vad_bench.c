@@ -0,0 +1,170 @@
+// Copyright (c) 2019-2023 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// VAD throughput of the generic C code and of the SIMD code the CPU supports, at 16 kHz
+// and 48 kHz. The input is a synthetic signal of voiced bursts, pauses and noise. Reports
+// 10ms frames per second of CPU time and the CPU load of one core when running in real
+// time, and checks that both implementations classify every frame the same.
+//
+//   vad_bench [seconds of audio, default 600]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "litevad.h"
+#include "vad/webrtc_vad.h"
+#include "signal_processing/signal_processing_library.h"
+
+#define BENCH_FRAME_TIME    10      // ms, frame classified by the vad
+#define BENCH_BLOCK_TIME    1000    // ms fed per call
+#define BENCH_BLOCK_FRAMES  (BENCH_BLOCK_TIME / BENCH_FRAME_TIME)
+
+typedef struct {
+    double cpu_time;        // s
+    int frames;
+    unsigned char *activity; // one bit per frame
+} bench_result_t;
+
+static double cpu_time_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 1.5s voiced burst (harmonics of a gliding pitch, syllable rate amplitude) every 2.5s,
+// background noise all the time, louder noise bursts in every third pause
+static short *make_signal(int sample_rate, int seconds)
+{
+    int nsamples = sample_rate * seconds;
+    short *pcm = (short *)malloc(nsamples * sizeof(short));
+    if (pcm == NULL)
+        return NULL;
+
+    unsigned int seed = 1;
+    double phase = 0;
+    for (int i = 0; i < nsamples; i++) {
+        double t = (double)i / sample_rate;
+        double cycle = fmod(t, 2.5);
+        int burst = (int)(t / 2.5);
+        seed = seed * 1103515245 + 12345;
+        double noise = ((int)((seed >> 16) & 0x7fff) - 16384) / 16384.0;
+        double s = noise * ((burst % 3 == 2 && cycle >= 1.5) ? 3000 : 200);
+        if (cycle < 1.5) {
+            double pitch = 120 + 40 * sin(2 * M_PI * 0.7 * t);
+            double envelope = 0.5 - 0.5 * cos(2 * M_PI * 4 * cycle);
+            phase += 2 * M_PI * pitch / sample_rate;
+            for (int h = 1; h <= 8; h++)
+                s += envelope * 6000 / h * sin(h * phase);
+        }
+        pcm[i] = (short)(s > 32767 ? 32767 : (s < -32768 ? -32768 : s));
+    }
+    return pcm;
+}
+
+static int run(int sample_rate, const short *pcm, int seconds, bench_result_t *result)
+{
+    litevad_handle_t handle = litevad_create(sample_rate, 1, 16);
+    if (handle == NULL)
+        return -1;
+
+    int block_size = sample_rate / 1000 * BENCH_BLOCK_TIME;
+    int blocks = seconds * 1000 / BENCH_BLOCK_TIME;
+    memset(result->activity, 0, (blocks * BENCH_BLOCK_FRAMES + 7) / 8);
+    result->frames = 0;
+
+    double start = cpu_time_now();
+    for (int b = 0; b < blocks; b++) {
+        unsigned char activity[(BENCH_BLOCK_FRAMES + 7) / 8];
+        litevad_stream_info_t info = { 0, -1, activity, sizeof(activity) };
+        litevad_process_stream(handle, pcm + b * block_size, block_size * sizeof(short), &info);
+        for (int f = 0; f < info.frames; f++, result->frames++) {
+            if (activity[f / 8] & (1 << (f % 8)))
+                result->activity[result->frames / 8] |= 1 << (result->frames % 8);
+        }
+    }
+    result->cpu_time = cpu_time_now() - start;
+
+    litevad_destroy(handle);
+    return 0;
+}
+
+static void report(const char *name, int sample_rate, int seconds, const bench_result_t *result)
+{
+    int active = 0;
+    for (int f = 0; f < result->frames; f++)
+        active += (result->activity[f / 8] >> (f % 8)) & 1;
+    fprintf(stdout, "%5dHz %-5s %8.0f frames/s, cpu %6.3f%%, %d/%d frames active\n",
+            sample_rate, name, result->frames / result->cpu_time,
+            100 * result->cpu_time / seconds, active, result->frames);
+}
+
+int main(int argc, char *argv[])
+{
+    static const int sample_rates[] = { 16000, 48000 };
+    int seconds = argc > 1 ? atoi(argv[1]) : 600;
+    int features = WebRtcSpl_GetCpuFeatures();
+    int mismatch = 0;
+
+    if (seconds <= 0) {
+        fprintf(stderr, "Usage: %s [seconds of audio]\n", argv[0]);
+        return 1;
+    }
+    fprintf(stdout, "%ds of audio, cpu features:%s%s%s\n", seconds,
+            (features & WEBRTC_SPL_CPU_SSE2) ? " sse2" : "",
+            (features & WEBRTC_SPL_CPU_NEON) ? " neon" : "",
+            features == 0 ? " none" : "");
+
+    int activity_size = (seconds * 1000 / BENCH_FRAME_TIME + 7) / 8;
+    bench_result_t generic = { 0, 0, (unsigned char *)malloc(activity_size) };
+    bench_result_t simd = { 0, 0, (unsigned char *)malloc(activity_size) };
+    if (generic.activity == NULL || simd.activity == NULL)
+        return 1;
+
+    for (int i = 0; i < (int)(sizeof(sample_rates) / sizeof(sample_rates[0])); i++) {
+        int rate = sample_rates[i];
+        short *pcm = make_signal(rate, seconds);
+        if (pcm == NULL)
+            return 1;
+
+        WebRtcVad_InitWithCpuFeatures(0);
+        if (run(rate, pcm, seconds, &generic) != 0) {
+            fprintf(stderr, "litevad_create failed, sample rate %d\n", rate);
+            return 1;
+        }
+        report("c", rate, seconds, &generic);
+
+        if (features != 0) {
+            WebRtcVad_InitWithCpuFeatures(features);
+            run(rate, pcm, seconds, &simd);
+            report("simd", rate, seconds, &simd);
+            if (simd.frames != generic.frames ||
+                memcmp(simd.activity, generic.activity, (generic.frames + 7) / 8) != 0) {
+                fprintf(stdout, "%5dHz simd and c results differ\n", rate);
+                mismatch = 1;
+            } else {
+                fprintf(stdout, "%5dHz speedup %.2fx\n", rate, generic.cpu_time / simd.cpu_time);
+            }
+        }
+        free(pcm);
+    }
+
+    free(generic.activity);
+    free(simd.activity);
+    return mismatch;
+}
@@ -32,10 +32,62 @@ typedef enum {
 
 typedef void *litevad_handle_t;
 
+// Runtime tunables, see litevad_default_config() for defaults
+typedef struct {
+    int vad_mode;               // 0-3, higher is more restrictive in reporting speech
+    int bos_active_time;        // ms of continuous speech before SPEECH_BEGIN
+    int bos_active_weight;      // 0-100
+    int eos_silence_time;       // ms of silence before SPEECH_END, upper bound if eos_adaptive
+    int eos_silence_weight;     // 0-100
+    int eos_adaptive;           // adapt silence timeout to speaker pauses and noise floor
+    int eos_silence_time_min;   // ms, lower bound if eos_adaptive
+} litevad_config_t;
+
+typedef enum {
+    LITEVAD_HINT_NONE       = 0,
+    LITEVAD_HINT_COMPLETE   = 1,   // utterance looks complete, end on the shortest timeout
+    LITEVAD_HINT_INCOMPLETE = 2,   // utterance looks unfinished, wait for the longest timeout
+} litevad_hint_t;
+
+typedef struct {
+    int eos_silence_time;       // ms, timeout in effect now
+    int last_eos_silence_time;  // ms, timeout that ended the last utterance
+    int pause_mean;             // ms, in-utterance pauses of this speaker
+    int pause_dev;              // ms, mean deviation of pauses
+    int noise_level;            // dB, silence frames
+    int speech_level;           // dB, speech frames
+} litevad_eos_info_t;
+
+typedef struct {
+    int frames;                 // 10ms frames classified by this call
+    int event_frame;            // frame index of last SPEECH_BEGIN/SPEECH_END in this call, -1 if none
+    unsigned char *activity;    // optional, bit i (LSB first) is set if frame i is active
+    int activity_size;          // size of activity in bytes, frames beyond it are not recorded
+} litevad_stream_info_t;
+
+void litevad_default_config(litevad_config_t *config);
+
 litevad_handle_t litevad_create(int sample_rate, int channel_count, int sample_bits);
 
+litevad_handle_t litevad_create_with_config(int sample_rate, int channel_count, int sample_bits,
+                                            const litevad_config_t *config);
+
+// size must be a multiple of 10ms, stops at SPEECH_END leaving the rest unclassified
 litevad_result_t litevad_process(litevad_handle_t handle, const void *buff, int size);
 
+// Streaming variant, size can be any number of whole samples (error if odd): the trailing
+// partial frame is carried over to the next call. Every frame is classified, after
+// SPEECH_END the rest of the buffer still updates the detector but no new event is raised
+// until the next call. info is optional.
+litevad_result_t litevad_process_stream(litevad_handle_t handle, const void *buff, int size,
+                                        litevad_stream_info_t *info);
+
+// Hint from a recognizer about the utterance in progress, cleared on SPEECH_END and reset
+void litevad_set_hint(litevad_handle_t handle, litevad_hint_t hint);
+
+void litevad_get_eos_info(litevad_handle_t handle, litevad_eos_info_t *info);
+
+// Reset utterance state, learned pause and noise statistics are kept
 void litevad_reset(litevad_handle_t handle);
 
 void litevad_destroy(litevad_handle_t handle);
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2018-2023 Qinglong<sysu.zqlong@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LITEVAD_DENOISE_H
+#define __LITEVAD_DENOISE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Capture processing ahead of litevad and upload: fixed-point spectral noise suppression
+// followed by an automatic gain control, 16 bit mono at 8 or 16 kHz in 10ms frames, the
+// framing litevad runs on. Each frame is analysed with the tail of the previous one through
+// a 256 (128 at 8 kHz) point real FFT, the noise spectrum is tracked by a minimum follower
+// and a decision-directed Wiener gain applied per bin; output is delayed by 6ms. The FFTs
+// use the runtime dispatched webrtc signal processing library (SSE2/NEON).
+
+typedef void *litevad_denoise_handle_t;
+
+typedef struct {
+    // Suppression aggressiveness 0-3: noise overestimation and the floor of the gain, at
+    // most 6/10/15/20 dB of attenuation
+    int ns_level;
+    // Gain speech towards agc_target_level, boosting by at most agc_max_gain. Speech frames
+    // only move the level, peaks are limited to -1 dBFS
+    int agc_enable;
+    int agc_target_level;   // rms dBFS of speech, -30~0
+    int agc_max_gain;       // dB, 0~30
+} litevad_denoise_config_t;
+
+typedef struct {
+    int noise_level;        // rms dBFS of the tracked noise
+    int speech_level;       // rms dBFS of speech, as seen by the AGC
+    int agc_gain;           // dB applied to the last frame
+} litevad_denoise_info_t;
+
+void litevad_denoise_default_config(litevad_denoise_config_t *config);
+
+// sample_rate: 8000 or 16000, config NULL for defaults
+litevad_denoise_handle_t litevad_denoise_create(int sample_rate, const litevad_denoise_config_t *config);
+
+// Denoise and gain in place, size must be whole 10ms frames. Returns 0, -1 on invalid size
+int litevad_denoise_process(litevad_denoise_handle_t handle, void *buff, int size);
+
+// Only track noise, buff is left untouched. Feed capture while not recording so the noise
+// estimate is settled when an utterance starts. size must be whole 10ms frames
+int litevad_denoise_analyze(litevad_denoise_handle_t handle, const void *buff, int size);
+
+void litevad_denoise_get_info(litevad_denoise_handle_t handle, litevad_denoise_info_t *info);
+
+// Drop the overlap and SNR state, the noise estimate and AGC level are kept
+void litevad_denoise_reset(litevad_denoise_handle_t handle);
+
+void litevad_denoise_destroy(litevad_denoise_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LITEVAD_DENOISE_H
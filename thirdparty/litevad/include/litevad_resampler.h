@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2018-2023 Qinglong<sysu.zqlong@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LITEVAD_RESAMPLER_H
+#define __LITEVAD_RESAMPLER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Capture front-end: interleaved pcm at the device's native rate, channel count and
+// sample format in, 16 kHz mono 16 bit out, the format litevad and the voice engines
+// run on. Channels are averaged, then resampled with the webrtc resamplers in 10ms
+// blocks.
+//
+// sample_rate: 8000/16000/22050/24000/32000/44100/48000/96000. 22050 and 44100 are
+//              resampled as 22000 and 44000 like webrtc's Resampler, output runs 0.2% fast
+// sample_bits: 16 (S16_LE), 24 (S24_LE, low 3 bytes of 32 bit) or 32 (S32_LE)
+#define LITEVAD_RESAMPLER_OUT_RATE  16000
+
+typedef void *litevad_resampler_handle_t;
+
+litevad_resampler_handle_t litevad_resampler_create(int sample_rate, int channel_count, int sample_bits);
+
+// Max bytes litevad_resampler_process() writes for size bytes of input
+int litevad_resampler_output_size(litevad_resampler_handle_t handle, int size);
+
+// size must be whole frames (channel_count samples), input short of a 10ms block is carried
+// over to the next call. Returns bytes written to out, -1 on invalid size or if out_size is
+// less than litevad_resampler_output_size()
+int litevad_resampler_process(litevad_resampler_handle_t handle, const void *in, int size,
+                              void *out, int out_size);
+
+// Drop carried input and filter state, call when the capture stream restarts
+void litevad_resampler_reset(litevad_resampler_handle_t handle);
+
+void litevad_resampler_destroy(litevad_resampler_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LITEVAD_RESAMPLER_H
@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "vad/webrtc_vad.h"
@@ -67,12 +68,32 @@
 // VAD 模式（合法值：0/1/2/3），值越大对语音的判断越严格（越准确？）
 #define DEFAULT_VAD_MODE           3
 
+// 自适应判停（litevad_config_t.eos_adaptive）：静音超时取说话人句中停顿的
+// “均值 + 3 倍平均偏差 + 余量”，低信噪比时适当加长，最终限制在
+// [DEFAULT_EOS_SILENCE_TIME_MIN, DEFAULT_EOS_SILENCE_TIME] 之间
+#define DEFAULT_EOS_SILENCE_TIME_MIN 300
+
+// 句中停顿短于 60ms 认为是 VAD 抖动，不计入停顿统计
+#define DEFAULT_EOS_PAUSE_MIN        60
+
+// 尚未学到说话人停顿习惯时的停顿统计初始值（单位 ms）
+#define DEFAULT_EOS_PAUSE_MEAN       250
+#define DEFAULT_EOS_PAUSE_DEV        80
+#define DEFAULT_EOS_PAUSE_MARGIN     80
+
+// 信噪比低于 15dB 时 VAD 容易把语音判成静音，每低 1dB 静音超时加长 25ms
+#define DEFAULT_EOS_LOW_SNR          15
+#define DEFAULT_EOS_LOW_SNR_PENALTY  25
+
 // 每帧的长度（单位 ms，合法值：10ms/20ms/30ms），建议设置为 10ms
 #define DEFAULT_SPEECH_FRAME_TIME  10
 
+// 流式处理时，不足一帧的数据缓存到下次处理，按最高采样率 48kHz 分配
+#define MAX_SPEECH_FRAME_SIZE      (DEFAULT_SPEECH_FRAME_TIME * 48)
+
 struct litevad_priv {
     VadInst *vad_inst;
-    int      vad_mode;
+    litevad_config_t config;
     int      rate_idx;
     int      sample_rate;
     int      channel_count;
@@ -80,6 +101,18 @@ struct litevad_priv {
     int      silence_time;
     int      speech_weight;
     bool     speech_detected;
+    short    carry_buff[MAX_SPEECH_FRAME_SIZE];
+    int      carry_size;
+
+    // adaptive eos, kept across litevad_reset
+    litevad_hint_t hint;
+    int      pause_mean;            // ms
+    int      pause_dev;             // ms
+    int      noise_level;           // dB, Q4
+    int      speech_level;          // dB, Q4
+    bool     noise_level_valid;
+    bool     speech_level_valid;
+    int      last_eos_silence_time; // ms
 };
 
 // valid vad operating mode, A more aggressive (higher mode) VAD is more
@@ -122,13 +155,41 @@ static bool valid_frame_size(int rate_idx, int frame_size)
     return false;
 }
 
+void litevad_default_config(litevad_config_t *config)
+{
+    config->vad_mode             = DEFAULT_VAD_MODE;
+    config->bos_active_time      = DEFAULT_BOS_ACTIVE_TIME;
+    config->bos_active_weight    = DEFAULT_BOS_ACTIVE_WEIGHT;
+    config->eos_silence_time     = DEFAULT_EOS_SILENCE_TIME;
+    config->eos_silence_weight   = DEFAULT_EOS_SILENCE_WEIGHT;
+    config->eos_adaptive         = 0;
+    config->eos_silence_time_min = DEFAULT_EOS_SILENCE_TIME_MIN;
+}
+
 litevad_handle_t litevad_create(int sample_rate, int channel_count, int sample_bits)
 {
-    if (!valid_vad_mode(DEFAULT_VAD_MODE)) {
+    litevad_config_t config;
+    litevad_default_config(&config);
+    return litevad_create_with_config(sample_rate, channel_count, sample_bits, &config);
+}
+
+litevad_handle_t litevad_create_with_config(int sample_rate, int channel_count, int sample_bits,
+                                            const litevad_config_t *config)
+{
+    if (!valid_vad_mode(config->vad_mode)) {
         pr_err("Invalid vad mode, valid value: 0/1/2/3");
         return NULL;
     }
 
+    if (config->bos_active_time <= 0 || config->eos_silence_time <= 0 ||
+        config->bos_active_weight < 0 || config->bos_active_weight > 100 ||
+        config->eos_silence_weight < 0 || config->eos_silence_weight > 100 ||
+        (config->eos_adaptive &&
+         (config->eos_silence_time_min <= 0 || config->eos_silence_time_min > config->eos_silence_time))) {
+        pr_err("Invalid bos/eos config");
+        return NULL;
+    }
+
     int rate_idx = 0;
     if (!valid_sample_rate(sample_rate, &rate_idx)) {
         pr_err("Invalid sampling frequency, valid value: 8000/16000/32000/48000");
@@ -164,16 +225,18 @@ litevad_handle_t litevad_create(int sample_rate, int channel_count, int sample_b
         goto bail;
     }
 
-    ret = WebRtcVad_set_mode(priv->vad_inst, DEFAULT_VAD_MODE);
+    ret = WebRtcVad_set_mode(priv->vad_inst, config->vad_mode);
     if (ret != 0) {
         pr_err("Failed to set vad mode");
         goto bail;
     }
 
-    priv->vad_mode         = DEFAULT_VAD_MODE;
+    priv->config           = *config;
     priv->rate_idx         = rate_idx;
     priv->sample_rate      = sample_rate;
     priv->channel_count    = channel_count;
+    priv->pause_mean       = DEFAULT_EOS_PAUSE_MEAN;
+    priv->pause_dev        = DEFAULT_EOS_PAUSE_DEV;
     return (litevad_handle_t)priv;
 
 bail:
@@ -183,6 +246,63 @@ bail:
     return NULL;
 }
 
+// Frame energy in dB, ~3dB per bit of mean square
+static int litevad_frame_level(const short *frame_buff, int frame_size)
+{
+    uint64_t sum = 0;
+    for (int i = 0; i < frame_size; i++)
+        sum += (int32_t)frame_buff[i] * frame_buff[i];
+    uint32_t mean = (uint32_t)(sum / frame_size);
+    int bits = 0;
+    while (mean != 0) {
+        bits++;
+        mean >>= 1;
+    }
+    return bits * 3;
+}
+
+static void litevad_update_level(int *level, bool *valid, int frame_level)
+{
+    if (!*valid) {
+        *level = frame_level << 4;
+        *valid = true;
+    } else {
+        *level += ((frame_level << 4) - *level) / 16;
+    }
+}
+
+// An in-utterance pause just ended, fold it into the speaker statistics
+static void litevad_update_pause(struct litevad_priv *priv, int pause)
+{
+    int deviation = pause > priv->pause_mean ? pause - priv->pause_mean : priv->pause_mean - pause;
+    priv->pause_mean += (pause - priv->pause_mean) / 8;
+    priv->pause_dev  += (deviation - priv->pause_dev) / 8;
+    pr_dbg("pause=%d(ms), pause_mean=%d(ms), pause_dev=%d(ms)", pause, priv->pause_mean, priv->pause_dev);
+}
+
+static int litevad_eos_silence_time(struct litevad_priv *priv)
+{
+    const litevad_config_t *config = &priv->config;
+    if (!config->eos_adaptive)
+        return config->eos_silence_time;
+    if (priv->hint == LITEVAD_HINT_COMPLETE)
+        return config->eos_silence_time_min;
+    if (priv->hint == LITEVAD_HINT_INCOMPLETE)
+        return config->eos_silence_time;
+
+    int timeout = priv->pause_mean + 3 * priv->pause_dev + DEFAULT_EOS_PAUSE_MARGIN;
+    if (priv->noise_level_valid && priv->speech_level_valid) {
+        int snr = (priv->speech_level - priv->noise_level) >> 4;
+        if (snr < DEFAULT_EOS_LOW_SNR)
+            timeout += (DEFAULT_EOS_LOW_SNR - snr) * DEFAULT_EOS_LOW_SNR_PENALTY;
+    }
+    if (timeout < config->eos_silence_time_min)
+        timeout = config->eos_silence_time_min;
+    if (timeout > config->eos_silence_time)
+        timeout = config->eos_silence_time;
+    return timeout;
+}
+
 static int litevad_process_frame(litevad_handle_t handle, const short *frame_buff, int frame_size)
 {
     struct litevad_priv *priv = (struct litevad_priv *)handle;
@@ -193,6 +313,16 @@ static int litevad_process_frame(litevad_handle_t handle, const short *frame_buf
 
     int frame_time = frame_size / valid_sample_rates[priv->rate_idx];
     int ret = WebRtcVad_Process(priv->vad_inst, priv->sample_rate, frame_buff, frame_size);
+    if (priv->config.eos_adaptive && (ret == 0 || ret == 1)) {
+        if (ret == 1)
+            litevad_update_level(&priv->speech_level, &priv->speech_level_valid,
+                                 litevad_frame_level(frame_buff, frame_size));
+        else
+            litevad_update_level(&priv->noise_level, &priv->noise_level_valid,
+                                 litevad_frame_level(frame_buff, frame_size));
+        if (ret == 1 && priv->speech_detected && priv->silence_time >= DEFAULT_EOS_PAUSE_MIN)
+            litevad_update_pause(priv, priv->silence_time);
+    }
     if (ret == 1) {
         priv->silence_time = 0;
         priv->active_time += frame_time;
@@ -215,6 +345,50 @@ static int litevad_process_frame(litevad_handle_t handle, const short *frame_buf
     return ret;
 }
 
+// Run BOS/EOS state machine on one classified frame
+static litevad_result_t litevad_update_state(struct litevad_priv *priv, int ret)
+{
+    if (!priv->speech_detected &&
+        priv->active_time < priv->config.bos_active_time &&
+        priv->speech_weight < priv->config.bos_active_weight)
+        return LITEVAD_RESULT_FRAME_SILENCE;
+
+    if (!priv->speech_detected) {
+        pr_dbg("speech begin");
+        priv->speech_detected = true;
+        priv->speech_weight = 100;
+        priv->silence_time = 0;
+        return LITEVAD_RESULT_SPEECH_BEGIN;
+    }
+
+    int eos_silence_time = litevad_eos_silence_time(priv);
+    if (priv->silence_time < eos_silence_time &&
+        priv->speech_weight > priv->config.eos_silence_weight)
+        return LITEVAD_RESULT_FRAME_ACTIVE;
+
+    if (ret == LITEVAD_RESULT_FRAME_SILENCE) {
+        pr_dbg("speech end, eos_silence_time=%d(ms)", eos_silence_time);
+        priv->last_eos_silence_time = eos_silence_time;
+        priv->hint = LITEVAD_HINT_NONE;
+        priv->active_time = 0;
+        priv->silence_time = 0;
+        priv->speech_weight = 0;
+        priv->speech_detected = false;
+        return LITEVAD_RESULT_SPEECH_END;
+    }
+    return ret;
+}
+
+// Fold the result of one frame into the result of the whole buffer
+static litevad_result_t litevad_merge_result(litevad_result_t result, litevad_result_t frame_result)
+{
+    if (frame_result == LITEVAD_RESULT_SPEECH_BEGIN)
+        return LITEVAD_RESULT_SPEECH_BEGIN;
+    if (frame_result == LITEVAD_RESULT_SPEECH_END)
+        return result == LITEVAD_RESULT_SPEECH_BEGIN ? LITEVAD_RESULT_SPEECH_BEGIN_AND_END : LITEVAD_RESULT_SPEECH_END;
+    return result == LITEVAD_RESULT_SPEECH_BEGIN ? result : frame_result;
+}
+
 litevad_result_t litevad_process(litevad_handle_t handle, const void *buff, int size)
 {
     struct litevad_priv *priv = (struct litevad_priv *)handle;
@@ -236,45 +410,96 @@ litevad_result_t litevad_process(litevad_handle_t handle, const void *buff, int
             break;
         }
 
-        if (!priv->speech_detected &&
-            priv->active_time < DEFAULT_BOS_ACTIVE_TIME &&
-            priv->speech_weight < DEFAULT_BOS_ACTIVE_WEIGHT) {
-            result = LITEVAD_RESULT_FRAME_SILENCE;
-        } else {
-            if (!priv->speech_detected) {
-                pr_dbg("speech begin");
-                priv->speech_detected = true;
-                priv->speech_weight = 100;
-                priv->silence_time = 0;
-                result = LITEVAD_RESULT_SPEECH_BEGIN;
-            }
-
-            if (priv->silence_time < DEFAULT_EOS_SILENCE_TIME &&
-                priv->speech_weight > DEFAULT_EOS_SILENCE_WEIGHT) {
-                if (result != LITEVAD_RESULT_SPEECH_BEGIN)
-                    result = LITEVAD_RESULT_FRAME_ACTIVE;
-            } else if (ret == LITEVAD_RESULT_FRAME_SILENCE) {
-                pr_dbg("speech end");
-                priv->active_time = 0;
-                priv->silence_time = 0;
-                priv->speech_weight = 0;
-                priv->speech_detected = false;
-                if (result != LITEVAD_RESULT_SPEECH_BEGIN)
-                    result = LITEVAD_RESULT_SPEECH_END;
-                else
-                    result = LITEVAD_RESULT_SPEECH_BEGIN_AND_END;
+        result = litevad_merge_result(result, litevad_update_state(priv, ret));
+        if (result == LITEVAD_RESULT_SPEECH_END || result == LITEVAD_RESULT_SPEECH_BEGIN_AND_END)
+            break;
+        i += frame_size;
+    }
+
+    return result;
+}
+
+litevad_result_t litevad_process_stream(litevad_handle_t handle, const void *buff, int size,
+                                        litevad_stream_info_t *info)
+{
+    struct litevad_priv *priv = (struct litevad_priv *)handle;
+    const short *in_buff = (const short *)buff;
+    int nsamples = size / sizeof(short);
+    int frame_size = DEFAULT_SPEECH_FRAME_TIME * valid_sample_rates[priv->rate_idx];
+    int frames = 0, event_frame = -1, ret = 0;
+    bool speech_ended = false;
+    litevad_result_t result =
+            priv->speech_detected ? LITEVAD_RESULT_FRAME_ACTIVE : LITEVAD_RESULT_FRAME_SILENCE;
+
+    // the carry holds whole samples, a split sample would misalign everything after it
+    if (buff == NULL || size < 0 || size % sizeof(short) != 0)
+        return LITEVAD_RESULT_ERROR;
+    if (info != NULL && info->activity != NULL && info->activity_size > 0)
+        memset(info->activity, 0, info->activity_size);
+
+    while (nsamples > 0) {
+        const short *frame_buff;
+        if (priv->carry_size > 0 || nsamples < frame_size) {
+            // complete the carried frame first, or keep the tail for next call
+            int copy = frame_size - priv->carry_size;
+            if (copy > nsamples)
+                copy = nsamples;
+            memcpy(&priv->carry_buff[priv->carry_size], in_buff, copy * sizeof(short));
+            priv->carry_size += copy;
+            in_buff += copy;
+            nsamples -= copy;
+            if (priv->carry_size < frame_size)
                 break;
-            } else {
-                if (result != LITEVAD_RESULT_SPEECH_BEGIN)
-                    result = ret;
-            }
+            frame_buff = priv->carry_buff;
+            priv->carry_size = 0;
+        } else {
+            // whole frames are classified in place
+            frame_buff = in_buff;
+            in_buff += frame_size;
+            nsamples -= frame_size;
         }
-        i += frame_size;
+
+        ret = litevad_process_frame(priv, frame_buff, frame_size);
+        if (ret == LITEVAD_RESULT_ERROR)
+            return LITEVAD_RESULT_ERROR;
+        if (ret == LITEVAD_RESULT_FRAME_ACTIVE && info != NULL && info->activity != NULL &&
+            frames / 8 < info->activity_size)
+            info->activity[frames / 8] |= 1 << (frames % 8);
+
+        if (!speech_ended) {
+            litevad_result_t frame_result = litevad_update_state(priv, ret);
+            if (frame_result == LITEVAD_RESULT_SPEECH_BEGIN || frame_result == LITEVAD_RESULT_SPEECH_END)
+                event_frame = frames;
+            speech_ended = frame_result == LITEVAD_RESULT_SPEECH_END;
+            result = litevad_merge_result(result, frame_result);
+        }
+        frames++;
     }
 
+    if (info != NULL) {
+        info->frames = frames;
+        info->event_frame = event_frame;
+    }
     return result;
 }
 
+void litevad_set_hint(litevad_handle_t handle, litevad_hint_t hint)
+{
+    struct litevad_priv *priv = (struct litevad_priv *)handle;
+    priv->hint = hint;
+}
+
+void litevad_get_eos_info(litevad_handle_t handle, litevad_eos_info_t *info)
+{
+    struct litevad_priv *priv = (struct litevad_priv *)handle;
+    info->eos_silence_time      = litevad_eos_silence_time(priv);
+    info->last_eos_silence_time = priv->last_eos_silence_time;
+    info->pause_mean            = priv->pause_mean;
+    info->pause_dev             = priv->pause_dev;
+    info->noise_level           = priv->noise_level >> 4;
+    info->speech_level          = priv->speech_level >> 4;
+}
+
 void litevad_reset(litevad_handle_t handle)
 {
     struct litevad_priv *priv = (struct litevad_priv *)handle;
@@ -282,8 +507,10 @@ void litevad_reset(litevad_handle_t handle)
     priv->silence_time = 0;
     priv->speech_weight = 0;
     priv->speech_detected = false;
+    priv->carry_size = 0;
+    priv->hint = LITEVAD_HINT_NONE;
     WebRtcVad_Init(priv->vad_inst);
-    WebRtcVad_set_mode(priv->vad_inst, priv->vad_mode);
+    WebRtcVad_set_mode(priv->vad_inst, priv->config.vad_mode);
 }
 
 void litevad_destroy(litevad_handle_t handle)
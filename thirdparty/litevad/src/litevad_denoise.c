@@ -0,0 +1,494 @@
+/*
+ * Copyright (C) 2018-2023 Qinglong<sysu.zqlong@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "signal_processing/signal_processing_library.h"
+#include "litevad_denoise.h"
+
+#if defined(ANDROID)
+#include <android/log.h>
+#define TAG "litevad"
+#define pr_dbg(fmt, ...) //__android_log_print(ANDROID_LOG_DEBUG, TAG, fmt, ##__VA_ARGS__)
+#define pr_err(fmt, ...) __android_log_print(ANDROID_LOG_ERROR, TAG, fmt, ##__VA_ARGS__)
+
+#elif defined(LITEVAD_HAVE_SYSUTILS_ENABLED)
+#include "cutils/log_helper.h"
+#define TAG "litevad"
+#define pr_dbg(fmt, ...) //OS_LOGD(TAG, fmt, ##__VA_ARGS__)
+#define pr_err(fmt, ...) OS_LOGE(TAG, fmt, ##__VA_ARGS__)
+
+#else
+#define pr_dbg(fmt, ...) //fprintf(stdout, fmt "\n", ##__VA_ARGS__)
+#define pr_err(fmt, ...) fprintf(stderr, fmt "\n", ##__VA_ARGS__)
+#endif
+
+// 每帧 10ms，与 litevad 一致。分析窗为上一帧末尾 6ms + 当前帧，16kHz 下 256 点 FFT，
+// 8kHz 下 128 点。窗在重叠段按正弦上升、下降，平方和为 1，分析和合成用同一个窗，
+// 重叠相加后还原输入，输出延迟为重叠段 6ms
+#define DENOISE_FRAME_TIME         10
+#define DENOISE_MAX_FFT_ORDER      8
+#define DENOISE_MAX_FFT_SIZE       (1 << DENOISE_MAX_FFT_ORDER)
+#define DENOISE_MAX_BINS           (DENOISE_MAX_FFT_SIZE / 2 + 1)
+#define DENOISE_MAX_FRAME_SIZE     160
+#define DENOISE_MAX_OVERLAP        (DENOISE_MAX_FFT_SIZE - DENOISE_MAX_FRAME_SIZE)
+
+// 噪声估计：前 200ms 取幅度均值，之后跟随平滑幅度（每帧 1/4）的最小值，下降时每帧
+// 逼近 1/16，上升时每帧最多 1/128（约 3.4dB/s），语音段的能量不会很快被当成噪声。
+// 下降太快时非平稳噪声的间隙会把估计拉得过低
+#define DENOISE_INIT_FRAMES        20
+#define DENOISE_SMOOTH_SHIFT       2
+#define DENOISE_NOISE_FALL_SHIFT   4
+#define DENOISE_NOISE_RISE_SHIFT   7
+
+// 先验信噪比的判决引导平滑系数，Q8 0.98
+#define DENOISE_DD_ALPHA           251
+// 信噪比上限，幅度比 Q8，64 倍即 36dB，增益已非常接近 1
+#define DENOISE_RATIO_MAX          (64 << 8)
+
+// 300Hz~4kHz 能量超过噪声 10dB 认为是语音帧，只有语音帧更新 AGC 电平。门限取得高，
+// 多人说话的背景噪声（babble）减噪后的残留不会被当成语音放大
+#define DENOISE_SPEECH_LOW_FREQ    300
+#define DENOISE_SPEECH_HIGH_FREQ   4000
+#define DENOISE_SPEECH_RATIO       10
+
+// AGC：电平变大时每帧逼近 1/8，变小时 1/32；增益每帧最多升 0.5dB、降 1dB，
+// 峰值限制在 -1dBFS。最后一个语音帧 300ms 后增益回到 0dB，不放大语音后的残留噪声，
+// 否则 VAD 会把它当成语音而无法判停
+#define AGC_LEVEL_ATTACK_SHIFT     3
+#define AGC_LEVEL_DECAY_SHIFT      5
+#define AGC_HOLD_FRAMES            30
+#define AGC_HOLD_RANGE             10   // dB
+#define AGC_GAIN_UP_STEP           128  // Q8 dB
+#define AGC_GAIN_DOWN_STEP         256  // Q8 dB
+#define AGC_PEAK_LIMIT             29204
+
+#define DEFAULT_NS_LEVEL           1
+#define DEFAULT_AGC_TARGET_LEVEL   (-20)
+#define DEFAULT_AGC_MAX_GAIN       18
+
+// noise overestimation (Q8) and floor of the gain (Q14) of each ns_level
+static const struct {
+    int32_t noise_weight;
+    int32_t gain_floor;
+} ns_levels[] = {
+    { 256, 8211 },  // -6dB
+    { 320, 5181 },  // -10dB
+    { 384, 2913 },  // -15dB
+    { 512, 1638 },  // -20dB
+};
+
+// Rising half of the window over the overlap, sin(pi/2 * (n + 0.5) / overlap) in Q15
+static const int16_t window_96[96] = {
+      268,   804,  1340,  1876,  2411,  2945,  3479,  4011,  4543,  5073,  5602,  6130,
+     6655,  7180,  7702,  8222,  8740,  9255,  9768, 10279, 10786, 11291, 11793, 12292,
+    12787, 13279, 13767, 14252, 14733, 15210, 15683, 16151, 16616, 17075, 17531, 17981,
+    18427, 18868, 19304, 19735, 20160, 20580, 20994, 21403, 21806, 22204, 22595, 22980,
+    23359, 23732, 24099, 24459, 24812, 25159, 25499, 25833, 26159, 26478, 26791, 27096,
+    27394, 27684, 27967, 28243, 28511, 28771, 29024, 29269, 29506, 29736, 29957, 30170,
+    30375, 30572, 30761, 30942, 31114, 31278, 31434, 31581, 31720, 31850, 31972, 32085,
+    32190, 32286, 32373, 32452, 32522, 32583, 32635, 32679, 32714, 32741, 32758, 32767,
+};
+
+static const int16_t window_48[48] = {
+      536,  1608,  2678,  3745,  4808,  5866,  6918,  7962,  8998, 10024, 11039, 12043,
+    13033, 14010, 14972, 15917, 16846, 17757, 18648, 19520, 20371, 21199, 22006, 22788,
+    23546, 24279, 24986, 25667, 26320, 26944, 27540, 28106, 28642, 29148, 29622, 30064,
+    30475, 30853, 31197, 31508, 31786, 32029, 32239, 32413, 32553, 32658, 32729, 32764,
+};
+
+struct litevad_denoise_priv {
+    litevad_denoise_config_t config;
+    int      fft_order;
+    int      fft_size;
+    int      bins;
+    int      frame_size;        // samples per 10ms
+    int      overlap;
+    const int16_t *window;
+    struct RealFFT *fft;
+    int      speech_bin_low;
+    int      speech_bin_high;
+    int32_t  frame_size_log2;   // Q8
+    int      frames;            // frames analysed, up to DENOISE_INIT_FRAMES
+    bool     speech;            // last frame analysed looked like speech
+    int16_t  history[DENOISE_MAX_OVERLAP];     // input tail of the previous frame
+    int32_t  synthesis[DENOISE_MAX_OVERLAP];   // output tail of the previous frame
+    uint32_t noise[DENOISE_MAX_BINS];          // noise magnitude per bin
+    uint32_t smooth[DENOISE_MAX_BINS];         // smoothed magnitude
+    uint32_t clean[DENOISE_MAX_BINS];          // gained magnitude of the previous frame
+    int32_t  agc_level;         // Q8 dBFS
+    int32_t  agc_gain;          // Q8 dB
+    int32_t  agc_gain_lin;      // Q10, applied at the end of the previous frame
+    int      agc_hold;          // frames left before the gain is released
+};
+
+static uint32_t isqrt32(uint32_t x)
+{
+    uint32_t root = 0;
+    if (x == 0)
+        return 0;
+    // highest power of four not above x
+    uint32_t bit = 1u << ((31 - WebRtcSpl_NormU32(x)) & ~1);
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// log2(x) in Q8, log2(1 + f) ~= f + 0.34 * f * (1 - f) over the mantissa
+static int32_t log2_q8(uint32_t x)
+{
+    if (x == 0)
+        return -(32 << 8);
+    int zeros = WebRtcSpl_NormU32(x);
+    int32_t frac = (int32_t)((x << zeros) >> 23) & 0xFF;
+    frac += (87 * frac * (256 - frac)) >> 16;
+    return ((31 - zeros) << 8) + frac;
+}
+
+static int32_t log2_q8_u64(uint64_t x)
+{
+    int shift = 0;
+    while (x > 0xFFFFFFFFu) {
+        x >>= 1;
+        shift++;
+    }
+    return log2_q8((uint32_t)x) + (shift << 8);
+}
+
+// 10^(db / 20) in Q10 for db (Q8) >= 0, 2^f ~= 1 + f * (0.6565 + 0.3435 * f)
+static int32_t db_to_gain_q10(int32_t db)
+{
+    int32_t l2 = (db * 10885) >> 16;   // db / 6.0206
+    int32_t frac = l2 & 0xFF;
+    return (1024 + ((frac * (168 + ((88 * frac) >> 8))) >> 6)) << (l2 >> 8);
+}
+
+// num / den in Q8, saturated at DENOISE_RATIO_MAX
+static uint32_t ratio_q8(uint32_t num, uint32_t den)
+{
+    while (num >= (1u << 24)) {
+        num >>= 1;
+        den >>= 1;
+    }
+    if (den == 0 || (num >> 8) >= den)
+        return DENOISE_RATIO_MAX;
+    uint32_t ratio = (num << 8) / den;
+    return ratio < DENOISE_RATIO_MAX ? ratio : DENOISE_RATIO_MAX;
+}
+
+static int16_t window_at(struct litevad_denoise_priv *priv, int n)
+{
+    if (n < priv->overlap)
+        return priv->window[n];
+    if (n < priv->frame_size)
+        return 32767;
+    return priv->window[priv->fft_size - 1 - n];
+}
+
+// Spectrum of the frame and the tail of the previous one, normalised for the fixed point
+// FFT. Updates the noise estimate and speech decision, returns the normalisation shift
+static int analyze_frame(struct litevad_denoise_priv *priv, const int16_t *in,
+                         int16_t *spectrum, uint32_t *magnitude)
+{
+    int16_t buff[DENOISE_MAX_FFT_SIZE];
+    int n, k;
+
+    memcpy(buff, priv->history, priv->overlap * sizeof(int16_t));
+    memcpy(buff + priv->overlap, in, priv->frame_size * sizeof(int16_t));
+    memcpy(priv->history, buff + priv->frame_size, priv->overlap * sizeof(int16_t));
+
+    // one bit of headroom against the forward FFT butterflies
+    int16_t peak = WebRtcSpl_MaxAbsValueW16(buff, priv->fft_size);
+    int norm = WebRtcSpl_NormW16(peak) - 1;
+    if (norm < 0)
+        norm = 0;
+    for (n = 0; n < priv->fft_size; n++)
+        buff[n] = (int16_t)((buff[n] * (1 << norm) * window_at(priv, n) + 16384) >> 15);
+
+    WebRtcSpl_RealForwardFFT(priv->fft, buff, spectrum);
+
+    // magnitudes back in input units, the forward FFT is scaled down by fft_size
+    uint64_t speech_sum = 0, noise_sum = 0;
+    for (k = 0; k < priv->bins; k++) {
+        int32_t re = spectrum[2 * k];
+        int32_t im = spectrum[2 * k + 1];
+        uint32_t mag = isqrt32((uint32_t)(re * re) + (uint32_t)(im * im));
+        mag = (mag << priv->fft_order) >> norm;
+        magnitude[k] = mag;
+
+        priv->smooth[k] += ((int32_t)mag - (int32_t)priv->smooth[k]) >> DENOISE_SMOOTH_SHIFT;
+        if (priv->frames < DENOISE_INIT_FRAMES) {
+            int32_t diff = (int32_t)mag - (int32_t)priv->noise[k];
+            priv->noise[k] += diff / (priv->frames + 1);
+        } else if (priv->smooth[k] < priv->noise[k]) {
+            priv->noise[k] -= (priv->noise[k] - priv->smooth[k]) >> DENOISE_NOISE_FALL_SHIFT;
+        } else {
+            uint32_t rise = (priv->noise[k] >> DENOISE_NOISE_RISE_SHIFT) + 1;
+            if (rise > priv->smooth[k] - priv->noise[k])
+                rise = priv->smooth[k] - priv->noise[k];
+            priv->noise[k] += rise;
+        }
+
+        if (k >= priv->speech_bin_low && k <= priv->speech_bin_high) {
+            speech_sum += (uint64_t)mag * mag;
+            noise_sum += (uint64_t)priv->noise[k] * priv->noise[k];
+        }
+    }
+    if (priv->frames < DENOISE_INIT_FRAMES)
+        priv->frames++;
+    priv->speech = speech_sum > noise_sum * DENOISE_SPEECH_RATIO;
+    return norm;
+}
+
+// Decision-directed Wiener gain of each bin applied to the spectrum
+static void suppress_frame(struct litevad_denoise_priv *priv, int16_t *spectrum,
+                           const uint32_t *magnitude)
+{
+    int32_t weight = ns_levels[priv->config.ns_level].noise_weight;
+    int32_t floor = ns_levels[priv->config.ns_level].gain_floor;
+
+    for (int k = 0; k < priv->bins; k++) {
+        uint32_t noise = (uint32_t)(((uint64_t)priv->noise[k] * weight) >> 8);
+        if (noise == 0)
+            noise = 1;
+
+        // a posteriori and a priori SNR, power ratios in Q10
+        uint32_t post = ratio_q8(magnitude[k], noise);
+        uint32_t prio = ratio_q8(priv->clean[k], noise);
+        int32_t post_snr = (int32_t)((post * post) >> 6) - 1024;
+        int32_t prio_snr = (int32_t)((prio * prio) >> 6);
+        if (post_snr < 0)
+            post_snr = 0;
+        int32_t snr = (DENOISE_DD_ALPHA * prio_snr + (256 - DENOISE_DD_ALPHA) * post_snr) >> 8;
+
+        int32_t gain = 16384 - (1 << 24) / (snr + 1024);
+        if (gain < floor)
+            gain = floor;
+
+        priv->clean[k] = (uint32_t)(((uint64_t)magnitude[k] * gain) >> 14);
+        spectrum[2 * k] = (int16_t)((spectrum[2 * k] * gain + 8192) >> 14);
+        spectrum[2 * k + 1] = (int16_t)((spectrum[2 * k + 1] * gain + 8192) >> 14);
+    }
+}
+
+// Back to time domain, windowed and overlap-added into out
+static void synthesize_frame(struct litevad_denoise_priv *priv, const int16_t *spectrum,
+                             int norm, int16_t *out)
+{
+    int16_t buff[DENOISE_MAX_FFT_SIZE];
+    int scale = WebRtcSpl_RealInverseFFT(priv->fft, spectrum, buff);
+    // undo the inverse FFT scaling and the normalisation, Q15 of the window
+    int shift = scale - norm - 15;
+    int32_t round = shift < 0 ? 1 << (-shift - 1) : 0;
+
+    for (int n = 0; n < priv->fft_size; n++) {
+        int32_t value = buff[n] * window_at(priv, n);
+        value = shift < 0 ? (value + round) >> -shift : value << shift;
+        if (n < priv->overlap)
+            value += priv->synthesis[n];
+        if (n < priv->frame_size)
+            out[n] = WebRtcSpl_SatW32ToW16(value);
+        else
+            priv->synthesis[n - priv->frame_size] = value;
+    }
+}
+
+static void agc_frame(struct litevad_denoise_priv *priv, int16_t *frame)
+{
+    int scale = 0;
+    int32_t energy = WebRtcSpl_Energy(frame, priv->frame_size, &scale);
+    // mean square over full scale 2^30, 10 * log10(2) = 3.0103 is 771 in Q8
+    int32_t level = log2_q8((uint32_t)energy) + (scale << 8) - priv->frame_size_log2 - (30 << 8);
+    level = (level * 771) >> 8;
+
+    if (priv->speech) {
+        int32_t diff = level - priv->agc_level;
+        priv->agc_level += diff >> (diff > 0 ? AGC_LEVEL_ATTACK_SHIFT : AGC_LEVEL_DECAY_SHIFT);
+        if (level > priv->agc_level - (AGC_HOLD_RANGE << 8))
+            priv->agc_hold = AGC_HOLD_FRAMES;
+    } else if (priv->agc_hold > 0) {
+        priv->agc_hold--;
+    }
+
+    int32_t target = (priv->config.agc_target_level << 8) - priv->agc_level;
+    if (target < 0 || priv->agc_hold == 0)
+        target = 0;
+    if (target > (priv->config.agc_max_gain << 8))
+        target = priv->config.agc_max_gain << 8;
+    if (target > priv->agc_gain)
+        priv->agc_gain = target - priv->agc_gain > AGC_GAIN_UP_STEP ?
+                priv->agc_gain + AGC_GAIN_UP_STEP : target;
+    else
+        priv->agc_gain = priv->agc_gain - target > AGC_GAIN_DOWN_STEP ?
+                priv->agc_gain - AGC_GAIN_DOWN_STEP : target;
+
+    // limit the peak, and ramp from the gain of the previous frame
+    int32_t gain = db_to_gain_q10(priv->agc_gain);
+    int32_t peak = WebRtcSpl_MaxAbsValueW16(frame, priv->frame_size);
+    if (peak * gain > (AGC_PEAK_LIMIT << 10))
+        gain = (AGC_PEAK_LIMIT << 10) / peak;
+    int32_t start = priv->agc_gain_lin;
+    int32_t step = ((gain - start) << 8) / priv->frame_size;
+    for (int n = 0; n < priv->frame_size; n++) {
+        int32_t g = start + ((step * (n + 1)) >> 8);
+        frame[n] = WebRtcSpl_SatW32ToW16((frame[n] * g + 512) >> 10);
+    }
+    priv->agc_gain_lin = gain;
+}
+
+void litevad_denoise_default_config(litevad_denoise_config_t *config)
+{
+    config->ns_level         = DEFAULT_NS_LEVEL;
+    config->agc_enable       = 1;
+    config->agc_target_level = DEFAULT_AGC_TARGET_LEVEL;
+    config->agc_max_gain     = DEFAULT_AGC_MAX_GAIN;
+}
+
+litevad_denoise_handle_t litevad_denoise_create(int sample_rate, const litevad_denoise_config_t *config)
+{
+    litevad_denoise_config_t defaults;
+
+    if (sample_rate != 8000 && sample_rate != 16000) {
+        pr_err("Invalid sampling frequency, valid value: 8000/16000");
+        return NULL;
+    }
+
+    if (config == NULL) {
+        litevad_denoise_default_config(&defaults);
+        config = &defaults;
+    }
+    if (config->ns_level < 0 || config->ns_level > 3) {
+        pr_err("Invalid ns level, valid value: 0-3");
+        return NULL;
+    }
+    if (config->agc_target_level < -30 || config->agc_target_level > 0) {
+        pr_err("Invalid agc target level, valid value: -30~0");
+        return NULL;
+    }
+    if (config->agc_max_gain < 0 || config->agc_max_gain > 30) {
+        pr_err("Invalid agc max gain, valid value: 0~30");
+        return NULL;
+    }
+
+    struct litevad_denoise_priv *priv =
+            (struct litevad_denoise_priv *)calloc(1, sizeof(struct litevad_denoise_priv));
+    if (priv == NULL)
+        return NULL;
+
+    WebRtcSpl_Init();
+
+    priv->config     = *config;
+    priv->fft_order  = sample_rate == 16000 ? DENOISE_MAX_FFT_ORDER : DENOISE_MAX_FFT_ORDER - 1;
+    priv->fft_size   = 1 << priv->fft_order;
+    priv->bins       = priv->fft_size / 2 + 1;
+    priv->frame_size = DENOISE_FRAME_TIME * sample_rate / 1000;
+    priv->overlap    = priv->fft_size - priv->frame_size;
+    priv->window     = sample_rate == 16000 ? window_96 : window_48;
+    priv->speech_bin_low  = DENOISE_SPEECH_LOW_FREQ * priv->fft_size / sample_rate;
+    priv->speech_bin_high = DENOISE_SPEECH_HIGH_FREQ * priv->fft_size / sample_rate;
+    priv->frame_size_log2 = log2_q8(priv->frame_size);
+    priv->agc_level    = config->agc_target_level << 8;
+    priv->agc_gain_lin = 1 << 10;
+
+    priv->fft = WebRtcSpl_CreateRealFFT(priv->fft_order);
+    if (priv->fft == NULL) {
+        free(priv);
+        return NULL;
+    }
+    return (litevad_denoise_handle_t)priv;
+}
+
+int litevad_denoise_process(litevad_denoise_handle_t handle, void *buff, int size)
+{
+    struct litevad_denoise_priv *priv = (struct litevad_denoise_priv *)handle;
+    int frame_bytes = priv->frame_size * sizeof(int16_t);
+    int16_t spectrum[DENOISE_MAX_FFT_SIZE + 2];
+    uint32_t magnitude[DENOISE_MAX_BINS];
+
+    if (buff == NULL || size < 0 || size % frame_bytes != 0)
+        return -1;
+
+    for (int16_t *frame = (int16_t *)buff; size > 0; frame += priv->frame_size, size -= frame_bytes) {
+        int norm = analyze_frame(priv, frame, spectrum, magnitude);
+        suppress_frame(priv, spectrum, magnitude);
+        synthesize_frame(priv, spectrum, norm, frame);
+        if (priv->config.agc_enable)
+            agc_frame(priv, frame);
+    }
+    return 0;
+}
+
+int litevad_denoise_analyze(litevad_denoise_handle_t handle, const void *buff, int size)
+{
+    struct litevad_denoise_priv *priv = (struct litevad_denoise_priv *)handle;
+    int frame_bytes = priv->frame_size * sizeof(int16_t);
+    int16_t spectrum[DENOISE_MAX_FFT_SIZE + 2];
+    uint32_t magnitude[DENOISE_MAX_BINS];
+
+    if (buff == NULL || size < 0 || size % frame_bytes != 0)
+        return -1;
+
+    const int16_t *frame = (const int16_t *)buff;
+    for (; size > 0; frame += priv->frame_size, size -= frame_bytes)
+        analyze_frame(priv, frame, spectrum, magnitude);
+    // nothing was synthesized, the next processed frame must not overlap stale output
+    memset(priv->synthesis, 0, sizeof(priv->synthesis));
+    memset(priv->clean, 0, sizeof(priv->clean));
+    return 0;
+}
+
+void litevad_denoise_get_info(litevad_denoise_handle_t handle, litevad_denoise_info_t *info)
+{
+    struct litevad_denoise_priv *priv = (struct litevad_denoise_priv *)handle;
+
+    // Parseval, the window squared sums to frame_size and the bins between DC and
+    // Nyquist count twice
+    uint64_t power = 0;
+    for (int k = 0; k < priv->bins; k++) {
+        uint64_t p = (uint64_t)priv->noise[k] * priv->noise[k];
+        power += (k == 0 || k == priv->bins - 1) ? p : 2 * p;
+    }
+    int32_t level = log2_q8_u64(power) - (priv->fft_order << 8) - priv->frame_size_log2 - (30 << 8);
+    info->noise_level  = ((level * 771) >> 8) / 256;
+    info->speech_level = priv->agc_level / 256;
+    info->agc_gain     = priv->agc_gain / 256;
+}
+
+void litevad_denoise_reset(litevad_denoise_handle_t handle)
+{
+    struct litevad_denoise_priv *priv = (struct litevad_denoise_priv *)handle;
+    memset(priv->history, 0, sizeof(priv->history));
+    memset(priv->synthesis, 0, sizeof(priv->synthesis));
+    memset(priv->clean, 0, sizeof(priv->clean));
+}
+
+void litevad_denoise_destroy(litevad_denoise_handle_t handle)
+{
+    struct litevad_denoise_priv *priv = (struct litevad_denoise_priv *)handle;
+    WebRtcSpl_FreeRealFFT(priv->fft);
+    free(priv);
+}
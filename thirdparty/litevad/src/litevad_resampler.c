@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2018-2023 Qinglong<sysu.zqlong@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "signal_processing/signal_processing_library.h"
+#include "litevad_resampler.h"
+
+#if defined(WEBRTC_USE_SSE2)
+#include <emmintrin.h>
+#elif defined(WEBRTC_HAS_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(ANDROID)
+#include <android/log.h>
+#define TAG "litevad"
+#define pr_dbg(fmt, ...) //__android_log_print(ANDROID_LOG_DEBUG, TAG, fmt, ##__VA_ARGS__)
+#define pr_err(fmt, ...) __android_log_print(ANDROID_LOG_ERROR, TAG, fmt, ##__VA_ARGS__)
+
+#elif defined(LITEVAD_HAVE_SYSUTILS_ENABLED)
+#include "cutils/log_helper.h"
+#define TAG "litevad"
+#define pr_dbg(fmt, ...) //OS_LOGD(TAG, fmt, ##__VA_ARGS__)
+#define pr_err(fmt, ...) OS_LOGE(TAG, fmt, ##__VA_ARGS__)
+
+#else
+#define pr_dbg(fmt, ...) //fprintf(stdout, fmt "\n", ##__VA_ARGS__)
+#define pr_err(fmt, ...) fprintf(stderr, fmt "\n", ##__VA_ARGS__)
+#endif
+
+// 每次重采样 10ms，webrtc 的重采样函数都按固定块长处理
+#define RESAMPLE_BLOCK_TIME        10
+#define RESAMPLE_OUT_BLOCK_SIZE    (RESAMPLE_BLOCK_TIME * LITEVAD_RESAMPLER_OUT_RATE / 1000)
+// 输入块长按最高采样率 96kHz 分配
+#define RESAMPLE_MAX_BLOCK_SIZE    (RESAMPLE_BLOCK_TIME * 96)
+#define RESAMPLE_MAX_CHANNELS      8
+
+struct litevad_resampler_priv {
+    int      sample_rate;
+    int      channel_count;
+    int      sample_bytes;
+    int      sample_shift;          // left shift that puts a 24 bit sample in the upper bits
+    int      downmix_gain;          // Q15, 1/channel_count
+    int      block_size;            // input samples per 10ms block
+    int      block_fill;            // samples downmixed into block so far
+    int16_t  block[RESAMPLE_MAX_BLOCK_SIZE];
+    int16_t  tmp[RESAMPLE_MAX_BLOCK_SIZE / 2];
+    int32_t  tmp_mem[496];          // largest scratch of the webrtc resamplers, 48 -> 16
+    int32_t  by2_state[8];
+    union {
+        WebRtcSpl_State48khzTo16khz s48_16;
+        WebRtcSpl_State22khzTo16khz s22_16;
+        WebRtcSpl_State22khzTo8khz  s22_8;
+    } state;
+};
+
+// valid input sample rates and their 10ms block length, 22050/44100 run as 22000/44000
+static const struct {
+    int sample_rate;
+    int block_size;
+} valid_sample_rates[] = {
+    { 8000,  80  },
+    { 16000, 160 },
+    { 22050, 220 },
+    { 24000, 240 },
+    { 32000, 320 },
+    { 44100, 440 },
+    { 48000, 480 },
+    { 96000, 960 },
+};
+
+#define ARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
+
+// Average of the channels of S16 frames
+static void downmix_s16(const int16_t *in, int frames, int channels, int gain, int16_t *out)
+{
+    int i = 0;
+
+    if (channels == 1) {
+        memcpy(out, in, frames * sizeof(int16_t));
+        return;
+    }
+
+    if (channels == 2) {
+#if defined(WEBRTC_USE_SSE2)
+        const __m128i ones = _mm_set1_epi16(1);
+        for (; i + 8 <= frames; i += 8) {
+            __m128i lr0 = _mm_loadu_si128((const __m128i *)&in[2 * i]);
+            __m128i lr1 = _mm_loadu_si128((const __m128i *)&in[2 * i + 8]);
+            __m128i sum0 = _mm_srai_epi32(_mm_madd_epi16(lr0, ones), 1);
+            __m128i sum1 = _mm_srai_epi32(_mm_madd_epi16(lr1, ones), 1);
+            _mm_storeu_si128((__m128i *)&out[i], _mm_packs_epi32(sum0, sum1));
+        }
+#elif defined(WEBRTC_HAS_NEON)
+        for (; i + 8 <= frames; i += 8) {
+            int32x4_t sum0 = vpaddlq_s16(vld1q_s16(&in[2 * i]));
+            int32x4_t sum1 = vpaddlq_s16(vld1q_s16(&in[2 * i + 8]));
+            vst1q_s16(&out[i], vcombine_s16(vshrn_n_s32(sum0, 1), vshrn_n_s32(sum1, 1)));
+        }
+#endif
+        for (; i < frames; i++)
+            out[i] = (int16_t)((in[2 * i] + in[2 * i + 1]) >> 1);
+        return;
+    }
+
+    for (; i < frames; i++) {
+        int32_t sum = 0;
+        for (int c = 0; c < channels; c++)
+            sum += in[i * channels + c];
+        out[i] = (int16_t)((sum * gain) >> 15);
+    }
+}
+
+// Average of the channels of S32/S24 frames, upper 16 bits of each sample
+static void downmix_s32(const int32_t *in, int frames, int channels, int shift, int gain,
+                        int16_t *out)
+{
+    int i = 0;
+
+    if (channels == 2) {
+#if defined(WEBRTC_USE_SSE2)
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128i vshift = _mm_cvtsi32_si128(shift);
+        for (; i + 4 <= frames; i += 4) {
+            __m128i lr0 = _mm_loadu_si128((const __m128i *)&in[2 * i]);
+            __m128i lr1 = _mm_loadu_si128((const __m128i *)&in[2 * i + 4]);
+            lr0 = _mm_srai_epi32(_mm_sll_epi32(lr0, vshift), 16);
+            lr1 = _mm_srai_epi32(_mm_sll_epi32(lr1, vshift), 16);
+            __m128i sum = _mm_srai_epi32(_mm_madd_epi16(_mm_packs_epi32(lr0, lr1), ones), 1);
+            _mm_storel_epi64((__m128i *)&out[i], _mm_packs_epi32(sum, sum));
+        }
+#elif defined(WEBRTC_HAS_NEON)
+        const int32x4_t vshift = vdupq_n_s32(shift);
+        for (; i + 4 <= frames; i += 4) {
+            int32x4x2_t lr = vld2q_s32(&in[2 * i]);
+            int32x4_t l = vshrq_n_s32(vshlq_s32(lr.val[0], vshift), 16);
+            int32x4_t r = vshrq_n_s32(vshlq_s32(lr.val[1], vshift), 16);
+            vst1_s16(&out[i], vshrn_n_s32(vaddq_s32(l, r), 1));
+        }
+#endif
+        for (; i < frames; i++) {
+            int32_t l = (int32_t)((uint32_t)in[2 * i] << shift) >> 16;
+            int32_t r = (int32_t)((uint32_t)in[2 * i + 1] << shift) >> 16;
+            out[i] = (int16_t)((l + r) >> 1);
+        }
+        return;
+    }
+
+    for (; i < frames; i++) {
+        int32_t sum = 0;
+        for (int c = 0; c < channels; c++)
+            sum += (int32_t)((uint32_t)in[i * channels + c] << shift) >> 16;
+        out[i] = (int16_t)((sum * gain) >> 15);
+    }
+}
+
+// One 10ms block from priv->block to RESAMPLE_OUT_BLOCK_SIZE samples at out
+static void resample_block(struct litevad_resampler_priv *priv, int16_t *out)
+{
+    switch (priv->sample_rate) {
+    case 8000:
+        WebRtcSpl_UpsampleBy2(priv->block, 80, out, priv->by2_state);
+        break;
+    case 16000:
+        memcpy(out, priv->block, 160 * sizeof(int16_t));
+        break;
+    case 22050:
+        WebRtcSpl_Resample22khzTo16khz(priv->block, out, &priv->state.s22_16, priv->tmp_mem);
+        break;
+    case 24000:
+        // 24 -> 48 -> 16, same as webrtc's Resampler
+        WebRtcSpl_UpsampleBy2(priv->block, 240, priv->tmp, priv->by2_state);
+        WebRtcSpl_Resample48khzTo16khz(priv->tmp, out, &priv->state.s48_16, priv->tmp_mem);
+        break;
+    case 32000:
+        WebRtcSpl_DownsampleBy2(priv->block, 320, out, priv->by2_state);
+        break;
+    case 44100:
+        // 44 -> 16 is 22 -> 8 at twice the rate
+        WebRtcSpl_Resample22khzTo8khz(priv->block, out, &priv->state.s22_8, priv->tmp_mem);
+        WebRtcSpl_Resample22khzTo8khz(priv->block + 220, out + 80, &priv->state.s22_8,
+                                      priv->tmp_mem);
+        break;
+    case 48000:
+        WebRtcSpl_Resample48khzTo16khz(priv->block, out, &priv->state.s48_16, priv->tmp_mem);
+        break;
+    case 96000:
+        // 96 -> 32 -> 16
+        WebRtcSpl_Resample48khzTo16khz(priv->block, priv->tmp, &priv->state.s48_16,
+                                       priv->tmp_mem);
+        WebRtcSpl_Resample48khzTo16khz(priv->block + 480, priv->tmp + 160, &priv->state.s48_16,
+                                       priv->tmp_mem);
+        WebRtcSpl_DownsampleBy2(priv->tmp, 320, out, priv->by2_state);
+        break;
+    }
+}
+
+litevad_resampler_handle_t litevad_resampler_create(int sample_rate, int channel_count, int sample_bits)
+{
+    int block_size = 0;
+    for (int i = 0; i < ARRAY_SIZE(valid_sample_rates); i++) {
+        if (sample_rate == valid_sample_rates[i].sample_rate) {
+            block_size = valid_sample_rates[i].block_size;
+            break;
+        }
+    }
+    if (block_size == 0) {
+        pr_err("Invalid sampling frequency, valid value: 8000/16000/22050/24000/32000/44100/48000/96000");
+        return NULL;
+    }
+
+    if (channel_count < 1 || channel_count > RESAMPLE_MAX_CHANNELS) {
+        pr_err("Invalid channel count, valid value: 1-%d", RESAMPLE_MAX_CHANNELS);
+        return NULL;
+    }
+
+    if (sample_bits != 16 && sample_bits != 24 && sample_bits != 32) {
+        pr_err("Invalid sample bits, valid value: 16/24/32");
+        return NULL;
+    }
+
+    struct litevad_resampler_priv *priv =
+            (struct litevad_resampler_priv *)calloc(1, sizeof(struct litevad_resampler_priv));
+    if (priv == NULL)
+        return NULL;
+
+    priv->sample_rate   = sample_rate;
+    priv->channel_count = channel_count;
+    priv->sample_bytes  = sample_bits == 16 ? 2 : 4;
+    priv->sample_shift  = sample_bits == 24 ? 8 : 0;
+    priv->downmix_gain  = 32768 / channel_count;
+    priv->block_size    = block_size;
+    litevad_resampler_reset(priv);
+    return (litevad_resampler_handle_t)priv;
+}
+
+int litevad_resampler_output_size(litevad_resampler_handle_t handle, int size)
+{
+    struct litevad_resampler_priv *priv = (struct litevad_resampler_priv *)handle;
+    int samples = priv->block_fill + size / (priv->sample_bytes * priv->channel_count);
+    return samples / priv->block_size * RESAMPLE_OUT_BLOCK_SIZE * sizeof(int16_t);
+}
+
+int litevad_resampler_process(litevad_resampler_handle_t handle, const void *in, int size,
+                              void *out, int out_size)
+{
+    struct litevad_resampler_priv *priv = (struct litevad_resampler_priv *)handle;
+    int frame_bytes = priv->sample_bytes * priv->channel_count;
+    const char *in_buff = (const char *)in;
+    int16_t *out_buff = (int16_t *)out;
+    int frames = size / frame_bytes;
+
+    if (in == NULL || size < 0 || size % frame_bytes != 0)
+        return -1;
+    if (out_size < litevad_resampler_output_size(handle, size))
+        return -1;
+
+    // downmix straight into the block and resample it as soon as it's full, the block
+    // stays in cache between the two passes
+    while (frames > 0) {
+        int count = priv->block_size - priv->block_fill;
+        if (count > frames)
+            count = frames;
+        if (priv->sample_bytes == 2)
+            downmix_s16((const int16_t *)in_buff, count, priv->channel_count,
+                        priv->downmix_gain, &priv->block[priv->block_fill]);
+        else
+            downmix_s32((const int32_t *)in_buff, count, priv->channel_count,
+                        priv->sample_shift, priv->downmix_gain, &priv->block[priv->block_fill]);
+        priv->block_fill += count;
+        in_buff += count * frame_bytes;
+        frames -= count;
+
+        if (priv->block_fill == priv->block_size) {
+            resample_block(priv, out_buff);
+            out_buff += RESAMPLE_OUT_BLOCK_SIZE;
+            priv->block_fill = 0;
+        }
+    }
+    return (int)((char *)out_buff - (char *)out);
+}
+
+void litevad_resampler_reset(litevad_resampler_handle_t handle)
+{
+    struct litevad_resampler_priv *priv = (struct litevad_resampler_priv *)handle;
+    priv->block_fill = 0;
+    memset(priv->by2_state, 0, sizeof(priv->by2_state));
+    switch (priv->sample_rate) {
+    case 22050:
+        WebRtcSpl_ResetResample22khzTo16khz(&priv->state.s22_16);
+        break;
+    case 44100:
+        WebRtcSpl_ResetResample22khzTo8khz(&priv->state.s22_8);
+        break;
+    case 24000:
+    case 48000:
+    case 96000:
+        WebRtcSpl_ResetResample48khzTo16khz(&priv->state.s48_16);
+        break;
+    }
+}
+
+void litevad_resampler_destroy(litevad_resampler_handle_t handle)
+{
+    free(handle);
+}
@@ -101,9 +101,44 @@ extern "C" {
 // inline functions:
 #include "spl_inl.h"
 
-int16_t WebRtcSpl_GetScalingSquare(int16_t* in_vector,
-                                   size_t in_vector_length,
-                                   size_t times);
+// CPU features that select the implementation of the function pointers below,
+// see spl_init.c.
+#define WEBRTC_SPL_CPU_SSE2         (1 << 0)
+#define WEBRTC_SPL_CPU_NEON         (1 << 1)
+
+// Initialize the function pointers to the fastest implementation the CPU
+// supports. The pointers start out at the generic C code, so calling this is
+// optional. Thread safe, the detection is done once.
+void WebRtcSpl_Init(void);
+
+// Same as WebRtcSpl_Init() but restricted to |cpu_features|, 0 selects the
+// generic C code and features the CPU lacks are ignored. All implementations
+// are bit-exact, this is meant for tests and benchmarks. Not thread safe, don't
+// call while another thread runs SPL functions.
+void WebRtcSpl_InitWithCpuFeatures(int cpu_features);
+
+// Returns the WEBRTC_SPL_CPU_* features of this CPU that SPL has code for.
+int WebRtcSpl_GetCpuFeatures(void);
+
+// Get the number of right shifts needed so that |times| products of the
+// largest value in |in_vector| with itself can be summed without overflow.
+typedef int16_t (*GetScalingSquare)(int16_t* in_vector,
+                                    size_t in_vector_length,
+                                    size_t times);
+extern GetScalingSquare WebRtcSpl_GetScalingSquare;
+int16_t WebRtcSpl_GetScalingSquareC(int16_t* in_vector,
+                                    size_t in_vector_length,
+                                    size_t times);
+#if defined(WEBRTC_USE_SSE2)
+int16_t WebRtcSpl_GetScalingSquareSSE2(int16_t* in_vector,
+                                       size_t in_vector_length,
+                                       size_t times);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+int16_t WebRtcSpl_GetScalingSquareNeon(int16_t* in_vector,
+                                       size_t in_vector_length,
+                                       size_t times);
+#endif
 
 // Divisions. Implementations collected in division_operations.c and
 // descriptions at bottom of this file.
@@ -114,9 +149,95 @@ int32_t WebRtcSpl_DivResultInQ31(int32_t num, int32_t den);
 int32_t WebRtcSpl_DivW32HiLow(int32_t num, int16_t den_hi, int16_t den_low);
 // End: Divisions.
 
-int32_t WebRtcSpl_Energy(int16_t* vector,
-                         size_t vector_length,
-                         int* scale_factor);
+typedef int32_t (*Energy)(int16_t* vector,
+                          size_t vector_length,
+                          int* scale_factor);
+extern Energy WebRtcSpl_Energy;
+int32_t WebRtcSpl_EnergyC(int16_t* vector,
+                          size_t vector_length,
+                          int* scale_factor);
+#if defined(WEBRTC_USE_SSE2)
+int32_t WebRtcSpl_EnergySSE2(int16_t* vector,
+                             size_t vector_length,
+                             int* scale_factor);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+int32_t WebRtcSpl_EnergyNeon(int16_t* vector,
+                             size_t vector_length,
+                             int* scale_factor);
+#endif
+
+// Maximum absolute value of |vector|, abs(-32768) is returned as 32767.
+typedef int16_t (*MaxAbsValueW16)(const int16_t* vector, size_t length);
+extern MaxAbsValueW16 WebRtcSpl_MaxAbsValueW16;
+int16_t WebRtcSpl_MaxAbsValueW16C(const int16_t* vector, size_t length);
+#if defined(WEBRTC_USE_SSE2)
+int16_t WebRtcSpl_MaxAbsValueW16SSE2(const int16_t* vector, size_t length);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+int16_t WebRtcSpl_MaxAbsValueW16Neon(const int16_t* vector, size_t length);
+#endif
+
+/************************************************************
+ *
+ * FFT FUNCTIONS ARE DEFINED BELOW
+ *
+ ************************************************************/
+
+// Largest FFT order of this tree, 256 points of the 16 kHz noise suppressor.
+// The real FFTs keep a complex buffer of 2^order points on the stack.
+enum { kMaxFFTOrder = 8 };
+
+struct RealFFT;
+
+struct RealFFT* WebRtcSpl_CreateRealFFT(int order);
+void WebRtcSpl_FreeRealFFT(struct RealFFT* self);
+
+// Forward FFT of 2^order real samples, the output is the first 2^order / 2 + 1
+// complex bins as interleaved real and imaginary parts (2^order + 2 int16_t),
+// scaled down by 2^order. Returns 0, or -1 on error.
+int WebRtcSpl_RealForwardFFT(struct RealFFT* self,
+                             const int16_t* real_data_in,
+                             int16_t* complex_data_out);
+
+// Inverse of WebRtcSpl_RealForwardFFT(), the 2^order / 2 + 1 bins in are
+// completed by conjugate symmetry. Not scaled down by 2^order, instead each
+// stage is scaled down only as far as needed against overflow. Returns the
+// total number of right shifts applied, or -1 on error.
+int WebRtcSpl_RealInverseFFT(struct RealFFT* self,
+                             const int16_t* complex_data_in,
+                             int16_t* real_data_out);
+
+// Puts the 2^|stages| complex elements of |complex_data| in bit-reversed
+// order, the input order WebRtcSpl_ComplexFFT() and WebRtcSpl_ComplexIFFT()
+// expect.
+void WebRtcSpl_ComplexBitReverse(int16_t* __restrict complex_data, int stages);
+
+// In-place complex FFT of 2^|stages| (at most 1024) bit-reversed points,
+// interleaved real and imaginary parts. Every stage is scaled down by 2, the
+// output is scaled down by 2^|stages|. Returns 0, or -1 on error.
+typedef int (*ComplexFFT)(int16_t frfi[], int stages);
+extern ComplexFFT WebRtcSpl_ComplexFFT;
+int WebRtcSpl_ComplexFFTC(int16_t frfi[], int stages);
+#if defined(WEBRTC_USE_SSE2)
+int WebRtcSpl_ComplexFFTSSE2(int16_t frfi[], int stages);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+int WebRtcSpl_ComplexFFTNeon(int16_t frfi[], int stages);
+#endif
+
+// In-place complex inverse FFT of 2^|stages| (at most 1024) bit-reversed
+// points. A stage is scaled down by 2 or 4 only when its input is large
+// enough to overflow. Returns the total number of right shifts, or -1 on error.
+typedef int (*ComplexIFFT)(int16_t frfi[], int stages);
+extern ComplexIFFT WebRtcSpl_ComplexIFFT;
+int WebRtcSpl_ComplexIFFTC(int16_t frfi[], int stages);
+#if defined(WEBRTC_USE_SSE2)
+int WebRtcSpl_ComplexIFFTSSE2(int16_t frfi[], int stages);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+int WebRtcSpl_ComplexIFFTNeon(int16_t frfi[], int stages);
+#endif
 
 /************************************************************
  *
@@ -55,6 +55,16 @@
 #error Define either WEBRTC_ARCH_LITTLE_ENDIAN or WEBRTC_ARCH_BIG_ENDIAN
 #endif
 
+// SIMD implementations are built when the compiler targets the instruction
+// set. ARMv7 builds without -mfpu=neon can define WEBRTC_DETECT_NEON and build
+// only the *_neon.c files with -mfpu=neon, NEON is then picked at runtime.
+#if defined(WEBRTC_ARCH_X86_FAMILY) && (defined(__SSE2__) || defined(_M_X64))
+#define WEBRTC_USE_SSE2
+#endif
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define WEBRTC_HAS_NEON
+#endif
+
 // TODO(zhongwei.yao): WEBRTC_CPU_DETECTION is only used in one place; we should
 // probably just remove it.
 #if (defined(WEBRTC_ARCH_X86_FAMILY) && !defined(__SSE2__)) || \
@@ -26,9 +26,19 @@ typedef struct WebRtcVadInst VadInst;
 extern "C" {
 #endif
 
-// Creates an instance to the VAD structure.
+// Creates an instance to the VAD structure. The first call also selects the
+// fastest implementation of the signal processing functions the CPU supports.
 VadInst* WebRtcVad_Create();
 
+// Restricts the signal processing functions of all VAD instances to
+// |cpu_features|, a mask of WEBRTC_SPL_CPU_* from signal_processing_library.h,
+// 0 selects the generic C code. All implementations give bit-exact results,
+// this is meant for tests and benchmarks. Not thread safe, don't call while
+// another thread runs WebRtcVad_Process().
+//
+// - cpu_features [i] : Allowed CPU features, others are ignored.
+void WebRtcVad_InitWithCpuFeatures(int cpu_features);
+
 // Frees the dynamic memory of a specified VAD instance.
 //
 // - handle [i] : Pointer to VAD instance that should be freed.
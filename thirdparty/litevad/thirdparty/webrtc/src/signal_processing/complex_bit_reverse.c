@@ -0,0 +1,43 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * This file contains the function WebRtcSpl_ComplexBitReverse().
+ * The description header can be found in signal_processing_library.h
+ *
+ */
+
+#include "signal_processing/signal_processing_library.h"
+
+void WebRtcSpl_ComplexBitReverse(int16_t* __restrict complex_data, int stages) {
+  int m = 0;
+  int mr = 0;
+  int l = 0;
+  int n = 1 << stages;
+  int nn = n - 1;
+
+  // Decimation in time. Swap the elements with bit-reversed indexes, a
+  // complex element is moved as one 32 bit word.
+  int32_t* complex_data_ptr = (int32_t*)complex_data;
+  for (m = 1; m <= nn; ++m) {
+    l = n;
+    do {
+      l >>= 1;
+    } while (l > nn - mr);
+    mr = (mr & (l - 1)) + l;
+
+    if (mr > m) {
+      int32_t tmp = complex_data_ptr[m];
+      complex_data_ptr[m] = complex_data_ptr[mr];
+      complex_data_ptr[mr] = tmp;
+    }
+  }
+}
@@ -0,0 +1,100 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * This file contains the functions WebRtcSpl_ComplexFFTC() and
+ * WebRtcSpl_ComplexIFFTC(), in the high accuracy mode of the upstream code.
+ * The description header can be found in signal_processing_library.h
+ *
+ */
+
+#include "signal_processing/signal_processing_library.h"
+#include "complex_fft_internal.h"
+#include "complex_fft_tables.h"
+
+#define CFFTSFT 14
+#define CFFTRND 1
+
+void WebRtcSpl_ComplexFFTStageC(int16_t* frfi, size_t n, size_t l, int k,
+                                int inverse, int shift) {
+  size_t i, j, m;
+  size_t istep = l << 1;
+  int16_t wr, wi;
+  int32_t tr32, ti32, qr32, qi32;
+  int32_t round2 = (int32_t)1 << (CFFTSFT - 1 + shift);
+
+  for (m = 0; m < l; ++m) {
+    j = m << k;
+    wr = kSinTable1024[j + 256];
+    wi = inverse ? kSinTable1024[j] : -kSinTable1024[j];
+
+    for (i = m; i < n; i += istep) {
+      j = i + l;
+
+      tr32 = wr * frfi[2 * j] - wi * frfi[2 * j + 1] + CFFTRND;
+      ti32 = wr * frfi[2 * j + 1] + wi * frfi[2 * j] + CFFTRND;
+      tr32 >>= 15 - CFFTSFT;
+      ti32 >>= 15 - CFFTSFT;
+
+      qr32 = ((int32_t)frfi[2 * i]) * (1 << CFFTSFT);
+      qi32 = ((int32_t)frfi[2 * i + 1]) * (1 << CFFTSFT);
+
+      frfi[2 * j] = (int16_t)((qr32 - tr32 + round2) >> (shift + CFFTSFT));
+      frfi[2 * j + 1] = (int16_t)((qi32 - ti32 + round2) >> (shift + CFFTSFT));
+      frfi[2 * i] = (int16_t)((qr32 + tr32 + round2) >> (shift + CFFTSFT));
+      frfi[2 * i + 1] = (int16_t)((qi32 + ti32 + round2) >> (shift + CFFTSFT));
+    }
+  }
+}
+
+int WebRtcSpl_ComplexFFTC(int16_t frfi[], int stages) {
+  size_t n = ((size_t)1) << stages;
+  size_t l = 1;
+  int k = 10 - 1;
+
+  if (n > 1024)
+    return -1;
+
+  while (l < n) {
+    // every stage is scaled down by 2
+    WebRtcSpl_ComplexFFTStageC(frfi, n, l, k, 0, 1);
+    --k;
+    l <<= 1;
+  }
+  return 0;
+}
+
+int WebRtcSpl_ComplexIFFTC(int16_t frfi[], int stages) {
+  size_t n = ((size_t)1) << stages;
+  size_t l = 1;
+  int k = 10 - 1;
+  int scale = 0;
+
+  if (n > 1024)
+    return -1;
+
+  while (l < n) {
+    // variable scaling, depending upon data
+    int shift = 0;
+    int32_t tmp32 = WebRtcSpl_MaxAbsValueW16C(frfi, 2 * n);
+    if (tmp32 > 13573) {
+      shift++;
+    }
+    if (tmp32 > 27146) {
+      shift++;
+    }
+    scale += shift;
+    WebRtcSpl_ComplexFFTStageC(frfi, n, l, k, 1, shift);
+    --k;
+    l <<= 1;
+  }
+  return scale;
+}
@@ -0,0 +1,30 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * This header file contains the radix-2 stage shared by the C and the SIMD
+ * complex FFTs.
+ *
+ */
+
+#ifndef WEBRTC_SPL_COMPLEX_FFT_INTERNAL_H_
+#define WEBRTC_SPL_COMPLEX_FFT_INTERNAL_H_
+
+#include "typedefs.h"
+
+// One radix-2 stage of an |n| point FFT with butterfly span |l|, twiddles are
+// kSinTable1024 entries (m << |k|). |inverse| selects the sign of the
+// imaginary twiddles, the outputs are scaled down by 2^|shift|. The SIMD
+// versions run the stages with spans shorter than their vectors through it.
+void WebRtcSpl_ComplexFFTStageC(int16_t* frfi, size_t n, size_t l, int k,
+                                int inverse, int shift);
+
+#endif // WEBRTC_SPL_COMPLEX_FFT_INTERNAL_H_
@@ -10,16 +10,16 @@
 
 
 /*
- * This file contains the function WebRtcSpl_GetScalingSquare().
+ * This file contains the function WebRtcSpl_GetScalingSquareC().
  * The description header can be found in signal_processing_library.h
  *
  */
 
 #include "signal_processing/signal_processing_library.h"
 
-int16_t WebRtcSpl_GetScalingSquare(int16_t* in_vector,
-                                   size_t in_vector_length,
-                                   size_t times)
+int16_t WebRtcSpl_GetScalingSquareC(int16_t* in_vector,
+                                    size_t in_vector_length,
+                                    size_t times)
 {
     int16_t nbits = WebRtcSpl_GetSizeInBits((uint32_t)times);
     size_t i;
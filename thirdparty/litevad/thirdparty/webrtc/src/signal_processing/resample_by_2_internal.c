@@ -28,8 +28,8 @@ static const int16_t kResampleAllpass[2][3] = {
 // output: int16_t (saturated) (of length len/2)
 // state:  filter state array; length = 8
 
-void WebRtcSpl_DownBy2IntToShort(int32_t *in, int32_t len, int16_t *out,
-                                 int32_t *state)
+void WebRtcSpl_DownBy2IntToShortC(int32_t *in, int32_t len, int16_t *out,
+                                  int32_t *state)
 {
     int32_t tmp0, tmp1, diff;
     int32_t i;
@@ -121,7 +121,7 @@ void WebRtcSpl_DownBy2IntToShort(int32_t *in, int32_t len, int16_t *out,
 // output: int32_t (shifted 15 positions to the left, + offset 16384) (of length len/2)
 // state:  filter state array; length = 8
 
-void WebRtcSpl_DownBy2ShortToInt(const int16_t *in,
+void WebRtcSpl_DownBy2ShortToIntC(const int16_t *in,
                                   int32_t len,
                                   int32_t *out,
                                   int32_t *state)
@@ -549,8 +549,8 @@ void WebRtcSpl_LPBy2ShortToInt(const int16_t* in, int32_t len, int32_t* out,
 // input:  int32_t (shifted 15 positions to the left, + offset 16384)
 // output: int32_t (normalized, not saturated)
 // state:  filter state array; length = 8
-void WebRtcSpl_LPBy2IntToInt(const int32_t* in, int32_t len, int32_t* out,
-                             int32_t* state)
+void WebRtcSpl_LPBy2IntToIntC(const int32_t* in, int32_t len, int32_t* out,
+                              int32_t* state)
 {
     int32_t tmp0, tmp1, diff;
     int32_t i;
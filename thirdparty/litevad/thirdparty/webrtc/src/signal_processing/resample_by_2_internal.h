@@ -23,11 +23,37 @@
  * resample_by_2_fast.c
  * Functions for internal use in the other resample functions
  ******************************************************************/
-void WebRtcSpl_DownBy2IntToShort(int32_t *in, int32_t len, int16_t *out,
-                                 int32_t *state);
 
-void WebRtcSpl_DownBy2ShortToInt(const int16_t *in, int32_t len,
-                                 int32_t *out, int32_t *state);
+// DownBy2IntToShort, DownBy2ShortToInt and LPBy2IntToInt (the 48 kHz -> 8 kHz
+// chain) are function pointers initialized by WebRtcSpl_Init(), the SIMD
+// versions run the independent allpass branches in vector lanes.
+typedef void (*DownBy2IntToShort)(int32_t *in, int32_t len, int16_t *out,
+                                  int32_t *state);
+extern DownBy2IntToShort WebRtcSpl_DownBy2IntToShort;
+void WebRtcSpl_DownBy2IntToShortC(int32_t *in, int32_t len, int16_t *out,
+                                  int32_t *state);
+#if defined(WEBRTC_USE_SSE2)
+void WebRtcSpl_DownBy2IntToShortSSE2(int32_t *in, int32_t len, int16_t *out,
+                                     int32_t *state);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+void WebRtcSpl_DownBy2IntToShortNeon(int32_t *in, int32_t len, int16_t *out,
+                                     int32_t *state);
+#endif
+
+typedef void (*DownBy2ShortToInt)(const int16_t *in, int32_t len,
+                                  int32_t *out, int32_t *state);
+extern DownBy2ShortToInt WebRtcSpl_DownBy2ShortToInt;
+void WebRtcSpl_DownBy2ShortToIntC(const int16_t *in, int32_t len,
+                                  int32_t *out, int32_t *state);
+#if defined(WEBRTC_USE_SSE2)
+void WebRtcSpl_DownBy2ShortToIntSSE2(const int16_t *in, int32_t len,
+                                     int32_t *out, int32_t *state);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+void WebRtcSpl_DownBy2ShortToIntNeon(const int16_t *in, int32_t len,
+                                     int32_t *out, int32_t *state);
+#endif
 
 void WebRtcSpl_UpBy2ShortToInt(const int16_t *in, int32_t len,
                                int32_t *out, int32_t *state);
@@ -41,7 +67,18 @@ void WebRtcSpl_UpBy2IntToShort(const int32_t *in, int32_t len,
 void WebRtcSpl_LPBy2ShortToInt(const int16_t* in, int32_t len,
                                int32_t* out, int32_t* state);
 
-void WebRtcSpl_LPBy2IntToInt(const int32_t* in, int32_t len, int32_t* out,
-                             int32_t* state);
+typedef void (*LPBy2IntToInt)(const int32_t* in, int32_t len, int32_t* out,
+                              int32_t* state);
+extern LPBy2IntToInt WebRtcSpl_LPBy2IntToInt;
+void WebRtcSpl_LPBy2IntToIntC(const int32_t* in, int32_t len, int32_t* out,
+                              int32_t* state);
+#if defined(WEBRTC_USE_SSE2)
+void WebRtcSpl_LPBy2IntToIntSSE2(const int32_t* in, int32_t len, int32_t* out,
+                                 int32_t* state);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+void WebRtcSpl_LPBy2IntToIntNeon(const int32_t* in, int32_t len, int32_t* out,
+                                 int32_t* state);
+#endif
 
 #endif // WEBRTC_SPL_RESAMPLE_BY_2_INTERNAL_H_
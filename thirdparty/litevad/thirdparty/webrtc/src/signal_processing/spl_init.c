@@ -0,0 +1,122 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/* The global function contained in this file initializes SPL function
+ * pointers, currently only for the energy and the allpass resampling
+ * functions on the VAD path, and the FFTs of the noise suppressor.
+ */
+
+#include "signal_processing/signal_processing_library.h"
+#include "resample_by_2_internal.h"
+
+#include <pthread.h>
+
+#if defined(WEBRTC_DETECT_NEON) && !defined(WEBRTC_HAS_NEON)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+
+/* Declare function pointers, initialized to the generic C versions. */
+GetScalingSquare WebRtcSpl_GetScalingSquare = WebRtcSpl_GetScalingSquareC;
+Energy WebRtcSpl_Energy = WebRtcSpl_EnergyC;
+DownBy2IntToShort WebRtcSpl_DownBy2IntToShort = WebRtcSpl_DownBy2IntToShortC;
+DownBy2ShortToInt WebRtcSpl_DownBy2ShortToInt = WebRtcSpl_DownBy2ShortToIntC;
+LPBy2IntToInt WebRtcSpl_LPBy2IntToInt = WebRtcSpl_LPBy2IntToIntC;
+MaxAbsValueW16 WebRtcSpl_MaxAbsValueW16 = WebRtcSpl_MaxAbsValueW16C;
+ComplexFFT WebRtcSpl_ComplexFFT = WebRtcSpl_ComplexFFTC;
+ComplexIFFT WebRtcSpl_ComplexIFFT = WebRtcSpl_ComplexIFFTC;
+
+/* Initialize function pointers to the generic C version. */
+static void InitPointersToC(void) {
+  WebRtcSpl_GetScalingSquare = WebRtcSpl_GetScalingSquareC;
+  WebRtcSpl_Energy = WebRtcSpl_EnergyC;
+  WebRtcSpl_DownBy2IntToShort = WebRtcSpl_DownBy2IntToShortC;
+  WebRtcSpl_DownBy2ShortToInt = WebRtcSpl_DownBy2ShortToIntC;
+  WebRtcSpl_LPBy2IntToInt = WebRtcSpl_LPBy2IntToIntC;
+  WebRtcSpl_MaxAbsValueW16 = WebRtcSpl_MaxAbsValueW16C;
+  WebRtcSpl_ComplexFFT = WebRtcSpl_ComplexFFTC;
+  WebRtcSpl_ComplexIFFT = WebRtcSpl_ComplexIFFTC;
+}
+
+#if defined(WEBRTC_USE_SSE2)
+/* Initialize function pointers to the SSE2 version. */
+static void InitPointersToSSE2(void) {
+  WebRtcSpl_GetScalingSquare = WebRtcSpl_GetScalingSquareSSE2;
+  WebRtcSpl_Energy = WebRtcSpl_EnergySSE2;
+  WebRtcSpl_DownBy2IntToShort = WebRtcSpl_DownBy2IntToShortSSE2;
+  WebRtcSpl_DownBy2ShortToInt = WebRtcSpl_DownBy2ShortToIntSSE2;
+  WebRtcSpl_LPBy2IntToInt = WebRtcSpl_LPBy2IntToIntSSE2;
+  WebRtcSpl_MaxAbsValueW16 = WebRtcSpl_MaxAbsValueW16SSE2;
+  WebRtcSpl_ComplexFFT = WebRtcSpl_ComplexFFTSSE2;
+  WebRtcSpl_ComplexIFFT = WebRtcSpl_ComplexIFFTSSE2;
+}
+#endif
+
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+/* Initialize function pointers to the Neon version. */
+static void InitPointersToNeon(void) {
+  WebRtcSpl_GetScalingSquare = WebRtcSpl_GetScalingSquareNeon;
+  WebRtcSpl_Energy = WebRtcSpl_EnergyNeon;
+  WebRtcSpl_DownBy2IntToShort = WebRtcSpl_DownBy2IntToShortNeon;
+  WebRtcSpl_DownBy2ShortToInt = WebRtcSpl_DownBy2ShortToIntNeon;
+  WebRtcSpl_LPBy2IntToInt = WebRtcSpl_LPBy2IntToIntNeon;
+  WebRtcSpl_MaxAbsValueW16 = WebRtcSpl_MaxAbsValueW16Neon;
+  WebRtcSpl_ComplexFFT = WebRtcSpl_ComplexFFTNeon;
+  WebRtcSpl_ComplexIFFT = WebRtcSpl_ComplexIFFTNeon;
+}
+#endif
+
+int WebRtcSpl_GetCpuFeatures(void) {
+  int features = 0;
+#if defined(WEBRTC_USE_SSE2)
+  // SSE2 is part of the target instruction set, nothing to detect.
+  features |= WEBRTC_SPL_CPU_SSE2;
+#endif
+#if defined(WEBRTC_HAS_NEON)
+  features |= WEBRTC_SPL_CPU_NEON;
+#elif defined(WEBRTC_DETECT_NEON)
+  if ((getauxval(AT_HWCAP) & HWCAP_NEON) != 0) {
+    features |= WEBRTC_SPL_CPU_NEON;
+  }
+#endif
+  return features;
+}
+
+static void InitPointers(int cpu_features) {
+  InitPointersToC();
+#if defined(WEBRTC_USE_SSE2)
+  if ((cpu_features & WEBRTC_SPL_CPU_SSE2) != 0) {
+    InitPointersToSSE2();
+  }
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+  if ((cpu_features & WEBRTC_SPL_CPU_NEON) != 0) {
+    InitPointersToNeon();
+  }
+#endif
+}
+
+static void InitFunctionPointers(void) {
+  InitPointers(WebRtcSpl_GetCpuFeatures());
+}
+
+void WebRtcSpl_Init(void) {
+  static pthread_once_t lock = PTHREAD_ONCE_INIT;
+  pthread_once(&lock, InitFunctionPointers);
+}
+
+void WebRtcSpl_InitWithCpuFeatures(int cpu_features) {
+  // Run the one-time initialization first, so that a later WebRtcSpl_Init()
+  // doesn't override the selection.
+  WebRtcSpl_Init();
+  InitPointers(cpu_features & WebRtcSpl_GetCpuFeatures());
+}
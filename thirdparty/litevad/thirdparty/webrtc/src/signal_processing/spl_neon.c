@@ -0,0 +1,357 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * This file contains Neon versions of the energy, the allpass resampling,
+ * the max abs value and the complex FFT functions. They are bit-exact with the
+ * C versions in energy.c, get_scaling_square.c, resample_by_2_internal.c,
+ * min_max_operations.c and complex_fft.c.
+ */
+
+#include "signal_processing/signal_processing_library.h"
+#include "resample_by_2_internal.h"
+
+#if defined(WEBRTC_HAS_NEON)
+
+#include <arm_neon.h>
+
+#include "complex_fft_internal.h"
+#include "complex_fft_tables.h"
+
+// allpass filter coefficients, same as in resample_by_2_internal.c.
+static const int16_t kResampleAllpass[2][3] = {
+        {821, 6110, 12382},
+        {3050, 9368, 15063}
+};
+
+int16_t WebRtcSpl_GetScalingSquareNeon(int16_t* in_vector,
+                                       size_t in_vector_length,
+                                       size_t times) {
+  int16_t nbits = WebRtcSpl_GetSizeInBits((uint32_t)times);
+  int16x8_t vmax = vdupq_n_s16(-1);
+  int16x4_t vmax4;
+  int16_t smax, sabs, t;
+  size_t i = 0;
+
+  for (; i + 8 <= in_vector_length; i += 8) {
+    // vabsq_s16() wraps like the C version: -32768 stays negative and never
+    // wins.
+    vmax = vmaxq_s16(vmax, vabsq_s16(vld1q_s16(&in_vector[i])));
+  }
+  vmax4 = vmax_s16(vget_low_s16(vmax), vget_high_s16(vmax));
+  vmax4 = vpmax_s16(vmax4, vmax4);
+  vmax4 = vpmax_s16(vmax4, vmax4);
+  smax = vget_lane_s16(vmax4, 0);
+  for (; i < in_vector_length; i++) {
+    sabs = (in_vector[i] > 0 ? in_vector[i] : -in_vector[i]);
+    smax = (sabs > smax ? sabs : smax);
+  }
+  t = WebRtcSpl_NormW32(WEBRTC_SPL_MUL(smax, smax));
+
+  if (smax == 0) {
+    return 0;  // Since norm(0) returns 0
+  } else {
+    return (t > nbits) ? 0 : nbits - t;
+  }
+}
+
+int32_t WebRtcSpl_EnergyNeon(int16_t* vector,
+                             size_t vector_length,
+                             int* scale_factor) {
+  int scaling =
+      WebRtcSpl_GetScalingSquareNeon(vector, vector_length, vector_length);
+  const int32x4_t shift = vdupq_n_s32(-scaling);
+  int32x4_t sum = vdupq_n_s32(0);
+  int32x2_t sum2;
+  int32_t en;
+  size_t i = 0;
+
+  // Each square is shifted before it is added, as in the C version. The sum
+  // wraps the same way, it doesn't depend on the order of the additions.
+  for (; i + 8 <= vector_length; i += 8) {
+    int16x8_t v = vld1q_s16(&vector[i]);
+    int32x4_t sq0 = vmull_s16(vget_low_s16(v), vget_low_s16(v));
+    int32x4_t sq1 = vmull_s16(vget_high_s16(v), vget_high_s16(v));
+    sum = vaddq_s32(sum, vshlq_s32(sq0, shift));
+    sum = vaddq_s32(sum, vshlq_s32(sq1, shift));
+  }
+  sum2 = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+  sum2 = vpadd_s32(sum2, sum2);
+  en = vget_lane_s32(sum2, 0);
+  for (; i < vector_length; i++) {
+    en += (vector[i] * vector[i]) >> scaling;
+  }
+  *scale_factor = scaling;
+
+  return en;
+}
+
+// Runs |tmp0| through the three allpass sections of both lanes, |state| holds
+// state[0..3] of the C version for each lane. Returns the new state[3].
+static __inline int32x2_t AllpassSections(int32x2_t tmp0, int32x2_t state[4],
+                                          const int32x2_t coef[3]) {
+  int32x2_t diff, tmp1;
+
+  diff = vsub_s32(tmp0, state[1]);
+  // scale down and round
+  diff = vshr_n_s32(vadd_s32(diff, vdup_n_s32(1 << 13)), 14);
+  tmp1 = vmla_s32(state[0], diff, coef[0]);
+  state[0] = tmp0;
+  diff = vsub_s32(tmp1, state[2]);
+  // scale down and truncate
+  diff = vsub_s32(vshr_n_s32(diff, 14), vshr_n_s32(diff, 31));
+  tmp0 = vmla_s32(state[1], diff, coef[1]);
+  state[1] = tmp1;
+  diff = vsub_s32(tmp0, state[3]);
+  // scale down and truncate
+  diff = vsub_s32(vshr_n_s32(diff, 14), vshr_n_s32(diff, 31));
+  state[3] = vmla_s32(state[2], diff, coef[2]);
+  state[2] = tmp0;
+  return state[3];
+}
+
+// Same as AllpassSections() for four lanes.
+static __inline int32x4_t AllpassSectionsQ(int32x4_t tmp0, int32x4x4_t* state,
+                                           const int32x4_t coef[3]) {
+  int32x4_t diff, tmp1;
+
+  diff = vsubq_s32(tmp0, state->val[1]);
+  // scale down and round
+  diff = vshrq_n_s32(vaddq_s32(diff, vdupq_n_s32(1 << 13)), 14);
+  tmp1 = vmlaq_s32(state->val[0], diff, coef[0]);
+  state->val[0] = tmp0;
+  diff = vsubq_s32(tmp1, state->val[2]);
+  // scale down and truncate
+  diff = vsubq_s32(vshrq_n_s32(diff, 14), vshrq_n_s32(diff, 31));
+  tmp0 = vmlaq_s32(state->val[1], diff, coef[1]);
+  state->val[1] = tmp1;
+  diff = vsubq_s32(tmp0, state->val[3]);
+  // scale down and truncate
+  diff = vsubq_s32(vshrq_n_s32(diff, 14), vshrq_n_s32(diff, 31));
+  state->val[3] = vmlaq_s32(state->val[2], diff, coef[2]);
+  state->val[2] = tmp0;
+  return state->val[3];
+}
+
+// Lower allpass filter in lane 0, upper allpass filter in lane 1.
+static __inline void LoadStates(const int32_t* state, int32x2_t s[4],
+                                int32x2_t coef[3]) {
+  int k;
+  for (k = 0; k < 4; k++) {
+    s[k] = vset_lane_s32(state[4 + k], vdup_n_s32(state[k]), 1);
+  }
+  for (k = 0; k < 3; k++) {
+    coef[k] = vset_lane_s32(kResampleAllpass[0][k],
+                            vdup_n_s32(kResampleAllpass[1][k]), 1);
+  }
+}
+
+static __inline void StoreStates(const int32x2_t s[4], int32_t* state) {
+  int k;
+  for (k = 0; k < 4; k++) {
+    state[k] = vget_lane_s32(s[k], 0);
+    state[4 + k] = vget_lane_s32(s[k], 1);
+  }
+}
+
+void WebRtcSpl_DownBy2IntToShortNeon(int32_t *in, int32_t len, int16_t *out,
+                                     int32_t *state) {
+  int32x2_t s[4], coef[3];
+  int32_t i;
+
+  len >>= 1;
+  LoadStates(state, s, coef);
+  for (i = 0; i < len; i++) {
+    int32x2_t half = AllpassSections(vld1_s32(&in[i << 1]), s, coef);
+
+    // divide by two and store temporarily
+    half = vshr_n_s32(half, 1);
+    vst1_s32(&in[i << 1], half);
+
+    // divide by two, add both allpass outputs and round
+    out[i] = WebRtcSpl_SatW32ToW16(
+        (vget_lane_s32(half, 0) + vget_lane_s32(half, 1)) >> 15);
+  }
+  StoreStates(s, state);
+}
+
+void WebRtcSpl_DownBy2ShortToIntNeon(const int16_t *in, int32_t len,
+                                     int32_t *out, int32_t *state) {
+  const int32x2_t offset = vdup_n_s32(1 << 14);
+  int32x2_t s[4], coef[3];
+  int32_t i;
+
+  len >>= 1;
+  LoadStates(state, s, coef);
+  for (i = 0; i < len; i++) {
+    int32x2_t tmp0 = vset_lane_s32(in[(i << 1) + 1], vdup_n_s32(in[i << 1]), 1);
+    int32x2_t half;
+    tmp0 = vadd_s32(vshl_n_s32(tmp0, 15), offset);
+    half = vshr_n_s32(AllpassSections(tmp0, s, coef), 1);
+
+    // divide by two and add both allpass outputs
+    out[i] = vget_lane_s32(vpadd_s32(half, half), 0);
+  }
+  StoreStates(s, state);
+}
+
+void WebRtcSpl_LPBy2IntToIntNeon(const int32_t* in, int32_t len, int32_t* out,
+                                 int32_t* state) {
+  // Lane 0: lower allpass, odd input -> even output, state[0..3].
+  // Lane 1: upper allpass, even input -> even output, state[4..7].
+  // Lane 2: lower allpass, even input -> odd output, state[8..11].
+  // Lane 3: upper allpass, odd input -> odd output, state[12..15].
+  // vld4q_s32() puts state[4 * lane + k] in s.val[k].
+  int32x4x4_t s = vld4q_s32(state);
+  int32x4_t coef[3];
+  int32_t odd = state[12];  // initial state of polyphase delay element
+  int32_t i;
+  int k;
+
+  len >>= 1;
+  for (k = 0; k < 3; k++) {
+    const int32_t lanes[4] = {
+        kResampleAllpass[1][k], kResampleAllpass[0][k],
+        kResampleAllpass[1][k], kResampleAllpass[0][k]
+    };
+    coef[k] = vld1q_s32(lanes);
+  }
+  for (i = 0; i < len; i++) {
+    int32x4_t tmp0 = vdupq_n_s32(in[i << 1]);
+    int32x4_t half;
+    int32x2_t avg;
+    tmp0 = vsetq_lane_s32(odd, tmp0, 0);
+    odd = in[(i << 1) + 1];
+    tmp0 = vsetq_lane_s32(odd, tmp0, 3);
+    half = vshrq_n_s32(AllpassSectionsQ(tmp0, &s, coef), 1);
+
+    // average the two allpass outputs, scale down and store
+    avg = vpadd_s32(vget_low_s32(half), vget_high_s32(half));
+    vst1_s32(&out[i << 1], vshr_n_s32(avg, 15));
+  }
+  vst4q_s32(state, s);
+}
+
+int16_t WebRtcSpl_MaxAbsValueW16Neon(const int16_t* vector, size_t length) {
+  int16x8_t vmax = vdupq_n_s16(0);
+  int16x4_t vmax4;
+  int maximum, absolute;
+  size_t i = 0;
+
+  for (; i + 8 <= length; i += 8) {
+    // Saturating abs, abs(-32768) is 32767 like the guard of the C version.
+    vmax = vmaxq_s16(vmax, vqabsq_s16(vld1q_s16(&vector[i])));
+  }
+  vmax4 = vmax_s16(vget_low_s16(vmax), vget_high_s16(vmax));
+  vmax4 = vpmax_s16(vmax4, vmax4);
+  vmax4 = vpmax_s16(vmax4, vmax4);
+  maximum = vget_lane_s16(vmax4, 0);
+  for (; i < length; i++) {
+    absolute = vector[i] >= 0 ? vector[i] : -vector[i];
+    maximum = absolute > maximum ? absolute : maximum;
+  }
+  return (int16_t)(maximum > WEBRTC_SPL_WORD16_MAX ? WEBRTC_SPL_WORD16_MAX
+                                                    : maximum);
+}
+
+// WebRtcSpl_ComplexFFTStageC() four butterflies at a time, |l| >= 4. vld2
+// splits real and imaginary parts, the widening multiplies give the exact 32
+// bit products and vmovn truncates like the int16_t casts of the C version.
+static void ComplexFFTStageNeon(int16_t* frfi, size_t n, size_t l, int k,
+                                int inverse, int shift) {
+  const int32x4_t rnd = vdupq_n_s32(1);
+  const int32x4_t round2 = vdupq_n_s32(1 << (13 + shift));
+  const int32x4_t vshift = vdupq_n_s32(-(14 + shift));
+  size_t istep = l << 1;
+  size_t i, m;
+  int t;
+
+  for (m = 0; m < l; m += 4) {
+    int16_t w[8];
+    int16x4_t wr, wi;
+    for (t = 0; t < 4; t++) {
+      size_t j = (m + t) << k;
+      w[t] = kSinTable1024[j + 256];
+      w[4 + t] = inverse ? kSinTable1024[j] : -kSinTable1024[j];
+    }
+    wr = vld1_s16(&w[0]);
+    wi = vld1_s16(&w[4]);
+
+    for (i = m; i < n; i += istep) {
+      int16_t* pi = &frfi[2 * i];
+      int16_t* pj = &frfi[2 * (i + l)];
+      int16x4x2_t xi = vld2_s16(pi);
+      int16x4x2_t xj = vld2_s16(pj);
+      int16x4x2_t yi, yj;
+      int32x4_t tr = vmlsl_s16(vmull_s16(wr, xj.val[0]), wi, xj.val[1]);
+      int32x4_t ti = vmlal_s16(vmull_s16(wr, xj.val[1]), wi, xj.val[0]);
+      int32x4_t qr = vaddq_s32(vshll_n_s16(xi.val[0], 14), round2);
+      int32x4_t qi = vaddq_s32(vshll_n_s16(xi.val[1], 14), round2);
+      tr = vshrq_n_s32(vaddq_s32(tr, rnd), 1);
+      ti = vshrq_n_s32(vaddq_s32(ti, rnd), 1);
+      yi.val[0] = vmovn_s32(vshlq_s32(vaddq_s32(qr, tr), vshift));
+      yi.val[1] = vmovn_s32(vshlq_s32(vaddq_s32(qi, ti), vshift));
+      yj.val[0] = vmovn_s32(vshlq_s32(vsubq_s32(qr, tr), vshift));
+      yj.val[1] = vmovn_s32(vshlq_s32(vsubq_s32(qi, ti), vshift));
+      vst2_s16(pi, yi);
+      vst2_s16(pj, yj);
+    }
+  }
+}
+
+int WebRtcSpl_ComplexFFTNeon(int16_t frfi[], int stages) {
+  size_t n = ((size_t)1) << stages;
+  size_t l = 1;
+  int k = 10 - 1;
+
+  if (n > 1024)
+    return -1;
+
+  while (l < n) {
+    if (l < 4)
+      WebRtcSpl_ComplexFFTStageC(frfi, n, l, k, 0, 1);
+    else
+      ComplexFFTStageNeon(frfi, n, l, k, 0, 1);
+    --k;
+    l <<= 1;
+  }
+  return 0;
+}
+
+int WebRtcSpl_ComplexIFFTNeon(int16_t frfi[], int stages) {
+  size_t n = ((size_t)1) << stages;
+  size_t l = 1;
+  int k = 10 - 1;
+  int scale = 0;
+
+  if (n > 1024)
+    return -1;
+
+  while (l < n) {
+    int shift = 0;
+    int32_t tmp32 = WebRtcSpl_MaxAbsValueW16Neon(frfi, 2 * n);
+    if (tmp32 > 13573) {
+      shift++;
+    }
+    if (tmp32 > 27146) {
+      shift++;
+    }
+    scale += shift;
+    if (l < 4)
+      WebRtcSpl_ComplexFFTStageC(frfi, n, l, k, 1, shift);
+    else
+      ComplexFFTStageNeon(frfi, n, l, k, 1, shift);
+    --k;
+    l <<= 1;
+  }
+  return scale;
+}
+
+#endif  // WEBRTC_HAS_NEON
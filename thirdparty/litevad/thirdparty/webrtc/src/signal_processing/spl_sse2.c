@@ -0,0 +1,369 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * This file contains SSE2 versions of the energy, the allpass resampling,
+ * the max abs value and the complex FFT functions. They are bit-exact with the
+ * C versions in energy.c, get_scaling_square.c, resample_by_2_internal.c,
+ * min_max_operations.c and complex_fft.c.
+ */
+
+#include "signal_processing/signal_processing_library.h"
+#include "resample_by_2_internal.h"
+
+#if defined(WEBRTC_USE_SSE2)
+
+#include <emmintrin.h>
+
+#include "complex_fft_internal.h"
+#include "complex_fft_tables.h"
+
+// allpass filter coefficients, same as in resample_by_2_internal.c.
+static const int16_t kResampleAllpass[2][3] = {
+        {821, 6110, 12382},
+        {3050, 9368, 15063}
+};
+
+int16_t WebRtcSpl_GetScalingSquareSSE2(int16_t* in_vector,
+                                       size_t in_vector_length,
+                                       size_t times) {
+  int16_t nbits = WebRtcSpl_GetSizeInBits((uint32_t)times);
+  __m128i vmax = _mm_set1_epi16(-1);
+  int16_t smax, sabs, t;
+  size_t i = 0;
+
+  for (; i + 8 <= in_vector_length; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)&in_vector[i]);
+    // Wrapping abs like the C version: -32768 stays negative and never wins.
+    v = _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+    vmax = _mm_max_epi16(vmax, v);
+  }
+  vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 8));
+  vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 4));
+  vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 2));
+  smax = (int16_t)_mm_cvtsi128_si32(vmax);
+  for (; i < in_vector_length; i++) {
+    sabs = (in_vector[i] > 0 ? in_vector[i] : -in_vector[i]);
+    smax = (sabs > smax ? sabs : smax);
+  }
+  t = WebRtcSpl_NormW32(WEBRTC_SPL_MUL(smax, smax));
+
+  if (smax == 0) {
+    return 0;  // Since norm(0) returns 0
+  } else {
+    return (t > nbits) ? 0 : nbits - t;
+  }
+}
+
+int32_t WebRtcSpl_EnergySSE2(int16_t* vector,
+                             size_t vector_length,
+                             int* scale_factor) {
+  int scaling =
+      WebRtcSpl_GetScalingSquareSSE2(vector, vector_length, vector_length);
+  __m128i shift = _mm_cvtsi32_si128(scaling);
+  __m128i sum = _mm_setzero_si128();
+  int32_t en;
+  size_t i = 0;
+
+  // Each square is shifted before it is added, as in the C version. The sum
+  // wraps the same way, it doesn't depend on the order of the additions.
+  for (; i + 8 <= vector_length; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)&vector[i]);
+    __m128i lo = _mm_mullo_epi16(v, v);
+    __m128i hi = _mm_mulhi_epi16(v, v);
+    __m128i sq0 = _mm_sra_epi32(_mm_unpacklo_epi16(lo, hi), shift);
+    __m128i sq1 = _mm_sra_epi32(_mm_unpackhi_epi16(lo, hi), shift);
+    sum = _mm_add_epi32(sum, _mm_add_epi32(sq0, sq1));
+  }
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+  en = _mm_cvtsi128_si32(sum);
+  for (; i < vector_length; i++) {
+    en += (vector[i] * vector[i]) >> scaling;
+  }
+  *scale_factor = scaling;
+
+  return en;
+}
+
+// Low 32 bits of |a| * |b| in lanes 0 and 2, lanes 1 and 3 are garbage.
+static __inline __m128i MulLanes02(__m128i a, __m128i b) {
+  return _mm_mul_epu32(a, b);
+}
+
+// Low 32 bits of |a| * |b| in all lanes.
+static __inline __m128i MulLanes0123(__m128i a, __m128i b) {
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// (diff >> 14), plus one if |diff| is negative.
+static __inline __m128i ScaleDownTruncate(__m128i diff) {
+  return _mm_sub_epi32(_mm_srai_epi32(diff, 14), _mm_srai_epi32(diff, 31));
+}
+
+// Runs |tmp0| through the three allpass sections of every lane, |state| holds
+// state[0..3] of the C version for each lane. The output is left in state[3].
+#define ALLPASS_SECTIONS(tmp0, state, coef, mul)                              \
+  do {                                                                        \
+    __m128i diff, tmp1;                                                       \
+    diff = _mm_sub_epi32(tmp0, state[1]);                                     \
+    /* scale down and round */                                                \
+    diff = _mm_srai_epi32(_mm_add_epi32(diff, _mm_set1_epi32(1 << 13)), 14);  \
+    tmp1 = _mm_add_epi32(state[0], mul(diff, coef[0]));                       \
+    state[0] = tmp0;                                                          \
+    diff = ScaleDownTruncate(_mm_sub_epi32(tmp1, state[2]));                  \
+    tmp0 = _mm_add_epi32(state[1], mul(diff, coef[1]));                       \
+    state[1] = tmp1;                                                          \
+    diff = ScaleDownTruncate(_mm_sub_epi32(tmp0, state[3]));                  \
+    state[3] = _mm_add_epi32(state[2], mul(diff, coef[2]));                   \
+    state[2] = tmp0;                                                          \
+  } while (0)
+
+// Lower allpass filter in lane 0, upper allpass filter in lane 2.
+static __inline void LoadStates02(const int32_t* state, __m128i s[4],
+                                  __m128i coef[3]) {
+  int k;
+  for (k = 0; k < 4; k++) {
+    s[k] = _mm_set_epi32(0, state[4 + k], 0, state[k]);
+  }
+  for (k = 0; k < 3; k++) {
+    coef[k] = _mm_set_epi32(0, kResampleAllpass[0][k], 0,
+                            kResampleAllpass[1][k]);
+  }
+}
+
+static __inline void StoreStates02(const __m128i s[4], int32_t* state) {
+  int k;
+  for (k = 0; k < 4; k++) {
+    state[k] = _mm_cvtsi128_si32(s[k]);
+    state[4 + k] = _mm_cvtsi128_si32(_mm_srli_si128(s[k], 8));
+  }
+}
+
+void WebRtcSpl_DownBy2IntToShortSSE2(int32_t *in, int32_t len, int16_t *out,
+                                     int32_t *state) {
+  __m128i s[4], coef[3];
+  int32_t i;
+
+  len >>= 1;
+  LoadStates02(state, s, coef);
+  for (i = 0; i < len; i++) {
+    __m128i tmp0 = _mm_set_epi32(0, in[(i << 1) + 1], 0, in[i << 1]);
+    __m128i half;
+    int32_t lower, upper;
+    ALLPASS_SECTIONS(tmp0, s, coef, MulLanes02);
+
+    // divide by two and store temporarily
+    half = _mm_srai_epi32(s[3], 1);
+    lower = _mm_cvtsi128_si32(half);
+    upper = _mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+    in[i << 1] = lower;
+    in[(i << 1) + 1] = upper;
+
+    // divide by two, add both allpass outputs and round
+    out[i] = WebRtcSpl_SatW32ToW16((lower + upper) >> 15);
+  }
+  StoreStates02(s, state);
+}
+
+void WebRtcSpl_DownBy2ShortToIntSSE2(const int16_t *in, int32_t len,
+                                     int32_t *out, int32_t *state) {
+  const __m128i offset = _mm_set_epi32(0, 1 << 14, 0, 1 << 14);
+  __m128i s[4], coef[3];
+  int32_t i;
+
+  len >>= 1;
+  LoadStates02(state, s, coef);
+  for (i = 0; i < len; i++) {
+    __m128i tmp0 = _mm_set_epi32(0, in[(i << 1) + 1], 0, in[i << 1]);
+    __m128i half;
+    tmp0 = _mm_add_epi32(_mm_slli_epi32(tmp0, 15), offset);
+    ALLPASS_SECTIONS(tmp0, s, coef, MulLanes02);
+
+    // divide by two and add both allpass outputs
+    half = _mm_srai_epi32(s[3], 1);
+    out[i] = _mm_cvtsi128_si32(half) +
+             _mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+  }
+  StoreStates02(s, state);
+}
+
+void WebRtcSpl_LPBy2IntToIntSSE2(const int32_t* in, int32_t len, int32_t* out,
+                                 int32_t* state) {
+  // Lane 0: lower allpass, odd input -> even output, state[0..3].
+  // Lane 1: upper allpass, even input -> even output, state[4..7].
+  // Lane 2: lower allpass, even input -> odd output, state[8..11].
+  // Lane 3: upper allpass, odd input -> odd output, state[12..15].
+  __m128i s[4], coef[3];
+  int32_t odd = state[12];  // initial state of polyphase delay element
+  int32_t i;
+  int k;
+
+  len >>= 1;
+  for (k = 0; k < 4; k++) {
+    s[k] = _mm_set_epi32(state[12 + k], state[8 + k], state[4 + k], state[k]);
+  }
+  for (k = 0; k < 3; k++) {
+    coef[k] = _mm_set_epi32(kResampleAllpass[0][k], kResampleAllpass[1][k],
+                            kResampleAllpass[0][k], kResampleAllpass[1][k]);
+  }
+  for (i = 0; i < len; i++) {
+    const int32_t even = in[i << 1];
+    __m128i tmp0 = _mm_set_epi32(in[(i << 1) + 1], even, even, odd);
+    __m128i half;
+    odd = in[(i << 1) + 1];
+    ALLPASS_SECTIONS(tmp0, s, coef, MulLanes0123);
+
+    // average the two allpass outputs, scale down and store
+    half = _mm_srai_epi32(s[3], 1);
+    half = _mm_srai_epi32(_mm_add_epi32(half, _mm_srli_si128(half, 4)), 15);
+    out[i << 1] = _mm_cvtsi128_si32(half);
+    out[(i << 1) + 1] = _mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+  }
+  for (k = 0; k < 4; k++) {
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, s[k]);
+    state[k] = lanes[0];
+    state[4 + k] = lanes[1];
+    state[8 + k] = lanes[2];
+    state[12 + k] = lanes[3];
+  }
+}
+
+int16_t WebRtcSpl_MaxAbsValueW16SSE2(const int16_t* vector, size_t length) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i vmax = zero;
+  int maximum, absolute;
+  size_t i = 0;
+
+  for (; i + 8 <= length; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)&vector[i]);
+    // Saturating negate, abs(-32768) is 32767 like the guard of the C version.
+    v = _mm_max_epi16(v, _mm_subs_epi16(zero, v));
+    vmax = _mm_max_epi16(vmax, v);
+  }
+  vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 8));
+  vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 4));
+  vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 2));
+  maximum = (int16_t)_mm_cvtsi128_si32(vmax);
+  for (; i < length; i++) {
+    absolute = vector[i] >= 0 ? vector[i] : -vector[i];
+    maximum = absolute > maximum ? absolute : maximum;
+  }
+  return (int16_t)(maximum > WEBRTC_SPL_WORD16_MAX ? WEBRTC_SPL_WORD16_MAX
+                                                    : maximum);
+}
+
+// WebRtcSpl_ComplexFFTStageC() four butterflies at a time, |l| >= 4. A complex
+// element is one 32 bit lane, _mm_madd_epi16() of (re, im) pairs against
+// (wr, -wi) and (wi, wr) gives the exact 32 bit products of the C version.
+static void ComplexFFTStageSSE2(int16_t* frfi, size_t n, size_t l, int k,
+                                int inverse, int shift) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i rnd = _mm_set1_epi32(1);
+  const __m128i round2 = _mm_set1_epi32(1 << (13 + shift));
+  const __m128i vshift = _mm_cvtsi32_si128(14 + shift);
+  size_t istep = l << 1;
+  size_t i, m;
+  int t;
+
+  for (m = 0; m < l; m += 4) {
+    int16_t w[16];
+    __m128i w1, w2;
+    for (t = 0; t < 4; t++) {
+      size_t j = (m + t) << k;
+      int16_t wr = kSinTable1024[j + 256];
+      int16_t wi = inverse ? kSinTable1024[j] : -kSinTable1024[j];
+      w[2 * t] = wr;
+      w[2 * t + 1] = -wi;
+      w[8 + 2 * t] = wi;
+      w[8 + 2 * t + 1] = wr;
+    }
+    w1 = _mm_loadu_si128((const __m128i*)&w[0]);
+    w2 = _mm_loadu_si128((const __m128i*)&w[8]);
+
+    for (i = m; i < n; i += istep) {
+      int16_t* pi = &frfi[2 * i];
+      int16_t* pj = &frfi[2 * (i + l)];
+      __m128i xi = _mm_loadu_si128((const __m128i*)pi);
+      __m128i xj = _mm_loadu_si128((const __m128i*)pj);
+      __m128i tr = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(xj, w1), rnd), 1);
+      __m128i ti = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(xj, w2), rnd), 1);
+      __m128i t_lo = _mm_unpacklo_epi32(tr, ti);
+      __m128i t_hi = _mm_unpackhi_epi32(tr, ti);
+      // frfi[i] << 14, sign extended to 32 bits
+      __m128i q_lo = _mm_add_epi32(
+          _mm_srai_epi32(_mm_unpacklo_epi16(zero, xi), 16 - 14), round2);
+      __m128i q_hi = _mm_add_epi32(
+          _mm_srai_epi32(_mm_unpackhi_epi16(zero, xi), 16 - 14), round2);
+      __m128i yi = _mm_packs_epi32(
+          _mm_sra_epi32(_mm_add_epi32(q_lo, t_lo), vshift),
+          _mm_sra_epi32(_mm_add_epi32(q_hi, t_hi), vshift));
+      __m128i yj = _mm_packs_epi32(
+          _mm_sra_epi32(_mm_sub_epi32(q_lo, t_lo), vshift),
+          _mm_sra_epi32(_mm_sub_epi32(q_hi, t_hi), vshift));
+      _mm_storeu_si128((__m128i*)pi, yi);
+      _mm_storeu_si128((__m128i*)pj, yj);
+    }
+  }
+}
+
+int WebRtcSpl_ComplexFFTSSE2(int16_t frfi[], int stages) {
+  size_t n = ((size_t)1) << stages;
+  size_t l = 1;
+  int k = 10 - 1;
+
+  if (n > 1024)
+    return -1;
+
+  while (l < n) {
+    if (l < 4)
+      WebRtcSpl_ComplexFFTStageC(frfi, n, l, k, 0, 1);
+    else
+      ComplexFFTStageSSE2(frfi, n, l, k, 0, 1);
+    --k;
+    l <<= 1;
+  }
+  return 0;
+}
+
+int WebRtcSpl_ComplexIFFTSSE2(int16_t frfi[], int stages) {
+  size_t n = ((size_t)1) << stages;
+  size_t l = 1;
+  int k = 10 - 1;
+  int scale = 0;
+
+  if (n > 1024)
+    return -1;
+
+  while (l < n) {
+    int shift = 0;
+    int32_t tmp32 = WebRtcSpl_MaxAbsValueW16SSE2(frfi, 2 * n);
+    if (tmp32 > 13573) {
+      shift++;
+    }
+    if (tmp32 > 27146) {
+      shift++;
+    }
+    scale += shift;
+    if (l < 4)
+      WebRtcSpl_ComplexFFTStageC(frfi, n, l, k, 1, shift);
+    else
+      ComplexFFTStageSSE2(frfi, n, l, k, 1, shift);
+    --k;
+    l <<= 1;
+  }
+  return scale;
+}
+
+#endif  // WEBRTC_USE_SSE2
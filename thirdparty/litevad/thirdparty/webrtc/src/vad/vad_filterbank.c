@@ -106,20 +106,11 @@ static void AllPassFilter(const int16_t* data_in, size_t data_length,
   *filter_state = (int16_t) (state32 >> 16);  // Q(-1)
 }
 
-// Splits |data_in| into |hp_data_out| and |lp_data_out| corresponding to
-// an upper (high pass) part and a lower (low pass) part respectively.
-//
-// - data_in      [i]   : Input audio data to be split into two frequency bands.
-// - data_length  [i]   : Length of |data_in|.
-// - upper_state  [i/o] : State of the upper filter, given in Q(-1).
-// - lower_state  [i/o] : State of the lower filter, given in Q(-1).
-// - hp_data_out  [o]   : Output audio data of the upper half of the spectrum.
-//                        The length is |data_length| / 2.
-// - lp_data_out  [o]   : Output audio data of the lower half of the spectrum.
-//                        The length is |data_length| / 2.
-static void SplitFilter(const int16_t* data_in, size_t data_length,
-                        int16_t* upper_state, int16_t* lower_state,
-                        int16_t* hp_data_out, int16_t* lp_data_out) {
+SplitFilter WebRtcVad_SplitFilter = WebRtcVad_SplitFilterC;
+
+void WebRtcVad_SplitFilterC(const int16_t* data_in, size_t data_length,
+                            int16_t* upper_state, int16_t* lower_state,
+                            int16_t* hp_data_out, int16_t* lp_data_out) {
   size_t i;
   size_t half_length = data_length >> 1;  // Downsampling by 2.
   int16_t tmp_out;
@@ -265,16 +256,19 @@ int16_t WebRtcVad_CalculateFeatures(VadInstT* self, const int16_t* data_in,
   assert(4 < kNumChannels - 1);  // Checking maximum |frequency_band|.
 
   // Split at 2000 Hz and downsample.
-  SplitFilter(in_ptr, data_length, &self->upper_state[frequency_band],
-              &self->lower_state[frequency_band], hp_out_ptr, lp_out_ptr);
+  WebRtcVad_SplitFilter(in_ptr, data_length,
+                        &self->upper_state[frequency_band],
+                        &self->lower_state[frequency_band], hp_out_ptr,
+                        lp_out_ptr);
 
   // For the upper band (2000 Hz - 4000 Hz) split at 3000 Hz and downsample.
   frequency_band = 1;
   in_ptr = hp_120;  // [2000 - 4000] Hz.
   hp_out_ptr = hp_60;  // [3000 - 4000] Hz.
   lp_out_ptr = lp_60;  // [2000 - 3000] Hz.
-  SplitFilter(in_ptr, length, &self->upper_state[frequency_band],
-              &self->lower_state[frequency_band], hp_out_ptr, lp_out_ptr);
+  WebRtcVad_SplitFilter(in_ptr, length, &self->upper_state[frequency_band],
+                        &self->lower_state[frequency_band], hp_out_ptr,
+                        lp_out_ptr);
 
   // Energy in 3000 Hz - 4000 Hz.
   length >>= 1;  // |data_length| / 4 <=> bandwidth = 1000 Hz.
@@ -290,8 +284,9 @@ int16_t WebRtcVad_CalculateFeatures(VadInstT* self, const int16_t* data_in,
   hp_out_ptr = hp_60;  // [1000 - 2000] Hz.
   lp_out_ptr = lp_60;  // [0 - 1000] Hz.
   length = half_data_length;  // |data_length| / 2 <=> bandwidth = 2000 Hz.
-  SplitFilter(in_ptr, length, &self->upper_state[frequency_band],
-              &self->lower_state[frequency_band], hp_out_ptr, lp_out_ptr);
+  WebRtcVad_SplitFilter(in_ptr, length, &self->upper_state[frequency_band],
+                        &self->lower_state[frequency_band], hp_out_ptr,
+                        lp_out_ptr);
 
   // Energy in 1000 Hz - 2000 Hz.
   length >>= 1;  // |data_length| / 4 <=> bandwidth = 1000 Hz.
@@ -302,8 +297,9 @@ int16_t WebRtcVad_CalculateFeatures(VadInstT* self, const int16_t* data_in,
   in_ptr = lp_60;  // [0 - 1000] Hz.
   hp_out_ptr = hp_120;  // [500 - 1000] Hz.
   lp_out_ptr = lp_120;  // [0 - 500] Hz.
-  SplitFilter(in_ptr, length, &self->upper_state[frequency_band],
-              &self->lower_state[frequency_band], hp_out_ptr, lp_out_ptr);
+  WebRtcVad_SplitFilter(in_ptr, length, &self->upper_state[frequency_band],
+                        &self->lower_state[frequency_band], hp_out_ptr,
+                        lp_out_ptr);
 
   // Energy in 500 Hz - 1000 Hz.
   length >>= 1;  // |data_length| / 8 <=> bandwidth = 500 Hz.
@@ -314,8 +310,9 @@ int16_t WebRtcVad_CalculateFeatures(VadInstT* self, const int16_t* data_in,
   in_ptr = lp_120;  // [0 - 500] Hz.
   hp_out_ptr = hp_60;  // [250 - 500] Hz.
   lp_out_ptr = lp_60;  // [0 - 250] Hz.
-  SplitFilter(in_ptr, length, &self->upper_state[frequency_band],
-              &self->lower_state[frequency_band], hp_out_ptr, lp_out_ptr);
+  WebRtcVad_SplitFilter(in_ptr, length, &self->upper_state[frequency_band],
+                        &self->lower_state[frequency_band], hp_out_ptr,
+                        lp_out_ptr);
 
   // Energy in 250 Hz - 500 Hz.
   length >>= 1;  // |data_length| / 16 <=> bandwidth = 250 Hz.
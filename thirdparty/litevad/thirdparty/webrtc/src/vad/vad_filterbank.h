@@ -41,4 +41,34 @@
 int16_t WebRtcVad_CalculateFeatures(VadInstT* self, const int16_t* data_in,
                                     size_t data_length, int16_t* features);
 
+// Splits |data_in| into |hp_data_out| and |lp_data_out| corresponding to
+// an upper (high pass) part and a lower (low pass) part respectively. Points to
+// the fastest version the CPU supports once a VAD instance has been created.
+//
+// - data_in      [i]   : Input audio data to be split into two frequency bands.
+// - data_length  [i]   : Length of |data_in|.
+// - upper_state  [i/o] : State of the upper filter, given in Q(-1).
+// - lower_state  [i/o] : State of the lower filter, given in Q(-1).
+// - hp_data_out  [o]   : Output audio data of the upper half of the spectrum.
+//                        The length is |data_length| / 2.
+// - lp_data_out  [o]   : Output audio data of the lower half of the spectrum.
+//                        The length is |data_length| / 2.
+typedef void (*SplitFilter)(const int16_t* data_in, size_t data_length,
+                            int16_t* upper_state, int16_t* lower_state,
+                            int16_t* hp_data_out, int16_t* lp_data_out);
+extern SplitFilter WebRtcVad_SplitFilter;
+void WebRtcVad_SplitFilterC(const int16_t* data_in, size_t data_length,
+                            int16_t* upper_state, int16_t* lower_state,
+                            int16_t* hp_data_out, int16_t* lp_data_out);
+#if defined(WEBRTC_USE_SSE2)
+void WebRtcVad_SplitFilterSSE2(const int16_t* data_in, size_t data_length,
+                               int16_t* upper_state, int16_t* lower_state,
+                               int16_t* hp_data_out, int16_t* lp_data_out);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+void WebRtcVad_SplitFilterNeon(const int16_t* data_in, size_t data_length,
+                               int16_t* upper_state, int16_t* lower_state,
+                               int16_t* hp_data_out, int16_t* lp_data_out);
+#endif
+
 #endif  // WEBRTC_COMMON_AUDIO_VAD_VAD_FILTERBANK_H_
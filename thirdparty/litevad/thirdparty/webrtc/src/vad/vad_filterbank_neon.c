@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "vad_filterbank.h"
+
+#if defined(WEBRTC_HAS_NEON)
+
+#include <arm_neon.h>
+
+// Allpass filter coefficients, upper and lower, in Q15. Same as in
+// vad_filterbank.c.
+static const int16_t kAllPassCoefsQ15[2] = { 20972, 5571 };
+
+// Sign extends data_in[0] to lane 0 and data_in[1] to lane 1.
+static __inline int32x2_t LoadPair(const int16_t* data_in) {
+  return vset_lane_s32(data_in[1], vdup_n_s32(data_in[0]), 1);
+}
+
+// Neon version of WebRtcVad_SplitFilterC(). The upper and lower allpass
+// filters are independent, they run in lane 0 and lane 1.
+//
+// Substituting the state update of AllPassFilter() into the next output gives
+//   tmp32[i] = (in[i - 1] << 15) + coef * in[i]
+//              - 2 * coef * (tmp32[i - 1] >> 16)
+// in 32 bit wrap-around arithmetic, same as the C version, which keeps the
+// recursion down to a shift and a multiply-subtract.
+void WebRtcVad_SplitFilterNeon(const int16_t* data_in, size_t data_length,
+                               int16_t* upper_state, int16_t* lower_state,
+                               int16_t* hp_data_out, int16_t* lp_data_out) {
+  const int32x2_t coefs = vset_lane_s32(kAllPassCoefsQ15[1],
+                                        vdup_n_s32(kAllPassCoefsQ15[0]), 1);
+  const int32x2_t coefs_x2 = vshl_n_s32(coefs, 1);
+  size_t i;
+  size_t half_length = data_length >> 1;  // Downsampling by 2.
+  int32x2_t in, prev_in, tmp32, tmp16, state32;
+
+  if (half_length == 0) {
+    return;
+  }
+
+  state32 = vset_lane_s32((int32_t) (*lower_state) << 16,
+                          vdup_n_s32((int32_t) (*upper_state) << 16), 1);  // Q15
+  in = LoadPair(data_in);
+  tmp32 = vmla_s32(state32, in, coefs);
+
+  for (i = 0;;) {
+    int16_t upper, lower;
+
+    // Make LP and HP signals.
+    tmp16 = vshr_n_s32(tmp32, 16);  // Q(-1)
+    upper = (int16_t) vget_lane_s32(tmp16, 0);
+    lower = (int16_t) vget_lane_s32(tmp16, 1);
+    hp_data_out[i] = (int16_t) (upper - lower);
+    lp_data_out[i] = (int16_t) (lower + upper);
+
+    if (++i == half_length) {
+      break;
+    }
+    prev_in = in;
+    in = LoadPair(&data_in[i << 1]);
+    tmp32 = vmls_s32(vmla_s32(vshl_n_s32(prev_in, 15), in, coefs),
+                     tmp16, coefs_x2);
+  }
+
+  state32 = vmls_s32(vshl_n_s32(in, 15), tmp16, coefs_x2);  // Q15
+  *upper_state = (int16_t) (vget_lane_s32(state32, 0) >> 16);  // Q(-1)
+  *lower_state = (int16_t) (vget_lane_s32(state32, 1) >> 16);
+}
+
+#endif  // WEBRTC_HAS_NEON
@@ -0,0 +1,88 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "vad_filterbank.h"
+
+#if defined(WEBRTC_USE_SSE2)
+
+#include <emmintrin.h>
+#include <string.h>
+
+// Allpass filter coefficients, upper and lower, in Q15. Same as in
+// vad_filterbank.c.
+static const int16_t kAllPassCoefsQ15[2] = { 20972, 5571 };
+
+// Sign extends data_in[0] to lane 0 and data_in[1] to lane 1.
+static __inline __m128i LoadPair(const int16_t* data_in) {
+  int32_t pair;
+  __m128i in;
+  memcpy(&pair, data_in, sizeof(pair));
+  in = _mm_cvtsi32_si128(pair);
+  return _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+}
+
+// SSE2 version of WebRtcVad_SplitFilterC(). The upper and lower allpass
+// filters are independent, they run in lane 0 and lane 1.
+//
+// Substituting the state update of AllPassFilter() into the next output gives
+//   tmp32[i] = (in[i - 1] << 15) + coef * in[i]
+//              - 2 * coef * (tmp32[i - 1] >> 16)
+// in 32 bit wrap-around arithmetic, same as the C version. Samples fit in 16
+// bits, so _mm_madd_epi16() gives coef * in[i] exactly, and against the
+// coefficient in the upper 16 bits of a lane it gives coef * (tmp32 >> 16)
+// without a shift. This keeps the recursion down to a multiply, a shift and a
+// subtraction.
+void WebRtcVad_SplitFilterSSE2(const int16_t* data_in, size_t data_length,
+                               int16_t* upper_state, int16_t* lower_state,
+                               int16_t* hp_data_out, int16_t* lp_data_out) {
+  const __m128i coefs = _mm_set_epi32(0, 0, kAllPassCoefsQ15[1],
+                                      kAllPassCoefsQ15[0]);
+  const __m128i coefs_high = _mm_slli_epi32(coefs, 16);
+  size_t i;
+  size_t half_length = data_length >> 1;  // Downsampling by 2.
+  __m128i in, prev_in, tmp32, tmp16, state32;
+
+  if (half_length == 0) {
+    return;
+  }
+
+  state32 = _mm_set_epi32(0, 0, (int32_t) (*lower_state) << 16,
+                          (int32_t) (*upper_state) << 16);  // Q15
+  in = LoadPair(data_in);
+  tmp32 = _mm_add_epi32(state32, _mm_madd_epi16(in, coefs));
+
+  for (i = 0;;) {
+    int16_t upper, lower;
+
+    // Make LP and HP signals.
+    tmp16 = _mm_srai_epi32(tmp32, 16);  // Q(-1)
+    upper = (int16_t) _mm_cvtsi128_si32(tmp16);
+    lower = (int16_t) _mm_cvtsi128_si32(_mm_srli_si128(tmp16, 4));
+    hp_data_out[i] = (int16_t) (upper - lower);
+    lp_data_out[i] = (int16_t) (lower + upper);
+
+    if (++i == half_length) {
+      break;
+    }
+    prev_in = in;
+    in = LoadPair(&data_in[i << 1]);
+    tmp32 = _mm_sub_epi32(
+        _mm_add_epi32(_mm_slli_epi32(prev_in, 15), _mm_madd_epi16(in, coefs)),
+        _mm_slli_epi32(_mm_madd_epi16(tmp32, coefs_high), 1));
+  }
+
+  state32 = _mm_sub_epi32(_mm_slli_epi32(in, 15),
+      _mm_slli_epi32(_mm_madd_epi16(tmp32, coefs_high), 1));  // Q15
+  *upper_state = (int16_t) (_mm_cvtsi128_si32(state32) >> 16);  // Q(-1)
+  *lower_state =
+      (int16_t) (_mm_cvtsi128_si32(_mm_srli_si128(state32, 4)) >> 16);
+}
+
+#endif  // WEBRTC_USE_SSE2
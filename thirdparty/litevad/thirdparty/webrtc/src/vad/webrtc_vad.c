@@ -13,8 +13,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <pthread.h>
+
 #include "signal_processing/signal_processing_library.h"
 #include "vad_core.h"
+#include "vad_filterbank.h"
 #include "typedefs.h"
 
 static const int kInitCheck = 42;
@@ -22,10 +25,40 @@ static const int kValidRates[] = { 8000, 16000, 32000, 48000 };
 static const size_t kRatesSize = sizeof(kValidRates) / sizeof(*kValidRates);
 static const int kMaxFrameLengthMs = 30;
 
+static void InitPointers(int cpu_features) {
+  WebRtcVad_SplitFilter = WebRtcVad_SplitFilterC;
+#if defined(WEBRTC_USE_SSE2)
+  if ((cpu_features & WEBRTC_SPL_CPU_SSE2) != 0) {
+    WebRtcVad_SplitFilter = WebRtcVad_SplitFilterSSE2;
+  }
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+  if ((cpu_features & WEBRTC_SPL_CPU_NEON) != 0) {
+    WebRtcVad_SplitFilter = WebRtcVad_SplitFilterNeon;
+  }
+#endif
+}
+
+static void InitFunctionPointers(void) {
+  WebRtcSpl_Init();
+  InitPointers(WebRtcSpl_GetCpuFeatures());
+}
+
+static void InitOnce(void) {
+  static pthread_once_t lock = PTHREAD_ONCE_INIT;
+  pthread_once(&lock, InitFunctionPointers);
+}
+
+void WebRtcVad_InitWithCpuFeatures(int cpu_features) {
+  InitOnce();
+  WebRtcSpl_InitWithCpuFeatures(cpu_features);
+  InitPointers(cpu_features & WebRtcSpl_GetCpuFeatures());
+}
+
 VadInst* WebRtcVad_Create() {
   VadInstT* self = (VadInstT*)malloc(sizeof(VadInstT));
 
-  //WebRtcSpl_Init();
+  InitOnce();
   self->init_flag = 0;
 
   return (VadInst*)self;
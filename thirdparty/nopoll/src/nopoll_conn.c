@@ -44,6 +44,16 @@
 //  3. Add sysutils support, because sysutils has osal layer, we don't need
 //     to care about platform dependent
 //  4. Add lwip support
+//  5. Vectorize frame masking (AVX2/SSE2/NEON, 64-bit word fallback), define
+//     'NOPOLL_DISABLE_SIMD' to use the word fallback only
+//  6. Add read-ahead receive buffer, binary payloads are delivered as views
+//     into it, see 'NOPOLL_READ_BUF_SIZE' and nopoll_conn_get_recv_stats
+//  7. Add send statistics, see nopoll_conn_get_send_stats
+//  8. Reuse parsed CA and resume TLS session with reused options (mbedtls),
+//     wait on the socket instead of fixed 10ms sleeps during client handshake
+//  9. Add permessage-deflate (RFC 7692) for text messages, see
+//     nopoll_conn_opts_set_permessage_deflate and nopoll_conn_get_deflate_stats
+// 10. Add nopoll_conn_recv_pending, bytes received but not delivered yet
 
 /**
  * \defgroup nopoll_conn noPoll Connection: functions required to create WebSocket client connections.
@@ -55,11 +65,36 @@
  */
 
 #include "nopoll_conn.h"
+#include "nopoll_deflate.h"
 #include "nopoll_private.h"
 
+#if !defined(NOPOLL_DISABLE_SIMD)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NOPOLL_MASK_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define NOPOLL_MASK_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define NOPOLL_MASK_NEON
+#endif
+#endif
+
 #define NOPOLL_DELIVER_PONG_FRAME
 #define NOPOLL_DELIVER_PAYLOAD_EMPTY_FRAME
 
+// Size of the per-connection read-ahead buffer, requests larger than
+// this are read directly into the caller buffer
+#if !defined(NOPOLL_READ_BUF_SIZE)
+#define NOPOLL_READ_BUF_SIZE 8192
+#endif
+
+// Text messages shorter than this are not worth compressing
+#if !defined(NOPOLL_DEFLATE_MIN_SIZE)
+#define NOPOLL_DEFLATE_MIN_SIZE 32
+#endif
+
 // mbedtls debug levels:
 //  - 0 No debug
 //  - 1 Error
@@ -391,6 +426,7 @@ char * __nopoll_conn_get_client_init (noPollConn * conn, noPollConnOpts * opts)
 	char key[50];
 	int  key_size = 50;
 	char nonce[17];
+	char extensions[128];
 
 	/* get the nonce */
 	if (! nopoll_nonce (nonce, 16)) {
@@ -410,6 +446,14 @@ char * __nopoll_conn_get_client_init (noPollConn * conn, noPollConnOpts * opts)
 	conn->handshake = nopoll_new (noPollHandShake, 1);
 	conn->handshake->expected_accept = nopoll_strdup (key);
 
+	/* permessage-deflate offer, the same window is requested for
+	 * both directions */
+	extensions[0] = 0;
+	conn->deflate_offer_bits = opts ? opts->deflate_window_bits : 0;
+	if (conn->deflate_offer_bits > 0)
+		sprintf (extensions, "\r\nSec-WebSocket-Extensions: permessage-deflate; client_max_window_bits=%d; server_max_window_bits=%d",
+			 conn->deflate_offer_bits, conn->deflate_offer_bits);
+
 	/* send initial handshake */
 	return nopoll_strdup_printf ("GET %s HTTP/1.1"
 				     "\r\nHost: %s"
@@ -420,6 +464,7 @@ char * __nopoll_conn_get_client_init (noPollConn * conn, noPollConnOpts * opts)
 				     "%s%s"
 				     "%s%s"  /* Cookie */
 				     "%s%s"  /* protocol part */
+				     "%s"    /* extensions */
 				     "%s"    /* extra arbitrary headers */
 				     "\r\n\r\n",
 				     conn->get_url,
@@ -437,6 +482,8 @@ char * __nopoll_conn_get_client_init (noPollConn * conn, noPollConnOpts * opts)
 				     /* protocol part */
 				     conn->protocols ? "\r\nSec-WebSocket-Protocol: " : "",
 				     conn->protocols ? conn->protocols : "",
+				     /* extensions */
+				     extensions,
 				     /* extra arbitrary headers */
 				     (opts && opts->extra_headers) ? opts->extra_headers : "");
 }
@@ -963,7 +1010,18 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 			}
 		}
 
-		if (options && options->ca_certificate) {
+		if (options && options->ca_certificate && options->reuse) {
+			/* reused options outlive the connection, parse the CA once for all of them */
+			nopoll_mutex_lock (options->mutex);
+			if (! options->ssl_ca_chain_parsed &&
+			    mbedtls_x509_crt_parse(&options->ssl_ca_chain, (const unsigned char *)options->ca_certificate, options->ca_certificate_size) == 0)
+				options->ssl_ca_chain_parsed = nopoll_true;
+			nopoll_mutex_unlock (options->mutex);
+			if (! options->ssl_ca_chain_parsed) {
+				nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "failed to parse ca_certificate\n");
+				goto fail_ssl_connection;
+			}
+		} else if (options && options->ca_certificate) {
 			if (mbedtls_x509_crt_parse(&conn->ssl_ca_cert, (const unsigned char *)options->ca_certificate, options->ca_certificate_size) != 0) {
 				nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "failed to parse ca_certificate\n");
 				goto fail_ssl_connection;
@@ -993,7 +1051,10 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 			mbedtls_ssl_conf_authmode(&conn->ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
 
 		mbedtls_ssl_conf_rng(&conn->ssl_conf, mbedtls_ctr_drbg_random, &conn->ssl_ctr_drbg);
-		mbedtls_ssl_conf_ca_chain(&conn->ssl_conf, &conn->ssl_ca_cert, NULL);
+		if (options && options->ssl_ca_chain_parsed)
+			mbedtls_ssl_conf_ca_chain(&conn->ssl_conf, &options->ssl_ca_chain, NULL);
+		else
+			mbedtls_ssl_conf_ca_chain(&conn->ssl_conf, &conn->ssl_ca_cert, NULL);
 
 		if (mbedtls_ssl_conf_own_cert(&conn->ssl_conf, &conn->ssl_cert, &conn->ssl_pkey) != 0) {
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_conf_own_cert failed\n");
@@ -1004,6 +1065,14 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_setup failed\n");
 			goto fail_ssl_connection;
 		}
+
+		/* offer the previous session, server falls back to a full handshake if it can't resume it */
+		if (options && options->reuse) {
+			nopoll_mutex_lock (options->mutex);
+			if (options->ssl_session_valid && mbedtls_ssl_set_session(&conn->ssl, &options->ssl_session) != 0)
+				nopoll_log (ctx, NOPOLL_LEVEL_WARNING, "mbedtls_ssl_set_session failed, doing full handshake\n");
+			nopoll_mutex_unlock (options->mutex);
+		}
 #if 0
 		if (mbedtls_ssl_set_hostname(&conn->ssl, conn->host_name ) != 0) {
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_set_hostname failed\n");
@@ -1072,8 +1141,17 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 				goto fail_ssl_connection;
 			} /* end if */
 
-			/* wait a bit before retry */
-			nopoll_sleep (10000);
+			/* wait a bit before retry, or less if the socket is
+			   already ready for the next handshake step */
+			FD_ZERO (&fdset);
+			FD_SET (session, &fdset);
+			tv.tv_sec  = 0;
+			tv.tv_usec = 10000;
+			if (select (session + 1,
+				    ssl_error == MBEDTLS_ERR_SSL_WANT_READ ? &fdset : NULL,
+				    ssl_error == MBEDTLS_ERR_SSL_WANT_WRITE ? &fdset : NULL,
+				    NULL, &tv) < 0)
+				nopoll_sleep (10000);
 
 		} /* end while */
 
@@ -1083,6 +1161,15 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_get_verify_result failed\n");
 			goto fail_ssl_connection;
 		}
+
+		/* keep the session (and ticket) for the next connection */
+		if (options && options->reuse) {
+			nopoll_mutex_lock (options->mutex);
+			mbedtls_ssl_session_free (&options->ssl_session);
+			mbedtls_ssl_session_init (&options->ssl_session);
+			options->ssl_session_valid = mbedtls_ssl_get_session(&conn->ssl, &options->ssl_session) == 0;
+			nopoll_mutex_unlock (options->mutex);
+		}
 #else
 		/* found TLS connection request, enable it */
 		conn->ssl_ctx  = __nopoll_conn_get_ssl_context (ctx, conn, options, nopoll_true);
@@ -1271,6 +1358,10 @@ fail_ssl_connection:
 	nopoll_conn_shutdown (conn);
 	nopoll_ctx_unregister_conn (ctx, conn);
 
+	/* don't offer again a session that may be the cause of the failure */
+	if (options && options->reuse)
+		nopoll_conn_opts_clear_ssl_session (options);
+
 	/* release connection options */
 	__nopoll_conn_opts_release_if_needed (options);
 
@@ -2309,6 +2400,9 @@ void nopoll_conn_unref (noPollConn * conn)
 	if (conn->pending_msg)
 		nopoll_msg_unref (conn->pending_msg);
 
+	/* release read-ahead buffer (views may still hold it) */
+	__nopoll_conn_buffer_unref (conn->read_buf);
+
 	/* release ctx */
 	if (conn->ctx) {
 		nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Released context refs, now: %d", conn->ctx->refs);
@@ -2364,6 +2458,7 @@ void nopoll_conn_unref (noPollConn * conn)
 		nopoll_free (conn->handshake->websocket_accept);
 		nopoll_free (conn->handshake->expected_accept);
 		nopoll_free (conn->handshake->cookie);
+		nopoll_free (conn->handshake->websocket_extensions);
 		nopoll_free (conn->handshake);
 	} /* end if */
 
@@ -2374,6 +2469,10 @@ void nopoll_conn_unref (noPollConn * conn)
 	/* release pending write buffer */
 	nopoll_free (conn->pending_write);
 
+	/* release permessage-deflate state */
+	__nopoll_deflate_free (conn->deflate);
+	nopoll_free (conn->inflate_buf);
+
 	/* release mutexes */
 	nopoll_mutex_destroy (conn->handshake_mutex);
 	nopoll_mutex_destroy (conn->ref_mutex);
@@ -2529,48 +2628,14 @@ void __nopoll_pack_content (char * buffer, int start, int bytes)
 }
 
 /**
- * @internal Function used to read bytes from the wire.
+ * @internal Issues a single read on the connection.
  *
  * @return The function returns the number of bytes read, 0 when no
  * bytes were available and -1 when it fails.
  */
-int         __nopoll_conn_receive  (noPollConn * conn, char  * buffer, int  maxlen)
+static int  __nopoll_conn_receive_wire (noPollConn * conn, char  * buffer, int  maxlen)
 {
 	int         nread;
-	int         bytes;
-
-	if (conn->pending_buf_bytes > 0) {
-		nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Calling with bytes we can reuse (%d), requested: %d",
-			    conn->pending_buf_bytes, maxlen);
-
-		if (conn->pending_buf_bytes >= maxlen) {
-			/* we have more in the buffer to serve than
-			 * requested, ok, copy into the buffer and
-			 * pack */
-
-			memcpy (buffer, conn->pending_buf, maxlen);
-			__nopoll_pack_content (conn->pending_buf, maxlen, conn->pending_buf_bytes - maxlen);
-			conn->pending_buf_bytes -= maxlen;
-			return maxlen;
-		}
-
-		/* ok, we don't have enough bytes to serve
-		 * directly, so copy what we have */
-		memcpy (buffer, conn->pending_buf, conn->pending_buf_bytes);
-
-		/* copy number of bytes served to reduce next request */
-		nread = conn->pending_buf_bytes;
-		conn->pending_buf_bytes = 0;
-
-		/* call again to get bytes reducing the request in the
-		 * amount of bytes served */
-		bytes = __nopoll_conn_receive (conn, buffer + nread, maxlen - nread);
-		if (bytes < 0) {
-			return -1;
-		}
-
-		return bytes + nread;
-	} /* end if */
 
  keep_reading:
 	/* clear buffer */
@@ -2580,6 +2645,7 @@ int         __nopoll_conn_receive  (noPollConn * conn, char  * buffer, int  maxl
 #else
 	errno = 0;
 #endif
+	conn->recv_reads++;
 	if ((nread = conn->receive (conn, buffer, maxlen)) < 0) {
 		/* nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, " returning errno=%d (%s)", errno, strerror (errno)); */
 		if (errno == NOPOLL_EAGAIN)
@@ -2617,6 +2683,158 @@ int         __nopoll_conn_receive  (noPollConn * conn, char  * buffer, int  maxl
 	return nread;
 }
 
+/**
+ * @internal Acquires a reference to the receive block provided.
+ */
+noPollBuffer * __nopoll_conn_buffer_ref (noPollBuffer * buffer)
+{
+	nopoll_mutex_lock (buffer->ref_mutex);
+	buffer->refs++;
+	nopoll_mutex_unlock (buffer->ref_mutex);
+	return buffer;
+}
+
+/**
+ * @internal Releases a reference to the receive block provided,
+ * freeing it when it was the last one.
+ */
+void           __nopoll_conn_buffer_unref (noPollBuffer * buffer)
+{
+	if (buffer == NULL)
+		return;
+
+	nopoll_mutex_lock (buffer->ref_mutex);
+	buffer->refs--;
+	if (buffer->refs != 0) {
+		nopoll_mutex_unlock (buffer->ref_mutex);
+		return;
+	}
+	nopoll_mutex_unlock (buffer->ref_mutex);
+	nopoll_mutex_destroy (buffer->ref_mutex);
+
+	nopoll_free (buffer->data);
+	nopoll_free (buffer);
+	return;
+}
+
+/**
+ * @internal Makes sure the connection owns an empty read-ahead block
+ * it can refill. A block still referenced by delivered messages is
+ * left to them and a new one is allocated.
+ */
+static nopoll_bool __nopoll_conn_prepare_read_buf (noPollConn * conn)
+{
+	noPollBuffer * buffer = conn->read_buf;
+	int            refs   = 0;
+
+	if (buffer) {
+		nopoll_mutex_lock (buffer->ref_mutex);
+		refs = buffer->refs;
+		nopoll_mutex_unlock (buffer->ref_mutex);
+		if (refs == 1)
+			return nopoll_true;
+
+		/* views still alive, hand the block over to them */
+		__nopoll_conn_buffer_unref (buffer);
+		conn->read_buf = NULL;
+	} /* end if */
+
+	buffer = nopoll_new (noPollBuffer, 1);
+	if (buffer == NULL)
+		return nopoll_false;
+	/* allow extra byte for the terminator written after reads */
+	buffer->data = nopoll_new (char, NOPOLL_READ_BUF_SIZE + 1);
+	if (buffer->data == NULL) {
+		nopoll_free (buffer);
+		return nopoll_false;
+	} /* end if */
+	buffer->size      = NOPOLL_READ_BUF_SIZE;
+	buffer->refs      = 1;
+	buffer->ref_mutex = nopoll_mutex_create ();
+
+	conn->read_buf     = buffer;
+	conn->read_buf_pos = 0;
+	conn->read_buf_len = 0;
+	return nopoll_true;
+}
+
+/**
+ * @internal Function used to read bytes from the wire.
+ *
+ * @return The function returns the number of bytes read, 0 when no
+ * bytes were available and -1 when it fails.
+ */
+int         __nopoll_conn_receive  (noPollConn * conn, char  * buffer, int  maxlen)
+{
+	int         nread;
+	int         bytes;
+
+	if (conn->pending_buf_bytes > 0) {
+		nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Calling with bytes we can reuse (%d), requested: %d",
+			    conn->pending_buf_bytes, maxlen);
+
+		if (conn->pending_buf_bytes >= maxlen) {
+			/* we have more in the buffer to serve than
+			 * requested, ok, copy into the buffer and
+			 * pack */
+
+			memcpy (buffer, conn->pending_buf, maxlen);
+			__nopoll_pack_content (conn->pending_buf, maxlen, conn->pending_buf_bytes - maxlen);
+			conn->pending_buf_bytes -= maxlen;
+			return maxlen;
+		}
+
+		/* ok, we don't have enough bytes to serve
+		 * directly, so copy what we have */
+		memcpy (buffer, conn->pending_buf, conn->pending_buf_bytes);
+
+		/* copy number of bytes served to reduce next request */
+		nread = conn->pending_buf_bytes;
+		conn->pending_buf_bytes = 0;
+
+		/* call again to get bytes reducing the request in the
+		 * amount of bytes served */
+		bytes = __nopoll_conn_receive (conn, buffer + nread, maxlen - nread);
+		if (bytes < 0) {
+			return -1;
+		}
+
+		return bytes + nread;
+	} /* end if */
+
+	/* serve from the read-ahead buffer */
+	nread = conn->read_buf_len - conn->read_buf_pos;
+	if (nread > 0) {
+		if (nread > maxlen)
+			nread = maxlen;
+		memcpy (buffer, conn->read_buf->data + conn->read_buf_pos, nread);
+		conn->read_buf_pos += nread;
+		if (nread == maxlen)
+			return maxlen;
+
+		/* get the rest from the wire */
+		bytes = __nopoll_conn_receive (conn, buffer + nread, maxlen - nread);
+		if (bytes < 0) {
+			return -1;
+		}
+
+		return bytes + nread;
+	} /* end if */
+
+	/* large reads (payloads) go straight to the caller buffer,
+	 * otherwise read ahead as much as available */
+	if (maxlen >= NOPOLL_READ_BUF_SIZE || ! __nopoll_conn_prepare_read_buf (conn))
+		return __nopoll_conn_receive_wire (conn, buffer, maxlen);
+
+	bytes = __nopoll_conn_receive_wire (conn, conn->read_buf->data, conn->read_buf->size);
+	if (bytes <= 0)
+		return bytes;
+	conn->read_buf_pos = 0;
+	conn->read_buf_len = bytes;
+
+	return __nopoll_conn_receive (conn, buffer, maxlen);
+}
+
 nopoll_bool nopoll_conn_get_http_url (noPollConn * conn, const char * buffer, int buffer_size, const char * method, char ** url)
 {
 	int          iterator;
@@ -2955,6 +3173,74 @@ nopoll_bool nopoll_conn_complete_handshake_check_listener (noPollCtx * ctx, noPo
 	return nopoll_true; /* signal handshake was completed */
 }
 
+/**
+ * @internal Parses the Sec-WebSocket-Extensions reply of the server
+ * and creates the permessage-deflate state if it was accepted.
+ *
+ * @return nopoll_false if the reply is not valid for what was offered.
+ */
+nopoll_bool __nopoll_conn_deflate_accept (noPollCtx * ctx, noPollConn * conn)
+{
+	char        * extensions = conn->handshake->websocket_extensions;
+	char        * param, * next, * value;
+	int           window_bits      = conn->deflate_offer_bits;
+	int           peer_window_bits = conn->deflate_offer_bits;
+	nopoll_bool   no_context_takeover      = nopoll_false;
+	nopoll_bool   peer_no_context_takeover = nopoll_false;
+	nopoll_bool   first = nopoll_true;
+
+	if (extensions == NULL)
+		return nopoll_true;
+	/* only a single extension is ever offered */
+	if (conn->deflate_offer_bits == 0 || strchr (extensions, ','))
+		return nopoll_false;
+
+	for (param = extensions; param != NULL; param = next) {
+		next = strchr (param, ';');
+		if (next)
+			*next++ = 0;
+		value = strchr (param, '=');
+		if (value) {
+			*value++ = 0;
+			nopoll_trim (value, NULL);
+			if (value[0] == '"' && strlen (value) > 1) {
+				value++;
+				value[strlen (value) - 1] = 0;
+			}
+		} /* end if */
+		nopoll_trim (param, NULL);
+
+		if (first) {
+			if (strcasecmp (param, "permessage-deflate") != 0 || value)
+				return nopoll_false;
+			first = nopoll_false;
+		} else if (strcasecmp (param, "server_no_context_takeover") == 0 && value == NULL) {
+			peer_no_context_takeover = nopoll_true;
+		} else if (strcasecmp (param, "client_no_context_takeover") == 0 && value == NULL) {
+			no_context_takeover = nopoll_true;
+		} else if (strcasecmp (param, "server_max_window_bits") == 0 && value) {
+			peer_window_bits = atoi (value);
+			if (peer_window_bits < 8 || peer_window_bits > conn->deflate_offer_bits)
+				return nopoll_false;
+		} else if (strcasecmp (param, "client_max_window_bits") == 0 && value) {
+			window_bits = atoi (value);
+			if (window_bits < 8 || window_bits > conn->deflate_offer_bits)
+				return nopoll_false;
+		} else {
+			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "Unsupported permessage-deflate parameter: %s", param);
+			return nopoll_false;
+		}
+	} /* end for */
+
+	conn->deflate = __nopoll_deflate_new (window_bits, no_context_takeover,
+					      peer_window_bits, peer_no_context_takeover);
+	if (conn->deflate == NULL)
+		return nopoll_false;
+	nopoll_log (ctx, NOPOLL_LEVEL_DEBUG, "permessage-deflate enabled on conn-id=%d (window bits %d/%d, no context takeover %d/%d)",
+		    conn->id, window_bits, peer_window_bits, no_context_takeover, peer_no_context_takeover);
+	return nopoll_true;
+}
+
 nopoll_bool nopoll_conn_complete_handshake_check_client (noPollCtx * ctx, noPollConn * conn)
 {
 	char         * accept;
@@ -2984,6 +3270,13 @@ nopoll_bool nopoll_conn_complete_handshake_check_client (noPollCtx * ctx, noPoll
 	nopoll_log (ctx, NOPOLL_LEVEL_DEBUG, "Sec-Websocket-Accept matches expected value..nopoll_conn_complete_handshake_check_client (%p, %p)=%d",
 		    ctx, conn, result);
 
+	/* check extensions accepted by the server */
+	if (result && ! __nopoll_conn_deflate_accept (ctx, conn)) {
+		nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "Server replied with unexpected Sec-WebSocket-Extensions, closing session");
+		nopoll_conn_shutdown (conn);
+		return nopoll_false;
+	} /* end if */
+
 	/* now call the user app level to accept the websocket
 	   connection */
 	if (! __nopoll_conn_call_on_ready_if_defined (ctx, conn))
@@ -3143,12 +3436,16 @@ int nopoll_conn_complete_handshake_client (noPollCtx * ctx, noPollConn * conn, c
 		return 0;
 	if (nopoll_conn_check_mime_header_repeated (conn, header, value, "Sec-WebSocket-Protocol", conn->accepted_protocol))
 		return 0;
+	if (nopoll_conn_check_mime_header_repeated (conn, header, value, "Sec-WebSocket-Extensions", conn->handshake->websocket_extensions))
+		return 0;
 
 	/* set the value if required */
 	if (strcasecmp (header, "Sec-Websocket-Accept") == 0)
 		conn->handshake->websocket_accept = value;
 	else if (strcasecmp (header, "Sec-Websocket-Protocol") == 0)
 		conn->accepted_protocol = value;
+	else if (strcasecmp (header, "Sec-Websocket-Extensions") == 0)
+		conn->handshake->websocket_extensions = value;
 	else if (strcasecmp (header, "Upgrade") == 0) {
 		conn->handshake->upgrade_websocket = 1;
 		nopoll_free (value);
@@ -3240,13 +3537,64 @@ void nopoll_conn_complete_handshake (noPollConn * conn)
 
 void nopoll_conn_mask_content (noPollCtx * ctx, char * payload, int payload_size, char * mask, int desp)
 {
-	int iter       = 0;
-	int mask_index = 0;
+	unsigned char    * data = (unsigned char *) payload;
+	unsigned char      key[32];
+	unsigned long long word;
+	unsigned long long value;
+	int                iter = 0;
+	int                index;
+
+	/* byte-wise until payload is aligned to 8 bytes (or finished) */
+	while (iter < payload_size && (((size_t) (data + iter)) & 7) != 0) {
+		data[iter] ^= mask[(iter + desp) % 4];
+		iter++;
+	} /* end while */
 
+	if (payload_size - iter < 8)
+		goto mask_tail;
+
+	/* mask rotated to current position, repeated to fill a vector,
+	 * the rotation doesn't change inside the block loop since every
+	 * block is a multiple of 4 bytes */
+	for (index = 0; index < (int) sizeof (key); index++)
+		key[index] = mask[(iter + desp + index) % 4];
+
+#if defined(NOPOLL_MASK_AVX2)
+	{
+		__m256i vkey = _mm256_loadu_si256 ((const __m256i *) key);
+		for (; payload_size - iter >= 32; iter += 32) {
+			__m256i v = _mm256_loadu_si256 ((const __m256i *) (data + iter));
+			_mm256_storeu_si256 ((__m256i *) (data + iter), _mm256_xor_si256 (v, vkey));
+		}
+	}
+#elif defined(NOPOLL_MASK_SSE2)
+	{
+		__m128i vkey = _mm_loadu_si128 ((const __m128i *) key);
+		for (; payload_size - iter >= 16; iter += 16) {
+			__m128i v = _mm_loadu_si128 ((const __m128i *) (data + iter));
+			_mm_storeu_si128 ((__m128i *) (data + iter), _mm_xor_si128 (v, vkey));
+		}
+	}
+#elif defined(NOPOLL_MASK_NEON)
+	{
+		uint8x16_t vkey = vld1q_u8 (key);
+		for (; payload_size - iter >= 16; iter += 16)
+			vst1q_u8 (data + iter, veorq_u8 (vld1q_u8 (data + iter), vkey));
+	}
+#endif
+
+	/* remaining 8 byte words, memcpy compiles to a plain load/store */
+	memcpy (&word, key, sizeof (word));
+	for (; payload_size - iter >= 8; iter += 8) {
+		memcpy (&value, data + iter, sizeof (value));
+		value ^= word;
+		memcpy (data + iter, &value, sizeof (value));
+	}
+
+mask_tail:
 	while (iter < payload_size) {
 		/* rotate mask and apply it */
-		mask_index = (iter + desp) % 4;
-		payload[iter] ^= mask[mask_index];
+		data[iter] ^= mask[(iter + desp) % 4];
 		iter++;
 	} /* end while */
 
@@ -3254,6 +3602,82 @@ void nopoll_conn_mask_content (noPollCtx * ctx, char * payload, int payload_size
 }
 
 
+/**
+ * @internal Collects the frames of a compressed message and inflates
+ * it once its last frame was received.
+ *
+ * @return The message with the inflated payload, or NULL if more
+ * frames are needed or it fails (connection is closed).
+ */
+static noPollMsg * __nopoll_conn_inflate_msg (noPollConn * conn, noPollMsg * msg)
+{
+	const char * input = (const char *) msg->payload;
+	long         input_length = msg->payload_size;
+	char       * payload;
+	long         length = 0;
+
+	if (msg->remain_bytes > 0 || ! msg->has_fin || conn->inflate_buf_len > 0) {
+		/* fragmented or partially read: append */
+		if (conn->inflate_buf_len + input_length > conn->inflate_buf_size) {
+			long   size = conn->inflate_buf_size > 0 ? conn->inflate_buf_size : 1024;
+			char * buf;
+			while (size < conn->inflate_buf_len + input_length)
+				size *= 2;
+			buf = nopoll_realloc (conn->inflate_buf, size);
+			if (buf == NULL) {
+				nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Unable to acquire memory to collect compressed message, dropping connection id=%d", conn->id);
+				nopoll_msg_unref (msg);
+				nopoll_conn_shutdown (conn);
+				return NULL;
+			} /* end if */
+			conn->inflate_buf      = buf;
+			conn->inflate_buf_size = size;
+		} /* end if */
+		memcpy (conn->inflate_buf + conn->inflate_buf_len, input, input_length);
+		conn->inflate_buf_len += input_length;
+
+		if (msg->remain_bytes > 0 || ! msg->has_fin) {
+			nopoll_msg_unref (msg);
+			return NULL;
+		} /* end if */
+		input        = conn->inflate_buf;
+		input_length = conn->inflate_buf_len;
+	} /* end if */
+
+	payload = __nopoll_deflate_decompress (conn->deflate, input, input_length, &length);
+	conn->deflate_recv_wire += input_length;
+	conn->inflate_msg = nopoll_false;
+
+	/* release collected frames, a message only needs them briefly */
+	nopoll_free (conn->inflate_buf);
+	conn->inflate_buf      = NULL;
+	conn->inflate_buf_len  = 0;
+	conn->inflate_buf_size = 0;
+
+	if (payload == NULL) {
+		nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Failed to inflate compressed message (%ld bytes), dropping connection id=%d",
+			    input_length, conn->id);
+		nopoll_msg_unref (msg);
+		nopoll_conn_shutdown (conn);
+		return NULL;
+	} /* end if */
+	conn->deflate_recv_raw += length;
+
+	/* replace compressed payload */
+	if (msg->payload_owner) {
+		__nopoll_conn_buffer_unref (msg->payload_owner);
+		msg->payload_owner = NULL;
+	} else {
+		nopoll_free (msg->payload);
+	}
+	msg->payload      = payload;
+	msg->payload_size = length;
+	msg->op_code      = conn->fragment_op_code;
+	msg->has_fin      = nopoll_true;
+	msg->is_fragment  = nopoll_false;
+	return msg;
+}
+
 /**
  * @brief Allows to get the next message available on the provided
  * connection. The function returns NULL in the case no message is
@@ -3574,6 +3998,11 @@ noPollMsg   * nopoll_conn_get_msg (noPollConn * conn)
 	msg->is_masked    = nopoll_get_bit (buffer[1], 7);
 	msg->payload_size = buffer[1] & 0x7F;
 
+	/* RSV1 on the first frame of a data message flags it as
+	 * compressed (permessage-deflate) */
+	if (msg->op_code == NOPOLL_TEXT_FRAME || msg->op_code == NOPOLL_BINARY_FRAME)
+		conn->inflate_msg = conn->deflate != NULL && nopoll_get_bit (buffer[0], 6);
+
 	/* ensure FIN = 1 in case we are listener */
 	if (conn->role == NOPOLL_ROLE_LISTENER && ! msg->is_masked) {
 		nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Received websocket frame with mask bit set to zero, closing session id: %d",
@@ -3762,29 +4191,48 @@ noPollMsg   * nopoll_conn_get_msg (noPollConn * conn)
 
 read_payload:
 
-	/* copy payload received */
-	msg->payload = nopoll_new (char, msg->payload_size + 1);	/* allow extra byte for string terminator */
-	if (msg->payload == NULL) {
-		nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Unable to acquire memory to read the incoming frame, dropping connection id=%d", conn->id);
-		nopoll_msg_unref (msg);
-		nopoll_conn_shutdown (conn);
-		return NULL;
-	} /* end if */
+	/* remember the type of fragmented messages for continuation frames */
+	if (msg->op_code == NOPOLL_TEXT_FRAME || msg->op_code == NOPOLL_BINARY_FRAME)
+		conn->fragment_op_code = msg->op_code;
+
+	if (msg->payload_size > 0 && conn->pending_buf_bytes == 0 &&
+	    conn->read_buf_len - conn->read_buf_pos >= msg->payload_size &&
+	    (msg->op_code == NOPOLL_BINARY_FRAME ||
+	     (msg->op_code == NOPOLL_CONTINUATION_FRAME && conn->fragment_op_code == NOPOLL_BINARY_FRAME))) {
+		/* whole binary payload already buffered: hand it out as
+		 * a view, text payloads are copied since they are
+		 * expected to be NUL terminated */
+		msg->payload       = conn->read_buf->data + conn->read_buf_pos;
+		msg->payload_owner = __nopoll_conn_buffer_ref (conn->read_buf);
+		conn->read_buf_pos += msg->payload_size;
+		conn->recv_views++;
+		bytes = msg->payload_size;
+	} else {
+		/* copy payload received */
+		msg->payload = nopoll_new (char, msg->payload_size + 1);	/* allow extra byte for string terminator */
+		if (msg->payload == NULL) {
+			nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Unable to acquire memory to read the incoming frame, dropping connection id=%d", conn->id);
+			nopoll_msg_unref (msg);
+			nopoll_conn_shutdown (conn);
+			return NULL;
+		} /* end if */
 
-	if (msg->payload_size == 0)
-		bytes = 0;
-	else
-		bytes = __nopoll_conn_receive (conn, (char *) msg->payload, msg->payload_size);
-	if (bytes < 0) {
-		nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Connection lost during message reception, dropping connection id=%d, bytes=%d, errno=%d : %s",
-			    conn->id, bytes, errno, strerror (errno));
-		nopoll_msg_unref (msg);
-		nopoll_conn_shutdown (conn);
-		return NULL;
-	} /* end if */
+		if (msg->payload_size == 0)
+			bytes = 0;
+		else
+			bytes = __nopoll_conn_receive (conn, (char *) msg->payload, msg->payload_size);
+		if (bytes < 0) {
+			nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Connection lost during message reception, dropping connection id=%d, bytes=%d, errno=%d : %s",
+				    conn->id, bytes, errno, strerror (errno));
+			nopoll_msg_unref (msg);
+			nopoll_conn_shutdown (conn);
+			return NULL;
+		} /* end if */
 
-	/* add string terminator */
-	((char *) msg->payload)[bytes] = 0;
+		/* add string terminator */
+		((char *) msg->payload)[bytes] = 0;
+	} /* end if */
+	conn->recv_bytes += bytes;
 
 	/* record we've got content pending to be read */
 	msg->remain_bytes = msg->payload_size - bytes;
@@ -3866,9 +4314,148 @@ read_payload:
 		return NULL;
 	} /* end if */
 
+	/* compressed message: collect its frames and deliver it once
+	 * inflated */
+	if (conn->inflate_msg && (msg->op_code == NOPOLL_TEXT_FRAME || msg->op_code == NOPOLL_BINARY_FRAME ||
+				  msg->op_code == NOPOLL_CONTINUATION_FRAME)) {
+		msg = __nopoll_conn_inflate_msg (conn, msg);
+		if (msg == NULL)
+			return NULL;
+	} /* end if */
+
+	conn->recv_frames++;
 	return msg;
 }
 
+/**
+ * @brief Allows to get receive statistics of the provided
+ * connection, useful to check how many frames were parsed out of
+ * each read done on the transport (TLS or socket).
+ *
+ * @param conn The connection to get statistics from.
+ *
+ * @param reads Optional reference to report read calls done on the
+ * transport.
+ *
+ * @param frames Optional reference to report messages delivered by
+ * \ref nopoll_conn_get_msg.
+ *
+ * @param views Optional reference to report messages whose payload
+ * was delivered without copy, as a view into the receive buffer.
+ *
+ * @param bytes Optional reference to report payload bytes received.
+ */
+void          nopoll_conn_get_recv_stats (noPollConn * conn, long * reads, long * frames, long * views, long * bytes)
+{
+	if (conn == NULL)
+		return;
+	if (reads)
+		(*reads) = conn->recv_reads;
+	if (frames)
+		(*frames) = conn->recv_frames;
+	if (views)
+		(*views) = conn->recv_views;
+	if (bytes)
+		(*bytes) = conn->recv_bytes;
+	return;
+}
+
+/**
+ * @brief Allows to check if the connection holds received bytes that
+ * were not delivered yet by ef nopoll_conn_get_msg: frames left in
+ * the read-ahead buffer, a partial header, or TLS record data already
+ * decrypted. The socket will not report them as readable, so callers
+ * waiting on the socket (or sleeping) between ef
+ * nopoll_conn_get_msg calls should keep calling it while this returns
+ * > 0.
+ *
+ * Unlike ef nopoll_conn_read_pending, this is meant for the message
+ * oriented API.
+ *
+ * @param conn The connection to check.
+ *
+ * @return The amount of bytes retained, 0 if nothing is pending.
+ */
+int           nopoll_conn_recv_pending (noPollConn * conn)
+{
+	int pending;
+	if (conn == NULL)
+		return 0;
+	pending = conn->read_buf_len - conn->read_buf_pos + conn->pending_buf_bytes;
+	if (conn->tls_on) {
+#if defined(NOPOLL_HAVE_MBEDTLS_ENABLED)
+		pending += (int) mbedtls_ssl_get_bytes_avail (&conn->ssl);
+#else
+		if (conn->ssl != NULL)
+			pending += SSL_pending (conn->ssl);
+#endif
+	}
+	return pending;
+}
+
+/**
+ * @brief Allows to get send statistics of the provided connection.
+ * With TLS each write is a TLS record (for writes up to 16KB).
+ *
+ * @param conn The connection to get statistics from.
+ *
+ * @param writes Optional reference to report write calls done on the
+ * transport, including retries of pending writes.
+ *
+ * @param frames Optional reference to report frames sent.
+ *
+ * @param bytes Optional reference to report payload bytes sent.
+ */
+void          nopoll_conn_get_send_stats (noPollConn * conn, long * writes, long * frames, long * bytes)
+{
+	if (conn == NULL)
+		return;
+	if (writes)
+		(*writes) = conn->send_writes;
+	if (frames)
+		(*frames) = conn->send_frames;
+	if (bytes)
+		(*bytes) = conn->send_bytes;
+	return;
+}
+
+/**
+ * @brief Allows to get permessage-deflate statistics of the provided
+ * connection, to check the savings on the wire (see \ref
+ * nopoll_conn_opts_set_permessage_deflate).
+ *
+ * @param conn The connection to get statistics from.
+ *
+ * @param sent_raw Optional reference to report text bytes sent by
+ * the application.
+ *
+ * @param sent_wire Optional reference to report payload bytes those
+ * messages took on the wire.
+ *
+ * @param recv_raw Optional reference to report bytes of compressed
+ * messages received, once inflated.
+ *
+ * @param recv_wire Optional reference to report payload bytes those
+ * messages took on the wire.
+ *
+ * @return nopoll_true if permessage-deflate was negotiated on the
+ * connection, otherwise nopoll_false.
+ */
+nopoll_bool   nopoll_conn_get_deflate_stats (noPollConn * conn, long * sent_raw, long * sent_wire, long * recv_raw, long * recv_wire)
+{
+	if (conn == NULL)
+		return nopoll_false;
+	if (sent_raw)
+		(*sent_raw) = conn->deflate_sent_raw;
+	if (sent_wire)
+		(*sent_wire) = conn->deflate_sent_wire;
+	if (recv_raw)
+		(*recv_raw) = conn->deflate_recv_raw;
+	if (recv_wire)
+		(*recv_wire) = conn->deflate_recv_wire;
+	return conn->deflate != NULL;
+}
+
 /**
  * @internal Implementation to send Frames according to various
  * parameters passed in into the function. This is the core function
@@ -3886,6 +4473,9 @@ read_payload:
  * include a pause between sending the header and the rest of the
  * content.
  */
+static int __nopoll_conn_send_frame_common (noPollConn * conn, nopoll_bool fin, nopoll_bool masked, nopoll_bool rsv1,
+					    noPollOpCode op_code, long length, noPollPtr content, long sleep_in_header);
+
 int           __nopoll_conn_send_common (noPollConn * conn, const char * content, long length, nopoll_bool has_fin, long sleep_in_header, noPollOpCode frame_type)
 {
 // Modified by Qinglong
@@ -3908,6 +4498,28 @@ int           __nopoll_conn_send_common (noPollConn * conn, const char * content
 	}
 	nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "nopoll_conn_send_text: Attempting to send %d bytes", (int) length);
 
+	/* compress complete text messages when permessage-deflate was
+	 * negotiated, binary (audio) is sent as it is */
+	if (conn->deflate && frame_type == NOPOLL_TEXT_FRAME && has_fin) {
+		char * compressed = NULL;
+		long   compressed_length = 0;
+		int    result;
+
+		if (length >= NOPOLL_DEFLATE_MIN_SIZE)
+			compressed = __nopoll_deflate_compress (conn->deflate, content, length, &compressed_length);
+		conn->deflate_sent_raw  += length;
+		conn->deflate_sent_wire += compressed ? compressed_length : length;
+		if (compressed) {
+			result = __nopoll_conn_send_frame_common (conn, /* fin */ nopoll_true, /* masked */ conn->role == NOPOLL_ROLE_CLIENT,
+								  /* rsv1 */ nopoll_true, frame_type, compressed_length, compressed, sleep_in_header);
+			nopoll_free (compressed);
+			/* report user bytes once the whole frame was written,
+			 * otherwise bytes written so far (pending write
+			 * completes the rest) */
+			return result == compressed_length ? length : result;
+		} /* end if */
+	} /* end if */
+
 	/* sending content as client */
 	if (conn->role == NOPOLL_ROLE_CLIENT) {
 		return nopoll_conn_send_frame (conn, /* fin */ has_fin, /* masked */ nopoll_true,
@@ -4495,6 +5107,7 @@ int nopoll_conn_complete_pending_write (noPollConn * conn)
 		return 0;
 
 	/* simple implementation */
+	conn->send_writes++;
 	bytes_written = conn->send (conn, conn->pending_write + conn->pending_write_desp, conn->pending_write_bytes);
 	if (bytes_written == conn->pending_write_bytes) {
 		nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Completed pending write operation with bytes=%d", bytes_written);
@@ -4641,7 +5254,17 @@ int nopoll_conn_flush_writes (noPollConn * conn, long timeout, int previous_resu
  */
 int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool masked,
 			    noPollOpCode op_code, long length, noPollPtr content, long sleep_in_header)
+{
+	return __nopoll_conn_send_frame_common (conn, fin, masked, nopoll_false, op_code, length, content, sleep_in_header);
+}
 
+/**
+ * @internal Implementation of \ref nopoll_conn_send_frame, rsv1 flags
+ * the frame as the first one of a compressed message
+ * (permessage-deflate).
+ */
+static int __nopoll_conn_send_frame_common (noPollConn * conn, nopoll_bool fin, nopoll_bool masked, nopoll_bool rsv1,
+					    noPollOpCode op_code, long length, noPollPtr content, long sleep_in_header)
 {
 	char               header[14];
 	int                header_size;
@@ -4665,6 +5288,8 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 	/* set header codes */
 	if (fin)
 		nopoll_set_bit (header, 7);
+	if (rsv1)
+		nopoll_set_bit (header, 6);
 
 	if (masked) {
 		nopoll_set_bit (header + 1, 7);
@@ -4768,8 +5393,11 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 	} /* end if */
 	/****** END INTERNAL debug code for test_30 : nopoll-regression-client.c ******/
 
+	conn->send_frames++;
+	conn->send_bytes += length;
 	while (nopoll_true) {
 		/* try to write bytes */
+		conn->send_writes++;
 		if (sleep_in_header == 0) {
 			bytes_written = conn->send (conn, send_buffer + desp, length + header_size - desp);
 		} else {
@@ -5351,6 +5979,8 @@ nopoll_bool      nopoll_conn_wait_until_connection_ready (noPollConn * conn,
 							  int          timeout)
 {
 	long long total_timeout = timeout * 1000000;
+	fd_set         fdset;
+	struct timeval tv;
 
 	/* check if the connection already finished its connection
 	   handshake */
@@ -5360,8 +5990,14 @@ nopoll_bool      nopoll_conn_wait_until_connection_ready (noPollConn * conn,
 		if (! nopoll_conn_is_ok (conn))
 			return nopoll_false;
 
-		/* wait a bit 10ms */
-		nopoll_sleep (10000);
+		/* wait a bit 10ms, or less if the server reply is
+		   already there */
+		FD_ZERO (&fdset);
+		FD_SET (conn->session, &fdset);
+		tv.tv_sec  = 0;
+		tv.tv_usec = 10000;
+		if (select (conn->session + 1, &fdset, NULL, NULL, &tv) < 0)
+			nopoll_sleep (10000);
 
 		/* reduce the amount of time we have to wait */
 		total_timeout = total_timeout - 10000;
@@ -188,6 +188,14 @@ nopoll_bool   nopoll_conn_set_sock_block         (NOPOLL_SOCKET socket,
 
 noPollMsg   * nopoll_conn_get_msg (noPollConn * conn);
 
+void          nopoll_conn_get_recv_stats (noPollConn * conn, long * reads, long * frames, long * views, long * bytes);
+
+int           nopoll_conn_recv_pending (noPollConn * conn);
+
+void          nopoll_conn_get_send_stats (noPollConn * conn, long * writes, long * frames, long * bytes);
+
+nopoll_bool   nopoll_conn_get_deflate_stats (noPollConn * conn, long * sent_raw, long * sent_wire, long * recv_raw, long * recv_wire);
+
 int           nopoll_conn_send_text (noPollConn * conn, const char * content, long length);
 
 int           nopoll_conn_send_text_fragment (noPollConn * conn, const char * content, long length);
@@ -228,6 +236,10 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 			    noPollOpCode op_code, long length, noPollPtr content,
 			    long sleep_in_header);
 
+noPollBuffer * __nopoll_conn_buffer_ref (noPollBuffer * buffer);
+
+void          __nopoll_conn_buffer_unref (noPollBuffer * buffer);
+
 int           __nopoll_conn_send_common (noPollConn * conn,
 					 const char * content,
 					 long         length,
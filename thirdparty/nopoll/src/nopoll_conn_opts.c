@@ -44,6 +44,10 @@
 //  3. Add sysutils support, because sysutils has osal layer, we don't need
 //     to care about platform dependent
 //  4. Add lwip support
+//  5. Keep parsed CA and TLS session in reused options, see
+//     nopoll_conn_opts_clear_ssl_session
+//  6. Add permessage-deflate offer, see
+//     nopoll_conn_opts_set_permessage_deflate
 #include "nopoll_conn_opts.h"
 #include "nopoll_private.h"
 
@@ -85,6 +89,10 @@ noPollConnOpts * nopoll_conn_opts_new (void)
 
 	result->mutex        = nopoll_mutex_create ();
 	result->refs         = 1;
+#if defined(NOPOLL_HAVE_MBEDTLS_ENABLED)
+	mbedtls_x509_crt_init (&result->ssl_ca_chain);
+	mbedtls_ssl_session_init (&result->ssl_session);
+#endif
 
 	/* by default, disable ssl peer verification */
 	result->disable_ssl_verify = nopoll_true;
@@ -436,6 +444,34 @@ void nopoll_conn_opts_set_reuse        (noPollConnOpts * opts, nopoll_bool reuse
 }
 
 
+/**
+ * @brief Offers the permessage-deflate extension (RFC 7692) on client
+ * connections created with these options. When the server accepts
+ * it, text messages are sent and received compressed; binary messages
+ * are never compressed by this side (audio doesn't compress).
+ *
+ * Each direction keeps a sliding window of (1 << window_bits) bytes
+ * while the connection is alive, which is also the window offered for
+ * the server (server_max_window_bits), so memory stays bounded.
+ *
+ * @param opts The connection options object.
+ *
+ * @param window_bits Window size, 9 to 15, or 0 to not offer the
+ * extension (default).
+ */
+void nopoll_conn_opts_set_permessage_deflate (noPollConnOpts * opts, int window_bits)
+{
+	if (opts == NULL)
+		return;
+	if (window_bits != 0 && (window_bits < 9 || window_bits > 15)) {
+		nopoll_log (NULL, NOPOLL_LEVEL_WARNING, "Invalid permessage-deflate window bits %d, expected 9 to 15",
+			    window_bits);
+		return;
+	}
+	opts->deflate_window_bits = window_bits;
+	return;
+}
+
 /** 
  * @brief Allows the user to configure the interface to bind the connection to.
  *
@@ -486,6 +522,8 @@ void __nopoll_conn_opts_free_common  (noPollConnOpts * opts)
 	opts->private_key_size = 0;
 	opts->chain_certificate_size = 0;
 	opts->ca_certificate_size = 0;
+	mbedtls_x509_crt_free (&opts->ssl_ca_chain);
+	mbedtls_ssl_session_free (&opts->ssl_session);
 #endif
 
 	/* cookie */
@@ -518,6 +556,33 @@ void nopoll_conn_opts_free (noPollConnOpts * opts)
 	return;
 } /* end if */
 
+/**
+ * @brief Drops the TLS session kept by the provided options, so the
+ * next connection does a full handshake instead of resuming it.
+ *
+ * With mbedtls, options flagged with \ref nopoll_conn_opts_set_reuse
+ * keep the parsed CA certificate and the session of the last TLS
+ * connection, so reconnecting to the same server resumes the session
+ * (session ticket or session id) and skips certificate exchange and
+ * key agreement. Call this function when connecting to a different
+ * server with the same options.
+ *
+ * @param opts The connection options object.
+ */
+void nopoll_conn_opts_clear_ssl_session (noPollConnOpts * opts)
+{
+	if (opts == NULL)
+		return;
+#if defined(NOPOLL_HAVE_MBEDTLS_ENABLED)
+	nopoll_mutex_lock (opts->mutex);
+	mbedtls_ssl_session_free (&opts->ssl_session);
+	mbedtls_ssl_session_init (&opts->ssl_session);
+	opts->ssl_session_valid = nopoll_false;
+	nopoll_mutex_unlock (opts->mutex);
+#endif
+	return;
+}
+
 /**
  * @internal API. Do not use it. It may change at any time without any
  * previous indication.
@@ -92,6 +92,10 @@ void nopoll_conn_opts_set_interface    (noPollConnOpts * opts, const char * _int
 
 void nopoll_conn_opts_set_extra_headers (noPollConnOpts * opts, const char * extra_headers);
 
+void nopoll_conn_opts_set_permessage_deflate (noPollConnOpts * opts, int window_bits);
+
+void nopoll_conn_opts_clear_ssl_session (noPollConnOpts * opts);
+
 void nopoll_conn_opts_free (noPollConnOpts * opts);
 
 /** internal API **/
@@ -333,12 +333,22 @@ typedef struct _noPollIoEngine noPollIoEngine;
  */
 typedef struct _noPollMsg noPollMsg;
 
+/**
+ * @internal Reference counted block used to buffer incoming data.
+ */
+typedef struct _noPollBuffer noPollBuffer;
+
 /**
  * @brief Abstraction that represents the status and data exchanged
  * during the handshake.
  */
 typedef struct _noPollHandshake noPollHandShake;
 
+/**
+ * @internal permessage-deflate state of a connection (RFC 7692).
+ */
+typedef struct _noPollDeflate noPollDeflate;
+
 /**
  * @brief Nopoll debug levels.
  *
@@ -0,0 +1,870 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Raw DEFLATE (RFC 1951) codec for the permessage-deflate extension
+// (RFC 7692). Both directions keep a sliding window bounded by the
+// negotiated window bits, so the memory held per connection between
+// messages is two windows (2KB each with 11 bits). The compressor
+// does LZ77 with hash chains over the window plus the message and
+// emits whichever of stored, fixed or dynamic Huffman block is the
+// smallest; the decompressor handles any DEFLATE stream.
+#include "nopoll_deflate.h"
+#include "nopoll_private.h"
+
+/* hash chains built for each compressed message */
+#define NOPOLL_DEFLATE_HASH_BITS   10
+#define NOPOLL_DEFLATE_HASH_SIZE   (1 << NOPOLL_DEFLATE_HASH_BITS)
+#define NOPOLL_DEFLATE_MAX_CHAIN   32
+/* matches shorter than this are checked against a match starting
+ * at the next byte (lazy matching) */
+#define NOPOLL_DEFLATE_LAZY_MATCH  32
+#define NOPOLL_DEFLATE_MIN_MATCH   3
+#define NOPOLL_DEFLATE_MAX_MATCH   258
+/* larger messages are sent as they are, bounding the transient
+ * memory used by the compressor */
+#define NOPOLL_DEFLATE_MAX_INPUT   (16 * 1024)
+/* guard against decompression bombs */
+#define NOPOLL_INFLATE_MAX_OUTPUT  (1024 * 1024)
+
+#define NOPOLL_DEFLATE_MATCH_FLAG  0x80000000
+
+static const short __nopoll_deflate_len_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const short __nopoll_deflate_len_extra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const short __nopoll_deflate_dist_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577};
+static const short __nopoll_deflate_dist_extra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+static const unsigned char __nopoll_deflate_cl_order[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+/**
+ * @internal Creates the permessage-deflate state of a connection.
+ *
+ * @param window_bits Window used to compress outgoing messages
+ * (client_max_window_bits when acting as client), 8 to 15.
+ *
+ * @param no_context_takeover Do not refer to previous messages when
+ * compressing.
+ *
+ * @param peer_window_bits Window used by the peer to compress
+ * incoming messages, 8 to 15.
+ *
+ * @param peer_no_context_takeover The peer doesn't refer to previous
+ * messages, so no history is kept for them.
+ */
+noPollDeflate * __nopoll_deflate_new (int         window_bits,
+				      nopoll_bool no_context_takeover,
+				      int         peer_window_bits,
+				      nopoll_bool peer_no_context_takeover)
+{
+	noPollDeflate * deflate;
+
+	if (window_bits < 8 || window_bits > 15 || peer_window_bits < 8 || peer_window_bits > 15)
+		return NULL;
+
+	deflate = nopoll_new (noPollDeflate, 1);
+	if (deflate == NULL)
+		return NULL;
+	deflate->window_size              = 1 << window_bits;
+	deflate->no_context_takeover      = no_context_takeover;
+	deflate->peer_window_size         = 1 << peer_window_bits;
+	deflate->peer_no_context_takeover = peer_no_context_takeover;
+
+	if (! no_context_takeover)
+		deflate->history = nopoll_new (unsigned char, deflate->window_size);
+	if (! peer_no_context_takeover)
+		deflate->peer_history = nopoll_new (unsigned char, deflate->peer_window_size);
+	if ((! no_context_takeover && deflate->history == NULL) ||
+	    (! peer_no_context_takeover && deflate->peer_history == NULL)) {
+		__nopoll_deflate_free (deflate);
+		return NULL;
+	} /* end if */
+
+	return deflate;
+}
+
+/**
+ * @internal Releases the permessage-deflate state.
+ */
+void __nopoll_deflate_free (noPollDeflate * deflate)
+{
+	if (deflate == NULL)
+		return;
+	nopoll_free (deflate->history);
+	nopoll_free (deflate->peer_history);
+	nopoll_free (deflate);
+	return;
+}
+
+/*** compressor ***/
+
+typedef struct _noPollDeflateOut {
+	unsigned char * data;
+	long            pos;
+	unsigned int    bit_buf;
+	int             bit_count;
+} noPollDeflateOut;
+
+static void __nopoll_deflate_put_bits (noPollDeflateOut * out, unsigned int value, int count)
+{
+	out->bit_buf   |= value << out->bit_count;
+	out->bit_count += count;
+	while (out->bit_count >= 8) {
+		out->data[out->pos++] = out->bit_buf & 0xff;
+		out->bit_buf   >>= 8;
+		out->bit_count  -= 8;
+	} /* end while */
+}
+
+static void __nopoll_deflate_align (noPollDeflateOut * out)
+{
+	if (out->bit_count > 0)
+		__nopoll_deflate_put_bits (out, 0, 8 - out->bit_count);
+}
+
+static int __nopoll_deflate_len_code (int length)
+{
+	int code = 28;
+	while (__nopoll_deflate_len_base[code] > length)
+		code--;
+	return code;
+}
+
+static int __nopoll_deflate_dist_code (int dist)
+{
+	int code = 29;
+	while (__nopoll_deflate_dist_base[code] > dist)
+		code--;
+	return code;
+}
+
+static int __nopoll_deflate_huffman (const int * freq, int count, int * weight, int * parent, int * symbols, unsigned char * lengths)
+{
+	int nsym = 0, iterator, j, leaf, node, next, max = 0;
+
+	for (iterator = 0; iterator < count; iterator++) {
+		lengths[iterator] = 0;
+		if (freq[iterator] > 0)
+			symbols[nsym++] = iterator;
+	} /* end for */
+	if (nsym == 0)
+		return 0;
+	if (nsym == 1) {
+		lengths[symbols[0]] = 1;
+		return 1;
+	} /* end if */
+
+	/* leaves sorted by weight, internal nodes are created in
+	 * increasing weight order, so the two smallest are always at
+	 * the front of either queue */
+	for (iterator = 0; iterator < nsym; iterator++)
+		weight[iterator] = freq[symbols[iterator]];
+	for (iterator = 1; iterator < nsym; iterator++) {
+		int w = weight[iterator], s = symbols[iterator];
+		for (j = iterator; j > 0 && weight[j - 1] > w; j--) {
+			weight[j]  = weight[j - 1];
+			symbols[j] = symbols[j - 1];
+		}
+		weight[j]  = w;
+		symbols[j] = s;
+	} /* end for */
+
+	leaf = 0;
+	node = nsym;
+	for (next = nsym; next < 2 * nsym - 1; next++) {
+		int pick[2];
+		for (j = 0; j < 2; j++) {
+			if (leaf < nsym && (node >= next || weight[leaf] <= weight[node]))
+				pick[j] = leaf++;
+			else
+				pick[j] = node++;
+		}
+		weight[next]    = weight[pick[0]] + weight[pick[1]];
+		parent[pick[0]] = next;
+		parent[pick[1]] = next;
+	} /* end for */
+
+	/* parents always have a higher index: walk down from the root */
+	weight[2 * nsym - 2] = 0;
+	for (node = 2 * nsym - 3; node >= 0; node--) {
+		weight[node] = weight[parent[node]] + 1;
+		if (node < nsym) {
+			lengths[symbols[node]] = weight[node];
+			if (weight[node] > max)
+				max = weight[node];
+		}
+	} /* end for */
+	return max;
+}
+
+/* Builds length limited Huffman code lengths: when the optimal tree
+ * is too deep, frequencies are flattened until it fits, which keeps
+ * the code complete as required by inflaters */
+static void __nopoll_deflate_build_lengths (const int * freq, int count, int max_bits, unsigned char * lengths)
+{
+	int weight[2 * 288], parent[2 * 288], symbols[288], scaled[288];
+	int iterator;
+
+	if (__nopoll_deflate_huffman (freq, count, weight, parent, symbols, lengths) <= max_bits)
+		return;
+	for (iterator = 0; iterator < count; iterator++)
+		scaled[iterator] = freq[iterator];
+	do {
+		for (iterator = 0; iterator < count; iterator++) {
+			if (scaled[iterator] > 0)
+				scaled[iterator] = (scaled[iterator] >> 1) | 1;
+		}
+	} while (__nopoll_deflate_huffman (scaled, count, weight, parent, symbols, lengths) > max_bits);
+}
+
+static void __nopoll_deflate_build_codes (const unsigned char * lengths, int count, unsigned short * codes)
+{
+	int bl_count[16], next_code[16];
+	int iterator, bits, code = 0;
+
+	memset (bl_count, 0, sizeof (bl_count));
+	for (iterator = 0; iterator < count; iterator++)
+		bl_count[lengths[iterator]]++;
+	bl_count[0] = 0;
+	for (bits = 1; bits < 16; bits++) {
+		code = (code + bl_count[bits - 1]) << 1;
+		next_code[bits] = code;
+	} /* end for */
+
+	/* codes are written least significant bit first: reverse them */
+	for (iterator = 0; iterator < count; iterator++) {
+		int len = lengths[iterator], value, reversed = 0;
+		if (len == 0)
+			continue;
+		value = next_code[len]++;
+		for (bits = 0; bits < len; bits++) {
+			reversed = (reversed << 1) | (value & 1);
+			value >>= 1;
+		}
+		codes[iterator] = reversed;
+	} /* end for */
+}
+
+static void __nopoll_deflate_fixed_lengths (unsigned char * lit_lengths, unsigned char * dist_lengths)
+{
+	int iterator;
+	for (iterator = 0; iterator < 288; iterator++)
+		lit_lengths[iterator] = iterator < 144 ? 8 : iterator < 256 ? 9 : iterator < 280 ? 7 : 8;
+	for (iterator = 0; iterator < 30; iterator++)
+		dist_lengths[iterator] = 5;
+}
+
+static long __nopoll_deflate_data_bits (const int * lit_freq, const int * dist_freq,
+					const unsigned char * lit_lengths, const unsigned char * dist_lengths)
+{
+	long bits = 0;
+	int  iterator;
+	for (iterator = 0; iterator < 286; iterator++) {
+		bits += (long) lit_freq[iterator] * lit_lengths[iterator];
+		if (iterator > 256)
+			bits += (long) lit_freq[iterator] * __nopoll_deflate_len_extra[iterator - 257];
+	}
+	for (iterator = 0; iterator < 30; iterator++)
+		bits += (long) dist_freq[iterator] * (dist_lengths[iterator] + __nopoll_deflate_dist_extra[iterator]);
+	return bits;
+}
+
+static void __nopoll_deflate_write_tokens (noPollDeflateOut * out, const unsigned int * tokens, long count,
+					   const unsigned char * lit_lengths, const unsigned short * lit_codes,
+					   const unsigned char * dist_lengths, const unsigned short * dist_codes)
+{
+	long iterator;
+	for (iterator = 0; iterator < count; iterator++) {
+		unsigned int token = tokens[iterator];
+		if (token & NOPOLL_DEFLATE_MATCH_FLAG) {
+			int length = (token >> 16) & 0x1ff;
+			int dist   = token & 0xffff;
+			int code   = __nopoll_deflate_len_code (length);
+			__nopoll_deflate_put_bits (out, lit_codes[257 + code], lit_lengths[257 + code]);
+			__nopoll_deflate_put_bits (out, length - __nopoll_deflate_len_base[code], __nopoll_deflate_len_extra[code]);
+			code = __nopoll_deflate_dist_code (dist);
+			__nopoll_deflate_put_bits (out, dist_codes[code], dist_lengths[code]);
+			__nopoll_deflate_put_bits (out, dist - __nopoll_deflate_dist_base[code], __nopoll_deflate_dist_extra[code]);
+		} else {
+			__nopoll_deflate_put_bits (out, lit_codes[token], lit_lengths[token]);
+		}
+	} /* end for */
+	__nopoll_deflate_put_bits (out, lit_codes[256], lit_lengths[256]);
+}
+
+#define __NOPOLL_DEFLATE_HASH(p) \
+	((((unsigned int)(p)[0] << 16 | (unsigned int)(p)[1] << 8 | (p)[2]) * 2654435761u) >> (32 - NOPOLL_DEFLATE_HASH_BITS))
+
+static int __nopoll_deflate_find_match (const unsigned char * buf, long n, long pos, int window_size,
+					const int * head, const int * prev, int * match_dist)
+{
+	int  best_len = 0, chain = NOPOLL_DEFLATE_MAX_CHAIN;
+	long max_len  = n - pos, p;
+
+	if (max_len < NOPOLL_DEFLATE_MIN_MATCH)
+		return 0;
+	if (max_len > NOPOLL_DEFLATE_MAX_MATCH)
+		max_len = NOPOLL_DEFLATE_MAX_MATCH;
+
+	p = head[__NOPOLL_DEFLATE_HASH (buf + pos)];
+	while (p >= 0 && pos - p <= window_size && chain-- > 0) {
+		if (buf[p + best_len] == buf[pos + best_len] && buf[p] == buf[pos]) {
+			int len = 1;
+			while (len < max_len && buf[p + len] == buf[pos + len])
+				len++;
+			if (len > best_len) {
+				best_len    = len;
+				*match_dist = pos - p;
+				if (len == max_len)
+					break;
+			}
+		} /* end if */
+		if (prev[p & (window_size - 1)] >= p)
+			break;
+		p = prev[p & (window_size - 1)];
+	} /* end while */
+
+	return best_len >= NOPOLL_DEFLATE_MIN_MATCH ? best_len : 0;
+}
+
+/**
+ * @internal Compresses a message as RFC 7692 requires: a non final
+ * block followed by an empty stored block whose trailing 0x00 0x00
+ * 0xff 0xff is removed. Matches may refer to previously compressed
+ * messages unless no context takeover was negotiated.
+ *
+ * @return A newly allocated buffer with the compressed message, or
+ * NULL if it would not be smaller than the message (which must then
+ * be sent uncompressed, the history is left untouched) or it fails.
+ */
+char          * __nopoll_deflate_compress (noPollDeflate * deflate,
+					   const char    * content,
+					   long            length,
+					   long          * out_length)
+{
+	unsigned char  * buf = NULL;
+	unsigned int   * tokens = NULL;
+	int            * head = NULL, * prev = NULL;
+	long             n, pos, next_insert, count = 0, iterator, best_bits, stored_bits;
+	int              history_len, lit_freq[286], dist_freq[30], cl_freq[19];
+	unsigned char    lit_lengths[288], dist_lengths[30], cl_lengths[19];
+	unsigned char    fixed_lit[288], fixed_dist[30];
+	unsigned short   lit_codes[288], dist_codes[30], cl_codes[19];
+	unsigned char    cl_syms[286 + 30], cl_extra[286 + 30], seq[286 + 30];
+	int              hlit, hdist, hclen, ncl = 0, block_type;
+	long             fixed_bits, dynamic_bits;
+	noPollDeflateOut out;
+
+	if (deflate == NULL || content == NULL || length <= 0 || length > NOPOLL_DEFLATE_MAX_INPUT)
+		return NULL;
+
+	/* history followed by the message, so both can be matched */
+	history_len = deflate->no_context_takeover ? 0 : deflate->history_len;
+	n      = history_len + length;
+	buf    = nopoll_new (unsigned char, n);
+	tokens = nopoll_new (unsigned int, length);
+	head   = nopoll_new (int, NOPOLL_DEFLATE_HASH_SIZE);
+	prev   = nopoll_new (int, deflate->window_size);
+	if (buf == NULL || tokens == NULL || head == NULL || prev == NULL)
+		goto failed;
+	if (history_len > 0)
+		memcpy (buf, deflate->history, history_len);
+	memcpy (buf + history_len, content, length);
+	memset (head, 0xff, sizeof (int) * NOPOLL_DEFLATE_HASH_SIZE);
+
+	/* LZ77 with one step lazy matching */
+	memset (lit_freq, 0, sizeof (lit_freq));
+	memset (dist_freq, 0, sizeof (dist_freq));
+	next_insert = 0;
+	pos = history_len;
+	while (pos < n) {
+		int  len, dist = 0, len2, dist2 = 0;
+
+		/* insert every position before pos into the chains */
+		for (; next_insert < pos && next_insert + 2 < n; next_insert++) {
+			int h = __NOPOLL_DEFLATE_HASH (buf + next_insert);
+			prev[next_insert & (deflate->window_size - 1)] = head[h];
+			head[h] = next_insert;
+		}
+
+		len = __nopoll_deflate_find_match (buf, n, pos, deflate->window_size, head, prev, &dist);
+		if (len > 0 && len < NOPOLL_DEFLATE_LAZY_MATCH && pos + 1 < n) {
+			if (next_insert == pos && pos + 2 < n) {
+				int h = __NOPOLL_DEFLATE_HASH (buf + pos);
+				prev[pos & (deflate->window_size - 1)] = head[h];
+				head[h] = pos;
+				next_insert++;
+			}
+			len2 = __nopoll_deflate_find_match (buf, n, pos + 1, deflate->window_size, head, prev, &dist2);
+			if (len2 > len) {
+				tokens[count++] = buf[pos];
+				lit_freq[buf[pos]]++;
+				pos++;
+				len  = len2;
+				dist = dist2;
+			}
+		} /* end if */
+
+		if (len > 0) {
+			tokens[count++] = NOPOLL_DEFLATE_MATCH_FLAG | (len << 16) | dist;
+			lit_freq[257 + __nopoll_deflate_len_code (len)]++;
+			dist_freq[__nopoll_deflate_dist_code (dist)]++;
+			pos += len;
+		} else {
+			tokens[count++] = buf[pos];
+			lit_freq[buf[pos]]++;
+			pos++;
+		}
+	} /* end while */
+	lit_freq[256] = 1;
+
+	/* dynamic Huffman codes and their header */
+	__nopoll_deflate_build_lengths (lit_freq, 286, 15, lit_lengths);
+	__nopoll_deflate_build_lengths (dist_freq, 30, 15, dist_lengths);
+	for (hlit = 286; hlit > 257 && lit_lengths[hlit - 1] == 0; hlit--)
+		;
+	for (hdist = 30; hdist > 1 && dist_lengths[hdist - 1] == 0; hdist--)
+		;
+	/* keep one distance code even if unused, an empty distance
+	 * tree is not accepted by every inflater */
+	if (dist_lengths[0] == 0 && hdist == 1)
+		dist_lengths[0] = 1;
+	memcpy (seq, lit_lengths, hlit);
+	memcpy (seq + hlit, dist_lengths, hdist);
+	memset (cl_freq, 0, sizeof (cl_freq));
+	for (iterator = 0; iterator < hlit + hdist; ) {
+		int value = seq[iterator], run = 1;
+		while (iterator + run < hlit + hdist && seq[iterator + run] == value)
+			run++;
+		if (value == 0 && run >= 3) {
+			if (run > 138)
+				run = 138;
+			cl_syms[ncl]    = run <= 10 ? 17 : 18;
+			cl_extra[ncl++] = run <= 10 ? run - 3 : run - 11;
+		} else if (value != 0 && run >= 4) {
+			if (run > 7)
+				run = 7;
+			cl_syms[ncl]    = value;
+			cl_extra[ncl++] = 0;
+			cl_syms[ncl]    = 16;
+			cl_extra[ncl++] = run - 4;
+		} else {
+			run = 1;
+			cl_syms[ncl]    = value;
+			cl_extra[ncl++] = 0;
+		}
+		iterator += run;
+	} /* end for */
+	for (iterator = 0; iterator < ncl; iterator++)
+		cl_freq[cl_syms[iterator]]++;
+	__nopoll_deflate_build_lengths (cl_freq, 19, 7, cl_lengths);
+	for (hclen = 19; hclen > 4 && cl_lengths[__nopoll_deflate_cl_order[hclen - 1]] == 0; hclen--)
+		;
+
+	/* pick the smallest block type */
+	dynamic_bits = 3 + 14 + 3 * hclen + __nopoll_deflate_data_bits (lit_freq, dist_freq, lit_lengths, dist_lengths);
+	for (iterator = 0; iterator < 19; iterator++)
+		dynamic_bits += (long) cl_freq[iterator] * cl_lengths[iterator];
+	dynamic_bits += 2 * cl_freq[16] + 3 * cl_freq[17] + 7 * cl_freq[18];
+	__nopoll_deflate_fixed_lengths (fixed_lit, fixed_dist);
+	fixed_bits = 3 + __nopoll_deflate_data_bits (lit_freq, dist_freq, fixed_lit, fixed_dist);
+	stored_bits = (length / 65535 + 1) * 40 + 8 * length;
+	block_type = 2;
+	best_bits  = dynamic_bits;
+	if (fixed_bits < best_bits) {
+		block_type = 1;
+		best_bits  = fixed_bits;
+	}
+	if (stored_bits < best_bits) {
+		block_type = 0;
+		best_bits  = stored_bits;
+	}
+
+	/* empty stored block for the flush: 3 bits plus padding, its
+	 * 0x00 0x00 0xff 0xff tail is not sent */
+	*out_length = (best_bits + 7) / 8 + 1;
+	if (*out_length >= length)
+		goto failed;
+	memset (&out, 0, sizeof (out));
+	out.data = (unsigned char *) nopoll_new (char, *out_length + 8);
+	if (out.data == NULL)
+		goto failed;
+
+	if (block_type == 2) {
+		__nopoll_deflate_put_bits (&out, 2 << 1, 3);
+		__nopoll_deflate_put_bits (&out, hlit - 257, 5);
+		__nopoll_deflate_put_bits (&out, hdist - 1, 5);
+		__nopoll_deflate_put_bits (&out, hclen - 4, 4);
+		for (iterator = 0; iterator < hclen; iterator++)
+			__nopoll_deflate_put_bits (&out, cl_lengths[__nopoll_deflate_cl_order[iterator]], 3);
+		__nopoll_deflate_build_codes (cl_lengths, 19, cl_codes);
+		for (iterator = 0; iterator < ncl; iterator++) {
+			int sym = cl_syms[iterator];
+			__nopoll_deflate_put_bits (&out, cl_codes[sym], cl_lengths[sym]);
+			if (sym >= 16)
+				__nopoll_deflate_put_bits (&out, cl_extra[iterator], sym == 16 ? 2 : sym == 17 ? 3 : 7);
+		}
+		__nopoll_deflate_build_codes (lit_lengths, 286, lit_codes);
+		__nopoll_deflate_build_codes (dist_lengths, 30, dist_codes);
+		__nopoll_deflate_write_tokens (&out, tokens, count, lit_lengths, lit_codes, dist_lengths, dist_codes);
+	} else if (block_type == 1) {
+		__nopoll_deflate_put_bits (&out, 1 << 1, 3);
+		__nopoll_deflate_build_codes (fixed_lit, 288, lit_codes);
+		__nopoll_deflate_build_codes (fixed_dist, 30, dist_codes);
+		__nopoll_deflate_write_tokens (&out, tokens, count, fixed_lit, lit_codes, fixed_dist, dist_codes);
+	} else {
+		for (iterator = 0; iterator < length; iterator += 65535) {
+			long chunk = length - iterator < 65535 ? length - iterator : 65535;
+			__nopoll_deflate_put_bits (&out, 0, 3);
+			__nopoll_deflate_align (&out);
+			__nopoll_deflate_put_bits (&out, chunk, 16);
+			__nopoll_deflate_put_bits (&out, ~chunk & 0xffff, 16);
+			memcpy (out.data + out.pos, content + iterator, chunk);
+			out.pos += chunk;
+		}
+	}
+	__nopoll_deflate_put_bits (&out, 0, 3);
+	__nopoll_deflate_align (&out);
+	*out_length = out.pos;
+
+	/* slide the window over the message just compressed */
+	if (! deflate->no_context_takeover) {
+		int keep = n < deflate->window_size ? n : deflate->window_size;
+		memcpy (deflate->history, buf + n - keep, keep);
+		deflate->history_len = keep;
+	} /* end if */
+
+	nopoll_free (buf);
+	nopoll_free (tokens);
+	nopoll_free (head);
+	nopoll_free (prev);
+	return (char *) out.data;
+
+failed:
+	nopoll_free (buf);
+	nopoll_free (tokens);
+	nopoll_free (head);
+	nopoll_free (prev);
+	return NULL;
+}
+
+/*** decompressor ***/
+
+typedef struct _noPollInflateHuffman {
+	short count[16];
+	short symbol[288];
+} noPollInflateHuffman;
+
+typedef struct _noPollInflate {
+	const unsigned char * in;
+	long                  in_length;
+	long                  in_pos;
+	unsigned int          bit_buf;
+	int                   bit_count;
+	nopoll_bool           failed;
+
+	unsigned char       * out;
+	long                  out_length;
+	long                  out_size;
+	long                  out_limit;
+} noPollInflate;
+
+static int __nopoll_inflate_bits (noPollInflate * s, int need)
+{
+	/* 0x00 0x00 0xff 0xff removed by the sender */
+	static const unsigned char tail[4] = {0x00, 0x00, 0xff, 0xff};
+	unsigned int value = s->bit_buf;
+
+	while (s->bit_count < need) {
+		unsigned int byte = 0;
+		if (s->in_pos < s->in_length)
+			byte = s->in[s->in_pos];
+		else if (s->in_pos < s->in_length + 4)
+			byte = tail[s->in_pos - s->in_length];
+		else
+			s->failed = nopoll_true;
+		s->in_pos++;
+		value |= byte << s->bit_count;
+		s->bit_count += 8;
+	} /* end while */
+
+	s->bit_buf    = need < 32 ? value >> need : 0;
+	s->bit_count -= need;
+	return value & ((1u << need) - 1);
+}
+
+static nopoll_bool __nopoll_inflate_out (noPollInflate * s, long count)
+{
+	long            size;
+	unsigned char * out;
+	if (s->out_length + count <= s->out_size)
+		return nopoll_true;
+	if (s->out_length + count > s->out_limit) {
+		s->failed = nopoll_true;
+		return nopoll_false;
+	}
+	size = s->out_size * 2;
+	while (size < s->out_length + count)
+		size *= 2;
+	if (size > s->out_limit)
+		size = s->out_limit;
+	/* keep the old buffer on failure, the caller still owns it */
+	out = (unsigned char *) nopoll_realloc (s->out, size);
+	if (out == NULL) {
+		s->failed = nopoll_true;
+		return nopoll_false;
+	}
+	s->out      = out;
+	s->out_size = size;
+	return nopoll_true;
+}
+
+static int __nopoll_inflate_construct (noPollInflateHuffman * h, const unsigned char * lengths, int count)
+{
+	short offs[16];
+	int   iterator, left = 1;
+
+	memset (h->count, 0, sizeof (h->count));
+	for (iterator = 0; iterator < count; iterator++)
+		h->count[lengths[iterator]]++;
+	if (h->count[0] == count)
+		return 0;
+	for (iterator = 1; iterator < 16; iterator++) {
+		left <<= 1;
+		left -= h->count[iterator];
+		if (left < 0)
+			return -1; /* over subscribed */
+	}
+	offs[1] = 0;
+	for (iterator = 1; iterator < 15; iterator++)
+		offs[iterator + 1] = offs[iterator] + h->count[iterator];
+	for (iterator = 0; iterator < count; iterator++) {
+		if (lengths[iterator] != 0)
+			h->symbol[offs[lengths[iterator]]++] = iterator;
+	}
+	return left;
+}
+
+static int __nopoll_inflate_decode (noPollInflate * s, const noPollInflateHuffman * h)
+{
+	int code = 0, first = 0, index = 0, len, count;
+
+	for (len = 1; len < 16; len++) {
+		code |= __nopoll_inflate_bits (s, 1);
+		count = h->count[len];
+		if (code - count < first)
+			return h->symbol[index + (code - first)];
+		index += count;
+		first += count;
+		first <<= 1;
+		code  <<= 1;
+	}
+	return -1;
+}
+
+static nopoll_bool __nopoll_inflate_stored (noPollInflate * s)
+{
+	unsigned int len, nlen;
+
+	/* discard the remaining bits of the current byte */
+	s->bit_buf   = 0;
+	s->bit_count = 0;
+	len  = __nopoll_inflate_bits (s, 16);
+	nlen = __nopoll_inflate_bits (s, 16);
+	if (s->failed || len != (~nlen & 0xffff))
+		return nopoll_false;
+	if (! __nopoll_inflate_out (s, len))
+		return nopoll_false;
+	while (len-- > 0)
+		s->out[s->out_length++] = __nopoll_inflate_bits (s, 8);
+	return ! s->failed;
+}
+
+static nopoll_bool __nopoll_inflate_codes (noPollInflate * s, const noPollInflateHuffman * lencode, const noPollInflateHuffman * distcode)
+{
+	int symbol, len;
+	long dist;
+
+	while (! s->failed) {
+		symbol = __nopoll_inflate_decode (s, lencode);
+		if (symbol < 0)
+			return nopoll_false;
+		if (symbol < 256) {
+			if (! __nopoll_inflate_out (s, 1))
+				return nopoll_false;
+			s->out[s->out_length++] = symbol;
+			continue;
+		}
+		if (symbol == 256)
+			return nopoll_true;
+
+		symbol -= 257;
+		if (symbol >= 29)
+			return nopoll_false;
+		len = __nopoll_deflate_len_base[symbol] + __nopoll_inflate_bits (s, __nopoll_deflate_len_extra[symbol]);
+		symbol = __nopoll_inflate_decode (s, distcode);
+		if (symbol < 0 || symbol >= 30)
+			return nopoll_false;
+		dist = __nopoll_deflate_dist_base[symbol] + __nopoll_inflate_bits (s, __nopoll_deflate_dist_extra[symbol]);
+		if (dist > s->out_length || ! __nopoll_inflate_out (s, len))
+			return nopoll_false;
+		while (len-- > 0) {
+			s->out[s->out_length] = s->out[s->out_length - dist];
+			s->out_length++;
+		}
+	} /* end while */
+	return nopoll_false;
+}
+
+static nopoll_bool __nopoll_inflate_dynamic (noPollInflate * s, noPollInflateHuffman * lencode, noPollInflateHuffman * distcode)
+{
+	unsigned char lengths[286 + 30];
+	int nlen, ndist, ncode, index, symbol, len;
+
+	nlen  = __nopoll_inflate_bits (s, 5) + 257;
+	ndist = __nopoll_inflate_bits (s, 5) + 1;
+	ncode = __nopoll_inflate_bits (s, 4) + 4;
+	if (nlen > 286 || ndist > 30)
+		return nopoll_false;
+
+	memset (lengths, 0, sizeof (lengths));
+	for (index = 0; index < ncode; index++)
+		lengths[__nopoll_deflate_cl_order[index]] = __nopoll_inflate_bits (s, 3);
+	if (__nopoll_inflate_construct (lencode, lengths, 19) != 0)
+		return nopoll_false; /* code length codes must be complete */
+
+	for (index = 0; index < nlen + ndist; ) {
+		symbol = __nopoll_inflate_decode (s, lencode);
+		if (symbol < 0 || s->failed)
+			return nopoll_false;
+		if (symbol < 16) {
+			lengths[index++] = symbol;
+			continue;
+		}
+		len = 0;
+		if (symbol == 16) {
+			if (index == 0)
+				return nopoll_false;
+			len = lengths[index - 1];
+			symbol = 3 + __nopoll_inflate_bits (s, 2);
+		} else if (symbol == 17) {
+			symbol = 3 + __nopoll_inflate_bits (s, 3);
+		} else {
+			symbol = 11 + __nopoll_inflate_bits (s, 7);
+		}
+		if (index + symbol > nlen + ndist)
+			return nopoll_false;
+		while (symbol-- > 0)
+			lengths[index++] = len;
+	} /* end for */
+
+	if (lengths[256] == 0)
+		return nopoll_false;
+	if (__nopoll_inflate_construct (lencode, lengths, nlen) < 0)
+		return nopoll_false;
+	if (__nopoll_inflate_construct (distcode, lengths + nlen, ndist) < 0)
+		return nopoll_false;
+	return __nopoll_inflate_codes (s, lencode, distcode);
+}
+
+/**
+ * @internal Decompresses a message compressed by the peer, its
+ * removed 0x00 0x00 0xff 0xff tail is added back here.
+ *
+ * @return A newly allocated, NUL terminated buffer with the message,
+ * or NULL if the data is not valid DEFLATE or it inflates beyond the
+ * allowed size.
+ */
+char          * __nopoll_deflate_decompress (noPollDeflate * deflate,
+					     const char    * content,
+					     long            length,
+					     long          * out_length)
+{
+	noPollInflate          s;
+	noPollInflateHuffman * lencode, * distcode;
+	unsigned char          lengths[288 + 30];
+	int                    history_len, last, type;
+	nopoll_bool            ok = nopoll_true;
+	char                 * result = NULL;
+
+	if (deflate == NULL || content == NULL || length < 0)
+		return NULL;
+
+	lencode  = nopoll_new (noPollInflateHuffman, 2);
+	if (lencode == NULL)
+		return NULL;
+	distcode = lencode + 1;
+
+	/* back references may reach into previous messages: output is
+	 * produced after the history */
+	history_len = deflate->peer_no_context_takeover ? 0 : deflate->peer_history_len;
+	memset (&s, 0, sizeof (s));
+	s.in         = (const unsigned char *) content;
+	s.in_length  = length;
+	s.out_limit  = history_len + NOPOLL_INFLATE_MAX_OUTPUT;
+	s.out_size   = history_len + (length < 256 ? 1024 : length * 4);
+	if (s.out_size > s.out_limit)
+		s.out_size = s.out_limit;
+	s.out        = nopoll_new (unsigned char, s.out_size);
+	if (s.out == NULL) {
+		nopoll_free (lencode);
+		return NULL;
+	}
+	if (history_len > 0)
+		memcpy (s.out, deflate->peer_history, history_len);
+	s.out_length = history_len;
+
+	do {
+		last = __nopoll_inflate_bits (&s, 1);
+		type = __nopoll_inflate_bits (&s, 2);
+		if (type == 0) {
+			ok = __nopoll_inflate_stored (&s);
+		} else if (type == 1) {
+			__nopoll_deflate_fixed_lengths (lengths, lengths + 288);
+			__nopoll_inflate_construct (lencode, lengths, 288);
+			__nopoll_inflate_construct (distcode, lengths + 288, 30);
+			ok = __nopoll_inflate_codes (&s, lencode, distcode);
+		} else if (type == 2) {
+			ok = __nopoll_inflate_dynamic (&s, lencode, distcode);
+		} else {
+			ok = nopoll_false;
+		}
+	} while (ok && ! s.failed && ! last && s.in_pos < s.in_length + 4);
+
+	if (ok && ! s.failed) {
+		*out_length = s.out_length - history_len;
+		result = nopoll_new (char, *out_length + 1);
+		if (result != NULL) {
+			memcpy (result, s.out + history_len, *out_length);
+			result[*out_length] = 0;
+
+			if (! deflate->peer_no_context_takeover) {
+				long keep = s.out_length < deflate->peer_window_size ? s.out_length : deflate->peer_window_size;
+				memcpy (deflate->peer_history, s.out + s.out_length - keep, keep);
+				deflate->peer_history_len = keep;
+			} /* end if */
+		} /* end if */
+	} /* end if */
+
+	nopoll_free (s.out);
+	nopoll_free (lencode);
+	return result;
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __NOPOLL_DEFLATE_H__
+#define __NOPOLL_DEFLATE_H__
+
+#include "nopoll_namespace.h"
+#include "nopoll.h"
+
+BEGIN_C_DECLS
+
+noPollDeflate * __nopoll_deflate_new (int         window_bits,
+				      nopoll_bool no_context_takeover,
+				      int         peer_window_bits,
+				      nopoll_bool peer_no_context_takeover);
+
+char          * __nopoll_deflate_compress (noPollDeflate * deflate,
+					   const char    * content,
+					   long            length,
+					   long          * out_length);
+
+char          * __nopoll_deflate_decompress (noPollDeflate * deflate,
+					     const char    * content,
+					     long            length,
+					     long          * out_length);
+
+void            __nopoll_deflate_free (noPollDeflate * deflate);
+
+END_C_DECLS
+
+#endif
@@ -44,6 +44,7 @@
 //  3. Add sysutils support, because sysutils has osal layer, we don't need
 //     to care about platform dependent
 //  4. Add lwip support
+//  5. Drain frames left in the connection read-ahead buffer
 #include "nopoll_loop.h"
 #include "nopoll_private.h"
 
@@ -91,20 +92,28 @@ nopoll_bool nopoll_loop_register (noPollCtx * ctx, noPollConn * conn, noPollPtr
 void nopoll_loop_process_data (noPollCtx * ctx, noPollConn * conn)
 {
 	noPollMsg * msg;
-
-	/* call to get messages from the connection */
-	msg = nopoll_conn_get_msg (conn);
-	if (msg == NULL)
-		return;
-
-	/* found message, notify it */
-	if (conn->on_msg)
-		conn->on_msg (ctx, conn, msg, conn->on_msg_data);
-	else if (ctx->on_msg)
-		ctx->on_msg (ctx, conn, msg, ctx->on_msg_data);
-
-	/* release message */
-	nopoll_msg_unref (msg);
+	int         pending;
+
+	/* frames already in the read-ahead buffer will not be
+	 * reported by the socket, so keep going until it is drained
+	 * or a call makes no progress (partial frame left) */
+	do {
+		/* call to get messages from the connection */
+		pending = nopoll_conn_recv_pending (conn);
+		msg = nopoll_conn_get_msg (conn);
+		if (msg == NULL)
+			continue;
+
+		/* found message, notify it */
+		if (conn->on_msg)
+			conn->on_msg (ctx, conn, msg, conn->on_msg_data);
+		else if (ctx->on_msg)
+			ctx->on_msg (ctx, conn, msg, ctx->on_msg_data);
+
+		/* release message */
+		nopoll_msg_unref (msg);
+	} while (nopoll_conn_is_ok (conn) && nopoll_conn_recv_pending (conn) > 0 &&
+		 (msg != NULL || nopoll_conn_recv_pending (conn) != pending));
 	return;
 }
 
@@ -44,7 +44,9 @@
 //  3. Add sysutils support, because sysutils has osal layer, we don't need
 //     to care about platform dependent
 //  4. Add lwip support
+//  5. Release receive buffer views, see nopoll_conn.c
 #include "nopoll_msg.h"
+#include "nopoll_conn.h"
 #include "nopoll_private.h"
 
 /**
@@ -316,8 +318,11 @@ void         nopoll_msg_unref (noPollMsg * msg)
 	nopoll_mutex_unlock (msg->ref_mutex);
 	nopoll_mutex_destroy (msg->ref_mutex);
 
-	/* free websocket message */
-	nopoll_free (msg->payload);
+	/* free websocket message, views only drop their block reference */
+	if (msg->payload_owner)
+		__nopoll_conn_buffer_unref (msg->payload_owner);
+	else
+		nopoll_free (msg->payload);
 	nopoll_free (msg);
 
 	/* release mutex here */
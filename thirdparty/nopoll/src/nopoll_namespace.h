@@ -18,8 +18,11 @@
 #endif
 
 #define __nopoll_conn_accept_complete_common                NOPOLL_NAMESPACE(__nopoll_conn_accept_complete_common)
+#define __nopoll_conn_buffer_ref                            NOPOLL_NAMESPACE(__nopoll_conn_buffer_ref)
+#define __nopoll_conn_buffer_unref                          NOPOLL_NAMESPACE(__nopoll_conn_buffer_unref)
 #define __nopoll_conn_call_on_ready_if_defined              NOPOLL_NAMESPACE(__nopoll_conn_call_on_ready_if_defined)
 #define __nopoll_conn_complete_pending_write_reduce_header  NOPOLL_NAMESPACE(__nopoll_conn_complete_pending_write_reduce_header)
+#define __nopoll_conn_deflate_accept                        NOPOLL_NAMESPACE(__nopoll_conn_deflate_accept)
 #define __nopoll_conn_get_client_init                       NOPOLL_NAMESPACE(__nopoll_conn_get_client_init)
 #define __nopoll_conn_get_ssl_context                       NOPOLL_NAMESPACE(__nopoll_conn_get_ssl_context)
 #define __nopoll_conn_new_common                            NOPOLL_NAMESPACE(__nopoll_conn_new_common)
@@ -33,6 +36,10 @@
 #define __nopoll_conn_ssl_verify_callback                   NOPOLL_NAMESPACE(__nopoll_conn_ssl_verify_callback)
 #define __nopoll_conn_tls_handle_error                      NOPOLL_NAMESPACE(__nopoll_conn_tls_handle_error)
 #define __nopoll_ctx_sigpipe_do_nothing                     NOPOLL_NAMESPACE(__nopoll_ctx_sigpipe_do_nothing)
+#define __nopoll_deflate_compress                           NOPOLL_NAMESPACE(__nopoll_deflate_compress)
+#define __nopoll_deflate_decompress                         NOPOLL_NAMESPACE(__nopoll_deflate_decompress)
+#define __nopoll_deflate_free                               NOPOLL_NAMESPACE(__nopoll_deflate_free)
+#define __nopoll_deflate_new                                NOPOLL_NAMESPACE(__nopoll_deflate_new)
 #define __nopoll_listener_new_opts_internal                 NOPOLL_NAMESPACE(__nopoll_listener_new_opts_internal)
 #define __nopoll_listener_sock_listen_internal              NOPOLL_NAMESPACE(__nopoll_listener_sock_listen_internal)
 #define __nopoll_listener_tls_new_opts_internal             NOPOLL_NAMESPACE(__nopoll_listener_tls_new_opts_internal)
@@ -70,6 +77,7 @@
 #define nopoll_conn_get_close_status                        NOPOLL_NAMESPACE(nopoll_conn_get_close_status)
 #define nopoll_conn_get_connect_timeout                     NOPOLL_NAMESPACE(nopoll_conn_get_connect_timeout)
 #define nopoll_conn_get_cookie                              NOPOLL_NAMESPACE(nopoll_conn_get_cookie)
+#define nopoll_conn_get_deflate_stats                       NOPOLL_NAMESPACE(nopoll_conn_get_deflate_stats)
 #define nopoll_conn_get_hook                                NOPOLL_NAMESPACE(nopoll_conn_get_hook)
 #define nopoll_conn_get_host_header                         NOPOLL_NAMESPACE(nopoll_conn_get_host_header)
 #define nopoll_conn_get_http_url                            NOPOLL_NAMESPACE(nopoll_conn_get_http_url)
@@ -78,8 +86,10 @@
 #define nopoll_conn_get_mime_header                         NOPOLL_NAMESPACE(nopoll_conn_get_mime_header)
 #define nopoll_conn_get_msg                                 NOPOLL_NAMESPACE(nopoll_conn_get_msg)
 #define nopoll_conn_get_origin                              NOPOLL_NAMESPACE(nopoll_conn_get_origin)
+#define nopoll_conn_get_recv_stats                          NOPOLL_NAMESPACE(nopoll_conn_get_recv_stats)
 #define nopoll_conn_get_requested_protocol                  NOPOLL_NAMESPACE(nopoll_conn_get_requested_protocol)
 #define nopoll_conn_get_requested_url                       NOPOLL_NAMESPACE(nopoll_conn_get_requested_url)
+#define nopoll_conn_get_send_stats                          NOPOLL_NAMESPACE(nopoll_conn_get_send_stats)
 #define nopoll_conn_host                                    NOPOLL_NAMESPACE(nopoll_conn_host)
 #define nopoll_conn_is_ok                                   NOPOLL_NAMESPACE(nopoll_conn_is_ok)
 #define nopoll_conn_is_ready                                NOPOLL_NAMESPACE(nopoll_conn_is_ready)
@@ -91,12 +101,14 @@
 #define nopoll_conn_new_opts                                NOPOLL_NAMESPACE(nopoll_conn_new_opts)
 #define nopoll_conn_new_with_socket                         NOPOLL_NAMESPACE(nopoll_conn_new_with_socket)
 #define nopoll_conn_opts_add_origin_header                  NOPOLL_NAMESPACE(nopoll_conn_opts_add_origin_header)
+#define nopoll_conn_opts_clear_ssl_session                  NOPOLL_NAMESPACE(nopoll_conn_opts_clear_ssl_session)
 #define nopoll_conn_opts_free                               NOPOLL_NAMESPACE(nopoll_conn_opts_free)
 #define nopoll_conn_opts_new                                NOPOLL_NAMESPACE(nopoll_conn_opts_new)
 #define nopoll_conn_opts_ref                                NOPOLL_NAMESPACE(nopoll_conn_opts_ref)
 #define nopoll_conn_opts_set_cookie                         NOPOLL_NAMESPACE(nopoll_conn_opts_set_cookie)
 #define nopoll_conn_opts_set_extra_headers                  NOPOLL_NAMESPACE(nopoll_conn_opts_set_extra_headers)
 #define nopoll_conn_opts_set_interface                      NOPOLL_NAMESPACE(nopoll_conn_opts_set_interface)
+#define nopoll_conn_opts_set_permessage_deflate             NOPOLL_NAMESPACE(nopoll_conn_opts_set_permessage_deflate)
 #define nopoll_conn_opts_set_reuse                          NOPOLL_NAMESPACE(nopoll_conn_opts_set_reuse)
 #define nopoll_conn_opts_set_ssl_certs                      NOPOLL_NAMESPACE(nopoll_conn_opts_set_ssl_certs)
 #define nopoll_conn_opts_set_ssl_protocol                   NOPOLL_NAMESPACE(nopoll_conn_opts_set_ssl_protocol)
@@ -109,6 +121,7 @@
 #define nopoll_conn_read                                    NOPOLL_NAMESPACE(nopoll_conn_read)
 #define nopoll_conn_read_pending                            NOPOLL_NAMESPACE(nopoll_conn_read_pending)
 #define nopoll_conn_readline                                NOPOLL_NAMESPACE(nopoll_conn_readline)
+#define nopoll_conn_recv_pending                            NOPOLL_NAMESPACE(nopoll_conn_recv_pending)
 #define nopoll_conn_ref                                     NOPOLL_NAMESPACE(nopoll_conn_ref)
 #define nopoll_conn_ref_count                               NOPOLL_NAMESPACE(nopoll_conn_ref_count)
 #define nopoll_conn_role                                    NOPOLL_NAMESPACE(nopoll_conn_role)
@@ -339,6 +339,50 @@ struct _noPollConn {
 	char             pending_buf[100];
 	int              pending_buf_bytes;
 
+	/**
+	 * @internal Read-ahead buffer: frames are parsed out of large
+	 * reads instead of issuing one read per header field and
+	 * payload. Complete binary payloads are handed out as views
+	 * into this block (see noPollBuffer).
+	 */
+	noPollBuffer        * read_buf;
+	int                   read_buf_pos;
+	int                   read_buf_len;
+	/* op code of the fragmented message being received, used to
+	 * know the type of continuation frames */
+	short                 fragment_op_code;
+
+	/* receive statistics, see nopoll_conn_get_recv_stats */
+	long                  recv_reads;
+	long                  recv_frames;
+	long                  recv_views;
+	long                  recv_bytes;
+
+	/* send statistics, see nopoll_conn_get_send_stats */
+	long                  send_writes;
+	long                  send_frames;
+	long                  send_bytes;
+
+	/**
+	 * @internal permessage-deflate state, set when the extension
+	 * was negotiated during the handshake.
+	 */
+	noPollDeflate       * deflate;
+	/* window bits offered by the client, 0 if not offered */
+	int                   deflate_offer_bits;
+	/* the message being received is compressed (RSV1 on its first
+	 * frame); its fragments are collected on inflate_buf */
+	nopoll_bool           inflate_msg;
+	char                * inflate_buf;
+	long                  inflate_buf_len;
+	long                  inflate_buf_size;
+
+	/* deflate statistics, see nopoll_conn_get_deflate_stats */
+	long                  deflate_sent_raw;
+	long                  deflate_sent_wire;
+	long                  deflate_recv_raw;
+	long                  deflate_recv_wire;
+
 	/**
 	 * @internal Support for an user defined pointer.
 	 */
@@ -398,6 +442,18 @@ struct _noPollIoEngine {
 	noPollIoMechIsSet      is_set;
 };
 
+/**
+ * @internal Reference counted receive block. A message whose payload
+ * is a view into the block holds a reference, so the connection only
+ * reuses the block once every such message was released.
+ */
+struct _noPollBuffer {
+	int            refs;
+	noPollPtr      ref_mutex;
+	int            size;
+	char         * data;
+};
+
 struct _noPollMsg {
 	nopoll_bool    has_fin;
 	short          op_code;
@@ -405,6 +461,8 @@ struct _noPollMsg {
 
 	noPollPtr      payload;
 	long int       payload_size;
+	/* block owning payload when it is a view (not to be freed) */
+	noPollBuffer * payload_owner;
 
 	int            refs;
 	noPollPtr      ref_mutex;
@@ -431,6 +489,23 @@ struct _noPollHandshake {
 
 	/* reference to cookie header */
 	char          * cookie;
+
+	/* reference to Sec-WebSocket-Extensions header */
+	char          * websocket_extensions;
+};
+
+struct _noPollDeflate {
+	/* compression of outgoing messages */
+	int             window_size;
+	nopoll_bool     no_context_takeover;
+	unsigned char * history;
+	int             history_len;
+
+	/* decompression of incoming messages */
+	int             peer_window_size;
+	nopoll_bool     peer_no_context_takeover;
+	unsigned char * peer_history;
+	int             peer_history_len;
 };
 
 struct _noPollConnOpts {
@@ -456,6 +531,14 @@ struct _noPollConnOpts {
 	int    private_key_size;
 	int    chain_certificate_size;
 	int    ca_certificate_size;
+
+	/* TLS state kept by reused options across connections: the
+	 * parsed CA chain and the last session, offered to the server
+	 * for resumption (session ticket or session id) */
+	mbedtls_x509_crt     ssl_ca_chain;
+	nopoll_bool          ssl_ca_chain_parsed;
+	mbedtls_ssl_session  ssl_session;
+	nopoll_bool          ssl_session_valid;
 #endif
 
 	nopoll_bool  disable_ssl_verify;
@@ -475,6 +558,10 @@ struct _noPollConnOpts {
 	/* control whether origin header is added or not (see
 	 * nopoll_conn_opts_add_origin_header) */
 	nopoll_bool add_origin_header;
+
+	/* permessage-deflate window bits offered, 0 to disable (see
+	 * nopoll_conn_opts_set_permessage_deflate) */
+	int         deflate_window_bits;
 };
 
 #endif
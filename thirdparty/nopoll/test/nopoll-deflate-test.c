@@ -0,0 +1,202 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "osal/os_time.h"
+#include "cutils/log_helper.h"
+#include "cutils/memory_helper.h"
+#include "nopoll.h"
+#include "nopoll_deflate.h"
+#include "GenieProtocol.h"
+
+#define TAG "nopoll_deflate"
+
+#define FUZZ_ROUNDS         3000
+#define FUZZ_MAX_SIZE       (20*1024)
+#define SESSION_ROUNDS      50
+
+// Compresses with one end and inflates with the other, as a client
+// and a server sharing the negotiated parameters would
+static int roundtrip(noPollDeflate *sender, noPollDeflate *receiver, const char *msg, long len,
+                     long *raw_bytes, long *wire_bytes)
+{
+    long out_len = 0, inflated_len = 0;
+    char *out = __nopoll_deflate_compress(sender, msg, len, &out_len);
+    if (out == NULL) {
+        // not worth compressing, sent as it is
+        *raw_bytes += len;
+        *wire_bytes += len;
+        return 0;
+    }
+    char *inflated = __nopoll_deflate_decompress(receiver, out, out_len, &inflated_len);
+    int ret = (inflated != NULL && inflated_len == len && memcmp(inflated, msg, len) == 0) ? 0 : -1;
+    *raw_bytes += len;
+    *wire_bytes += out_len;
+    nopoll_free(out);
+    nopoll_free(inflated);
+    return ret;
+}
+
+static void random_message(char *buffer, long len)
+{
+    static const char *words[] = {
+        "\"audioUrl\":", "\"payload\":{", "AliGenie.", "}", ",", "https://", "Speak", "0123", "\"status\":\"normal\"",
+    };
+    int kind = rand() % 3;
+    long pos = 0;
+    while (pos < len) {
+        if (kind == 0) {
+            buffer[pos++] = (char)rand();
+        } else if (kind == 1) {
+            buffer[pos++] = "ab"[rand() % 2];
+        } else {
+            const char *word = words[rand() % (sizeof(words)/sizeof(words[0]))];
+            for (int i = 0; word[i] != 0 && pos < len; i++)
+                buffer[pos++] = word[i];
+        }
+    }
+}
+
+static int fuzz_roundtrip()
+{
+    static char message[FUZZ_MAX_SIZE];
+    int window_bits[] = { 8, 9, 11, 15 };
+
+    srand(0x64656631);
+    for (int w = 0; w < sizeof(window_bits)/sizeof(window_bits[0]); w++) {
+        for (int no_context = 0; no_context < 2; no_context++) {
+            noPollDeflate *client = __nopoll_deflate_new(window_bits[w], no_context, window_bits[w], no_context);
+            noPollDeflate *server = __nopoll_deflate_new(window_bits[w], no_context, window_bits[w], no_context);
+            long raw = 0, wire = 0;
+            if (client == NULL || server == NULL) {
+                OS_LOGE(TAG, "Failed to create deflate state, window_bits=%d", window_bits[w]);
+                return -1;
+            }
+            for (int round = 0; round < FUZZ_ROUNDS; round++) {
+                long len = 1 + rand() % (round % 10 == 0 ? FUZZ_MAX_SIZE : 600);
+                random_message(message, len);
+                if (roundtrip(client, server, message, len, &raw, &wire) != 0) {
+                    OS_LOGE(TAG, "Mismatch: window_bits=%d, no_context=%d, round=%d, len=%ld",
+                            window_bits[w], no_context, round, len);
+                    return -1;
+                }
+            }
+            __nopoll_deflate_free(client);
+            __nopoll_deflate_free(server);
+        }
+    }
+
+    // corrupted input must fail cleanly
+    noPollDeflate *receiver = __nopoll_deflate_new(11, nopoll_true, 11, nopoll_true);
+    for (int round = 0; round < FUZZ_ROUNDS; round++) {
+        long len = rand() % 200, inflated_len = 0;
+        for (long i = 0; i < len; i++)
+            message[i] = (char)rand();
+        char *inflated = __nopoll_deflate_decompress(receiver, message, len, &inflated_len);
+        nopoll_free(inflated);
+    }
+    __nopoll_deflate_free(receiver);
+
+    OS_LOGI(TAG, "fuzz: %d rounds passed", FUZZ_ROUNDS);
+    return 0;
+}
+
+// Gateway commands as received by GnWebsocket_OnReceivedText
+static char *gateway_command(int round, int index)
+{
+    static const char *formats[] = {
+        "{\"commandDomain\":\"AliGenie.Microphone\",\"commandName\":\"StopListen\",\"payload\":{\"recordId\":\"20220318103005_%08x\"}}",
+        "{\"commandDomain\":\"AliGenie.Speaker\",\"commandName\":\"Speak\",\"payload\":{\"audioUrl\":\"https://ailabs-tts.alicdn.com/tts/%08x.mp3?auth_key=1647570605-0-0-6f1f2b0e5d9a4c1b8e7d3a2f1c0b9a8e\",\"audioAnchor\":\"\",\"audioExt\":\"{\\\"ttsText\\\":\\\"Sunny today, 18 to 26 degrees\\\"}\",\"audioId\":\"tts\",\"audioName\":\"\",\"audioType\":\"tts\",\"audioAlbum\":\"\",\"audioSource\":\"tts\",\"audioLength\":3200,\"progress\":0}}",
+        "{\"commandDomain\":\"AliGenie.Audio\",\"commandName\":\"Play\",\"payload\":{\"audioUrl\":\"https://ailabs-media.alicdn.com/music/%08x.mp3?auth_key=1647570605-0-0-0a1b2c3d4e5f60718293a4b5c6d7e8f9\",\"audioAnchor\":\"\",\"audioExt\":\"{\\\"singer\\\":\\\"Jay Chou\\\",\\\"quality\\\":\\\"standard\\\"}\",\"audioId\":\"1769490417\",\"audioName\":\"Nocturne\",\"audioType\":\"music\",\"audioAlbum\":\"November's Chopin\",\"audioSource\":\"xiami\",\"audioLength\":226000,\"progress\":0}}",
+        "{\"commandDomain\":\"AliGenie.System\",\"commandName\":\"Success\",\"payload\":{\"requestId\":\"%08x\"}}",
+    };
+    return nopoll_strdup_printf(formats[index], round * 7919 + index);
+}
+
+// Replays the text messages of a typical session (state sync, then
+// wake-ups each producing events up and commands down); binary audio
+// frames are left out since they are never compressed
+static int measure_session(int window_bits, nopoll_bool no_context)
+{
+    noPollDeflate *client = __nopoll_deflate_new(window_bits, no_context, window_bits, no_context);
+    noPollDeflate *server = __nopoll_deflate_new(window_bits, no_context, window_bits, no_context);
+    const char *uuid = "9f5e0c0a3b6c4d1e8a2f7b3c1d0e9f8a";
+    const char *token = "a7c3e1f9b5d2046e8c1a3f5b7d9e0c2a4f6b8d0e";
+    Genie_SpeakerContext_t speaker = { 50, false };
+    Genie_PlayerContext_t player = {
+        GENIE_PLAYER_SOURCE_CLOUD,
+        "https://ailabs-media.alicdn.com/music/1769490417.mp3?auth_key=1647570605-0-0-0a1b2c3d4e5f60718293a4b5c6d7e8f9",
+        "", "{}", "1769490417", "Nocturne", "music", "November's Chopin", "xiami", 0, 226000 };
+    Genie_SpeechContext_t speech = { GENIE_SPEECH_FORMAT_SPEEXOGG, "tianmaojingling", 0, 0.92 };
+    long up_raw = 0, up_wire = 0, down_raw = 0, down_wire = 0;
+    int ret = 0;
+    char *msg;
+
+    // event builders need it to be called once
+    msg = Genie_Create_GatewayUrl("bizType", "bizGroup", "bizSecret");
+    OS_FREE(msg);
+
+    msg = Genie_Create_StateSyncEvent("bizType", "bizGroup", uuid, token, GENIE_STATESYNC_REASON_START, &speaker, &player);
+    ret |= roundtrip(client, server, msg, strlen(msg), &up_raw, &up_wire);
+    OS_FREE(msg);
+    for (int round = 0; round < SESSION_ROUNDS; round++) {
+        char *events[4];
+        int count = 0;
+        events[count++] = Genie_Create_MicrophoneListenStartedEvent("bizType", "bizGroup", uuid, token, &speech);
+        if (round % 3 == 0) {
+            player.progress = round * 1000;
+            events[count++] = Genie_Create_PlayerSyncEvent("bizType", "bizGroup", uuid, token, GENIE_PLAYERSYNC_REASON_STARTED, &player);
+        } else if (round % 3 == 1) {
+            speaker.volume = round % 100;
+            events[count++] = Genie_Create_SpeakerSyncEvent("bizType", "bizGroup", uuid, token, GENIE_SPEAKERSYNC_REASON_VOLUMECHANGED, &speaker);
+        } else {
+            events[count++] = Genie_Create_TextRecognizeEvent("bizType", "bizGroup", uuid, token, "what is the weather today");
+        }
+        for (int i = 0; i < count; i++) {
+            if (events[i] == NULL)
+                continue;
+            ret |= roundtrip(client, server, events[i], strlen(events[i]), &up_raw, &up_wire);
+            OS_FREE(events[i]);
+        }
+        for (int i = 0; i < 4; i++) {
+            msg = gateway_command(round, i);
+            ret |= roundtrip(server, client, msg, strlen(msg), &down_raw, &down_wire);
+            nopoll_free(msg);
+        }
+    }
+
+    OS_LOGI(TAG, "session: window=%d bits%s, uplink %ld -> %ld bytes (%.0f%%), downlink %ld -> %ld bytes (%.0f%%)",
+            window_bits, no_context ? " (no context takeover)" : "",
+            up_raw, up_wire, 100.0 * up_wire / up_raw, down_raw, down_wire, 100.0 * down_wire / down_raw);
+    __nopoll_deflate_free(client);
+    __nopoll_deflate_free(server);
+    if (ret != 0)
+        OS_LOGE(TAG, "Session mismatch: window=%d bits, no_context=%d", window_bits, no_context);
+    return ret;
+}
+
+int main()
+{
+    int ret = fuzz_roundtrip();
+
+    ret |= measure_session(11, nopoll_false);
+    ret |= measure_session(11, nopoll_true);
+    ret |= measure_session(15, nopoll_false);
+
+    OS_LOGI(TAG, "deflate test %s", ret == 0 ? "passed" : "failed");
+    return ret == 0 ? 0 : 1;
+}
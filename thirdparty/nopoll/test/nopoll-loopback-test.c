@@ -0,0 +1,279 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Loopback test of the read-ahead receive buffer. A listener runs nopoll_loop on a
+// thread, the client:
+//  1. uploads masked binary frames, the server checks every byte;
+//  2. receives 3000 mixed text/binary frames, some larger than the read-ahead block,
+//     holding every 7th message across further reads so that a block still referenced
+//     by a view is handed over, and checks every byte and the text NUL terminators;
+//  3. receives a burst of small frames in one read and drains it with
+//     nopoll_conn_recv_pending while the socket doesn't report anything readable.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+
+#include "osal/os_thread.h"
+#include "cutils/log_helper.h"
+#include "nopoll.h"
+
+#define TAG "nopoll_loopback"
+
+#define TEST_HOST           "127.0.0.1"
+#define TEST_PORT           "17011"
+#define TEST_UPLOAD_FRAMES  200
+#define TEST_FRAMES         3000
+#define TEST_BURST_FRAMES   100
+#define TEST_FRAME_MAX      (24*1024)
+#define TEST_HOLD_EVERY     7
+
+static noPollCtx *sServerCtx;
+static int sServerIndex = 0, sServerOk = 0, sServerBad = 0;
+static char *sServerAcc = NULL;
+static int sServerAccLen = 0;
+
+// every 50th frame is larger than the read-ahead block, read straight into the message
+static int frame_size(int index)
+{
+    return (index * 7919) % 3000 + (index % 50 == 0 ? 20000 : 0) + 1;
+}
+
+static bool frame_is_text(int index)
+{
+    return index % 10 == 3;
+}
+
+static void frame_fill(char *buffer, int size, int index)
+{
+    for (int i = 0; i < size; i++)
+        buffer[i] = (char)(index * 13 + i * 7);
+}
+
+static bool frame_check(const char *buffer, int size, int index)
+{
+    for (int i = 0; i < size; i++) {
+        if (buffer[i] != (char)(index * 13 + i * 7))
+            return false;
+    }
+    return true;
+}
+
+static void server_on_msg(noPollCtx *ctx, noPollConn *conn, noPollMsg *msg, noPollPtr user_data)
+{
+    const char *payload = (const char *)nopoll_msg_get_payload(msg);
+    int size = nopoll_msg_get_payload_size(msg);
+
+    if (nopoll_msg_opcode(msg) == NOPOLL_TEXT_FRAME) {
+        char *buffer = malloc(TEST_FRAME_MAX);
+        if (strcmp(payload, "frames") == 0) {
+            for (int i = 0; i < TEST_FRAMES; i++) {
+                if (frame_is_text(i)) {
+                    snprintf(buffer, TEST_FRAME_MAX, "text-%d", i);
+                    nopoll_conn_send_text(conn, buffer, strlen(buffer));
+                } else {
+                    frame_fill(buffer, frame_size(i), i);
+                    nopoll_conn_send_binary(conn, buffer, frame_size(i));
+                }
+            }
+        } else if (strcmp(payload, "burst") == 0) {
+            for (int i = 0; i < TEST_BURST_FRAMES; i++) {
+                frame_fill(buffer, 20, i);
+                nopoll_conn_send_binary(conn, buffer, 20);
+            }
+        }
+        nopoll_conn_send_text(conn, "end", 3);
+        free(buffer);
+        return;
+    }
+
+    // uploaded frames, possibly split in fragments
+    sServerAcc = realloc(sServerAcc, sServerAccLen + size);
+    memcpy(sServerAcc + sServerAccLen, payload, size);
+    sServerAccLen += size;
+    if (sServerAccLen == frame_size(sServerIndex)) {
+        if (frame_check(sServerAcc, sServerAccLen, sServerIndex))
+            sServerOk++;
+        else
+            sServerBad++;
+        sServerIndex++;
+        sServerAccLen = 0;
+    }
+}
+
+static void *server_entry(void *arg)
+{
+    nopoll_loop_wait(sServerCtx, 0);
+    return NULL;
+}
+
+static noPollMsg *client_wait_msg(noPollConn *conn)
+{
+    noPollMsg *msg;
+    while ((msg = nopoll_conn_get_msg(conn)) == NULL) {
+        if (!nopoll_conn_is_ok(conn))
+            return NULL;
+        if (nopoll_conn_recv_pending(conn) == 0)
+            os_thread_sleep_msec(1);
+    }
+    return msg;
+}
+
+static int client_receive_frames(noPollConn *conn)
+{
+    char *acc = malloc(TEST_FRAME_MAX);
+    int index = 0, ok = 0, bad = 0, acc_len = 0;
+    noPollMsg *hold = NULL;
+
+    nopoll_conn_send_text(conn, "frames", 6);
+    while (true) {
+        noPollMsg *msg = client_wait_msg(conn);
+        if (msg == NULL)
+            break;
+        const char *payload = (const char *)nopoll_msg_get_payload(msg);
+        int size = nopoll_msg_get_payload_size(msg);
+        if (nopoll_msg_opcode(msg) == NOPOLL_TEXT_FRAME && strcmp(payload, "end") == 0) {
+            nopoll_msg_unref(msg);
+            break;
+        }
+        memcpy(acc + acc_len, payload, size);
+        acc_len += size;
+        if (frame_is_text(index)) {
+            char expected[32];
+            snprintf(expected, sizeof(expected), "text-%d", index);
+            if (acc_len == (int)strlen(expected)) {
+                if (memcmp(acc, expected, acc_len) == 0 && payload[size] == 0)
+                    ok++;
+                else
+                    bad++;
+                index++;
+                acc_len = 0;
+            }
+        } else if (acc_len == frame_size(index)) {
+            if (frame_check(acc, acc_len, index))
+                ok++;
+            else
+                bad++;
+            index++;
+            acc_len = 0;
+        }
+        // keep a view alive while the connection refills
+        if (hold != NULL)
+            nopoll_msg_unref(hold);
+        hold = NULL;
+        if (index % TEST_HOLD_EVERY == 0)
+            hold = msg;
+        else
+            nopoll_msg_unref(msg);
+    }
+    if (hold != NULL)
+        nopoll_msg_unref(hold);
+    free(acc);
+
+    long reads = 0, frames = 0, views = 0, bytes = 0;
+    nopoll_conn_get_recv_stats(conn, &reads, &frames, &views, &bytes);
+    OS_LOGI(TAG, "frames: %d ok, %d bad of %d, %ld reads, %ld frames, %ld views, %ld bytes",
+            ok, bad, TEST_FRAMES, reads, frames, views, bytes);
+    return (bad == 0 && ok == TEST_FRAMES) ? 0 : -1;
+}
+
+static int client_receive_burst(noPollConn *conn)
+{
+    struct pollfd pfd = { .fd = nopoll_conn_socket(conn), .events = POLLIN };
+    long reads_before = 0, reads_after = 0;
+    int received = 0, stalls = 0;
+    bool ended = false;
+
+    nopoll_conn_send_text(conn, "burst", 5);
+    // let the whole burst (about 2.5KB) arrive, one read takes all of it
+    if (poll(&pfd, 1, 3000) != 1)
+        return -1;
+    os_thread_sleep_msec(200);
+    nopoll_conn_get_recv_stats(conn, &reads_before, NULL, NULL, NULL);
+
+    noPollMsg *msg = client_wait_msg(conn);
+    while (msg != NULL) {
+        if (nopoll_msg_opcode(msg) == NOPOLL_TEXT_FRAME) {
+            ended = strcmp((const char *)nopoll_msg_get_payload(msg), "end") == 0;
+        } else if (nopoll_msg_get_payload_size(msg) == 20 &&
+                   frame_check((const char *)nopoll_msg_get_payload(msg), 20, received)) {
+            received++;
+        }
+        nopoll_msg_unref(msg);
+        if (ended || nopoll_conn_recv_pending(conn) == 0)
+            break;
+        // the rest is buffered, the socket has nothing for select()/poll()
+        if (poll(&pfd, 1, 0) != 0)
+            stalls++;
+        msg = nopoll_conn_get_msg(conn);
+    }
+    nopoll_conn_get_recv_stats(conn, &reads_after, NULL, NULL, NULL);
+
+    OS_LOGI(TAG, "burst: %d/%d frames, end %s, %ld reads, socket readable %d times, %d bytes left",
+            received, TEST_BURST_FRAMES, ended ? "received" : "missing",
+            reads_after - reads_before, stalls, nopoll_conn_recv_pending(conn));
+    return (received == TEST_BURST_FRAMES && ended && stalls == 0 &&
+            nopoll_conn_recv_pending(conn) == 0) ? 0 : -1;
+}
+
+int main()
+{
+    int ret = 0;
+
+    sServerCtx = nopoll_ctx_new();
+    noPollConn *listener = nopoll_listener_new(sServerCtx, TEST_HOST, TEST_PORT);
+    if (!nopoll_conn_is_ok(listener)) {
+        OS_LOGE(TAG, "Failed to listen on %s:%s", TEST_HOST, TEST_PORT);
+        return 1;
+    }
+    nopoll_ctx_set_on_msg(sServerCtx, server_on_msg, NULL);
+    struct os_thread_attr attr = {
+        .name = "nopoll_server",
+        .priority = OS_THREAD_PRIO_NORMAL,
+        .stacksize = os_thread_default_stacksize(),
+        .joinable = false,
+    };
+    if (os_thread_create(&attr, server_entry, NULL) == NULL) {
+        OS_LOGE(TAG, "Failed to create server thread");
+        return 1;
+    }
+
+    noPollCtx *ctx = nopoll_ctx_new();
+    noPollConn *conn = nopoll_conn_new(ctx, TEST_HOST, TEST_PORT, NULL, NULL, NULL, NULL);
+    if (!nopoll_conn_wait_until_connection_ready(conn, 5)) {
+        OS_LOGE(TAG, "Failed to connect");
+        return 1;
+    }
+
+    char *buffer = malloc(TEST_FRAME_MAX);
+    for (int i = 0; i < TEST_UPLOAD_FRAMES; i++) {
+        frame_fill(buffer, frame_size(i), i);
+        nopoll_conn_send_binary(conn, buffer, frame_size(i));
+    }
+    free(buffer);
+
+    ret |= client_receive_frames(conn);
+    ret |= client_receive_burst(conn);
+
+    // the uploads were sent before the requests, the server has seen all of them
+    OS_LOGI(TAG, "upload: %d ok, %d bad of %d", sServerOk, sServerBad, TEST_UPLOAD_FRAMES);
+    if (sServerBad != 0 || sServerOk != TEST_UPLOAD_FRAMES)
+        ret = -1;
+
+    nopoll_conn_close(conn);
+    nopoll_ctx_unref(ctx);
+    OS_LOGI(TAG, "loopback test %s", ret == 0 ? "passed" : "failed");
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "osal/os_time.h"
+#include "cutils/log_helper.h"
+#include "nopoll.h"
+
+#define TAG "nopoll_mask"
+
+#define FUZZ_ROUNDS         200000
+#define FUZZ_MAX_SIZE       300
+#define BENCH_TOTAL         (256*1024*1024)
+// 20ms of 16kHz/16bit/mono pcm, the size of one mic upload frame
+#define BENCH_FRAME_SIZE    640
+#define BENCH_LARGE_SIZE    (64*1024)
+
+// byte-wise reference, as nopoll_conn_mask_content was before vectorizing
+static void mask_reference(char *payload, int payload_size, char *mask, int desp)
+{
+    for (int iter = 0; iter < payload_size; iter++)
+        payload[iter] ^= mask[(iter + desp) % 4];
+}
+
+static int fuzz_mask()
+{
+    static char input[FUZZ_MAX_SIZE + 64];
+    static char expected[FUZZ_MAX_SIZE + 64];
+    static char actual[FUZZ_MAX_SIZE + 64];
+
+    srand(0x6d61736b);
+    for (int round = 0; round < FUZZ_ROUNDS; round++) {
+        int size = rand() % (FUZZ_MAX_SIZE + 1);
+        int align = rand() % 32;
+        int desp = rand() % 8;
+        char mask[4];
+        for (int i = 0; i < 4; i++)
+            mask[i] = (char)rand();
+        for (int i = 0; i < size + align; i++)
+            input[i] = (char)rand();
+
+        // guard bytes around the payload must not be touched
+        memcpy(expected, input, sizeof(input));
+        memcpy(actual, input, sizeof(input));
+        mask_reference(&expected[align], size, mask, desp);
+        nopoll_conn_mask_content(NULL, &actual[align], size, mask, desp);
+        if (memcmp(expected, actual, sizeof(actual)) != 0) {
+            OS_LOGE(TAG, "Mismatch: round=%d, size=%d, align=%d, desp=%d", round, size, align, desp);
+            return -1;
+        }
+
+        // unmasking is the same operation
+        nopoll_conn_mask_content(NULL, &actual[align], size, mask, desp);
+        if (memcmp(input, actual, sizeof(actual)) != 0) {
+            OS_LOGE(TAG, "Roundtrip mismatch: round=%d, size=%d, align=%d, desp=%d", round, size, align, desp);
+            return -1;
+        }
+    }
+    OS_LOGI(TAG, "fuzz: %d rounds passed", FUZZ_ROUNDS);
+    return 0;
+}
+
+static double bench_mask(void (*func)(noPollCtx *, char *, int, char *, int), char *buffer, int frame_size)
+{
+    char mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+    unsigned long long start = os_monotonic_usec();
+    for (long total = 0; total < BENCH_TOTAL; total += frame_size)
+        func(NULL, buffer + 1, frame_size, mask, 0); // frame payload follows a header, so it's unaligned
+    unsigned long long cost = os_monotonic_usec() - start;
+    return (double)BENCH_TOTAL / (cost > 0 ? cost : 1); // MB/s
+}
+
+static void mask_reference_wrapper(noPollCtx *ctx, char *payload, int payload_size, char *mask, int desp)
+{
+    mask_reference(payload, payload_size, mask, desp);
+}
+
+int main()
+{
+    int ret = fuzz_mask();
+
+    char *buffer = malloc(BENCH_LARGE_SIZE + 1);
+    if (buffer == NULL)
+        return 1;
+    memset(buffer, 0x5a, BENCH_LARGE_SIZE + 1);
+
+    int sizes[] = { BENCH_FRAME_SIZE, BENCH_LARGE_SIZE };
+    for (int i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+        double reference = bench_mask(mask_reference_wrapper, buffer, sizes[i]);
+        double vectorized = bench_mask(nopoll_conn_mask_content, buffer, sizes[i]);
+        OS_LOGI(TAG, "bench: frame=%d bytes, byte-wise %.0f MB/s, vectorized %.0f MB/s, speedup %.1fx",
+                sizes[i], reference, vectorized, vectorized / reference);
+    }
+
+    free(buffer);
+    OS_LOGI(TAG, "mask test %s", ret == 0 ? "passed" : "failed");
+    return ret == 0 ? 0 : 1;
+}
@@ -63,6 +63,12 @@
 #define speex_packet_to_header                  SPEEX_NAMESPACE(speex_packet_to_header)
 #define speex_header_free                       SPEEX_NAMESPACE(speex_header_free)
 
+#define speex_echo_state_init                   SPEEX_NAMESPACE(speex_echo_state_init)
+#define speex_echo_state_destroy                SPEEX_NAMESPACE(speex_echo_state_destroy)
+#define speex_echo_cancellation                 SPEEX_NAMESPACE(speex_echo_cancellation)
+#define speex_echo_state_reset                  SPEEX_NAMESPACE(speex_echo_state_reset)
+#define speex_echo_ctl                          SPEEX_NAMESPACE(speex_echo_ctl)
+
 #define speex_stereo_state_init                 SPEEX_NAMESPACE(speex_stereo_state_init)
 #define speex_stereo_state_reset                SPEEX_NAMESPACE(speex_stereo_state_reset)
 #define speex_stereo_state_destroy              SPEEX_NAMESPACE(speex_stereo_state_destroy)
@@ -52,6 +52,9 @@
 #ifdef _USE_SSE
 #error SSE is only for floating-point
 #endif
+#ifdef _USE_NEON
+#error NEON is only for floating-point
+#endif
 #if ((defined (ARM4_ASM)||defined (ARM4_ASM)) && defined(BFIN_ASM)) || (defined (ARM4_ASM)&&defined(ARM5E_ASM))
 #error Make up your mind. What CPU do you have?
 #endif
@@ -67,6 +70,9 @@
 #if defined (ARM4_ASM) || defined(ARM5E_ASM) || defined(BFIN_ASM)
 #error I suppose you can have a [ARM4/ARM5E/Blackfin] that has float instructions?
 #endif
+#if defined(_USE_SSE) && defined(_USE_NEON)
+#error Make up your mind. SSE or NEON?
+#endif
 #ifdef FIXED_POINT_DEBUG
 #error "Don't you think enabling fixed-point is a good thing to do if you want to debug that?"
 #endif
@@ -43,6 +43,8 @@
 
 #ifdef _USE_SSE
 #include "cb_search_sse.h"
+#elif defined(_USE_NEON)
+#include "cb_search_neon.h"
 #elif defined(ARM4_ASM) || defined(ARM5E_ASM)
 #include "cb_search_arm4.h"
 #elif defined(BFIN_ASM)
@@ -119,6 +121,9 @@ int   update_target
 #ifdef _USE_SSE
    VARDECL(__m128 *resp2);
    VARDECL(__m128 *E);
+#elif defined(_USE_NEON)
+   VARDECL(float32x4_t *resp2);
+   VARDECL(float32x4_t *E);
 #else
    spx_word16_t *resp2;
    VARDECL(spx_word32_t *E);
@@ -142,6 +147,9 @@ int   update_target
 #ifdef _USE_SSE
    ALLOC(resp2, (shape_cb_size*subvect_size)>>2, __m128);
    ALLOC(E, shape_cb_size>>2, __m128);
+#elif defined(_USE_NEON)
+   ALLOC(resp2, (shape_cb_size*subvect_size)>>2, float32x4_t);
+   ALLOC(E, shape_cb_size>>2, float32x4_t);
 #else
    resp2 = resp;
    ALLOC(E, shape_cb_size, spx_word32_t);
@@ -264,6 +272,9 @@ int   update_target
 #ifdef _USE_SSE
    VARDECL(__m128 *resp2);
    VARDECL(__m128 *E);
+#elif defined(_USE_NEON)
+   VARDECL(float32x4_t *resp2);
+   VARDECL(float32x4_t *E);
 #else
    spx_word16_t *resp2;
    VARDECL(spx_word32_t *E);
@@ -316,6 +327,9 @@ int   update_target
 #ifdef _USE_SSE
    ALLOC(resp2, (shape_cb_size*subvect_size)>>2, __m128);
    ALLOC(E, shape_cb_size>>2, __m128);
+#elif defined(_USE_NEON)
+   ALLOC(resp2, (shape_cb_size*subvect_size)>>2, float32x4_t);
+   ALLOC(E, shape_cb_size>>2, float32x4_t);
 #else
    resp2 = resp;
    ALLOC(E, shape_cb_size, spx_word32_t);
@@ -0,0 +1,78 @@
+/* Copyright (C) 2023 Qinglong */
+/**
+   @file cb_search_neon.h
+   @brief Fixed codebook functions (NEON version)
+*/
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+   
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+   
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+   
+   - Neither the name of the Xiph.org Foundation nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+   
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <arm_neon.h>
+
+#define OVERRIDE_COMPUTE_WEIGHTED_CODEBOOK
+static void compute_weighted_codebook(const signed char *shape_cb, const spx_sig_t *_r, float *resp, float32x4_t *resp2, float32x4_t *E, int shape_cb_size, int subvect_size, char *stack)
+{
+   int i, j, k;
+   float32x4_t resj, EE;
+   float lanes[4];
+   VARDECL(float32x4_t *r);
+   VARDECL(float32x4_t *shape);
+   ALLOC(r, subvect_size, float32x4_t);
+   ALLOC(shape, subvect_size, float32x4_t);
+   for(j=0;j<subvect_size;j++)
+      r[j] = vdupq_n_f32(_r[j]);
+   for (i=0;i<shape_cb_size;i+=4)
+   {
+      float *_res = resp+i*subvect_size;
+      const signed char *_shape = shape_cb+i*subvect_size;
+      EE = vdupq_n_f32(0);
+      /* Four codebook entries side by side, one per lane */
+      for(j=0;j<subvect_size;j++)
+      {
+         lanes[0] = 0.03125*_shape[j];
+         lanes[1] = 0.03125*_shape[subvect_size+j];
+         lanes[2] = 0.03125*_shape[2*subvect_size+j];
+         lanes[3] = 0.03125*_shape[3*subvect_size+j];
+         shape[j] = vld1q_f32(lanes);
+      }
+      for(j=0;j<subvect_size;j++)
+      {
+         resj = vdupq_n_f32(0);
+         for (k=0;k<=j;k++)
+            resj = vmlaq_f32(resj, shape[k], r[j-k]);
+         vst1q_f32(lanes, resj);
+         _res[j] = lanes[0];
+         _res[subvect_size+j] = lanes[1];
+         _res[2*subvect_size+j] = lanes[2];
+         _res[3*subvect_size+j] = lanes[3];
+         *resp2++ = resj;
+         EE = vmlaq_f32(EE, resj, resj);
+      }
+      E[i>>2] = EE;
+   }
+}
@@ -43,6 +43,8 @@
 
 #ifdef _USE_SSE
 #include "filters_sse.h"
+#elif defined(_USE_NEON)
+#include "filters_neon.h"
 #elif defined (ARM4_ASM) || defined(ARM5E_ASM)
 #include "filters_arm4.h"
 #elif defined (BFIN_ASM)
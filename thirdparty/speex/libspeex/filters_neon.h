@@ -0,0 +1,281 @@
+/* Copyright (C) 2023 Qinglong */
+/**
+   @file filters_neon.h
+   @brief Various analysis/synthesis filters (NEON version)
+*/
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+   
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+   
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+   
+   - Neither the name of the Xiph.org Foundation nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+   
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <arm_neon.h>
+
+/* The filter memory lives in (ord+3)/4 vectors; each sample shifts it down one lane
+   with vext and accumulates the taps, the same update as the SSE version */
+
+void filter_mem16_10(const float *x, const float *_num, const float *_den, float *y, int N, int ord, float *_mem)
+{
+   float32x4_t num[3], den[3], mem[3];
+   const float32x4_t zero = vdupq_n_f32(0);
+   const float tail_num[4] = {_num[8], _num[9], 0, 0};
+   const float tail_den[4] = {_den[8], _den[9], 0, 0};
+   const float tail_mem[4] = {_mem[8], _mem[9], 0, 0};
+
+   int i;
+
+   for (i=0;i<2;i++)
+   {
+      mem[i] = vld1q_f32(_mem+4*i);
+      num[i] = vld1q_f32(_num+4*i);
+      den[i] = vld1q_f32(_den+4*i);
+   }
+   mem[2] = vld1q_f32(tail_mem);
+   num[2] = vld1q_f32(tail_num);
+   den[2] = vld1q_f32(tail_den);
+
+   for (i=0;i<N;i++)
+   {
+      float32x4_t xx, yy;
+      float yi;
+      /* Compute next filter result, x may alias y */
+      xx = vdupq_n_f32(x[i]);
+      yi = x[i] + vgetq_lane_f32(mem[0], 0);
+      y[i] = yi;
+      yy = vdupq_n_f32(yi);
+
+      /* Update memory */
+      mem[0] = vextq_f32(mem[0], mem[1], 1);
+      mem[0] = vmlsq_f32(vmlaq_f32(mem[0], xx, num[0]), yy, den[0]);
+      mem[1] = vextq_f32(mem[1], mem[2], 1);
+      mem[1] = vmlsq_f32(vmlaq_f32(mem[1], xx, num[1]), yy, den[1]);
+      mem[2] = vextq_f32(mem[2], zero, 1);
+      mem[2] = vmlsq_f32(vmlaq_f32(mem[2], xx, num[2]), yy, den[2]);
+   }
+   /* Put memory back in its place */
+   vst1q_f32(_mem, mem[0]);
+   vst1q_f32(_mem+4, mem[1]);
+   vst1_f32(_mem+8, vget_low_f32(mem[2]));
+}
+
+void filter_mem16_8(const float *x, const float *_num, const float *_den, float *y, int N, int ord, float *_mem)
+{
+   float32x4_t num[2], den[2], mem[2];
+   const float32x4_t zero = vdupq_n_f32(0);
+
+   int i;
+
+   for (i=0;i<2;i++)
+   {
+      mem[i] = vld1q_f32(_mem+4*i);
+      num[i] = vld1q_f32(_num+4*i);
+      den[i] = vld1q_f32(_den+4*i);
+   }
+
+   for (i=0;i<N;i++)
+   {
+      float32x4_t xx, yy;
+      float yi;
+      /* Compute next filter result, x may alias y */
+      xx = vdupq_n_f32(x[i]);
+      yi = x[i] + vgetq_lane_f32(mem[0], 0);
+      y[i] = yi;
+      yy = vdupq_n_f32(yi);
+
+      /* Update memory */
+      mem[0] = vextq_f32(mem[0], mem[1], 1);
+      mem[0] = vmlsq_f32(vmlaq_f32(mem[0], xx, num[0]), yy, den[0]);
+      mem[1] = vextq_f32(mem[1], zero, 1);
+      mem[1] = vmlsq_f32(vmlaq_f32(mem[1], xx, num[1]), yy, den[1]);
+   }
+   /* Put memory back in its place */
+   vst1q_f32(_mem, mem[0]);
+   vst1q_f32(_mem+4, mem[1]);
+}
+
+
+#define OVERRIDE_FILTER_MEM16
+void filter_mem16(const float *x, const float *_num, const float *_den, float *y, int N, int ord, float *_mem, char *stack)
+{
+   if(ord==10)
+      filter_mem16_10(x, _num, _den, y, N, ord, _mem);
+   else if (ord==8)
+      filter_mem16_8(x, _num, _den, y, N, ord, _mem);
+}
+
+
+
+void iir_mem16_10(const float *x, const float *_den, float *y, int N, int ord, float *_mem)
+{
+   float32x4_t den[3], mem[3];
+   const float32x4_t zero = vdupq_n_f32(0);
+   const float tail_den[4] = {_den[8], _den[9], 0, 0};
+   const float tail_mem[4] = {_mem[8], _mem[9], 0, 0};
+
+   int i;
+
+   for (i=0;i<2;i++)
+   {
+      mem[i] = vld1q_f32(_mem+4*i);
+      den[i] = vld1q_f32(_den+4*i);
+   }
+   mem[2] = vld1q_f32(tail_mem);
+   den[2] = vld1q_f32(tail_den);
+
+   for (i=0;i<N;i++)
+   {
+      float32x4_t yy;
+      float yi;
+      /* Compute next filter result */
+      yi = x[i] + vgetq_lane_f32(mem[0], 0);
+      y[i] = yi;
+      yy = vdupq_n_f32(yi);
+
+      /* Update memory */
+      mem[0] = vmlsq_f32(vextq_f32(mem[0], mem[1], 1), yy, den[0]);
+      mem[1] = vmlsq_f32(vextq_f32(mem[1], mem[2], 1), yy, den[1]);
+      mem[2] = vmlsq_f32(vextq_f32(mem[2], zero, 1), yy, den[2]);
+   }
+   /* Put memory back in its place */
+   vst1q_f32(_mem, mem[0]);
+   vst1q_f32(_mem+4, mem[1]);
+   vst1_f32(_mem+8, vget_low_f32(mem[2]));
+}
+
+
+void iir_mem16_8(const float *x, const float *_den, float *y, int N, int ord, float *_mem)
+{
+   float32x4_t den[2], mem[2];
+   const float32x4_t zero = vdupq_n_f32(0);
+
+   int i;
+
+   for (i=0;i<2;i++)
+   {
+      mem[i] = vld1q_f32(_mem+4*i);
+      den[i] = vld1q_f32(_den+4*i);
+   }
+
+   for (i=0;i<N;i++)
+   {
+      float32x4_t yy;
+      float yi;
+      /* Compute next filter result */
+      yi = x[i] + vgetq_lane_f32(mem[0], 0);
+      y[i] = yi;
+      yy = vdupq_n_f32(yi);
+
+      /* Update memory */
+      mem[0] = vmlsq_f32(vextq_f32(mem[0], mem[1], 1), yy, den[0]);
+      mem[1] = vmlsq_f32(vextq_f32(mem[1], zero, 1), yy, den[1]);
+   }
+   /* Put memory back in its place */
+   vst1q_f32(_mem, mem[0]);
+   vst1q_f32(_mem+4, mem[1]);
+}
+
+#define OVERRIDE_IIR_MEM16
+void iir_mem16(const float *x, const float *_den, float *y, int N, int ord, float *_mem, char *stack)
+{
+   if(ord==10)
+      iir_mem16_10(x, _den, y, N, ord, _mem);
+   else if (ord==8)
+      iir_mem16_8(x, _den, y, N, ord, _mem);
+}
+
+
+void fir_mem16_10(const float *x, const float *_num, float *y, int N, int ord, float *_mem)
+{
+   float32x4_t num[3], mem[3];
+   const float32x4_t zero = vdupq_n_f32(0);
+   const float tail_num[4] = {_num[8], _num[9], 0, 0};
+   const float tail_mem[4] = {_mem[8], _mem[9], 0, 0};
+
+   int i;
+
+   for (i=0;i<2;i++)
+   {
+      mem[i] = vld1q_f32(_mem+4*i);
+      num[i] = vld1q_f32(_num+4*i);
+   }
+   mem[2] = vld1q_f32(tail_mem);
+   num[2] = vld1q_f32(tail_num);
+
+   for (i=0;i<N;i++)
+   {
+      float32x4_t xx;
+      /* Compute next filter result, x may alias y */
+      xx = vdupq_n_f32(x[i]);
+      y[i] = x[i] + vgetq_lane_f32(mem[0], 0);
+
+      /* Update memory */
+      mem[0] = vmlaq_f32(vextq_f32(mem[0], mem[1], 1), xx, num[0]);
+      mem[1] = vmlaq_f32(vextq_f32(mem[1], mem[2], 1), xx, num[1]);
+      mem[2] = vmlaq_f32(vextq_f32(mem[2], zero, 1), xx, num[2]);
+   }
+   /* Put memory back in its place */
+   vst1q_f32(_mem, mem[0]);
+   vst1q_f32(_mem+4, mem[1]);
+   vst1_f32(_mem+8, vget_low_f32(mem[2]));
+}
+
+void fir_mem16_8(const float *x, const float *_num, float *y, int N, int ord, float *_mem)
+{
+   float32x4_t num[2], mem[2];
+   const float32x4_t zero = vdupq_n_f32(0);
+
+   int i;
+
+   for (i=0;i<2;i++)
+   {
+      mem[i] = vld1q_f32(_mem+4*i);
+      num[i] = vld1q_f32(_num+4*i);
+   }
+
+   for (i=0;i<N;i++)
+   {
+      float32x4_t xx;
+      /* Compute next filter result, x may alias y */
+      xx = vdupq_n_f32(x[i]);
+      y[i] = x[i] + vgetq_lane_f32(mem[0], 0);
+
+      /* Update memory */
+      mem[0] = vmlaq_f32(vextq_f32(mem[0], mem[1], 1), xx, num[0]);
+      mem[1] = vmlaq_f32(vextq_f32(mem[1], zero, 1), xx, num[1]);
+   }
+   /* Put memory back in its place */
+   vst1q_f32(_mem, mem[0]);
+   vst1q_f32(_mem+4, mem[1]);
+}
+
+#define OVERRIDE_FIR_MEM16
+void fir_mem16(const float *x, const float *_num, float *y, int N, int ord, float *_mem, char *stack)
+{
+   if(ord==10)
+      fir_mem16_10(x, _num, y, N, ord, _mem);
+   else if (ord==8)
+      fir_mem16_8(x, _num, y, N, ord, _mem);
+}
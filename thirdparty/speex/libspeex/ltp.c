@@ -48,6 +48,8 @@
 
 #ifdef _USE_SSE
 #include "ltp_sse.h"
+#elif defined(_USE_NEON)
+#include "ltp_neon.h"
 #elif defined (ARM4_ASM) || defined(ARM5E_ASM)
 #include "ltp_arm4.h"
 #elif defined (BFIN_ASM)
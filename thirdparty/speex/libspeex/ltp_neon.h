@@ -0,0 +1,90 @@
+/* Copyright (C) 2023 Qinglong */
+/**
+   @file ltp_neon.h
+   @brief Long-Term Prediction functions (NEON version)
+*/
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+   
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+   
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+   
+   - Neither the name of the Xiph.org Foundation nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+   
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <arm_neon.h>
+
+static inline float _spx_vaddvq_f32(float32x4_t sum)
+{
+   /* (s0+s2)+(s1+s3), same order as the SSE reduction */
+   float32x2_t s = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+   return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+
+#define OVERRIDE_INNER_PROD
+float inner_prod(const float *a, const float *b, int len)
+{
+   int i;
+   float32x4_t sum = vdupq_n_f32(0);
+   for (i=0;i<(len>>2);i+=2)
+   {
+      sum = vmlaq_f32(sum, vld1q_f32(a+0), vld1q_f32(b+0));
+      sum = vmlaq_f32(sum, vld1q_f32(a+4), vld1q_f32(b+4));
+      a += 8;
+      b += 8;
+   }
+   return _spx_vaddvq_f32(sum);
+}
+
+#define OVERRIDE_PITCH_XCORR
+void pitch_xcorr(const float *_x, const float *_y, float *corr, int len, int nb_pitch, char *stack)
+{
+   int i, j;
+   /* Four consecutive lags per pass, sharing the loads of x. NEON loads don't need
+      alignment, so unlike the SSE version nothing is copied to the stack */
+   for (i=0;i<nb_pitch;i+=4)
+   {
+      const float *x = _x;
+      const float *y = _y+i;
+      float32x4_t sum0 = vdupq_n_f32(0);
+      float32x4_t sum1 = vdupq_n_f32(0);
+      float32x4_t sum2 = vdupq_n_f32(0);
+      float32x4_t sum3 = vdupq_n_f32(0);
+      for (j=0;j<(len>>2);j++)
+      {
+         float32x4_t xx = vld1q_f32(x);
+         float32x4_t y0 = vld1q_f32(y);
+         float32x4_t y4 = vld1q_f32(y+4);
+         sum0 = vmlaq_f32(sum0, xx, y0);
+         sum1 = vmlaq_f32(sum1, xx, vextq_f32(y0, y4, 1));
+         sum2 = vmlaq_f32(sum2, xx, vextq_f32(y0, y4, 2));
+         sum3 = vmlaq_f32(sum3, xx, vextq_f32(y0, y4, 3));
+         x += 4;
+         y += 4;
+      }
+      corr[nb_pitch-1-i] = _spx_vaddvq_f32(sum0);
+      corr[nb_pitch-2-i] = _spx_vaddvq_f32(sum1);
+      corr[nb_pitch-3-i] = _spx_vaddvq_f32(sum2);
+      corr[nb_pitch-4-i] = _spx_vaddvq_f32(sum3);
+   }
+}
@@ -41,6 +41,9 @@
 #ifdef _USE_SSE
 #include <xmmintrin.h>
 #include "vq_sse.h"
+#elif defined(_USE_NEON)
+#include <arm_neon.h>
+#include "vq_neon.h"
 #elif defined(SHORTCUTS) && (defined(ARM4_ASM) || defined(ARM5E_ASM))
 #include "vq_arm4.h"
 #elif defined(BFIN_ASM)
@@ -45,6 +45,11 @@ int scal_quant32(spx_word32_t in, const spx_word32_t *boundary, int entries);
 void vq_nbest(spx_word16_t *in, const __m128 *codebook, int len, int entries, __m128 *E, int N, int *nbest, spx_word32_t *best_dist, char *stack);
 
 void vq_nbest_sign(spx_word16_t *in, const __m128 *codebook, int len, int entries, __m128 *E, int N, int *nbest, spx_word32_t *best_dist, char *stack);
+#elif defined(_USE_NEON)
+#include <arm_neon.h>
+void vq_nbest(spx_word16_t *in, const float32x4_t *codebook, int len, int entries, float32x4_t *E, int N, int *nbest, spx_word32_t *best_dist, char *stack);
+
+void vq_nbest_sign(spx_word16_t *in, const float32x4_t *codebook, int len, int entries, float32x4_t *E, int N, int *nbest, spx_word32_t *best_dist, char *stack);
 #else
 void vq_nbest(spx_word16_t *in, const spx_word16_t *codebook, int len, int entries, spx_word32_t *E, int N, int *nbest, spx_word32_t *best_dist, char *stack);
 
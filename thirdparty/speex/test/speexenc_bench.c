@@ -0,0 +1,190 @@
+// Copyright (c) 2023 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Encode cost of the recorder's speex+ogg pipeline (narrowband, quality 8, 16 kHz, mono)
+// at every complexity, for the arithmetic this binary's libspeex was built with. Reports
+// the cpu time per speex frame, the real time factor and a hash of the bitstream, so
+// builds can be checked against each other. The last line is the
+// complexity that fits the given cpu budget the way GnRecorder calibrates: counting up, the
+// last one before the first that doesn't fit.
+//
+//   speexenc_bench [wav, default test.wav] [passes, default 5] [cpu budget %, default 10]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "speex/speex.h"
+#include "speex/speex_header.h"
+#include "ogg/ogg.h"
+
+#ifndef SPEEXENC_BENCH_MODE
+#define SPEEXENC_BENCH_MODE "unknown"
+#endif
+
+#define BENCH_SAMPLE_RATE   16000
+#define BENCH_QUALITY       8
+#define BENCH_MAX_BYTES     256
+
+static double cpu_time_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 16 bit mono pcm of a canonical wav, NULL if it's anything else
+static int16_t *read_wav(const char *path, int *samples)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+        return NULL;
+    unsigned char header[44];
+    int16_t *pcm = NULL;
+    if (fread(header, 1, sizeof(header), fp) != sizeof(header) ||
+        memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+        goto out;
+    int channels = header[22] | (header[23] << 8);
+    int rate = header[24] | (header[25] << 8) | (header[26] << 16) | (header[27] << 24);
+    int bits = header[34] | (header[35] << 8);
+    if (channels != 1 || bits != 16 || rate != BENCH_SAMPLE_RATE) {
+        fprintf(stderr, "%s: need %d Hz mono 16 bit\n", path, BENCH_SAMPLE_RATE);
+        goto out;
+    }
+    fseek(fp, 0, SEEK_END);
+    long bytes = ftell(fp) - sizeof(header);
+    fseek(fp, sizeof(header), SEEK_SET);
+    pcm = (int16_t *)malloc(bytes);
+    if (pcm != NULL)
+        *samples = fread(pcm, 2, bytes / 2, fp);
+out:
+    fclose(fp);
+    return pcm;
+}
+
+static uint32_t fnv1a(uint32_t hash, const unsigned char *data, int size)
+{
+    for (int i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+// One pass over the input like GnRecorder_SpeexOgg_EncodeStream: encode a frame, write the
+// bits, page them through ogg. Returns the cpu time taken, hashes the bitstream if asked
+static double encode_pass(int complexity, const int16_t *pcm, int frames, int frame_size,
+                          uint32_t *hash)
+{
+    const SpeexMode *mode = speex_lib_get_mode(SPEEX_MODEID_NB);
+    void *enc = speex_encoder_init(mode);
+    spx_int32_t quality = BENCH_QUALITY;
+    spx_int32_t rate = BENCH_SAMPLE_RATE;
+    speex_encoder_ctl(enc, SPEEX_SET_COMPLEXITY, &complexity);
+    speex_encoder_ctl(enc, SPEEX_SET_QUALITY, &quality);
+    speex_encoder_ctl(enc, SPEEX_SET_SAMPLING_RATE, &rate);
+
+    SpeexBits bits;
+    speex_bits_init(&bits);
+    ogg_stream_state os;
+    ogg_page og;
+    ogg_packet op;
+    ogg_stream_init(&os, 0);
+
+    spx_int16_t frame[640];
+    char cbits[BENCH_MAX_BYTES];
+    if (hash != NULL)
+        *hash = 2166136261u;
+
+    double start = cpu_time_now();
+    for (int i = 0; i < frames; i++) {
+        memcpy(frame, &pcm[i * frame_size], frame_size * sizeof(spx_int16_t));
+        speex_encode_int(enc, frame, &bits);
+        speex_bits_insert_terminator(&bits);
+        int bytes = speex_bits_write(&bits, cbits, sizeof(cbits));
+        speex_bits_reset(&bits);
+
+        op.packet = (unsigned char *)cbits;
+        op.bytes = bytes;
+        op.b_o_s = 0;
+        op.e_o_s = i == frames - 1;
+        op.granulepos = (i + 1) * frame_size;
+        op.packetno = i + 1;
+        ogg_stream_packetin(&os, &op);
+        while (ogg_stream_flush(&os, &og) != 0)
+            continue;
+
+        if (hash != NULL)
+            *hash = fnv1a(*hash, (const unsigned char *)cbits, bytes);
+    }
+    double elapsed = cpu_time_now() - start;
+
+    ogg_stream_clear(&os);
+    speex_bits_destroy(&bits);
+    speex_encoder_destroy(enc);
+    return elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "test.wav";
+    int passes = argc > 2 ? atoi(argv[2]) : 5;
+    int budget = argc > 3 ? atoi(argv[3]) : 10;
+    if (passes <= 0)
+        passes = 1;
+
+    int samples = 0;
+    int16_t *pcm = read_wav(path, &samples);
+    if (pcm == NULL) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return 1;
+    }
+
+    spx_int32_t frame_size = 0;
+    void *probe = speex_encoder_init(speex_lib_get_mode(SPEEX_MODEID_NB));
+    speex_encoder_ctl(probe, SPEEX_GET_FRAME_SIZE, &frame_size);
+    speex_encoder_destroy(probe);
+
+    int frames = samples / frame_size;
+    double frame_us = frame_size * 1e6 / BENCH_SAMPLE_RATE;
+
+    printf("speex %s, nb quality %d, %s: %.2fs, %d frames of %.0fms, best of %d passes\n",
+           SPEEXENC_BENCH_MODE, BENCH_QUALITY, path, (double)samples / BENCH_SAMPLE_RATE,
+           frames, frame_us / 1000, passes);
+    printf("%-10s %10s %8s %10s\n", "complexity", "us/frame", "rtf", "bitstream");
+
+    int picked = 0;
+    for (int c = 1; c <= 10; c++) {
+        uint32_t hash = 0;
+        double best = 1e9;
+        for (int p = 0; p < passes; p++) {
+            double elapsed = encode_pass(c, pcm, frames, frame_size, p == 0 ? &hash : NULL);
+            if (elapsed < best)
+                best = elapsed;
+        }
+        double us_per_frame = best * 1e6 / frames;
+        printf("%-10d %10.2f %8.4f   %08x\n", c, us_per_frame, us_per_frame / frame_us, hash);
+        if (picked == c - 1 && us_per_frame <= frame_us * budget / 100)
+            picked = c;
+    }
+
+    if (picked > 0)
+        printf("cpu budget %d%% (%.0fus per frame): complexity %d\n",
+               budget, frame_us * budget / 100, picked);
+    else
+        printf("cpu budget %d%% (%.0fus per frame): none fits\n", budget, frame_us * budget / 100);
+
+    free(pcm);
+    return 0;
+}
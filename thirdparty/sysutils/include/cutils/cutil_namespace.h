@@ -84,6 +84,12 @@
 #define rb_reach_threshold             SYSUTILS_CUTILS_NAMESPACE(rb_reach_threshold)
 #define rb_is_full                     SYSUTILS_CUTILS_NAMESPACE(rb_is_full)
 #define rb_is_done_write               SYSUTILS_CUTILS_NAMESPACE(rb_is_done_write)
+#define rb_create_mirrored             SYSUTILS_CUTILS_NAMESPACE(rb_create_mirrored)
+#define rb_peek_contiguous             SYSUTILS_CUTILS_NAMESPACE(rb_peek_contiguous)
+#define rb_consume                     SYSUTILS_CUTILS_NAMESPACE(rb_consume)
+#define rb_reserve_write               SYSUTILS_CUTILS_NAMESPACE(rb_reserve_write)
+#define rb_commit_write                SYSUTILS_CUTILS_NAMESPACE(rb_commit_write)
+#define rb_is_mirrored                 SYSUTILS_CUTILS_NAMESPACE(rb_is_mirrored)
 
 // swtimer.h
 #define swtimer_create                 SYSUTILS_CUTILS_NAMESPACE(swtimer_create)
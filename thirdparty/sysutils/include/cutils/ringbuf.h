@@ -53,6 +53,18 @@ typedef struct ringbuf *ringbuf_handle;
  */
 ringbuf_handle rb_create(int size);
 
+/**
+ * @brief      Create ringbuffer whose memory is mapped twice back-to-back, so that
+ *             any segment returned by rb_peek_contiguous/rb_reserve_write is linear
+ *             even if it crosses the end of buffer. Size is rounded up to page size.
+ *             Fallback to rb_create if the platform can't map mirrored memory.
+ *
+ * @param[in]  size   Size of ringbuffer
+ *
+ * @return     ringbuf_handle
+ */
+ringbuf_handle rb_create_mirrored(int size);
+
 /**
  * @brief      Cleanup and free all memory created by ringbuf_handle
  *
@@ -151,6 +163,56 @@ int rb_read_chunk(ringbuf_handle rb, char *buf, int size, unsigned int timeout_m
  */
 int rb_write_chunk(ringbuf_handle rb, char *buf, int size, unsigned int timeout_ms);
 
+/**
+ * @brief      Wait until `size` bytes are readable (or writer is done), then return
+ *             a pointer to the readable data in ringbuffer memory without copying.
+ *             Data stays in ringbuffer until rb_consume. Only one reader is allowed.
+ *
+ * @param[in]  rb             The Ringbuffer handle
+ * @param[out] buf            Pointer to readable data
+ * @param[in]  size           The length request
+ * @param[in]  timeout_ms     The time to wait, if zero, wait forever
+ *
+ * @return     Number of contiguous bytes at `buf`, may be less than `size` at the
+ *             end of a non-mirrored buffer, or RB_DONE/RB_ABORT/RB_TIMEOUT/RB_FAIL
+ */
+int rb_peek_contiguous(ringbuf_handle rb, char **buf, int size, unsigned int timeout_ms);
+
+/**
+ * @brief      Release `size` bytes returned by rb_peek_contiguous
+ *
+ * @param[in]  rb             The Ringbuffer handle
+ * @param[in]  size           The length consumed
+ *
+ * @return     Number of bytes consumed, or RB_FAIL
+ */
+int rb_consume(ringbuf_handle rb, int size);
+
+/**
+ * @brief      Wait until `size` bytes are writable, then return a pointer to free
+ *             space in ringbuffer memory, to be filled in place by the writer.
+ *             Data is invisible to reader until rb_commit_write. Only one writer is allowed.
+ *
+ * @param[in]  rb             The Ringbuffer handle
+ * @param[out] buf            Pointer to writable space
+ * @param[in]  size           The length request
+ * @param[in]  timeout_ms     The time to wait, if zero, wait forever
+ *
+ * @return     Number of contiguous bytes at `buf`, may be less than `size` at the
+ *             end of a non-mirrored buffer, or RB_DONE/RB_ABORT/RB_TIMEOUT/RB_FAIL
+ */
+int rb_reserve_write(ringbuf_handle rb, char **buf, int size, unsigned int timeout_ms);
+
+/**
+ * @brief      Publish `size` bytes written to space returned by rb_reserve_write
+ *
+ * @param[in]  rb             The Ringbuffer handle
+ * @param[in]  size           The length written
+ *
+ * @return     Number of bytes committed, or RB_FAIL
+ */
+int rb_commit_write(ringbuf_handle rb, int size);
+
 /**
  * @brief      Set status of writing to ringbuffer is done
  *
@@ -173,9 +235,12 @@ void rb_done_read(ringbuf_handle rb);
 void rb_unblock_reader(ringbuf_handle rb);
 
 /**
- * @brief      Set reader threshold
+ * @brief      Set reader threshold, reader is blocked until threshold bytes are
+ *             filled or writer is done. Setting it again re-arms the threshold,
+ *             which can be used to rebuffer after an underrun
  *
- * @param[in]  rb    The Ringbuffer handle
+ * @param[in]  rb         The Ringbuffer handle
+ * @param[in]  threshold  Number of bytes
  */
 void rb_set_threshold(ringbuf_handle rb, int threshold);
 
@@ -197,6 +262,8 @@ bool rb_is_full(ringbuf_handle rb);
 
 bool rb_is_done_write(ringbuf_handle rb);
 
+bool rb_is_mirrored(ringbuf_handle rb);
+
 #ifdef __cplusplus
 }
 #endif
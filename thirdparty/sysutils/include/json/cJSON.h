@@ -135,6 +135,20 @@ typedef struct cJSON_Hooks
 
 typedef int cJSON_bool;
 
+/* Scoped arena: nodes, strings and print buffers are bump-allocated from one caller block and released
+ * together by cJSON_ResetArena. If the block is exhausted, allocations spill to the hooks and are freed
+ * on reset as well. Trees from an arena are read-only: don't cJSON_Delete them, and don't add, replace
+ * or detach items. */
+typedef struct cJSON_Arena
+{
+    unsigned char *buffer;
+    size_t size;
+    size_t offset;
+    size_t peak;        /* high water mark of buffer usage, for sizing the block */
+    size_t spill_count; /* allocations that did not fit in the block, since init */
+    struct cJSON_ArenaSpill *spills;
+} cJSON_Arena;
+
 /* Limits how deeply nested arrays/objects can be before cJSON rejects to parse them.
  * This is to prevent stack overflows. */
 #ifndef CJSON_NESTING_LIMIT
@@ -168,6 +182,14 @@ CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, cons
 /* Delete a cJSON entity and all subentities. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *item);
 
+/* Arena variants, see cJSON_Arena. Results stay valid until the next cJSON_ResetArena. */
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t size);
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithArena(cJSON_Arena *arena, const char *value);
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthArena(cJSON_Arena *arena, const char *value, size_t buffer_length);
+CJSON_PUBLIC(char *) cJSON_PrintWithArena(cJSON_Arena *arena, const cJSON *item, cJSON_bool format);
+/* Release everything allocated from the arena in O(1), spilled allocations are freed one by one. */
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena);
+
 /* Returns the number of items in an array (or object). */
 CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array);
 /* Retrieve item number "index" from array "array". Returns NULL if unsuccessful. */
@@ -55,6 +55,11 @@
 #define cJSON_PrintBuffered                         SYSUTILS_JSON_NAMESPACE(cJSON_PrintBuffered)
 #define cJSON_PrintPreallocated                     SYSUTILS_JSON_NAMESPACE(cJSON_PrintPreallocated)
 #define cJSON_Delete                                SYSUTILS_JSON_NAMESPACE(cJSON_Delete)
+#define cJSON_InitArena                             SYSUTILS_JSON_NAMESPACE(cJSON_InitArena)
+#define cJSON_ParseWithArena                        SYSUTILS_JSON_NAMESPACE(cJSON_ParseWithArena)
+#define cJSON_ParseWithLengthArena                  SYSUTILS_JSON_NAMESPACE(cJSON_ParseWithLengthArena)
+#define cJSON_PrintWithArena                        SYSUTILS_JSON_NAMESPACE(cJSON_PrintWithArena)
+#define cJSON_ResetArena                            SYSUTILS_JSON_NAMESPACE(cJSON_ResetArena)
 #define cJSON_GetArraySize                          SYSUTILS_JSON_NAMESPACE(cJSON_GetArraySize)
 #define cJSON_GetArrayItem                          SYSUTILS_JSON_NAMESPACE(cJSON_GetArrayItem)
 #define cJSON_GetObjectItem                         SYSUTILS_JSON_NAMESPACE(cJSON_GetObjectItem)
@@ -32,6 +32,21 @@
 #include "cutils/log_helper.h"
 #include "cutils/ringbuf.h"
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(SYS_memfd_create)
+#define RB_HAVE_MIRROR
+#endif
+#elif defined(OS_APPLE)
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#define RB_HAVE_MIRROR
+#endif
+
 #define LOG_TAG "ringbuf"
 
 struct ringbuf {
@@ -49,8 +64,59 @@ struct ringbuf {
     bool is_done_write;          /**< To signal that we are done writing */
     bool unblock_reader_flag;    /**< To unblock instantly from rb_read */
     bool is_reach_threshold;
+    bool is_mirrored;            /**< Buffer is mapped twice back-to-back */
 };
 
+#if defined(RB_HAVE_MIRROR)
+static int rb_mirror_fd(int size)
+{
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    int fd = (int)syscall(SYS_memfd_create, "ringbuf", 0);
+#else
+    char name[32];
+    snprintf(name, sizeof(name), "/ringbuf-%d-%p", (int)getpid(), (void *)&name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0)
+        shm_unlink(name);
+#endif
+    if (fd < 0)
+        return -1;
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static char *rb_mirror_alloc(int size)
+{
+    int fd = rb_mirror_fd(size);
+    if (fd < 0)
+        return NULL;
+
+    // Reserve 2*size of address space, then map the same pages into both halves,
+    // so that p + n is valid for any p inside the first half and n <= size
+    char *addr = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    if (mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != addr ||
+        mmap(addr + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != addr + size) {
+        munmap(addr, 2 * size);
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+    return addr;
+}
+
+static void rb_mirror_free(char *addr, int size)
+{
+    munmap(addr, 2 * size);
+}
+#endif
+
 ringbuf_handle rb_create(int size)
 {
     ringbuf_handle rb;
@@ -78,12 +144,46 @@ ringbuf_handle rb_create(int size)
     return rb;
 }
 
+ringbuf_handle rb_create_mirrored(int size)
+{
+#if defined(RB_HAVE_MIRROR)
+    long page = sysconf(_SC_PAGESIZE);
+    int mirror_size = page > 0 ? (int)((size + page - 1) / page * page) : size;
+    ringbuf_handle rb;
+    char *buf = NULL;
+    bool _success =
+        (
+            (rb             = OS_CALLOC(1, sizeof(struct ringbuf))) &&
+            (rb->lock       = os_mutex_create()) &&
+            (rb->can_read   = os_cond_create()) &&
+            (rb->can_write  = os_cond_create())
+        );
+
+    if (_success && page > 0 && (buf = rb_mirror_alloc(mirror_size)) != NULL) {
+        rb->p_o = rb->p_r = rb->p_w = buf;
+        rb->size = mirror_size;
+        rb->is_mirrored = true;
+        return rb;
+    }
+
+    OS_LOGW(LOG_TAG, "Failed to map mirrored buffer, fallback to plain ringbuf");
+    rb_destroy(rb);
+#endif
+    return rb_create(size);
+}
+
 void rb_destroy(ringbuf_handle rb)
 {
     if (rb == NULL)
         return;
-    if (rb->p_o)
-        OS_FREE(rb->p_o);
+    if (rb->p_o) {
+#if defined(RB_HAVE_MIRROR)
+        if (rb->is_mirrored)
+            rb_mirror_free(rb->p_o, rb->size);
+        else
+#endif
+            OS_FREE(rb->p_o);
+    }
     if (rb->can_read)
         os_cond_destroy(rb->can_read);
     if (rb->can_write)
@@ -415,6 +515,165 @@ write_done:
     return total_write_size > 0 ? total_write_size : ret_val;
 }
 
+static inline int rb_contiguous_filled(ringbuf_handle rb)
+{
+    int len = rb->p_o + rb->size - rb->p_r;
+    return (rb->is_mirrored || rb->fill_cnt < len) ? rb->fill_cnt : len;
+}
+
+static inline int rb_contiguous_available(ringbuf_handle rb)
+{
+    int available = rb_bytes_available(rb);
+    int len = rb->p_o + rb->size - rb->p_w;
+    return (rb->is_mirrored || available < len) ? available : len;
+}
+
+int rb_peek_contiguous(ringbuf_handle rb, char **buf, int size, unsigned int timeout_ms)
+{
+    int peek_size = 0;
+    int ret_val = 0;
+
+    os_mutex_lock(rb->lock);
+
+wait_filled:
+    if (rb->fill_cnt < size) {
+        if (rb->is_done_write)
+            peek_size = rb->fill_cnt;
+        else
+            peek_size = 0;
+    } else {
+        peek_size = size;
+    }
+
+    if (peek_size == 0 || !rb->is_reach_threshold) {
+        if (rb->is_done_write) {
+            ret_val = RB_DONE;
+            goto peek_done;
+        }
+        if (rb->abort_read) {
+            ret_val = RB_ABORT;
+            goto peek_done;
+        }
+        if (rb->unblock_reader_flag) {
+            ret_val = RB_TIMEOUT;
+            goto peek_done;
+        }
+        if (size > rb->size) {
+            ret_val = RB_FAIL;
+            goto peek_done;
+        }
+        os_cond_signal(rb->can_write);
+        if (timeout_ms == 0)
+            ret_val = os_cond_wait(rb->can_read, rb->lock);
+        else
+            ret_val = os_cond_timedwait(rb->can_read, rb->lock, timeout_ms*1000);
+        if (ret_val != 0) {
+            ret_val = RB_TIMEOUT;
+            goto peek_done;
+        }
+        goto wait_filled;
+    }
+
+    // Without mirror mapping, the segment stops at the end of buffer
+    if (peek_size > rb_contiguous_filled(rb))
+        peek_size = rb_contiguous_filled(rb);
+    *buf = rb->p_r;
+    ret_val = peek_size;
+
+peek_done:
+    os_mutex_unlock(rb->lock);
+    return ret_val;
+}
+
+int rb_consume(ringbuf_handle rb, int size)
+{
+    os_mutex_lock(rb->lock);
+    if (size < 0 || size > rb->fill_cnt) {
+        os_mutex_unlock(rb->lock);
+        return RB_FAIL;
+    }
+    rb->p_r += size;
+    if (rb->p_r >= rb->p_o + rb->size)
+        rb->p_r -= rb->size;
+    rb->fill_cnt -= size;
+    if (size > 0)
+        os_cond_signal(rb->can_write);
+    os_mutex_unlock(rb->lock);
+    return size;
+}
+
+int rb_reserve_write(ringbuf_handle rb, char **buf, int size, unsigned int timeout_ms)
+{
+    int reserve_size = 0;
+    int ret_val = 0;
+
+    os_mutex_lock(rb->lock);
+
+wait_available:
+    if (rb->fill_cnt == 0) {
+        // Nothing pending, rewind so that the whole buffer is contiguous
+        rb->p_r = rb->p_w = rb->p_o;
+    }
+    reserve_size = rb_bytes_available(rb) < size ? 0 : size;
+
+    if (reserve_size == 0) {
+        if (rb->is_done_write) {
+            ret_val = RB_DONE;
+            rb->is_reach_threshold = true;
+            goto reserve_done;
+        }
+        if (rb->abort_write) {
+            ret_val = RB_ABORT;
+            rb->is_reach_threshold = true;
+            goto reserve_done;
+        }
+        if (size > rb->size || size <= 0) {
+            ret_val = RB_FAIL;
+            rb->is_reach_threshold = true;
+            goto reserve_done;
+        }
+        os_cond_signal(rb->can_read);
+        if (timeout_ms == 0)
+            ret_val = os_cond_wait(rb->can_write, rb->lock);
+        else
+            ret_val = os_cond_timedwait(rb->can_write, rb->lock, timeout_ms*1000);
+        if (ret_val != 0) {
+            ret_val = RB_TIMEOUT;
+            goto reserve_done;
+        }
+        goto wait_available;
+    }
+
+    // Without mirror mapping, the segment stops at the end of buffer
+    if (reserve_size > rb_contiguous_available(rb))
+        reserve_size = rb_contiguous_available(rb);
+    *buf = rb->p_w;
+    ret_val = reserve_size;
+
+reserve_done:
+    os_mutex_unlock(rb->lock);
+    return ret_val;
+}
+
+int rb_commit_write(ringbuf_handle rb, int size)
+{
+    os_mutex_lock(rb->lock);
+    if (size < 0 || size > rb_bytes_available(rb)) {
+        os_mutex_unlock(rb->lock);
+        return RB_FAIL;
+    }
+    rb->p_w += size;
+    if (rb->p_w >= rb->p_o + rb->size)
+        rb->p_w -= rb->size;
+    rb->fill_cnt += size;
+    if (!rb->is_reach_threshold && rb->fill_cnt >= rb->threshold_cnt)
+        rb->is_reach_threshold = true;
+    if (rb->is_reach_threshold && size > 0)
+        os_cond_signal(rb->can_read);
+    os_mutex_unlock(rb->lock);
+    return size;
+}
+
 static void rb_abort_read(ringbuf_handle rb)
 {
     os_mutex_lock(rb->lock);
@@ -446,6 +705,8 @@ void rb_done_write(ringbuf_handle rb)
 {
     os_mutex_lock(rb->lock);
     rb->is_done_write = true;
+    // no more data is coming, let reader drain what is left below threshold
+    rb->is_reach_threshold = true;
     os_cond_signal(rb->can_read);
     os_mutex_unlock(rb->lock);
 }
@@ -476,10 +737,17 @@ int rb_get_size(ringbuf_handle rb)
     return rb->size;
 }
 
+bool rb_is_mirrored(ringbuf_handle rb)
+{
+    return rb->is_mirrored;
+}
+
 void rb_set_threshold(ringbuf_handle rb, int threshold)
 {
     os_mutex_lock(rb->lock);
     rb->threshold_cnt = threshold <= rb->size ? threshold : rb->size;
+    // re-arm: reader blocks again until threshold bytes are filled or writer is done
+    rb->is_reach_threshold = rb->fill_cnt >= rb->threshold_cnt || rb->is_done_write;
     os_mutex_unlock(rb->lock);
 }
 
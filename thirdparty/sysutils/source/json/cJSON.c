@@ -154,6 +154,7 @@ typedef struct internal_hooks
     void *(CJSON_CDECL *allocate)(size_t size);
     void (CJSON_CDECL *deallocate)(void *pointer);
     void *(CJSON_CDECL *reallocate)(void *pointer, size_t size);
+    cJSON_Arena *arena; /* if set, allocate from arena and never deallocate */
 } internal_hooks;
 
 #if defined(SYSUTILS_HAVE_MEMORY_LEAK_DETECT_ENABLED) || defined(SYSUTILS_HAVE_MEMORY_OVERFLOW_DETECT_ENABLED)
@@ -179,7 +180,96 @@ static void * CJSON_CDECL internal_realloc(void *pointer, size_t size)
 /* strlen of character literals resolved at compile time */
 #define static_strlen(string_literal) (sizeof(string_literal) - sizeof(""))
 
-static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc };
+static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc, NULL };
+
+#define CJSON_ARENA_ALIGN 8
+
+struct cJSON_ArenaSpill
+{
+    struct cJSON_ArenaSpill *next;
+    double data[1]; /* aligned payload */
+};
+
+static void *arena_allocate(cJSON_Arena * const arena, size_t size)
+{
+    size_t offset = arena->offset;
+    size_t misalign = (size_t)(arena->buffer + offset) & (CJSON_ARENA_ALIGN - 1);
+    struct cJSON_ArenaSpill *spill = NULL;
+
+    if (misalign != 0)
+    {
+        offset += CJSON_ARENA_ALIGN - misalign;
+    }
+    if ((arena->buffer != NULL) && (offset <= arena->size) && (size <= arena->size - offset))
+    {
+        arena->offset = offset + size;
+        if (arena->offset > arena->peak)
+        {
+            arena->peak = arena->offset;
+        }
+        return arena->buffer + offset;
+    }
+
+    /* block exhausted, fall back to the heap, released with the arena */
+    spill = (struct cJSON_ArenaSpill*)global_hooks.allocate(offsetof(struct cJSON_ArenaSpill, data) + size);
+    if (spill == NULL)
+    {
+        return NULL;
+    }
+    spill->next = arena->spills;
+    arena->spills = spill;
+    arena->spill_count++;
+    return spill->data;
+}
+
+static void *hooks_allocate(const internal_hooks * const hooks, size_t size)
+{
+    if (hooks->arena != NULL)
+    {
+        return arena_allocate(hooks->arena, size);
+    }
+    return hooks->allocate(size);
+}
+
+static void hooks_deallocate(const internal_hooks * const hooks, void *pointer)
+{
+    /* arena memory is only released by cJSON_ResetArena */
+    if (hooks->arena == NULL)
+    {
+        hooks->deallocate(pointer);
+    }
+}
+
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t size)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+    arena->buffer = (unsigned char*)buffer;
+    arena->size = (buffer != NULL) ? size : 0;
+    arena->offset = 0;
+    arena->peak = 0;
+    arena->spill_count = 0;
+    arena->spills = NULL;
+}
+
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena)
+{
+    struct cJSON_ArenaSpill *spill = NULL;
+
+    if (arena == NULL)
+    {
+        return;
+    }
+    while (arena->spills != NULL)
+    {
+        spill = arena->spills;
+        arena->spills = spill->next;
+        global_hooks.deallocate(spill);
+    }
+    arena->offset = 0;
+}
 
 static unsigned char* cJSON_strdup(const unsigned char* string, const internal_hooks * const hooks)
 {
@@ -192,7 +282,7 @@ static unsigned char* cJSON_strdup(const unsigned char* string, const internal_h
     }
 
     length = strlen((const char*)string) + sizeof("");
-    copy = (unsigned char*)hooks->allocate(length);
+    copy = (unsigned char*)hooks_allocate(hooks, length);
     if (copy == NULL)
     {
         return NULL;
@@ -236,7 +326,7 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
 {
-    cJSON* node = (cJSON*)hooks->allocate(sizeof(cJSON));
+    cJSON* node = (cJSON*)hooks_allocate(hooks, sizeof(cJSON));
     if (node)
     {
         memset(node, '\0', sizeof(cJSON));
@@ -482,7 +572,7 @@ static unsigned char* ensure(printbuffer * const p, size_t needed)
         newsize = needed * 2;
     }
 
-    if (p->hooks.reallocate != NULL)
+    if ((p->hooks.reallocate != NULL) && (p->hooks.arena == NULL))
     {
         /* reallocate with realloc if available */
         newbuffer = (unsigned char*)p->hooks.reallocate(p->buffer, newsize);
@@ -498,10 +588,10 @@ static unsigned char* ensure(printbuffer * const p, size_t needed)
     else
     {
         /* otherwise reallocate manually */
-        newbuffer = (unsigned char*)p->hooks.allocate(newsize);
+        newbuffer = (unsigned char*)hooks_allocate(&p->hooks, newsize);
         if (!newbuffer)
         {
-            p->hooks.deallocate(p->buffer);
+            hooks_deallocate(&p->hooks, p->buffer);
             p->length = 0;
             p->buffer = NULL;
 
@@ -511,7 +601,7 @@ static unsigned char* ensure(printbuffer * const p, size_t needed)
         {
             memcpy(newbuffer, p->buffer, p->offset + 1);
         }
-        p->hooks.deallocate(p->buffer);
+        hooks_deallocate(&p->hooks, p->buffer);
     }
     p->length = newsize;
     p->buffer = newbuffer;
@@ -803,7 +893,7 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
 
         /* This is at most how much we need for the output */
         allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
+        output = (unsigned char*)hooks_allocate(&input_buffer->hooks, allocation_length + sizeof(""));
         if (output == NULL)
         {
             goto fail; /* allocation failure */
@@ -881,7 +971,7 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
 fail:
     if (output != NULL)
     {
-        input_buffer->hooks.deallocate(output);
+        hooks_deallocate(&input_buffer->hooks, output);
     }
 
     if (input_pointer != NULL)
@@ -1085,10 +1175,9 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return
     return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
 }
 
-/* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+static cJSON *parse(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, const internal_hooks * const hooks)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 } };
     cJSON *item = NULL;
 
     /* reset error position */
@@ -1103,9 +1192,9 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     buffer.content = (const unsigned char*)value;
     buffer.length = buffer_length; 
     buffer.offset = 0;
-    buffer.hooks = global_hooks;
+    buffer.hooks = *hooks;
 
-    item = cJSON_New_Item(&global_hooks);
+    item = cJSON_New_Item(hooks);
     if (item == NULL) /* memory fail */
     {
         goto fail;
@@ -1134,7 +1223,7 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     return item;
 
 fail:
-    if (item != NULL)
+    if ((item != NULL) && (hooks->arena == NULL))
     {
         cJSON_Delete(item);
     }
@@ -1165,6 +1254,33 @@ fail:
     return NULL;
 }
 
+/* Parse an object - create a new root, and populate. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse(value, buffer_length, return_parse_end, require_null_terminated, &global_hooks);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthArena(cJSON_Arena *arena, const char *value, size_t buffer_length)
+{
+    internal_hooks hooks = global_hooks;
+
+    if (arena == NULL)
+    {
+        return NULL;
+    }
+    hooks.arena = arena;
+    return parse(value, buffer_length, NULL, false, &hooks);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithArena(cJSON_Arena *arena, const char *value)
+{
+    if (value == NULL)
+    {
+        return NULL;
+    }
+    return cJSON_ParseWithLengthArena(arena, value, strlen(value) + sizeof(""));
+}
+
 /* Default options for cJSON_Parse */
 CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
 {
@@ -1187,7 +1303,7 @@ static unsigned char *print(const cJSON * const item, cJSON_bool format, const i
     memset(buffer, 0, sizeof(buffer));
 
     /* create buffer */
-    buffer->buffer = (unsigned char*) hooks->allocate(default_buffer_size);
+    buffer->buffer = (unsigned char*) hooks_allocate(hooks, default_buffer_size);
     buffer->length = default_buffer_size;
     buffer->format = format;
     buffer->hooks = *hooks;
@@ -1203,6 +1319,12 @@ static unsigned char *print(const cJSON * const item, cJSON_bool format, const i
     }
     update_offset(buffer);
 
+    if (hooks->arena != NULL)
+    {
+        /* no need to shrink, the arena is released as a whole */
+        return buffer->buffer;
+    }
+
     /* check if reallocate is available */
     if (hooks->reallocate != NULL)
     {
@@ -1231,12 +1353,12 @@ static unsigned char *print(const cJSON * const item, cJSON_bool format, const i
 fail:
     if (buffer->buffer != NULL)
     {
-        hooks->deallocate(buffer->buffer);
+        hooks_deallocate(hooks, buffer->buffer);
     }
 
     if (printed != NULL)
     {
-        hooks->deallocate(printed);
+        hooks_deallocate(hooks, printed);
     }
 
     return NULL;
@@ -1253,9 +1375,21 @@ CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
     return (char*)print(item, false, &global_hooks);
 }
 
+CJSON_PUBLIC(char *) cJSON_PrintWithArena(cJSON_Arena *arena, const cJSON *item, cJSON_bool format)
+{
+    internal_hooks hooks = global_hooks;
+
+    if (arena == NULL)
+    {
+        return NULL;
+    }
+    hooks.arena = arena;
+    return (char*)print(item, format, &hooks);
+}
+
 CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 } };
 
     if (prebuffer < 0)
     {
@@ -1285,7 +1419,7 @@ CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON
 
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 } };
 
     if ((length < 0) || (buffer == NULL))
     {
@@ -1521,7 +1655,7 @@ success:
     return true;
 
 fail:
-    if (head != NULL)
+    if ((head != NULL) && (input_buffer->hooks.arena == NULL))
     {
         cJSON_Delete(head);
     }
@@ -1696,7 +1830,7 @@ success:
     return true;
 
 fail:
-    if (head != NULL)
+    if ((head != NULL) && (input_buffer->hooks.arena == NULL))
     {
         cJSON_Delete(head);
     }
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "osal/os_time.h"
+#include "cutils/log_helper.h"
+#include "json/cJSON.h"
+
+#define LOG_TAG "cjson_arena_test"
+
+#define ARENA_SIZE      4096
+#define ROUNDS          20000
+
+// Typical gateway commands, the Play one carries a long signed url
+static const char *sCommands[] = {
+    "{\"commandDomain\":\"AliGenie.Speaker\",\"commandName\":\"Speak\","
+        "\"payload\":{\"text\":\"Sunny today, 18 to 26 degrees\",\"expectSpeech\":false}}",
+    "{\"commandDomain\":\"AliGenie.Text\",\"commandName\":\"ListenResult\","
+        "\"payload\":{\"isLast\":true,\"outputText\":\"\\u4eca\\u5929\\u5929\\u6c14\\u600e\\u4e48\\u6837\"}}",
+    "{\"commandDomain\":\"AliGenie.Audio\",\"commandName\":\"Play\",\"payload\":{"
+        "\"audioUrl\":\"http://example.com/a/long/path/to/audio.mp3?auth_key=0123456789abcdef0123456789abcdef\","
+        "\"audioAnchor\":\"\",\"audioExt\":\"{\\\"a\\\":1}\",\"audioId\":\"123456\",\"audioName\":\"song\","
+        "\"audioType\":\"music\",\"audioAlbum\":\"album\",\"audioSource\":\"xiami\","
+        "\"audioLength\":240000,\"progress\":0,\"tags\":[1,2.5,null,true,[\"x\"]]}}",
+};
+
+static unsigned long sMallocCount = 0;
+
+static void *counting_malloc(size_t size)
+{
+    sMallocCount++;
+    return malloc(size);
+}
+
+static int test_equivalence(cJSON_Arena *arena, const char *text)
+{
+    int ret = -1;
+    cJSON *heap = cJSON_Parse(text);
+    cJSON *scoped = cJSON_ParseWithArena(arena, text);
+    char *heapStr = cJSON_PrintUnformatted(heap);
+    char *scopedStr = cJSON_PrintWithArena(arena, scoped, false);
+    if (heapStr != NULL && scopedStr != NULL && strcmp(heapStr, scopedStr) == 0)
+        ret = 0;
+    else
+        OS_LOGE(LOG_TAG, "Arena result mismatch:\n  heap:  %s\n  arena: %s", heapStr, scopedStr);
+    if (heapStr != NULL)
+        cJSON_free(heapStr);
+    cJSON_Delete(heap);
+    cJSON_ResetArena(arena);
+    return ret;
+}
+
+// Small block: allocations spill to the heap, everything is still released by reset
+static int test_spill()
+{
+    char block[64];
+    cJSON_Arena arena;
+    cJSON_InitArena(&arena, block, sizeof(block));
+    cJSON *root = cJSON_ParseWithArena(&arena, sCommands[2]);
+    cJSON *payload = cJSON_GetObjectItem(root, "payload");
+    const char *audioId = cJSON_GetStringValue(cJSON_GetObjectItem(payload, "audioId"));
+    int ret = (audioId != NULL && strcmp(audioId, "123456") == 0 && arena.spill_count > 0) ? 0 : -1;
+    if (ret != 0)
+        OS_LOGE(LOG_TAG, "Spill test failed, spill_count=%d", (int)arena.spill_count);
+    cJSON_ResetArena(&arena);
+    if (arena.spills != NULL || arena.offset != 0)
+        ret = -1;
+
+    // invalid json must not leak or touch freed memory
+    if (cJSON_ParseWithArena(&arena, "{\"a\":[1,2,{\"b\":\"c\"") != NULL)
+        ret = -1;
+    cJSON_ResetArena(&arena);
+    return ret;
+}
+
+static void benchmark(cJSON_Arena *arena, const char *text)
+{
+    const char *name = NULL;
+    unsigned long mallocs;
+    unsigned long long start, heapCost, arenaCost;
+
+    sMallocCount = 0;
+    start = os_monotonic_usec();
+    for (int i = 0; i < ROUNDS; i++) {
+        cJSON *root = cJSON_Parse(text);
+        char *printed = cJSON_PrintUnformatted(cJSON_GetObjectItem(root, "payload"));
+        cJSON_free(printed);
+        cJSON_Delete(root);
+    }
+    heapCost = os_monotonic_usec() - start;
+    mallocs = sMallocCount;
+
+    sMallocCount = 0;
+    arena->peak = 0;
+    start = os_monotonic_usec();
+    for (int i = 0; i < ROUNDS; i++) {
+        cJSON *root = cJSON_ParseWithArena(arena, text);
+        cJSON_PrintWithArena(arena, cJSON_GetObjectItem(root, "payload"), false);
+        if (i == 0)
+            name = cJSON_GetStringValue(cJSON_GetObjectItem(root, "commandName"));
+        if (i < ROUNDS - 1)
+            cJSON_ResetArena(arena);
+    }
+    arenaCost = os_monotonic_usec() - start;
+
+    OS_LOGI(LOG_TAG, "%-12s %4d bytes: heap %5.1f mallocs %5.2fus, arena %5.1f mallocs %5.2fus, arena peak %d bytes",
+            name, (int)strlen(text),
+            (double)mallocs/ROUNDS, (double)heapCost/ROUNDS,
+            (double)sMallocCount/ROUNDS, (double)arenaCost/ROUNDS, (int)arena->peak);
+    cJSON_ResetArena(arena);
+}
+
+int main()
+{
+    int ret = 0;
+    static char block[ARENA_SIZE];
+    cJSON_Arena arena;
+    cJSON_InitArena(&arena, block, sizeof(block));
+
+    for (int i = 0; i < sizeof(sCommands)/sizeof(sCommands[0]); i++)
+        ret |= test_equivalence(&arena, sCommands[i]);
+    ret |= test_spill();
+
+    // parse and print one payload per command, as GenieService does for public listeners
+    cJSON_Hooks hooks = { .malloc_fn = counting_malloc, .free_fn = free };
+    cJSON_InitHooks(&hooks);
+    for (int i = 0; i < sizeof(sCommands)/sizeof(sCommands[0]); i++)
+        benchmark(&arena, sCommands[i]);
+    cJSON_InitHooks(NULL);
+
+    OS_LOGI(LOG_TAG, "cjson arena test %s", ret == 0 ? "passed" : "failed");
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <string.h>
+#include "osal/os_time.h"
+#include "cutils/memory_helper.h"
+#include "cutils/log_helper.h"
+#include "cutils/ringbuf.h"
+
+#define LOG_TAG "ringbuf_test"
+
+#define RINGBUF_SIZE        (32*1024)
+#define SOURCE_CHUNK_SIZE   (8*1024+1)   // same as liteplayer media source
+#define DECODER_CHUNK_SIZE  3528         // 20ms of 44.1kHz/16bit/stereo pcm
+#define PAYLOAD_TOTAL       (64*1024*1024)
+#define PLAYBACK_BYTERATE   (44100*2*2)
+
+struct pipeline {
+    ringbuf_handle rb;
+    bool zero_copy;
+    unsigned long long memcpy_bytes;  // copies other than source-fill and decode
+};
+
+static void fill_pattern(char *buf, int size, unsigned int pos)
+{
+    for (int i = 0; i < size; i++)
+        buf[i] = (char)((pos + i) * 31);
+}
+
+static bool check_pattern(const char *buf, int size, unsigned int pos)
+{
+    for (int i = 0; i < size; i++) {
+        if (buf[i] != (char)((pos + i) * 31))
+            return false;
+    }
+    return true;
+}
+
+static int test_reserve_peek(ringbuf_handle rb)
+{
+    unsigned int wpos = 0, rpos = 0;
+    int short_peeks = 0;
+
+    // Odd write/read sizes walk the pointers across the end of buffer many times
+    for (int round = 0; round < 10000; round++) {
+        char *buf = NULL;
+        int ret = rb_reserve_write(rb, &buf, 1000, 100);
+        if (ret > 0) {
+            fill_pattern(buf, ret, wpos);
+            rb_commit_write(rb, ret);
+            wpos += ret;
+        }
+
+        ret = rb_peek_contiguous(rb, &buf, 700, 100);
+        if (ret <= 0) {
+            OS_LOGE(LOG_TAG, "Failed to peek, ret:%d", ret);
+            return -1;
+        }
+        if (ret < 700)
+            short_peeks++;
+        if (!check_pattern(buf, ret, rpos)) {
+            OS_LOGE(LOG_TAG, "Data mismatch at %u", rpos);
+            return -1;
+        }
+        rb_consume(rb, ret);
+        rpos += ret;
+
+        // Drain occasionally so that both the rewind and the wrap path are exercised
+        if (round % 97 == 0) {
+            while (rb_bytes_filled(rb) > 0) {
+                ret = rb_peek_contiguous(rb, &buf, rb_bytes_filled(rb), 100);
+                if (ret <= 0 || !check_pattern(buf, ret, rpos)) {
+                    OS_LOGE(LOG_TAG, "Failed to drain, ret:%d", ret);
+                    return -1;
+                }
+                rb_consume(rb, ret);
+                rpos += ret;
+            }
+        }
+    }
+
+    if (rb_is_mirrored(rb) && short_peeks > 0) {
+        OS_LOGE(LOG_TAG, "Mirrored ringbuf returned %d short peeks", short_peeks);
+        return -1;
+    }
+    OS_LOGI(LOG_TAG, "reserve/peek: mirrored=%d, size=%d, bytes=%u, short peeks=%d",
+            rb_is_mirrored(rb), rb_get_size(rb), rpos, short_peeks);
+    return 0;
+}
+
+static int source_write(struct pipeline *p, char *scratch, unsigned int pos, int size)
+{
+    if (p->zero_copy) {
+        char *buf = NULL;
+        size = rb_reserve_write(p->rb, &buf, size, 10);
+        if (size <= 0)
+            return size;
+        memset(buf, (int)pos, size); // source read lands in ringbuf memory
+        rb_commit_write(p->rb, size);
+    } else {
+        memset(scratch, (int)pos, size); // source read lands in scratch buffer
+        size = rb_write_chunk(p->rb, scratch, size, 10);
+        if (size > 0)
+            p->memcpy_bytes += size;
+    }
+    return size;
+}
+
+static int decoder_read(struct pipeline *p, char *in, char *out)
+{
+    int ret;
+    if (p->zero_copy) {
+        char *buf = NULL;
+        ret = rb_peek_contiguous(p->rb, &buf, DECODER_CHUNK_SIZE, 10);
+        if (ret <= 0)
+            return ret;
+        memcpy(out, buf, ret); // decode from ringbuf memory
+        rb_consume(p->rb, ret);
+    } else {
+        ret = rb_read_chunk(p->rb, in, DECODER_CHUNK_SIZE, 10);
+        if (ret <= 0)
+            return ret;
+        p->memcpy_bytes += ret;
+        memcpy(out, in, ret); // decode from private buffer
+    }
+    return ret;
+}
+
+// Source and decoder run in one thread, as liteplayer does with a synchronous source,
+// so the cost measured is memory traffic and locking rather than thread scheduling
+static int run_pipeline(struct pipeline *p)
+{
+    char *scratch = OS_MALLOC(SOURCE_CHUNK_SIZE);
+    char *in = OS_MALLOC(DECODER_CHUNK_SIZE);
+    char *out = OS_MALLOC(DECODER_CHUNK_SIZE);
+    unsigned int written = 0;
+    unsigned long long total = 0;
+    unsigned long long cost = 0;
+    unsigned long long start = os_monotonic_usec();
+
+    while (total < PAYLOAD_TOTAL) {
+        while (written < PAYLOAD_TOTAL && rb_bytes_available(p->rb) >= SOURCE_CHUNK_SIZE) {
+            int size = PAYLOAD_TOTAL - written < SOURCE_CHUNK_SIZE ? PAYLOAD_TOTAL - written : SOURCE_CHUNK_SIZE;
+            int ret = source_write(p, scratch, written, size);
+            if (ret <= 0)
+                goto out;
+            written += ret;
+            if (written == PAYLOAD_TOTAL)
+                rb_done_write(p->rb);
+        }
+        int ret = decoder_read(p, in, out);
+        if (ret <= 0)
+            break;
+        total += ret;
+    }
+
+out:
+    cost = os_monotonic_usec() - start;
+    double ratio = (double)p->memcpy_bytes / (total > 0 ? total : 1);
+    OS_LOGI(LOG_TAG, "%s: %llu bytes, %.1f MB/s, extra memcpy %.2f B/B, %.0f B/s at 44.1kHz stereo playback",
+            p->zero_copy ? "zero-copy" : "copy     ", total,
+            total / (cost > 0 ? (double)cost : 1.0), ratio, ratio * PLAYBACK_BYTERATE);
+
+    OS_FREE(scratch);
+    OS_FREE(in);
+    OS_FREE(out);
+    return total == PAYLOAD_TOTAL ? 0 : -1;
+}
+
+int main()
+{
+    int ret = 0;
+
+    ringbuf_handle plain = rb_create(RINGBUF_SIZE);
+    ringbuf_handle mirrored = rb_create_mirrored(RINGBUF_SIZE);
+    if (plain == NULL || mirrored == NULL) {
+        OS_LOGE(LOG_TAG, "Failed to create ringbuf");
+        return 1;
+    }
+    ret |= test_reserve_peek(plain);
+    ret |= test_reserve_peek(mirrored);
+
+    struct pipeline copy = { .rb = plain, .zero_copy = false };
+    struct pipeline zero_copy = { .rb = mirrored, .zero_copy = true };
+    rb_reset(plain);
+    rb_reset(mirrored);
+    ret |= run_pipeline(&copy);
+    ret |= run_pipeline(&zero_copy);
+
+    rb_destroy(plain);
+    rb_destroy(mirrored);
+
+    OS_LOGI(LOG_TAG, "ringbuf test %s", ret == 0 ? "passed" : "failed");
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,365 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "osal/os_time.h"
+#include "osal/os_thread.h"
+#include "cutils/log_helper.h"
+#include "cutils/memory_helper.h"
+
+#include "GenieSdk.h"
+#include "core/GenieService.h"
+#include "GenieMockGateway.h"
+
+#define TAG "GenieLatency_Benchmark"
+
+#ifndef GENIE_MOCK_GATEWAY_PORT
+#define GENIE_MOCK_GATEWAY_PORT     18443
+#endif
+
+#define LATENCY_SPEECH_FILE         "test.wav"  // played as micphone input, end of file is end of speech
+#define LATENCY_SPEECH_FILE_HEADER  44
+#define LATENCY_TTS_FILE            "test.mp3"  // streamed by mock gateway as tts
+#define LATENCY_PCMOUT_FILE         "latency_out.pcm"
+
+#define LATENCY_ROUNDS_DEFAULT      20
+#define LATENCY_SAMPLES_MAX         256
+#define LATENCY_AUTHORIZE_TIMEOUT   10000 // ms
+#define LATENCY_TURN_TIMEOUT        10000 // ms
+#define LATENCY_ROUND_INTERVAL      500   // ms
+
+#define LATENCY_EXPECT_SPEECH_EVERY 5     // every 5th utterance gets a follow-up turn without wakeup
+#define LATENCY_PLAY_EVERY          3
+
+typedef enum {
+    LATENCY_PHASE_IDLE = 0,
+    LATENCY_PHASE_WAKEUP,       // wakeup triggered, waiting for prompt out
+    LATENCY_PHASE_PROMPT,       // prompt playing, waiting for recorder
+    LATENCY_PHASE_SPEECH,       // recorder streaming speech file
+    LATENCY_PHASE_THINKING,     // end of speech, waiting for first tts byte
+    LATENCY_PHASE_TTS,          // tts receiving, waiting for first audio out
+} Latency_Phase_t;
+
+typedef struct {
+    const char *name;
+    double samples[LATENCY_SAMPLES_MAX];
+    int count;
+} Latency_Metric_t;
+
+typedef struct {
+    os_mutex lock;
+    os_cond cond;
+    Latency_Phase_t phase;
+    unsigned long long wakeupUs;
+    unsigned long long speechEndUs;
+    unsigned long long ttsFirstByteUs;
+    int turnsDone;
+    bool isAuthorized;
+
+    FILE *pcmInFile;
+    unsigned long long pcmInOpenUs;
+    long long pcmInBytes;
+    int pcmInBytesPerSecond;
+    FILE *pcmOutFile;
+
+    Latency_Metric_t wakeupToPrompt;
+    Latency_Metric_t speechEndToTts;
+    Latency_Metric_t ttsToAudioOut;
+} Latency_Priv_t;
+
+static Latency_Priv_t       sLatency;
+static GenieSdk_Callback_t *sSdkCallback = NULL;
+
+static const char *bizType()       { return "mockBizType"; }
+static const char *bizGroup()      { return "mockBizGroup"; }
+static const char *bizSecret()     { return "mockBizSecret"; }
+static const char *caCert()        { return NULL; }
+static const char *macAddr()       { return "11:22:33:44:55:66"; }
+static const char *uuid()          { return NULL; } // unauthorized, activate with mock gateway
+static const char *accessToken()   { return NULL; }
+
+static int  sSpeakerVolume = 50;
+static bool sSpeakerMuted = false;
+static bool setSpeakerVolume(int volume) { sSpeakerVolume = volume; return true; }
+static int  getSpeakerVolume()           { return sSpeakerVolume; }
+static bool setSpeakerMuted(bool muted)  { sSpeakerMuted = muted; return true; }
+static bool getSpeakerMuted()            { return sSpeakerMuted; }
+
+static void Latency_Add_Sample(Latency_Metric_t *metric, unsigned long long fromUs, unsigned long long toUs)
+{
+    if (metric->count < LATENCY_SAMPLES_MAX)
+        metric->samples[metric->count++] = (toUs - fromUs)/1000.0;
+}
+
+static int Latency_Compare_Sample(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// nearest-rank percentile
+static double Latency_Percentile(Latency_Metric_t *metric, int percent)
+{
+    int rank = (metric->count*percent + 99)/100;
+    if (rank < 1) rank = 1;
+    return metric->samples[rank - 1];
+}
+
+static void Latency_Report_Metric(Latency_Metric_t *metric)
+{
+    if (metric->count == 0) {
+        OS_LOGW(TAG, "%-36s n=0", metric->name);
+        return;
+    }
+    qsort(metric->samples, metric->count, sizeof(double), Latency_Compare_Sample);
+    OS_LOGI(TAG, "%-36s n=%-3d p50=%7.1fms p95=%7.1fms p99=%7.1fms max=%7.1fms",
+            metric->name, metric->count,
+            Latency_Percentile(metric, 50), Latency_Percentile(metric, 95),
+            Latency_Percentile(metric, 99), metric->samples[metric->count - 1]);
+}
+
+static void *pcmOutOpen(int sampleRate, int channelCount, int bitsPerSample)
+{
+    OS_LOGD(TAG, "pcmOutOpen: sampleRate=%d, channelCount=%d, bitsPerSample=%d", sampleRate, channelCount, bitsPerSample);
+    return sLatency.pcmOutFile;
+}
+
+static int pcmOutWrite(void *handle, void *buffer, unsigned int size)
+{
+    unsigned long long nowUs = os_monotonic_usec();
+    os_mutex_lock(sLatency.lock);
+    if (sLatency.phase == LATENCY_PHASE_WAKEUP) {
+        Latency_Add_Sample(&sLatency.wakeupToPrompt, sLatency.wakeupUs, nowUs);
+        sLatency.phase = LATENCY_PHASE_PROMPT;
+    } else if (sLatency.phase == LATENCY_PHASE_TTS) {
+        Latency_Add_Sample(&sLatency.ttsToAudioOut, sLatency.ttsFirstByteUs, nowUs);
+        sLatency.phase = LATENCY_PHASE_IDLE;
+        sLatency.turnsDone++;
+        os_cond_signal(sLatency.cond);
+    }
+    os_mutex_unlock(sLatency.lock);
+    if (handle != NULL)
+        fwrite(buffer, 1, size, (FILE *)handle);
+    return size;
+}
+
+static void pcmOutClose(void *handle)
+{
+    OS_LOGD(TAG, "pcmOutClose");
+}
+
+static void *pcmInOpen(int sampleRate, int channelCount, int bitsPerSample)
+{
+    FILE *file = fopen(LATENCY_SPEECH_FILE, "rb");
+    if (file == NULL) {
+        OS_LOGE(TAG, "Failed to open %s", LATENCY_SPEECH_FILE);
+        return NULL;
+    }
+    fseek(file, LATENCY_SPEECH_FILE_HEADER, SEEK_SET);
+    os_mutex_lock(sLatency.lock);
+    sLatency.pcmInFile = file;
+    sLatency.pcmInOpenUs = os_monotonic_usec();
+    sLatency.pcmInBytes = 0;
+    sLatency.pcmInBytesPerSecond = sampleRate*channelCount*bitsPerSample/8;
+    sLatency.phase = LATENCY_PHASE_SPEECH;
+    os_mutex_unlock(sLatency.lock);
+    return file;
+}
+
+// Paced like a real micphone; at end of file, report silence as a vad would
+static int pcmInRead(void *handle, void *buffer, unsigned int size)
+{
+    unsigned long long dueUs = sLatency.pcmInOpenUs +
+        (sLatency.pcmInBytes + size)*1000000ULL/sLatency.pcmInBytesPerSecond;
+    unsigned long long nowUs = os_monotonic_usec();
+    if (dueUs > nowUs)
+        os_thread_sleep_usec(dueUs - nowUs);
+    sLatency.pcmInBytes += size;
+
+    int nread = fread(buffer, 1, size, (FILE *)handle);
+    if (nread < (int)size) {
+        memset((char *)buffer + nread, 0x0, size - nread);
+        bool speechEnd = false;
+        os_mutex_lock(sLatency.lock);
+        if (sLatency.phase == LATENCY_PHASE_SPEECH) {
+            sLatency.speechEndUs = os_monotonic_usec();
+            sLatency.phase = LATENCY_PHASE_THINKING;
+            speechEnd = true;
+        }
+        os_mutex_unlock(sLatency.lock);
+        if (speechEnd)
+            sSdkCallback->onMicphoneSilence();
+    }
+    return size;
+}
+
+static void pcmInClose(void *handle)
+{
+    fclose((FILE *)handle);
+}
+
+static void ttsListener(char *data, int len, bool final)
+{
+    if (len <= 0) return;
+    os_mutex_lock(sLatency.lock);
+    if (sLatency.phase == LATENCY_PHASE_THINKING) {
+        sLatency.ttsFirstByteUs = os_monotonic_usec();
+        Latency_Add_Sample(&sLatency.speechEndToTts, sLatency.speechEndUs, sLatency.ttsFirstByteUs);
+        sLatency.phase = LATENCY_PHASE_TTS;
+    }
+    os_mutex_unlock(sLatency.lock);
+}
+
+static void statusListener(Genie_Status_t status)
+{
+    if (status == GENIE_STATUS_Authorized || status == GENIE_STATUS_Unauthorized) {
+        os_mutex_lock(sLatency.lock);
+        sLatency.isAuthorized = status == GENIE_STATUS_Authorized;
+        os_cond_signal(sLatency.cond);
+        os_mutex_unlock(sLatency.lock);
+    }
+}
+
+static bool Latency_Wait_Authorized()
+{
+    unsigned long long deadlineUs = os_monotonic_usec() + LATENCY_AUTHORIZE_TIMEOUT*1000ULL;
+    os_mutex_lock(sLatency.lock);
+    while (!sLatency.isAuthorized && os_monotonic_usec() < deadlineUs)
+        os_cond_timedwait(sLatency.cond, sLatency.lock, 100000);
+    bool authorized = sLatency.isAuthorized;
+    os_mutex_unlock(sLatency.lock);
+    return authorized;
+}
+
+static bool Latency_Wait_Turns(int turns)
+{
+    unsigned long long deadlineUs = os_monotonic_usec() + LATENCY_TURN_TIMEOUT*1000ULL;
+    os_mutex_lock(sLatency.lock);
+    while (sLatency.turnsDone < turns && os_monotonic_usec() < deadlineUs)
+        os_cond_timedwait(sLatency.cond, sLatency.lock, 100000);
+    bool done = sLatency.turnsDone >= turns;
+    if (!done)
+        OS_LOGE(TAG, "Turn %d timeout in phase %d", turns, sLatency.phase);
+    sLatency.phase = LATENCY_PHASE_IDLE;
+    os_mutex_unlock(sLatency.lock);
+    return done;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : LATENCY_ROUNDS_DEFAULT;
+    int turns = 0, ret = -1;
+
+    memset(&sLatency, 0x0, sizeof(sLatency));
+    sLatency.wakeupToPrompt.name = "wakeup -> prompt out";
+    sLatency.speechEndToTts.name = "end of speech -> first tts byte";
+    sLatency.ttsToAudioOut.name  = "first tts byte -> first audio out";
+    sLatency.lock = os_mutex_create();
+    sLatency.cond = os_cond_create();
+    sLatency.pcmOutFile = fopen(LATENCY_PCMOUT_FILE, "wb");
+
+    GnMockGateway_Config_t gatewayConfig = {
+        .port = GENIE_MOCK_GATEWAY_PORT,
+        .ttsFile = LATENCY_TTS_FILE,
+        .activateDelayMs = 50,
+        .asrDelayMs = 200,
+        .nluDelayMs = 100,
+        .ttsDelayMs = 80,
+        .ttsChunkSize = 1024,
+        .ttsChunkIntervalMs = 20,
+        .expectSpeechEvery = LATENCY_EXPECT_SPEECH_EVERY,
+        .playEvery = LATENCY_PLAY_EVERY,
+    };
+    if (!GnMockGateway_Start(&gatewayConfig)) {
+        OS_LOGE(TAG, "Failed to GnMockGateway_Start");
+        goto __exit;
+    }
+
+    GnVendor_Wrapper_t adapter = {
+        .bizType = bizType,
+        .bizGroup = bizGroup,
+        .bizSecret = bizSecret,
+        .caCert = caCert,
+        .macAddr = macAddr,
+        .uuid = uuid,
+        .accessToken = accessToken,
+        .pcmOutOpen = pcmOutOpen,
+        .pcmOutWrite = pcmOutWrite,
+        .pcmOutClose = pcmOutClose,
+        .pcmInOpen = pcmInOpen,
+        .pcmInRead = pcmInRead,
+        .pcmInClose = pcmInClose,
+        .setSpeakerVolume = setSpeakerVolume,
+        .getSpeakerVolume = getSpeakerVolume,
+        .setSpeakerMuted = setSpeakerMuted,
+        .getSpeakerMuted = getSpeakerMuted,
+    };
+    if (!GenieSdk_Init(&adapter)) {
+        OS_LOGE(TAG, "Failed to GenieSdk_Init");
+        goto __exit;
+    }
+    if (!GenieSdk_Get_Callback(&sSdkCallback)) {
+        OS_LOGE(TAG, "Failed to GenieSdk_Get_Callback");
+        goto __exit;
+    }
+    // registered before player starts, so first tts byte is stamped before it is queued for decoding
+    GnService_Register_TtsbinaryListener(ttsListener);
+    GenieSdk_Register_StatusListener(statusListener);
+    if (!GenieSdk_Start()) {
+        OS_LOGE(TAG, "Failed to GenieSdk_Start");
+        goto __exit;
+    }
+    sSdkCallback->onNetworkConnected();
+
+    if (!Latency_Wait_Authorized()) {
+        OS_LOGE(TAG, "Failed to activate with mock gateway");
+        goto __exit;
+    }
+    os_thread_sleep_msec(LATENCY_ROUND_INTERVAL);
+
+    for (int round = 0; round < rounds; round++) {
+        os_mutex_lock(sLatency.lock);
+        sLatency.phase = LATENCY_PHASE_WAKEUP;
+        sLatency.wakeupUs = os_monotonic_usec();
+        os_mutex_unlock(sLatency.lock);
+        sSdkCallback->onMicphoneWakeup("ni hao tian mao", 0, 0.600998834);
+        if (!Latency_Wait_Turns(++turns))
+            goto __exit;
+        if (turns % LATENCY_EXPECT_SPEECH_EVERY == 0) {
+            // gateway asked a follow-up question, recorder reopens after RECORD_REMIND
+            if (!Latency_Wait_Turns(++turns))
+                goto __exit;
+        }
+        os_thread_sleep_msec(LATENCY_ROUND_INTERVAL);
+    }
+    ret = 0;
+
+__exit:
+    GenieSdk_Stop();
+    GnMockGateway_Stop();
+    GnMockGateway_Dump_Events();
+
+    OS_LOGI(TAG, "Latency over %d turns (%d rounds):", turns, rounds);
+    Latency_Report_Metric(&sLatency.wakeupToPrompt);
+    Latency_Report_Metric(&sLatency.speechEndToTts);
+    Latency_Report_Metric(&sLatency.ttsToAudioOut);
+
+    if (sLatency.pcmOutFile != NULL)
+        fclose(sLatency.pcmOutFile);
+    os_cond_destroy(sLatency.cond);
+    os_mutex_destroy(sLatency.lock);
+    return ret;
+}
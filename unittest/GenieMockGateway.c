@@ -0,0 +1,461 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+
+#include "osal/os_time.h"
+#include "osal/os_thread.h"
+#include "cutils/list.h"
+#include "cutils/log_helper.h"
+#include "cutils/memory_helper.h"
+#include "json/cJSON.h"
+
+#include "nopoll.h"
+#include "GenieMockGateway.h"
+
+#define TAG "GenieMockGateway"
+
+#define GN_MOCK_THREAD_NAME         "GnMockGateway"
+#define GN_MOCK_THREAD_PRIO         OS_THREAD_PRIO_NORMAL
+#define GN_MOCK_THREAD_STACK        8192
+
+#define GN_MOCK_POLL_INTERVAL       5     // ms, upper bound of scripted delay jitter
+#define GN_MOCK_SEND_RETRY          20
+#define GN_MOCK_EVENT_MAX           1024
+#define GN_MOCK_EVENT_NAME_SIZE     64
+
+#define GN_MOCK_UUID                "8f1e6c2a-3b7d-4e9a-a1c5-0d2f4b6e8a9c"
+#define GN_MOCK_ACCESS_TOKEN        "5c9a1e3f-7b2d-4f6a-8e0c-1a3b5d7f9e2c"
+#define GN_MOCK_ASR_TEXT            "what is the weather today"
+#define GN_MOCK_NLU_TEXT            "Sunny today, 18 to 26 degrees"
+
+typedef enum {
+    GN_MOCK_ACTION_TEXT = 0,    // send a command
+    GN_MOCK_ACTION_TTS,         // send next tts chunk, reschedule itself until the file is done
+} GnMockGateway_ActionType_t;
+
+typedef struct {
+    unsigned long long dueUs;
+    GnMockGateway_ActionType_t type;
+    char *text;
+    int ttsOffset;
+    bool playAfterTts;
+    struct listnode listnode;
+} GnMockGateway_Action_t;
+
+typedef struct {
+    unsigned long long arrivalUs;
+    char name[GN_MOCK_EVENT_NAME_SIZE];
+} GnMockGateway_Event_t;
+
+typedef struct {
+    GnMockGateway_Config_t config;
+    noPollCtx *ctx;
+    noPollConn *listener;
+    noPollConn *conn;
+    os_thread thread;
+    bool isThreadRunning;
+
+    char *ttsData;
+    int ttsSize;
+
+    unsigned long long startUs;
+    int utteranceCount;
+    long utteranceBytes;
+    struct listnode actionList;     // sorted by dueUs
+
+    GnMockGateway_Event_t events[GN_MOCK_EVENT_MAX];
+    int eventCount;
+} GnMockGateway_Priv_t;
+
+static GnMockGateway_Priv_t sGnMock;
+static bool                 sGnStarted = false;
+
+static void GnMockGateway_Record_Event(const char *name)
+{
+    if (sGnMock.eventCount >= GN_MOCK_EVENT_MAX)
+        return;
+    GnMockGateway_Event_t *event = &sGnMock.events[sGnMock.eventCount++];
+    event->arrivalUs = os_monotonic_usec();
+    snprintf(event->name, sizeof(event->name), "%s", name);
+    OS_LOGD(TAG, "Event arrived: %s", name);
+}
+
+static bool GnMockGateway_Complete_PendingWrite()
+{
+    int tries = 0;
+    while (nopoll_conn_pending_write_bytes(sGnMock.conn) > 0) {
+        if (tries++ >= GN_MOCK_SEND_RETRY)
+            return false;
+        os_thread_sleep_msec(1);
+        nopoll_conn_complete_pending_write(sGnMock.conn);
+    }
+    return true;
+}
+
+static void GnMockGateway_Send_Frame(bool fin, noPollOpCode opcode, const char *data, int len)
+{
+    if (sGnMock.conn == NULL || !nopoll_conn_is_ok(sGnMock.conn))
+        return;
+    int ret = nopoll_conn_send_frame(sGnMock.conn, fin, nopoll_false, opcode, len, (noPollPtr)data, 0);
+    if (ret != len && !GnMockGateway_Complete_PendingWrite())
+        OS_LOGE(TAG, "Failed to send frame: opcode=%d, len=%d, ret=%d", opcode, len, ret);
+}
+
+static void GnMockGateway_Post_Action(GnMockGateway_Action_t *action)
+{
+    struct listnode *item;
+    list_for_each(item, &sGnMock.actionList) {
+        GnMockGateway_Action_t *node = listnode_to_item(item, GnMockGateway_Action_t, listnode);
+        if (node->dueUs > action->dueUs) {
+            list_add_before(item, &action->listnode);
+            return;
+        }
+    }
+    list_add_tail(&sGnMock.actionList, &action->listnode);
+}
+
+static void GnMockGateway_Post_Command(int delayMs, const char *domain, const char *name, const char *payload)
+{
+    GnMockGateway_Action_t *action = OS_CALLOC(1, sizeof(GnMockGateway_Action_t));
+    if (action == NULL)
+        return;
+    int len = strlen(domain) + strlen(name) + strlen(payload) + 64;
+    action->text = OS_MALLOC(len);
+    if (action->text == NULL) {
+        OS_FREE(action);
+        return;
+    }
+    snprintf(action->text, len, "{\"commandDomain\":\"%s\",\"commandName\":\"%s\",\"payload\":%s}",
+             domain, name, payload);
+    action->type = GN_MOCK_ACTION_TEXT;
+    action->dueUs = os_monotonic_usec() + delayMs*1000ULL;
+    GnMockGateway_Post_Action(action);
+}
+
+static void GnMockGateway_Post_Tts(int delayMs, int offset, bool playAfterTts)
+{
+    GnMockGateway_Action_t *action = OS_CALLOC(1, sizeof(GnMockGateway_Action_t));
+    if (action == NULL)
+        return;
+    action->type = GN_MOCK_ACTION_TTS;
+    action->dueUs = os_monotonic_usec() + delayMs*1000ULL;
+    action->ttsOffset = offset;
+    action->playAfterTts = playAfterTts;
+    GnMockGateway_Post_Action(action);
+}
+
+static void GnMockGateway_Clear_Actions()
+{
+    struct listnode *item, *tmp;
+    list_for_each_safe(item, tmp, &sGnMock.actionList) {
+        GnMockGateway_Action_t *action = listnode_to_item(item, GnMockGateway_Action_t, listnode);
+        list_remove(item);
+        if (action->text != NULL)
+            OS_FREE(action->text);
+        OS_FREE(action);
+    }
+}
+
+static void GnMockGateway_Post_Play()
+{
+    char payload[512];
+    snprintf(payload, sizeof(payload),
+             "{\"audioUrl\":\"%s\",\"audioAnchor\":\"\",\"audioExt\":\"{}\",\"audioId\":\"mock%d\","
+             "\"audioName\":\"mock\",\"audioType\":\"music\",\"audioAlbum\":\"\",\"audioSource\":\"mock\","
+             "\"audioLength\":0,\"progress\":0}",
+             sGnMock.config.ttsFile, sGnMock.utteranceCount);
+    GnMockGateway_Post_Command(0, "AliGenie.Audio", "Play", payload);
+}
+
+// tmallgenie tts binary: non-final binary frame announces tts coming, then
+// continuation frames carry the mp3 stream, the final one closes it
+static void GnMockGateway_Handle_Tts(GnMockGateway_Action_t *action)
+{
+    static const char ttsHeader[16] = { 0 };
+    int offset = action->ttsOffset;
+
+    if (offset == 0)
+        GnMockGateway_Send_Frame(false, NOPOLL_BINARY_FRAME, ttsHeader, sizeof(ttsHeader));
+
+    int len = sGnMock.ttsSize - offset;
+    if (len > sGnMock.config.ttsChunkSize)
+        len = sGnMock.config.ttsChunkSize;
+    bool final = offset + len >= sGnMock.ttsSize;
+    GnMockGateway_Send_Frame(final, NOPOLL_CONTINUATION_FRAME, sGnMock.ttsData + offset, len);
+
+    if (!final)
+        GnMockGateway_Post_Tts(sGnMock.config.ttsChunkIntervalMs, offset + len, action->playAfterTts);
+    else if (action->playAfterTts)
+        GnMockGateway_Post_Play();
+}
+
+static void GnMockGateway_Run_DueActions()
+{
+    unsigned long long nowUs = os_monotonic_usec();
+    while (!list_empty(&sGnMock.actionList)) {
+        struct listnode *item = list_head(&sGnMock.actionList);
+        GnMockGateway_Action_t *action = listnode_to_item(item, GnMockGateway_Action_t, listnode);
+        if (action->dueUs > nowUs)
+            break;
+        list_remove(item);
+        if (action->type == GN_MOCK_ACTION_TEXT) {
+            OS_LOGD(TAG, "Send command: %s", action->text);
+            GnMockGateway_Send_Frame(true, NOPOLL_TEXT_FRAME, action->text, strlen(action->text));
+            OS_FREE(action->text);
+        } else {
+            GnMockGateway_Handle_Tts(action);
+        }
+        OS_FREE(action);
+    }
+}
+
+static void GnMockGateway_Handle_Utterance()
+{
+    int count = ++sGnMock.utteranceCount;
+    bool expectSpeech = sGnMock.config.expectSpeechEvery > 0 && count % sGnMock.config.expectSpeechEvery == 0;
+    bool play = !expectSpeech && sGnMock.config.playEvery > 0 && count % sGnMock.config.playEvery == 0;
+    char payload[256];
+
+    GnMockGateway_Post_Command(sGnMock.config.asrDelayMs, "AliGenie.Microphone", "StopListen", "{}");
+    GnMockGateway_Post_Command(sGnMock.config.asrDelayMs, "AliGenie.Text", "ListenResult",
+                               "{\"isLast\":true,\"outputText\":\"" GN_MOCK_ASR_TEXT "\"}");
+    snprintf(payload, sizeof(payload), "{\"text\":\"%s\",\"expectSpeech\":%s}",
+             GN_MOCK_NLU_TEXT, expectSpeech ? "true" : "false");
+    GnMockGateway_Post_Command(sGnMock.config.asrDelayMs + sGnMock.config.nluDelayMs,
+                               "AliGenie.Speaker", "Speak", payload);
+    if (sGnMock.ttsSize > 0)
+        GnMockGateway_Post_Tts(sGnMock.config.asrDelayMs + sGnMock.config.nluDelayMs + sGnMock.config.ttsDelayMs,
+                               0, play);
+}
+
+static void GnMockGateway_Handle_Text(const char *text)
+{
+    cJSON *rootJson = cJSON_Parse(text);
+    if (rootJson == NULL) {
+        GnMockGateway_Record_Event("InvalidText");
+        return;
+    }
+    char *eventNs = cJSON_GetStringValue(cJSON_GetObjectItem(rootJson, "eventNs"));
+    char *eventName = cJSON_GetStringValue(cJSON_GetObjectItem(rootJson, "eventName"));
+    if (eventNs == NULL || eventName == NULL) {
+        GnMockGateway_Record_Event("UnknownEvent");
+        cJSON_Delete(rootJson);
+        return;
+    }
+
+    char name[GN_MOCK_EVENT_NAME_SIZE];
+    snprintf(name, sizeof(name), "%s.%s", eventNs, eventName);
+    GnMockGateway_Record_Event(name);
+
+    if (strcmp(eventName, "GuestDeviceActivate") == 0) {
+        GnMockGateway_Post_Command(sGnMock.config.activateDelayMs, "AliGenie.Account", "GuestDeviceActivateResp",
+            "{\"data\":{\"uuid\":\"" GN_MOCK_UUID "\",\"accessToken\":\"" GN_MOCK_ACCESS_TOKEN "\"}}");
+    } else if (strcmp(eventName, "UserInfo") == 0) {
+        GnMockGateway_Post_Command(0, "AliGenie.Account", "UserInfoResp", "{}");
+    } else if (strcmp(eventName, "SynchronizeState") == 0) {
+        GnMockGateway_Post_Command(0, "AliGenie.System", "Success", "{}");
+    } else if (strcmp(eventName, "Recognize") == 0) {
+        GnMockGateway_Handle_Utterance();
+    }
+    cJSON_Delete(rootJson);
+}
+
+static void GnMockGateway_Handle_Message(noPollMsg *msg)
+{
+    noPollOpCode opcode = nopoll_msg_opcode(msg);
+    int size = nopoll_msg_get_payload_size(msg);
+    bool final = nopoll_msg_is_final(msg);
+
+    switch (opcode) {
+    case NOPOLL_TEXT_FRAME:
+        GnMockGateway_Handle_Text((const char *)nopoll_msg_get_payload(msg));
+        break;
+    case NOPOLL_BINARY_FRAME:
+        // speech binary header, see Genie_Create_MicrophoneBinaryHeader
+        GnMockGateway_Record_Event("SpeechBinary.Start");
+        sGnMock.utteranceBytes = 0;
+        break;
+    case NOPOLL_CONTINUATION_FRAME:
+        sGnMock.utteranceBytes += size;
+        if (final) {
+            char name[GN_MOCK_EVENT_NAME_SIZE];
+            snprintf(name, sizeof(name), "SpeechBinary.Final(%ld bytes)", sGnMock.utteranceBytes);
+            GnMockGateway_Record_Event(name);
+            GnMockGateway_Handle_Utterance();
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void GnMockGateway_Accept_Conn()
+{
+    noPollConn *conn = nopoll_conn_accept(sGnMock.ctx, sGnMock.listener);
+    if (conn == NULL)
+        return;
+    if (sGnMock.conn != NULL) {
+        OS_LOGW(TAG, "New client connected, drop the previous one");
+        nopoll_conn_close(sGnMock.conn);
+        GnMockGateway_Clear_Actions();
+    }
+    // accepted conn is owned by ctx only, but nopoll_conn_close drops both ctx and caller reference
+    nopoll_conn_ref(conn);
+    // accepted socket is blocking, reads are driven by poll() below
+    NOPOLL_SOCKET session = nopoll_conn_socket(conn);
+    fcntl(session, F_SETFL, fcntl(session, F_GETFL, 0) | O_NONBLOCK);
+    sGnMock.conn = conn;
+    GnMockGateway_Record_Event("Connected");
+}
+
+static void *GnMockGateway_Thread_Entry(void *arg)
+{
+    OS_LOGD(TAG, "GnMockGateway thread enter");
+    while (sGnMock.isThreadRunning) {
+        struct pollfd fds[2];
+        int nfds = 0;
+        fds[nfds].fd = nopoll_conn_socket(sGnMock.listener);
+        fds[nfds++].events = POLLIN;
+        if (sGnMock.conn != NULL) {
+            fds[nfds].fd = nopoll_conn_socket(sGnMock.conn);
+            fds[nfds++].events = POLLIN;
+        }
+
+        int timeout = GN_MOCK_POLL_INTERVAL;
+        if (!list_empty(&sGnMock.actionList)) {
+            GnMockGateway_Action_t *action =
+                listnode_to_item(list_head(&sGnMock.actionList), GnMockGateway_Action_t, listnode);
+            unsigned long long nowUs = os_monotonic_usec();
+            int dueMs = action->dueUs > nowUs ? (int)((action->dueUs - nowUs + 999)/1000) : 0;
+            if (dueMs < timeout)
+                timeout = dueMs;
+        }
+        poll(fds, nfds, timeout);
+
+        if (fds[0].revents & POLLIN)
+            GnMockGateway_Accept_Conn();
+
+        if (sGnMock.conn != NULL) {
+            noPollMsg *msg;
+            while ((msg = nopoll_conn_get_msg(sGnMock.conn)) != NULL) {
+                GnMockGateway_Handle_Message(msg);
+                nopoll_msg_unref(msg);
+            }
+            if (!nopoll_conn_is_ok(sGnMock.conn)) {
+                GnMockGateway_Record_Event("Disconnected");
+                nopoll_conn_close(sGnMock.conn);
+                sGnMock.conn = NULL;
+                GnMockGateway_Clear_Actions();
+            }
+        }
+
+        GnMockGateway_Run_DueActions();
+    }
+    OS_LOGD(TAG, "GnMockGateway thread leave");
+    return NULL;
+}
+
+static bool GnMockGateway_Load_TtsFile(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        OS_LOGE(TAG, "Failed to open tts file: %s", path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size > 0 && (sGnMock.ttsData = OS_MALLOC(size)) != NULL)
+        sGnMock.ttsSize = fread(sGnMock.ttsData, 1, size, file);
+    fclose(file);
+    return sGnMock.ttsSize > 0;
+}
+
+bool GnMockGateway_Start(GnMockGateway_Config_t *config)
+{
+    if (sGnStarted) return true;
+    if (config == NULL || config->ttsFile == NULL || config->ttsChunkSize <= 0) return false;
+
+    memset(&sGnMock, 0x0, sizeof(sGnMock));
+    memcpy(&sGnMock.config, config, sizeof(GnMockGateway_Config_t));
+    list_init(&sGnMock.actionList);
+
+    if (!GnMockGateway_Load_TtsFile(config->ttsFile))
+        goto __error_start;
+
+    char port[16];
+    snprintf(port, sizeof(port), "%d", config->port);
+    if ((sGnMock.ctx = nopoll_ctx_new()) == NULL)
+        goto __error_start;
+    sGnMock.listener = nopoll_listener_new(sGnMock.ctx, "127.0.0.1", port);
+    if (!nopoll_conn_is_ok(sGnMock.listener)) {
+        OS_LOGE(TAG, "Failed to listen on 127.0.0.1:%s", port);
+        goto __error_start;
+    }
+    nopoll_conn_ref(sGnMock.listener); // same as accepted conn, see GnMockGateway_Accept_Conn
+
+    struct os_thread_attr thread_attr = {
+        .name = GN_MOCK_THREAD_NAME,
+        .priority = GN_MOCK_THREAD_PRIO,
+        .stacksize = GN_MOCK_THREAD_STACK,
+        .joinable = true,
+    };
+    sGnMock.startUs = os_monotonic_usec();
+    sGnMock.isThreadRunning = true;
+    sGnMock.thread = os_thread_create(&thread_attr, GnMockGateway_Thread_Entry, NULL);
+    if (sGnMock.thread == NULL)
+        goto __error_start;
+
+    OS_LOGI(TAG, "Mock gateway listening on 127.0.0.1:%s, tts: %s (%d bytes)", port, config->ttsFile, sGnMock.ttsSize);
+    sGnStarted = true;
+    return true;
+
+__error_start:
+    sGnMock.isThreadRunning = false;
+    if (sGnMock.listener != NULL)   nopoll_conn_close(sGnMock.listener);
+    if (sGnMock.ctx != NULL)        nopoll_ctx_unref(sGnMock.ctx);
+    if (sGnMock.ttsData != NULL)    OS_FREE(sGnMock.ttsData);
+    return false;
+}
+
+void GnMockGateway_Dump_Events()
+{
+    OS_LOGI(TAG, "Client events (%d), arrival time relative to gateway start:", sGnMock.eventCount);
+    for (int i = 0; i < sGnMock.eventCount; i++) {
+        GnMockGateway_Event_t *event = &sGnMock.events[i];
+        OS_LOGI(TAG, "  %10.1fms  %s", (event->arrivalUs - sGnMock.startUs)/1000.0, event->name);
+    }
+}
+
+void GnMockGateway_Stop()
+{
+    if (!sGnStarted) return;
+
+    sGnMock.isThreadRunning = false;
+    os_thread_join(sGnMock.thread, NULL);
+
+    GnMockGateway_Clear_Actions();
+    if (sGnMock.conn != NULL)
+        nopoll_conn_close(sGnMock.conn);
+    nopoll_conn_close(sGnMock.listener);
+    nopoll_ctx_unref(sGnMock.ctx);
+    OS_FREE(sGnMock.ttsData);
+    sGnStarted = false;
+}
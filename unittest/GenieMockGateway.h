@@ -0,0 +1,59 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __TMALLGENIE_MOCK_GATEWAY_H__
+#define __TMALLGENIE_MOCK_GATEWAY_H__
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Local stand-in for g-aicloud.alibaba.com, built on nopoll listener. Build GenieService.c
+// with GENIE_HAVE_MOCK_GATEWAY_ENABLED to connect it here instead of the real gateway.
+//
+// Scripted flow:
+//   GuestDeviceActivate  --activateDelayMs-->  GuestDeviceActivateResp
+//   UserInfo                                   UserInfoResp
+//   SynchronizeState                           Success
+//   speech binary final  --asrDelayMs-->       StopListen, ListenResult
+//                        --nluDelayMs-->       Speak (expectSpeech every expectSpeechEvery utterances)
+//                        --ttsDelayMs-->       tts binary, ttsChunkSize bytes every ttsChunkIntervalMs
+//                                              Play (every playEvery utterances, after tts finished)
+typedef struct {
+    int port;
+    const char *ttsFile;        // mp3 streamed as tts binary, also used as Play audioUrl
+    int activateDelayMs;
+    int asrDelayMs;
+    int nluDelayMs;
+    int ttsDelayMs;
+    int ttsChunkSize;
+    int ttsChunkIntervalMs;
+    int expectSpeechEvery;      // 0: never ask a follow-up question
+    int playEvery;              // 0: never send Play
+} GnMockGateway_Config_t;
+
+bool GnMockGateway_Start(GnMockGateway_Config_t *config);
+
+// log every client event with its arrival time, relative to gateway start
+void GnMockGateway_Dump_Events();
+
+void GnMockGateway_Stop();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TMALLGENIE_MOCK_GATEWAY_H__ */
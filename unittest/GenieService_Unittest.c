@@ -33,7 +33,7 @@ static const char *macAddr()       { return "11:22:33:44:55:66"; } // FIXME: fil
 static const char *uuid()          { return NULL; }
 static const char *accessToken()   { return NULL; }
 
-static void commandListener(Genie_Domain_t domain, Genie_Command_t command, const char *payload)
+static void commandListener(Genie_Domain_t domain, Genie_Command_t command, const cJSON *payload)
 {
     OS_LOGD(TAG, "Received command: domain=%d, command=%d", domain, command);
 }
@@ -0,0 +1,200 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Stress test of src/base/listener_set, built with AddressSanitizer: reader threads
+// notify in a loop and stay pinned a while, one writer adds and removes listeners as fast
+// as it can. A listener array freed before its readers drained is a use-after-free ASan
+// reports. Readers also check that the listener that is never removed is always there
+// and that every listener they get is a real one. Finally a forked child adds from inside
+// a listener, which must hit the assert instead of deadlocking.
+//
+//   ListenerSet_Unittest [writer iterations, default 5000]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "osal/os_thread.h"
+#include "cutils/log_helper.h"
+
+#include "base/listener_set.h"
+
+#define TAG "ListenerSet_Unittest"
+
+#define TEST_READERS        4
+#define TEST_LISTENERS      6   // listener 0 is never removed
+#define TEST_SPIN           200 // iterations a reader stays pinned after its first pass
+
+typedef void (*test_listener_t)(int reader);
+
+static listener_set_handle_t sTestSet;
+static atomic_bool sTestStop;
+static atomic_int sTestRunning;
+static atomic_uint sTestCalls[TEST_LISTENERS];
+static atomic_uint sTestErrors;
+
+#define TEST_LISTENER(n) \
+    static void testListener##n(int reader) { atomic_fetch_add_explicit(&sTestCalls[n], 1, memory_order_relaxed); }
+TEST_LISTENER(0)
+TEST_LISTENER(1)
+TEST_LISTENER(2)
+TEST_LISTENER(3)
+TEST_LISTENER(4)
+TEST_LISTENER(5)
+
+static const test_listener_t sTestListeners[TEST_LISTENERS] = {
+    testListener0, testListener1, testListener2, testListener3, testListener4, testListener5,
+};
+
+static int testListenerIndex(listener_fn_t listener)
+{
+    for (int i = 0; i < TEST_LISTENERS; i++) {
+        if ((listener_fn_t)sTestListeners[i] == listener)
+            return i;
+    }
+    return -1;
+}
+
+static void *testReaderEntry(void *arg)
+{
+    int reader = (int)(long)arg;
+    unsigned long notifications = 0;
+    atomic_fetch_add(&sTestRunning, 1);
+    while (!atomic_load(&sTestStop)) {
+        listener_set_reader_t pin;
+        bool pinned = false;
+        listener_set_read_begin(sTestSet, &pin);
+        for (int i = 0; i < pin.count; i++) {
+            int index = testListenerIndex(pin.listeners[i]);
+            if (index < 0) {
+                atomic_fetch_add(&sTestErrors, 1);
+                continue;
+            }
+            pinned = pinned || index == 0;
+            ((test_listener_t)pin.listeners[i])(reader);
+        }
+        // stay pinned and read the array again, a writer that freed it early trips ASan
+        for (volatile int spin = 0; spin < TEST_SPIN; spin++);
+        for (int i = 0; i < pin.count; i++) {
+            if (testListenerIndex(pin.listeners[i]) < 0)
+                atomic_fetch_add(&sTestErrors, 1);
+        }
+        listener_set_read_end(sTestSet, &pin);
+        if (!pinned)
+            atomic_fetch_add(&sTestErrors, 1);
+        notifications++;
+    }
+    OS_LOGI(TAG, "Reader %d: %lu notifications", reader, notifications);
+    return NULL;
+}
+
+static void testReentrantListener(void)
+{
+    listener_set_add(sTestSet, (listener_fn_t)testListener1);
+}
+
+// Child process: add from a listener of the same set, the assert must abort it
+static bool testReentrantAdd()
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0)
+        return false;
+    if (pid == 0) {
+        listener_set_handle_t set = listener_set_create();
+        sTestSet = set;
+        listener_set_add(set, (listener_fn_t)testReentrantListener);
+        listener_set_reader_t pin;
+        listener_set_read_begin(set, &pin);
+        for (int i = 0; i < pin.count; i++)
+            ((void (*)(void))pin.listeners[i])();
+        listener_set_read_end(set, &pin);
+        _exit(0);
+    }
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid)
+        return false;
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 5000;
+    os_thread readers[TEST_READERS];
+    bool passed = true;
+
+    if (iterations <= 0)
+        iterations = 5000;
+    if ((sTestSet = listener_set_create()) == NULL) {
+        OS_LOGE(TAG, "Failed to create listener set");
+        return 1;
+    }
+    listener_set_add(sTestSet, (listener_fn_t)testListener0);
+
+    for (int i = 0; i < TEST_READERS; i++) {
+        struct os_thread_attr attr = {
+            .name = "listener_reader",
+            .priority = OS_THREAD_PRIO_NORMAL,
+            .stacksize = os_thread_default_stacksize(),
+            .joinable = true,
+        };
+        if ((readers[i] = os_thread_create(&attr, testReaderEntry, (void *)(long)i)) == NULL) {
+            OS_LOGE(TAG, "Failed to create reader thread");
+            return 1;
+        }
+    }
+
+    // the writer doesn't wait for anybody until readers are there
+    while (atomic_load(&sTestRunning) < TEST_READERS)
+        os_thread_sleep_msec(1);
+
+    unsigned int seed = 1;
+    for (int i = 0; i < iterations; i++) {
+        seed = seed * 1103515245 + 12345;
+        int index = 1 + (seed >> 16) % (TEST_LISTENERS - 1);
+        if (listener_set_add(sTestSet, (listener_fn_t)sTestListeners[index]) != 0)
+            atomic_fetch_add(&sTestErrors, 1);
+        seed = seed * 1103515245 + 12345;
+        index = 1 + (seed >> 16) % (TEST_LISTENERS - 1);
+        listener_set_remove(sTestSet, (listener_fn_t)sTestListeners[index]);
+    }
+
+    atomic_store(&sTestStop, true);
+    for (int i = 0; i < TEST_READERS; i++)
+        os_thread_join(readers[i], NULL);
+
+    for (int i = 0; i < TEST_LISTENERS; i++)
+        OS_LOGI(TAG, "Listener %d: %u calls", i, atomic_load(&sTestCalls[i]));
+    if (atomic_load(&sTestErrors) != 0) {
+        OS_LOGE(TAG, "%u bad reads", atomic_load(&sTestErrors));
+        passed = false;
+    }
+    if (atomic_load(&sTestCalls[0]) == 0) {
+        OS_LOGE(TAG, "Readers never ran");
+        passed = false;
+    }
+    listener_set_destroy(sTestSet);
+
+    if (!testReentrantAdd()) {
+        OS_LOGE(TAG, "Add from a listener of the same set didn't assert");
+        passed = false;
+    }
+
+    OS_LOGI(TAG, "%d writer iterations: %s", iterations, passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,324 @@
+// Copyright (c) 2021-2022 Qinglong<sysu.zqlong@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Uplink scheduling of src/base/websocket_client: lanes, late audio drop and fragment
+// coalescing. The scheduler cases include websocket_client.c and drive ws_client_dequeue
+// on a handle that has no thread, so what goes out in which order is deterministic. The
+// loopback case streams through a real connection to a nopoll listener, which checks
+// that the voice stream arrives complete and in byte order.
+//
+//   WebsocketClient_Unittest
+
+#include "base/websocket_client.c"
+
+#include <stdatomic.h>
+
+#define TEST_TAG                "WebsocketClient_Unittest"
+#define TEST_FRAGMENT_SIZE      640 // 20ms of 16kHz/16bit/mono pcm
+#define TEST_PORT               17012
+
+typedef struct {
+    int frames;             // audio frames dequeued, START included
+    int texts;
+    int text_at;            // audio frames dequeued before the first text
+    int bytes;
+    unsigned char stream[512 * TEST_FRAGMENT_SIZE];
+    bool finished;
+    bool oversized;         // a merged frame larger than WS_CLIENT_AUDIO_COALESCE_BYTES
+} test_uplink_t;
+
+static ws_client_handle_t test_client_new()
+{
+    ws_client_handle_t client = ws_client_create();
+    if (client != NULL)
+        client->conn_state = WS_CONN_STATE_CONNECTED; // send calls only enqueue, nothing runs them
+    return client;
+}
+
+static void test_send_fragment(ws_client_handle_t client, int index, ws_binary_type_t type)
+{
+    char fragment[TEST_FRAGMENT_SIZE];
+    memset(fragment, index, sizeof(fragment));
+    ws_client_send_binary(client, fragment, sizeof(fragment), type);
+}
+
+// Dequeues until nothing can be sent, as the client thread would
+static void test_drain(ws_client_handle_t client, test_uplink_t *uplink)
+{
+    ws_msg_t *msg;
+    os_mutex_lock(client->lock);
+    while ((msg = ws_client_dequeue(client)) != NULL) {
+        char *content = msg->xfer.unique_data != NULL ? msg->xfer.unique_data : msg->xfer.data;
+        if (msg->what == WS_CLIENT_CMD_SEND_TEXT) {
+            if (uplink->texts++ == 0)
+                uplink->text_at = uplink->frames;
+        } else if (msg->lane == WS_LANE_AUDIO) {
+            if (msg->xfer.len > WS_CLIENT_AUDIO_COALESCE_BYTES)
+                uplink->oversized = true;
+            if (msg->xfer.type != WS_BINARY_FRAGMENT_START &&
+                uplink->bytes + msg->xfer.len <= (int)sizeof(uplink->stream)) {
+                memcpy(uplink->stream + uplink->bytes, content, msg->xfer.len);
+                uplink->bytes += msg->xfer.len;
+            }
+            if (msg->xfer.type == WS_BINARY_FRAGMENT_FINISH)
+                uplink->finished = true;
+            uplink->frames++;
+        }
+        ws_client_free_msg(msg);
+    }
+    os_mutex_unlock(client->lock);
+}
+
+// The stream must be the fragments first..last, each TEST_FRAGMENT_SIZE bytes of its index
+static bool test_stream_is(const test_uplink_t *uplink, int first, int last)
+{
+    if (uplink->bytes != (last - first + 1) * TEST_FRAGMENT_SIZE)
+        return false;
+    for (int i = 0; i < uplink->bytes; i++) {
+        if (uplink->stream[i] != (unsigned char)(first + i / TEST_FRAGMENT_SIZE))
+            return false;
+    }
+    return true;
+}
+
+static void test_age_queued(ws_client_handle_t client, ws_lane_t lane, unsigned int ms)
+{
+    struct listnode *item;
+    os_mutex_lock(client->lock);
+    list_for_each(item, &client->lanes[lane].list) {
+        ws_msg_t *msg = listnode_to_item(item, ws_msg_t, listnode);
+        msg->enqueue_time -= ms;
+    }
+    os_mutex_unlock(client->lock);
+}
+
+// 300 fragments then a text, queued faster than the uplink takes them: the text goes
+// first, the audio lane keeps the newest WS_CLIENT_QUEUE_MESSAGE_MAX and the stream ends
+static bool test_lane_priority()
+{
+    static test_uplink_t uplink;
+    ws_client_handle_t client = test_client_new();
+    ws_lane_stats_t audio, control;
+    int fragments = 300;
+
+    memset(&uplink, 0, sizeof(uplink));
+    test_send_fragment(client, 0, WS_BINARY_FRAGMENT_START);
+    for (int i = 1; i <= fragments; i++)
+        test_send_fragment(client, i, WS_BINARY_FRAGMENT_CONTINUE);
+    ws_client_send_text(client, "{\"header\":{\"name\":\"PlayerSync\"}}", 32);
+    test_send_fragment(client, fragments + 1, WS_BINARY_FRAGMENT_FINISH);
+    test_drain(client, &uplink);
+    ws_client_get_lane_stats(client, WS_LANE_AUDIO, &audio);
+    ws_client_get_lane_stats(client, WS_LANE_CONTROL, &control);
+
+    // START and FINISH are never dropped, WS_CLIENT_QUEUE_MESSAGE_MAX - 2 continue survive
+    int kept = WS_CLIENT_QUEUE_MESSAGE_MAX - 2;
+    bool passed = uplink.texts == 1 && uplink.text_at == 0 && uplink.finished && !uplink.oversized &&
+                  audio.dropped == (unsigned int)(fragments - kept) &&
+                  test_stream_is(&uplink, fragments - kept + 1, fragments + 1) &&
+                  control.sent == 1 && audio.depth == 0;
+    OS_LOGI(TEST_TAG, "lane priority: text after %d audio frames, %d frames, %u dropped, %u coalesced: %s",
+            uplink.text_at, uplink.frames, audio.dropped, audio.coalesced, passed ? "PASSED" : "FAILED");
+    ws_client_destory(client);
+    return passed;
+}
+
+// Continue fragments older than WS_CLIENT_AUDIO_LATE_TIMEOUT are dropped, the START that
+// opened the stream is not
+static bool test_late_drop()
+{
+    static test_uplink_t uplink;
+    ws_client_handle_t client = test_client_new();
+    ws_lane_stats_t audio;
+
+    memset(&uplink, 0, sizeof(uplink));
+    test_send_fragment(client, 0, WS_BINARY_FRAGMENT_START);
+    for (int i = 1; i <= 20; i++)
+        test_send_fragment(client, i, WS_BINARY_FRAGMENT_CONTINUE);
+    test_age_queued(client, WS_LANE_AUDIO, WS_CLIENT_AUDIO_LATE_TIMEOUT + 100);
+    for (int i = 21; i <= 25; i++)
+        test_send_fragment(client, i, WS_BINARY_FRAGMENT_CONTINUE);
+    test_send_fragment(client, 26, WS_BINARY_FRAGMENT_FINISH);
+    test_drain(client, &uplink);
+    ws_client_get_lane_stats(client, WS_LANE_AUDIO, &audio);
+
+    bool passed = audio.dropped == 20 && uplink.finished && uplink.frames == 2 &&
+                  test_stream_is(&uplink, 21, 26);
+    OS_LOGI(TEST_TAG, "late drop: %u dropped, %d frames: %s", audio.dropped, uplink.frames,
+            passed ? "PASSED" : "FAILED");
+    ws_client_destory(client);
+    return passed;
+}
+
+// Queued fragments go out merged, up to WS_CLIENT_AUDIO_COALESCE_BYTES per frame, in
+// byte order: 80 continue fragments and the finish one take 7 frames after the START
+static bool test_merge_order()
+{
+    static test_uplink_t uplink;
+    ws_client_handle_t client = test_client_new();
+    ws_lane_stats_t audio;
+    int fragments = 80;
+    int per_frame = WS_CLIENT_AUDIO_COALESCE_BYTES / TEST_FRAGMENT_SIZE;
+
+    memset(&uplink, 0, sizeof(uplink));
+    test_send_fragment(client, 0, WS_BINARY_FRAGMENT_START);
+    for (int i = 1; i <= fragments; i++)
+        test_send_fragment(client, i, WS_BINARY_FRAGMENT_CONTINUE);
+    test_send_fragment(client, fragments + 1, WS_BINARY_FRAGMENT_FINISH);
+    test_drain(client, &uplink);
+    ws_client_get_lane_stats(client, WS_LANE_AUDIO, &audio);
+
+    int expected = 1 + (fragments + 1 + per_frame - 1) / per_frame;
+    bool passed = uplink.frames == expected && uplink.finished && !uplink.oversized &&
+                  audio.coalesced == (unsigned int)(fragments + 1 - (expected - 1)) &&
+                  test_stream_is(&uplink, 1, fragments + 1);
+    OS_LOGI(TEST_TAG, "merge order: %d fragments in %d frames (expected %d), %u coalesced: %s",
+            fragments + 2, uplink.frames, expected, audio.coalesced, passed ? "PASSED" : "FAILED");
+    ws_client_destory(client);
+    return passed;
+}
+
+// On a slow uplink a short run of fragments is held for more, up to
+// WS_CLIENT_AUDIO_COALESCE_HOLD; whole binary waits until the voice stream is finished
+static bool test_slow_uplink_hold()
+{
+    static test_uplink_t uplink;
+    ws_client_handle_t client = test_client_new();
+    bool passed = true;
+
+    memset(&uplink, 0, sizeof(uplink));
+    client->rtt = WS_CLIENT_UPLINK_SLOW_RTT + 1;
+    test_send_fragment(client, 0, WS_BINARY_FRAGMENT_START);
+    test_send_fragment(client, 1, WS_BINARY_FRAGMENT_CONTINUE);
+    test_send_fragment(client, 2, WS_BINARY_FRAGMENT_CONTINUE);
+    ws_client_send_binary(client, "bulk", 4, WS_BINARY_WHOLE);
+    test_drain(client, &uplink);
+    passed = passed && uplink.frames == 1 && uplink.bytes == 0;       // only START went out
+
+    test_age_queued(client, WS_LANE_AUDIO, WS_CLIENT_AUDIO_COALESCE_HOLD);
+    test_drain(client, &uplink);
+    passed = passed && uplink.frames == 2 && test_stream_is(&uplink, 1, 2);
+    passed = passed && client->lanes[WS_LANE_BULK].stats.sent == 0;  // stream still open
+
+    test_send_fragment(client, 3, WS_BINARY_FRAGMENT_FINISH);
+    test_drain(client, &uplink);
+    passed = passed && uplink.finished && test_stream_is(&uplink, 1, 3) &&
+             client->lanes[WS_LANE_BULK].stats.sent == 1;
+    OS_LOGI(TEST_TAG, "slow uplink hold: %s", passed ? "PASSED" : "FAILED");
+    ws_client_destory(client);
+    return passed;
+}
+
+static test_uplink_t sTestReceived;
+static atomic_bool sTestConnected;
+
+static void test_server_on_msg(noPollCtx *ctx, noPollConn *conn, noPollMsg *msg, noPollPtr user_data)
+{
+    const unsigned char *payload = (const unsigned char *)nopoll_msg_get_payload(msg);
+    int size = nopoll_msg_get_payload_size(msg);
+    test_uplink_t *uplink = &sTestReceived;
+
+    if (nopoll_msg_opcode(msg) == NOPOLL_TEXT_FRAME) {
+        if (uplink->texts++ == 0)
+            uplink->text_at = uplink->frames;
+        return;
+    }
+    // the START fragment is left out of the stream, as test_drain does
+    if (uplink->frames > 0 && uplink->bytes + size <= (int)sizeof(uplink->stream)) {
+        memcpy(uplink->stream + uplink->bytes, payload, size);
+        uplink->bytes += size;
+    }
+    uplink->frames++;
+    if (nopoll_msg_is_final(msg))
+        uplink->finished = true;
+    os_thread_sleep_msec(2); // slow reader, fragments queue up on the client
+}
+
+static void *test_server_entry(void *arg)
+{
+    nopoll_loop_wait((noPollCtx *)arg, 0);
+    return NULL;
+}
+
+static void test_on_connected()
+{
+    atomic_store(&sTestConnected, true);
+}
+
+// A voice stream with a text in the middle through a real connection
+static bool test_loopback()
+{
+    char port[8];
+    int fragments = 80;
+    snprintf(port, sizeof(port), "%d", TEST_PORT);
+
+    noPollCtx *ctx = nopoll_ctx_new();
+    noPollConn *listener = nopoll_listener_new(ctx, "127.0.0.1", port);
+    if (!nopoll_conn_is_ok(listener)) {
+        OS_LOGE(TEST_TAG, "Failed to listen on port %s", port);
+        return false;
+    }
+    nopoll_ctx_set_on_msg(ctx, test_server_on_msg, NULL);
+    struct os_thread_attr attr = {
+        .name = "ws_test_server",
+        .priority = OS_THREAD_PRIO_NORMAL,
+        .stacksize = os_thread_default_stacksize(),
+        .joinable = false,
+    };
+    os_thread_create(&attr, test_server_entry, ctx);
+
+    ws_client_handle_t client = ws_client_create();
+    ws_user_info_t info = { .port = TEST_PORT, .host = "127.0.0.1", .path = "/" };
+    info.callback.on_connected = test_on_connected;
+    ws_client_connect(client, &info);
+    for (int i = 0; i < 5000 && !atomic_load(&sTestConnected); i++)
+        os_thread_sleep_msec(1);
+    if (!atomic_load(&sTestConnected)) {
+        OS_LOGE(TEST_TAG, "Failed to connect");
+        return false;
+    }
+
+    test_send_fragment(client, 0, WS_BINARY_FRAGMENT_START);
+    for (int i = 1; i <= fragments; i++) {
+        test_send_fragment(client, i, WS_BINARY_FRAGMENT_CONTINUE);
+        if (i == fragments / 2)
+            ws_client_send_text(client, "{\"header\":{\"name\":\"PlayerSync\"}}", 32);
+    }
+    test_send_fragment(client, fragments + 1, WS_BINARY_FRAGMENT_FINISH);
+    for (int i = 0; i < 5000 && !sTestReceived.finished; i++)
+        os_thread_sleep_msec(1);
+
+    ws_lane_stats_t audio;
+    ws_client_get_lane_stats(client, WS_LANE_AUDIO, &audio);
+    bool passed = sTestReceived.finished && sTestReceived.texts == 1 && audio.dropped == 0 &&
+                  test_stream_is(&sTestReceived, 1, fragments + 1);
+    OS_LOGI(TEST_TAG, "loopback: %d fragments in %d frames, text after %d, %u coalesced: %s",
+            fragments + 2, sTestReceived.frames, sTestReceived.text_at, audio.coalesced,
+            passed ? "PASSED" : "FAILED");
+    ws_client_disconnect(client);
+    ws_client_destory(client);
+    return passed;
+}
+
+int main(int argc, char **argv)
+{
+    bool passed = true;
+    passed = test_lane_priority() && passed;
+    passed = test_late_drop() && passed;
+    passed = test_merge_order() && passed;
+    passed = test_slow_uplink_hold() && passed;
+    passed = test_loopback() && passed;
+    OS_LOGI(TEST_TAG, "websocket client test %s", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}